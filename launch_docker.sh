@@ -53,6 +53,9 @@ else
     echo -e "${GREEN}Web port: ${WEB_PORT}${NC}"
     echo -e "${GREEN}GUI URL: http://${HOSTNAME}:${WEB_PORT}${NC}"
     echo -e "${GREEN}Use \"./remote_vscode.sh ${SSH_PORT} ${HOSTNAME}\" to launch VSCode in the container${NC}"
+    # The web port is xpra's, so the metrics endpoints (9464 for the container, 9465 for gz sim)
+    # go through the SSH port
+    echo -e "${GREEN}Metrics: \"ssh -p ${SSH_PORT} -N -L 9464:localhost:9464 -L 9465:localhost:9465 developer@${HOSTNAME}\", then http://localhost:9464/metrics${NC}"
     echo -e "${GREEN}Using UID: ${HOST_UID}, GID: ${HOST_GID}${NC}"
 
     # Launch the Docker container in the background
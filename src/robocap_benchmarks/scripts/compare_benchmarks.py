@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+"""
+Compare two Google Benchmark JSON outputs and flag regressions.
+
+Usage: compare_benchmarks.py [BASELINE.json] CONTENDER.json [--threshold 0.1]
+                             [--budgets BUDGETS.json]
+
+Compares real_time and the robocap counters of every benchmark present in both files. Exits
+with 1 when any of them got worse by more than the threshold, so it can gate a commit.
+
+--budgets also checks the contender against absolute limits, e.g. replay_budgets.json:
+{"BM_ReplayEkf": {"p99_us": 20.0}} caps a lower-is-better value and puts a floor under a
+higher-is-better one. Benchmarks are matched by name up to the first '/', so a budget covers
+every argument and iteration count of its benchmark.
+"""
+
+import argparse
+import json
+import sys
+
+# Values where larger is worse, and where larger is better
+LOWER_IS_BETTER = ('real_time', 'p50_us', 'p90_us', 'p99_us', 'p999_us', 'max_us', 'lost')
+HIGHER_IS_BETTER = ('rtf', 'steps_per_second', 'items_per_second', 'bytes_per_second')
+
+TIME_UNITS = {'ns': 1e-9, 'us': 1e-6, 'ms': 1e-3, 's': 1.0}
+
+
+def load(path):
+    """Return {name: benchmark} for the iteration or mean entries of a result file."""
+    with open(path, 'r') as f:
+        results = json.load(f)
+    benchmarks = {}
+    for benchmark in results.get('benchmarks', []):
+        if benchmark.get('error_occurred'):
+            continue
+        aggregate = benchmark.get('aggregate_name')
+        if aggregate not in (None, 'mean'):
+            continue
+        name = benchmark.get('run_name', benchmark['name'])
+        value = dict(benchmark)
+        # Normalize to seconds so a changed Unit() is not a regression
+        value['real_time'] = benchmark['real_time'] * TIME_UNITS[benchmark.get('time_unit', 'ns')]
+        benchmarks[name] = value
+    return benchmarks
+
+
+def lower_is_better(key):
+    """Whether key is one of the compared values, possibly prefixed as in ekf_p99_us."""
+    return any(key == name or key.endswith('_' + name) for name in LOWER_IS_BETTER)
+
+
+def higher_is_better(key):
+    return any(key == name or key.endswith('_' + name) for name in HIGHER_IS_BETTER)
+
+
+def compare(baseline, contender, threshold):
+    """Print one line per compared value and return the regressions."""
+    regressions = []
+    for name in sorted(set(baseline) & set(contender)):
+        keys = [key for key in baseline[name] if lower_is_better(key) or higher_is_better(key)]
+        for key in keys:
+            if key not in contender[name]:
+                continue
+            old = float(baseline[name][key])
+            new = float(contender[name][key])
+            if old == 0.0:
+                continue
+            change = (new - old) / old
+            worse = change > threshold if lower_is_better(key) else change < -threshold
+            marker = '  REGRESSION' if worse else ''
+            print(f'{name:<60} {key:<18} {old:>12.4g} -> {new:>12.4g} {change:>+8.1%}{marker}')
+            if worse:
+                regressions.append((name, key, change))
+    for name in sorted(set(baseline) - set(contender)):
+        print(f'{name:<60} missing from the contender')
+    return regressions
+
+
+def check_budgets(contender, budgets):
+    """Print one line per budgeted value and return the ones out of budget."""
+    violations = []
+    for name in sorted(contender):
+        limits = budgets.get(name.split('/')[0], {})
+        for key, limit in sorted(limits.items()):
+            if key not in contender[name]:
+                print(f'{name:<60} {key:<18} missing, budget {limit:.4g}  OVER BUDGET')
+                violations.append((name, key, None))
+                continue
+            value = float(contender[name][key])
+            over = value > limit if lower_is_better(key) else value < limit
+            marker = '  OVER BUDGET' if over else ''
+            print(f'{name:<60} {key:<18} {value:>12.4g} budget {limit:>12.4g}{marker}')
+            if over:
+                violations.append((name, key, value))
+    return violations
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument('baseline', nargs='?')
+    parser.add_argument('contender')
+    parser.add_argument(
+        '--threshold', type=float, default=0.1,
+        help='relative change counted as a regression (default 0.1)')
+    parser.add_argument('--budgets', help='JSON of absolute limits per benchmark and value')
+    args = parser.parse_args()
+    if args.baseline is None and args.budgets is None:
+        parser.error('nothing to check the contender against, give a baseline or --budgets')
+
+    contender = load(args.contender)
+    failed = False
+    if args.baseline is not None:
+        regressions = compare(load(args.baseline), contender, args.threshold)
+        if regressions:
+            print(f'{len(regressions)} regression(s) over {args.threshold:.0%}')
+            failed = True
+    if args.budgets is not None:
+        with open(args.budgets, 'r') as f:
+            violations = check_budgets(contender, json.load(f))
+        if violations:
+            print(f'{len(violations)} value(s) over budget')
+            failed = True
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
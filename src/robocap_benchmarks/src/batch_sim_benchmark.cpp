@@ -0,0 +1,46 @@
+#include <cstddef>
+#include <cstdint>
+#include <random>
+
+#include "benchmark/benchmark.h"
+#include "robocap_sim/batch_sim.hpp"
+
+namespace
+{
+
+// One call per policy step at 50 Hz over the world's 1 ms physics step
+constexpr std::uint32_t kSubsteps = 20;
+
+// state.range(0) robots on state.range(1) threads (0 = all cores), random wheel commands
+void BM_BatchSimStep(benchmark::State & state)
+{
+  robocap_sim::BatchSimConfig config;
+  config.threads = static_cast<std::size_t>(state.range(1));
+  robocap_sim::BatchSim sim(static_cast<std::size_t>(state.range(0)), config);
+
+  std::mt19937 engine(1);
+  std::uniform_real_distribution<float> speed(-20.0f, 20.0f);
+  for (std::size_t wheel = 0; wheel < 3; ++wheel) {
+    for (std::size_t robot = 0; robot < sim.size(); ++robot) {
+      sim.wheel_command(wheel)[robot] = speed(engine);
+    }
+  }
+  for (auto _ : state) {
+    sim.step(kSubsteps);
+    benchmark::DoNotOptimize(sim.x());
+    benchmark::ClobberMemory();
+  }
+  // Items are robot physics steps
+  state.SetItemsProcessed(
+    static_cast<std::int64_t>(state.iterations() * sim.size() * kSubsteps));
+}
+
+}  // namespace
+
+BENCHMARK(BM_BatchSimStep)
+->ArgsProduct({{1024, 8192, 65536}, {1, 0}})
+->ArgNames({"robots", "threads"})
+->Unit(benchmark::kMicrosecond)
+->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,148 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "benchmark/benchmark.h"
+#include "ignition/msgs/imu.pb.h"
+#include "ignition/msgs/laserscan.pb.h"
+#include "ignition/transport/Node.hh"
+#include "rclcpp/rclcpp.hpp"
+#include "sensor_msgs/msg/imu.hpp"
+#include "sensor_msgs/msg/laser_scan.hpp"
+
+#include "latency_stats.hpp"
+#include "robocap_bridge/imu_bridge.hpp"
+#include "robocap_bridge/laser_scan_bridge.hpp"
+
+namespace
+{
+
+constexpr auto kTimeout = std::chrono::seconds(1);
+
+void ensure_ros()
+{
+  if (!rclcpp::ok()) {
+    rclcpp::init(0, nullptr);
+  }
+}
+
+void fill(ignition::msgs::LaserScan & scan, int count)
+{
+  scan.set_count(static_cast<std::uint32_t>(count));
+  scan.set_angle_min(-M_PI);
+  scan.set_angle_max(M_PI);
+  scan.set_angle_step(2.0 * M_PI / count);
+  scan.set_range_min(0.1);
+  scan.set_range_max(12.0);
+  for (int i = 0; i < count; ++i) {
+    scan.add_ranges(1.0 + 0.001 * i);
+  }
+}
+
+void fill(ignition::msgs::IMU & imu, int /*count*/)
+{
+  imu.mutable_orientation()->set_w(1.0);
+  imu.mutable_linear_acceleration()->set_z(9.81);
+}
+
+// Latency from an ign-transport publish to the ROS callback on the other side of `Bridge`, with
+// the bridge and the subscriber in one process like the robocap container. The ign-transport
+// publisher is in that process too, so this is the conversion plus the ROS hop, without the
+// socket hop from gz sim. A message that never arrives counts as kTimeout and in "lost"
+template<typename Bridge, typename GzMessage, typename RosMessage>
+void bridge_latency(
+  benchmark::State & state, const std::string & topic, int count, bool intra_process)
+{
+  ensure_ros();
+  // Namespaced on both transports, so a running sim does not interfere
+  const std::string gz_topic = "/robocap_benchmarks/gz/" + topic;
+  const std::string ros_topic = "/robocap_benchmarks/" + topic;
+  rclcpp::NodeOptions options;
+  options.use_intra_process_comms(intra_process);
+  options.arguments({"--ros-args", "-r", "__ns:=/robocap_benchmarks"});
+  options.parameter_overrides({{"gz_topic", gz_topic}});
+  const auto bridge = std::make_shared<Bridge>(options);
+
+  const auto listener = std::make_shared<rclcpp::Node>(
+    "bridge_benchmark_listener", rclcpp::NodeOptions().use_intra_process_comms(intra_process));
+  std::atomic<std::int64_t> received_ns{0};
+  const auto subscription = listener->create_subscription<RosMessage>(
+    ros_topic, rclcpp::SensorDataQoS(),
+    [&received_ns](typename RosMessage::UniquePtr /*message*/) {
+      received_ns.store(std::chrono::steady_clock::now().time_since_epoch().count());
+    });
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(listener);
+
+  ignition::transport::Node gz_node;
+  auto publisher = gz_node.Advertise<GzMessage>(gz_topic);
+  GzMessage message;
+  fill(message, count);
+
+  // Discovery on both sides before the first timed message
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while ((!publisher.HasConnections() || subscription->get_publisher_count() == 0) &&
+    std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  if (!publisher.HasConnections() || subscription->get_publisher_count() == 0) {
+    state.SkipWithError("Bridge endpoints never connected");
+    return;
+  }
+
+  robocap_benchmarks::LatencyStats stats;
+  std::int64_t lost = 0;
+  for (auto _ : state) {
+    received_ns.store(0);
+    const auto start = std::chrono::steady_clock::now();
+    publisher.Publish(message);
+    while (received_ns.load() == 0 && std::chrono::steady_clock::now() - start < kTimeout) {
+      executor.spin_some(std::chrono::microseconds(100));
+    }
+    if (received_ns.load() == 0) {
+      ++lost;  // Best effort QoS may drop
+      state.SetIterationTime(std::chrono::duration<double>(kTimeout).count());
+      continue;
+    }
+    const auto latency = std::chrono::nanoseconds(received_ns.load()) -
+      start.time_since_epoch();
+    state.SetIterationTime(std::chrono::duration<double>(latency).count());
+    stats.add(latency);
+  }
+  stats.report(state);
+  state.counters["lost"] = static_cast<double>(lost);
+}
+
+void BM_LaserScanBridge(benchmark::State & state)
+{
+  bridge_latency<
+    robocap_bridge::LaserScanBridge, ignition::msgs::LaserScan, sensor_msgs::msg::LaserScan>(
+    state, "scan", static_cast<int>(state.range(0)), state.range(1) != 0);
+}
+
+void BM_ImuBridge(benchmark::State & state)
+{
+  bridge_latency<robocap_bridge::ImuBridge, ignition::msgs::IMU, sensor_msgs::msg::Imu>(
+    state, "imu", 0, state.range(0) != 0);
+}
+
+}  // namespace
+
+// Beams (the robocap lidar has 2048), then intra-process on or off
+BENCHMARK(BM_LaserScanBridge)
+->ArgsProduct({{512, 2048}, {0, 1}})
+->ArgNames({"beams", "intra_process"})
+->UseManualTime()
+->Unit(benchmark::kMicrosecond)
+->Iterations(2000);
+BENCHMARK(BM_ImuBridge)
+->Arg(0)->Arg(1)
+->ArgNames({"intra_process"})
+->UseManualTime()
+->Unit(benchmark::kMicrosecond)
+->Iterations(5000);
+
+BENCHMARK_MAIN();
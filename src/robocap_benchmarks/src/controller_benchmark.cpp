@@ -0,0 +1,226 @@
+#include <array>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "controller_interface/controller_interface.hpp"
+#include "geometry_msgs/msg/twist.hpp"
+#include "hardware_interface/handle.hpp"
+#include "hardware_interface/loaned_command_interface.hpp"
+#include "hardware_interface/loaned_state_interface.hpp"
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "lifecycle_msgs/msg/state.hpp"
+#include "rclcpp/rclcpp.hpp"
+
+#include "latency_stats.hpp"
+#include "robocap_control/kiwi_drive_controller.hpp"
+#include "robocap_control/kiwi_mpc.hpp"
+#include "robocap_control/kiwi_mpc_controller.hpp"
+#include "robocap_estimation/ekf_odometry_controller.hpp"
+#include "robocap_kinematics/kiwi_drive.hpp"
+#include "robocap_runtime/allocation_counter.hpp"
+
+namespace
+{
+
+constexpr std::array<const char *, robocap_kinematics::kNumWheels> kWheelNames{
+  "wheel_1_joint", "wheel_2_joint", "wheel_3_joint"};
+// The controller manager's period in the sim
+const rclcpp::Duration kPeriod = rclcpp::Duration::from_seconds(1e-3);
+
+// Stand-in for the hardware: three velocity joints whose interfaces are loaned to one controller,
+// the way the controller manager does it. Outlives the controller it is loaned to
+struct WheelHardware
+{
+  std::array<double, robocap_kinematics::kNumWheels> command{};
+  std::array<double, robocap_kinematics::kNumWheels> state{1.0, -0.5, 0.25};
+  std::vector<hardware_interface::CommandInterface> command_interfaces;
+  std::vector<hardware_interface::StateInterface> state_interfaces;
+
+  WheelHardware()
+  {
+    command_interfaces.reserve(kWheelNames.size());
+    state_interfaces.reserve(kWheelNames.size());
+    for (std::size_t i = 0; i < kWheelNames.size(); ++i) {
+      command_interfaces.emplace_back(
+        kWheelNames[i], hardware_interface::HW_IF_VELOCITY, &command[i]);
+      state_interfaces.emplace_back(kWheelNames[i], hardware_interface::HW_IF_VELOCITY, &state[i]);
+    }
+  }
+
+  // Configures, loans the interfaces and activates. False if any step fails
+  bool start(
+    controller_interface::ControllerInterface & controller, const std::string & name,
+    bool claim_commands, const std::vector<rclcpp::Parameter> & parameters)
+  {
+    if (controller.init(name) != controller_interface::return_type::OK) {
+      return false;
+    }
+    const auto node = controller.get_node();
+    for (const auto & parameter : parameters) {
+      node->set_parameter(parameter);
+    }
+    if (node->configure().id() != lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE) {
+      return false;
+    }
+    std::vector<hardware_interface::LoanedCommandInterface> commands;
+    if (claim_commands) {
+      for (auto & interface : command_interfaces) {
+        commands.emplace_back(interface);
+      }
+    }
+    std::vector<hardware_interface::LoanedStateInterface> states;
+    for (auto & interface : state_interfaces) {
+      states.emplace_back(interface);
+    }
+    controller.assign_interfaces(std::move(commands), std::move(states));
+    return node->activate().id() == lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE;
+  }
+};
+
+void ensure_ros()
+{
+  if (!rclcpp::ok()) {
+    rclcpp::init(0, nullptr);
+  }
+}
+
+// update() as the controller manager calls it, with its odometry published at 50 Hz of the
+// synthetic clock. The time spent in each call goes into the percentile counters, and its heap
+// calls into updates_allocating and max_allocations, both 0 for a real-time safe update
+void run_updates(
+  benchmark::State & state, controller_interface::ControllerInterface & controller,
+  rclcpp::Time time)
+{
+  robocap_benchmarks::LatencyStats stats;
+  robocap_runtime::CycleAllocationCounter allocations;
+  for (auto _ : state) {
+    time += kPeriod;
+    const auto start = std::chrono::steady_clock::now();
+    allocations.begin();
+    const auto result = controller.update(time, kPeriod);
+    allocations.end();
+    stats.add(std::chrono::steady_clock::now() - start);
+    benchmark::DoNotOptimize(result);
+  }
+  stats.report(state);
+  if (robocap_runtime::allocation_counting_active()) {
+    state.counters["updates_allocating"] =
+      static_cast<double>(allocations.cycles_with_allocations());
+    state.counters["max_allocations"] = static_cast<double>(allocations.max_allocations());
+  }
+  controller.get_node()->deactivate();
+  controller.release_interfaces();
+}
+
+void BM_KiwiDriveControllerUpdate(benchmark::State & state)
+{
+  ensure_ros();
+  WheelHardware hardware;
+  robocap_control::KiwiDriveController controller;
+  // A timeout past the end of the run keeps the one command below in effect throughout
+  if (!hardware.start(
+      controller, "benchmark_kiwi_drive_controller", true,
+      {rclcpp::Parameter("cmd_vel_timeout", 1e9), rclcpp::Parameter("enable_odom_tf", true)}))
+  {
+    state.SkipWithError("KiwiDriveController failed to start");
+    return;
+  }
+
+  // Deliver one command through the real subscription and TripleBuffer
+  const auto node = controller.get_node();
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(node->get_node_base_interface());
+  const auto publisher = node->create_publisher<geometry_msgs::msg::Twist>(
+    "~/cmd_vel", rclcpp::SystemDefaultsQoS());
+  geometry_msgs::msg::Twist command;
+  command.linear.x = 0.3;
+  command.linear.y = -0.2;
+  command.angular.z = 0.5;
+  publisher->publish(command);
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+  while (hardware.command[0] == 0.0 && std::chrono::steady_clock::now() < deadline) {
+    executor.spin_some(std::chrono::milliseconds(10));
+    controller.update(node->now(), kPeriod);
+  }
+  if (hardware.command[0] == 0.0) {
+    state.SkipWithError("cmd_vel never reached the controller");
+    return;
+  }
+  executor.remove_node(node->get_node_base_interface());
+  run_updates(state, controller, node->now());
+}
+
+// One QP per iteration on its own, warm started as in the controller: the target flips every
+// 50 solves, so most solves follow a settled plan and some a fresh step
+void BM_KiwiMpcSolve(benchmark::State & state)
+{
+  robocap_control::KiwiMpc mpc;
+  if (!mpc.configure(robocap_control::KiwiMpcConfig{})) {
+    state.SkipWithError("KiwiMpc rejected its default config");
+    return;
+  }
+  robocap_control::KiwiMpc::Twist current{0.0, 0.0, 0.0};
+  const robocap_control::KiwiMpc::Twist targets[] = {{1.0, -0.5, 1.0}, {-0.5, 0.8, -1.0}};
+  constexpr double kSolvePeriod = 1.0 / 200.0;
+  robocap_benchmarks::LatencyStats stats;
+  std::size_t unconverged = 0;
+  std::size_t solves = 0;
+  for (auto _ : state) {
+    const auto & target = targets[(solves / 50) % 2];
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = mpc.solve(current, target);
+    stats.add(std::chrono::steady_clock::now() - start);
+    unconverged += result.converged ? 0 : 1;
+    ++solves;
+    const auto & acceleration = mpc.acceleration();
+    current.vx += acceleration.vx * kSolvePeriod;
+    current.vy += acceleration.vy * kSolvePeriod;
+    current.wz += acceleration.wz * kSolvePeriod;
+  }
+  stats.report(state);
+  state.counters["unconverged"] = static_cast<double>(unconverged);
+}
+
+// Every update re-plans (mpc_rate at the update rate), from spinning wheels towards a stop
+void BM_KiwiMpcControllerUpdate(benchmark::State & state)
+{
+  ensure_ros();
+  WheelHardware hardware;
+  robocap_control::KiwiMpcController controller;
+  if (!hardware.start(
+      controller, "benchmark_kiwi_mpc_controller", true,
+      {rclcpp::Parameter("mpc_rate", 1.0 / kPeriod.seconds())}))
+  {
+    state.SkipWithError("KiwiMpcController failed to start");
+    return;
+  }
+  run_updates(state, controller, controller.get_node()->now());
+}
+
+void BM_EkfOdometryControllerUpdate(benchmark::State & state)
+{
+  ensure_ros();
+  WheelHardware hardware;
+  robocap_estimation::EkfOdometryController controller;
+  if (!hardware.start(
+      controller, "benchmark_ekf_odometry_controller", false,
+      {rclcpp::Parameter("imu_topic", "/robocap_benchmarks/imu")}))
+  {
+    state.SkipWithError("EkfOdometryController failed to start");
+    return;
+  }
+  run_updates(state, controller, controller.get_node()->now());
+}
+
+}  // namespace
+
+BENCHMARK(BM_KiwiDriveControllerUpdate)->Iterations(200000);
+BENCHMARK(BM_KiwiMpcSolve)->Iterations(20000);
+BENCHMARK(BM_KiwiMpcControllerUpdate)->Iterations(20000);
+BENCHMARK(BM_EkfOdometryControllerUpdate)->Iterations(200000);
+
+BENCHMARK_MAIN();
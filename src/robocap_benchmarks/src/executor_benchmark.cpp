@@ -0,0 +1,122 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "rclcpp/rclcpp.hpp"
+#include "sensor_msgs/msg/joint_state.hpp"
+
+#include "latency_stats.hpp"
+#include "robocap_runtime/priority_executor.hpp"
+
+namespace
+{
+
+constexpr auto kTimeout = std::chrono::milliseconds(100);
+constexpr int kLoadTimers = 4;
+constexpr auto kLoadPeriod = std::chrono::milliseconds(1);
+constexpr auto kLoadWork = std::chrono::microseconds(700);
+
+void ensure_ros()
+{
+  if (!rclcpp::ok()) {
+    rclcpp::init(0, nullptr);
+  }
+}
+
+void busy_wait(std::chrono::steady_clock::duration duration)
+{
+  const auto end = std::chrono::steady_clock::now() + duration;
+  while (std::chrono::steady_clock::now() < end) {
+  }
+}
+
+// Latency from publishing a joint state to its callback, while a second node in the same executor
+// keeps every thread of a plain MultiThreadedExecutor busy, like TF and marker publishing at full
+// tilt. With the priority executor the joint state callback has a tier of its own. Run it with
+// CAP_SYS_NICE to get SCHED_FIFO, without it only the queues are separate
+void BM_ControlCallbackUnderLoad(benchmark::State & state)
+{
+  ensure_ros();
+  const bool priority = state.range(0) != 0;
+  const auto control = std::make_shared<rclcpp::Node>("executor_benchmark_control");
+  std::atomic<std::int64_t> received_ns{0};
+  const auto subscription = control->create_subscription<sensor_msgs::msg::JointState>(
+    "/robocap_benchmarks/joint_states", rclcpp::SensorDataQoS(),
+    [&received_ns](sensor_msgs::msg::JointState::ConstSharedPtr /*message*/) {
+      received_ns.store(std::chrono::steady_clock::now().time_since_epoch().count());
+    });
+
+  const auto load = std::make_shared<rclcpp::Node>("executor_benchmark_load");
+  const auto load_group = load->create_callback_group(rclcpp::CallbackGroupType::Reentrant);
+  std::vector<rclcpp::TimerBase::SharedPtr> timers;
+  for (int i = 0; i < kLoadTimers; ++i) {
+    timers.push_back(
+      load->create_wall_timer(kLoadPeriod, []() {busy_wait(kLoadWork);}, load_group));
+  }
+
+  std::shared_ptr<rclcpp::Executor> executor;
+  if (priority) {
+    auto tiers = std::make_shared<robocap_runtime::PriorityExecutor>();
+    tiers->add_tier({"control", 80, {}, 1});
+    tiers->add_tier({"best_effort", 0, {}, 2});
+    tiers->set_node_tier("executor_benchmark_control", 0);
+    executor = tiers;
+  } else {
+    executor = std::make_shared<rclcpp::executors::MultiThreadedExecutor>(
+      rclcpp::ExecutorOptions(), 3);
+  }
+  executor->add_node(control);
+  executor->add_node(load);
+  std::thread spinner([&executor]() {executor->spin();});
+
+  const auto publisher_node = std::make_shared<rclcpp::Node>("executor_benchmark_publisher");
+  const auto publisher = publisher_node->create_publisher<sensor_msgs::msg::JointState>(
+    "/robocap_benchmarks/joint_states", rclcpp::SensorDataQoS());
+  sensor_msgs::msg::JointState message;
+  message.name = {"wheel_1_joint", "wheel_2_joint", "wheel_3_joint"};
+  message.velocity = {1.0, -0.5, 0.25};
+  while (subscription->get_publisher_count() == 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  robocap_benchmarks::LatencyStats stats;
+  std::int64_t lost = 0;
+  for (auto _ : state) {
+    received_ns.store(0);
+    const auto start = std::chrono::steady_clock::now();
+    publisher->publish(message);
+    while (received_ns.load() == 0 && std::chrono::steady_clock::now() - start < kTimeout) {
+    }
+    if (received_ns.load() == 0) {
+      ++lost;
+      state.SetIterationTime(std::chrono::duration<double>(kTimeout).count());
+      continue;
+    }
+    const auto latency = std::chrono::nanoseconds(received_ns.load()) -
+      start.time_since_epoch();
+    state.SetIterationTime(std::chrono::duration<double>(latency).count());
+    stats.add(latency);
+    // The robot's joint states arrive at 1 kHz
+    std::this_thread::sleep_until(start + std::chrono::milliseconds(1));
+  }
+  stats.report(state);
+  state.counters["lost"] = static_cast<double>(lost);
+
+  executor->cancel();
+  spinner.join();
+}
+
+}  // namespace
+
+BENCHMARK(BM_ControlCallbackUnderLoad)
+->Arg(0)->Arg(1)
+->ArgNames({"priority_executor"})
+->UseManualTime()
+->Unit(benchmark::kMicrosecond)
+->Iterations(5000);
+
+BENCHMARK_MAIN();
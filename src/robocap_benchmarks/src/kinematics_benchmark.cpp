@@ -0,0 +1,109 @@
+#include <array>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "robocap_kinematics/robocap_layout.hpp"
+
+namespace
+{
+
+constexpr const auto & kKinematics = robocap_kinematics::kRobocapKiwiDrive;
+constexpr std::size_t kScalarCount = 1024;
+
+template<typename T>
+std::vector<T> random_values(std::size_t count, std::uint32_t seed)
+{
+  std::mt19937 engine(seed);
+  std::uniform_real_distribution<T> distribution(-1, 1);
+  std::vector<T> values(count);
+  for (auto & value : values) {
+    value = distribution(engine);
+  }
+  return values;
+}
+
+template<typename T>
+void BM_ToWheelSpeeds(benchmark::State & state)
+{
+  const auto vx = random_values<T>(kScalarCount, 1);
+  const auto vy = random_values<T>(kScalarCount, 2);
+  const auto wz = random_values<T>(kScalarCount, 3);
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < kScalarCount; ++i) {
+      auto speeds = kKinematics.to_wheel_speeds(robocap_kinematics::Twist<T>{vx[i], vy[i], wz[i]});
+      benchmark::DoNotOptimize(speeds);
+    }
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * kScalarCount));
+}
+
+template<typename T>
+void BM_ToTwist(benchmark::State & state)
+{
+  const auto w1 = random_values<T>(kScalarCount, 1);
+  const auto w2 = random_values<T>(kScalarCount, 2);
+  const auto w3 = random_values<T>(kScalarCount, 3);
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < kScalarCount; ++i) {
+      auto twist = kKinematics.to_twist(robocap_kinematics::WheelSpeeds<T>{w1[i], w2[i], w3[i]});
+      benchmark::DoNotOptimize(twist);
+    }
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * kScalarCount));
+}
+
+// Batched API over state.range(0) candidates, as a sampling planner would call it
+template<typename T>
+void BM_ToWheelSpeedsBatch(benchmark::State & state)
+{
+  const auto count = static_cast<std::size_t>(state.range(0));
+  const auto vx = random_values<T>(count, 1);
+  const auto vy = random_values<T>(count, 2);
+  const auto wz = random_values<T>(count, 3);
+  std::array<std::vector<T>, robocap_kinematics::kNumWheels> wheels;
+  for (auto & wheel : wheels) {
+    wheel.resize(count);
+  }
+  for (auto _ : state) {
+    kKinematics.to_wheel_speeds<T>(
+      {vx.data(), vy.data(), wz.data(), count},
+      {{wheels[0].data(), wheels[1].data(), wheels[2].data()}});
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * count));
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * count * 6 * sizeof(T)));
+}
+
+template<typename T>
+void BM_ToTwistsBatch(benchmark::State & state)
+{
+  const auto count = static_cast<std::size_t>(state.range(0));
+  const auto w1 = random_values<T>(count, 1);
+  const auto w2 = random_values<T>(count, 2);
+  const auto w3 = random_values<T>(count, 3);
+  std::vector<T> vx(count);
+  std::vector<T> vy(count);
+  std::vector<T> wz(count);
+  for (auto _ : state) {
+    kKinematics.to_twists<T>(
+      {{w1.data(), w2.data(), w3.data()}, count}, {vx.data(), vy.data(), wz.data()});
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * count));
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * count * 6 * sizeof(T)));
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_ToWheelSpeeds, float);
+BENCHMARK_TEMPLATE(BM_ToWheelSpeeds, double);
+BENCHMARK_TEMPLATE(BM_ToTwist, float);
+BENCHMARK_TEMPLATE(BM_ToTwist, double);
+BENCHMARK_TEMPLATE(BM_ToWheelSpeedsBatch, float)->RangeMultiplier(8)->Range(64, 1 << 18);
+BENCHMARK_TEMPLATE(BM_ToWheelSpeedsBatch, double)->RangeMultiplier(8)->Range(64, 1 << 18);
+BENCHMARK_TEMPLATE(BM_ToTwistsBatch, float)->RangeMultiplier(8)->Range(64, 1 << 18);
+BENCHMARK_TEMPLATE(BM_ToTwistsBatch, double)->RangeMultiplier(8)->Range(64, 1 << 18);
+
+BENCHMARK_MAIN();
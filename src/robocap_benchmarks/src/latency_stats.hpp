@@ -0,0 +1,56 @@
+#ifndef ROBOCAP_BENCHMARKS__LATENCY_STATS_HPP_
+#define ROBOCAP_BENCHMARKS__LATENCY_STATS_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+namespace robocap_benchmarks
+{
+
+// Per-iteration latencies of one benchmark run, reported as percentile counters so the JSON output
+// carries the tail and not only Google Benchmark's mean. Samples are preallocated, add() does not
+// allocate until `capacity` is exceeded.
+class LatencyStats
+{
+public:
+  explicit LatencyStats(std::size_t capacity = 1 << 20)
+  {
+    samples_.reserve(capacity);
+  }
+
+  void add(std::chrono::steady_clock::duration latency)
+  {
+    samples_.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count());
+  }
+
+  // p50_us, p90_us, p99_us, p999_us and max_us, after `prefix` when one run times several stages
+  void report(benchmark::State & state, const std::string & prefix = std::string())
+  {
+    if (samples_.empty()) {
+      return;
+    }
+    std::sort(samples_.begin(), samples_.end());
+    const auto percentile = [this](double p) {
+        const auto index = static_cast<std::size_t>(p * static_cast<double>(samples_.size() - 1));
+        return static_cast<double>(samples_[index]) * 1e-3;
+      };
+    state.counters[prefix + "p50_us"] = percentile(0.5);
+    state.counters[prefix + "p90_us"] = percentile(0.9);
+    state.counters[prefix + "p99_us"] = percentile(0.99);
+    state.counters[prefix + "p999_us"] = percentile(0.999);
+    state.counters[prefix + "max_us"] = static_cast<double>(samples_.back()) * 1e-3;
+  }
+
+private:
+  std::vector<std::int64_t> samples_;
+};
+
+}  // namespace robocap_benchmarks
+
+#endif  // ROBOCAP_BENCHMARKS__LATENCY_STATS_HPP_
@@ -0,0 +1,167 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "robocap_estimation/scan_matcher.hpp"
+#include "robocap_perception/thread_pool.hpp"
+
+#include "latency_stats.hpp"
+
+namespace
+{
+
+constexpr int kMapWidth = 400;   // 20 m
+constexpr int kMapHeight = 300;  // 15 m
+constexpr double kResolution = 0.05;
+constexpr double kMaxRange = 12.0;
+
+// A 20 x 15 m hall with shelves and a pillar, walls one cell thick
+std::vector<std::int8_t> hall_map()
+{
+  std::vector<std::int8_t> map(static_cast<std::size_t>(kMapWidth) * kMapHeight, 0);
+  const auto box = [&map](double x0, double y0, double x1, double y1) {
+      for (int y = static_cast<int>(y0 / kResolution); y <= static_cast<int>(y1 / kResolution);
+        ++y)
+      {
+        for (int x = static_cast<int>(x0 / kResolution);
+          x <= static_cast<int>(x1 / kResolution); ++x)
+        {
+          const bool edge = y == static_cast<int>(y0 / kResolution) ||
+            y == static_cast<int>(y1 / kResolution) || x == static_cast<int>(x0 / kResolution) ||
+            x == static_cast<int>(x1 / kResolution);
+          if (edge) {
+            map[static_cast<std::size_t>(y) * kMapWidth + static_cast<std::size_t>(x)] = 100;
+          }
+        }
+      }
+    };
+  box(0.21, 0.21, 19.79, 14.79);
+  box(5.03, 5.02, 5.33, 9.02);
+  box(8.01, 10.04, 14.01, 10.34);
+  box(12.02, 4.53, 13.02, 6.53);
+  box(16.04, 5.51, 16.54, 9.51);
+  box(9.2, 5.7, 9.8, 6.3);
+  return map;
+}
+
+// 720 beams from (x, y, yaw) marched through the map, in the sensor's frame
+void cast_scan(
+  const std::vector<std::int8_t> & map, double x, double y, double yaw,
+  std::vector<float> & px, std::vector<float> & py)
+{
+  px.clear();
+  py.clear();
+  for (int beam = 0; beam < 720; ++beam) {
+    const double angle = -M_PI + beam * M_PI / 360.0;
+    const double c = std::cos(yaw + angle);
+    const double s = std::sin(yaw + angle);
+    for (double range = 0.0; range < kMaxRange; range += 0.01) {
+      const int cx = static_cast<int>(std::floor((x + range * c) / kResolution));
+      const int cy = static_cast<int>(std::floor((y + range * s) / kResolution));
+      if (cx < 0 || cy < 0 || cx >= kMapWidth || cy >= kMapHeight ||
+        map[static_cast<std::size_t>(cy) * kMapWidth + static_cast<std::size_t>(cx)] >= 65)
+      {
+        px.push_back(static_cast<float>(range * std::cos(angle)));
+        py.push_back(static_cast<float>(range * std::sin(angle)));
+        break;
+      }
+    }
+  }
+}
+
+void BM_LikelihoodFieldBuild(benchmark::State & state)
+{
+  const auto map = hall_map();
+  for (auto _ : state) {
+    robocap_estimation::LikelihoodField field(
+      map.data(), kMapWidth, kMapHeight, kResolution, 0.0, 0.0, 0.1, 7);
+    benchmark::DoNotOptimize(&field);
+  }
+  state.SetItemsProcessed(state.iterations() * kMapWidth * kMapHeight);
+}
+
+// ScanLocalizer's steady state at 40 Hz: a 720-beam scan matched around a prior off by up to
+// 15 cm and 0.2 rad, the default tracking window. state.range(0) threads
+void BM_ScanMatchTracking(benchmark::State & state)
+{
+  const auto map = hall_map();
+  const robocap_estimation::LikelihoodField field(
+    map.data(), kMapWidth, kMapHeight, kResolution, 0.0, 0.0, 0.1, 7);
+  robocap_perception::ThreadPool pool(static_cast<std::size_t>(state.range(0)));
+  robocap_estimation::ScanMatcher matcher(field, &pool);
+  const robocap_estimation::ScanMatcherOptions options;
+
+  // A loop of poses through the hall, scans cast up front
+  constexpr int kPoses = 64;
+  std::vector<std::vector<float>> scans_x(kPoses);
+  std::vector<std::vector<float>> scans_y(kPoses);
+  std::vector<robocap_estimation::Pose2> truth(kPoses);
+  std::vector<robocap_estimation::Pose2> priors(kPoses);
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<double> offset(-0.15, 0.15);
+  std::uniform_real_distribution<double> turn(-0.2, 0.2);
+  for (int i = 0; i < kPoses; ++i) {
+    const double t = 2.0 * M_PI * i / kPoses;
+    truth[i] = {10.5 + 7.5 * std::cos(t), 7.5 + 5.5 * std::sin(t), t + M_PI_2};
+    priors[i] = {truth[i].x + offset(rng), truth[i].y + offset(rng), truth[i].yaw + turn(rng)};
+    cast_scan(map, truth[i].x, truth[i].y, truth[i].yaw, scans_x[i], scans_y[i]);
+  }
+
+  robocap_benchmarks::LatencyStats stats;
+  double error = 0.0;
+  std::int64_t matches = 0;
+  int i = 0;
+  for (auto _ : state) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto match = matcher.match(
+      scans_x[i].data(), scans_y[i].data(), scans_x[i].size(), priors[i], options);
+    stats.add(std::chrono::steady_clock::now() - start);
+    error = std::max(error, std::hypot(match.pose.x - truth[i].x, match.pose.y - truth[i].y));
+    matches += match.valid;
+    i = (i + 1) % kPoses;
+  }
+  stats.report(state);
+  // Against the ray cast's truth, which includes up to half a cell of map quantization
+  state.counters["max_error_m"] = error;
+  state.counters["valid"] = static_cast<double>(matches) / static_cast<double>(state.iterations());
+}
+
+// The search after a restart or kidnapping: the whole hall, every heading. state.range(0) threads
+void BM_ScanMatchGlobal(benchmark::State & state)
+{
+  const auto map = hall_map();
+  const robocap_estimation::LikelihoodField field(
+    map.data(), kMapWidth, kMapHeight, kResolution, 0.0, 0.0, 0.1, 7);
+  robocap_perception::ThreadPool pool(static_cast<std::size_t>(state.range(0)));
+  robocap_estimation::ScanMatcher matcher(field, &pool);
+  robocap_estimation::ScanMatcherOptions options;
+  options.linear_window = 0.5 * kMapWidth * kResolution;
+  options.angular_window = M_PI;
+  options.min_score = 0.65;
+  std::vector<float> x;
+  std::vector<float> y;
+  cast_scan(map, 3.1, 11.7, 0.4, x, y);
+  const robocap_estimation::Pose2 centre{0.5 * kMapWidth * kResolution,
+    0.5 * kMapHeight * kResolution, 0.0};
+
+  double error = 0.0;
+  for (auto _ : state) {
+    const auto match = matcher.match(x.data(), y.data(), x.size(), centre, options);
+    error = std::hypot(match.pose.x - 3.1, match.pose.y - 11.7);
+    benchmark::DoNotOptimize(match);
+  }
+  state.counters["error_m"] = error;
+}
+
+}  // namespace
+
+BENCHMARK(BM_LikelihoodFieldBuild)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ScanMatchTracking)->Arg(1)->Arg(0)->ArgName("threads")
+->Unit(benchmark::kMicrosecond)->UseRealTime();
+BENCHMARK(BM_ScanMatchGlobal)->Arg(1)->Arg(0)->ArgName("threads")
+->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
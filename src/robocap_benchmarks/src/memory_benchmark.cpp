@@ -0,0 +1,181 @@
+#include <array>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "sensor_msgs/msg/joint_state.hpp"
+#include "sensor_msgs/msg/laser_scan.hpp"
+
+#include "robocap_runtime/allocation_counter.hpp"
+#include "robocap_runtime/arena.hpp"
+#include "robocap_runtime/fixed_pool.hpp"
+#include "robocap_runtime/message_pool.hpp"
+
+namespace
+{
+
+constexpr std::size_t kBeams = 720;
+const std::array<std::string, 3> kJoints{"wheel_1_joint", "wheel_2_joint", "wheel_3_joint"};
+
+// Heap calls per iteration of the loop that follows, as the "allocations" counter
+class AllocationsPerIteration
+{
+public:
+  AllocationsPerIteration()
+  : start_(robocap_runtime::thread_allocation_counts())
+  {
+  }
+
+  void report(benchmark::State & state) const
+  {
+    // Taken first, allocation_counting_active() allocates itself
+    const auto counts = robocap_runtime::thread_allocation_counts() - start_;
+    if (!robocap_runtime::allocation_counting_active()) {
+      return;
+    }
+    state.counters["allocations"] =
+      static_cast<double>(counts.allocations) / static_cast<double>(state.iterations());
+  }
+
+private:
+  robocap_runtime::AllocationCounts start_;
+};
+
+void fill(sensor_msgs::msg::JointState & message, double value)
+{
+  message.name.assign(kJoints.begin(), kJoints.end());
+  message.position.assign(kJoints.size(), value);
+  message.velocity.assign(kJoints.size(), value);
+  message.effort.assign(kJoints.size(), value);
+}
+
+void fill(sensor_msgs::msg::LaserScan & message, float value)
+{
+  message.ranges.assign(kBeams, value);
+  message.intensities.assign(kBeams, value);
+}
+
+// What ShmBridge did per sample before its pools: a fresh message, every sequence allocated
+template<typename MessageT>
+void BM_FreshMessage(benchmark::State & state)
+{
+  const AllocationsPerIteration allocations;
+  for (auto _ : state) {
+    auto message = std::make_unique<MessageT>();
+    fill(*message, 1.0f);
+    benchmark::DoNotOptimize(message.get());
+  }
+  allocations.report(state);
+}
+
+// The same through a MessagePool, whose messages keep their capacity
+template<typename MessageT>
+void BM_PooledMessage(benchmark::State & state)
+{
+  robocap_runtime::MessagePool<MessageT> pool(4);
+  std::vector<MessageT *> warm;
+  while (MessageT * message = pool.acquire()) {
+    fill(*message, 0.0f);
+    warm.push_back(message);
+  }
+  for (MessageT * message : warm) {
+    pool.release(message);
+  }
+  const AllocationsPerIteration allocations;
+  for (auto _ : state) {
+    MessageT * message = pool.acquire();
+    fill(*message, 1.0f);
+    benchmark::DoNotOptimize(message);
+    pool.release(message);
+  }
+  allocations.report(state);
+}
+
+// A subscription's borrowed message: rclcpp's default std::make_shared, then the pooled strategy
+void BM_BorrowHeap(benchmark::State & state)
+{
+  rclcpp::message_memory_strategy::MessageMemoryStrategy<sensor_msgs::msg::LaserScan> strategy;
+  const AllocationsPerIteration allocations;
+  for (auto _ : state) {
+    auto message = strategy.borrow_message();
+    fill(*message, 1.0f);
+    strategy.return_message(message);
+  }
+  allocations.report(state);
+}
+
+void BM_BorrowPooled(benchmark::State & state)
+{
+  robocap_runtime::PooledMessageMemoryStrategy<sensor_msgs::msg::LaserScan> strategy(
+    std::make_shared<robocap_runtime::MessagePool<sensor_msgs::msg::LaserScan>>(4));
+  {
+    auto warm = strategy.borrow_message();
+    fill(*warm, 0.0f);
+  }
+  const AllocationsPerIteration allocations;
+  for (auto _ : state) {
+    auto message = strategy.borrow_message();
+    fill(*message, 1.0f);
+    strategy.return_message(message);
+  }
+  allocations.report(state);
+}
+
+// Small blocks from one thread: state.range(0) 0 for new/delete, 1 for a FixedPool
+void BM_SmallBlocks(benchmark::State & state)
+{
+  robocap_runtime::FixedPool pool(64, 256);
+  std::pmr::memory_resource * resource =
+    state.range(0) ? static_cast<std::pmr::memory_resource *>(&pool) :
+    std::pmr::new_delete_resource();
+  std::array<void *, 16> blocks{};
+  const AllocationsPerIteration allocations;
+  for (auto _ : state) {
+    for (auto & block : blocks) {
+      block = resource->allocate(48, alignof(std::max_align_t));
+    }
+    benchmark::DoNotOptimize(blocks.data());
+    for (auto & block : blocks) {
+      resource->deallocate(block, 48, alignof(std::max_align_t));
+    }
+  }
+  allocations.report(state);
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(blocks.size()));
+}
+
+// A cycle's scratch: a few vectors built and dropped, on the heap or in an Arena reset per cycle
+void BM_CycleScratch(benchmark::State & state)
+{
+  robocap_runtime::Arena arena(64 * 1024);
+  std::pmr::memory_resource * resource =
+    state.range(0) ? static_cast<std::pmr::memory_resource *>(&arena) :
+    std::pmr::new_delete_resource();
+  const AllocationsPerIteration allocations;
+  for (auto _ : state) {
+    arena.reset();
+    std::pmr::vector<double> costs(resource);
+    std::pmr::vector<int> indices(resource);
+    for (int i = 0; i < 256; ++i) {
+      costs.push_back(i * 0.5);
+      indices.push_back(i);
+    }
+    benchmark::DoNotOptimize(costs.data());
+    benchmark::DoNotOptimize(indices.data());
+  }
+  allocations.report(state);
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_FreshMessage, sensor_msgs::msg::JointState);
+BENCHMARK_TEMPLATE(BM_PooledMessage, sensor_msgs::msg::JointState);
+BENCHMARK_TEMPLATE(BM_FreshMessage, sensor_msgs::msg::LaserScan);
+BENCHMARK_TEMPLATE(BM_PooledMessage, sensor_msgs::msg::LaserScan);
+BENCHMARK(BM_BorrowHeap);
+BENCHMARK(BM_BorrowPooled);
+BENCHMARK(BM_SmallBlocks)->Arg(0)->Arg(1)->ArgName("pool");
+BENCHMARK(BM_CycleScratch)->Arg(0)->Arg(1)->ArgName("arena");
+
+BENCHMARK_MAIN();
@@ -0,0 +1,81 @@
+#include <cstdint>
+#include <string>
+
+#include "benchmark/benchmark.h"
+
+#include "robocap_runtime/metrics.hpp"
+
+namespace
+{
+
+// About what the robocap container registers: a few histograms per component and the counters
+constexpr int kSeries = 24;
+
+// One record() from each of state.threads() threads at once, e.g. the control loop, the bridge
+// and the EKF. Up to Histogram::kShards threads each have a shard to themselves
+void BM_HistogramRecord(benchmark::State & state)
+{
+  static robocap_runtime::Histogram histogram;
+  std::uint64_t ns = 1000 + static_cast<std::uint64_t>(state.thread_index()) * 100;
+  for (auto _ : state) {
+    histogram.record(ns);
+    ns = ns * 13 % 10'000'000 + 1000;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_CounterAdd(benchmark::State & state)
+{
+  static robocap_runtime::Counter counter;
+  for (auto _ : state) {
+    counter.add();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+robocap_runtime::MetricsRegistry & filled_registry()
+{
+  static robocap_runtime::MetricsRegistry registry;
+  static const bool filled = [] {
+      for (int i = 0; i < kSeries; ++i) {
+        auto & histogram = registry.histogram(
+          "robocap_benchmark_seconds", "Benchmark", {{"series", std::to_string(i)}});
+        for (std::uint64_t ns = 1000; ns < 100'000'000; ns = ns * 11 / 10) {
+          histogram.record(ns);
+        }
+      }
+      return true;
+    }();
+  static_cast<void>(filled);
+  return registry;
+}
+
+// What the exporter does off the hot path, per diagnostics period and per scrape
+void BM_RegistrySnapshot(benchmark::State & state)
+{
+  const auto & registry = filled_registry();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(registry.snapshot());
+  }
+}
+
+void BM_PrometheusText(benchmark::State & state)
+{
+  const auto & registry = filled_registry();
+  std::size_t bytes = 0;
+  for (auto _ : state) {
+    const auto text = registry.prometheus_text();
+    bytes = text.size();
+    benchmark::DoNotOptimize(text.data());
+  }
+  state.counters["bytes"] = static_cast<double>(bytes);
+}
+
+}  // namespace
+
+BENCHMARK(BM_HistogramRecord)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_CounterAdd)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_RegistrySnapshot);
+BENCHMARK(BM_PrometheusText);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,190 @@
+#include <fcntl.h>
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+#include "benchmark/benchmark.h"
+
+#include "latency_stats.hpp"
+#include "robocap_control/motor_bus_backend.hpp"
+#include "robocap_control/motor_protocol.hpp"
+#include "robocap_control/spsc_ring.hpp"
+
+namespace
+{
+
+using robocap_control::MotorPayload;
+
+// Stand-in for the three motor drivers on the far end of a pseudo-terminal: every command frame
+// is answered with a feedback frame of that motor, integrating the commanded velocity over 1 ms
+class SerialBoard
+{
+public:
+  SerialBoard()
+  {
+    int slave = -1;
+    if (openpty(&master_, &slave, name_.data(), nullptr, nullptr) != 0) {
+      return;
+    }
+    ::close(slave);  // MotorBusBackend opens the device by name
+    termios options{};
+    tcgetattr(master_, &options);
+    cfmakeraw(&options);
+    tcsetattr(master_, TCSANOW, &options);
+    fcntl(master_, F_SETFL, O_NONBLOCK);
+    thread_ = std::thread([this] {run();});
+  }
+
+  ~SerialBoard()
+  {
+    running_ = false;
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+    if (master_ >= 0) {
+      ::close(master_);
+    }
+  }
+
+  bool ok() const {return master_ >= 0;}
+  const char * device() const {return name_.data();}
+  std::uint64_t commands() const {return commands_.load(std::memory_order_relaxed);}
+
+private:
+  void run()
+  {
+    std::array<std::uint8_t, 1024> buffer{};
+    std::size_t size = 0;
+    std::array<double, 3> position{};
+    std::uint64_t rejected = 0;
+    while (running_) {
+      const ssize_t got = ::read(master_, buffer.data() + size, buffer.size() - size);
+      if (got <= 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+        continue;
+      }
+      size += static_cast<std::size_t>(got);
+      std::size_t offset = 0;
+      std::size_t consumed = 0;
+      std::uint8_t id = 0;
+      MotorPayload payload{};
+      while (robocap_control::read_serial_frame(
+          buffer.data() + offset, size - offset, consumed, id, payload, rejected))
+      {
+        offset += consumed;
+        if (id < 1 || id > position.size()) {
+          continue;
+        }
+        const auto command = robocap_control::decode_command(payload);
+        position[id - 1] += command.velocity * 1e-3;
+        robocap_control::MotorFeedback feedback;
+        feedback.position_raw = robocap_control::position_to_raw(position[id - 1]);
+        feedback.velocity = command.velocity;
+        std::array<std::uint8_t, robocap_control::kSerialFrameSize> frame{};
+        robocap_control::write_serial_frame(
+          static_cast<std::uint8_t>(id | robocap_control::kSerialFeedbackFlag),
+          robocap_control::encode_feedback(feedback), frame.data());
+        [[maybe_unused]] const ssize_t sent = ::write(master_, frame.data(), frame.size());
+        commands_.fetch_add(1, std::memory_order_relaxed);
+      }
+      offset += consumed;
+      size -= offset;
+      std::memmove(buffer.data(), buffer.data() + offset, size);
+    }
+  }
+
+  int master_ = -1;
+  std::array<char, 64> name_{};
+  std::thread thread_;
+  std::atomic<bool> running_{true};
+  std::atomic<std::uint64_t> commands_{0};
+};
+
+// One controller manager cycle on the real robot's backend: write() the three set-points and
+// read() the latest feedback, with the drivers answering on a serial line. Neither call touches
+// the device, so the percentiles stay in microseconds whatever the line's latency
+void BM_MotorBusCycle(benchmark::State & state)
+{
+  SerialBoard board;
+  if (!board.ok()) {
+    state.SkipWithError("No pseudo-terminal");
+    return;
+  }
+  robocap_control::MotorBusBackend::Config config;
+  config.transport = robocap_control::MotorBusBackend::Transport::kSerial;
+  config.device = board.device();
+  robocap_control::MotorBusBackend backend(config);
+  if (!backend.configure({"wheel_1_joint", "wheel_2_joint", "wheel_3_joint"})) {
+    state.SkipWithError("MotorBusBackend failed to open the pseudo-terminal");
+    return;
+  }
+
+  robocap_control::WheelCommands commands;
+  commands.mode.fill(robocap_control::CommandMode::kVelocity);
+  commands.velocity = {1.0, -2.0, 3.0};
+  robocap_control::WheelStates states;
+  robocap_benchmarks::LatencyStats stats;
+  const auto run_start = std::chrono::steady_clock::now();
+  for (auto _ : state) {
+    const auto start = std::chrono::steady_clock::now();
+    backend.write(commands);
+    backend.read(states);
+    stats.add(std::chrono::steady_clock::now() - start);
+    benchmark::DoNotOptimize(states);
+    // The controller manager's 1 kHz period
+    std::this_thread::sleep_until(start + std::chrono::milliseconds(1));
+  }
+  const double seconds =
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - run_start).count();
+  stats.report(state);
+  // Motor commands the drivers received per second, 3 per cycle when every batch goes out
+  state.counters["driver_commands_per_s"] = static_cast<double>(board.commands()) / seconds;
+}
+
+// Producer and consumer of the feedback ring on two threads, the I/O thread and the controller
+// manager's
+void BM_SpscRingTransfer(benchmark::State & state)
+{
+  struct Item
+  {
+    std::uint64_t sequence;
+    MotorPayload payload;
+  };
+  robocap_control::SpscRing<Item, 256> ring;
+  std::atomic<bool> done{false};
+  std::thread consumer([&] {
+      Item item{};
+      while (!done.load(std::memory_order_relaxed)) {
+        if (!ring.pop(item)) {
+          std::this_thread::yield();
+        }
+      }
+      while (ring.pop(item)) {
+      }
+    });
+  std::uint64_t sequence = 0;
+  for (auto _ : state) {
+    while (!ring.push(Item{sequence, {}})) {
+      std::this_thread::yield();
+    }
+    ++sequence;
+  }
+  done = true;
+  consumer.join();
+  state.SetItemsProcessed(static_cast<std::int64_t>(sequence));
+}
+
+}  // namespace
+
+BENCHMARK(BM_MotorBusCycle)->Iterations(5000)->UseRealTime();
+BENCHMARK(BM_SpscRingTransfer)->UseRealTime();
+
+BENCHMARK_MAIN();
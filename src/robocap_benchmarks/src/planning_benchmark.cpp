@@ -0,0 +1,143 @@
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "robocap_kinematics/robocap_layout.hpp"
+#include "robocap_perception/point_cloud.hpp"
+#include "robocap_perception/point_filters.hpp"
+#include "robocap_perception/rolling_grid.hpp"
+#include "robocap_perception/thread_pool.hpp"
+#include "robocap_planning/mppi_planner.hpp"
+#include "robocap_planning/obstacle_map.hpp"
+
+namespace
+{
+
+constexpr int kGridSize = 400;
+constexpr double kResolution = 0.05;
+
+// A 2048-beam scan of a 4 m room with the sensor off centre, like the robocap lidar
+std::vector<float> room_scan(std::size_t beams)
+{
+  std::vector<float> ranges(beams);
+  for (std::size_t i = 0; i < beams; ++i) {
+    const double angle = -M_PI + 2.0 * M_PI * static_cast<double>(i) / static_cast<double>(beams);
+    const double c = std::abs(std::cos(angle));
+    const double s = std::abs(std::sin(angle));
+    ranges[i] = static_cast<float>(std::min(c > 0.0 ? 2.5 / c : 1e9, s > 0.0 ? 1.5 / s : 1e9));
+  }
+  return ranges;
+}
+
+// One ScanMapper cycle: insert a scan, then collect the changed cells. state.range(0) threads
+void BM_RollingGridInsertScan(benchmark::State & state)
+{
+  robocap_perception::ThreadPool pool(static_cast<std::size_t>(state.range(0)));
+  robocap_perception::RollingGrid grid(kGridSize, kResolution, pool.size());
+  const auto ranges = room_scan(2048);
+  std::vector<robocap_perception::GridChange> changes;
+  changes.reserve(static_cast<std::size_t>(kGridSize) * kGridSize);
+  double yaw = 0.0;
+  for (auto _ : state) {
+    // Turning in place, so every scan changes some cells
+    yaw += 0.01;
+    const robocap_perception::ScanRays scan{
+      0.0, 0.0, yaw, static_cast<float>(-M_PI), static_cast<float>(2.0 * M_PI / 2048), 0.1f,
+      12.0f, ranges.data(), ranges.size()};
+    grid.recenter(0.0, 0.0);
+    grid.insert_scan(scan, pool);
+    grid.take_changes(changes);
+    benchmark::DoNotOptimize(changes.data());
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * ranges.size()));
+}
+
+// PointCloudFilter's stages on a full frame, state.range(0) 0 for the room scan, 1 for a 640x480
+// depth image of a wall 3 m ahead, the camera 1.2 m up and looking forward
+void BM_PointFilterChain(benchmark::State & state)
+{
+  const bool depth = state.range(0) == 1;
+  constexpr std::size_t kWidth = 640;
+  constexpr std::size_t kHeight = 480;
+  const auto ranges = room_scan(2048);
+  const std::vector<float> image(kWidth * kHeight, 3.0f);
+
+  robocap_perception::PointCloud cloud(kWidth * kHeight);
+  robocap_perception::TemporalMedianFilter median(3, cloud.capacity());
+  robocap_perception::ScanProjector scan_projector(cloud.capacity());
+  robocap_perception::DepthProjector depth_projector(cloud.capacity());
+  std::vector<float> frame(cloud.capacity());
+  robocap_perception::FilterChain chain;
+  chain.add<robocap_perception::RangeFilter>(0.1f, 12.0f);
+  auto & transform = chain.add<robocap_perception::TransformFilter>();
+  if (depth) {
+    // Optical frame (z forward, y down) into base_link
+    transform.set_transform({0, 0, 1, -1, 0, 0, 0, -1, 0}, {0.25f, 0.0f, 1.2f});
+  } else {
+    transform.set_transform({1, 0, 0, 0, 1, 0, 0, 0, 1}, {0.0f, 0.0f, 0.07f});
+  }
+  chain.add<robocap_perception::SelfFilter>();
+  chain.add<robocap_perception::VoxelGridFilter>(0.05f, cloud.capacity());
+
+  std::size_t points = 0;
+  for (auto _ : state) {
+    if (depth) {
+      median.apply(image.data(), frame.data(), image.size());
+      depth_projector.project(
+        frame.data(), kWidth, kHeight, kWidth, {525.0, 525.0, 319.5, 239.5}, cloud);
+    } else {
+      median.apply(ranges.data(), frame.data(), ranges.size());
+      scan_projector.project(
+        frame.data(), ranges.size(), static_cast<float>(-M_PI),
+        static_cast<float>(2.0 * M_PI / 2048), cloud);
+    }
+    points = cloud.size();
+    chain.apply(cloud);
+    benchmark::DoNotOptimize(cloud.x());
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * points));
+  state.counters["voxels"] = static_cast<double>(cloud.size());
+}
+
+// One LocalPlanner cycle. state.range(0) samples, state.range(1) threads
+void BM_MppiPlan(benchmark::State & state)
+{
+  robocap_perception::ThreadPool pool(static_cast<std::size_t>(state.range(1)));
+  robocap_planning::MppiConfig config;
+  config.samples = static_cast<std::size_t>(state.range(0));
+  robocap_planning::MppiPlanner planner(robocap_kinematics::kRobocapKiwiDrive, config, pool.size());
+
+  // A post between the robot and the goal
+  std::vector<std::int8_t> cells(static_cast<std::size_t>(kGridSize) * kGridSize, 0);
+  for (int y = 195; y < 205; ++y) {
+    for (int x = 240; x < 250; ++x) {
+      cells[static_cast<std::size_t>(y) * kGridSize + x] = 100;
+    }
+  }
+  robocap_planning::ObstacleMap map(0.3, 65);
+  map.update(cells, kGridSize, kResolution, -kGridSize / 2, -kGridSize / 2);
+
+  const robocap_planning::Pose2 goal{5.0, 0.0, M_PI_2};
+  for (auto _ : state) {
+    auto command = planner.plan({0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, goal, map.view(), pool);
+    benchmark::DoNotOptimize(command);
+  }
+  state.SetItemsProcessed(
+    static_cast<std::int64_t>(state.iterations() * planner.samples() * config.steps));
+  state.counters["rollouts"] = static_cast<double>(planner.samples());
+}
+
+}  // namespace
+
+BENCHMARK(BM_RollingGridInsertScan)->Arg(1)->Arg(0)->ArgName("threads")
+->Unit(benchmark::kMicrosecond)->UseRealTime();
+BENCHMARK(BM_PointFilterChain)->Arg(0)->Arg(1)->ArgName("depth")
+->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_MppiPlan)
+->ArgsProduct({{1024, 5120, 10240}, {1, 0}})
+->ArgNames({"samples", "threads"})
+->Unit(benchmark::kMillisecond)
+->UseRealTime();
+
+BENCHMARK_MAIN();
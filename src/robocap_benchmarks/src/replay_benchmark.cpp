@@ -0,0 +1,490 @@
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "latency_stats.hpp"
+#include "robocap_control/kiwi_mpc.hpp"
+#include "robocap_estimation/kiwi_ekf.hpp"
+#include "robocap_kinematics/robocap_layout.hpp"
+#include "robocap_perception/thread_pool.hpp"
+#include "robocap_planning/mppi_planner.hpp"
+#include "robocap_planning/obstacle_map.hpp"
+#include "robocap_sim/batch_sim.hpp"
+#include "robocap_telemetry/ring_log.hpp"
+
+// Replays a telemetry log (robocap_telemetry's ring file, gazebo.launch.py telemetry_file:=...)
+// through the estimator, the MPC and the local planner as fast as they run, with no simulator:
+//
+//   ROBOCAP_REPLAY_LOG=run.telemetry ros2 run robocap_benchmarks replay_benchmark
+//
+// Each benchmark is one pass over the whole log, every component called at its rate in log time.
+// Without ROBOCAP_REPLAY_LOG a fixed synthetic minute from robocap_sim::BatchSim is replayed, so
+// the suite always has an input to compare against a baseline or against replay_budgets.json.
+
+namespace
+{
+
+using robocap_kinematics::kNumWheels;
+using robocap_kinematics::kRobocapKiwiDrive;
+
+// The components' rates on the robot: the EKF at every physics step, KiwiMpcController's
+// mpc_rate and LocalPlanner's rate
+constexpr std::int64_t kMpcPeriodNs = 5'000'000;
+constexpr std::int64_t kPlannerPeriodNs = 50'000'000;
+// The planner's goal is where the recording was this much later
+constexpr std::int64_t kGoalLookaheadNs = 3'000'000'000;
+// A free local grid like LocalPlanner's, so rollouts pay for the map lookups
+constexpr int kGridSize = 400;
+constexpr double kResolution = 0.05;
+
+constexpr std::size_t kSyntheticRecords = 60000;
+constexpr double kSyntheticStep = 0.001;
+constexpr std::size_t kSyntheticSegment = 2500;
+
+// The recorded streams, decoded up front so the benchmarks only measure the components
+struct Replay
+{
+  std::string source;
+  std::vector<std::int64_t> time_ns;
+  std::array<std::vector<double>, kNumWheels> wheel_velocity;
+  std::array<std::vector<double>, kNumWheels> wheel_command;
+  std::vector<double> x;
+  std::vector<double> y;
+  std::vector<double> yaw;
+  // In base_link, the way the IMU sees them: twist and planar acceleration without gravity
+  std::vector<double> vx;
+  std::vector<double> vy;
+  std::vector<double> wz;
+  std::vector<double> ax;
+  std::vector<double> ay;
+
+  std::size_t size() const {return time_ns.size();}
+  double seconds() const {return (time_ns.back() - time_ns.front()) * 1e-9;}
+
+  robocap_kinematics::WheelSpeeds<double> wheels(std::size_t i) const
+  {
+    return {wheel_velocity[0][i], wheel_velocity[1][i], wheel_velocity[2][i]};
+  }
+  robocap_kinematics::WheelSpeeds<double> commands(std::size_t i) const
+  {
+    return {wheel_command[0][i], wheel_command[1][i], wheel_command[2][i]};
+  }
+  // First record at or after `time`, size() - 1 past the end
+  std::size_t at(std::int64_t time) const
+  {
+    const auto it = std::lower_bound(time_ns.begin(), time_ns.end(), time);
+    return std::min(static_cast<std::size_t>(it - time_ns.begin()), size() - 1);
+  }
+};
+
+const std::array<const char *, kNumWheels> kJoints{
+  "wheel_1_joint", "wheel_2_joint", "wheel_3_joint"};
+
+// A minute of driving on the planar model, under TelemetryRecorder's column names: a fixed
+// sequence of translations, turns and stops, each held for kSyntheticSegment steps
+bool record_synthetic_log(const std::string & path)
+{
+  std::vector<robocap_telemetry::ColumnSpec> columns{
+    {"sim_time_ns", robocap_telemetry::ColumnType::kInt64}};
+  for (const char * joint : kJoints) {
+    for (const char * suffix : {"/velocity", "/velocity_cmd"}) {
+      columns.push_back({std::string(joint) + suffix, robocap_telemetry::ColumnType::kFloat64});
+    }
+  }
+  for (const char * name : {"base_x", "base_y", "base_qw", "base_qx", "base_qy", "base_qz",
+      "base_vx", "base_vy", "base_wz"})
+  {
+    columns.push_back({name, robocap_telemetry::ColumnType::kFloat64});
+  }
+  robocap_telemetry::RingLogWriter writer;
+  if (!writer.open(path, columns, kSyntheticRecords)) {
+    return false;
+  }
+
+  const std::array<robocap_kinematics::Twist<double>, 8> schedule{{
+    {0.5, 0.0, 0.0}, {0.0, 0.4, 0.5}, {-0.3, 0.3, -1.0}, {0.0, 0.0, 0.0},
+    {0.8, -0.2, 0.3}, {0.0, 0.0, 2.0}, {-0.5, -0.5, 0.0}, {0.2, 0.6, -0.6}}};
+  robocap_sim::BatchSimConfig config;
+  config.step_size = kSyntheticStep;
+  config.motor_time_constant = 0.02;
+  config.threads = 1;
+  robocap_sim::BatchSim sim(1, config);
+  for (std::size_t i = 0; i < kSyntheticRecords; ++i) {
+    const auto command =
+      kRobocapKiwiDrive.to_wheel_speeds(schedule[(i / kSyntheticSegment) % schedule.size()]);
+    for (std::size_t wheel = 0; wheel < kNumWheels; ++wheel) {
+      sim.wheel_command(wheel)[0] = static_cast<float>(command[wheel]);
+    }
+    sim.step();
+    const auto robot = sim.state(0);
+    std::size_t column = 0;
+    writer.set(column++, static_cast<std::int64_t>((i + 1) * 1'000'000));
+    for (std::size_t wheel = 0; wheel < kNumWheels; ++wheel) {
+      writer.set(column++, static_cast<double>(sim.wheel_velocity(wheel)[0]));
+      writer.set(column++, command[wheel]);
+    }
+    for (const double value : {robot.x, robot.y, std::cos(robot.yaw / 2.0), 0.0, 0.0,
+        std::sin(robot.yaw / 2.0), robot.vx, robot.vy, robot.wz})
+    {
+      writer.set(column++, value);
+    }
+    writer.commit();
+  }
+  writer.close();
+  return true;
+}
+
+bool load(const std::string & path, Replay & replay)
+{
+  robocap_telemetry::RingLogReader reader;
+  if (!reader.open(path)) {
+    std::fprintf(stderr, "replay_benchmark: cannot map %s\n", path.c_str());
+    return false;
+  }
+  const auto range = reader.range();
+  auto intact = range.begin;
+  const auto column = [&](const std::string & name, auto & out) {
+      const int index = reader.find(name);
+      if (index < 0) {
+        std::fprintf(stderr, "replay_benchmark: %s has no %s column\n", path.c_str(), name.c_str());
+        return false;
+      }
+      intact = std::max(intact, reader.read(index, range, out));
+      return true;
+    };
+
+  std::vector<double> qw;
+  std::vector<double> qx;
+  std::vector<double> qy;
+  std::vector<double> qz;
+  std::vector<double> world_vx;
+  std::vector<double> world_vy;
+  bool ok = column("sim_time_ns", replay.time_ns);
+  for (std::size_t wheel = 0; wheel < kNumWheels; ++wheel) {
+    const std::string joint = kJoints[wheel];
+    ok = ok && column(joint + "/velocity", replay.wheel_velocity[wheel]) &&
+      column(joint + "/velocity_cmd", replay.wheel_command[wheel]);
+  }
+  ok = ok && column("base_x", replay.x) && column("base_y", replay.y) && column("base_qw", qw) &&
+    column("base_qx", qx) && column("base_qy", qy) && column("base_qz", qz) &&
+    column("base_vx", world_vx) && column("base_vy", world_vy) && column("base_wz", replay.wz);
+  if (!ok) {
+    return false;
+  }
+
+  // Drops the head of the ring if the recorder overwrote it while the columns were copied
+  const auto dropped = static_cast<std::ptrdiff_t>(intact - range.begin);
+  const auto trim = [dropped](auto & values) {
+      values.erase(values.begin(), values.begin() + dropped);
+    };
+  trim(replay.time_ns);
+  for (std::size_t wheel = 0; wheel < kNumWheels; ++wheel) {
+    trim(replay.wheel_velocity[wheel]);
+    trim(replay.wheel_command[wheel]);
+  }
+  for (auto * values : {&replay.x, &replay.y, &replay.wz, &qw, &qx, &qy, &qz, &world_vx,
+      &world_vy})
+  {
+    trim(*values);
+  }
+  const std::size_t n = replay.size();
+  if (n < 2) {
+    std::fprintf(stderr, "replay_benchmark: %s holds fewer than two records\n", path.c_str());
+    return false;
+  }
+
+  replay.yaw.resize(n);
+  replay.vx.resize(n);
+  replay.vy.resize(n);
+  replay.ax.assign(n, 0.0);
+  replay.ay.assign(n, 0.0);
+  for (std::size_t i = 0; i < n; ++i) {
+    replay.yaw[i] = std::atan2(
+      2.0 * (qw[i] * qz[i] + qx[i] * qy[i]), 1.0 - 2.0 * (qy[i] * qy[i] + qz[i] * qz[i]));
+    const double c = std::cos(replay.yaw[i]);
+    const double s = std::sin(replay.yaw[i]);
+    replay.vx[i] = c * world_vx[i] + s * world_vy[i];
+    replay.vy[i] = -s * world_vx[i] + c * world_vy[i];
+    if (i > 0) {
+      // Differentiated in the world frame, then turned into base_link like the velocity
+      const double dt = (replay.time_ns[i] - replay.time_ns[i - 1]) * 1e-9;
+      if (dt > 0.0) {
+        const double awx = (world_vx[i] - world_vx[i - 1]) / dt;
+        const double awy = (world_vy[i] - world_vy[i - 1]) / dt;
+        replay.ax[i] = c * awx + s * awy;
+        replay.ay[i] = -s * awx + c * awy;
+      }
+    }
+  }
+  replay.source = path;
+  return true;
+}
+
+// KiwiEkf as EkfOdometryController runs it: predict on the IMU acceleration, then correct with
+// the wheels and the gyro, started on the first recorded pose
+class EkfStage
+{
+public:
+  explicit EkfStage(const Replay & replay)
+  : replay_(replay), ekf_(kRobocapKiwiDrive.inverse_matrix())
+  {
+    ekf_.set_pose(replay.x[0], replay.y[0], replay.yaw[0], Eigen::Matrix3d::Identity() * 1e-9);
+  }
+
+  void step(std::size_t i)
+  {
+    const double dt = (replay_.time_ns[i] - replay_.time_ns[i - 1]) * 1e-9;
+    ekf_.predict(dt, replay_.ax[i], replay_.ay[i]);
+    ekf_.update_wheels(replay_.wheels(i));
+    ekf_.update_gyro(replay_.wz[i]);
+  }
+
+  robocap_planning::Pose2 pose() const
+  {
+    const auto & state = ekf_.state();
+    return {state(robocap_estimation::KiwiEkf::kX), state(robocap_estimation::KiwiEkf::kY),
+      state(robocap_estimation::KiwiEkf::kYaw)};
+  }
+  robocap_kinematics::Twist<double> twist() const
+  {
+    const auto & state = ekf_.state();
+    return {state(robocap_estimation::KiwiEkf::kVx), state(robocap_estimation::KiwiEkf::kVy),
+      state(robocap_estimation::KiwiEkf::kWz)};
+  }
+  // [m] from the recorded pose of record i
+  double error(std::size_t i) const
+  {
+    const auto estimate = pose();
+    return std::hypot(estimate.x - replay_.x[i], estimate.y - replay_.y[i]);
+  }
+
+private:
+  const Replay & replay_;
+  robocap_estimation::KiwiEkf ekf_;
+};
+
+// LocalPlanner's MPPI on a free grid that follows the robot, towards the recorded pose
+// kGoalLookaheadNs later
+class PlannerStage
+{
+public:
+  explicit PlannerStage(const Replay & replay)
+  : replay_(replay), map_(0.3, 65),
+    planner_(kRobocapKiwiDrive, robocap_planning::MppiConfig{}, pool_.size()),
+    cells_(static_cast<std::size_t>(kGridSize) * kGridSize, 0)
+  {
+  }
+
+  robocap_kinematics::Twist<double> plan(
+    std::size_t i, const robocap_planning::Pose2 & pose,
+    const robocap_kinematics::Twist<double> & twist)
+  {
+    map_.update(
+      cells_, kGridSize, kResolution,
+      static_cast<int>(std::floor(pose.x / kResolution)) - kGridSize / 2,
+      static_cast<int>(std::floor(pose.y / kResolution)) - kGridSize / 2);
+    const std::size_t g = replay_.at(replay_.time_ns[i] + kGoalLookaheadNs);
+    return planner_.plan(pose, twist, {replay_.x[g], replay_.y[g], replay_.yaw[g]}, map_.view(),
+             pool_);
+  }
+
+  std::size_t samples() const {return planner_.samples();}
+
+private:
+  const Replay & replay_;
+  robocap_perception::ThreadPool pool_;
+  robocap_planning::ObstacleMap map_;
+  robocap_planning::MppiPlanner planner_;
+  std::vector<std::int8_t> cells_;
+};
+
+double elapsed(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// rtf: seconds of log replayed per second of wall time
+void report_rate(benchmark::State & state, const Replay & replay, double seconds)
+{
+  state.counters["rtf"] = replay.seconds() / seconds;
+  state.SetLabel(replay.source);
+}
+
+// The estimator on every record
+void BM_ReplayEkf(benchmark::State & state, const Replay * replay)
+{
+  EkfStage ekf(*replay);
+  robocap_benchmarks::LatencyStats stats(replay->size());
+  std::size_t i = 1;
+  const auto run_start = std::chrono::steady_clock::now();
+  for (auto _ : state) {
+    const auto start = std::chrono::steady_clock::now();
+    ekf.step(i);
+    stats.add(std::chrono::steady_clock::now() - start);
+    ++i;
+  }
+  report_rate(state, *replay, elapsed(run_start));
+  stats.report(state);
+  state.SetItemsProcessed(state.iterations());
+  // Wheel and gyro odometry only, so this grows with the log's length and its wheel slip
+  state.counters["final_error_m"] = ekf.error(i - 1);
+}
+
+// The MPC at mpc_rate, from the recorded twist towards the recorded wheel commands
+void BM_ReplayMpc(benchmark::State & state, const Replay * replay)
+{
+  robocap_control::KiwiMpc mpc;
+  if (!mpc.configure(robocap_control::KiwiMpcConfig{})) {
+    state.SkipWithError("KiwiMpc rejected its default config");
+    return;
+  }
+  robocap_benchmarks::LatencyStats stats(replay->size());
+  std::size_t unconverged = 0;
+  std::int64_t time = replay->time_ns.front();
+  const auto run_start = std::chrono::steady_clock::now();
+  for (auto _ : state) {
+    const std::size_t i = replay->at(time);
+    const auto current = kRobocapKiwiDrive.to_twist(replay->wheels(i));
+    const auto target = kRobocapKiwiDrive.to_twist(replay->commands(i));
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = mpc.solve({current.vx, current.vy, current.wz},
+        {target.vx, target.vy, target.wz});
+    stats.add(std::chrono::steady_clock::now() - start);
+    unconverged += result.converged ? 0 : 1;
+    time += kMpcPeriodNs;
+  }
+  report_rate(state, *replay, elapsed(run_start));
+  stats.report(state);
+  state.SetItemsProcessed(state.iterations());
+  state.counters["unconverged"] = static_cast<double>(unconverged);
+}
+
+// The local planner at its rate, from the recorded pose and twist
+void BM_ReplayPlanner(benchmark::State & state, const Replay * replay)
+{
+  PlannerStage planner(*replay);
+  robocap_benchmarks::LatencyStats stats(replay->size());
+  std::int64_t time = replay->time_ns.front();
+  const auto run_start = std::chrono::steady_clock::now();
+  for (auto _ : state) {
+    const std::size_t i = replay->at(time);
+    const auto start = std::chrono::steady_clock::now();
+    const auto command = planner.plan(
+      i, {replay->x[i], replay->y[i], replay->yaw[i]}, {replay->vx[i], replay->vy[i],
+        replay->wz[i]});
+    stats.add(std::chrono::steady_clock::now() - start);
+    benchmark::DoNotOptimize(command);
+    time += kPlannerPeriodNs;
+  }
+  report_rate(state, *replay, elapsed(run_start));
+  stats.report(state);
+  state.SetItemsProcessed(state.iterations());
+  state.counters["rollouts"] = static_cast<double>(planner.samples());
+}
+
+// All three chained on one thread in log time, the estimate feeding the planner and the planner's
+// command the MPC, as the stack runs. Each component's latencies get their own counters
+void BM_ReplayStack(benchmark::State & state, const Replay * replay)
+{
+  EkfStage ekf(*replay);
+  PlannerStage planner(*replay);
+  robocap_control::KiwiMpc mpc;
+  if (!mpc.configure(robocap_control::KiwiMpcConfig{})) {
+    state.SkipWithError("KiwiMpc rejected its default config");
+    return;
+  }
+  robocap_benchmarks::LatencyStats ekf_stats(replay->size());
+  robocap_benchmarks::LatencyStats mpc_stats(replay->size());
+  robocap_benchmarks::LatencyStats planner_stats(replay->size());
+  robocap_kinematics::Twist<double> command{0.0, 0.0, 0.0};
+  std::int64_t next_mpc = replay->time_ns.front();
+  std::int64_t next_plan = replay->time_ns.front();
+  std::size_t i = 1;
+  const auto run_start = std::chrono::steady_clock::now();
+  for (auto _ : state) {
+    auto start = std::chrono::steady_clock::now();
+    ekf.step(i);
+    ekf_stats.add(std::chrono::steady_clock::now() - start);
+    if (replay->time_ns[i] >= next_plan) {
+      start = std::chrono::steady_clock::now();
+      command = planner.plan(i, ekf.pose(), ekf.twist());
+      planner_stats.add(std::chrono::steady_clock::now() - start);
+      next_plan += kPlannerPeriodNs;
+    }
+    if (replay->time_ns[i] >= next_mpc) {
+      const auto twist = ekf.twist();
+      start = std::chrono::steady_clock::now();
+      const auto result = mpc.solve({twist.vx, twist.vy, twist.wz},
+          {command.vx, command.vy, command.wz});
+      mpc_stats.add(std::chrono::steady_clock::now() - start);
+      benchmark::DoNotOptimize(result);
+      next_mpc += kMpcPeriodNs;
+    }
+    ++i;
+  }
+  report_rate(state, *replay, elapsed(run_start));
+  ekf_stats.report(state, "ekf_");
+  mpc_stats.report(state, "mpc_");
+  planner_stats.report(state, "planner_");
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Calls at `period` [ns] of log time over the whole log
+benchmark::IterationCount calls(const Replay & replay, std::int64_t period)
+{
+  return (replay.time_ns.back() - replay.time_ns.front()) / period + 1;
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+
+  static Replay replay;
+  const char * log = std::getenv("ROBOCAP_REPLAY_LOG");
+  if (log != nullptr && log[0] != '\0') {
+    if (!load(log, replay)) {
+      return 1;
+    }
+  } else {
+    char path[] = "/tmp/robocap_replay_XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd < 0) {
+      std::perror("replay_benchmark: mkstemp");
+      return 1;
+    }
+    ::close(fd);
+    const bool ok = record_synthetic_log(path) && load(path, replay);
+    ::unlink(path);
+    if (!ok) {
+      return 1;
+    }
+    replay.source = "synthetic";
+  }
+
+  const auto records = static_cast<benchmark::IterationCount>(replay.size() - 1);
+  benchmark::RegisterBenchmark("BM_ReplayEkf", BM_ReplayEkf, &replay)->Iterations(records);
+  benchmark::RegisterBenchmark("BM_ReplayMpc", BM_ReplayMpc, &replay)
+  ->Iterations(calls(replay, kMpcPeriodNs));
+  benchmark::RegisterBenchmark("BM_ReplayPlanner", BM_ReplayPlanner, &replay)
+  ->Iterations(calls(replay, kPlannerPeriodNs))->Unit(benchmark::kMillisecond)->UseRealTime();
+  benchmark::RegisterBenchmark("BM_ReplayStack", BM_ReplayStack, &replay)
+  ->Iterations(records)->Unit(benchmark::kMicrosecond)->UseRealTime();
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
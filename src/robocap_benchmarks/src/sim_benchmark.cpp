@@ -0,0 +1,144 @@
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ament_index_cpp/get_package_share_directory.hpp"
+#include "benchmark/benchmark.h"
+#include "ignition/gazebo/Server.hh"
+#include "ignition/gazebo/ServerConfig.hh"
+#include "nav_msgs/msg/odometry.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "sdf/Physics.hh"
+#include "sdf/Root.hh"
+#include "sdf/World.hh"
+
+extern char ** environ;
+
+namespace
+{
+
+constexpr std::uint64_t kStepsPerIteration = 2000;
+constexpr auto kStartupTimeout = std::chrono::seconds(120);
+constexpr auto kShutdownTimeout = std::chrono::seconds(20);
+
+std::string world_file()
+{
+  return ament_index_cpp::get_package_share_directory("robocap_sim") + "/worlds/robocap.sdf";
+}
+
+double step_size(const std::string & world)
+{
+  sdf::Root root;
+  if (!root.Load(world).empty() || root.WorldCount() == 0) {
+    return 0.0;
+  }
+  return root.WorldByIndex(0)->PhysicsDefault()->MaxStepSize();
+}
+
+// Real-time factor the robocap world reaches without wall-clock throttling, robot, lidar and IMU
+// included. Same server setup as robocap_sim_farm; no controllers are spawned, so the controller
+// manager only runs its read/write cycle.
+void BM_RobocapWorldRealTimeFactor(benchmark::State & state)
+{
+  const auto world = world_file();
+  const double dt = step_size(world);
+  if (dt <= 0.0) {
+    state.SkipWithError("Could not read the physics step of the robocap world");
+    return;
+  }
+  ignition::gazebo::ServerConfig config;
+  config.SetSdfFile(world);
+  config.SetHeadlessRendering(true);
+  ignition::gazebo::Server server(config);
+  server.SetUpdatePeriod(std::chrono::nanoseconds(0));
+  // Spawn the robot and let it settle before timing
+  server.Run(true, 1000, false);
+
+  double wall = 0.0;
+  for (auto _ : state) {
+    const auto start = std::chrono::steady_clock::now();
+    server.Run(true, kStepsPerIteration, false);
+    wall += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  const double simulated = static_cast<double>(state.iterations() * kStepsPerIteration) * dt;
+  state.counters["rtf"] = simulated / wall;
+  state.counters["steps_per_second"] = simulated / dt / wall;
+}
+
+// Wall time from `ros2 launch robocap_sim gazebo.launch.py headless:=true` to the first odometry
+// from kiwi_drive_controller, i.e. until the whole stack is up and the controllers are active
+void BM_GazeboLaunchStartup(benchmark::State & state)
+{
+  if (!rclcpp::ok()) {
+    rclcpp::init(0, nullptr);
+  }
+  const auto node = std::make_shared<rclcpp::Node>("launch_startup_benchmark");
+  std::atomic<bool> received{false};
+  const auto subscription = node->create_subscription<nav_msgs::msg::Odometry>(
+    "/kiwi_drive_controller/odom", rclcpp::SystemDefaultsQoS(),
+    [&received](nav_msgs::msg::Odometry::ConstSharedPtr /*odom*/) {received = true;});
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(node);
+
+  std::vector<std::string> arguments{
+    "ros2", "launch", "robocap_sim", "gazebo.launch.py", "headless:=true"};
+  std::vector<char *> argv;
+  for (auto & argument : arguments) {
+    argv.push_back(argument.data());
+  }
+  argv.push_back(nullptr);
+
+  for (auto _ : state) {
+    received = false;
+    // Own process group, so the shutdown below reaches gz sim and the container too
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP);
+    posix_spawnattr_setpgroup(&attributes, 0);
+    pid_t pid = 0;
+    const auto start = std::chrono::steady_clock::now();
+    const int error = posix_spawnp(&pid, "ros2", nullptr, &attributes, argv.data(), environ);
+    posix_spawnattr_destroy(&attributes);
+    if (error != 0) {
+      state.SkipWithError("Failed to run ros2 launch");
+      return;
+    }
+    while (!received && std::chrono::steady_clock::now() - start < kStartupTimeout) {
+      executor.spin_some(std::chrono::milliseconds(10));
+    }
+    state.SetIterationTime(
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    kill(-pid, SIGINT);
+    const auto stop = std::chrono::steady_clock::now();
+    int status = 0;
+    while (waitpid(pid, &status, WNOHANG) == 0) {
+      if (std::chrono::steady_clock::now() - stop > kShutdownTimeout) {
+        kill(-pid, SIGKILL);
+        waitpid(pid, &status, 0);
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    if (!received) {
+      state.SkipWithError("kiwi_drive_controller never published odometry");
+      return;
+    }
+  }
+}
+
+}  // namespace
+
+BENCHMARK(BM_RobocapWorldRealTimeFactor)->Unit(benchmark::kMillisecond)->Iterations(10);
+BENCHMARK(BM_GazeboLaunchStartup)->UseManualTime()->Unit(benchmark::kSecond)->Iterations(3);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,31 @@
+#ifndef ROBOCAP_BRIDGE__CLOCK_BRIDGE_HPP_
+#define ROBOCAP_BRIDGE__CLOCK_BRIDGE_HPP_
+
+#include "ignition/msgs/clock.pb.h"
+#include "ignition/transport/Node.hh"
+#include "rclcpp/rclcpp.hpp"
+#include "rosgraph_msgs/msg/clock.hpp"
+
+namespace robocap_bridge
+{
+
+// Publishes the simulation clock on /clock, in place of a ros_gz_bridge parameter_bridge process.
+//
+// Parameters:
+//   gz_topic  ign-transport clock topic, defaults to /clock
+class ClockBridge : public rclcpp::Node
+{
+public:
+  explicit ClockBridge(const rclcpp::NodeOptions & options);
+
+private:
+  void on_clock(const ignition::msgs::Clock & clock);
+
+  rclcpp::Publisher<rosgraph_msgs::msg::Clock>::SharedPtr publisher_;
+  // Declared last, so its callbacks stop before the publisher goes away
+  ignition::transport::Node gz_node_;
+};
+
+}  // namespace robocap_bridge
+
+#endif  // ROBOCAP_BRIDGE__CLOCK_BRIDGE_HPP_
@@ -0,0 +1,36 @@
+#ifndef ROBOCAP_BRIDGE__IMU_BRIDGE_HPP_
+#define ROBOCAP_BRIDGE__IMU_BRIDGE_HPP_
+
+#include <string>
+
+#include "ignition/msgs/imu.pb.h"
+#include "ignition/transport/Node.hh"
+#include "rclcpp/rclcpp.hpp"
+#include "sensor_msgs/msg/imu.hpp"
+
+namespace robocap_bridge
+{
+
+// Republishes an IMU sensor from ign-transport as sensor_msgs/Imu on "imu", moved to
+// intra-process subscribers the same way as LaserScanBridge.
+//
+// Parameters:
+//   gz_topic  ign-transport topic of the sensor, defaults to /robocap/imu
+//   frame_id  header frame, defaults to chassis
+class ImuBridge : public rclcpp::Node
+{
+public:
+  explicit ImuBridge(const rclcpp::NodeOptions & options);
+
+private:
+  void on_imu(const ignition::msgs::IMU & imu);
+
+  std::string frame_id_;
+  rclcpp::Publisher<sensor_msgs::msg::Imu>::SharedPtr publisher_;
+  // Declared last, so its callbacks stop before the publisher goes away
+  ignition::transport::Node gz_node_;
+};
+
+}  // namespace robocap_bridge
+
+#endif  // ROBOCAP_BRIDGE__IMU_BRIDGE_HPP_
@@ -0,0 +1,40 @@
+#ifndef ROBOCAP_BRIDGE__LASER_SCAN_BRIDGE_HPP_
+#define ROBOCAP_BRIDGE__LASER_SCAN_BRIDGE_HPP_
+
+#include <string>
+
+#include "ignition/msgs/laserscan.pb.h"
+#include "ignition/transport/Node.hh"
+#include "rclcpp/rclcpp.hpp"
+#include "sensor_msgs/msg/laser_scan.hpp"
+
+namespace robocap_bridge
+{
+
+// Republishes a gpu_lidar scan from ign-transport as sensor_msgs/LaserScan on "scan".
+//
+// Meant to run in the robocap component container with intra-process comms on: each scan is
+// converted once into a unique_ptr and handed to subscribers in the same container by move. Out of
+// the container it fills a middleware loan when the rmw offers one.
+//
+// Parameters:
+//   gz_topic  ign-transport topic of the sensor, defaults to /robocap/laser/scan
+//   frame_id  header frame, defaults to laser
+class LaserScanBridge : public rclcpp::Node
+{
+public:
+  explicit LaserScanBridge(const rclcpp::NodeOptions & options);
+
+private:
+  void on_scan(const ignition::msgs::LaserScan & scan);
+  void fill(const ignition::msgs::LaserScan & scan, sensor_msgs::msg::LaserScan & message) const;
+
+  std::string frame_id_;
+  rclcpp::Publisher<sensor_msgs::msg::LaserScan>::SharedPtr publisher_;
+  // Declared last, so its callbacks stop before the publisher goes away
+  ignition::transport::Node gz_node_;
+};
+
+}  // namespace robocap_bridge
+
+#endif  // ROBOCAP_BRIDGE__LASER_SCAN_BRIDGE_HPP_
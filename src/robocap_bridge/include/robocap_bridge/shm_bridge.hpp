@@ -0,0 +1,100 @@
+#ifndef ROBOCAP_BRIDGE__SHM_BRIDGE_HPP_
+#define ROBOCAP_BRIDGE__SHM_BRIDGE_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "nav_msgs/msg/odometry.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "sensor_msgs/msg/joint_state.hpp"
+#include "sensor_msgs/msg/laser_scan.hpp"
+
+#include "robocap_bridge/shm_segment.hpp"
+#include "robocap_runtime/metrics.hpp"
+
+namespace robocap_bridge
+{
+
+// Publishes what robocap_bridge::ShmPublisher writes into shared memory from inside gz sim: joint
+// states on "joint_states", the base link's ground truth on "ground_truth" and the lidar on
+// "scan". Samples are read where the simulator left them and converted once, straight into the
+// outgoing message, so neither protobuf nor a gz-transport socket is on the way. It fills a loan
+// if the rmw has one and intra-process comms are off, and otherwise one message kept per topic,
+// published by const reference: without intra-process comms that serializes it in place, and the
+// message keeps its sequences' capacity, so publishing does not allocate once it was filled. With
+// them rclcpp copies it into a message of the subscriptions' std::allocator, as the publishers
+// use std::allocator too: intra-process delivery throws on a publisher and subscription with
+// different allocators. A sample the simulator overwrote while it was being read is dropped.
+//
+// A thread of its own sleeps on the segment and publishes as soon as a sample is committed. Per
+// topic, samples the simulator overwrote
+// before this thread got to them (robocap_bridge_samples_skipped_total), torn samples
+// (robocap_bridge_samples_torn_total) and the age of those published (robocap_message_age_seconds)
+// go to robocap_runtime's metrics.
+//
+// Parameters:
+//   segment         shared memory name, defaults to /robocap_bridge
+//   frame_id        scan frame, defaults to laser
+//   odom_frame_id   ground truth parent frame, defaults to world
+//   base_frame_id   ground truth child frame, defaults to base_link
+class ShmBridge : public rclcpp::Node
+{
+public:
+  explicit ShmBridge(const rclcpp::NodeOptions & options);
+  ~ShmBridge() override;
+
+private:
+  void run();
+  void publish_joints();
+  void publish_base();
+  void publish_scan();
+
+  // One topic's series, labelled with it
+  struct ChannelMetrics
+  {
+    robocap_runtime::Counter * skipped = nullptr;
+    robocap_runtime::Counter * torn = nullptr;
+    robocap_runtime::Histogram * age = nullptr;
+  };
+
+  // Fills a loan or `message` and publishes it, returns false for a torn sample
+  template<typename MessageT, typename FillT>
+  bool publish(
+    typename rclcpp::Publisher<MessageT>::SharedPtr & publisher, MessageT & message,
+    ChannelMetrics & metrics, FillT && fill);
+  ChannelMetrics channel_metrics(const rclcpp::PublisherBase & publisher) const;
+  // Samples between write counts `previous` and `count`, the last two read
+  void count_skipped(ChannelMetrics & metrics, std::uint64_t previous, std::uint64_t count);
+  void record_age(ChannelMetrics & metrics, const rclcpp::Time & stamp);
+
+  std::string segment_name_;
+  std::string frame_id_;
+  std::string odom_frame_id_;
+  std::string base_frame_id_;
+  std::vector<std::string> joint_names_;
+  std::uint64_t last_joints_ = 0;
+  std::uint64_t last_base_ = 0;
+  std::uint64_t last_scan_ = 0;
+
+  rclcpp::Publisher<sensor_msgs::msg::JointState>::SharedPtr joint_state_publisher_;
+  rclcpp::Publisher<nav_msgs::msg::Odometry>::SharedPtr ground_truth_publisher_;
+  rclcpp::Publisher<sensor_msgs::msg::LaserScan>::SharedPtr scan_publisher_;
+  // Reused for every sample, only touched by the bridge's thread
+  sensor_msgs::msg::JointState joint_state_message_;
+  nav_msgs::msg::Odometry ground_truth_message_;
+  sensor_msgs::msg::LaserScan scan_message_;
+  ChannelMetrics joint_metrics_;
+  ChannelMetrics base_metrics_;
+  ChannelMetrics scan_metrics_;
+
+  ShmReader reader_;
+  std::atomic<bool> running_{true};
+  std::thread thread_;
+};
+
+}  // namespace robocap_bridge
+
+#endif  // ROBOCAP_BRIDGE__SHM_BRIDGE_HPP_
@@ -0,0 +1,56 @@
+#ifndef ROBOCAP_BRIDGE__SHM_PUBLISHER_HPP_
+#define ROBOCAP_BRIDGE__SHM_PUBLISHER_HPP_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ignition/gazebo/Entity.hh"
+#include "ignition/gazebo/System.hh"
+#include "ignition/msgs/laserscan.pb.h"
+#include "ignition/transport/Node.hh"
+
+#include "robocap_bridge/shm_segment.hpp"
+
+namespace robocap_bridge
+{
+
+// Model system that writes the wheel joint states and the base pose after every physics step, and
+// every lidar scan, into a ShmSegment for ShmBridge. Nothing goes through protobuf: joint states
+// and pose are copied straight out of the ECM, and the scan is taken from the Sensors system by
+// ign-transport's in-process delivery, which hands over the message object without serializing.
+//
+// SDF parameters:
+//   <segment>     shared memory name, defaults to $ROBOCAP_SHM_SEGMENT. Off if neither is set
+//   <joint>       joint to write, repeated. Defaults to wheel_1_joint..wheel_3_joint
+//   <scan_topic>  ign-transport topic of the lidar, defaults to /robocap/laser/scan
+class ShmPublisher
+  : public ignition::gazebo::System,
+  public ignition::gazebo::ISystemConfigure,
+  public ignition::gazebo::ISystemPostUpdate
+{
+public:
+  ShmPublisher() = default;
+
+  void Configure(
+    const ignition::gazebo::Entity & entity, const std::shared_ptr<const sdf::Element> & sdf,
+    ignition::gazebo::EntityComponentManager & ecm,
+    ignition::gazebo::EventManager & event_manager) override;
+
+  void PostUpdate(
+    const ignition::gazebo::UpdateInfo & info,
+    const ignition::gazebo::EntityComponentManager & ecm) override;
+
+private:
+  void on_scan(const ignition::msgs::LaserScan & scan);
+
+  std::vector<ignition::gazebo::Entity> joints_;
+  ignition::gazebo::Entity base_link_ = ignition::gazebo::kNullEntity;
+  ShmWriter writer_;
+  // Declared last, so scan callbacks stop before the writer unmaps
+  ignition::transport::Node gz_node_;
+};
+
+}  // namespace robocap_bridge
+
+#endif  // ROBOCAP_BRIDGE__SHM_PUBLISHER_HPP_
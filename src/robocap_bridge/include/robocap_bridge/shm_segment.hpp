@@ -0,0 +1,210 @@
+#ifndef ROBOCAP_BRIDGE__SHM_SEGMENT_HPP_
+#define ROBOCAP_BRIDGE__SHM_SEGMENT_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace robocap_bridge
+{
+
+// Layout of the POSIX shared memory segment robocap_bridge::ShmPublisher writes from inside the
+// simulator and ShmBridge reads on the ROS side. Every sample is a fixed-size POD, so nothing is
+// serialized on either side: the writer stores numbers into a slot, readers read them in place.
+//
+// Each channel is a ring of kSlots samples with one writer. Slot i % kSlots holds sample i, its
+// sequence is 2i + 1 while the writer fills it and 2i + 2 once complete; write_count = i + 1 then
+// publishes it. A reader borrows the newest slot and, when done with it, checks that the sequence
+// did not move, i.e. the writer did not lap it meanwhile. Any commit bumps the segment's
+// generation, a futex word readers sleep on.
+constexpr std::uint64_t kShmMagic = 0x4d48535043424f52;  // "ROBCPSHM"
+constexpr std::uint32_t kShmVersion = 1;
+constexpr std::size_t kShmSlots = 4;
+constexpr std::size_t kMaxJoints = 16;
+constexpr std::size_t kJointNameSize = 32;
+constexpr std::size_t kMaxScanRanges = 4096;
+
+struct JointStateSample
+{
+  std::int64_t stamp_ns;
+  std::uint32_t count;
+  std::uint32_t reserved;
+  double position[kMaxJoints];
+  double velocity[kMaxJoints];
+  double effort[kMaxJoints];
+};
+
+// Canonical link of the model in the world frame, velocities in the world frame too
+struct BasePoseSample
+{
+  std::int64_t stamp_ns;
+  double position[3];
+  double orientation[4];  // x, y, z, w
+  double linear_velocity[3];
+  double angular_velocity[3];
+};
+
+// First row of the lidar, like sensor_msgs/LaserScan
+struct ScanSample
+{
+  std::int64_t stamp_ns;
+  float angle_min;
+  float angle_max;
+  float angle_increment;
+  float range_min;
+  float range_max;
+  std::uint32_t count;
+  std::uint32_t intensity_count;
+  std::uint32_t reserved;
+  float ranges[kMaxScanRanges];
+  float intensities[kMaxScanRanges];
+};
+
+template<typename T>
+struct ShmChannel
+{
+  struct alignas(64) Slot
+  {
+    std::atomic<std::uint64_t> sequence;
+    T sample;
+  };
+
+  alignas(64) std::atomic<std::uint64_t> write_count;
+  Slot slots[kShmSlots];
+};
+
+struct ShmSegment
+{
+  std::uint64_t magic;
+  std::uint32_t version;
+  std::uint32_t joint_count;
+  char joint_names[kMaxJoints][kJointNameSize];
+  alignas(64) std::atomic<std::uint32_t> generation;
+  std::atomic<std::uint32_t> waiters;
+  ShmChannel<JointStateSample> joints;
+  ShmChannel<BasePoseSample> base;
+  ShmChannel<ScanSample> scan;
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "processes share the atomics");
+static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t), "used as a futex");
+
+// Creates or reuses the segment `name` (e.g. /robocap_bridge) and writes it. Each channel must
+// only be written from one thread at a time; different channels from different threads is fine.
+// After open(), begin()/commit() never allocate or fault, so they are safe on the physics thread.
+class ShmWriter
+{
+public:
+  ShmWriter() = default;
+  ~ShmWriter();
+  ShmWriter(const ShmWriter &) = delete;
+  ShmWriter & operator=(const ShmWriter &) = delete;
+
+  bool open(const std::string & name, const char * const * joint_names, std::size_t joint_count);
+  void close();
+  bool is_open() const {return segment_ != nullptr;}
+
+  // Slot for the next sample of `channel`, to fill and then commit()
+  template<typename T>
+  T & begin(ShmChannel<T> & channel)
+  {
+    const auto index = channel.write_count.load(std::memory_order_relaxed);
+    auto & slot = channel.slots[index % kShmSlots];
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return slot.sample;
+  }
+
+  template<typename T>
+  void commit(ShmChannel<T> & channel)
+  {
+    const auto index = channel.write_count.load(std::memory_order_relaxed);
+    channel.slots[index % kShmSlots].sequence.store(2 * index + 2, std::memory_order_release);
+    channel.write_count.store(index + 1, std::memory_order_release);
+    notify();
+  }
+
+  ShmSegment & segment() {return *segment_;}
+
+private:
+  void notify();
+
+  ShmSegment * segment_ = nullptr;
+};
+
+// A sample still inside the segment. Only trust what was read from it if valid() holds afterwards
+template<typename T>
+class Borrowed
+{
+public:
+  Borrowed() = default;
+  Borrowed(const typename ShmChannel<T>::Slot * slot, std::uint64_t sequence)
+  : slot_(slot), sequence_(sequence)
+  {
+  }
+
+  explicit operator bool() const {return slot_ != nullptr;}
+  const T & operator*() const {return slot_->sample;}
+  const T * operator->() const {return &slot_->sample;}
+
+  bool valid() const
+  {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot_ && slot_->sequence.load(std::memory_order_relaxed) == sequence_;
+  }
+
+private:
+  const typename ShmChannel<T>::Slot * slot_ = nullptr;
+  std::uint64_t sequence_ = 0;
+};
+
+// Maps a segment some ShmWriter created, possibly in another process
+class ShmReader
+{
+public:
+  ShmReader() = default;
+  ~ShmReader();
+  ShmReader(const ShmReader &) = delete;
+  ShmReader & operator=(const ShmReader &) = delete;
+
+  bool open(const std::string & name);
+  void close();
+  bool is_open() const {return segment_ != nullptr;}
+
+  const ShmSegment & segment() const {return *segment_;}
+
+  // Newest sample of `channel` if it is newer than `*last` (a write_count seen before), which is
+  // then advanced. Empty if nothing new, or if the writer is lapping this reader right now.
+  // A write_count smaller than `*last` means the writer restarted, it counts as new.
+  template<typename T>
+  Borrowed<T> latest(const ShmChannel<T> & channel, std::uint64_t * last) const
+  {
+    const auto count = channel.write_count.load(std::memory_order_acquire);
+    if (count == 0 || count == *last) {
+      return {};
+    }
+    const auto & slot = channel.slots[(count - 1) % kShmSlots];
+    const auto sequence = 2 * (count - 1) + 2;
+    if (slot.sequence.load(std::memory_order_acquire) != sequence) {
+      return {};
+    }
+    *last = count;
+    return {&slot, sequence};
+  }
+
+  // Sleeps until any channel commits after `generation` was read, or `timeout` passes
+  void wait(std::uint32_t generation, std::chrono::nanoseconds timeout) const;
+  std::uint32_t generation() const
+  {
+    return segment_->generation.load(std::memory_order_acquire);
+  }
+
+private:
+  ShmSegment * segment_ = nullptr;
+};
+
+}  // namespace robocap_bridge
+
+#endif  // ROBOCAP_BRIDGE__SHM_SEGMENT_HPP_
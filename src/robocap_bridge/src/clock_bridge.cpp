@@ -0,0 +1,38 @@
+#include "robocap_bridge/clock_bridge.hpp"
+
+#include <stdexcept>
+#include <string>
+
+#include "ignition/msgs/Utility.hh"
+#include "robocap_tracing/tracing.hpp"
+
+namespace robocap_bridge
+{
+
+ClockBridge::ClockBridge(const rclcpp::NodeOptions & options)
+: rclcpp::Node("clock_bridge", options)
+{
+  const auto gz_topic = declare_parameter<std::string>("gz_topic", "/clock");
+  publisher_ = create_publisher<rosgraph_msgs::msg::Clock>("/clock", rclcpp::ClockQoS());
+
+  if (!gz_node_.Subscribe(gz_topic, &ClockBridge::on_clock, this)) {
+    throw std::runtime_error("Failed to subscribe to '" + gz_topic + "'");
+  }
+  ROBOCAP_TRACEPOINT(component_init, this, publisher_->get_topic_name());
+}
+
+void ClockBridge::on_clock(const ignition::msgs::Clock & clock)
+{
+  ROBOCAP_TRACEPOINT(bridge_publish_start, this, ignition::msgs::Convert(clock.sim()).count());
+  rosgraph_msgs::msg::Clock message;
+  message.clock.sec = static_cast<int32_t>(clock.sim().sec());
+  message.clock.nanosec = static_cast<uint32_t>(clock.sim().nsec());
+  publisher_->publish(message);
+  ROBOCAP_TRACEPOINT(bridge_publish_end, this);
+}
+
+}  // namespace robocap_bridge
+
+#include "rclcpp_components/register_node_macro.hpp"
+
+RCLCPP_COMPONENTS_REGISTER_NODE(robocap_bridge::ClockBridge)
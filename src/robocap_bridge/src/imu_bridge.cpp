@@ -0,0 +1,56 @@
+#include "robocap_bridge/imu_bridge.hpp"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "ignition/msgs/Utility.hh"
+#include "robocap_tracing/tracing.hpp"
+
+namespace robocap_bridge
+{
+
+ImuBridge::ImuBridge(const rclcpp::NodeOptions & options)
+: rclcpp::Node("imu_bridge", options)
+{
+  const auto gz_topic = declare_parameter<std::string>("gz_topic", "/robocap/imu");
+  frame_id_ = declare_parameter<std::string>("frame_id", "chassis");
+  publisher_ = create_publisher<sensor_msgs::msg::Imu>("imu", rclcpp::SensorDataQoS());
+
+  if (!gz_node_.Subscribe(gz_topic, &ImuBridge::on_imu, this)) {
+    throw std::runtime_error("Failed to subscribe to '" + gz_topic + "'");
+  }
+  RCLCPP_INFO(
+    get_logger(), "Bridging '%s' to '%s'", gz_topic.c_str(), publisher_->get_topic_name());
+  ROBOCAP_TRACEPOINT(component_init, this, publisher_->get_topic_name());
+}
+
+void ImuBridge::on_imu(const ignition::msgs::IMU & imu)
+{
+  ROBOCAP_TRACEPOINT(
+    bridge_publish_start, this, ignition::msgs::Convert(imu.header().stamp()).count());
+  auto message = std::make_unique<sensor_msgs::msg::Imu>();
+  message->header.stamp.sec = static_cast<int32_t>(imu.header().stamp().sec());
+  message->header.stamp.nanosec = static_cast<uint32_t>(imu.header().stamp().nsec());
+  message->header.frame_id = frame_id_;
+  message->orientation.x = imu.orientation().x();
+  message->orientation.y = imu.orientation().y();
+  message->orientation.z = imu.orientation().z();
+  message->orientation.w = imu.orientation().w();
+  message->angular_velocity.x = imu.angular_velocity().x();
+  message->angular_velocity.y = imu.angular_velocity().y();
+  message->angular_velocity.z = imu.angular_velocity().z();
+  message->linear_acceleration.x = imu.linear_acceleration().x();
+  message->linear_acceleration.y = imu.linear_acceleration().y();
+  message->linear_acceleration.z = imu.linear_acceleration().z();
+  // Covariances stay zero, i.e. unknown: the noise is configured in urdf/imu.xacro
+  publisher_->publish(std::move(message));
+  ROBOCAP_TRACEPOINT(bridge_publish_end, this);
+}
+
+}  // namespace robocap_bridge
+
+#include "rclcpp_components/register_node_macro.hpp"
+
+RCLCPP_COMPONENTS_REGISTER_NODE(robocap_bridge::ImuBridge)
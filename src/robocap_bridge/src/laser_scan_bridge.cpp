@@ -0,0 +1,80 @@
+#include "robocap_bridge/laser_scan_bridge.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "ignition/msgs/Utility.hh"
+#include "robocap_tracing/tracing.hpp"
+
+namespace robocap_bridge
+{
+
+LaserScanBridge::LaserScanBridge(const rclcpp::NodeOptions & options)
+: rclcpp::Node("laser_scan_bridge", options)
+{
+  const auto gz_topic = declare_parameter<std::string>("gz_topic", "/robocap/laser/scan");
+  frame_id_ = declare_parameter<std::string>("frame_id", "laser");
+  publisher_ = create_publisher<sensor_msgs::msg::LaserScan>("scan", rclcpp::SensorDataQoS());
+
+  if (!gz_node_.Subscribe(gz_topic, &LaserScanBridge::on_scan, this)) {
+    throw std::runtime_error("Failed to subscribe to '" + gz_topic + "'");
+  }
+  RCLCPP_INFO(
+    get_logger(), "Bridging '%s' to '%s'", gz_topic.c_str(), publisher_->get_topic_name());
+  ROBOCAP_TRACEPOINT(component_init, this, publisher_->get_topic_name());
+}
+
+void LaserScanBridge::on_scan(const ignition::msgs::LaserScan & scan)
+{
+  ROBOCAP_TRACEPOINT(
+    bridge_publish_start, this, ignition::msgs::Convert(scan.header().stamp()).count());
+  if (get_node_options().use_intra_process_comms() || !publisher_->can_loan_messages()) {
+    // Moved to intra-process subscribers, serialized at most once for anyone outside
+    auto message = std::make_unique<sensor_msgs::msg::LaserScan>();
+    fill(scan, *message);
+    publisher_->publish(std::move(message));
+    ROBOCAP_TRACEPOINT(bridge_publish_end, this);
+    return;
+  }
+  auto loaned = publisher_->borrow_loaned_message();
+  fill(scan, loaned.get());
+  publisher_->publish(std::move(loaned));
+  ROBOCAP_TRACEPOINT(bridge_publish_end, this);
+}
+
+void LaserScanBridge::fill(
+  const ignition::msgs::LaserScan & scan, sensor_msgs::msg::LaserScan & message) const
+{
+  message.header.stamp.sec = static_cast<int32_t>(scan.header().stamp().sec());
+  message.header.stamp.nanosec = static_cast<uint32_t>(scan.header().stamp().nsec());
+  message.header.frame_id = frame_id_;
+  message.angle_min = static_cast<float>(scan.angle_min());
+  message.angle_max = static_cast<float>(scan.angle_max());
+  message.angle_increment = static_cast<float>(scan.angle_step());
+  message.time_increment = 0.0f;  // gpu_lidar renders the whole sweep at one instant
+  message.scan_time = 0.0f;
+  message.range_min = static_cast<float>(scan.range_min());
+  message.range_max = static_cast<float>(scan.range_max());
+
+  // Only the first row of a multi-row lidar fits a LaserScan
+  const auto count =
+    std::min(static_cast<std::size_t>(scan.count()), static_cast<std::size_t>(scan.ranges_size()));
+  message.ranges.resize(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    message.ranges[i] = static_cast<float>(scan.ranges(static_cast<int>(i)));
+  }
+  const auto intensities = std::min(count, static_cast<std::size_t>(scan.intensities_size()));
+  message.intensities.resize(intensities);
+  for (std::size_t i = 0; i < intensities; ++i) {
+    message.intensities[i] = static_cast<float>(scan.intensities(static_cast<int>(i)));
+  }
+}
+
+}  // namespace robocap_bridge
+
+#include "rclcpp_components/register_node_macro.hpp"
+
+RCLCPP_COMPONENTS_REGISTER_NODE(robocap_bridge::LaserScanBridge)
@@ -0,0 +1,238 @@
+#include "robocap_bridge/shm_bridge.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "robocap_tracing/tracing.hpp"
+
+namespace robocap_bridge
+{
+
+namespace
+{
+
+constexpr auto kWaitTimeout = std::chrono::milliseconds(100);
+constexpr auto kRetryPeriod = std::chrono::milliseconds(100);
+
+// Rotates the world frame vector `v` into the frame of orientation `q` (x, y, z, w)
+void to_body(const double q[4], const double v[3], double out[3])
+{
+  // v + 2 u x (u x v + w v) with u = -q.xyz, the inverse rotation
+  const double ux = -q[0], uy = -q[1], uz = -q[2], w = q[3];
+  const double tx = 2.0 * (uy * v[2] - uz * v[1]);
+  const double ty = 2.0 * (uz * v[0] - ux * v[2]);
+  const double tz = 2.0 * (ux * v[1] - uy * v[0]);
+  out[0] = v[0] + w * tx + (uy * tz - uz * ty);
+  out[1] = v[1] + w * ty + (uz * tx - ux * tz);
+  out[2] = v[2] + w * tz + (ux * ty - uy * tx);
+}
+
+}  // namespace
+
+ShmBridge::ShmBridge(const rclcpp::NodeOptions & options)
+: rclcpp::Node("shm_bridge", options)
+{
+  segment_name_ = declare_parameter<std::string>("segment", "/robocap_bridge");
+  frame_id_ = declare_parameter<std::string>("frame_id", "laser");
+  odom_frame_id_ = declare_parameter<std::string>("odom_frame_id", "world");
+  base_frame_id_ = declare_parameter<std::string>("base_frame_id", "base_link");
+  joint_state_publisher_ =
+    create_publisher<sensor_msgs::msg::JointState>("joint_states", rclcpp::SensorDataQoS());
+  ground_truth_publisher_ =
+    create_publisher<nav_msgs::msg::Odometry>("ground_truth", rclcpp::SensorDataQoS());
+  scan_publisher_ =
+    create_publisher<sensor_msgs::msg::LaserScan>("scan", rclcpp::SensorDataQoS());
+  joint_metrics_ = channel_metrics(*joint_state_publisher_);
+  base_metrics_ = channel_metrics(*ground_truth_publisher_);
+  scan_metrics_ = channel_metrics(*scan_publisher_);
+
+  thread_ = std::thread([this]() {run();});
+  RCLCPP_INFO(get_logger(), "Bridging shared memory segment '%s'", segment_name_.c_str());
+  ROBOCAP_TRACEPOINT(component_init, this, get_fully_qualified_name());
+}
+
+ShmBridge::~ShmBridge()
+{
+  running_ = false;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+ShmBridge::ChannelMetrics ShmBridge::channel_metrics(
+  const rclcpp::PublisherBase & publisher) const
+{
+  auto & registry = robocap_runtime::MetricsRegistry::global();
+  const robocap_runtime::Labels labels{{"topic", publisher.get_topic_name()}};
+  ChannelMetrics metrics;
+  metrics.skipped = &registry.counter(
+    "robocap_bridge_samples_skipped_total",
+    "Simulator samples overwritten before the bridge read them", labels);
+  metrics.torn = &registry.counter(
+    "robocap_bridge_samples_torn_total",
+    "Simulator samples overwritten while the bridge read them", labels);
+  metrics.age = &robocap_runtime::message_age_histogram(get_name(), publisher.get_topic_name());
+  return metrics;
+}
+
+void ShmBridge::count_skipped(
+  ChannelMetrics & metrics, std::uint64_t previous, std::uint64_t count)
+{
+  // Write counts run one per sample; a gap is samples this thread woke up too late for. The
+  // first sample, and one after the simulator restarted, has nothing to compare with
+  if (previous > 0 && count > previous + 1) {
+    metrics.skipped->add(count - previous - 1);
+  }
+}
+
+void ShmBridge::record_age(ChannelMetrics & metrics, const rclcpp::Time & stamp)
+{
+  metrics.age->record(std::chrono::nanoseconds((now() - stamp).nanoseconds()));
+}
+
+void ShmBridge::run()
+{
+  while (running_ && rclcpp::ok(get_node_options().context())) {
+    if (!reader_.is_open()) {
+      // gz sim may come up after us, or not have created the segment yet
+      if (!reader_.open(segment_name_)) {
+        std::this_thread::sleep_for(kRetryPeriod);
+        continue;
+      }
+      const auto & segment = reader_.segment();
+      joint_names_.assign(segment.joint_names, segment.joint_names + segment.joint_count);
+      RCLCPP_INFO(
+        get_logger(), "Attached to '%s' with %u joints", segment_name_.c_str(),
+        segment.joint_count);
+    }
+    const auto generation = reader_.generation();
+    publish_joints();
+    publish_base();
+    publish_scan();
+    reader_.wait(generation, kWaitTimeout);
+  }
+}
+
+template<typename MessageT, typename FillT>
+bool ShmBridge::publish(
+  typename rclcpp::Publisher<MessageT>::SharedPtr & publisher, MessageT & message,
+  ChannelMetrics & metrics, FillT && fill)
+{
+  if (get_node_options().use_intra_process_comms() || !publisher->can_loan_messages()) {
+    // A torn sample is left in `message` unpublished, the next one overwrites it
+    if (!fill(message)) {
+      metrics.torn->add();
+      return false;
+    }
+    record_age(metrics, message.header.stamp);
+    publisher->publish(message);
+    return true;
+  }
+  // An unpublished loan goes back to the middleware when it goes out of scope
+  auto loaned = publisher->borrow_loaned_message();
+  if (!fill(loaned.get())) {
+    metrics.torn->add();
+    return false;
+  }
+  record_age(metrics, loaned.get().header.stamp);
+  publisher->publish(std::move(loaned));
+  return true;
+}
+
+void ShmBridge::publish_joints()
+{
+  const auto previous = last_joints_;
+  const auto sample = reader_.latest(reader_.segment().joints, &last_joints_);
+  if (!sample) {
+    return;
+  }
+  count_skipped(joint_metrics_, previous, last_joints_);
+  ROBOCAP_TRACEPOINT(bridge_publish_start, this, sample->stamp_ns);
+  publish<sensor_msgs::msg::JointState>(
+    joint_state_publisher_, joint_state_message_, joint_metrics_,
+    [this, &sample](sensor_msgs::msg::JointState & message) {
+      const std::size_t count = std::min<std::size_t>(sample->count, joint_names_.size());
+      message.header.stamp = rclcpp::Time(sample->stamp_ns, RCL_ROS_TIME);
+      message.name.assign(joint_names_.begin(), joint_names_.begin() + count);
+      message.position.assign(sample->position, sample->position + count);
+      message.velocity.assign(sample->velocity, sample->velocity + count);
+      message.effort.assign(sample->effort, sample->effort + count);
+      return sample.valid();
+    });
+  ROBOCAP_TRACEPOINT(bridge_publish_end, this);
+}
+
+void ShmBridge::publish_base()
+{
+  const auto previous = last_base_;
+  const auto sample = reader_.latest(reader_.segment().base, &last_base_);
+  if (!sample) {
+    return;
+  }
+  count_skipped(base_metrics_, previous, last_base_);
+  publish<nav_msgs::msg::Odometry>(
+    ground_truth_publisher_, ground_truth_message_, base_metrics_,
+    [this, &sample](nav_msgs::msg::Odometry & message) {
+      message.header.stamp = rclcpp::Time(sample->stamp_ns, RCL_ROS_TIME);
+      message.header.frame_id = odom_frame_id_;
+      message.child_frame_id = base_frame_id_;
+      message.pose.pose.position.x = sample->position[0];
+      message.pose.pose.position.y = sample->position[1];
+      message.pose.pose.position.z = sample->position[2];
+      message.pose.pose.orientation.x = sample->orientation[0];
+      message.pose.pose.orientation.y = sample->orientation[1];
+      message.pose.pose.orientation.z = sample->orientation[2];
+      message.pose.pose.orientation.w = sample->orientation[3];
+      // Odometry twists are in the child frame, the simulator's are in the world frame
+      double linear[3];
+      double angular[3];
+      to_body(sample->orientation, sample->linear_velocity, linear);
+      to_body(sample->orientation, sample->angular_velocity, angular);
+      message.twist.twist.linear.x = linear[0];
+      message.twist.twist.linear.y = linear[1];
+      message.twist.twist.linear.z = linear[2];
+      message.twist.twist.angular.x = angular[0];
+      message.twist.twist.angular.y = angular[1];
+      message.twist.twist.angular.z = angular[2];
+      return sample.valid();
+    });
+}
+
+void ShmBridge::publish_scan()
+{
+  const auto previous = last_scan_;
+  const auto sample = reader_.latest(reader_.segment().scan, &last_scan_);
+  if (!sample) {
+    return;
+  }
+  count_skipped(scan_metrics_, previous, last_scan_);
+  ROBOCAP_TRACEPOINT(bridge_publish_start, this, sample->stamp_ns);
+  publish<sensor_msgs::msg::LaserScan>(
+    scan_publisher_, scan_message_, scan_metrics_,
+    [this, &sample](sensor_msgs::msg::LaserScan & message) {
+      message.header.stamp = rclcpp::Time(sample->stamp_ns, RCL_ROS_TIME);
+      message.header.frame_id = frame_id_;
+      message.angle_min = sample->angle_min;
+      message.angle_max = sample->angle_max;
+      message.angle_increment = sample->angle_increment;
+      message.time_increment = 0.0f;  // gpu_lidar renders the whole sweep at one instant
+      message.scan_time = 0.0f;
+      message.range_min = sample->range_min;
+      message.range_max = sample->range_max;
+      const std::size_t count = std::min<std::size_t>(sample->count, kMaxScanRanges);
+      message.ranges.assign(sample->ranges, sample->ranges + count);
+      const std::size_t intensities = std::min<std::size_t>(sample->intensity_count, count);
+      message.intensities.assign(sample->intensities, sample->intensities + intensities);
+      return sample.valid();
+    });
+  ROBOCAP_TRACEPOINT(bridge_publish_end, this);
+}
+
+}  // namespace robocap_bridge
+
+#include "rclcpp_components/register_node_macro.hpp"
+
+RCLCPP_COMPONENTS_REGISTER_NODE(robocap_bridge::ShmBridge)
@@ -0,0 +1,173 @@
+#include "robocap_bridge/shm_publisher.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+#include "ignition/common/Console.hh"
+#include "ignition/gazebo/Link.hh"
+#include "ignition/gazebo/Model.hh"
+#include "ignition/gazebo/Util.hh"
+#include "ignition/gazebo/components/JointForceCmd.hh"
+#include "ignition/gazebo/components/JointPosition.hh"
+#include "ignition/gazebo/components/JointVelocity.hh"
+#include "ignition/msgs/Utility.hh"
+#include "ignition/plugin/Register.hh"
+
+namespace robocap_bridge
+{
+
+namespace components = ignition::gazebo::components;
+
+namespace
+{
+
+const std::vector<std::string> kDefaultJoints = {"wheel_1_joint", "wheel_2_joint", "wheel_3_joint"};
+
+template<typename ComponentT>
+double first_or_zero(
+  const ignition::gazebo::EntityComponentManager & ecm, ignition::gazebo::Entity entity)
+{
+  const auto * component = ecm.Component<ComponentT>(entity);
+  return component && !component->Data().empty() ? component->Data()[0] : 0.0;
+}
+
+}  // namespace
+
+void ShmPublisher::Configure(
+  const ignition::gazebo::Entity & entity, const std::shared_ptr<const sdf::Element> & sdf,
+  ignition::gazebo::EntityComponentManager & ecm,
+  ignition::gazebo::EventManager & /*event_manager*/)
+{
+  const ignition::gazebo::Model model(entity);
+  if (!model.Valid(ecm)) {
+    ignerr << "ShmPublisher must be attached to a model" << std::endl;
+    return;
+  }
+
+  std::string name = sdf->HasElement("segment") ? sdf->Get<std::string>("segment") : std::string{};
+  if (name.empty()) {
+    const char * env = std::getenv("ROBOCAP_SHM_SEGMENT");
+    name = env != nullptr ? env : "";
+  }
+  if (name.empty()) {
+    ignmsg << "ShmPublisher: no <segment> or ROBOCAP_SHM_SEGMENT, not publishing" << std::endl;
+    return;
+  }
+
+  std::vector<std::string> joint_names;
+  auto element = sdf->FindElement("joint");
+  while (element) {
+    joint_names.push_back(element->Get<std::string>());
+    element = element->GetNextElement("joint");
+  }
+  if (joint_names.empty()) {
+    joint_names = kDefaultJoints;
+  }
+  if (joint_names.size() > kMaxJoints) {
+    ignerr << "ShmPublisher: at most " << kMaxJoints << " joints fit the segment" << std::endl;
+    return;
+  }
+  std::vector<const char *> names;
+  for (const auto & joint_name : joint_names) {
+    const auto joint = model.JointByName(ecm, joint_name);
+    if (joint == ignition::gazebo::kNullEntity) {
+      ignerr << "ShmPublisher: joint [" << joint_name << "] not found" << std::endl;
+      return;
+    }
+    if (!ecm.Component<components::JointPosition>(joint)) {
+      ecm.CreateComponent(joint, components::JointPosition());
+    }
+    if (!ecm.Component<components::JointVelocity>(joint)) {
+      ecm.CreateComponent(joint, components::JointVelocity());
+    }
+    joints_.push_back(joint);
+    names.push_back(joint_name.c_str());
+  }
+
+  base_link_ = model.CanonicalLink(ecm);
+  ignition::gazebo::Link(base_link_).EnableVelocityChecks(ecm, true);
+
+  if (!writer_.open(name, names.data(), names.size())) {
+    ignerr << "ShmPublisher: failed to map [" << name << "]" << std::endl;
+    return;
+  }
+  const auto scan_topic = sdf->HasElement("scan_topic") ?
+    sdf->Get<std::string>("scan_topic") : std::string("/robocap/laser/scan");
+  if (!scan_topic.empty() && !gz_node_.Subscribe(scan_topic, &ShmPublisher::on_scan, this)) {
+    ignerr << "ShmPublisher: failed to subscribe to [" << scan_topic << "]" << std::endl;
+  }
+  ignmsg << "ShmPublisher: writing " << joints_.size() << " joints, the base pose and [" <<
+    scan_topic << "] to [" << name << "]" << std::endl;
+}
+
+void ShmPublisher::PostUpdate(
+  const ignition::gazebo::UpdateInfo & info,
+  const ignition::gazebo::EntityComponentManager & ecm)
+{
+  if (!writer_.is_open() || info.paused) {
+    return;
+  }
+  const std::int64_t stamp_ns =
+    std::chrono::duration_cast<std::chrono::nanoseconds>(info.simTime).count();
+
+  auto & segment = writer_.segment();
+  auto & joints = writer_.begin(segment.joints);
+  joints.stamp_ns = stamp_ns;
+  joints.count = static_cast<std::uint32_t>(joints_.size());
+  for (std::size_t i = 0; i < joints_.size(); ++i) {
+    joints.position[i] = first_or_zero<components::JointPosition>(ecm, joints_[i]);
+    joints.velocity[i] = first_or_zero<components::JointVelocity>(ecm, joints_[i]);
+    joints.effort[i] = first_or_zero<components::JointForceCmd>(ecm, joints_[i]);
+  }
+  writer_.commit(segment.joints);
+
+  const ignition::gazebo::Link link(base_link_);
+  const auto pose = ignition::gazebo::worldPose(base_link_, ecm);
+  const auto linear = link.WorldLinearVelocity(ecm).value_or(ignition::math::Vector3d::Zero);
+  const auto angular = link.WorldAngularVelocity(ecm).value_or(ignition::math::Vector3d::Zero);
+  auto & base = writer_.begin(segment.base);
+  base.stamp_ns = stamp_ns;
+  base.position[0] = pose.Pos().X();
+  base.position[1] = pose.Pos().Y();
+  base.position[2] = pose.Pos().Z();
+  base.orientation[0] = pose.Rot().X();
+  base.orientation[1] = pose.Rot().Y();
+  base.orientation[2] = pose.Rot().Z();
+  base.orientation[3] = pose.Rot().W();
+  for (int axis = 0; axis < 3; ++axis) {
+    base.linear_velocity[axis] = linear[axis];
+    base.angular_velocity[axis] = angular[axis];
+  }
+  writer_.commit(segment.base);
+}
+
+void ShmPublisher::on_scan(const ignition::msgs::LaserScan & scan)
+{
+  // Runs on the sensors' rendering thread, the only writer of the scan channel
+  auto & segment = writer_.segment();
+  auto & sample = writer_.begin(segment.scan);
+  sample.stamp_ns = ignition::msgs::Convert(scan.header().stamp()).count();
+  sample.angle_min = static_cast<float>(scan.angle_min());
+  sample.angle_max = static_cast<float>(scan.angle_max());
+  sample.angle_increment = static_cast<float>(scan.angle_step());
+  sample.range_min = static_cast<float>(scan.range_min());
+  sample.range_max = static_cast<float>(scan.range_max());
+  // Only the first row of a multi-row lidar, like LaserScanBridge
+  const auto count = std::min(
+    {static_cast<std::size_t>(scan.count()), static_cast<std::size_t>(scan.ranges_size()),
+      kMaxScanRanges});
+  sample.count = static_cast<std::uint32_t>(count);
+  std::copy_n(scan.ranges().begin(), count, sample.ranges);
+  const auto intensities = std::min(count, static_cast<std::size_t>(scan.intensities_size()));
+  sample.intensity_count = static_cast<std::uint32_t>(intensities);
+  std::copy_n(scan.intensities().begin(), intensities, sample.intensities);
+  writer_.commit(segment.scan);
+}
+
+}  // namespace robocap_bridge
+
+IGNITION_ADD_PLUGIN(
+  robocap_bridge::ShmPublisher, ignition::gazebo::System,
+  robocap_bridge::ShmPublisher::ISystemConfigure,
+  robocap_bridge::ShmPublisher::ISystemPostUpdate)
@@ -0,0 +1,148 @@
+#include "robocap_bridge/shm_segment.hpp"
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <climits>
+#include <cstring>
+#include <new>
+
+namespace robocap_bridge
+{
+
+namespace
+{
+
+// Shared between processes, so not FUTEX_PRIVATE_FLAG
+long futex(
+  std::atomic<std::uint32_t> & word, int op, std::uint32_t value, const timespec * timeout)
+{
+  return syscall(
+    SYS_futex, reinterpret_cast<std::uint32_t *>(&word), op, value, timeout, nullptr, 0);
+}
+
+}  // namespace
+
+ShmWriter::~ShmWriter()
+{
+  close();
+}
+
+bool ShmWriter::open(
+  const std::string & name, const char * const * joint_names, std::size_t joint_count)
+{
+  close();
+  if (joint_count > kMaxJoints) {
+    return false;
+  }
+  // Reused rather than unlinked, so a reader that outlives a sim restart keeps its mapping
+  const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  if (ftruncate(fd, sizeof(ShmSegment)) != 0) {
+    ::close(fd);
+    return false;
+  }
+  // MAP_POPULATE faults every page in now, so commits never take a page fault on the hot path
+  void * mapping = mmap(
+    nullptr, sizeof(ShmSegment), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+
+  // Readers that are already attached see the magic vanish while this runs
+  auto * segment = static_cast<ShmSegment *>(mapping);
+  segment->magic = 0;
+  std::atomic_thread_fence(std::memory_order_release);
+  const auto previous_generation = segment->generation.load(std::memory_order_relaxed);
+  segment_ = new (mapping) ShmSegment();
+  std::memset(segment_->joint_names, 0, sizeof(segment_->joint_names));
+  for (std::size_t i = 0; i < joint_count; ++i) {
+    std::strncpy(segment_->joint_names[i], joint_names[i], kJointNameSize - 1);
+  }
+  segment_->joint_count = static_cast<std::uint32_t>(joint_count);
+  segment_->version = kShmVersion;
+  // Sleeping readers compare against the old value, keep counting from there
+  segment_->generation.store(previous_generation, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  segment_->magic = kShmMagic;
+  return true;
+}
+
+void ShmWriter::close()
+{
+  if (segment_) {
+    munmap(segment_, sizeof(ShmSegment));
+    segment_ = nullptr;
+  }
+}
+
+void ShmWriter::notify()
+{
+  // Sequentially consistent with the waiter count in wait(), so either this sees the waiter or
+  // the waiter's FUTEX_WAIT sees the new generation. Only pays for the syscall while someone waits.
+  segment_->generation.fetch_add(1);
+  if (segment_->waiters.load() > 0) {
+    futex(segment_->generation, FUTEX_WAKE, INT_MAX, nullptr);
+  }
+}
+
+ShmReader::~ShmReader()
+{
+  close();
+}
+
+bool ShmReader::open(const std::string & name)
+{
+  close();
+  const int fd = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(ShmSegment)) {
+    ::close(fd);
+    return false;
+  }
+  // Writable only for the waiter count, samples are never written from this side
+  void * mapping = mmap(nullptr, sizeof(ShmSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+  auto * segment = static_cast<ShmSegment *>(mapping);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (segment->magic != kShmMagic || segment->version != kShmVersion) {
+    munmap(mapping, sizeof(ShmSegment));
+    return false;
+  }
+  segment_ = segment;
+  return true;
+}
+
+void ShmReader::close()
+{
+  if (segment_) {
+    munmap(segment_, sizeof(ShmSegment));
+    segment_ = nullptr;
+  }
+}
+
+void ShmReader::wait(std::uint32_t generation, std::chrono::nanoseconds timeout) const
+{
+  const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+  const timespec relative{
+    static_cast<time_t>(seconds.count()), static_cast<long>((timeout - seconds).count())};
+  segment_->waiters.fetch_add(1);
+  // Returns at once if a commit already moved the generation on
+  futex(segment_->generation, FUTEX_WAIT, generation, &relative);
+  segment_->waiters.fetch_sub(1);
+}
+
+}  // namespace robocap_bridge
@@ -0,0 +1,144 @@
+#ifndef ROBOCAP_CONTROL__ADMM_QP_HPP_
+#define ROBOCAP_CONTROL__ADMM_QP_HPP_
+
+#include <algorithm>
+
+#include "Eigen/Cholesky"
+#include "Eigen/Core"
+
+namespace robocap_control
+{
+
+struct AdmmQpSettings
+{
+  double rho = 0.1;                  // Constraint penalty, fixed so the KKT inverse is reused
+  double sigma = 1e-6;               // Regularization of the x update
+  double alpha = 1.6;                // Over-relaxation in (0, 2)
+  double absolute_tolerance = 1e-4;  // On the primal and dual residual, infinity norm
+  double relative_tolerance = 1e-3;  // Of the largest term in each residual
+  int max_iterations = 100;
+  int check_every = 5;               // Residuals are only computed every this many iterations
+};
+
+// Dense QP with a fixed shape, solved by the ADMM iteration OSQP uses:
+//
+//   minimize 1/2 x'Px + q'x  subject to  l <= Ax <= u
+//
+// P and A are set once by setup(), which also inverts P + sigma I + rho A'A: with both fixed and
+// a problem this small, a dense inverse makes each iteration three matrix-vector products and no
+// triangular solves. solve() only takes a new q, l and u, starts from the previous x, z and y (the
+// caller may shift them first) and stops on OSQP's residual test. Every matrix is fixed-size and a
+// member, so neither call allocates.
+template<int Variables, int Constraints>
+class AdmmQp
+{
+public:
+  using Vector = Eigen::Matrix<double, Variables, 1>;
+  using ConstraintVector = Eigen::Matrix<double, Constraints, 1>;
+  using Hessian = Eigen::Matrix<double, Variables, Variables>;
+  using ConstraintMatrix = Eigen::Matrix<double, Constraints, Variables>;
+
+  struct Result
+  {
+    int iterations = 0;
+    bool converged = false;
+    double primal_residual = 0.0;
+    double dual_residual = 0.0;
+  };
+
+  // False if P + sigma I + rho A'A is not positive definite, i.e. P is not positive semidefinite
+  bool setup(const Hessian & p, const ConstraintMatrix & a, const AdmmQpSettings & settings)
+  {
+    settings_ = settings;
+    p_ = p;
+    a_ = a;
+    Hessian kkt = p_;
+    kkt.diagonal().array() += settings_.sigma;
+    kkt.noalias() += settings_.rho * a_.transpose() * a_;
+    const Eigen::LLT<Hessian> factorization(kkt);
+    if (factorization.info() != Eigen::Success) {
+      return false;
+    }
+    kkt_inverse_ = factorization.solve(Hessian::Identity());
+    reset();
+    return true;
+  }
+
+  // Cold start
+  void reset()
+  {
+    x_.setZero();
+    z_.setZero();
+    y_.setZero();
+  }
+
+  Result solve(const Vector & q, const ConstraintVector & lower, const ConstraintVector & upper)
+  {
+    const double rho = settings_.rho;
+    const double alpha = settings_.alpha;
+    Result result;
+    // Warm starts may come from a different problem, pull z back inside the bounds
+    z_ = z_.cwiseMax(lower).cwiseMin(upper);
+    for (int iteration = 1; iteration <= settings_.max_iterations; ++iteration) {
+      rhs_ = settings_.sigma * x_ - q;
+      rhs_.noalias() += a_.transpose() * (rho * z_ - y_);
+      x_tilde_.noalias() = kkt_inverse_ * rhs_;
+      z_tilde_.noalias() = a_ * x_tilde_;
+
+      x_ = alpha * x_tilde_ + (1.0 - alpha) * x_;
+      z_relaxed_ = alpha * z_tilde_ + (1.0 - alpha) * z_;
+      z_next_ = (z_relaxed_ + y_ / rho).cwiseMax(lower).cwiseMin(upper);
+      y_ += rho * (z_relaxed_ - z_next_);
+      z_ = z_next_;
+
+      result.iterations = iteration;
+      if (iteration % settings_.check_every == 0 || iteration == settings_.max_iterations) {
+        z_tilde_.noalias() = a_ * x_;
+        result.primal_residual = (z_tilde_ - z_).template lpNorm<Eigen::Infinity>();
+        const double primal_scale = std::max(
+          z_tilde_.template lpNorm<Eigen::Infinity>(), z_.template lpNorm<Eigen::Infinity>());
+        x_tilde_.noalias() = p_ * x_;
+        rhs_.noalias() = a_.transpose() * y_;
+        const double dual_scale = std::max(
+          {x_tilde_.template lpNorm<Eigen::Infinity>(), rhs_.template lpNorm<Eigen::Infinity>(),
+            q.template lpNorm<Eigen::Infinity>()});
+        result.dual_residual = (x_tilde_ + rhs_ + q).template lpNorm<Eigen::Infinity>();
+        if (result.primal_residual <
+          settings_.absolute_tolerance + settings_.relative_tolerance * primal_scale &&
+          result.dual_residual <
+          settings_.absolute_tolerance + settings_.relative_tolerance * dual_scale)
+        {
+          result.converged = true;
+          break;
+        }
+      }
+    }
+    return result;
+  }
+
+  // Primal solution, and the iterates a warm start may shift in place
+  Vector & x() {return x_;}
+  ConstraintVector & z() {return z_;}
+  ConstraintVector & y() {return y_;}
+  const Vector & x() const {return x_;}
+
+private:
+  AdmmQpSettings settings_;
+  Hessian p_;
+  ConstraintMatrix a_;
+  Hessian kkt_inverse_;
+
+  Vector x_;
+  ConstraintVector z_;
+  ConstraintVector y_;
+  // Scratch, members so solve() keeps nothing this size on the stack
+  Vector rhs_;
+  Vector x_tilde_;
+  ConstraintVector z_tilde_;
+  ConstraintVector z_relaxed_;
+  ConstraintVector z_next_;
+};
+
+}  // namespace robocap_control
+
+#endif  // ROBOCAP_CONTROL__ADMM_QP_HPP_
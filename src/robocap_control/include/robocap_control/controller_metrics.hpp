@@ -0,0 +1,76 @@
+#ifndef ROBOCAP_CONTROL__CONTROLLER_METRICS_HPP_
+#define ROBOCAP_CONTROL__CONTROLLER_METRICS_HPP_
+
+#include <cstdint>
+#include <string>
+
+#include "robocap_runtime/metrics.hpp"
+
+namespace robocap_control
+{
+
+// A drive controller's series in robocap_runtime's MetricsRegistry, labelled with its name:
+//   robocap_controller_loop_period_seconds   between update() calls, on the steady clock
+//   robocap_controller_overruns_total        periods over 1.5 times the update rate's
+//   robocap_wheel_command_latency_seconds    cmd_vel received to its wheel velocities written
+// The clock is the wall clock, so with the controller manager in gz sim a simulation that falls
+// behind real time shows up as overruns as much as a slow controller does. Both calls in
+// update() are a clock read and a few relaxed increments.
+class ControllerMetrics
+{
+public:
+  // From on_activate(); `update_rate` [Hz] 0 disables the overrun count
+  void activate(const std::string & controller, unsigned int update_rate)
+  {
+    auto & registry = robocap_runtime::MetricsRegistry::global();
+    const robocap_runtime::Labels labels{{"controller", controller}};
+    loop_period_ = &registry.histogram(
+      "robocap_controller_loop_period_seconds", "Time between controller updates", labels);
+    overruns_ = &registry.counter(
+      "robocap_controller_overruns_total", "Controller updates late by half a period", labels);
+    command_latency_ = &registry.histogram(
+      "robocap_wheel_command_latency_seconds",
+      "Time from cmd_vel received to its wheel velocities written", labels);
+    overrun_ns_ = update_rate > 0 ? static_cast<std::int64_t>(1.5e9 / update_rate) : 0;
+    last_update_ns_ = -1;
+    applied_sequence_ = 0;
+  }
+
+  // First thing in update()
+  void update_started()
+  {
+    const std::int64_t now = robocap_runtime::steady_clock_ns();
+    if (last_update_ns_ >= 0) {
+      const std::int64_t period = now - last_update_ns_;
+      loop_period_->record(static_cast<std::uint64_t>(period));
+      if (overrun_ns_ > 0 && period > overrun_ns_) {
+        overruns_->add();
+      }
+    }
+    last_update_ns_ = now;
+  }
+
+  // After writing the wheels for command `sequence` (0 for none), received at `received_ns` on
+  // robocap_runtime::steady_clock_ns(). Only its first update counts
+  void command_written(std::uint64_t sequence, std::int64_t received_ns)
+  {
+    if (sequence == 0 || sequence == applied_sequence_) {
+      return;
+    }
+    applied_sequence_ = sequence;
+    const std::int64_t latency = robocap_runtime::steady_clock_ns() - received_ns;
+    command_latency_->record(static_cast<std::uint64_t>(latency > 0 ? latency : 0));
+  }
+
+private:
+  robocap_runtime::Histogram * loop_period_ = nullptr;
+  robocap_runtime::Counter * overruns_ = nullptr;
+  robocap_runtime::Histogram * command_latency_ = nullptr;
+  std::int64_t overrun_ns_ = 0;
+  std::int64_t last_update_ns_ = -1;
+  std::uint64_t applied_sequence_ = 0;
+};
+
+}  // namespace robocap_control
+
+#endif  // ROBOCAP_CONTROL__CONTROLLER_METRICS_HPP_
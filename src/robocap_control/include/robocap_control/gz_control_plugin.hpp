@@ -0,0 +1,75 @@
+#ifndef ROBOCAP_CONTROL__GZ_CONTROL_PLUGIN_HPP_
+#define ROBOCAP_CONTROL__GZ_CONTROL_PLUGIN_HPP_
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "controller_manager/controller_manager.hpp"
+#include "ignition/gazebo/System.hh"
+#include "rclcpp/executor.hpp"
+#include "rclcpp/time.hpp"
+#include "rclcpp/duration.hpp"
+#include "robocap_runtime/metrics_exporter.hpp"
+
+namespace robocap_control
+{
+
+// Ignition Gazebo system that runs a controller_manager inside the simulation process. The
+// KiwiDriveSystem hardware talks to the ECM directly, and read/update/write are called from the
+// physics loop, so a 1 kHz controller sees every physics step without any transport in between.
+//
+// SDF parameters:
+//   <parameters>          controller_manager YAML file (required)
+//   <robot_description_file>  URDF to read instead of asking <robot_param_node>
+//   <robot_param_node>    node holding robot_description, defaults to robot_state_publisher
+//   <controller_manager_name>  defaults to controller_manager
+//   <namespace>           ROS namespace of the controller manager, defaults to none
+//   <metrics_port>        serves the controllers' metrics from gz sim through a
+//                         robocap_runtime::MetricsExporter on this port, defaults to
+//                         ROBOCAP_METRICS_PORT or, without it, 0 (off)
+//
+// With ROBOCAP_DETERMINISTIC_CONTROLLERS set (space separated controller names), as
+// robocap_deterministic_sim does, the plugin runs in lockstep instead: it loads and activates those
+// controllers itself before the first step, and serves the controller manager's callbacks from
+// PreUpdate on the physics thread rather than from a thread of its own.
+class GzControlPlugin
+  : public ignition::gazebo::System,
+  public ignition::gazebo::ISystemConfigure,
+  public ignition::gazebo::ISystemPreUpdate,
+  public ignition::gazebo::ISystemPostUpdate
+{
+public:
+  GzControlPlugin() = default;
+  ~GzControlPlugin() override;
+
+  void Configure(
+    const ignition::gazebo::Entity & entity, const std::shared_ptr<const sdf::Element> & sdf,
+    ignition::gazebo::EntityComponentManager & ecm,
+    ignition::gazebo::EventManager & event_manager) override;
+
+  void PreUpdate(
+    const ignition::gazebo::UpdateInfo & info,
+    ignition::gazebo::EntityComponentManager & ecm) override;
+
+  void PostUpdate(
+    const ignition::gazebo::UpdateInfo & info,
+    const ignition::gazebo::EntityComponentManager & ecm) override;
+
+private:
+  bool activate_controllers(const std::vector<std::string> & names);
+  void start_metrics_exporter(int port);
+
+  bool lockstep_ = false;
+  std::shared_ptr<rclcpp::Executor> executor_;
+  std::thread executor_thread_;
+  std::shared_ptr<controller_manager::ControllerManager> controller_manager_;
+  std::shared_ptr<robocap_runtime::MetricsExporter> metrics_exporter_;
+  rclcpp::Duration control_period_{0, 0};
+  rclcpp::Time last_update_time_{0, 0, RCL_ROS_TIME};
+};
+
+}  // namespace robocap_control
+
+#endif  // ROBOCAP_CONTROL__GZ_CONTROL_PLUGIN_HPP_
@@ -0,0 +1,39 @@
+#ifndef ROBOCAP_CONTROL__GZ_WHEEL_BACKEND_HPP_
+#define ROBOCAP_CONTROL__GZ_WHEEL_BACKEND_HPP_
+
+#include <array>
+#include <cstddef>
+#include <string>
+
+#include "ignition/gazebo/Entity.hh"
+#include "ignition/gazebo/EntityComponentManager.hh"
+
+#include "robocap_control/wheel_backend.hpp"
+
+namespace robocap_control
+{
+
+// Reads and writes the wheel joints directly in the Ignition ECM. Only valid while called from the
+// simulation thread, which GzControlPlugin guarantees by driving the controller manager from its
+// PreUpdate/PostUpdate callbacks.
+class GzWheelBackend : public WheelBackend
+{
+public:
+  GzWheelBackend(ignition::gazebo::EntityComponentManager & ecm, ignition::gazebo::Entity model);
+
+  bool configure(const std::array<std::string, kNumWheels> & joint_names) override;
+  void read(WheelStates & states) override;
+  void write(const WheelCommands & commands) override;
+
+private:
+  void switch_mode(std::size_t index, CommandMode mode);
+
+  ignition::gazebo::EntityComponentManager & ecm_;
+  ignition::gazebo::Entity model_;
+  std::array<ignition::gazebo::Entity, kNumWheels> joints_{};
+  std::array<CommandMode, kNumWheels> active_modes_{};
+};
+
+}  // namespace robocap_control
+
+#endif  // ROBOCAP_CONTROL__GZ_WHEEL_BACKEND_HPP_
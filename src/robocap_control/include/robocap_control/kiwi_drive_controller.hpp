@@ -0,0 +1,106 @@
+#ifndef ROBOCAP_CONTROL__KIWI_DRIVE_CONTROLLER_HPP_
+#define ROBOCAP_CONTROL__KIWI_DRIVE_CONTROLLER_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "controller_interface/controller_interface.hpp"
+#include "geometry_msgs/msg/twist.hpp"
+#include "hardware_interface/loaned_command_interface.hpp"
+#include "hardware_interface/loaned_state_interface.hpp"
+#include "nav_msgs/msg/odometry.hpp"
+#include "rclcpp/subscription.hpp"
+#include "rclcpp_lifecycle/state.hpp"
+#include "realtime_tools/realtime_publisher.hpp"
+#include "tf2_msgs/msg/tf_message.hpp"
+
+#include "robocap_control/controller_metrics.hpp"
+#include "robocap_control/triple_buffer.hpp"
+#include "robocap_control/wheel_backend.hpp"
+
+namespace robocap_control
+{
+
+// Holonomic cmd_vel -> wheel velocity controller with wheel odometry for the kiwi drive.
+//
+// The subscriber thread hands commands to update() through a wait-free TripleBuffer, and update()
+// only touches memory preallocated in on_configure: odometry and TF go out through
+// realtime_tools::RealtimePublisher, whose real-time side never blocks (it drops the message if
+// the publishing thread still holds the previous one). Loop period, overruns and command latency
+// are recorded through ControllerMetrics.
+class KiwiDriveController : public controller_interface::ControllerInterface
+{
+public:
+  KiwiDriveController() = default;
+
+  controller_interface::InterfaceConfiguration command_interface_configuration() const override;
+  controller_interface::InterfaceConfiguration state_interface_configuration() const override;
+
+  controller_interface::CallbackReturn on_init() override;
+  controller_interface::CallbackReturn on_configure(const rclcpp_lifecycle::State & previous_state)
+  override;
+  controller_interface::CallbackReturn on_activate(const rclcpp_lifecycle::State & previous_state)
+  override;
+  controller_interface::CallbackReturn on_deactivate(
+    const rclcpp_lifecycle::State & previous_state) override;
+
+  controller_interface::return_type update(
+    const rclcpp::Time & time, const rclcpp::Duration & period) override;
+
+private:
+  struct Command
+  {
+    double vx;
+    double vy;
+    double wz;
+    std::int64_t stamp_ns;  // Receive time, for the timeout
+    std::int64_t received_ns;  // Receive time on the steady clock, for the command latency
+    std::uint64_t sequence;  // Numbers received commands for tracing, 0 before the first
+  };
+
+  struct Pose
+  {
+    double x;
+    double y;
+    double yaw;
+  };
+
+  void publish_odometry(const rclcpp::Time & time, double vx, double vy, double wz);
+
+  // Parameters
+  std::array<std::string, kNumWheels> wheel_names_;
+  std::string odom_frame_id_;
+  std::string base_frame_id_;
+  double cmd_vel_timeout_ = 0.5;      // [s]
+  double max_wheel_velocity_ = 0.0;   // [rad/s], 0 disables saturation
+  double publish_rate_ = 50.0;        // [Hz]
+  bool enable_odom_tf_ = true;
+
+  // Indices into command_interfaces_/state_interfaces_, resolved on activation
+  std::array<std::size_t, kNumWheels> command_index_{};
+  std::array<std::size_t, kNumWheels> state_index_{};
+
+  TripleBuffer<Command> command_buffer_;
+  std::uint64_t cmd_vel_count_ = 0;  // Only touched by the subscription
+  Command command_{};
+  std::int64_t activated_ns_ = 0;  // Steady clock, commands received before it are stale
+  ControllerMetrics metrics_;
+  Pose pose_{};
+  rclcpp::Duration publish_period_{0, 0};
+  rclcpp::Time last_publish_time_{0, 0, RCL_ROS_TIME};
+
+  rclcpp::Subscription<geometry_msgs::msg::Twist>::SharedPtr cmd_vel_subscriber_;
+  std::shared_ptr<rclcpp::Publisher<nav_msgs::msg::Odometry>> odom_publisher_;
+  std::unique_ptr<realtime_tools::RealtimePublisher<nav_msgs::msg::Odometry>>
+  realtime_odom_publisher_;
+  std::shared_ptr<rclcpp::Publisher<tf2_msgs::msg::TFMessage>> tf_publisher_;
+  std::unique_ptr<realtime_tools::RealtimePublisher<tf2_msgs::msg::TFMessage>>
+  realtime_tf_publisher_;
+};
+
+}  // namespace robocap_control
+
+#endif  // ROBOCAP_CONTROL__KIWI_DRIVE_CONTROLLER_HPP_
@@ -0,0 +1,69 @@
+#ifndef ROBOCAP_CONTROL__KIWI_DRIVE_SYSTEM_HPP_
+#define ROBOCAP_CONTROL__KIWI_DRIVE_SYSTEM_HPP_
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "hardware_interface/handle.hpp"
+#include "hardware_interface/hardware_info.hpp"
+#include "hardware_interface/system_interface.hpp"
+#include "hardware_interface/types/hardware_interface_return_values.hpp"
+#include "rclcpp/duration.hpp"
+#include "rclcpp/time.hpp"
+#include "rclcpp_lifecycle/state.hpp"
+
+#include "robocap_control/wheel_backend.hpp"
+
+namespace robocap_control
+{
+
+// ros2_control system for the three kiwi-drive wheels. Every joint exports position, velocity and
+// effort state interfaces and velocity and effort command interfaces; the actual I/O is delegated
+// to a WheelBackend: the Ignition ECM in simulation, attached by GzControlPlugin, and otherwise a
+// MotorBusBackend configured from the hardware parameters.
+class KiwiDriveSystem : public hardware_interface::SystemInterface
+{
+public:
+  KiwiDriveSystem() = default;
+  explicit KiwiDriveSystem(std::unique_ptr<WheelBackend> backend);
+
+  hardware_interface::CallbackReturn on_init(const hardware_interface::HardwareInfo & info)
+  override;
+  hardware_interface::CallbackReturn on_activate(const rclcpp_lifecycle::State & previous_state)
+  override;
+  hardware_interface::CallbackReturn on_deactivate(const rclcpp_lifecycle::State & previous_state)
+  override;
+
+  std::vector<hardware_interface::StateInterface> export_state_interfaces() override;
+  std::vector<hardware_interface::CommandInterface> export_command_interfaces() override;
+
+  hardware_interface::return_type prepare_command_mode_switch(
+    const std::vector<std::string> & start_interfaces,
+    const std::vector<std::string> & stop_interfaces) override;
+  hardware_interface::return_type perform_command_mode_switch(
+    const std::vector<std::string> & start_interfaces,
+    const std::vector<std::string> & stop_interfaces) override;
+
+  hardware_interface::return_type read(const rclcpp::Time & time, const rclcpp::Duration & period)
+  override;
+  hardware_interface::return_type write(const rclcpp::Time & time, const rclcpp::Duration & period)
+  override;
+
+private:
+  // Applies a list of "<joint>/<interface>" names to the per-joint modes in `modes`
+  bool apply_mode_switch(
+    const std::vector<std::string> & start_interfaces,
+    const std::vector<std::string> & stop_interfaces,
+    std::array<CommandMode, kNumWheels> & modes) const;
+
+  std::unique_ptr<WheelBackend> backend_;
+  std::array<std::string, kNumWheels> joint_names_;
+  WheelStates states_;
+  WheelCommands commands_;
+};
+
+}  // namespace robocap_control
+
+#endif  // ROBOCAP_CONTROL__KIWI_DRIVE_SYSTEM_HPP_
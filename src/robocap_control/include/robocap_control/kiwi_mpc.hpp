@@ -0,0 +1,245 @@
+#ifndef ROBOCAP_CONTROL__KIWI_MPC_HPP_
+#define ROBOCAP_CONTROL__KIWI_MPC_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include "Eigen/Core"
+
+#include "robocap_control/admm_qp.hpp"
+#include "robocap_kinematics/robocap_layout.hpp"
+
+namespace robocap_control
+{
+
+namespace mpc_model
+{
+
+namespace model = robocap_kinematics::robocap_model;
+
+constexpr double kGravity = 9.81;
+
+// Centre of mass above the ground. base_link sits on the wheel axles, one wheel radius up
+constexpr double kCenterOfMassHeight =
+  (model::links::chassis.mass *
+  (model::joints::chassis_joint.origin.xyz.z + model::links::chassis.inertial_origin.xyz.z) +
+  model::links::wheel_1.mass * model::joints::wheel_1_joint.origin.xyz.z +
+  model::links::wheel_2.mass * model::joints::wheel_2_joint.origin.xyz.z +
+  model::links::wheel_3.mass * model::joints::wheel_3_joint.origin.xyz.z) / model::kTotalMass +
+  robocap_kinematics::kRobocapLayout.wheel_radius;
+
+// Distance from base_link to the edge of the wheel contact triangle through wheels a and b
+constexpr double edge_distance(std::size_t a, std::size_t b)
+{
+  const auto & wa = robocap_kinematics::kRobocapLayout.wheels[a];
+  const auto & wb = robocap_kinematics::kRobocapLayout.wheels[b];
+  const double cross = wa.x * wb.y - wb.x * wa.y;
+  const double length = robocap_kinematics::detail::sqrt(
+    (wa.x - wb.x) * (wa.x - wb.x) + (wa.y - wb.y) * (wa.y - wb.y));
+  return (cross < 0.0 ? -cross : cross) / length;
+}
+
+constexpr double kSupportInradius =
+  std::min({edge_distance(0, 1), edge_distance(1, 2), edge_distance(2, 0)});
+
+// Horizontal acceleration at which the centre of mass leaves the support triangle in the worst
+// direction, quasi-statically: a = g d / h. About 1.2 m/s^2 for the 1.54 m chassis
+constexpr double kTippingAcceleration = kGravity * kSupportInradius / kCenterOfMassHeight;
+
+}  // namespace mpc_model
+
+struct KiwiMpcConfig
+{
+  double step = 0.05;                      // [s] between prediction points
+  double max_wheel_velocity = 0.0;         // [rad/s], 0 leaves the wheels unconstrained
+  double max_linear_acceleration = 0.0;    // [m/s^2], 0 for mpc_model::kTippingAcceleration
+  double max_angular_acceleration = 6.0;   // [rad/s^2]
+  std::array<double, 3> velocity_weight{{1.0, 1.0, 0.2}};  // vx, vy, wz tracking
+  double acceleration_weight = 0.01;
+  double jerk_weight = 0.1;                // on the change of acceleration between points
+  AdmmQpSettings solver;
+};
+
+// Velocity MPC for the kiwi drive. Over kHorizon points it plans the body accelerations u_k that
+// take the measured twist to the commanded one, with v_k+1 = v_k + step * u_k, minimizing
+//
+//   sum_k |v_k+1 - target|_Q^2 + acceleration_weight |u_k|^2 + jerk_weight |u_k - u_k-1|^2
+//
+// subject to, at every point:
+//   - the wheel joint velocities K v_k+1 within +-max_wheel_velocity
+//   - the centre of mass acceleration u_k + w x v inside an octagon of radius
+//     max_linear_acceleration, so the tall chassis never tips or rocks into an overshoot
+//   - the yaw acceleration within +-max_angular_acceleration
+//
+// Every size is a compile-time constant from the wheel count and the horizon. The Hessian and the
+// constraint matrix do not depend on the state, so configure() builds and factors them once and
+// solve() only fills the linear term and the bounds. solve() warm starts from the previous
+// solution unshifted: it runs far more often than the prediction step, so the last plan is
+// already close.
+class KiwiMpc
+{
+public:
+  static constexpr int kHorizon = 15;
+  static constexpr int kAxes = 3;        // vx, vy, wz
+  static constexpr int kDirections = 4;  // Strips whose intersection is the acceleration octagon
+  static constexpr int kWheels = static_cast<int>(robocap_kinematics::kNumWheels);
+  static constexpr int kRowsPerPoint = kWheels + kDirections + 1;
+  static constexpr int kVariables = kAxes * kHorizon;
+  static constexpr int kConstraints = kRowsPerPoint * kHorizon;
+  using Solver = AdmmQp<kVariables, kConstraints>;
+  using Twist = robocap_kinematics::Twist<double>;
+
+  // False for a non-positive step, negative limits or weights
+  bool configure(const KiwiMpcConfig & config)
+  {
+    if (!(config.step > 0.0) || config.max_wheel_velocity < 0.0 ||
+      config.max_linear_acceleration < 0.0 || !(config.max_angular_acceleration > 0.0) ||
+      config.acceleration_weight < 0.0 || config.jerk_weight < 0.0 ||
+      std::any_of(
+        config.velocity_weight.begin(), config.velocity_weight.end(),
+        [](double weight) {return weight < 0.0;}))
+    {
+      return false;
+    }
+    config_ = config;
+    linear_limit_ = config.max_linear_acceleration > 0.0 ?
+      config.max_linear_acceleration : mpc_model::kTippingAcceleration;
+    const double h = config.step;
+    const auto & inverse = robocap_kinematics::kRobocapKiwiDrive.inverse_matrix();
+    for (int wheel = 0; wheel < kWheels; ++wheel) {
+      for (int axis = 0; axis < kAxes; ++axis) {
+        inverse_(wheel, axis) = inverse[wheel][axis];
+      }
+    }
+
+    // 1/2 U'PU with P = 2 (S'QS + R + D'RdD). S sums the accelerations into velocities, so
+    // (S'QS) between points j and l is h^2 (N - max(j, l)) Q
+    Solver::Hessian p = Solver::Hessian::Zero();
+    for (int j = 0; j < kHorizon; ++j) {
+      for (int l = 0; l < kHorizon; ++l) {
+        const double count = static_cast<double>(kHorizon - std::max(j, l));
+        for (int axis = 0; axis < kAxes; ++axis) {
+          p(kAxes * j + axis, kAxes * l + axis) =
+            2.0 * h * h * count * config.velocity_weight[axis];
+        }
+      }
+    }
+    for (int k = 0; k < kHorizon; ++k) {
+      // D'D is tridiagonal: 2 on the diagonal (1 on the last point), -1 beside it
+      const double diagonal = k + 1 < kHorizon ? 2.0 : 1.0;
+      for (int axis = 0; axis < kAxes; ++axis) {
+        const int i = kAxes * k + axis;
+        p(i, i) += 2.0 * (config.acceleration_weight + config.jerk_weight * diagonal);
+        if (k + 1 < kHorizon) {
+          p(i, i + kAxes) -= 2.0 * config.jerk_weight;
+          p(i + kAxes, i) -= 2.0 * config.jerk_weight;
+        }
+      }
+    }
+
+    Solver::ConstraintMatrix a = Solver::ConstraintMatrix::Zero();
+    for (int k = 0; k < kHorizon; ++k) {
+      const int row = kRowsPerPoint * k;
+      // v_k+1 depends on every u_j with j <= k
+      for (int j = 0; j <= k; ++j) {
+        a.block<kWheels, kAxes>(row, kAxes * j) = h * inverse_;
+      }
+      for (int direction = 0; direction < kDirections; ++direction) {
+        const double angle = M_PI * direction / kDirections;
+        a(row + kWheels + direction, kAxes * k) = std::cos(angle);
+        a(row + kWheels + direction, kAxes * k + 1) = std::sin(angle);
+      }
+      a(row + kWheels + kDirections, kAxes * k + 2) = 1.0;
+    }
+
+    if (!solver_.setup(p, a, config.solver)) {
+      return false;
+    }
+    reset();
+    return true;
+  }
+
+  // Cold start and no previous acceleration
+  void reset()
+  {
+    solver_.reset();
+    acceleration_ = {0.0, 0.0, 0.0};
+  }
+
+  // Plans from the measured body twist towards `target`, both in base_link. The first planned
+  // acceleration is then acceleration()
+  Solver::Result solve(const Twist & current, const Twist & target)
+  {
+    const double h = config_.step;
+    const Eigen::Vector3d v0(current.vx, current.vy, current.wz);
+    const Eigen::Vector3d error = v0 - Eigen::Vector3d(target.vx, target.vy, target.wz);
+    const Eigen::Vector3d weights(
+      config_.velocity_weight[0], config_.velocity_weight[1], config_.velocity_weight[2]);
+    const Eigen::Vector3d previous(acceleration_.vx, acceleration_.vy, acceleration_.wz);
+    for (int j = 0; j < kHorizon; ++j) {
+      q_.segment<kAxes>(kAxes * j) =
+        2.0 * h * static_cast<double>(kHorizon - j) * weights.cwiseProduct(error);
+    }
+    q_.segment<kAxes>(0) -= 2.0 * config_.jerk_weight * previous;
+
+    const double wheel_limit = config_.max_wheel_velocity > 0.0 ?
+      config_.max_wheel_velocity : std::numeric_limits<double>::infinity();
+    const Eigen::Vector3d wheels = inverse_ * v0;
+    // Centripetal part of the centre of mass acceleration, linearized about the current twist
+    const double centripetal_x = -current.wz * current.vy;
+    const double centripetal_y = current.wz * current.vx;
+    for (int k = 0; k < kHorizon; ++k) {
+      const int row = kRowsPerPoint * k;
+      for (int wheel = 0; wheel < kWheels; ++wheel) {
+        lower_(row + wheel) = -wheel_limit - wheels(wheel);
+        upper_(row + wheel) = wheel_limit - wheels(wheel);
+      }
+      for (int direction = 0; direction < kDirections; ++direction) {
+        const double angle = M_PI * direction / kDirections;
+        const double offset = std::cos(angle) * centripetal_x + std::sin(angle) * centripetal_y;
+        lower_(row + kWheels + direction) = -linear_limit_ - offset;
+        upper_(row + kWheels + direction) = linear_limit_ - offset;
+      }
+      lower_(row + kWheels + kDirections) = -config_.max_angular_acceleration;
+      upper_(row + kWheels + kDirections) = config_.max_angular_acceleration;
+    }
+
+    const auto result = solver_.solve(q_, lower_, upper_);
+    // The octagon pokes 8 % past the limit at its corners and an unconverged iterate can sit
+    // slightly outside its bounds, so the applied acceleration is clamped to the disk itself
+    const auto & x = solver_.x();
+    double ax = x(0);
+    double ay = x(1);
+    const double norm = std::hypot(ax + centripetal_x, ay + centripetal_y);
+    if (norm > linear_limit_) {
+      const double scale = linear_limit_ / norm;
+      ax = (ax + centripetal_x) * scale - centripetal_x;
+      ay = (ay + centripetal_y) * scale - centripetal_y;
+    }
+    acceleration_ = Twist{
+      ax, ay,
+      std::clamp(x(2), -config_.max_angular_acceleration, config_.max_angular_acceleration)};
+    return result;
+  }
+
+  // First planned acceleration of the last solve() [m/s^2, m/s^2, rad/s^2]
+  const Twist & acceleration() const {return acceleration_;}
+  double linear_acceleration_limit() const {return linear_limit_;}
+  const KiwiMpcConfig & config() const {return config_;}
+
+private:
+  KiwiMpcConfig config_;
+  double linear_limit_ = mpc_model::kTippingAcceleration;
+  Eigen::Matrix3d inverse_;
+  Solver solver_;
+  Solver::Vector q_;
+  Solver::ConstraintVector lower_;
+  Solver::ConstraintVector upper_;
+  Twist acceleration_{0.0, 0.0, 0.0};
+};
+
+}  // namespace robocap_control
+
+#endif  // ROBOCAP_CONTROL__KIWI_MPC_HPP_
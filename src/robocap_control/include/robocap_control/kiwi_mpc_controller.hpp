@@ -0,0 +1,90 @@
+#ifndef ROBOCAP_CONTROL__KIWI_MPC_CONTROLLER_HPP_
+#define ROBOCAP_CONTROL__KIWI_MPC_CONTROLLER_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "controller_interface/controller_interface.hpp"
+#include "geometry_msgs/msg/twist.hpp"
+#include "rclcpp/subscription.hpp"
+#include "rclcpp_lifecycle/state.hpp"
+
+#include "robocap_control/kiwi_mpc.hpp"
+#include "robocap_control/controller_metrics.hpp"
+#include "robocap_control/triple_buffer.hpp"
+#include "robocap_control/wheel_backend.hpp"
+
+namespace robocap_control
+{
+
+// cmd_vel -> wheel velocity controller for the kiwi drive that reaches each command through
+// KiwiMpc instead of stepping to it, so hard maneuvers stay inside the tall chassis' tipping
+// limit. A drop-in for KiwiDriveController on the same interfaces, without its odometry.
+//
+// update() runs at the controller manager's rate and re-plans at mpc_rate from the twist the
+// wheel velocity states measure. In between it ramps the command along the first planned
+// acceleration. Everything the solver touches is sized at compile time and set up in
+// on_configure. update() neither allocates nor logs, unconverged solves are only counted and
+// reported on deactivation. Loop period, overruns and command latency are recorded through
+// ControllerMetrics.
+class KiwiMpcController : public controller_interface::ControllerInterface
+{
+public:
+  KiwiMpcController() = default;
+
+  controller_interface::InterfaceConfiguration command_interface_configuration() const override;
+  controller_interface::InterfaceConfiguration state_interface_configuration() const override;
+
+  controller_interface::CallbackReturn on_init() override;
+  controller_interface::CallbackReturn on_configure(const rclcpp_lifecycle::State & previous_state)
+  override;
+  controller_interface::CallbackReturn on_activate(const rclcpp_lifecycle::State & previous_state)
+  override;
+  controller_interface::CallbackReturn on_deactivate(
+    const rclcpp_lifecycle::State & previous_state) override;
+
+  controller_interface::return_type update(
+    const rclcpp::Time & time, const rclcpp::Duration & period) override;
+
+private:
+  struct Command
+  {
+    double vx;
+    double vy;
+    double wz;
+    std::int64_t stamp_ns;  // Receive time, for the timeout
+    std::int64_t received_ns;  // Receive time on the steady clock, for the command latency
+    std::uint64_t sequence;  // Numbers received commands for tracing, 0 before the first
+  };
+
+  // Parameters
+  std::array<std::string, kNumWheels> wheel_names_;
+  double cmd_vel_timeout_ = 0.5;  // [s]
+  double mpc_rate_ = 200.0;       // [Hz]
+
+  // Indices into command_interfaces_/state_interfaces_, resolved on activation
+  std::array<std::size_t, kNumWheels> command_index_{};
+  std::array<std::size_t, kNumWheels> state_index_{};
+
+  KiwiMpc mpc_;
+  TripleBuffer<Command> command_buffer_;
+  std::uint64_t cmd_vel_count_ = 0;  // Only touched by the subscription
+  Command command_{};
+  std::int64_t activated_ns_ = 0;  // Steady clock, commands received before it are stale
+  ControllerMetrics metrics_;
+  std::int64_t solve_period_ns_ = 0;
+  std::int64_t last_solve_ns_ = 0;
+  // Twist the current plan started from, and whether there is a plan yet
+  KiwiMpc::Twist plan_start_{0.0, 0.0, 0.0};
+  bool planned_ = false;
+  std::uint64_t solves_ = 0;
+  std::uint64_t unconverged_solves_ = 0;
+
+  rclcpp::Subscription<geometry_msgs::msg::Twist>::SharedPtr cmd_vel_subscriber_;
+};
+
+}  // namespace robocap_control
+
+#endif  // ROBOCAP_CONTROL__KIWI_MPC_CONTROLLER_HPP_
@@ -0,0 +1,125 @@
+#ifndef ROBOCAP_CONTROL__MOTOR_BUS_BACKEND_HPP_
+#define ROBOCAP_CONTROL__MOTOR_BUS_BACKEND_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "robocap_control/motor_protocol.hpp"
+#include "robocap_control/spsc_ring.hpp"
+#include "robocap_control/wheel_backend.hpp"
+#include "robocap_runtime/metrics.hpp"
+
+namespace robocap_control
+{
+
+// The real robot's WheelBackend: the three wheel motor drivers on a SocketCAN interface or a
+// serial line, in motor_protocol.hpp's format. KiwiDriveSystem creates it from the hardware
+// parameters whenever no GzControlPlugin attached the simulated backend, so the controllers and
+// the URDF are the same in simulation and on the robot.
+//
+// All device I/O happens on one thread that sleeps in epoll until the controller manager hands it
+// a command or the device has data. write() pushes the commands into an SPSC ring and wakes it
+// through an eventfd, and it sends all three motors' set-points at once: one write() on a serial
+// line, one sendmmsg() on CAN. Feedback frames come back through a second ring that read()
+// drains; the driver streams them at its own rate and read() reports the latest of each motor.
+// Neither read() nor write() blocks on the device or allocates. Dropped commands (a full ring)
+// and feedback frames that fail to parse are counted in robocap_motor_bus_*_total.
+//
+// Hardware parameters (<ros2_control><hardware><param>):
+//   transport  can or serial, defaults to can
+//   device     CAN interface or serial device, defaults to can0
+//   baud_rate  serial only, defaults to 1000000
+//   motor_ids  driver ids of wheel_1..wheel_3, defaults to 1,2,3
+class MotorBusBackend : public WheelBackend
+{
+public:
+  enum class Transport
+  {
+    kCan,
+    kSerial,
+  };
+
+  struct Config
+  {
+    Transport transport = Transport::kCan;
+    std::string device = "can0";
+    int baud_rate = 1000000;
+    std::array<std::uint8_t, kNumWheels> motor_ids{1, 2, 3};
+  };
+
+  // Throws std::invalid_argument naming the offending parameter
+  static Config parse_config(const std::unordered_map<std::string, std::string> & parameters);
+
+  explicit MotorBusBackend(Config config);
+  // Coasts the motors and stops the I/O thread
+  ~MotorBusBackend() override;
+
+  MotorBusBackend(const MotorBusBackend &) = delete;
+  MotorBusBackend & operator=(const MotorBusBackend &) = delete;
+
+  // Opens the device and starts the I/O thread
+  bool configure(const std::array<std::string, kNumWheels> & joint_names) override;
+  void read(WheelStates & states) override;
+  void write(const WheelCommands & commands) override;
+
+private:
+  struct Feedback
+  {
+    std::size_t wheel;
+    MotorFeedback data;
+  };
+
+  bool open_can();
+  bool open_serial();
+  void run();
+  // Sends the pending batch, first what is left of the last one if the device did not take it whole
+  void flush();
+  // False if the device would block, after arranging to be called again once it is writable
+  bool send_can();
+  bool send_serial();
+  void wait_writable(bool wait);
+  void receive_can();
+  void receive_serial();
+  void take_feedback(std::uint8_t motor_id, const MotorPayload & payload);
+
+  Config config_;
+  std::array<int, kMaxMotorId + 1> wheel_of_motor_;  // -1 for ids that are not ours
+
+  int device_fd_ = -1;
+  int epoll_fd_ = -1;
+  int wake_fd_ = -1;
+  std::thread thread_;
+  std::atomic<bool> running_{false};
+
+  SpscRing<WheelCommands, 16> commands_;
+  SpscRing<Feedback, 256> feedback_;
+
+  // I/O thread only. The batch being sent, counted in frames on CAN and in bytes on serial
+  WheelCommands next_;
+  bool have_next_ = false;
+  std::array<MotorPayload, kNumWheels> tx_payloads_{};
+  std::array<std::uint8_t, kNumWheels * kSerialFrameSize> tx_bytes_{};
+  std::size_t tx_size_ = 0;
+  std::size_t tx_sent_ = 0;
+  bool waiting_writable_ = false;
+  bool tx_failing_ = false;  // Only logs the first of a run of failed sends
+  std::array<std::uint8_t, 4096> rx_bytes_{};
+  std::size_t rx_size_ = 0;
+
+  // Controller manager thread only
+  WheelStates states_;
+  std::array<std::int32_t, kNumWheels> last_position_raw_{};
+  std::array<bool, kNumWheels> have_position_{};
+
+  robocap_runtime::Counter * dropped_commands_ = nullptr;
+  robocap_runtime::Counter * bad_frames_ = nullptr;
+};
+
+}  // namespace robocap_control
+
+#endif  // ROBOCAP_CONTROL__MOTOR_BUS_BACKEND_HPP_
@@ -0,0 +1,199 @@
+#ifndef ROBOCAP_CONTROL__MOTOR_PROTOCOL_HPP_
+#define ROBOCAP_CONTROL__MOTOR_PROTOCOL_HPP_
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace robocap_control
+{
+
+// Wire format of the wheel motor drivers (motor_1..motor_3 in the transmissions), one 8-byte
+// little-endian payload per motor and direction, the same on both transports:
+//
+//   command   mode u8 (0 coast, 1 velocity, 2 effort), reserved u8, effort i16 [mNm],
+//             velocity i32 [mrad/s]
+//   feedback  position i32 [0.1 mrad, wrapping], velocity i16 [10 mrad/s], effort i16 [mNm]
+//
+// On CAN a payload is a classic frame with id kCanCommandBase/kCanFeedbackBase + motor id. On a
+// serial line it is framed as kSerialSync, the id byte (motor id, kSerialFeedbackFlag set for
+// feedback), the payload and a CRC-8 (polynomial 0x07) over id and payload, kSerialFrameSize bytes.
+constexpr std::size_t kMotorPayloadSize = 8;
+using MotorPayload = std::array<std::uint8_t, kMotorPayloadSize>;
+
+constexpr std::uint32_t kCanCommandBase = 0x200;
+constexpr std::uint32_t kCanFeedbackBase = 0x280;
+constexpr std::uint8_t kSerialSync = 0xA5;
+constexpr std::uint8_t kSerialFeedbackFlag = 0x80;
+constexpr std::size_t kSerialFrameSize = 1 + 1 + kMotorPayloadSize + 1;
+constexpr std::uint8_t kMaxMotorId = 0x7F;
+
+enum class MotorMode : std::uint8_t
+{
+  kCoast = 0,
+  kVelocity = 1,
+  kEffort = 2,
+};
+
+struct MotorCommand
+{
+  MotorMode mode = MotorMode::kCoast;
+  double velocity = 0.0;  // [rad/s]
+  double effort = 0.0;    // [Nm]
+};
+
+struct MotorFeedback
+{
+  std::int32_t position_raw = 0;  // [0.1 mrad], wraps, see unwrap_position()
+  double velocity = 0.0;          // [rad/s]
+  double effort = 0.0;            // [Nm]
+};
+
+namespace detail
+{
+
+template<typename T>
+T saturate(double value)
+{
+  constexpr double kMin = static_cast<double>(std::numeric_limits<T>::min());
+  constexpr double kMax = static_cast<double>(std::numeric_limits<T>::max());
+  return static_cast<T>(std::lround(std::fmin(std::fmax(value, kMin), kMax)));
+}
+
+template<typename T>
+void put(MotorPayload & payload, std::size_t offset, T value)
+{
+  using U = std::make_unsigned_t<T>;
+  for (std::size_t i = 0; i < sizeof(T); ++i) {
+    payload[offset + i] = static_cast<std::uint8_t>(static_cast<U>(value) >> (8 * i));
+  }
+}
+
+template<typename T>
+T get(const MotorPayload & payload, std::size_t offset)
+{
+  using U = std::make_unsigned_t<T>;
+  U value = 0;
+  for (std::size_t i = 0; i < sizeof(T); ++i) {
+    value = static_cast<U>(value | static_cast<U>(static_cast<U>(payload[offset + i]) << (8 * i)));
+  }
+  return static_cast<T>(value);
+}
+
+}  // namespace detail
+
+inline MotorPayload encode_command(const MotorCommand & command)
+{
+  MotorPayload payload{};
+  payload[0] = static_cast<std::uint8_t>(command.mode);
+  detail::put(payload, 2, detail::saturate<std::int16_t>(command.effort * 1e3));
+  detail::put(payload, 4, detail::saturate<std::int32_t>(command.velocity * 1e3));
+  return payload;
+}
+
+inline MotorCommand decode_command(const MotorPayload & payload)
+{
+  MotorCommand command;
+  command.mode = static_cast<MotorMode>(payload[0]);
+  command.effort = detail::get<std::int16_t>(payload, 2) * 1e-3;
+  command.velocity = detail::get<std::int32_t>(payload, 4) * 1e-3;
+  return command;
+}
+
+inline MotorPayload encode_feedback(const MotorFeedback & feedback)
+{
+  MotorPayload payload{};
+  detail::put(payload, 0, feedback.position_raw);
+  detail::put(payload, 4, detail::saturate<std::int16_t>(feedback.velocity * 1e2));
+  detail::put(payload, 6, detail::saturate<std::int16_t>(feedback.effort * 1e3));
+  return payload;
+}
+
+inline MotorFeedback decode_feedback(const MotorPayload & payload)
+{
+  MotorFeedback feedback;
+  feedback.position_raw = detail::get<std::int32_t>(payload, 0);
+  feedback.velocity = detail::get<std::int16_t>(payload, 4) * 1e-2;
+  feedback.effort = detail::get<std::int16_t>(payload, 6) * 1e-3;
+  return feedback;
+}
+
+// [rad] moved from `previous` to `current` raw position, correct across the wrap as long as the
+// wheel turns less than half the raw range (about 34000 turns) between two feedback frames
+inline double unwrap_position(std::int32_t previous, std::int32_t current)
+{
+  const auto delta = static_cast<std::int32_t>(
+    static_cast<std::uint32_t>(current) - static_cast<std::uint32_t>(previous));
+  return delta * 1e-4;
+}
+
+inline std::int32_t position_to_raw(double position)
+{
+  // Wraps like the drivers' counters do
+  const double ticks = std::remainder(position * 1e4, 4294967296.0);
+  return static_cast<std::int32_t>(static_cast<std::uint32_t>(static_cast<std::int64_t>(ticks)));
+}
+
+inline std::uint8_t crc8(const std::uint8_t * data, std::size_t size)
+{
+  std::uint8_t crc = 0;
+  for (std::size_t i = 0; i < size; ++i) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = static_cast<std::uint8_t>((crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1);
+    }
+  }
+  return crc;
+}
+
+// Writes one serial frame for `id` to `out`, which has room for kSerialFrameSize bytes
+inline void write_serial_frame(std::uint8_t id, const MotorPayload & payload, std::uint8_t * out)
+{
+  out[0] = kSerialSync;
+  out[1] = id;
+  for (std::size_t i = 0; i < kMotorPayloadSize; ++i) {
+    out[2 + i] = payload[i];
+  }
+  out[kSerialFrameSize - 1] = crc8(out + 1, kSerialFrameSize - 2);
+}
+
+// Looks for the next valid frame in `data`. Returns true with it in `id` and `payload`, and
+// `consumed` set past it. Otherwise `consumed` covers the bytes that cannot start a frame and a
+// partial frame at the end is left for the next read. Frames with a bad CRC are skipped and
+// counted in `rejected`.
+inline bool read_serial_frame(
+  const std::uint8_t * data, std::size_t size, std::size_t & consumed, std::uint8_t & id,
+  MotorPayload & payload, std::uint64_t & rejected)
+{
+  std::size_t offset = 0;
+  while (offset < size) {
+    if (data[offset] != kSerialSync) {
+      ++offset;
+      continue;
+    }
+    if (size - offset < kSerialFrameSize) {
+      break;  // Wait for the rest of it
+    }
+    const std::uint8_t * frame = data + offset;
+    if (crc8(frame + 1, kSerialFrameSize - 2) != frame[kSerialFrameSize - 1]) {
+      ++rejected;
+      ++offset;  // A corrupted frame, or a sync byte inside a payload: resynchronize
+      continue;
+    }
+    id = frame[1];
+    for (std::size_t i = 0; i < kMotorPayloadSize; ++i) {
+      payload[i] = frame[2 + i];
+    }
+    consumed = offset + kSerialFrameSize;
+    return true;
+  }
+  consumed = offset;
+  return false;
+}
+
+}  // namespace robocap_control
+
+#endif  // ROBOCAP_CONTROL__MOTOR_PROTOCOL_HPP_
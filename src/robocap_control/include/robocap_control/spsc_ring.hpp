@@ -0,0 +1,67 @@
+#ifndef ROBOCAP_CONTROL__SPSC_RING_HPP_
+#define ROBOCAP_CONTROL__SPSC_RING_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace robocap_control
+{
+
+// Bounded single-producer, single-consumer FIFO. push() and pop() are a relaxed load, an acquire
+// load only when the cached index of the other side says the ring looks full (or empty), and a
+// release store, so neither side waits for or allocates behind the other. Unlike TripleBuffer it
+// keeps every value, for streams where each one counts, e.g. feedback frames of different motors.
+template<typename T, std::size_t Capacity>
+class SpscRing
+{
+  static_assert(std::is_trivially_copyable<T>::value, "T is copied from the real-time thread");
+  static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+  // Producer side. Returns false if the ring is full
+  bool push(const T & value)
+  {
+    const std::uint64_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_cache_ == Capacity) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (tail - head_cache_ == Capacity) {
+        return false;
+      }
+    }
+    slots_[tail & kMask] = value;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Returns false if the ring is empty
+  bool pop(T & value)
+  {
+    const std::uint64_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_cache_) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (head == tail_cache_) {
+        return false;
+      }
+    }
+    value = slots_[head & kMask];
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  static constexpr std::uint64_t kMask = Capacity - 1;
+
+  std::array<T, Capacity> slots_{};
+  // Each side's index and its cached copy of the other side's on their own cache lines
+  alignas(64) std::atomic<std::uint64_t> tail_{0};
+  std::uint64_t head_cache_ = 0;
+  alignas(64) std::atomic<std::uint64_t> head_{0};
+  std::uint64_t tail_cache_ = 0;
+};
+
+}  // namespace robocap_control
+
+#endif  // ROBOCAP_CONTROL__SPSC_RING_HPP_
@@ -0,0 +1,59 @@
+#ifndef ROBOCAP_CONTROL__TRIPLE_BUFFER_HPP_
+#define ROBOCAP_CONTROL__TRIPLE_BUFFER_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+namespace robocap_control
+{
+
+// Single-producer, single-consumer latest-value buffer. write() and read() are each one atomic
+// exchange, so neither side ever waits for the other (unlike realtime_tools::RealtimeBuffer, which
+// takes a mutex on the writer side and try-locks on the reader side). The reader always sees the
+// most recent complete value; intermediate values may be skipped.
+template<typename T>
+class TripleBuffer
+{
+  static_assert(std::is_trivially_copyable<T>::value, "T is copied from the real-time thread");
+  static_assert(std::atomic<std::uint8_t>::is_always_lock_free, "needs a lock-free byte atomic");
+
+public:
+  explicit TripleBuffer(const T & initial = T{})
+  {
+    buffers_.fill(initial);
+  }
+
+  // Producer side
+  void write(const T & value)
+  {
+    buffers_[back_] = value;
+    back_ = middle_.exchange(back_ | kFreshBit, std::memory_order_acq_rel) & kIndexMask;
+  }
+
+  // Consumer side. Returns true when `value` was updated since the last call.
+  bool read(T & value)
+  {
+    const bool fresh = (middle_.load(std::memory_order_relaxed) & kFreshBit) != 0;
+    if (fresh) {
+      front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndexMask;
+    }
+    value = buffers_[front_];
+    return fresh;
+  }
+
+private:
+  static constexpr std::uint8_t kIndexMask = 0x3;
+  static constexpr std::uint8_t kFreshBit = 0x4;
+
+  std::array<T, 3> buffers_;
+  // Each side owns one slot, the third is handed over through middle_
+  alignas(64) std::atomic<std::uint8_t> middle_{1};
+  alignas(64) std::uint8_t back_{0};
+  alignas(64) std::uint8_t front_{2};
+};
+
+}  // namespace robocap_control
+
+#endif  // ROBOCAP_CONTROL__TRIPLE_BUFFER_HPP_
@@ -0,0 +1,52 @@
+#ifndef ROBOCAP_CONTROL__WHEEL_BACKEND_HPP_
+#define ROBOCAP_CONTROL__WHEEL_BACKEND_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace robocap_control
+{
+
+// The kiwi drive has exactly three wheels, wheel_1_joint..wheel_3_joint in robot_core.xacro
+constexpr std::size_t kNumWheels = 3;
+
+enum class CommandMode : std::uint8_t
+{
+  kNone,      // No controller has claimed the joint, leave it free
+  kVelocity,  // Track commands.velocity [rad/s]
+  kEffort,    // Apply commands.effort [Nm]
+};
+
+struct WheelStates
+{
+  std::array<double, kNumWheels> position{};
+  std::array<double, kNumWheels> velocity{};
+  std::array<double, kNumWheels> effort{};
+};
+
+struct WheelCommands
+{
+  std::array<CommandMode, kNumWheels> mode{};
+  std::array<double, kNumWheels> velocity{};
+  std::array<double, kNumWheels> effort{};
+};
+
+// Where KiwiDriveSystem gets its wheel data from. read() and write() are called from the
+// controller manager loop and must not block or allocate.
+class WheelBackend
+{
+public:
+  virtual ~WheelBackend() = default;
+
+  // Resolve the joints, called once from KiwiDriveSystem::on_init
+  virtual bool configure(const std::array<std::string, kNumWheels> & joint_names) = 0;
+
+  virtual void read(WheelStates & states) = 0;
+  virtual void write(const WheelCommands & commands) = 0;
+};
+
+}  // namespace robocap_control
+
+#endif  // ROBOCAP_CONTROL__WHEEL_BACKEND_HPP_
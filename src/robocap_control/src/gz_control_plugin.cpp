@@ -0,0 +1,309 @@
+#include "robocap_control/gz_control_plugin.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "controller_manager_msgs/srv/switch_controller.hpp"
+#include "hardware_interface/component_parser.hpp"
+#include "hardware_interface/resource_manager.hpp"
+#include "hardware_interface/types/lifecycle_state_names.hpp"
+#include "ignition/gazebo/Model.hh"
+#include "ignition/plugin/Register.hh"
+#include "lifecycle_msgs/msg/state.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "rclcpp_lifecycle/state.hpp"
+#include "robocap_tracing/tracing.hpp"
+
+#include "robocap_control/gz_wheel_backend.hpp"
+#include "robocap_control/kiwi_drive_system.hpp"
+
+namespace robocap_control
+{
+
+namespace
+{
+
+const rclcpp::Logger kLogger = rclcpp::get_logger("GzControlPlugin");
+constexpr char kKiwiDriveSystemType[] = "robocap_control/KiwiDriveSystem";
+
+std::string sdf_string(
+  const std::shared_ptr<const sdf::Element> & sdf, const std::string & key,
+  const std::string & fallback)
+{
+  const auto value = sdf->HasElement(key) ? sdf->Get<std::string>(key) : std::string{};
+  return value.empty() ? fallback : value;
+}
+
+// A TCP port, 0 (off) for an empty value and, with a warning, for anything that is not one
+int parse_port(const std::string & value)
+{
+  if (value.empty()) {
+    return 0;
+  }
+  int port = 0;
+  const auto end = value.data() + value.size();
+  const auto [last, error] = std::from_chars(value.data(), end, port);
+  if (error != std::errc() || last != end || port < 0 || port > 65535) {
+    RCLCPP_WARN(kLogger, "metrics port '%s' is not a port, not exporting metrics", value.c_str());
+    return 0;
+  }
+  return port;
+}
+
+// Blocks until robot_state_publisher (or whichever node is configured) serves the robot
+// description. The plugin is useless without it, so there is no timeout.
+std::string fetch_robot_description(
+  const rclcpp::Node::SharedPtr & node, const std::string & param_node)
+{
+  auto client = std::make_shared<rclcpp::SyncParametersClient>(node, param_node);
+  while (!client->wait_for_service(std::chrono::seconds(1))) {
+    if (!rclcpp::ok()) {
+      return {};
+    }
+    RCLCPP_INFO(kLogger, "Waiting for '%s' to provide robot_description", param_node.c_str());
+  }
+  for (const auto & parameter : client->get_parameters({"robot_description"})) {
+    if (parameter.get_name() == "robot_description") {
+      return parameter.value_to_string();
+    }
+  }
+  return {};
+}
+
+std::string read_file(const std::string & path)
+{
+  std::ifstream file(path);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+}  // namespace
+
+GzControlPlugin::~GzControlPlugin()
+{
+  if (executor_) {
+    executor_->cancel();
+  }
+  if (executor_thread_.joinable()) {
+    executor_thread_.join();
+  }
+}
+
+void GzControlPlugin::Configure(
+  const ignition::gazebo::Entity & entity, const std::shared_ptr<const sdf::Element> & sdf,
+  ignition::gazebo::EntityComponentManager & ecm,
+  ignition::gazebo::EventManager & /*event_manager*/)
+{
+  const ignition::gazebo::Model model(entity);
+  if (!model.Valid(ecm)) {
+    RCLCPP_ERROR(kLogger, "GzControlPlugin must be attached to a model");
+    return;
+  }
+  const auto model_name = model.Name(ecm);
+
+  const auto parameters_file = sdf_string(sdf, "parameters", "");
+  if (parameters_file.empty()) {
+    RCLCPP_ERROR(kLogger, "<parameters> is required to configure the controller manager");
+    return;
+  }
+
+  // The ROS arguments are the only way to hand a parameter file to the controller manager node. A
+  // host that initialized rclcpp itself (robocap_deterministic_sim) passes the file in its own
+  // arguments instead
+  if (!rclcpp::ok()) {
+    std::vector<const char *> argv = {"gz_control_plugin", "--ros-args", "--params-file",
+      parameters_file.c_str()};
+    rclcpp::init(static_cast<int>(argv.size()), argv.data());
+  }
+
+  const auto ros_namespace = sdf_string(sdf, "namespace", "");
+  auto node = rclcpp::Node::make_shared("robocap_gz_control", ros_namespace);
+  // Reading the baked URDF directly avoids waiting on robot_state_publisher over DDS
+  const auto description_file = sdf_string(sdf, "robot_description_file", "");
+  const auto urdf = description_file.empty() ?
+    fetch_robot_description(node, sdf_string(sdf, "robot_param_node", "robot_state_publisher")) :
+    read_file(description_file);
+  if (urdf.empty()) {
+    RCLCPP_ERROR(kLogger, "Got an empty robot_description, controllers are not started");
+    return;
+  }
+
+  std::vector<hardware_interface::HardwareInfo> hardware_infos;
+  try {
+    hardware_infos = hardware_interface::parse_control_resources_from_urdf(urdf);
+  } catch (const std::runtime_error & e) {
+    RCLCPP_ERROR(kLogger, "Failed to parse the <ros2_control> tags: %s", e.what());
+    return;
+  }
+
+  auto resource_manager = std::make_unique<hardware_interface::ResourceManager>();
+  resource_manager->load_urdf(urdf, false, false);
+  for (const auto & hardware_info : hardware_infos) {
+    if (hardware_info.hardware_class_type != kKiwiDriveSystemType) {
+      RCLCPP_WARN(
+        kLogger, "Skipping '%s' of type '%s', only %s is simulated", hardware_info.name.c_str(),
+        hardware_info.hardware_class_type.c_str(), kKiwiDriveSystemType);
+      continue;
+    }
+    auto system = std::make_unique<KiwiDriveSystem>(
+      std::make_unique<GzWheelBackend>(ecm, entity));
+    resource_manager->import_component(std::move(system), hardware_info);
+
+    rclcpp_lifecycle::State active(
+      lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE,
+      hardware_interface::lifecycle_state_names::ACTIVE);
+    resource_manager->set_component_state(hardware_info.name, active);
+  }
+
+  std::vector<std::string> lockstep_controllers;
+  if (const char * names = std::getenv("ROBOCAP_DETERMINISTIC_CONTROLLERS")) {
+    lockstep_ = true;
+    std::istringstream stream(names);
+    for (std::string name; stream >> name; ) {
+      lockstep_controllers.push_back(name);
+    }
+  }
+  if (lockstep_) {
+    executor_ = std::make_shared<rclcpp::executors::SingleThreadedExecutor>();
+  } else {
+    executor_ = std::make_shared<rclcpp::executors::MultiThreadedExecutor>();
+  }
+  controller_manager_ = std::make_shared<controller_manager::ControllerManager>(
+    std::move(resource_manager), executor_,
+    sdf_string(sdf, "controller_manager_name", "controller_manager"), ros_namespace);
+  executor_->add_node(controller_manager_);
+  // Per process, so every instance of a farm or lockstep run does not try to bind the same port
+  const char * metrics_port = std::getenv("ROBOCAP_METRICS_PORT");
+  start_metrics_exporter(
+    parse_port(sdf_string(sdf, "metrics_port", metrics_port != nullptr ? metrics_port : "")));
+
+  const auto update_rate = controller_manager_->get_update_rate();
+  control_period_ = rclcpp::Duration::from_seconds(1.0 / static_cast<double>(update_rate));
+  RCLCPP_INFO(
+    kLogger, "Controller manager for '%s' running at %u Hz", model_name.c_str(), update_rate);
+  ROBOCAP_TRACEPOINT(component_init, this, model_name.c_str());
+
+  if (lockstep_) {
+    if (!activate_controllers(lockstep_controllers)) {
+      RCLCPP_ERROR(kLogger, "Failed to activate the lockstep controllers");
+    }
+    return;
+  }
+  // Only the controller manager's services run here, the control loop itself is driven by us
+  executor_thread_ = std::thread([this]() {executor_->spin();});
+}
+
+void GzControlPlugin::start_metrics_exporter(int port)
+{
+  if (port <= 0) {
+    return;
+  }
+  // The controllers' metrics are in this process's registry, which the container's exporter
+  // cannot see, so gz sim serves its own on another port
+  try {
+    metrics_exporter_ = std::make_shared<robocap_runtime::MetricsExporter>(
+      rclcpp::NodeOptions()
+      .arguments({"--ros-args", "-r", "__node:=gz_metrics_exporter"})
+      .parameter_overrides({{"port", port}}));
+  } catch (const std::exception & e) {
+    RCLCPP_ERROR(kLogger, "Controller metrics are not exported: %s", e.what());
+    return;
+  }
+  executor_->add_node(metrics_exporter_);
+}
+
+void GzControlPlugin::PreUpdate(
+  const ignition::gazebo::UpdateInfo & info, ignition::gazebo::EntityComponentManager & /*ecm*/)
+{
+  if (lockstep_ && executor_) {
+    // Everything published before this step, e.g. cmd_vel, reaches the controllers now
+    executor_->spin_all(std::chrono::nanoseconds(0));
+  }
+  if (!controller_manager_ || info.paused) {
+    return;
+  }
+  // Commands are applied on every physics step so joints do not coast between control periods
+  const rclcpp::Time sim_time(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(info.simTime).count(), RCL_ROS_TIME);
+  ROBOCAP_TRACEPOINT(sim_pre_update, this, sim_time.nanoseconds());
+  controller_manager_->write(sim_time, sim_time - last_update_time_);
+}
+
+void GzControlPlugin::PostUpdate(
+  const ignition::gazebo::UpdateInfo & info,
+  const ignition::gazebo::EntityComponentManager & /*ecm*/)
+{
+  if (!controller_manager_ || info.paused) {
+    return;
+  }
+  const rclcpp::Time sim_time(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(info.simTime).count(), RCL_ROS_TIME);
+  // The physics step that consumed the commands of PreUpdate ends here
+  ROBOCAP_TRACEPOINT(sim_post_update, this, sim_time.nanoseconds());
+  const auto period = sim_time - last_update_time_;
+  if (period < control_period_) {
+    return;
+  }
+  last_update_time_ = sim_time;
+  controller_manager_->read(sim_time, period);
+  controller_manager_->update(sim_time, period);
+}
+
+bool GzControlPlugin::activate_controllers(const std::vector<std::string> & names)
+{
+  for (const auto & name : names) {
+    if (!controller_manager_->load_controller(name)) {
+      RCLCPP_ERROR(kLogger, "Failed to load controller '%s'", name.c_str());
+      return false;
+    }
+    if (controller_manager_->configure_controller(name) != controller_interface::return_type::OK) {
+      RCLCPP_ERROR(kLogger, "Failed to configure controller '%s'", name.c_str());
+      return false;
+    }
+  }
+  const auto all_active = [this, &names]() {
+      for (const auto & controller : controller_manager_->get_loaded_controllers()) {
+        if (std::find(names.begin(), names.end(), controller.info.name) != names.end() &&
+          controller.c->get_state().id() != lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE)
+        {
+          return false;
+        }
+      }
+      return true;
+    };
+
+  // switch_controller() blocks until update() performs the switch, so it is asked from a helper
+  // thread while this one updates at t = 0. Only active controllers run and the loop ends with the
+  // update that activated them, so the state the run starts from does not depend on the timing.
+  auto switched = std::async(
+    std::launch::async, [this, &names]() {
+      return controller_manager_->switch_controller(
+        names, {}, controller_manager_msgs::srv::SwitchController::Request::STRICT);
+    });
+  const rclcpp::Time start(0, 0, RCL_ROS_TIME);
+  const rclcpp::Duration zero(0, 0);
+  while (!all_active()) {
+    if (switched.wait_for(std::chrono::microseconds(100)) == std::future_status::ready) {
+      break;
+    }
+    controller_manager_->update(start, zero);
+  }
+  return switched.get() == controller_interface::return_type::OK && all_active();
+}
+
+}  // namespace robocap_control
+
+IGNITION_ADD_PLUGIN(
+  robocap_control::GzControlPlugin, ignition::gazebo::System,
+  robocap_control::GzControlPlugin::ISystemConfigure,
+  robocap_control::GzControlPlugin::ISystemPreUpdate,
+  robocap_control::GzControlPlugin::ISystemPostUpdate)
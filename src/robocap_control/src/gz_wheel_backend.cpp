@@ -0,0 +1,116 @@
+#include "robocap_control/gz_wheel_backend.hpp"
+
+#include "ignition/gazebo/Model.hh"
+#include "ignition/gazebo/components/JointForceCmd.hh"
+#include "ignition/gazebo/components/JointPosition.hh"
+#include "ignition/gazebo/components/JointVelocity.hh"
+#include "ignition/gazebo/components/JointVelocityCmd.hh"
+#include "rclcpp/logging.hpp"
+#include "robocap_tracing/tracing.hpp"
+
+namespace robocap_control
+{
+
+namespace components = ignition::gazebo::components;
+
+namespace
+{
+
+const rclcpp::Logger kLogger = rclcpp::get_logger("GzWheelBackend");
+
+// Creates a single-axis component so physics starts populating (or consuming) it. All later
+// accesses write into the existing vector in place, which keeps read()/write() allocation free.
+template<typename ComponentT>
+void ensure_component(
+  ignition::gazebo::EntityComponentManager & ecm, ignition::gazebo::Entity joint)
+{
+  if (!ecm.Component<ComponentT>(joint)) {
+    ecm.CreateComponent(joint, ComponentT({0.0}));
+  }
+}
+
+}  // namespace
+
+GzWheelBackend::GzWheelBackend(
+  ignition::gazebo::EntityComponentManager & ecm, ignition::gazebo::Entity model)
+: ecm_(ecm), model_(model)
+{
+}
+
+bool GzWheelBackend::configure(const std::array<std::string, kNumWheels> & joint_names)
+{
+  const ignition::gazebo::Model model(model_);
+  for (std::size_t i = 0; i < kNumWheels; ++i) {
+    joints_[i] = model.JointByName(ecm_, joint_names[i]);
+    if (joints_[i] == ignition::gazebo::kNullEntity) {
+      RCLCPP_ERROR(
+        kLogger, "Joint '%s' not found in model '%s'", joint_names[i].c_str(),
+        model.Name(ecm_).c_str());
+      return false;
+    }
+    ensure_component<components::JointPosition>(ecm_, joints_[i]);
+    ensure_component<components::JointVelocity>(ecm_, joints_[i]);
+    ROBOCAP_TRACEPOINT(
+      wheel_joint_init, this, static_cast<std::uint32_t>(i), joint_names[i].c_str());
+  }
+  ROBOCAP_TRACEPOINT(component_init, this, model.Name(ecm_).c_str());
+  return true;
+}
+
+void GzWheelBackend::read(WheelStates & states)
+{
+  for (std::size_t i = 0; i < kNumWheels; ++i) {
+    // Physics may not have filled the components yet on the very first iteration
+    const auto * position = ecm_.Component<components::JointPosition>(joints_[i]);
+    if (position && !position->Data().empty()) {
+      states.position[i] = position->Data()[0];
+    }
+    const auto * velocity = ecm_.Component<components::JointVelocity>(joints_[i]);
+    if (velocity && !velocity->Data().empty()) {
+      states.velocity[i] = velocity->Data()[0];
+    }
+    // There is no measured joint torque in the ECM, report the applied effort instead
+    const auto * force = ecm_.Component<components::JointForceCmd>(joints_[i]);
+    states.effort[i] = force && !force->Data().empty() ? force->Data()[0] : 0.0;
+  }
+}
+
+void GzWheelBackend::write(const WheelCommands & commands)
+{
+  for (std::size_t i = 0; i < kNumWheels; ++i) {
+    if (commands.mode[i] != active_modes_[i]) {
+      switch_mode(i, commands.mode[i]);
+    }
+    switch (active_modes_[i]) {
+      case CommandMode::kVelocity:
+        ecm_.Component<components::JointVelocityCmd>(joints_[i])->Data()[0] = commands.velocity[i];
+        ROBOCAP_TRACEPOINT(
+          wheel_command_applied, this, static_cast<std::uint32_t>(i), commands.velocity[i]);
+        break;
+      case CommandMode::kEffort:
+        ecm_.Component<components::JointForceCmd>(joints_[i])->Data()[0] = commands.effort[i];
+        ROBOCAP_TRACEPOINT(
+          wheel_command_applied, this, static_cast<std::uint32_t>(i), commands.effort[i]);
+        break;
+      case CommandMode::kNone:
+        break;
+    }
+  }
+}
+
+void GzWheelBackend::switch_mode(std::size_t index, CommandMode mode)
+{
+  // Physics ignores the velocity command while a force command exists, so only the component of
+  // the active mode may be present. This only runs on a controller switch, never in steady state.
+  const auto joint = joints_[index];
+  ecm_.RemoveComponent<components::JointVelocityCmd>(joint);
+  ecm_.RemoveComponent<components::JointForceCmd>(joint);
+  if (mode == CommandMode::kVelocity) {
+    ensure_component<components::JointVelocityCmd>(ecm_, joint);
+  } else if (mode == CommandMode::kEffort) {
+    ensure_component<components::JointForceCmd>(ecm_, joint);
+  }
+  active_modes_[index] = mode;
+}
+
+}  // namespace robocap_control
@@ -0,0 +1,271 @@
+#include "robocap_control/kiwi_drive_controller.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "rclcpp/qos.hpp"
+#include "robocap_kinematics/robocap_layout.hpp"
+#include "robocap_tracing/tracing.hpp"
+
+namespace robocap_control
+{
+
+namespace
+{
+
+constexpr char kCmdVelTopic[] = "~/cmd_vel";
+constexpr char kOdomTopic[] = "~/odom";
+constexpr char kTfTopic[] = "/tf";
+constexpr double kPoseCovariance = 1e-3;
+constexpr double kTwistCovariance = 1e-3;
+
+}  // namespace
+
+controller_interface::CallbackReturn KiwiDriveController::on_init()
+{
+  try {
+    auto_declare<std::vector<std::string>>(
+      "wheel_names", {"wheel_1_joint", "wheel_2_joint", "wheel_3_joint"});
+    auto_declare<std::string>("odom_frame_id", "odom");
+    auto_declare<std::string>("base_frame_id", "base_link");
+    auto_declare<double>("cmd_vel_timeout", cmd_vel_timeout_);
+    auto_declare<double>("max_wheel_velocity", max_wheel_velocity_);
+    auto_declare<double>("publish_rate", publish_rate_);
+    auto_declare<bool>("enable_odom_tf", enable_odom_tf_);
+  } catch (const std::exception & e) {
+    RCLCPP_FATAL(get_node()->get_logger(), "Exception during init: %s", e.what());
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+controller_interface::InterfaceConfiguration
+KiwiDriveController::command_interface_configuration() const
+{
+  controller_interface::InterfaceConfiguration config;
+  config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
+  for (const auto & name : wheel_names_) {
+    config.names.push_back(name + "/" + hardware_interface::HW_IF_VELOCITY);
+  }
+  return config;
+}
+
+controller_interface::InterfaceConfiguration
+KiwiDriveController::state_interface_configuration() const
+{
+  controller_interface::InterfaceConfiguration config;
+  config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
+  for (const auto & name : wheel_names_) {
+    config.names.push_back(name + "/" + hardware_interface::HW_IF_VELOCITY);
+  }
+  return config;
+}
+
+controller_interface::CallbackReturn KiwiDriveController::on_configure(
+  const rclcpp_lifecycle::State & /*previous_state*/)
+{
+  const auto node = get_node();
+  const auto wheel_names = node->get_parameter("wheel_names").as_string_array();
+  if (wheel_names.size() != kNumWheels) {
+    // The kinematics are compiled for the robot_core.xacro layout, wheel_1..wheel_3 in order
+    RCLCPP_ERROR(
+      node->get_logger(), "'wheel_names' needs exactly %zu joints, got %zu", kNumWheels,
+      wheel_names.size());
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  std::copy(wheel_names.begin(), wheel_names.end(), wheel_names_.begin());
+  odom_frame_id_ = node->get_parameter("odom_frame_id").as_string();
+  base_frame_id_ = node->get_parameter("base_frame_id").as_string();
+  cmd_vel_timeout_ = node->get_parameter("cmd_vel_timeout").as_double();
+  max_wheel_velocity_ = node->get_parameter("max_wheel_velocity").as_double();
+  publish_rate_ = node->get_parameter("publish_rate").as_double();
+  enable_odom_tf_ = node->get_parameter("enable_odom_tf").as_bool();
+  if (publish_rate_ <= 0.0) {
+    RCLCPP_ERROR(node->get_logger(), "'publish_rate' must be positive");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  publish_period_ = rclcpp::Duration::from_seconds(1.0 / publish_rate_);
+  ROBOCAP_TRACEPOINT(component_init, this, node->get_name());
+
+  cmd_vel_subscriber_ = node->create_subscription<geometry_msgs::msg::Twist>(
+    kCmdVelTopic, rclcpp::SystemDefaultsQoS(),
+    [this](const std::shared_ptr<geometry_msgs::msg::Twist> msg) {
+      const auto sequence = ++cmd_vel_count_;
+      ROBOCAP_TRACEPOINT(cmd_vel_received, this, sequence);
+      command_buffer_.write(
+        Command{
+          msg->linear.x, msg->linear.y, msg->angular.z, get_node()->now().nanoseconds(),
+          robocap_runtime::steady_clock_ns(), sequence});
+    });
+
+  odom_publisher_ =
+    node->create_publisher<nav_msgs::msg::Odometry>(kOdomTopic, rclcpp::SystemDefaultsQoS());
+  realtime_odom_publisher_ =
+    std::make_unique<realtime_tools::RealtimePublisher<nav_msgs::msg::Odometry>>(odom_publisher_);
+  realtime_odom_publisher_->lock();
+  auto & odom = realtime_odom_publisher_->msg_;
+  odom.header.frame_id = odom_frame_id_;
+  odom.child_frame_id = base_frame_id_;
+  for (std::size_t i = 0; i < 6; ++i) {
+    odom.pose.covariance[7 * i] = kPoseCovariance;
+    odom.twist.covariance[7 * i] = kTwistCovariance;
+  }
+  realtime_odom_publisher_->unlock();
+
+  if (enable_odom_tf_) {
+    tf_publisher_ =
+      node->create_publisher<tf2_msgs::msg::TFMessage>(kTfTopic, rclcpp::SystemDefaultsQoS());
+    realtime_tf_publisher_ =
+      std::make_unique<realtime_tools::RealtimePublisher<tf2_msgs::msg::TFMessage>>(tf_publisher_);
+    realtime_tf_publisher_->lock();
+    // Sized once here so update() only overwrites values
+    realtime_tf_publisher_->msg_.transforms.resize(1);
+    realtime_tf_publisher_->msg_.transforms[0].header.frame_id = odom_frame_id_;
+    realtime_tf_publisher_->msg_.transforms[0].child_frame_id = base_frame_id_;
+    realtime_tf_publisher_->unlock();
+  }
+
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+controller_interface::CallbackReturn KiwiDriveController::on_activate(
+  const rclcpp_lifecycle::State & /*previous_state*/)
+{
+  for (std::size_t wheel = 0; wheel < kNumWheels; ++wheel) {
+    bool found_command = false;
+    for (std::size_t i = 0; i < command_interfaces_.size(); ++i) {
+      if (command_interfaces_[i].get_prefix_name() == wheel_names_[wheel]) {
+        command_index_[wheel] = i;
+        found_command = true;
+      }
+    }
+    bool found_state = false;
+    for (std::size_t i = 0; i < state_interfaces_.size(); ++i) {
+      if (state_interfaces_[i].get_prefix_name() == wheel_names_[wheel]) {
+        state_index_[wheel] = i;
+        found_state = true;
+      }
+    }
+    if (!found_command || !found_state) {
+      RCLCPP_ERROR(
+        get_node()->get_logger(), "Interfaces for '%s' were not claimed",
+        wheel_names_[wheel].c_str());
+      return controller_interface::CallbackReturn::ERROR;
+    }
+  }
+
+  // Never resume with a command from before the deactivation, update() drops what was received
+  // earlier. The subscription stays the buffer's only writer
+  activated_ns_ = robocap_runtime::steady_clock_ns();
+  command_ = Command{};
+  metrics_.activate(get_node()->get_name(), get_update_rate());
+  pose_ = Pose{};
+  last_publish_time_ = get_node()->now();
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+controller_interface::CallbackReturn KiwiDriveController::on_deactivate(
+  const rclcpp_lifecycle::State & /*previous_state*/)
+{
+  for (auto & interface : command_interfaces_) {
+    interface.set_value(0.0);
+  }
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+controller_interface::return_type KiwiDriveController::update(
+  const rclcpp::Time & time, const rclcpp::Duration & period)
+{
+  constexpr const auto & kinematics = robocap_kinematics::kRobocapKiwiDrive;
+  ROBOCAP_TRACEPOINT(controller_update_start, this);
+  metrics_.update_started();
+
+  Command latest;
+  if (command_buffer_.read(latest) && latest.received_ns >= activated_ns_) {
+    command_ = latest;
+  }
+  robocap_kinematics::Twist<double> target{command_.vx, command_.vy, command_.wz};
+  if (static_cast<double>(time.nanoseconds() - command_.stamp_ns) * 1e-9 > cmd_vel_timeout_) {
+    target = {0.0, 0.0, 0.0};
+  }
+
+  auto wheel_velocities = kinematics.to_wheel_speeds(target);
+  if (max_wheel_velocity_ > 0.0) {
+    // Scale the whole twist rather than clipping wheels individually, which would change direction
+    double peak = 0.0;
+    for (const double velocity : wheel_velocities) {
+      peak = std::max(peak, std::abs(velocity));
+    }
+    if (peak > max_wheel_velocity_) {
+      const double scale = max_wheel_velocity_ / peak;
+      for (double & velocity : wheel_velocities) {
+        velocity *= scale;
+      }
+    }
+  }
+  for (std::size_t i = 0; i < kNumWheels; ++i) {
+    command_interfaces_[command_index_[i]].set_value(wheel_velocities[i]);
+  }
+  metrics_.command_written(command_.sequence, command_.received_ns);
+  ROBOCAP_TRACEPOINT(controller_command, this, command_.sequence);
+
+  robocap_kinematics::WheelSpeeds<double> measured{};
+  for (std::size_t i = 0; i < kNumWheels; ++i) {
+    measured[i] = state_interfaces_[state_index_[i]].get_value();
+  }
+  const auto twist = kinematics.to_twist(measured);
+  const double dt = period.seconds();
+  // Integrate the body velocity at the mid-point heading
+  const double mid_yaw = pose_.yaw + 0.5 * twist.wz * dt;
+  const double cos_yaw = std::cos(mid_yaw);
+  const double sin_yaw = std::sin(mid_yaw);
+  pose_.x += (twist.vx * cos_yaw - twist.vy * sin_yaw) * dt;
+  pose_.y += (twist.vx * sin_yaw + twist.vy * cos_yaw) * dt;
+  pose_.yaw = std::remainder(pose_.yaw + twist.wz * dt, 2.0 * M_PI);
+
+  if (time - last_publish_time_ >= publish_period_) {
+    last_publish_time_ = time;
+    publish_odometry(time, twist.vx, twist.vy, twist.wz);
+  }
+  ROBOCAP_TRACEPOINT(controller_update_end, this);
+  return controller_interface::return_type::OK;
+}
+
+void KiwiDriveController::publish_odometry(
+  const rclcpp::Time & time, double vx, double vy, double wz)
+{
+  const double qz = std::sin(0.5 * pose_.yaw);
+  const double qw = std::cos(0.5 * pose_.yaw);
+
+  if (realtime_odom_publisher_->trylock()) {
+    auto & odom = realtime_odom_publisher_->msg_;
+    odom.header.stamp = time;
+    odom.pose.pose.position.x = pose_.x;
+    odom.pose.pose.position.y = pose_.y;
+    odom.pose.pose.orientation.z = qz;
+    odom.pose.pose.orientation.w = qw;
+    odom.twist.twist.linear.x = vx;
+    odom.twist.twist.linear.y = vy;
+    odom.twist.twist.angular.z = wz;
+    realtime_odom_publisher_->unlockAndPublish();
+  }
+
+  if (realtime_tf_publisher_ && realtime_tf_publisher_->trylock()) {
+    auto & transform = realtime_tf_publisher_->msg_.transforms[0];
+    transform.header.stamp = time;
+    transform.transform.translation.x = pose_.x;
+    transform.transform.translation.y = pose_.y;
+    transform.transform.rotation.z = qz;
+    transform.transform.rotation.w = qw;
+    realtime_tf_publisher_->unlockAndPublish();
+  }
+}
+
+}  // namespace robocap_control
+
+#include "pluginlib/class_list_macros.hpp"
+
+PLUGINLIB_EXPORT_CLASS(
+  robocap_control::KiwiDriveController, controller_interface::ControllerInterface)
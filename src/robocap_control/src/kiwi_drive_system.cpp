@@ -0,0 +1,250 @@
+#include "robocap_control/kiwi_drive_system.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "rclcpp/logging.hpp"
+#include "robocap_control/motor_bus_backend.hpp"
+#include "robocap_tracing/tracing.hpp"
+
+namespace robocap_control
+{
+
+namespace
+{
+
+const rclcpp::Logger kLogger = rclcpp::get_logger("KiwiDriveSystem");
+
+bool has_interface(
+  const std::vector<hardware_interface::InterfaceInfo> & interfaces, const std::string & name)
+{
+  for (const auto & interface : interfaces) {
+    if (interface.name == name) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+KiwiDriveSystem::KiwiDriveSystem(std::unique_ptr<WheelBackend> backend)
+: backend_(std::move(backend))
+{
+}
+
+hardware_interface::CallbackReturn KiwiDriveSystem::on_init(
+  const hardware_interface::HardwareInfo & info)
+{
+  if (hardware_interface::SystemInterface::on_init(info) !=
+    hardware_interface::CallbackReturn::SUCCESS)
+  {
+    return hardware_interface::CallbackReturn::ERROR;
+  }
+
+  if (info_.joints.size() != kNumWheels) {
+    RCLCPP_FATAL(
+      kLogger, "Kiwi drive needs exactly %zu joints, '%s' declares %zu", kNumWheels,
+      info_.name.c_str(), info_.joints.size());
+    return hardware_interface::CallbackReturn::ERROR;
+  }
+
+  for (std::size_t i = 0; i < kNumWheels; ++i) {
+    const auto & joint = info_.joints[i];
+    for (const auto & interface : joint.command_interfaces) {
+      if (interface.name != hardware_interface::HW_IF_VELOCITY &&
+        interface.name != hardware_interface::HW_IF_EFFORT)
+      {
+        RCLCPP_FATAL(
+          kLogger, "Joint '%s' has unsupported command interface '%s'", joint.name.c_str(),
+          interface.name.c_str());
+        return hardware_interface::CallbackReturn::ERROR;
+      }
+    }
+    for (const char * name : {hardware_interface::HW_IF_POSITION,
+        hardware_interface::HW_IF_VELOCITY, hardware_interface::HW_IF_EFFORT})
+    {
+      if (!has_interface(joint.state_interfaces, name)) {
+        RCLCPP_FATAL(
+          kLogger, "Joint '%s' is missing the '%s' state interface", joint.name.c_str(), name);
+        return hardware_interface::CallbackReturn::ERROR;
+      }
+    }
+    joint_names_[i] = joint.name;
+  }
+
+  // GzControlPlugin attaches the simulated wheels, anything else loading this system (e.g.
+  // ros2_control_node on the robot) gets the motor drivers
+  if (!backend_) {
+    try {
+      backend_ = std::make_unique<MotorBusBackend>(
+        MotorBusBackend::parse_config(info_.hardware_parameters));
+    } catch (const std::invalid_argument & e) {
+      RCLCPP_FATAL(
+        kLogger, "Invalid motor bus parameters of '%s': %s", info_.name.c_str(), e.what());
+      return hardware_interface::CallbackReturn::ERROR;
+    }
+  }
+  if (!backend_->configure(joint_names_)) {
+    RCLCPP_FATAL(kLogger, "Failed to configure the wheel backend");
+    return hardware_interface::CallbackReturn::ERROR;
+  }
+  ROBOCAP_TRACEPOINT(component_init, this, info_.name.c_str());
+
+  return hardware_interface::CallbackReturn::SUCCESS;
+}
+
+hardware_interface::CallbackReturn KiwiDriveSystem::on_activate(
+  const rclcpp_lifecycle::State & /*previous_state*/)
+{
+  backend_->read(states_);
+  commands_ = WheelCommands{};
+  return hardware_interface::CallbackReturn::SUCCESS;
+}
+
+hardware_interface::CallbackReturn KiwiDriveSystem::on_deactivate(
+  const rclcpp_lifecycle::State & /*previous_state*/)
+{
+  // Leave the wheels stopped rather than holding the last command
+  commands_.velocity.fill(0.0);
+  commands_.effort.fill(0.0);
+  backend_->write(commands_);
+  return hardware_interface::CallbackReturn::SUCCESS;
+}
+
+std::vector<hardware_interface::StateInterface> KiwiDriveSystem::export_state_interfaces()
+{
+  std::vector<hardware_interface::StateInterface> state_interfaces;
+  state_interfaces.reserve(3 * kNumWheels);
+  for (std::size_t i = 0; i < kNumWheels; ++i) {
+    state_interfaces.emplace_back(
+      joint_names_[i], hardware_interface::HW_IF_POSITION, &states_.position[i]);
+    state_interfaces.emplace_back(
+      joint_names_[i], hardware_interface::HW_IF_VELOCITY, &states_.velocity[i]);
+    state_interfaces.emplace_back(
+      joint_names_[i], hardware_interface::HW_IF_EFFORT, &states_.effort[i]);
+  }
+  return state_interfaces;
+}
+
+std::vector<hardware_interface::CommandInterface> KiwiDriveSystem::export_command_interfaces()
+{
+  std::vector<hardware_interface::CommandInterface> command_interfaces;
+  command_interfaces.reserve(2 * kNumWheels);
+  for (std::size_t i = 0; i < kNumWheels; ++i) {
+    const auto & joint = info_.joints[i];
+    if (has_interface(joint.command_interfaces, hardware_interface::HW_IF_VELOCITY)) {
+      command_interfaces.emplace_back(
+        joint_names_[i], hardware_interface::HW_IF_VELOCITY, &commands_.velocity[i]);
+    }
+    if (has_interface(joint.command_interfaces, hardware_interface::HW_IF_EFFORT)) {
+      command_interfaces.emplace_back(
+        joint_names_[i], hardware_interface::HW_IF_EFFORT, &commands_.effort[i]);
+    }
+  }
+  return command_interfaces;
+}
+
+bool KiwiDriveSystem::apply_mode_switch(
+  const std::vector<std::string> & start_interfaces,
+  const std::vector<std::string> & stop_interfaces,
+  std::array<CommandMode, kNumWheels> & modes) const
+{
+  const auto parse =
+    [this](const std::string & full_name, std::size_t & index, CommandMode & mode) {
+      for (index = 0; index < kNumWheels; ++index) {
+        const auto & joint = joint_names_[index];
+        if (full_name.size() > joint.size() && full_name.compare(0, joint.size(), joint) == 0 &&
+          full_name[joint.size()] == '/')
+        {
+          const auto interface = full_name.substr(joint.size() + 1);
+          if (interface == hardware_interface::HW_IF_VELOCITY) {
+            mode = CommandMode::kVelocity;
+            return true;
+          }
+          if (interface == hardware_interface::HW_IF_EFFORT) {
+            mode = CommandMode::kEffort;
+            return true;
+          }
+        }
+      }
+      return false;
+    };
+
+  std::size_t index;
+  CommandMode mode;
+  for (const auto & name : stop_interfaces) {
+    if (parse(name, index, mode) && modes[index] == mode) {
+      modes[index] = CommandMode::kNone;
+    }
+  }
+
+  std::array<bool, kNumWheels> started{};
+  for (const auto & name : start_interfaces) {
+    if (!parse(name, index, mode)) {
+      continue;  // Belongs to another hardware component
+    }
+    if (started[index] || modes[index] != CommandMode::kNone) {
+      RCLCPP_ERROR(
+        kLogger, "Joint '%s' cannot be commanded through more than one interface",
+        joint_names_[index].c_str());
+      return false;
+    }
+    started[index] = true;
+    modes[index] = mode;
+  }
+  return true;
+}
+
+hardware_interface::return_type KiwiDriveSystem::prepare_command_mode_switch(
+  const std::vector<std::string> & start_interfaces,
+  const std::vector<std::string> & stop_interfaces)
+{
+  auto modes = commands_.mode;
+  return apply_mode_switch(start_interfaces, stop_interfaces, modes) ?
+         hardware_interface::return_type::OK : hardware_interface::return_type::ERROR;
+}
+
+hardware_interface::return_type KiwiDriveSystem::perform_command_mode_switch(
+  const std::vector<std::string> & start_interfaces,
+  const std::vector<std::string> & stop_interfaces)
+{
+  auto modes = commands_.mode;
+  if (!apply_mode_switch(start_interfaces, stop_interfaces, modes)) {
+    return hardware_interface::return_type::ERROR;
+  }
+  for (std::size_t i = 0; i < kNumWheels; ++i) {
+    if (modes[i] != commands_.mode[i]) {
+      // Do not carry a stale command over into the new mode
+      commands_.velocity[i] = 0.0;
+      commands_.effort[i] = 0.0;
+    }
+  }
+  commands_.mode = modes;
+  return hardware_interface::return_type::OK;
+}
+
+hardware_interface::return_type KiwiDriveSystem::read(
+  const rclcpp::Time & /*time*/, const rclcpp::Duration & /*period*/)
+{
+  ROBOCAP_TRACEPOINT(hardware_read_start, this);
+  backend_->read(states_);
+  ROBOCAP_TRACEPOINT(hardware_read_end, this);
+  return hardware_interface::return_type::OK;
+}
+
+hardware_interface::return_type KiwiDriveSystem::write(
+  const rclcpp::Time & /*time*/, const rclcpp::Duration & /*period*/)
+{
+  ROBOCAP_TRACEPOINT(hardware_write_start, this);
+  backend_->write(commands_);
+  ROBOCAP_TRACEPOINT(hardware_write_end, this);
+  return hardware_interface::return_type::OK;
+}
+
+}  // namespace robocap_control
+
+#include "pluginlib/class_list_macros.hpp"
+
+PLUGINLIB_EXPORT_CLASS(robocap_control::KiwiDriveSystem, hardware_interface::SystemInterface)
@@ -0,0 +1,259 @@
+#include "robocap_control/kiwi_mpc_controller.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "rclcpp/qos.hpp"
+#include "robocap_kinematics/robocap_layout.hpp"
+#include "robocap_tracing/tracing.hpp"
+
+namespace robocap_control
+{
+
+namespace
+{
+
+constexpr char kCmdVelTopic[] = "~/cmd_vel";
+
+}  // namespace
+
+controller_interface::CallbackReturn KiwiMpcController::on_init()
+{
+  const KiwiMpcConfig defaults;
+  try {
+    auto_declare<std::vector<std::string>>(
+      "wheel_names", {"wheel_1_joint", "wheel_2_joint", "wheel_3_joint"});
+    auto_declare<double>("cmd_vel_timeout", cmd_vel_timeout_);
+    auto_declare<double>("mpc_rate", mpc_rate_);
+    auto_declare<double>("step", defaults.step);
+    auto_declare<double>("max_wheel_velocity", defaults.max_wheel_velocity);
+    auto_declare<double>("max_linear_acceleration", defaults.max_linear_acceleration);
+    auto_declare<double>("max_angular_acceleration", defaults.max_angular_acceleration);
+    auto_declare<std::vector<double>>(
+      "velocity_weight",
+      std::vector<double>(defaults.velocity_weight.begin(), defaults.velocity_weight.end()));
+    auto_declare<double>("acceleration_weight", defaults.acceleration_weight);
+    auto_declare<double>("jerk_weight", defaults.jerk_weight);
+    auto_declare<double>("solver.rho", defaults.solver.rho);
+    auto_declare<int>("solver.max_iterations", defaults.solver.max_iterations);
+    auto_declare<double>("solver.absolute_tolerance", defaults.solver.absolute_tolerance);
+    auto_declare<double>("solver.relative_tolerance", defaults.solver.relative_tolerance);
+  } catch (const std::exception & e) {
+    RCLCPP_FATAL(get_node()->get_logger(), "Exception during init: %s", e.what());
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+controller_interface::InterfaceConfiguration
+KiwiMpcController::command_interface_configuration() const
+{
+  controller_interface::InterfaceConfiguration config;
+  config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
+  for (const auto & name : wheel_names_) {
+    config.names.push_back(name + "/" + hardware_interface::HW_IF_VELOCITY);
+  }
+  return config;
+}
+
+controller_interface::InterfaceConfiguration
+KiwiMpcController::state_interface_configuration() const
+{
+  controller_interface::InterfaceConfiguration config;
+  config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
+  for (const auto & name : wheel_names_) {
+    config.names.push_back(name + "/" + hardware_interface::HW_IF_VELOCITY);
+  }
+  return config;
+}
+
+controller_interface::CallbackReturn KiwiMpcController::on_configure(
+  const rclcpp_lifecycle::State & /*previous_state*/)
+{
+  const auto node = get_node();
+  const auto wheel_names = node->get_parameter("wheel_names").as_string_array();
+  if (wheel_names.size() != kNumWheels) {
+    // The kinematics are compiled for the robot_core.xacro layout, wheel_1..wheel_3 in order
+    RCLCPP_ERROR(
+      node->get_logger(), "'wheel_names' needs exactly %zu joints, got %zu", kNumWheels,
+      wheel_names.size());
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  std::copy(wheel_names.begin(), wheel_names.end(), wheel_names_.begin());
+  cmd_vel_timeout_ = node->get_parameter("cmd_vel_timeout").as_double();
+  mpc_rate_ = node->get_parameter("mpc_rate").as_double();
+  if (mpc_rate_ <= 0.0) {
+    RCLCPP_ERROR(node->get_logger(), "'mpc_rate' must be positive");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  solve_period_ns_ = static_cast<std::int64_t>(std::round(1e9 / mpc_rate_));
+
+  KiwiMpcConfig config;
+  config.step = node->get_parameter("step").as_double();
+  config.max_wheel_velocity = node->get_parameter("max_wheel_velocity").as_double();
+  config.max_linear_acceleration = node->get_parameter("max_linear_acceleration").as_double();
+  config.max_angular_acceleration = node->get_parameter("max_angular_acceleration").as_double();
+  const auto velocity_weight = node->get_parameter("velocity_weight").as_double_array();
+  if (velocity_weight.size() != config.velocity_weight.size()) {
+    RCLCPP_ERROR(node->get_logger(), "'velocity_weight' needs vx, vy and wz weights");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  std::copy(velocity_weight.begin(), velocity_weight.end(), config.velocity_weight.begin());
+  config.acceleration_weight = node->get_parameter("acceleration_weight").as_double();
+  config.jerk_weight = node->get_parameter("jerk_weight").as_double();
+  config.solver.rho = node->get_parameter("solver.rho").as_double();
+  config.solver.max_iterations =
+    static_cast<int>(node->get_parameter("solver.max_iterations").as_int());
+  config.solver.absolute_tolerance = node->get_parameter("solver.absolute_tolerance").as_double();
+  config.solver.relative_tolerance = node->get_parameter("solver.relative_tolerance").as_double();
+  if (!(config.solver.rho > 0.0) || config.solver.max_iterations <= 0 ||
+    !mpc_.configure(config))
+  {
+    RCLCPP_ERROR(
+      node->get_logger(),
+      "Invalid MPC parameters: step, rho and max_angular_acceleration must be positive, the "
+      "limits and weights non-negative");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  RCLCPP_INFO(
+    node->get_logger(), "MPC over %.2f s at %.0f Hz, linear acceleration within %.3f m/s^2",
+    config.step * KiwiMpc::kHorizon, mpc_rate_, mpc_.linear_acceleration_limit());
+  ROBOCAP_TRACEPOINT(component_init, this, node->get_name());
+
+  cmd_vel_subscriber_ = node->create_subscription<geometry_msgs::msg::Twist>(
+    kCmdVelTopic, rclcpp::SystemDefaultsQoS(),
+    [this](const std::shared_ptr<geometry_msgs::msg::Twist> msg) {
+      const auto sequence = ++cmd_vel_count_;
+      ROBOCAP_TRACEPOINT(cmd_vel_received, this, sequence);
+      command_buffer_.write(
+        Command{
+          msg->linear.x, msg->linear.y, msg->angular.z, get_node()->now().nanoseconds(),
+          robocap_runtime::steady_clock_ns(), sequence});
+    });
+
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+controller_interface::CallbackReturn KiwiMpcController::on_activate(
+  const rclcpp_lifecycle::State & /*previous_state*/)
+{
+  for (std::size_t wheel = 0; wheel < kNumWheels; ++wheel) {
+    bool found_command = false;
+    for (std::size_t i = 0; i < command_interfaces_.size(); ++i) {
+      if (command_interfaces_[i].get_prefix_name() == wheel_names_[wheel]) {
+        command_index_[wheel] = i;
+        found_command = true;
+      }
+    }
+    bool found_state = false;
+    for (std::size_t i = 0; i < state_interfaces_.size(); ++i) {
+      if (state_interfaces_[i].get_prefix_name() == wheel_names_[wheel]) {
+        state_index_[wheel] = i;
+        found_state = true;
+      }
+    }
+    if (!found_command || !found_state) {
+      RCLCPP_ERROR(
+        get_node()->get_logger(), "Interfaces for '%s' were not claimed",
+        wheel_names_[wheel].c_str());
+      return controller_interface::CallbackReturn::ERROR;
+    }
+  }
+
+  // Never resume with a command or a plan from before the deactivation, update() drops what was
+  // received earlier. The subscription stays the buffer's only writer
+  activated_ns_ = robocap_runtime::steady_clock_ns();
+  command_ = Command{};
+  metrics_.activate(get_node()->get_name(), get_update_rate());
+  mpc_.reset();
+  planned_ = false;
+  solves_ = 0;
+  unconverged_solves_ = 0;
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+controller_interface::CallbackReturn KiwiMpcController::on_deactivate(
+  const rclcpp_lifecycle::State & /*previous_state*/)
+{
+  for (auto & interface : command_interfaces_) {
+    interface.set_value(0.0);
+  }
+  if (unconverged_solves_ > 0) {
+    RCLCPP_WARN(
+      get_node()->get_logger(), "%lu of %lu MPC solves stopped at solver.max_iterations",
+      static_cast<unsigned long>(unconverged_solves_), static_cast<unsigned long>(solves_));
+  }
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+controller_interface::return_type KiwiMpcController::update(
+  const rclcpp::Time & time, const rclcpp::Duration & /*period*/)
+{
+  constexpr const auto & kinematics = robocap_kinematics::kRobocapKiwiDrive;
+  ROBOCAP_TRACEPOINT(controller_update_start, this);
+  metrics_.update_started();
+
+  Command latest;
+  if (command_buffer_.read(latest) && latest.received_ns >= activated_ns_) {
+    command_ = latest;
+  }
+  const std::int64_t now_ns = time.nanoseconds();
+  KiwiMpc::Twist target{command_.vx, command_.vy, command_.wz};
+  if (static_cast<double>(now_ns - command_.stamp_ns) * 1e-9 > cmd_vel_timeout_) {
+    target = {0.0, 0.0, 0.0};
+  }
+
+  if (!planned_ || now_ns - last_solve_ns_ >= solve_period_ns_) {
+    robocap_kinematics::WheelSpeeds<double> measured{};
+    for (std::size_t i = 0; i < kNumWheels; ++i) {
+      measured[i] = state_interfaces_[state_index_[i]].get_value();
+    }
+    plan_start_ = kinematics.to_twist(measured);
+    const auto result = mpc_.solve(plan_start_, target);
+    ++solves_;
+    if (!result.converged) {
+      ++unconverged_solves_;
+    }
+    last_solve_ns_ = now_ns;
+    planned_ = true;
+  }
+
+  // Follow the first planned acceleration until the next solve
+  const double elapsed = static_cast<double>(now_ns - last_solve_ns_) * 1e-9;
+  const auto & acceleration = mpc_.acceleration();
+  auto wheel_velocities = kinematics.to_wheel_speeds(
+    KiwiMpc::Twist{
+      plan_start_.vx + acceleration.vx * elapsed, plan_start_.vy + acceleration.vy * elapsed,
+      plan_start_.wz + acceleration.wz * elapsed});
+  // The plan keeps the wheels within the limit at its prediction points only, scale the rest
+  // of the way like KiwiDriveController does
+  const double max_wheel_velocity = mpc_.config().max_wheel_velocity;
+  if (max_wheel_velocity > 0.0) {
+    double peak = 0.0;
+    for (const double velocity : wheel_velocities) {
+      peak = std::max(peak, std::abs(velocity));
+    }
+    if (peak > max_wheel_velocity) {
+      const double scale = max_wheel_velocity / peak;
+      for (double & velocity : wheel_velocities) {
+        velocity *= scale;
+      }
+    }
+  }
+  for (std::size_t i = 0; i < kNumWheels; ++i) {
+    command_interfaces_[command_index_[i]].set_value(wheel_velocities[i]);
+  }
+  metrics_.command_written(command_.sequence, command_.received_ns);
+  ROBOCAP_TRACEPOINT(controller_command, this, command_.sequence);
+  ROBOCAP_TRACEPOINT(controller_update_end, this);
+  return controller_interface::return_type::OK;
+}
+
+}  // namespace robocap_control
+
+#include "pluginlib/class_list_macros.hpp"
+
+PLUGINLIB_EXPORT_CLASS(
+  robocap_control::KiwiMpcController, controller_interface::ControllerInterface)
@@ -0,0 +1,500 @@
+#include "robocap_control/motor_bus_backend.hpp"
+
+#include <fcntl.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include "rclcpp/logging.hpp"
+
+namespace robocap_control
+{
+
+namespace
+{
+
+const rclcpp::Logger kLogger = rclcpp::get_logger("MotorBusBackend");
+
+// Frames taken per recvmmsg() call
+constexpr std::size_t kReceiveBatch = 16;
+
+bool baud_to_speed(int baud_rate, speed_t & speed)
+{
+  switch (baud_rate) {
+    case 115200: speed = B115200; return true;
+    case 230400: speed = B230400; return true;
+    case 460800: speed = B460800; return true;
+    case 500000: speed = B500000; return true;
+    case 921600: speed = B921600; return true;
+    case 1000000: speed = B1000000; return true;
+    case 2000000: speed = B2000000; return true;
+    case 3000000: speed = B3000000; return true;
+    default: return false;
+  }
+}
+
+MotorCommand motor_command(const WheelCommands & commands, std::size_t wheel)
+{
+  MotorCommand command;
+  switch (commands.mode[wheel]) {
+    case CommandMode::kVelocity:
+      command.mode = MotorMode::kVelocity;
+      command.velocity = commands.velocity[wheel];
+      break;
+    case CommandMode::kEffort:
+      command.mode = MotorMode::kEffort;
+      command.effort = commands.effort[wheel];
+      break;
+    case CommandMode::kNone:
+      break;
+  }
+  return command;
+}
+
+}  // namespace
+
+MotorBusBackend::Config MotorBusBackend::parse_config(
+  const std::unordered_map<std::string, std::string> & parameters)
+{
+  const auto value = [&parameters](const char * key, const char * fallback) {
+      const auto it = parameters.find(key);
+      return it == parameters.end() ? std::string(fallback) : it->second;
+    };
+
+  Config config;
+  const auto transport = value("transport", "can");
+  if (transport == "can") {
+    config.transport = Transport::kCan;
+  } else if (transport == "serial") {
+    config.transport = Transport::kSerial;
+  } else {
+    throw std::invalid_argument("'transport' must be can or serial, not '" + transport + "'");
+  }
+
+  config.device = value("device", "can0");
+  if (config.device.empty() ||
+    (config.transport == Transport::kCan && config.device.size() >= IFNAMSIZ))
+  {
+    throw std::invalid_argument("'device' must name a CAN interface or a serial device");
+  }
+
+  const auto baud_rate = value("baud_rate", "1000000");
+  speed_t speed;
+  try {
+    config.baud_rate = std::stoi(baud_rate);
+  } catch (const std::exception &) {
+    config.baud_rate = 0;
+  }
+  if (!baud_to_speed(config.baud_rate, speed)) {
+    throw std::invalid_argument("'baud_rate' " + baud_rate + " is not a supported serial speed");
+  }
+
+  std::istringstream ids(value("motor_ids", "1,2,3"));
+  std::string id;
+  std::size_t count = 0;
+  while (std::getline(ids, id, ',')) {
+    int number = 0;
+    try {
+      number = std::stoi(id);
+    } catch (const std::exception &) {
+    }
+    if (count == kNumWheels || number < 1 || number > kMaxMotorId) {
+      throw std::invalid_argument(
+              "'motor_ids' must be " + std::to_string(kNumWheels) + " ids in [1, " +
+              std::to_string(kMaxMotorId) + "]");
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+      if (config.motor_ids[i] == number) {
+        throw std::invalid_argument("'motor_ids' lists motor " + id + " twice");
+      }
+    }
+    config.motor_ids[count++] = static_cast<std::uint8_t>(number);
+  }
+  if (count != kNumWheels) {
+    throw std::invalid_argument("'motor_ids' must list " + std::to_string(kNumWheels) + " ids");
+  }
+  return config;
+}
+
+MotorBusBackend::MotorBusBackend(Config config)
+: config_(std::move(config))
+{
+  wheel_of_motor_.fill(-1);
+  for (std::size_t i = 0; i < kNumWheels; ++i) {
+    wheel_of_motor_[config_.motor_ids[i]] = static_cast<int>(i);
+  }
+  auto & registry = robocap_runtime::MetricsRegistry::global();
+  const robocap_runtime::Labels labels{{"device", config_.device}};
+  dropped_commands_ = &registry.counter(
+    "robocap_motor_bus_commands_dropped_total",
+    "Wheel command batches the motor bus thread did not take or could not send", labels);
+  bad_frames_ = &registry.counter(
+    "robocap_motor_bus_bad_frames_total", "Motor feedback frames that failed to parse", labels);
+}
+
+MotorBusBackend::~MotorBusBackend()
+{
+  if (thread_.joinable()) {
+    // Coast rather than leave the drivers on their last set-point
+    commands_.push(WheelCommands{});
+    running_.store(false, std::memory_order_release);
+    const std::uint64_t one = 1;
+    [[maybe_unused]] const auto written = ::write(wake_fd_, &one, sizeof(one));
+    thread_.join();
+  }
+  for (const int fd : {device_fd_, epoll_fd_, wake_fd_}) {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+}
+
+bool MotorBusBackend::open_can()
+{
+  device_fd_ = ::socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, CAN_RAW);
+  if (device_fd_ < 0) {
+    RCLCPP_FATAL(kLogger, "Cannot open a CAN socket: %s", std::strerror(errno));
+    return false;
+  }
+  ifreq request{};
+  std::strncpy(request.ifr_name, config_.device.c_str(), IFNAMSIZ - 1);
+  if (::ioctl(device_fd_, SIOCGIFINDEX, &request) < 0) {
+    RCLCPP_FATAL(
+      kLogger, "No CAN interface '%s': %s", config_.device.c_str(), std::strerror(errno));
+    return false;
+  }
+  sockaddr_can address{};
+  address.can_family = AF_CAN;
+  address.can_ifindex = request.ifr_ifindex;
+  if (::bind(device_fd_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+    RCLCPP_FATAL(kLogger, "Cannot bind to '%s': %s", config_.device.c_str(), std::strerror(errno));
+    return false;
+  }
+  // Only our drivers' feedback, the kernel drops the rest of the bus traffic
+  std::array<can_filter, kNumWheels> filters;
+  for (std::size_t i = 0; i < kNumWheels; ++i) {
+    filters[i].can_id = kCanFeedbackBase + config_.motor_ids[i];
+    filters[i].can_mask = CAN_SFF_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG;
+  }
+  if (::setsockopt(
+      device_fd_, SOL_CAN_RAW, CAN_RAW_FILTER, filters.data(), sizeof(filters)) < 0)
+  {
+    RCLCPP_FATAL(kLogger, "Cannot set the CAN filters: %s", std::strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+bool MotorBusBackend::open_serial()
+{
+  device_fd_ = ::open(config_.device.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if (device_fd_ < 0) {
+    RCLCPP_FATAL(kLogger, "Cannot open '%s': %s", config_.device.c_str(), std::strerror(errno));
+    return false;
+  }
+  termios options{};
+  speed_t speed = B1000000;
+  baud_to_speed(config_.baud_rate, speed);
+  if (::tcgetattr(device_fd_, &options) < 0) {
+    RCLCPP_FATAL(
+      kLogger, "'%s' is not a serial device: %s", config_.device.c_str(), std::strerror(errno));
+    return false;
+  }
+  ::cfmakeraw(&options);
+  options.c_cflag |= CLOCAL | CREAD;
+  options.c_cc[VMIN] = 0;
+  options.c_cc[VTIME] = 0;
+  if (::cfsetspeed(&options, speed) < 0 || ::tcsetattr(device_fd_, TCSANOW, &options) < 0) {
+    RCLCPP_FATAL(
+      kLogger, "Cannot set '%s' to %d baud: %s", config_.device.c_str(), config_.baud_rate,
+      std::strerror(errno));
+    return false;
+  }
+  ::tcflush(device_fd_, TCIOFLUSH);
+  return true;
+}
+
+bool MotorBusBackend::configure(const std::array<std::string, kNumWheels> & joint_names)
+{
+  if (!(config_.transport == Transport::kCan ? open_can() : open_serial())) {
+    return false;
+  }
+  wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+  epoll_event wake{};
+  wake.events = EPOLLIN;
+  wake.data.fd = wake_fd_;
+  epoll_event device{};
+  device.events = EPOLLIN;
+  device.data.fd = device_fd_;
+  if (wake_fd_ < 0 || epoll_fd_ < 0 ||
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &wake) < 0 ||
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, device_fd_, &device) < 0)
+  {
+    RCLCPP_FATAL(kLogger, "Cannot set up epoll: %s", std::strerror(errno));
+    return false;
+  }
+
+  running_.store(true, std::memory_order_release);
+  thread_ = std::thread([this]() {run();});
+  for (std::size_t i = 0; i < kNumWheels; ++i) {
+    RCLCPP_INFO(
+      kLogger, "%s: motor %u on %s", joint_names[i].c_str(), config_.motor_ids[i],
+      config_.device.c_str());
+  }
+  return true;
+}
+
+void MotorBusBackend::read(WheelStates & states)
+{
+  Feedback feedback;
+  while (feedback_.pop(feedback)) {
+    const auto i = feedback.wheel;
+    const auto raw = feedback.data.position_raw;
+    if (have_position_[i]) {
+      states_.position[i] += unwrap_position(last_position_raw_[i], raw);
+    } else {
+      states_.position[i] = unwrap_position(0, raw);
+      have_position_[i] = true;
+    }
+    last_position_raw_[i] = raw;
+    states_.velocity[i] = feedback.data.velocity;
+    states_.effort[i] = feedback.data.effort;
+  }
+  states = states_;
+}
+
+void MotorBusBackend::write(const WheelCommands & commands)
+{
+  if (!commands_.push(commands)) {
+    dropped_commands_->add();
+    return;
+  }
+  const std::uint64_t one = 1;
+  [[maybe_unused]] const auto written = ::write(wake_fd_, &one, sizeof(one));
+}
+
+void MotorBusBackend::run()
+{
+  std::array<epoll_event, 2> events;
+  while (running_.load(std::memory_order_acquire)) {
+    const int count = ::epoll_wait(epoll_fd_, events.data(), events.size(), -1);
+    if (count < 0 && errno != EINTR) {
+      RCLCPP_ERROR(kLogger, "epoll_wait failed: %s", std::strerror(errno));
+      return;
+    }
+    for (int e = 0; e < count; ++e) {
+      if (events[e].data.fd == wake_fd_) {
+        std::uint64_t wakes;
+        [[maybe_unused]] const auto taken = ::read(wake_fd_, &wakes, sizeof(wakes));
+        // Only the newest batch is worth sending
+        while (commands_.pop(next_)) {
+          have_next_ = true;
+        }
+        flush();
+        continue;
+      }
+      if (events[e].events & EPOLLIN) {
+        config_.transport == Transport::kCan ? receive_can() : receive_serial();
+      }
+      if (events[e].events & EPOLLOUT) {
+        flush();
+      }
+      if (events[e].events & (EPOLLERR | EPOLLHUP)) {
+        RCLCPP_ERROR(kLogger, "Lost '%s', stopping the motor bus", config_.device.c_str());
+        return;
+      }
+    }
+  }
+}
+
+void MotorBusBackend::flush()
+{
+  while (true) {
+    if (tx_sent_ == tx_size_) {
+      if (!have_next_) {
+        wait_writable(false);
+        return;
+      }
+      have_next_ = false;
+      for (std::size_t i = 0; i < kNumWheels; ++i) {
+        tx_payloads_[i] = encode_command(motor_command(next_, i));
+        write_serial_frame(
+          config_.motor_ids[i], tx_payloads_[i], tx_bytes_.data() + i * kSerialFrameSize);
+      }
+      tx_size_ = config_.transport == Transport::kCan ? kNumWheels : tx_bytes_.size();
+      tx_sent_ = 0;
+    }
+    if (!(config_.transport == Transport::kCan ? send_can() : send_serial())) {
+      return;
+    }
+  }
+}
+
+bool MotorBusBackend::send_can()
+{
+  std::array<can_frame, kNumWheels> frames{};
+  std::array<iovec, kNumWheels> vectors;
+  std::array<mmsghdr, kNumWheels> messages{};
+  const std::size_t count = tx_size_ - tx_sent_;
+  for (std::size_t f = 0; f < count; ++f) {
+    const std::size_t i = tx_sent_ + f;
+    frames[f].can_id = kCanCommandBase + config_.motor_ids[i];
+    frames[f].can_dlc = kMotorPayloadSize;
+    std::memcpy(frames[f].data, tx_payloads_[i].data(), kMotorPayloadSize);
+    vectors[f] = {&frames[f], sizeof(can_frame)};
+    messages[f].msg_hdr.msg_iov = &vectors[f];
+    messages[f].msg_hdr.msg_iovlen = 1;
+  }
+  const int sent = ::sendmmsg(device_fd_, messages.data(), static_cast<unsigned int>(count), 0);
+  if (sent > 0) {
+    tx_sent_ += static_cast<std::size_t>(sent);
+    tx_failing_ = false;
+    return true;
+  }
+  if (errno == EAGAIN || errno == EWOULDBLOCK) {
+    wait_writable(true);
+    return false;
+  }
+  // ENOBUFS is a full transmit queue, e.g. with the drivers unpowered: SocketCAN never reports
+  // the socket writable again for it, so drop the batch, a fresher one follows within a period
+  if (!tx_failing_) {
+    RCLCPP_ERROR(
+      kLogger, "Cannot send on '%s': %s", config_.device.c_str(), std::strerror(errno));
+  }
+  tx_failing_ = true;
+  tx_sent_ = tx_size_;
+  dropped_commands_->add();
+  return true;
+}
+
+bool MotorBusBackend::send_serial()
+{
+  const auto sent = ::write(device_fd_, tx_bytes_.data() + tx_sent_, tx_size_ - tx_sent_);
+  if (sent >= 0) {
+    // A partial write resumes mid-frame once the line drains, so the framing stays intact
+    tx_sent_ += static_cast<std::size_t>(sent);
+    tx_failing_ = false;
+    if (tx_sent_ < tx_size_) {
+      wait_writable(true);
+      return false;
+    }
+    return true;
+  }
+  if (errno == EAGAIN || errno == EWOULDBLOCK) {
+    wait_writable(true);
+    return false;
+  }
+  if (!tx_failing_) {
+    RCLCPP_ERROR(
+      kLogger, "Cannot write to '%s': %s", config_.device.c_str(), std::strerror(errno));
+  }
+  tx_failing_ = true;
+  if (tx_sent_ == 0) {
+    tx_sent_ = tx_size_;  // Nothing of it went out, drop it whole
+    dropped_commands_->add();
+    return true;
+  }
+  wait_writable(true);
+  return false;
+}
+
+void MotorBusBackend::wait_writable(bool wait)
+{
+  if (wait == waiting_writable_) {
+    return;
+  }
+  epoll_event device{};
+  device.events = wait ? EPOLLIN | EPOLLOUT : EPOLLIN;
+  device.data.fd = device_fd_;
+  ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, device_fd_, &device);
+  waiting_writable_ = wait;
+}
+
+void MotorBusBackend::receive_can()
+{
+  std::array<can_frame, kReceiveBatch> frames;
+  std::array<iovec, kReceiveBatch> vectors;
+  std::array<mmsghdr, kReceiveBatch> messages{};
+  for (std::size_t f = 0; f < kReceiveBatch; ++f) {
+    vectors[f] = {&frames[f], sizeof(can_frame)};
+    messages[f].msg_hdr.msg_iov = &vectors[f];
+    messages[f].msg_hdr.msg_iovlen = 1;
+  }
+  int received;
+  do {
+    received = ::recvmmsg(device_fd_, messages.data(), kReceiveBatch, MSG_DONTWAIT, nullptr);
+    for (int f = 0; f < received; ++f) {
+      const auto & frame = frames[f];
+      const auto id = frame.can_id & CAN_SFF_MASK;
+      if (messages[f].msg_len != sizeof(can_frame) || frame.can_dlc != kMotorPayloadSize ||
+        id <= kCanFeedbackBase || id > kCanFeedbackBase + kMaxMotorId)
+      {
+        bad_frames_->add();
+        continue;
+      }
+      MotorPayload payload;
+      std::memcpy(payload.data(), frame.data, kMotorPayloadSize);
+      take_feedback(static_cast<std::uint8_t>(id - kCanFeedbackBase), payload);
+    }
+  } while (received == static_cast<int>(kReceiveBatch));
+}
+
+void MotorBusBackend::receive_serial()
+{
+  while (true) {
+    const auto count =
+      ::read(device_fd_, rx_bytes_.data() + rx_size_, rx_bytes_.size() - rx_size_);
+    if (count <= 0) {
+      return;
+    }
+    rx_size_ += static_cast<std::size_t>(count);
+
+    std::size_t offset = 0;
+    std::size_t consumed;
+    std::uint8_t id;
+    MotorPayload payload;
+    std::uint64_t rejected = 0;
+    while (read_serial_frame(
+        rx_bytes_.data() + offset, rx_size_ - offset, consumed, id, payload, rejected))
+    {
+      offset += consumed;
+      if ((id & kSerialFeedbackFlag) == 0) {
+        ++rejected;  // Our own commands echoed, or another master on the line
+        continue;
+      }
+      take_feedback(static_cast<std::uint8_t>(id & ~kSerialFeedbackFlag), payload);
+    }
+    offset += consumed;
+    if (rejected > 0) {
+      bad_frames_->add(rejected);
+    }
+    // Keep the start of a partial frame for the next read
+    rx_size_ -= offset;
+    std::memmove(rx_bytes_.data(), rx_bytes_.data() + offset, rx_size_);
+  }
+}
+
+void MotorBusBackend::take_feedback(std::uint8_t motor_id, const MotorPayload & payload)
+{
+  const int wheel = motor_id <= kMaxMotorId ? wheel_of_motor_[motor_id] : -1;
+  if (wheel < 0) {
+    return;
+  }
+  // Full only when nothing calls read(), e.g. before activation: such frames are stale anyway
+  feedback_.push({static_cast<std::size_t>(wheel), decode_feedback(payload)});
+}
+
+}  // namespace robocap_control
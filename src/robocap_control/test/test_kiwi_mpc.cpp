@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "Eigen/Core"
+
+#include "robocap_control/admm_qp.hpp"
+#include "robocap_control/kiwi_mpc.hpp"
+
+namespace
+{
+
+using robocap_control::AdmmQp;
+using robocap_control::AdmmQpSettings;
+using robocap_control::KiwiMpc;
+using robocap_control::KiwiMpcConfig;
+
+// minimize 1/2 x'Px + q'x subject to x1 + x2 = 1, 0 <= x1, x2 <= 0.7. The KKT conditions hold at
+// x = (0.3, 0.7): the equality's multiplier is -2.9 and x2's upper bound carries 0.2
+struct SmallQp
+{
+  using Solver = AdmmQp<2, 3>;
+
+  SmallQp()
+  {
+    p << 4.0, 1.0,
+      1.0, 2.0;
+    a << 1.0, 1.0,
+      1.0, 0.0,
+      0.0, 1.0;
+    q << 1.0, 1.0;
+    lower << 1.0, 0.0, 0.0;
+    upper << 1.0, 0.7, 0.7;
+    settings.absolute_tolerance = 1e-6;
+    settings.relative_tolerance = 1e-6;
+    settings.max_iterations = 5000;
+  }
+
+  Solver::Hessian p;
+  Solver::ConstraintMatrix a;
+  Solver::Vector q;
+  Solver::ConstraintVector lower;
+  Solver::ConstraintVector upper;
+  AdmmQpSettings settings;
+};
+
+TEST(AdmmQp, MatchesTheKktSolution)
+{
+  SmallQp qp;
+  SmallQp::Solver solver;
+  ASSERT_TRUE(solver.setup(qp.p, qp.a, qp.settings));
+  const auto result = solver.solve(qp.q, qp.lower, qp.upper);
+  EXPECT_TRUE(result.converged);
+  EXPECT_NEAR(solver.x()(0), 0.3, 1e-4);
+  EXPECT_NEAR(solver.x()(1), 0.7, 1e-4);
+  // y holds the multipliers of A's rows
+  EXPECT_NEAR(solver.y()(0), -2.9, 1e-3);
+  EXPECT_NEAR(solver.y()(1), 0.0, 1e-3);
+  EXPECT_NEAR(solver.y()(2), 0.2, 1e-3);
+}
+
+TEST(AdmmQp, RejectsAnIndefiniteHessian)
+{
+  SmallQp qp;
+  qp.p << -4.0, 0.0,
+    0.0, 2.0;
+  qp.a.setZero();  // Nothing for rho A'A to make up for
+  SmallQp::Solver solver;
+  EXPECT_FALSE(solver.setup(qp.p, qp.a, qp.settings));
+}
+
+TEST(AdmmQp, WarmStartConvergesInFewerIterations)
+{
+  SmallQp qp;
+  SmallQp::Solver solver;
+  ASSERT_TRUE(solver.setup(qp.p, qp.a, qp.settings));
+  ASSERT_TRUE(solver.solve(qp.q, qp.lower, qp.upper).converged);
+
+  // A nearby problem, as the next control cycle poses it
+  SmallQp::Solver::Vector q = qp.q;
+  q(0) += 0.05;
+  const auto warm = solver.solve(q, qp.lower, qp.upper);
+  const SmallQp::Solver::Vector warm_x = solver.x();
+  solver.reset();
+  const auto cold = solver.solve(q, qp.lower, qp.upper);
+  EXPECT_TRUE(warm.converged);
+  EXPECT_TRUE(cold.converged);
+  EXPECT_LT(warm.iterations, cold.iterations);
+  EXPECT_NEAR((warm_x - solver.x()).lpNorm<Eigen::Infinity>(), 0.0, 1e-4);
+}
+
+Eigen::Matrix3d inverse_matrix()
+{
+  const auto & inverse = robocap_kinematics::kRobocapKiwiDrive.inverse_matrix();
+  Eigen::Matrix3d matrix;
+  for (int wheel = 0; wheel < 3; ++wheel) {
+    for (int axis = 0; axis < 3; ++axis) {
+      matrix(wheel, axis) = inverse[wheel][axis];
+    }
+  }
+  return matrix;
+}
+
+TEST(KiwiMpc, RejectsInvalidConfig)
+{
+  KiwiMpc mpc;
+  KiwiMpcConfig config;
+  config.step = 0.0;
+  EXPECT_FALSE(mpc.configure(config));
+  config = KiwiMpcConfig{};
+  config.jerk_weight = -1.0;
+  EXPECT_FALSE(mpc.configure(config));
+}
+
+// Following the plan one step at a time towards a twist far beyond the wheels' reach, every
+// predicted wheel velocity stays within the limit, up to the solver's tolerance
+TEST(KiwiMpc, KeepsEveryWheelWithinItsLimit)
+{
+  KiwiMpcConfig config;
+  config.max_wheel_velocity = 10.0;
+  KiwiMpc mpc;
+  ASSERT_TRUE(mpc.configure(config));
+  const Eigen::Matrix3d inverse = inverse_matrix();
+  const double tolerance = 0.02 * config.max_wheel_velocity;
+
+  KiwiMpc::Twist twist{0.0, 0.0, 0.0};
+  const KiwiMpc::Twist target{5.0, 3.0, 4.0};
+  double peak = 0.0;
+  for (int cycle = 0; cycle < 200; ++cycle) {
+    mpc.solve(twist, target);
+    const auto & acceleration = mpc.acceleration();
+    EXPECT_LE(std::abs(acceleration.wz), config.max_angular_acceleration + 1e-9);
+    twist = KiwiMpc::Twist{
+      twist.vx + config.step * acceleration.vx, twist.vy + config.step * acceleration.vy,
+      twist.wz + config.step * acceleration.wz};
+    const Eigen::Vector3d wheels = inverse * Eigen::Vector3d(twist.vx, twist.vy, twist.wz);
+    peak = std::max(peak, wheels.lpNorm<Eigen::Infinity>());
+    ASSERT_LE(wheels.lpNorm<Eigen::Infinity>(), config.max_wheel_velocity + tolerance) <<
+      "cycle " << cycle;
+  }
+  // It did drive the wheels up to the limit, the bound is what held them back
+  EXPECT_GT(peak, 0.9 * config.max_wheel_velocity);
+}
+
+TEST(KiwiMpc, TracksAReachableTargetWithinTheTippingLimit)
+{
+  KiwiMpc mpc;
+  ASSERT_TRUE(mpc.configure(KiwiMpcConfig{}));
+  const double step = mpc.config().step;
+  KiwiMpc::Twist twist{0.0, 0.0, 0.0};
+  const KiwiMpc::Twist target{0.5, 0.0, 0.0};
+  for (int cycle = 0; cycle < 200; ++cycle) {
+    mpc.solve(twist, target);
+    const auto & acceleration = mpc.acceleration();
+    EXPECT_LE(
+      std::hypot(acceleration.vx - twist.wz * twist.vy, acceleration.vy + twist.wz * twist.vx),
+      mpc.linear_acceleration_limit() + 1e-9);
+    twist = KiwiMpc::Twist{
+      twist.vx + step * acceleration.vx, twist.vy + step * acceleration.vy,
+      twist.wz + step * acceleration.wz};
+  }
+  EXPECT_NEAR(twist.vx, 0.5, 0.02);
+  EXPECT_NEAR(twist.vy, 0.0, 0.02);
+  EXPECT_NEAR(twist.wz, 0.0, 0.02);
+}
+
+}  // namespace
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "robocap_control/motor_protocol.hpp"
+
+namespace
+{
+
+using namespace robocap_control;  // NOLINT(build/namespaces)
+
+std::vector<std::uint8_t> frame(std::uint8_t id, const MotorPayload & payload)
+{
+  std::vector<std::uint8_t> bytes(kSerialFrameSize);
+  write_serial_frame(id, payload, bytes.data());
+  return bytes;
+}
+
+// Every frame read_serial_frame() finds in `stream`, as the backends call it
+std::vector<std::uint8_t> read_ids(
+  const std::vector<std::uint8_t> & stream, std::uint64_t & rejected, std::size_t & offset)
+{
+  std::vector<std::uint8_t> ids;
+  std::size_t consumed = 0;
+  std::uint8_t id = 0;
+  MotorPayload payload{};
+  offset = 0;
+  while (read_serial_frame(
+      stream.data() + offset, stream.size() - offset, consumed, id, payload, rejected))
+  {
+    offset += consumed;
+    ids.push_back(id);
+  }
+  offset += consumed;
+  return ids;
+}
+
+TEST(MotorProtocol, CommandRoundTrips)
+{
+  MotorCommand command;
+  command.mode = MotorMode::kVelocity;
+  command.velocity = -12.345;
+  command.effort = 1.5;
+  const auto decoded = decode_command(encode_command(command));
+  EXPECT_EQ(decoded.mode, MotorMode::kVelocity);
+  EXPECT_NEAR(decoded.velocity, -12.345, 1e-3);
+  EXPECT_NEAR(decoded.effort, 1.5, 1e-3);
+}
+
+TEST(MotorProtocol, CommandSaturates)
+{
+  MotorCommand command;
+  command.mode = MotorMode::kEffort;
+  command.effort = 1e6;  // Beyond i16 mNm
+  const auto payload = encode_command(command);
+  EXPECT_NEAR(decode_command(payload).effort, 32.767, 1e-9);
+  // Little-endian on the wire
+  EXPECT_EQ(payload[2], 0xFF);
+  EXPECT_EQ(payload[3], 0x7F);
+}
+
+TEST(MotorProtocol, FeedbackRoundTrips)
+{
+  MotorFeedback feedback;
+  feedback.position_raw = position_to_raw(-3.2);
+  feedback.velocity = -25.5;
+  feedback.effort = -0.75;
+  const auto decoded = decode_feedback(encode_feedback(feedback));
+  EXPECT_EQ(decoded.position_raw, feedback.position_raw);
+  EXPECT_NEAR(decoded.velocity, -25.5, 1e-2);
+  EXPECT_NEAR(decoded.effort, -0.75, 1e-3);
+}
+
+TEST(MotorProtocol, UnwrapsAcrossTheRawRange)
+{
+  EXPECT_NEAR(unwrap_position(position_to_raw(0.0), position_to_raw(-3.2)), -3.2, 1e-4);
+  // 1296 ticks forward through the wrap
+  EXPECT_NEAR(unwrap_position(2147483000, -2147483000), 0.1296, 1e-9);
+  EXPECT_NEAR(unwrap_position(-2147483000, 2147483000), -0.1296, 1e-9);
+}
+
+TEST(MotorProtocol, ReadsConsecutiveFrames)
+{
+  MotorFeedback feedback;
+  feedback.velocity = 1.0;
+  std::vector<std::uint8_t> stream;
+  for (std::uint8_t id : {0x81, 0x82, 0x83}) {
+    const auto bytes = frame(id, encode_feedback(feedback));
+    stream.insert(stream.end(), bytes.begin(), bytes.end());
+  }
+  std::uint64_t rejected = 0;
+  std::size_t offset = 0;
+  EXPECT_EQ(read_ids(stream, rejected, offset), (std::vector<std::uint8_t>{0x81, 0x82, 0x83}));
+  EXPECT_EQ(rejected, 0u);
+  EXPECT_EQ(offset, stream.size());
+}
+
+TEST(MotorProtocol, SkipsNoiseAndResynchronizesAfterABadCrc)
+{
+  MotorFeedback feedback;
+  feedback.position_raw = 0x00A500A5;  // Sync bytes inside the payload
+  std::vector<std::uint8_t> stream = {0x12, kSerialSync, 0x34};
+  for (std::uint8_t id : {0x81, 0x82, 0x83}) {
+    const auto bytes = frame(id, encode_feedback(feedback));
+    stream.insert(stream.end(), bytes.begin(), bytes.end());
+  }
+  stream[3 + kSerialFrameSize + 5] ^= 0x01;  // Corrupts the second frame's payload
+
+  std::uint64_t rejected = 0;
+  std::size_t offset = 0;
+  EXPECT_EQ(read_ids(stream, rejected, offset), (std::vector<std::uint8_t>{0x81, 0x83}));
+  EXPECT_GE(rejected, 1u);
+  EXPECT_EQ(offset, stream.size());
+}
+
+TEST(MotorProtocol, LeavesAPartialFrameForTheNextRead)
+{
+  const auto bytes = frame(0x01, encode_command(MotorCommand{}));
+  std::vector<std::uint8_t> stream = {0x00, 0x00};
+  stream.insert(stream.end(), bytes.begin(), bytes.begin() + 5);
+
+  std::size_t consumed = 0;
+  std::uint8_t id = 0;
+  MotorPayload payload{};
+  std::uint64_t rejected = 0;
+  EXPECT_FALSE(
+    read_serial_frame(stream.data(), stream.size(), consumed, id, payload, rejected));
+  EXPECT_EQ(consumed, 2u);  // The noise, not the start of the frame
+  EXPECT_EQ(rejected, 0u);
+
+  // The rest arrives
+  stream.erase(stream.begin(), stream.begin() + static_cast<std::ptrdiff_t>(consumed));
+  stream.insert(stream.end(), bytes.begin() + 5, bytes.end());
+  ASSERT_TRUE(read_serial_frame(stream.data(), stream.size(), consumed, id, payload, rejected));
+  EXPECT_EQ(id, 0x01);
+  EXPECT_EQ(consumed, kSerialFrameSize);
+  EXPECT_EQ(decode_command(payload).mode, MotorMode::kCoast);
+}
+
+}  // namespace
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <thread>
+
+#include "robocap_control/spsc_ring.hpp"
+
+namespace
+{
+
+using robocap_control::SpscRing;
+
+TEST(SpscRing, PopsInPushOrder)
+{
+  SpscRing<int, 4> ring;
+  int value = 0;
+  EXPECT_FALSE(ring.pop(value));
+  EXPECT_TRUE(ring.push(1));
+  EXPECT_TRUE(ring.push(2));
+  EXPECT_TRUE(ring.pop(value));
+  EXPECT_EQ(value, 1);
+  EXPECT_TRUE(ring.pop(value));
+  EXPECT_EQ(value, 2);
+  EXPECT_FALSE(ring.pop(value));
+}
+
+TEST(SpscRing, RejectsPushWhenFullAndAcceptsAfterPop)
+{
+  SpscRing<int, 4> ring;
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(ring.push(i));
+  }
+  EXPECT_FALSE(ring.push(4));
+
+  int value = -1;
+  EXPECT_TRUE(ring.pop(value));
+  EXPECT_EQ(value, 0);
+  EXPECT_TRUE(ring.push(4));
+  EXPECT_FALSE(ring.push(5));
+  for (int i = 1; i <= 4; ++i) {
+    EXPECT_TRUE(ring.pop(value));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_FALSE(ring.pop(value));
+}
+
+TEST(SpscRing, WrapsAroundManyTimes)
+{
+  SpscRing<std::uint64_t, 8> ring;
+  std::uint64_t value = 0;
+  for (std::uint64_t i = 0; i < 1000; ++i) {
+    ASSERT_TRUE(ring.push(i));
+    ASSERT_TRUE(ring.push(i + 1));
+    ASSERT_TRUE(ring.pop(value));
+    EXPECT_EQ(value, i);
+    ASSERT_TRUE(ring.pop(value));
+    EXPECT_EQ(value, i + 1);
+  }
+}
+
+// A producer and a consumer thread through a small ring: every value arrives, once, in order
+TEST(SpscRing, ConcurrentTransferKeepsEveryValueInOrder)
+{
+  constexpr std::uint64_t kValues = 200000;
+  SpscRing<std::uint64_t, 8> ring;
+  std::thread producer([&] {
+      for (std::uint64_t i = 1; i <= kValues; ) {
+        if (ring.push(i)) {
+          ++i;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+
+  std::uint64_t expected = 1;
+  bool in_order = true;
+  std::uint64_t value = 0;
+  while (expected <= kValues) {
+    if (ring.pop(value)) {
+      in_order = in_order && value == expected;
+      ++expected;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  EXPECT_TRUE(in_order);
+  EXPECT_FALSE(ring.pop(value));
+}
+
+}  // namespace
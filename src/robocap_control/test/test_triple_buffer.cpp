@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "robocap_control/triple_buffer.hpp"
+
+namespace
+{
+
+using robocap_control::TripleBuffer;
+
+TEST(TripleBuffer, ReadsTheInitialValueUntilAWrite)
+{
+  TripleBuffer<int> buffer(7);
+  int value = 0;
+  EXPECT_FALSE(buffer.read(value));
+  EXPECT_EQ(value, 7);
+
+  buffer.write(8);
+  EXPECT_TRUE(buffer.read(value));
+  EXPECT_EQ(value, 8);
+}
+
+TEST(TripleBuffer, ReadIsFreshOncePerWriteAndKeepsTheLatest)
+{
+  TripleBuffer<int> buffer;
+  buffer.write(1);
+  buffer.write(2);
+  buffer.write(3);
+  int value = 0;
+  EXPECT_TRUE(buffer.read(value));
+  EXPECT_EQ(value, 3);
+
+  // Not fresh any more, but still the latest value
+  value = 0;
+  EXPECT_FALSE(buffer.read(value));
+  EXPECT_EQ(value, 3);
+}
+
+TEST(TripleBuffer, EveryWriteAfterARead)
+{
+  TripleBuffer<int> buffer;
+  int value = 0;
+  for (int i = 1; i <= 10; ++i) {
+    buffer.write(i);
+    EXPECT_TRUE(buffer.read(value));
+    EXPECT_EQ(value, i);
+  }
+}
+
+// One writer and one reader thread: the reader never sees a torn value and never goes back in
+// time, and it ends on the last value written
+TEST(TripleBuffer, ConcurrentReadsAreCompleteAndInOrder)
+{
+  struct Sample
+  {
+    std::uint64_t sequence;
+    std::uint64_t check;  // ~sequence, a torn copy does not match
+  };
+  constexpr std::uint64_t kWrites = 100000;
+  TripleBuffer<Sample> buffer(Sample{0, ~0ull});
+  std::atomic<bool> done{false};
+
+  std::thread writer([&] {
+      for (std::uint64_t i = 1; i <= kWrites; ++i) {
+        buffer.write(Sample{i, ~i});
+        if (i % 64 == 0) {
+          std::this_thread::yield();
+        }
+      }
+      done = true;
+    });
+
+  std::uint64_t last = 0;
+  bool torn = false;
+  bool backwards = false;
+  Sample sample{};
+  while (!done.load() || last < kWrites) {
+    if (buffer.read(sample)) {
+      torn = torn || sample.check != ~sample.sequence;
+      backwards = backwards || sample.sequence <= last;
+      last = sample.sequence;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  writer.join();
+  EXPECT_FALSE(torn);
+  EXPECT_FALSE(backwards);
+  EXPECT_EQ(last, kWrites);
+}
+
+}  // namespace
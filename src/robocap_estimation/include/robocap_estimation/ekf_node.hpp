@@ -0,0 +1,85 @@
+#ifndef ROBOCAP_ESTIMATION__EKF_NODE_HPP_
+#define ROBOCAP_ESTIMATION__EKF_NODE_HPP_
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "geometry_msgs/msg/pose_with_covariance_stamped.hpp"
+#include "nav_msgs/msg/odometry.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "sensor_msgs/msg/imu.hpp"
+#include "sensor_msgs/msg/joint_state.hpp"
+#include "tf2_msgs/msg/tf_message.hpp"
+
+#include "robocap_estimation/kiwi_ekf.hpp"
+#include "robocap_kinematics/kiwi_drive.hpp"
+#include "robocap_runtime/metrics.hpp"
+
+namespace robocap_estimation
+{
+
+// Odometry from a KiwiEkf fed by joint_states and imu, published on "odom" and /tf.
+//
+// Each measurement is applied in the callback that receives it, after predicting up to its
+// stamp, and the estimate goes out from that same callback, so the latency is one filter step and
+// not a timer period. The messages are preallocated and only their values change afterwards.
+// joint_states, the one message here with sequences, is taken into a robocap_runtime::MessagePool,
+// so receiving it does not allocate either. All subscriptions share the node's default, mutually
+// exclusive callback group. The age of every imu and joint_states message on arrival is recorded
+// as robocap_message_age_seconds.
+//
+// With fuse_pose the filter also takes absolute fixes on "pose", e.g. from ScanLocalizer, and
+// its estimate lives in their frame: the first fix moves it there, so odom_frame_id should name
+// the map. Like the other measurements, a fix older than the filter is fused at the filter's time.
+//
+// Parameters:
+//   wheel_names      joints in kinematics order, defaults to wheel_1_joint..wheel_3_joint
+//   odom_frame_id    defaults to odom
+//   base_frame_id    defaults to base_link
+//   publish_rate     [Hz] upper bound on odometry rate, defaults to 0 (every measurement)
+//   publish_tf       odom -> base_link on /tf, defaults to true
+//   fuse_pose        subscribe to PoseWithCovarianceStamped fixes on "pose", defaults to false
+//   noise.*          KiwiEkfNoise fields
+class EkfNode : public rclcpp::Node
+{
+public:
+  explicit EkfNode(const rclcpp::NodeOptions & options);
+
+private:
+  void on_imu(const sensor_msgs::msg::Imu & imu);
+  void on_joint_state(const sensor_msgs::msg::JointState & joint_state);
+  void on_pose(const geometry_msgs::msg::PoseWithCovarianceStamped & pose);
+  // Predicts up to `stamp` with the last IMU acceleration. Measurements older than the filter are
+  // fused at the filter's time instead
+  void advance(std::int64_t stamp_ns);
+  void publish(std::int64_t stamp_ns);
+
+  std::array<std::string, robocap_kinematics::kNumWheels> wheel_names_;
+  // Positions of wheel_names_ in the last joint_states name list
+  std::array<std::size_t, robocap_kinematics::kNumWheels> wheel_index_{};
+  bool wheel_index_valid_ = false;
+  std::int64_t publish_period_ns_ = 0;
+  std::int64_t last_publish_ns_ = 0;
+
+  KiwiEkf ekf_;
+  bool initialized_ = false;
+  bool has_fix_ = false;
+  std::int64_t filter_time_ns_ = 0;
+  double ax_ = 0.0;
+  double ay_ = 0.0;
+
+  nav_msgs::msg::Odometry odom_;
+  tf2_msgs::msg::TFMessage tf_;
+  robocap_runtime::Histogram * imu_age_ = nullptr;
+  robocap_runtime::Histogram * joint_state_age_ = nullptr;
+  rclcpp::Publisher<nav_msgs::msg::Odometry>::SharedPtr odom_publisher_;
+  rclcpp::Publisher<tf2_msgs::msg::TFMessage>::SharedPtr tf_publisher_;
+  rclcpp::Subscription<sensor_msgs::msg::Imu>::SharedPtr imu_subscription_;
+  rclcpp::Subscription<sensor_msgs::msg::JointState>::SharedPtr joint_state_subscription_;
+  rclcpp::Subscription<geometry_msgs::msg::PoseWithCovarianceStamped>::SharedPtr pose_subscription_;
+};
+
+}  // namespace robocap_estimation
+
+#endif  // ROBOCAP_ESTIMATION__EKF_NODE_HPP_
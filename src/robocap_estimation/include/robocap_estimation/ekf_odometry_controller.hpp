@@ -0,0 +1,78 @@
+#ifndef ROBOCAP_ESTIMATION__EKF_ODOMETRY_CONTROLLER_HPP_
+#define ROBOCAP_ESTIMATION__EKF_ODOMETRY_CONTROLLER_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "controller_interface/controller_interface.hpp"
+#include "nav_msgs/msg/odometry.hpp"
+#include "rclcpp/subscription.hpp"
+#include "rclcpp_lifecycle/state.hpp"
+#include "realtime_tools/realtime_publisher.hpp"
+#include "sensor_msgs/msg/imu.hpp"
+#include "tf2_msgs/msg/tf_message.hpp"
+
+#include "robocap_control/triple_buffer.hpp"
+#include "robocap_estimation/kiwi_ekf.hpp"
+#include "robocap_kinematics/kiwi_drive.hpp"
+
+namespace robocap_estimation
+{
+
+// KiwiEkf inside the controller manager: reads the wheel velocity state interfaces directly in
+// update(), so there is no joint_states round trip, and takes the latest IMU sample from a
+// wait-free TripleBuffer filled by the subscription. Claims no command interfaces, so it runs next
+// to KiwiDriveController. Odometry and TF go out through realtime_tools::RealtimePublisher.
+//
+// Parameters match EkfNode, plus imu_topic (defaults to /imu) and publish_rate defaulting to 100.
+class EkfOdometryController : public controller_interface::ControllerInterface
+{
+public:
+  EkfOdometryController() = default;
+
+  controller_interface::InterfaceConfiguration command_interface_configuration() const override;
+  controller_interface::InterfaceConfiguration state_interface_configuration() const override;
+
+  controller_interface::CallbackReturn on_init() override;
+  controller_interface::CallbackReturn on_configure(const rclcpp_lifecycle::State & previous_state)
+  override;
+  controller_interface::CallbackReturn on_activate(const rclcpp_lifecycle::State & previous_state)
+  override;
+
+  controller_interface::return_type update(
+    const rclcpp::Time & time, const rclcpp::Duration & period) override;
+
+private:
+  struct ImuSample
+  {
+    double ax;
+    double ay;
+    double wz;
+  };
+
+  std::array<std::string, robocap_kinematics::kNumWheels> wheel_names_;
+  std::array<std::size_t, robocap_kinematics::kNumWheels> state_index_{};
+  rclcpp::Duration publish_period_{0, 0};
+  rclcpp::Time last_publish_time_{0, 0, RCL_ROS_TIME};
+
+  // Constructed in on_configure, once the noise parameters are known
+  std::optional<KiwiEkf> ekf_;
+  robocap_control::TripleBuffer<ImuSample> imu_buffer_;
+  ImuSample imu_{};
+
+  rclcpp::Subscription<sensor_msgs::msg::Imu>::SharedPtr imu_subscriber_;
+  std::shared_ptr<rclcpp::Publisher<nav_msgs::msg::Odometry>> odom_publisher_;
+  std::unique_ptr<realtime_tools::RealtimePublisher<nav_msgs::msg::Odometry>>
+  realtime_odom_publisher_;
+  std::shared_ptr<rclcpp::Publisher<tf2_msgs::msg::TFMessage>> tf_publisher_;
+  std::unique_ptr<realtime_tools::RealtimePublisher<tf2_msgs::msg::TFMessage>>
+  realtime_tf_publisher_;
+};
+
+}  // namespace robocap_estimation
+
+#endif  // ROBOCAP_ESTIMATION__EKF_ODOMETRY_CONTROLLER_HPP_
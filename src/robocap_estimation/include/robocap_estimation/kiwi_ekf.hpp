@@ -0,0 +1,200 @@
+#ifndef ROBOCAP_ESTIMATION__KIWI_EKF_HPP_
+#define ROBOCAP_ESTIMATION__KIWI_EKF_HPP_
+
+#include <cmath>
+
+#include "Eigen/Core"
+#include "Eigen/LU"
+
+#include "robocap_kinematics/kiwi_drive.hpp"
+
+namespace robocap_estimation
+{
+
+// Standard deviations for KiwiEkf. The process terms are densities, integrated over each
+// prediction
+struct KiwiEkfNoise
+{
+  double acceleration = 1.0;           // [m/s^2/sqrt(s)]
+  double angular_acceleration = 4.0;   // [rad/s^2/sqrt(s)]
+  double gyro_bias_drift = 1e-3;       // [rad/s/sqrt(s)]
+  double wheel_velocity = 0.2;         // [rad/s], includes roller slip
+  double gyro = 0.01;                  // [rad/s]
+};
+
+// Planar extended Kalman filter for the kiwi drive, fusing the three wheel joint velocities with
+// an IMU. Every matrix is fixed-size, so nothing here allocates and one predict plus one update is
+// a few hundred flops.
+//
+// State, with the velocities in base_link:
+//   x, y, yaw     pose in odom [m, m, rad]
+//   vx, vy, wz    body twist [m/s, m/s, rad/s]
+//   gyro_bias     z gyro bias [rad/s]
+//
+// The IMU's planar acceleration drives the prediction, its z rate and the wheel velocities are
+// the measurements. Both measurement models are linear in the state, only the prediction needs a
+// Jacobian.
+class KiwiEkf
+{
+public:
+  static constexpr int kStates = 7;
+  using StateVector = Eigen::Matrix<double, kStates, 1>;
+  using StateMatrix = Eigen::Matrix<double, kStates, kStates>;
+
+  enum Index : int
+  {
+    kX = 0,
+    kY,
+    kYaw,
+    kVx,
+    kVy,
+    kWz,
+    kGyroBias,
+  };
+
+  // `inverse_kinematics` maps the body twist to wheel joint velocities, see KiwiDrive
+  explicit KiwiEkf(
+    const robocap_kinematics::Matrix3 & inverse_kinematics,
+    const KiwiEkfNoise & noise = KiwiEkfNoise())
+  : noise_(noise)
+  {
+    wheel_jacobian_.setZero();
+    for (int wheel = 0; wheel < 3; ++wheel) {
+      for (int axis = 0; axis < 3; ++axis) {
+        wheel_jacobian_(wheel, kVx + axis) = inverse_kinematics[wheel][axis];
+      }
+    }
+    wheel_noise_ = Eigen::Matrix3d::Identity() * (noise.wheel_velocity * noise.wheel_velocity);
+    reset();
+  }
+
+  void reset()
+  {
+    state_.setZero();
+    covariance_.setZero();
+    // Start certain of the odom origin, unsure of the twist and the bias
+    covariance_.diagonal() << 1e-9, 1e-9, 1e-9, 1.0, 1.0, 1.0, 1e-4;
+  }
+
+  // Advances the state by dt seconds under body-frame acceleration (ax, ay), gravity removed
+  void predict(double dt, double ax, double ay)
+  {
+    if (dt <= 0.0) {
+      return;
+    }
+    const double yaw = state_(kYaw);
+    const double vx = state_(kVx);
+    const double vy = state_(kVy);
+    const double wz = state_(kWz);
+    const double c = std::cos(yaw);
+    const double s = std::sin(yaw);
+
+    state_(kX) += (vx * c - vy * s) * dt;
+    state_(kY) += (vx * s + vy * c) * dt;
+    state_(kYaw) = std::remainder(yaw + wz * dt, 2.0 * M_PI);
+    // d/dt of a body-frame velocity picks up the rotation of the frame itself
+    state_(kVx) += (ax + wz * vy) * dt;
+    state_(kVy) += (ay - wz * vx) * dt;
+
+    StateMatrix f = StateMatrix::Identity();
+    f(kX, kYaw) = -(vx * s + vy * c) * dt;
+    f(kX, kVx) = c * dt;
+    f(kX, kVy) = -s * dt;
+    f(kY, kYaw) = (vx * c - vy * s) * dt;
+    f(kY, kVx) = s * dt;
+    f(kY, kVy) = c * dt;
+    f(kYaw, kWz) = dt;
+    f(kVx, kVy) = wz * dt;
+    f(kVx, kWz) = vy * dt;
+    f(kVy, kVx) = -wz * dt;
+    f(kVy, kWz) = -vx * dt;
+
+    StateMatrix propagated;
+    propagated.noalias() = f * covariance_ * f.transpose();
+    covariance_ = propagated;
+    const double a = noise_.acceleration * noise_.acceleration * dt;
+    covariance_(kVx, kVx) += a;
+    covariance_(kVy, kVy) += a;
+    covariance_(kWz, kWz) += noise_.angular_acceleration * noise_.angular_acceleration * dt;
+    covariance_(kGyroBias, kGyroBias) += noise_.gyro_bias_drift * noise_.gyro_bias_drift * dt;
+  }
+
+  // Wheel joint velocities [rad/s], in kinematics order
+  void update_wheels(const robocap_kinematics::WheelSpeeds<double> & speeds)
+  {
+    const Eigen::Vector3d measured(speeds[0], speeds[1], speeds[2]);
+    const Eigen::Vector3d residual = measured - wheel_jacobian_ * state_;
+    correct<3>(residual, wheel_jacobian_, wheel_noise_);
+  }
+
+  // IMU z angular velocity [rad/s]
+  void update_gyro(double wz)
+  {
+    Eigen::Matrix<double, 1, kStates> h = Eigen::Matrix<double, 1, kStates>::Zero();
+    h(0, kWz) = 1.0;
+    h(0, kGyroBias) = 1.0;
+    const Eigen::Matrix<double, 1, 1> residual(wz - state_(kWz) - state_(kGyroBias));
+    const Eigen::Matrix<double, 1, 1> noise(noise_.gyro * noise_.gyro);
+    correct<1>(residual, h, noise);
+  }
+
+  // Absolute x, y, yaw, e.g. a ScanMatcher fix in a map, with their covariance
+  void update_pose(double x, double y, double yaw, const Eigen::Matrix3d & covariance)
+  {
+    Eigen::Matrix<double, 3, kStates> h = Eigen::Matrix<double, 3, kStates>::Zero();
+    h(0, kX) = 1.0;
+    h(1, kY) = 1.0;
+    h(2, kYaw) = 1.0;
+    const Eigen::Vector3d residual(
+      x - state_(kX), y - state_(kY), std::remainder(yaw - state_(kYaw), 2.0 * M_PI));
+    correct<3>(residual, h, covariance);
+  }
+
+  // Replaces the pose and its uncertainty and keeps the twist and bias. For the first fix, which
+  // the filter's near-certain odom origin would otherwise all but ignore
+  void set_pose(double x, double y, double yaw, const Eigen::Matrix3d & covariance)
+  {
+    state_(kX) = x;
+    state_(kY) = y;
+    state_(kYaw) = std::remainder(yaw, 2.0 * M_PI);
+    covariance_.topRows<3>().setZero();
+    covariance_.leftCols<3>().setZero();
+    covariance_.topLeftCorner<3, 3>() = covariance;
+  }
+
+  const StateVector & state() const {return state_;}
+  const StateMatrix & covariance() const {return covariance_;}
+
+private:
+  template<int Rows>
+  void correct(
+    const Eigen::Matrix<double, Rows, 1> & residual,
+    const Eigen::Matrix<double, Rows, kStates> & h,
+    const Eigen::Matrix<double, Rows, Rows> & noise)
+  {
+    const Eigen::Matrix<double, kStates, Rows> ph = covariance_ * h.transpose();
+    const Eigen::Matrix<double, Rows, Rows> innovation = h * ph + noise;
+    // Fixed-size inverse up to 4x4 is closed form
+    const Eigen::Matrix<double, kStates, Rows> gain = ph * innovation.inverse();
+    state_.noalias() += gain * residual;
+    state_(kYaw) = std::remainder(state_(kYaw), 2.0 * M_PI);
+
+    // Joseph form keeps the covariance symmetric positive definite in floating point
+    StateMatrix i_kh = StateMatrix::Identity();
+    i_kh.noalias() -= gain * h;
+    StateMatrix updated;
+    updated.noalias() = i_kh * covariance_ * i_kh.transpose();
+    updated.noalias() += gain * noise * gain.transpose();
+    covariance_ = updated;
+  }
+
+  KiwiEkfNoise noise_;
+  StateVector state_;
+  StateMatrix covariance_;
+  Eigen::Matrix<double, 3, kStates> wheel_jacobian_;
+  Eigen::Matrix3d wheel_noise_;
+};
+
+}  // namespace robocap_estimation
+
+#endif  // ROBOCAP_ESTIMATION__KIWI_EKF_HPP_
@@ -0,0 +1,70 @@
+#ifndef ROBOCAP_ESTIMATION__ODOMETRY_HPP_
+#define ROBOCAP_ESTIMATION__ODOMETRY_HPP_
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <initializer_list>
+
+#include "geometry_msgs/msg/transform.hpp"
+#include "nav_msgs/msg/odometry.hpp"
+
+#include "robocap_estimation/kiwi_ekf.hpp"
+
+namespace robocap_estimation
+{
+
+// Variance reported for the axes a planar filter does not estimate
+constexpr double kPlanarVariance = 1e-6;
+
+// Copies the estimate into `odom` without touching the header or child frame. Only overwrites
+// values, so a preallocated message never reallocates
+inline void fill_odometry(const KiwiEkf & ekf, nav_msgs::msg::Odometry & odom)
+{
+  const auto & state = ekf.state();
+  const auto & covariance = ekf.covariance();
+  odom.pose.pose.position.x = state(KiwiEkf::kX);
+  odom.pose.pose.position.y = state(KiwiEkf::kY);
+  odom.pose.pose.position.z = 0.0;
+  odom.pose.pose.orientation.x = 0.0;
+  odom.pose.pose.orientation.y = 0.0;
+  odom.pose.pose.orientation.z = std::sin(0.5 * state(KiwiEkf::kYaw));
+  odom.pose.pose.orientation.w = std::cos(0.5 * state(KiwiEkf::kYaw));
+  odom.twist.twist.linear.x = state(KiwiEkf::kVx);
+  odom.twist.twist.linear.y = state(KiwiEkf::kVy);
+  odom.twist.twist.linear.z = 0.0;
+  odom.twist.twist.angular.x = 0.0;
+  odom.twist.twist.angular.y = 0.0;
+  odom.twist.twist.angular.z = state(KiwiEkf::kWz);
+
+  // Row-major 6x6 over (x, y, z, roll, pitch, yaw) and (vx, vy, vz, wx, wy, wz)
+  constexpr std::array<int, 3> kPlanarAxes{0, 1, 5};
+  constexpr std::array<int, 3> kPoseStates{KiwiEkf::kX, KiwiEkf::kY, KiwiEkf::kYaw};
+  constexpr std::array<int, 3> kTwistStates{KiwiEkf::kVx, KiwiEkf::kVy, KiwiEkf::kWz};
+  odom.pose.covariance.fill(0.0);
+  odom.twist.covariance.fill(0.0);
+  for (const int axis : {2, 3, 4}) {
+    odom.pose.covariance[7 * axis] = kPlanarVariance;
+    odom.twist.covariance[7 * axis] = kPlanarVariance;
+  }
+  for (std::size_t row = 0; row < 3; ++row) {
+    for (std::size_t col = 0; col < 3; ++col) {
+      const auto index = 6 * kPlanarAxes[row] + kPlanarAxes[col];
+      odom.pose.covariance[index] = covariance(kPoseStates[row], kPoseStates[col]);
+      odom.twist.covariance[index] = covariance(kTwistStates[row], kTwistStates[col]);
+    }
+  }
+}
+
+inline void fill_transform(
+  const nav_msgs::msg::Odometry & odom, geometry_msgs::msg::Transform & transform)
+{
+  transform.translation.x = odom.pose.pose.position.x;
+  transform.translation.y = odom.pose.pose.position.y;
+  transform.translation.z = odom.pose.pose.position.z;
+  transform.rotation = odom.pose.pose.orientation;
+}
+
+}  // namespace robocap_estimation
+
+#endif  // ROBOCAP_ESTIMATION__ODOMETRY_HPP_
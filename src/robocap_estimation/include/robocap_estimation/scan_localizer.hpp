@@ -0,0 +1,94 @@
+#ifndef ROBOCAP_ESTIMATION__SCAN_LOCALIZER_HPP_
+#define ROBOCAP_ESTIMATION__SCAN_LOCALIZER_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "geometry_msgs/msg/pose_with_covariance_stamped.hpp"
+#include "nav_msgs/msg/occupancy_grid.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "sensor_msgs/msg/laser_scan.hpp"
+#include "tf2_ros/buffer.h"
+#include "tf2_ros/transform_listener.h"
+
+#include "robocap_estimation/scan_matcher.hpp"
+#include "robocap_perception/point_cloud.hpp"
+#include "robocap_perception/point_filters.hpp"
+#include "robocap_perception/thread_pool.hpp"
+#include "robocap_runtime/metrics.hpp"
+
+namespace robocap_estimation
+{
+
+// Localization in a known "map" by correlative scan matching of "scan", in place of AMCL's
+// particle cloud. Until it has a fix, and again after lost_after failed matches, every scan is
+// searched against the whole map; after that only a window around the pose extrapolated from the
+// last two fixes. Fixes go out on "pose" in the map's frame for EkfNode's fuse_pose, and
+// "initialpose" (e.g. RViz's 2D Pose Estimate) skips the global search.
+//
+// The scan goes through robocap_perception's filters into base_frame, with the laser's mounting
+// looked up once per frame id, so the map is matched in 2D against base_frame's pose. Each scan's
+// age on arrival goes to robocap_message_age_seconds.
+//
+// Parameters:
+//   base_frame        pose being estimated, defaults to base_link
+//   likelihood_sigma  [m] spread of the likelihood field around obstacles, defaults to 0.1
+//   levels            branch-and-bound pyramid levels, defaults to 7 (128 cells)
+//   threads           scoring threads including the callback's, 0 = one per core, defaults to 1
+//   linear_window     [m] tracking search each way, defaults to 0.3
+//   angular_window    [rad] tracking search each way, defaults to 0.35
+//   min_score         mean likelihood for a tracking fix, defaults to 0.5
+//   global_min_score  the same for a fix out of a whole map search, defaults to 0.65
+//   lost_after        failed tracking matches before searching globally again, defaults to 10
+class ScanLocalizer : public rclcpp::Node
+{
+public:
+  explicit ScanLocalizer(const rclcpp::NodeOptions & options);
+
+private:
+  void on_map(const nav_msgs::msg::OccupancyGrid & map);
+  void on_scan(const sensor_msgs::msg::LaserScan & scan);
+  void on_initial_pose(const geometry_msgs::msg::PoseWithCovarianceStamped & pose);
+  // Laser mounting for `frame_id` into transform_filter_, false until TF has it
+  bool update_mounting(const std::string & frame_id);
+  void publish(const ScanMatch & match, const rclcpp::Time & stamp);
+
+  std::string base_frame_;
+  double sigma_;
+  int levels_;
+  ScanMatcherOptions tracking_;
+  double global_min_score_;
+  int lost_after_;
+
+  robocap_perception::ThreadPool pool_;
+  std::unique_ptr<LikelihoodField> field_;
+  std::unique_ptr<ScanMatcher> matcher_;
+
+  robocap_perception::PointCloud cloud_;
+  robocap_perception::ScanProjector projector_;
+  robocap_perception::FilterChain chain_;
+  robocap_perception::RangeFilter * range_filter_ = nullptr;
+  robocap_perception::TransformFilter * transform_filter_ = nullptr;
+  std::string laser_frame_;
+  robocap_runtime::Histogram * scan_age_ = nullptr;
+
+  bool localized_ = false;
+  int failures_ = 0;
+  Pose2 pose_;
+  Pose2 velocity_;  // [m/s, m/s, rad/s] in the map, between the last two fixes
+  std::int64_t pose_stamp_ns_ = 0;
+
+  geometry_msgs::msg::PoseWithCovarianceStamped fix_;
+  std::unique_ptr<tf2_ros::Buffer> tf_buffer_;
+  std::unique_ptr<tf2_ros::TransformListener> tf_listener_;
+  rclcpp::Publisher<geometry_msgs::msg::PoseWithCovarianceStamped>::SharedPtr publisher_;
+  rclcpp::Subscription<nav_msgs::msg::OccupancyGrid>::SharedPtr map_subscription_;
+  rclcpp::Subscription<sensor_msgs::msg::LaserScan>::SharedPtr scan_subscription_;
+  rclcpp::Subscription<geometry_msgs::msg::PoseWithCovarianceStamped>::SharedPtr
+    initial_pose_subscription_;
+};
+
+}  // namespace robocap_estimation
+
+#endif  // ROBOCAP_ESTIMATION__SCAN_LOCALIZER_HPP_
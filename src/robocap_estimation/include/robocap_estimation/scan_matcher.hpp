@@ -0,0 +1,164 @@
+#ifndef ROBOCAP_ESTIMATION__SCAN_MATCHER_HPP_
+#define ROBOCAP_ESTIMATION__SCAN_MATCHER_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Eigen/Core"
+
+#include "robocap_perception/thread_pool.hpp"
+
+namespace robocap_estimation
+{
+
+struct Pose2
+{
+  double x = 0.0;    // [m]
+  double y = 0.0;    // [m]
+  double yaw = 0.0;  // [rad]
+};
+
+// Likelihood of a range return at every cell of an occupancy map, exp(-d^2 / 2 sigma^2) of the
+// distance to the nearest occupied cell quantized to 0..255, plus the branch-and-bound pyramid on
+// top of it: level h holds the maximum over the 2^h x 2^h cells starting at each cell, so one
+// lookup bounds the score of every translation in that square.
+//
+// Every level is stored in 8x8 tiles of one cache line each. Consecutive beams of a scan land in
+// neighbouring cells, so scoring a candidate pose mostly walks lines that are already loaded,
+// where a row-major grid would touch a new line per row crossed.
+class LikelihoodField
+{
+public:
+  static constexpr int kTileSize = 8;
+
+  // `occupancy` is a nav_msgs/OccupancyGrid's data: row-major from the origin, 0..100 with -1 for
+  // unknown. Cells from `occupied_threshold` up are obstacles, unknown ones are free. `levels`
+  // counts the full resolution field
+  LikelihoodField(
+    const std::int8_t * occupancy, int width, int height, double resolution, double origin_x,
+    double origin_y, double sigma, int levels, int occupied_threshold = 65);
+
+  int width() const {return width_;}
+  int height() const {return height_;}
+  double resolution() const {return resolution_;}
+  double origin_x() const {return origin_x_;}
+  double origin_y() const {return origin_y_;}
+  int levels() const {return static_cast<int>(levels_.size());}
+
+  // Level `level` at cell (x, y), 0 outside the map
+  std::uint8_t at(int level, std::int32_t x, std::int32_t y) const
+  {
+    const auto & grid = levels_[static_cast<std::size_t>(level)];
+    const auto u = static_cast<std::uint32_t>(x - grid.x0);
+    const auto v = static_cast<std::uint32_t>(y - grid.y0);
+    if (u >= grid.width || v >= grid.height) {
+      return 0;
+    }
+    return grid.tiles[(v / kTileSize) * grid.tiles_x + u / kTileSize]
+           .cells[(v % kTileSize) * kTileSize + u % kTileSize];
+  }
+
+  // Sum of level `level` over the cells (x[i] + dx, y[i] + dy)
+  std::uint32_t score(
+    int level, const std::int32_t * x, const std::int32_t * y, std::size_t count,
+    std::int32_t dx, std::int32_t dy) const;
+
+private:
+  struct alignas(64) Tile
+  {
+    std::array<std::uint8_t, kTileSize * kTileSize> cells;
+  };
+
+  struct Level
+  {
+    // Cell of the first stored column and row. Coarser levels reach 2^h - 1 cells below the map,
+    // where a square still overlaps it
+    std::int32_t x0;
+    std::int32_t y0;
+    std::uint32_t width;   // In cells, whole tiles
+    std::uint32_t height;
+    std::size_t tiles_x;
+    std::vector<Tile> tiles;
+  };
+
+  static Level tile(const std::vector<std::uint8_t> & cells, int width, int height, int offset);
+
+  int width_;
+  int height_;
+  double resolution_;
+  double origin_x_;
+  double origin_y_;
+  std::vector<Level> levels_;
+};
+
+struct ScanMatcherOptions
+{
+  double linear_window = 0.3;    // [m] searched each way around the prior
+  double angular_window = 0.35;  // [rad] each way, from pi up the whole circle
+  double angular_step = 0.0;     // [rad], 0 picks one cell of motion at the farthest point
+  double min_score = 0.5;        // Mean likelihood a match needs, 0..1
+  int refine_iterations = 10;    // Gauss-Newton steps on the interpolated field, 0 disables
+};
+
+struct ScanMatch
+{
+  bool valid = false;
+  Pose2 pose;
+  double score = 0.0;  // Mean likelihood at `pose`, 0..1
+  // Of x, y, yaw, from the refinement's Gauss-Newton Hessian
+  Eigen::Matrix3d covariance = Eigen::Matrix3d::Identity();
+};
+
+// Correlative scan matcher (Olson; Hess et al., "Real-time loop closure in 2D LIDAR SLAM"): the
+// exhaustive search over a window of poses, done by branch and bound over the LikelihoodField's
+// pyramid, then refined off the grid by Gauss-Newton on the bilinearly interpolated field.
+//
+// Each angle of the window is discretized into integer cell offsets once, after which scoring a
+// translation is only table lookups. The coarse candidates of all angles are scored and searched
+// in parallel on `pool`, best first, sharing the best score found so far for pruning. Buffers
+// grow to the largest search seen and are reused afterwards.
+class ScanMatcher
+{
+public:
+  // Neither `field` nor `pool` is owned. Without a pool everything runs on the caller's thread
+  explicit ScanMatcher(
+    const LikelihoodField & field, robocap_perception::ThreadPool * pool = nullptr);
+
+  // Points relative to the pose being estimated, e.g. a scan in base_link
+  ScanMatch match(
+    const float * x, const float * y, std::size_t count, const Pose2 & prior,
+    const ScanMatcherOptions & options);
+
+private:
+  struct Candidate
+  {
+    std::uint32_t score;
+    std::int32_t angle;
+    std::int32_t x;
+    std::int32_t y;
+  };
+
+  template<typename Body>
+  void parallel_for(std::size_t count, std::size_t chunk, Body && body);
+  void search(const Candidate & candidate, int level, std::int32_t window, std::size_t worker);
+  Pose2 refine(
+    const float * x, const float * y, std::size_t count, Pose2 pose, int iterations,
+    double & score, Eigen::Matrix3d & covariance) const;
+
+  const LikelihoodField & field_;
+  robocap_perception::ThreadPool * pool_;
+  std::size_t count_ = 0;
+  // [angle][point] cell of each point at the window's centre
+  std::vector<std::int32_t> cell_x_;
+  std::vector<std::int32_t> cell_y_;
+  std::vector<Candidate> candidates_;
+  std::vector<Candidate> best_;  // Per worker
+  std::atomic<std::uint32_t> best_score_{0};
+};
+
+}  // namespace robocap_estimation
+
+#endif  // ROBOCAP_ESTIMATION__SCAN_MATCHER_HPP_
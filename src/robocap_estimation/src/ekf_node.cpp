@@ -0,0 +1,214 @@
+#include "robocap_estimation/ekf_node.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "robocap_estimation/odometry.hpp"
+#include "robocap_kinematics/robocap_layout.hpp"
+#include "robocap_runtime/message_pool.hpp"
+#include "robocap_tracing/tracing.hpp"
+
+namespace robocap_estimation
+{
+
+namespace
+{
+
+// Longest prediction step. A larger gap (paused sim, dropped messages) is bridged without
+// integrating a stale acceleration over it
+constexpr std::int64_t kMaxPredictNs = 100'000'000;
+
+// joint_states messages in flight at once: the one being handled plus the queue
+constexpr std::size_t kJointStatePoolSize = 8;
+
+KiwiEkfNoise declare_noise(rclcpp::Node & node)
+{
+  KiwiEkfNoise noise;
+  noise.acceleration = node.declare_parameter("noise.acceleration", noise.acceleration);
+  noise.angular_acceleration =
+    node.declare_parameter("noise.angular_acceleration", noise.angular_acceleration);
+  noise.gyro_bias_drift = node.declare_parameter("noise.gyro_bias_drift", noise.gyro_bias_drift);
+  noise.wheel_velocity = node.declare_parameter("noise.wheel_velocity", noise.wheel_velocity);
+  noise.gyro = node.declare_parameter("noise.gyro", noise.gyro);
+  return noise;
+}
+
+}  // namespace
+
+EkfNode::EkfNode(const rclcpp::NodeOptions & options)
+: rclcpp::Node("ekf", options),
+  ekf_(robocap_kinematics::kRobocapKiwiDrive.inverse_matrix(), declare_noise(*this))
+{
+  const auto wheel_names = declare_parameter<std::vector<std::string>>(
+    "wheel_names", {"wheel_1_joint", "wheel_2_joint", "wheel_3_joint"});
+  if (wheel_names.size() != robocap_kinematics::kNumWheels) {
+    throw std::invalid_argument("'wheel_names' needs exactly three joints");
+  }
+  std::copy(wheel_names.begin(), wheel_names.end(), wheel_names_.begin());
+  const auto odom_frame_id = declare_parameter<std::string>("odom_frame_id", "odom");
+  const auto base_frame_id = declare_parameter<std::string>("base_frame_id", "base_link");
+  const auto publish_rate = declare_parameter<double>("publish_rate", 0.0);
+  const auto publish_tf = declare_parameter<bool>("publish_tf", true);
+  const auto fuse_pose = declare_parameter<bool>("fuse_pose", false);
+  if (publish_rate > 0.0) {
+    publish_period_ns_ = static_cast<std::int64_t>(1e9 / publish_rate);
+  }
+
+  odom_.header.frame_id = odom_frame_id;
+  odom_.child_frame_id = base_frame_id;
+  odom_publisher_ =
+    create_publisher<nav_msgs::msg::Odometry>("odom", rclcpp::SystemDefaultsQoS());
+  if (publish_tf) {
+    tf_.transforms.resize(1);
+    tf_.transforms[0].header.frame_id = odom_frame_id;
+    tf_.transforms[0].child_frame_id = base_frame_id;
+    tf_publisher_ =
+      create_publisher<tf2_msgs::msg::TFMessage>("/tf", rclcpp::SystemDefaultsQoS());
+  }
+
+  imu_subscription_ = create_subscription<sensor_msgs::msg::Imu>(
+    "imu", rclcpp::SensorDataQoS(),
+    [this](const sensor_msgs::msg::Imu::ConstSharedPtr msg) {on_imu(*msg);});
+  joint_state_subscription_ = create_subscription<sensor_msgs::msg::JointState>(
+    "joint_states", rclcpp::SensorDataQoS(),
+    [this](const sensor_msgs::msg::JointState::ConstSharedPtr msg) {on_joint_state(*msg);},
+    rclcpp::SubscriptionOptions(),
+    std::make_shared<robocap_runtime::PooledMessageMemoryStrategy<sensor_msgs::msg::JointState>>(
+      std::make_shared<robocap_runtime::MessagePool<sensor_msgs::msg::JointState>>(
+        kJointStatePoolSize)));
+  if (fuse_pose) {
+    pose_subscription_ = create_subscription<geometry_msgs::msg::PoseWithCovarianceStamped>(
+      "pose", rclcpp::SystemDefaultsQoS(),
+      [this](const geometry_msgs::msg::PoseWithCovarianceStamped::ConstSharedPtr msg) {
+        on_pose(*msg);
+      });
+  }
+  imu_age_ =
+    &robocap_runtime::message_age_histogram(get_name(), imu_subscription_->get_topic_name());
+  joint_state_age_ = &robocap_runtime::message_age_histogram(
+    get_name(), joint_state_subscription_->get_topic_name());
+  ROBOCAP_TRACEPOINT(component_init, this, get_fully_qualified_name());
+}
+
+void EkfNode::advance(std::int64_t stamp_ns)
+{
+  if (!initialized_) {
+    initialized_ = true;
+    filter_time_ns_ = stamp_ns;
+    return;
+  }
+  const auto dt_ns = stamp_ns - filter_time_ns_;
+  if (dt_ns < 0) {
+    return;
+  }
+  ekf_.predict(static_cast<double>(std::min(dt_ns, kMaxPredictNs)) * 1e-9, ax_, ay_);
+  filter_time_ns_ = stamp_ns;
+}
+
+void EkfNode::on_imu(const sensor_msgs::msg::Imu & imu)
+{
+  const auto stamp_ns = rclcpp::Time(imu.header.stamp).nanoseconds();
+  ROBOCAP_TRACEPOINT(processing_start, this, stamp_ns);
+  imu_age_->record(std::chrono::nanoseconds(now().nanoseconds() - stamp_ns));
+  advance(stamp_ns);
+  // The IMU sits on the base_link axis and the robot stays level, so x/y carry no gravity
+  ax_ = imu.linear_acceleration.x;
+  ay_ = imu.linear_acceleration.y;
+  ekf_.update_gyro(imu.angular_velocity.z);
+  publish(filter_time_ns_);
+  ROBOCAP_TRACEPOINT(processing_end, this);
+}
+
+void EkfNode::on_joint_state(const sensor_msgs::msg::JointState & joint_state)
+{
+  const auto stamp_ns = rclcpp::Time(joint_state.header.stamp).nanoseconds();
+  ROBOCAP_TRACEPOINT(processing_start, this, stamp_ns);
+  joint_state_age_->record(std::chrono::nanoseconds(now().nanoseconds() - stamp_ns));
+  // Resolved once; the broadcaster keeps its name order, so later messages only compare strings
+  const auto matches = [&](std::size_t wheel) {
+      const auto index = wheel_index_[wheel];
+      return index < joint_state.name.size() && index < joint_state.velocity.size() &&
+             joint_state.name[index] == wheel_names_[wheel];
+    };
+  bool valid = wheel_index_valid_;
+  for (std::size_t wheel = 0; wheel < robocap_kinematics::kNumWheels; ++wheel) {
+    valid = valid && matches(wheel);
+  }
+  if (!valid) {
+    wheel_index_valid_ = true;
+    for (std::size_t wheel = 0; wheel < robocap_kinematics::kNumWheels; ++wheel) {
+      const auto it =
+        std::find(joint_state.name.begin(), joint_state.name.end(), wheel_names_[wheel]);
+      wheel_index_[wheel] = static_cast<std::size_t>(it - joint_state.name.begin());
+      wheel_index_valid_ = wheel_index_valid_ && matches(wheel);
+    }
+    if (!wheel_index_valid_) {
+      RCLCPP_WARN_THROTTLE(
+        get_logger(), *get_clock(), 5000, "joint_states lacks velocities for the wheel joints");
+      ROBOCAP_TRACEPOINT(processing_end, this);
+      return;
+    }
+  }
+
+  robocap_kinematics::WheelSpeeds<double> speeds{};
+  for (std::size_t wheel = 0; wheel < robocap_kinematics::kNumWheels; ++wheel) {
+    speeds[wheel] = joint_state.velocity[wheel_index_[wheel]];
+  }
+  advance(stamp_ns);
+  ekf_.update_wheels(speeds);
+  publish(filter_time_ns_);
+  ROBOCAP_TRACEPOINT(processing_end, this);
+}
+
+void EkfNode::on_pose(const geometry_msgs::msg::PoseWithCovarianceStamped & pose)
+{
+  const auto stamp_ns = rclcpp::Time(pose.header.stamp).nanoseconds();
+  ROBOCAP_TRACEPOINT(processing_start, this, stamp_ns);
+  advance(stamp_ns);
+  const auto & p = pose.pose.pose.position;
+  const auto & q = pose.pose.pose.orientation;
+  const double yaw =
+    std::atan2(2.0 * (q.w * q.z + q.x * q.y), 1.0 - 2.0 * (q.y * q.y + q.z * q.z));
+  // x, y and yaw out of the row-major 6x6 over x, y, z, roll, pitch, yaw
+  const auto & c = pose.pose.covariance;
+  Eigen::Matrix3d covariance;
+  covariance << c[0], c[1], c[5],
+    c[6], c[7], c[11],
+    c[30], c[31], c[35];
+  if (has_fix_) {
+    ekf_.update_pose(p.x, p.y, yaw, covariance);
+  } else {
+    ekf_.set_pose(p.x, p.y, yaw, covariance);
+    has_fix_ = true;
+  }
+  publish(filter_time_ns_);
+  ROBOCAP_TRACEPOINT(processing_end, this);
+}
+
+void EkfNode::publish(std::int64_t stamp_ns)
+{
+  if (publish_period_ns_ > 0 && stamp_ns - last_publish_ns_ < publish_period_ns_) {
+    return;
+  }
+  last_publish_ns_ = stamp_ns;
+
+  const rclcpp::Time stamp(stamp_ns, RCL_ROS_TIME);
+  odom_.header.stamp = stamp;
+  fill_odometry(ekf_, odom_);
+  odom_publisher_->publish(odom_);
+  if (tf_publisher_) {
+    tf_.transforms[0].header.stamp = stamp;
+    fill_transform(odom_, tf_.transforms[0].transform);
+    tf_publisher_->publish(tf_);
+  }
+}
+
+}  // namespace robocap_estimation
+
+#include "rclcpp_components/register_node_macro.hpp"
+
+RCLCPP_COMPONENTS_REGISTER_NODE(robocap_estimation::EkfNode)
@@ -0,0 +1,197 @@
+#include "robocap_estimation/ekf_odometry_controller.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "rclcpp/qos.hpp"
+#include "robocap_estimation/odometry.hpp"
+#include "robocap_kinematics/robocap_layout.hpp"
+#include "robocap_tracing/tracing.hpp"
+
+namespace robocap_estimation
+{
+
+namespace
+{
+
+constexpr char kOdomTopic[] = "~/odom";
+constexpr char kTfTopic[] = "/tf";
+
+}  // namespace
+
+controller_interface::CallbackReturn EkfOdometryController::on_init()
+{
+  try {
+    const KiwiEkfNoise noise;
+    auto_declare<std::vector<std::string>>(
+      "wheel_names", {"wheel_1_joint", "wheel_2_joint", "wheel_3_joint"});
+    auto_declare<std::string>("imu_topic", "/imu");
+    auto_declare<std::string>("odom_frame_id", "odom");
+    auto_declare<std::string>("base_frame_id", "base_link");
+    auto_declare<double>("publish_rate", 100.0);
+    auto_declare<bool>("publish_tf", true);
+    auto_declare<double>("noise.acceleration", noise.acceleration);
+    auto_declare<double>("noise.angular_acceleration", noise.angular_acceleration);
+    auto_declare<double>("noise.gyro_bias_drift", noise.gyro_bias_drift);
+    auto_declare<double>("noise.wheel_velocity", noise.wheel_velocity);
+    auto_declare<double>("noise.gyro", noise.gyro);
+  } catch (const std::exception & e) {
+    RCLCPP_FATAL(get_node()->get_logger(), "Exception during init: %s", e.what());
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+controller_interface::InterfaceConfiguration
+EkfOdometryController::command_interface_configuration() const
+{
+  return {controller_interface::interface_configuration_type::NONE, {}};
+}
+
+controller_interface::InterfaceConfiguration
+EkfOdometryController::state_interface_configuration() const
+{
+  controller_interface::InterfaceConfiguration config;
+  config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
+  for (const auto & name : wheel_names_) {
+    config.names.push_back(name + "/" + hardware_interface::HW_IF_VELOCITY);
+  }
+  return config;
+}
+
+controller_interface::CallbackReturn EkfOdometryController::on_configure(
+  const rclcpp_lifecycle::State & /*previous_state*/)
+{
+  const auto node = get_node();
+  const auto wheel_names = node->get_parameter("wheel_names").as_string_array();
+  if (wheel_names.size() != robocap_kinematics::kNumWheels) {
+    RCLCPP_ERROR(
+      node->get_logger(), "'wheel_names' needs exactly %zu joints, got %zu",
+      robocap_kinematics::kNumWheels, wheel_names.size());
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  std::copy(wheel_names.begin(), wheel_names.end(), wheel_names_.begin());
+  const auto publish_rate = node->get_parameter("publish_rate").as_double();
+  if (publish_rate <= 0.0) {
+    RCLCPP_ERROR(node->get_logger(), "'publish_rate' must be positive");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  publish_period_ = rclcpp::Duration::from_seconds(1.0 / publish_rate);
+
+  KiwiEkfNoise noise;
+  noise.acceleration = node->get_parameter("noise.acceleration").as_double();
+  noise.angular_acceleration = node->get_parameter("noise.angular_acceleration").as_double();
+  noise.gyro_bias_drift = node->get_parameter("noise.gyro_bias_drift").as_double();
+  noise.wheel_velocity = node->get_parameter("noise.wheel_velocity").as_double();
+  noise.gyro = node->get_parameter("noise.gyro").as_double();
+  ekf_.emplace(robocap_kinematics::kRobocapKiwiDrive.inverse_matrix(), noise);
+  ROBOCAP_TRACEPOINT(component_init, this, node->get_name());
+
+  imu_subscriber_ = node->create_subscription<sensor_msgs::msg::Imu>(
+    node->get_parameter("imu_topic").as_string(), rclcpp::SensorDataQoS(),
+    [this](const std::shared_ptr<sensor_msgs::msg::Imu> msg) {
+      // The IMU sits on the base_link axis and the robot stays level, so x/y carry no gravity
+      imu_buffer_.write(
+        ImuSample{msg->linear_acceleration.x, msg->linear_acceleration.y, msg->angular_velocity.z});
+    });
+
+  const auto odom_frame_id = node->get_parameter("odom_frame_id").as_string();
+  const auto base_frame_id = node->get_parameter("base_frame_id").as_string();
+  odom_publisher_ =
+    node->create_publisher<nav_msgs::msg::Odometry>(kOdomTopic, rclcpp::SystemDefaultsQoS());
+  realtime_odom_publisher_ =
+    std::make_unique<realtime_tools::RealtimePublisher<nav_msgs::msg::Odometry>>(odom_publisher_);
+  realtime_odom_publisher_->lock();
+  realtime_odom_publisher_->msg_.header.frame_id = odom_frame_id;
+  realtime_odom_publisher_->msg_.child_frame_id = base_frame_id;
+  realtime_odom_publisher_->unlock();
+
+  if (node->get_parameter("publish_tf").as_bool()) {
+    tf_publisher_ =
+      node->create_publisher<tf2_msgs::msg::TFMessage>(kTfTopic, rclcpp::SystemDefaultsQoS());
+    realtime_tf_publisher_ =
+      std::make_unique<realtime_tools::RealtimePublisher<tf2_msgs::msg::TFMessage>>(tf_publisher_);
+    realtime_tf_publisher_->lock();
+    // Sized once here so update() only overwrites values
+    realtime_tf_publisher_->msg_.transforms.resize(1);
+    realtime_tf_publisher_->msg_.transforms[0].header.frame_id = odom_frame_id;
+    realtime_tf_publisher_->msg_.transforms[0].child_frame_id = base_frame_id;
+    realtime_tf_publisher_->unlock();
+  }
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+controller_interface::CallbackReturn EkfOdometryController::on_activate(
+  const rclcpp_lifecycle::State & /*previous_state*/)
+{
+  for (std::size_t wheel = 0; wheel < robocap_kinematics::kNumWheels; ++wheel) {
+    bool found = false;
+    for (std::size_t i = 0; i < state_interfaces_.size(); ++i) {
+      if (state_interfaces_[i].get_prefix_name() == wheel_names_[wheel]) {
+        state_index_[wheel] = i;
+        found = true;
+      }
+    }
+    if (!found) {
+      RCLCPP_ERROR(
+        get_node()->get_logger(), "Interfaces for '%s' were not claimed",
+        wheel_names_[wheel].c_str());
+      return controller_interface::CallbackReturn::ERROR;
+    }
+  }
+
+  ekf_->reset();
+  // Drop the sample from before the deactivation on the reader side, the subscription stays the
+  // buffer's only writer
+  ImuSample stale{};
+  imu_buffer_.read(stale);
+  imu_ = ImuSample{};
+  last_publish_time_ = get_node()->now();
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+controller_interface::return_type EkfOdometryController::update(
+  const rclcpp::Time & time, const rclcpp::Duration & period)
+{
+  ROBOCAP_TRACEPOINT(controller_update_start, this);
+  // Predict with the acceleration in effect over the period, then fuse whatever is new
+  ekf_->predict(period.seconds(), imu_.ax, imu_.ay);
+  ImuSample latest{};
+  if (imu_buffer_.read(latest)) {
+    imu_ = latest;
+    ekf_->update_gyro(imu_.wz);
+  }
+  robocap_kinematics::WheelSpeeds<double> speeds{};
+  for (std::size_t i = 0; i < robocap_kinematics::kNumWheels; ++i) {
+    speeds[i] = state_interfaces_[state_index_[i]].get_value();
+  }
+  ekf_->update_wheels(speeds);
+
+  if (time - last_publish_time_ < publish_period_) {
+    ROBOCAP_TRACEPOINT(controller_update_end, this);
+    return controller_interface::return_type::OK;
+  }
+  last_publish_time_ = time;
+  if (realtime_odom_publisher_->trylock()) {
+    auto & odom = realtime_odom_publisher_->msg_;
+    odom.header.stamp = time;
+    fill_odometry(*ekf_, odom);
+    if (realtime_tf_publisher_ && realtime_tf_publisher_->trylock()) {
+      auto & transform = realtime_tf_publisher_->msg_.transforms[0];
+      transform.header.stamp = time;
+      fill_transform(odom, transform.transform);
+      realtime_tf_publisher_->unlockAndPublish();
+    }
+    realtime_odom_publisher_->unlockAndPublish();
+  }
+  ROBOCAP_TRACEPOINT(controller_update_end, this);
+  return controller_interface::return_type::OK;
+}
+
+}  // namespace robocap_estimation
+
+#include "pluginlib/class_list_macros.hpp"
+
+PLUGINLIB_EXPORT_CLASS(
+  robocap_estimation::EkfOdometryController, controller_interface::ControllerInterface)
@@ -0,0 +1,227 @@
+#include "robocap_estimation/scan_localizer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+#include "robocap_tracing/tracing.hpp"
+#include "tf2/exceptions.h"
+
+namespace robocap_estimation
+{
+
+namespace
+{
+
+constexpr std::size_t kMaxBeams = 8192;  // Beams past it are dropped
+// Longest gap the last fixes' velocity is extrapolated over, beyond it the prior stands still
+constexpr std::int64_t kMaxExtrapolationNs = 500'000'000;
+
+double yaw_of(const geometry_msgs::msg::Quaternion & q)
+{
+  return std::atan2(2.0 * (q.w * q.z + q.x * q.y), 1.0 - 2.0 * (q.y * q.y + q.z * q.z));
+}
+
+}  // namespace
+
+ScanLocalizer::ScanLocalizer(const rclcpp::NodeOptions & options)
+: rclcpp::Node("scan_localizer", options),
+  pool_(static_cast<std::size_t>(std::max<std::int64_t>(
+      0, declare_parameter<int>("threads", 1)))),
+  cloud_(kMaxBeams),
+  projector_(kMaxBeams)
+{
+  base_frame_ = declare_parameter<std::string>("base_frame", "base_link");
+  sigma_ = declare_parameter<double>("likelihood_sigma", 0.1);
+  levels_ = static_cast<int>(declare_parameter<int>("levels", 7));
+  tracking_.linear_window = declare_parameter<double>("linear_window", tracking_.linear_window);
+  tracking_.angular_window = declare_parameter<double>("angular_window", tracking_.angular_window);
+  tracking_.min_score = declare_parameter<double>("min_score", tracking_.min_score);
+  global_min_score_ = declare_parameter<double>("global_min_score", 0.65);
+  lost_after_ = static_cast<int>(declare_parameter<int>("lost_after", 10));
+  if (sigma_ <= 0.0 || levels_ < 1 || levels_ > 16) {
+    throw std::invalid_argument(
+      "ScanLocalizer: 'likelihood_sigma' must be positive and 'levels' in 1..16");
+  }
+
+  range_filter_ = &chain_.add<robocap_perception::RangeFilter>(0.0f, 0.0f);
+  transform_filter_ = &chain_.add<robocap_perception::TransformFilter>();
+
+  fix_.header.frame_id = "map";
+  tf_buffer_ = std::make_unique<tf2_ros::Buffer>(get_clock());
+  tf_listener_ = std::make_unique<tf2_ros::TransformListener>(*tf_buffer_);
+  publisher_ = create_publisher<geometry_msgs::msg::PoseWithCovarianceStamped>(
+    "pose", rclcpp::SystemDefaultsQoS());
+  // Map servers latch the map
+  map_subscription_ = create_subscription<nav_msgs::msg::OccupancyGrid>(
+    "map", rclcpp::QoS(1).transient_local().reliable(),
+    [this](const nav_msgs::msg::OccupancyGrid::ConstSharedPtr msg) {on_map(*msg);});
+  scan_subscription_ = create_subscription<sensor_msgs::msg::LaserScan>(
+    "scan", rclcpp::SensorDataQoS(),
+    [this](const sensor_msgs::msg::LaserScan::ConstSharedPtr msg) {on_scan(*msg);});
+  scan_age_ =
+    &robocap_runtime::message_age_histogram(get_name(), scan_subscription_->get_topic_name());
+  initial_pose_subscription_ = create_subscription<geometry_msgs::msg::PoseWithCovarianceStamped>(
+    "initialpose", rclcpp::SystemDefaultsQoS(),
+    [this](const geometry_msgs::msg::PoseWithCovarianceStamped::ConstSharedPtr msg) {
+      on_initial_pose(*msg);
+    });
+  ROBOCAP_TRACEPOINT(component_init, this, get_fully_qualified_name());
+}
+
+void ScanLocalizer::on_map(const nav_msgs::msg::OccupancyGrid & map)
+{
+  const auto & info = map.info;
+  if (std::abs(yaw_of(info.origin.orientation)) > 1e-6 || info.resolution <= 0.0f ||
+    map.data.size() < static_cast<std::size_t>(info.width) * info.height)
+  {
+    RCLCPP_ERROR(get_logger(), "Ignoring map: rotated, without resolution or truncated");
+    return;
+  }
+  const auto start = std::chrono::steady_clock::now();
+  matcher_.reset();
+  field_ = std::make_unique<LikelihoodField>(
+    map.data.data(), static_cast<int>(info.width), static_cast<int>(info.height),
+    info.resolution, info.origin.position.x, info.origin.position.y, sigma_, levels_);
+  matcher_ = std::make_unique<ScanMatcher>(*field_, &pool_);
+  fix_.header.frame_id = map.header.frame_id;
+  // Keeps tracking: usually the same map was sent again. A different one fails lost_after matches
+  // and falls back to the global search
+  RCLCPP_INFO(
+    get_logger(), "Likelihood field for a %ux%u map at %.3f m in %.1f ms", info.width, info.height,
+    info.resolution,
+    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+void ScanLocalizer::on_initial_pose(const geometry_msgs::msg::PoseWithCovarianceStamped & pose)
+{
+  pose_ = {pose.pose.pose.position.x, pose.pose.pose.position.y,
+    yaw_of(pose.pose.pose.orientation)};
+  velocity_ = {};
+  pose_stamp_ns_ = rclcpp::Time(pose.header.stamp).nanoseconds();
+  localized_ = true;
+  failures_ = 0;
+  RCLCPP_INFO(get_logger(), "Tracking from (%.2f, %.2f, %.2f)", pose_.x, pose_.y, pose_.yaw);
+}
+
+bool ScanLocalizer::update_mounting(const std::string & frame_id)
+{
+  if (frame_id == laser_frame_) {
+    return true;
+  }
+  geometry_msgs::msg::TransformStamped mounting;
+  try {
+    mounting = tf_buffer_->lookupTransform(base_frame_, frame_id, tf2::TimePointZero);
+  } catch (const tf2::TransformException & e) {
+    RCLCPP_WARN_THROTTLE(get_logger(), *get_clock(), 5000, "Dropping scan: %s", e.what());
+    return false;
+  }
+  // Only the rotation about z matters, the field is a plane
+  const float yaw = static_cast<float>(yaw_of(mounting.transform.rotation));
+  const float c = std::cos(yaw);
+  const float s = std::sin(yaw);
+  transform_filter_->set_transform(
+    {c, -s, 0.0f, s, c, 0.0f, 0.0f, 0.0f, 1.0f},
+    {static_cast<float>(mounting.transform.translation.x),
+      static_cast<float>(mounting.transform.translation.y), 0.0f});
+  laser_frame_ = frame_id;
+  return true;
+}
+
+void ScanLocalizer::on_scan(const sensor_msgs::msg::LaserScan & scan)
+{
+  const rclcpp::Time stamp(scan.header.stamp);
+  ROBOCAP_TRACEPOINT(processing_start, this, stamp.nanoseconds());
+  scan_age_->record(std::chrono::nanoseconds((now() - stamp).nanoseconds()));
+  if (!matcher_) {
+    RCLCPP_WARN_THROTTLE(get_logger(), *get_clock(), 5000, "Waiting for a map on 'map'");
+    ROBOCAP_TRACEPOINT(processing_end, this);
+    return;
+  }
+  if (!update_mounting(scan.header.frame_id)) {
+    ROBOCAP_TRACEPOINT(processing_end, this);
+    return;
+  }
+  projector_.project(
+    scan.ranges.data(), std::min(scan.ranges.size(), kMaxBeams), scan.angle_min,
+    scan.angle_increment, cloud_);
+  range_filter_->set_limits(scan.range_min, scan.range_max);
+  chain_.apply(cloud_);
+
+  ScanMatch match;
+  const auto dt_ns = stamp.nanoseconds() - pose_stamp_ns_;
+  if (localized_) {
+    Pose2 prior = pose_;
+    if (dt_ns > 0 && dt_ns < kMaxExtrapolationNs) {
+      const double dt = static_cast<double>(dt_ns) * 1e-9;
+      prior.x += velocity_.x * dt;
+      prior.y += velocity_.y * dt;
+      prior.yaw += velocity_.yaw * dt;
+    }
+    match = matcher_->match(cloud_.x(), cloud_.y(), cloud_.size(), prior, tracking_);
+  } else {
+    // The whole map from its centre, in every direction
+    ScanMatcherOptions global = tracking_;
+    const double resolution = field_->resolution();
+    global.linear_window = 0.5 * std::max(field_->width(), field_->height()) * resolution;
+    global.angular_window = M_PI;
+    global.min_score = global_min_score_;
+    const Pose2 centre{
+      field_->origin_x() + 0.5 * field_->width() * resolution,
+      field_->origin_y() + 0.5 * field_->height() * resolution, 0.0};
+    match = matcher_->match(cloud_.x(), cloud_.y(), cloud_.size(), centre, global);
+    if (match.valid) {
+      RCLCPP_INFO(
+        get_logger(), "Localized at (%.2f, %.2f, %.2f), score %.2f", match.pose.x,
+        match.pose.y, match.pose.yaw, match.score);
+    }
+  }
+
+  if (!match.valid) {
+    if (localized_ && ++failures_ >= lost_after_) {
+      RCLCPP_WARN(get_logger(), "Lost after %d failed matches, searching the whole map", failures_);
+      localized_ = false;
+    }
+    ROBOCAP_TRACEPOINT(processing_end, this);
+    return;
+  }
+  if (localized_ && dt_ns > 0 && dt_ns < kMaxExtrapolationNs) {
+    const double dt = static_cast<double>(dt_ns) * 1e-9;
+    velocity_ = {(match.pose.x - pose_.x) / dt, (match.pose.y - pose_.y) / dt,
+      std::remainder(match.pose.yaw - pose_.yaw, 2.0 * M_PI) / dt};
+  } else {
+    velocity_ = {};
+  }
+  pose_ = match.pose;
+  pose_stamp_ns_ = stamp.nanoseconds();
+  localized_ = true;
+  failures_ = 0;
+  publish(match, stamp);
+  ROBOCAP_TRACEPOINT(processing_end, this);
+}
+
+void ScanLocalizer::publish(const ScanMatch & match, const rclcpp::Time & stamp)
+{
+  fix_.header.stamp = stamp;
+  auto & pose = fix_.pose.pose;
+  pose.position.x = match.pose.x;
+  pose.position.y = match.pose.y;
+  pose.orientation.z = std::sin(0.5 * match.pose.yaw);
+  pose.orientation.w = std::cos(0.5 * match.pose.yaw);
+  // Row-major 6x6 over x, y, z, roll, pitch, yaw; only the planar terms are estimated
+  constexpr std::size_t kIndex[3] = {0, 1, 5};
+  for (std::size_t row = 0; row < 3; ++row) {
+    for (std::size_t col = 0; col < 3; ++col) {
+      fix_.pose.covariance[kIndex[row] * 6 + kIndex[col]] =
+        match.covariance(static_cast<Eigen::Index>(row), static_cast<Eigen::Index>(col));
+    }
+  }
+  publisher_->publish(fix_);
+}
+
+}  // namespace robocap_estimation
+
+#include "rclcpp_components/register_node_macro.hpp"
+
+RCLCPP_COMPONENTS_REGISTER_NODE(robocap_estimation::ScanLocalizer)
@@ -0,0 +1,474 @@
+#include "robocap_estimation/scan_matcher.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include "Eigen/Cholesky"
+#include "Eigen/LU"
+
+namespace robocap_estimation
+{
+
+namespace
+{
+
+constexpr double kFar = 1e20;
+// Floors on the reported variances, what the refinement can resolve on any map
+constexpr double kMinPositionVariance = 1e-6;  // [m^2]
+constexpr double kMinYawVariance = 1e-6;       // [rad^2]
+
+// Felzenszwalb and Huttenlocher's squared Euclidean distance transform, in place along the n
+// values of `f` that are `stride` apart. The rest are scratch of n, n and n + 1 elements
+void distance_transform(
+  double * f, int n, std::size_t stride, double * line, int * v, double * z)
+{
+  for (int i = 0; i < n; ++i) {
+    line[i] = f[static_cast<std::size_t>(i) * stride];
+  }
+  // Lower envelope of the parabolas rooted at each sample
+  const auto intersection = [line](int q, int p) {
+      return ((line[q] + q * q) - (line[p] + p * p)) / (2.0 * (q - p));
+    };
+  int k = 0;
+  v[0] = 0;
+  z[0] = -std::numeric_limits<double>::infinity();
+  z[1] = std::numeric_limits<double>::infinity();
+  for (int q = 1; q < n; ++q) {
+    double s = intersection(q, v[k]);
+    while (s <= z[k]) {
+      --k;
+      s = intersection(q, v[k]);
+    }
+    ++k;
+    v[k] = q;
+    z[k] = s;
+    z[k + 1] = std::numeric_limits<double>::infinity();
+  }
+  k = 0;
+  for (int q = 0; q < n; ++q) {
+    while (z[k + 1] < q) {
+      ++k;
+    }
+    f[static_cast<std::size_t>(q) * stride] = (q - v[k]) * (q - v[k]) + line[v[k]];
+  }
+}
+
+}  // namespace
+
+LikelihoodField::LikelihoodField(
+  const std::int8_t * occupancy, int width, int height, double resolution, double origin_x,
+  double origin_y, double sigma, int levels, int occupied_threshold)
+: width_(std::max(width, 1)),
+  height_(std::max(height, 1)),
+  resolution_(resolution),
+  origin_x_(origin_x),
+  origin_y_(origin_y)
+{
+  const auto w = static_cast<std::size_t>(width_);
+  const auto h = static_cast<std::size_t>(height_);
+  std::vector<double> distance(w * h, kFar);
+  if (width > 0 && height > 0) {
+    for (std::size_t i = 0; i < w * h; ++i) {
+      if (occupancy[i] >= occupied_threshold) {
+        distance[i] = 0.0;
+      }
+    }
+  }
+  std::vector<double> line(std::max(w, h));
+  std::vector<int> v(std::max(w, h));
+  std::vector<double> z(std::max(w, h) + 1);
+  for (std::size_t x = 0; x < w; ++x) {
+    distance_transform(distance.data() + x, height_, w, line.data(), v.data(), z.data());
+  }
+  for (std::size_t y = 0; y < h; ++y) {
+    distance_transform(distance.data() + y * w, width_, 1, line.data(), v.data(), z.data());
+  }
+
+  // Squared distance in cells -> likelihood
+  const double scale = resolution * resolution / (2.0 * sigma * sigma);
+  std::vector<std::uint8_t> cells(w * h);
+  for (std::size_t i = 0; i < w * h; ++i) {
+    cells[i] = static_cast<std::uint8_t>(std::lround(255.0 * std::exp(-distance[i] * scale)));
+  }
+  levels_.push_back(tile(cells, width_, height_, 0));
+
+  // Level h from h - 1, a separable max over [x, x + 2^(h-1)] in each direction
+  int offset = 0;
+  for (int level = 1; level < std::max(levels, 1); ++level) {
+    const int half = 1 << (level - 1);
+    const int next_offset = (1 << level) - 1;
+    const int prev_width = width_ + offset;
+    const int prev_height = height_ + offset;
+    const int next_width = width_ + next_offset;
+    const int next_height = height_ + next_offset;
+    // Cell (x, y) of level h - 1, stored from -offset
+    const auto previous = [&](int x, int y) -> std::uint8_t {
+        const int u = x + offset;
+        const int r = y + offset;
+        return u >= 0 && u < prev_width && r >= 0 && r < prev_height ?
+               cells[static_cast<std::size_t>(r) * static_cast<std::size_t>(prev_width) +
+          static_cast<std::size_t>(u)] :
+               std::uint8_t{0};
+      };
+    std::vector<std::uint8_t> rows(
+      static_cast<std::size_t>(next_width) * static_cast<std::size_t>(prev_height));
+    for (int r = 0; r < prev_height; ++r) {
+      for (int u = 0; u < next_width; ++u) {
+        const int x = u - next_offset;
+        const int y = r - offset;
+        rows[static_cast<std::size_t>(r) * static_cast<std::size_t>(next_width) +
+          static_cast<std::size_t>(u)] = std::max(previous(x, y), previous(x + half, y));
+      }
+    }
+    std::vector<std::uint8_t> next(
+      static_cast<std::size_t>(next_width) * static_cast<std::size_t>(next_height));
+    const auto row = [&](int u, int y) -> std::uint8_t {
+        const int r = y + offset;
+        return r >= 0 && r < prev_height ?
+               rows[static_cast<std::size_t>(r) * static_cast<std::size_t>(next_width) +
+          static_cast<std::size_t>(u)] :
+               std::uint8_t{0};
+      };
+    for (int r = 0; r < next_height; ++r) {
+      for (int u = 0; u < next_width; ++u) {
+        const int y = r - next_offset;
+        next[static_cast<std::size_t>(r) * static_cast<std::size_t>(next_width) +
+          static_cast<std::size_t>(u)] = std::max(row(u, y), row(u, y + half));
+      }
+    }
+    levels_.push_back(tile(next, next_width, next_height, next_offset));
+    cells = std::move(next);
+    offset = next_offset;
+  }
+}
+
+LikelihoodField::Level LikelihoodField::tile(
+  const std::vector<std::uint8_t> & cells, int width, int height, int offset)
+{
+  Level level;
+  level.x0 = -offset;
+  level.y0 = -offset;
+  level.tiles_x = static_cast<std::size_t>((width + kTileSize - 1) / kTileSize);
+  const auto tiles_y = static_cast<std::size_t>((height + kTileSize - 1) / kTileSize);
+  level.width = static_cast<std::uint32_t>(level.tiles_x * kTileSize);
+  level.height = static_cast<std::uint32_t>(tiles_y * kTileSize);
+  level.tiles.resize(level.tiles_x * tiles_y);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      level.tiles[static_cast<std::size_t>(y / kTileSize) * level.tiles_x +
+        static_cast<std::size_t>(x / kTileSize)]
+      .cells[static_cast<std::size_t>((y % kTileSize) * kTileSize + x % kTileSize)] =
+        cells[static_cast<std::size_t>(y) * static_cast<std::size_t>(width) +
+          static_cast<std::size_t>(x)];
+    }
+  }
+  return level;
+}
+
+std::uint32_t LikelihoodField::score(
+  int level, const std::int32_t * x, const std::int32_t * y, std::size_t count,
+  std::int32_t dx, std::int32_t dy) const
+{
+  const auto & grid = levels_[static_cast<std::size_t>(level)];
+  const Tile * tiles = grid.tiles.data();
+  const std::int32_t shift_x = dx - grid.x0;
+  const std::int32_t shift_y = dy - grid.y0;
+  std::uint32_t sum = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto u = static_cast<std::uint32_t>(x[i] + shift_x);
+    const auto v = static_cast<std::uint32_t>(y[i] + shift_y);
+    if (u < grid.width && v < grid.height) {
+      sum += tiles[(v / kTileSize) * grid.tiles_x + u / kTileSize]
+        .cells[(v % kTileSize) * kTileSize + u % kTileSize];
+    }
+  }
+  return sum;
+}
+
+ScanMatcher::ScanMatcher(const LikelihoodField & field, robocap_perception::ThreadPool * pool)
+: field_(field),
+  pool_(pool),
+  best_(pool ? pool->size() : 1)
+{
+}
+
+template<typename Body>
+void ScanMatcher::parallel_for(std::size_t count, std::size_t chunk, Body && body)
+{
+  if (pool_ && pool_->size() > 1) {
+    pool_->parallel_for(count, chunk, std::forward<Body>(body));
+  } else {
+    body(std::size_t{0}, count, std::size_t{0});
+  }
+}
+
+ScanMatch ScanMatcher::match(
+  const float * x, const float * y, std::size_t count, const Pose2 & prior,
+  const ScanMatcherOptions & options)
+{
+  ScanMatch result;
+  result.pose = prior;
+  if (count == 0) {
+    return result;
+  }
+  count_ = count;
+  const double resolution = field_.resolution();
+
+  // Angles one cell of motion apart at the farthest point
+  double max_range_squared = resolution * resolution;
+  for (std::size_t i = 0; i < count; ++i) {
+    max_range_squared = std::max<double>(max_range_squared, x[i] * x[i] + y[i] * y[i]);
+  }
+  double angular_step = options.angular_step;
+  if (angular_step <= 0.0) {
+    angular_step = std::acos(1.0 - resolution * resolution / (2.0 * max_range_squared));
+  }
+  std::size_t angles;
+  double first_angle;
+  if (options.angular_window >= M_PI) {
+    angles = static_cast<std::size_t>(std::ceil(2.0 * M_PI / angular_step));
+    angular_step = 2.0 * M_PI / static_cast<double>(angles);
+    first_angle = prior.yaw - M_PI;
+  } else {
+    const auto side = static_cast<std::size_t>(std::ceil(options.angular_window / angular_step));
+    angles = 2 * side + 1;
+    first_angle = prior.yaw - static_cast<double>(side) * angular_step;
+  }
+  const auto window = static_cast<std::int32_t>(
+    std::ceil(std::max(options.linear_window, 0.0) / resolution));
+  // Coarsest level whose square covers the window, or the coarsest there is
+  int top = 0;
+  while (top + 1 < field_.levels() && (1 << top) < 2 * window + 1) {
+    ++top;
+  }
+
+  // Cells of every point at the window's centre, per angle
+  if (cell_x_.size() < angles * count) {
+    cell_x_.resize(angles * count);
+    cell_y_.resize(angles * count);
+  }
+  const double inverse_resolution = 1.0 / resolution;
+  const double origin_x = field_.origin_x();
+  const double origin_y = field_.origin_y();
+  parallel_for(
+    angles, 8, [&](std::size_t begin, std::size_t end, std::size_t) {
+      for (std::size_t angle = begin; angle < end; ++angle) {
+        const double theta = first_angle + static_cast<double>(angle) * angular_step;
+        const double c = std::cos(theta);
+        const double s = std::sin(theta);
+        std::int32_t * cell_x = cell_x_.data() + angle * count;
+        std::int32_t * cell_y = cell_y_.data() + angle * count;
+        for (std::size_t i = 0; i < count; ++i) {
+          const double px = prior.x + c * x[i] - s * y[i];
+          const double py = prior.y + s * x[i] + c * y[i];
+          cell_x[i] = static_cast<std::int32_t>(std::floor((px - origin_x) * inverse_resolution));
+          cell_y[i] = static_cast<std::int32_t>(std::floor((py - origin_y) * inverse_resolution));
+        }
+      }
+    });
+
+  // Coarsest candidates of every angle, best first
+  const std::int32_t top_step = 1 << top;
+  const auto per_side = static_cast<std::size_t>(2 * window / top_step + 1);
+  const std::size_t per_angle = per_side * per_side;
+  candidates_.resize(angles * per_angle);
+  parallel_for(
+    angles, 8, [&](std::size_t begin, std::size_t end, std::size_t) {
+      for (std::size_t angle = begin; angle < end; ++angle) {
+        const std::int32_t * cell_x = cell_x_.data() + angle * count;
+        const std::int32_t * cell_y = cell_y_.data() + angle * count;
+        Candidate * out = candidates_.data() + angle * per_angle;
+        for (std::size_t i = 0; i < per_side; ++i) {
+          for (std::size_t j = 0; j < per_side; ++j) {
+            const auto dx = -window + static_cast<std::int32_t>(i) * top_step;
+            const auto dy = -window + static_cast<std::int32_t>(j) * top_step;
+            *out++ = {field_.score(top, cell_x, cell_y, count, dx, dy),
+              static_cast<std::int32_t>(angle), dx, dy};
+          }
+        }
+      }
+    });
+  std::sort(
+    candidates_.begin(), candidates_.end(),
+    [](const Candidate & a, const Candidate & b) {return a.score > b.score;});
+
+  // Branch and bound, nothing below min_score is ever expanded
+  const auto min_score = static_cast<std::uint32_t>(
+    std::ceil(std::clamp(options.min_score, 0.0, 1.0) * 255.0 * static_cast<double>(count)));
+  best_score_.store(min_score > 0 ? min_score - 1 : 0, std::memory_order_relaxed);
+  std::fill(best_.begin(), best_.end(), Candidate{0, 0, 0, 0});
+  parallel_for(
+    candidates_.size(), 16, [&](std::size_t begin, std::size_t end, std::size_t worker) {
+      for (std::size_t i = begin; i < end; ++i) {
+        if (candidates_[i].score <= best_score_.load(std::memory_order_relaxed)) {
+          return;  // Sorted, so neither can any later one
+        }
+        search(candidates_[i], top, window, worker);
+      }
+    });
+  const auto best = *std::max_element(
+    best_.begin(), best_.end(),
+    [](const Candidate & a, const Candidate & b) {return a.score < b.score;});
+  if (best.score == 0) {
+    return result;
+  }
+
+  Pose2 pose;
+  pose.x = prior.x + best.x * resolution;
+  pose.y = prior.y + best.y * resolution;
+  pose.yaw = std::remainder(first_angle + best.angle * angular_step, 2.0 * M_PI);
+  result.valid = true;
+  result.pose = refine(
+    x, y, count, pose, options.refine_iterations, result.score, result.covariance);
+  return result;
+}
+
+void ScanMatcher::search(
+  const Candidate & candidate, int level, std::int32_t window, std::size_t worker)
+{
+  if (level == 0) {
+    if (candidate.score > best_[worker].score) {
+      best_[worker] = candidate;
+    }
+    auto current = best_score_.load(std::memory_order_relaxed);
+    while (candidate.score > current &&
+      !best_score_.compare_exchange_weak(current, candidate.score, std::memory_order_relaxed))
+    {
+    }
+    return;
+  }
+
+  // The four quarters of this candidate's square that still lie in the window
+  const std::int32_t step = 1 << (level - 1);
+  const auto offset = static_cast<std::size_t>(candidate.angle) * count_;
+  const std::int32_t * cell_x = cell_x_.data() + offset;
+  const std::int32_t * cell_y = cell_y_.data() + offset;
+  std::array<Candidate, 4> children;
+  std::size_t size = 0;
+  for (std::int32_t dx = 0; dx <= step; dx += step) {
+    for (std::int32_t dy = 0; dy <= step; dy += step) {
+      const auto x = candidate.x + dx;
+      const auto y = candidate.y + dy;
+      if (x > window || y > window) {
+        continue;
+      }
+      // Insertion sort, best first
+      const Candidate child{field_.score(level - 1, cell_x, cell_y, count_, x, y),
+        candidate.angle, x, y};
+      std::size_t slot = size++;
+      for (; slot > 0 && children[slot - 1].score < child.score; --slot) {
+        children[slot] = children[slot - 1];
+      }
+      children[slot] = child;
+    }
+  }
+  for (std::size_t i = 0; i < size; ++i) {
+    if (children[i].score <= best_score_.load(std::memory_order_relaxed)) {
+      break;
+    }
+    search(children[i], level - 1, window, worker);
+  }
+}
+
+Pose2 ScanMatcher::refine(
+  const float * x, const float * y, std::size_t count, Pose2 pose, int iterations,
+  double & score, Eigen::Matrix3d & covariance) const
+{
+  const double inverse_resolution = 1.0 / field_.resolution();
+  const double origin_x = field_.origin_x();
+  const double origin_y = field_.origin_y();
+  constexpr double kInverseMax = 1.0 / 255.0;
+
+  // Sum of squared (1 - likelihood) at `at`, bilinear between cell centres, with the Gauss-Newton
+  // normal equations when `hessian` is given
+  double likelihood_sum = 0.0;
+  const auto evaluate = [&](const Pose2 & at, Eigen::Matrix3d * hessian, Eigen::Vector3d * gradient)
+    {
+      const double c = std::cos(at.yaw);
+      const double s = std::sin(at.yaw);
+      double cost = 0.0;
+      likelihood_sum = 0.0;
+      if (hessian) {
+        hessian->setZero();
+        gradient->setZero();
+      }
+      for (std::size_t i = 0; i < count; ++i) {
+        const double rx = c * x[i] - s * y[i];
+        const double ry = s * x[i] + c * y[i];
+        const double u = (at.x + rx - origin_x) * inverse_resolution - 0.5;
+        const double v = (at.y + ry - origin_y) * inverse_resolution - 0.5;
+        const double u0 = std::floor(u);
+        const double v0 = std::floor(v);
+        const double fu = u - u0;
+        const double fv = v - v0;
+        const auto cx = static_cast<std::int32_t>(u0);
+        const auto cy = static_cast<std::int32_t>(v0);
+        const double m00 = field_.at(0, cx, cy);
+        const double m10 = field_.at(0, cx + 1, cy);
+        const double m01 = field_.at(0, cx, cy + 1);
+        const double m11 = field_.at(0, cx + 1, cy + 1);
+        const double m =
+          ((1.0 - fv) * ((1.0 - fu) * m00 + fu * m10) + fv * ((1.0 - fu) * m01 + fu * m11)) *
+          kInverseMax;
+        const double residual = 1.0 - m;
+        cost += residual * residual;
+        likelihood_sum += m;
+        if (hessian) {
+          const double du =
+            ((1.0 - fv) * (m10 - m00) + fv * (m11 - m01)) * kInverseMax * inverse_resolution;
+          const double dv =
+            ((1.0 - fu) * (m01 - m00) + fu * (m11 - m10)) * kInverseMax * inverse_resolution;
+          // d residual / d (x, y, yaw)
+          const Eigen::Vector3d jacobian(-du, -dv, -(du * -ry + dv * rx));
+          hessian->noalias() += jacobian * jacobian.transpose();
+          gradient->noalias() += jacobian * residual;
+        }
+      }
+      return cost;
+    };
+
+  // Levenberg-Marquardt, only ever taking steps that lower the cost
+  Eigen::Matrix3d hessian;
+  Eigen::Vector3d gradient;
+  double cost = evaluate(pose, &hessian, &gradient);
+  double lambda = 1e-3;
+  for (int iteration = 0; iteration < iterations; ++iteration) {
+    Eigen::Matrix3d damped = hessian;
+    damped.diagonal() *= 1.0 + lambda;
+    damped.diagonal().array() += 1e-12;
+    const Eigen::Vector3d delta = damped.ldlt().solve(-gradient);
+    Pose2 next{pose.x + delta.x(), pose.y + delta.y(), pose.yaw + delta.z()};
+    Eigen::Matrix3d next_hessian;
+    Eigen::Vector3d next_gradient;
+    const double next_cost = evaluate(next, &next_hessian, &next_gradient);
+    if (next_cost < cost) {
+      pose = next;
+      cost = next_cost;
+      hessian = next_hessian;
+      gradient = next_gradient;
+      lambda = std::max(lambda * 0.1, 1e-7);
+      if (delta.head<2>().squaredNorm() < 1e-10 && delta.z() * delta.z() < 1e-10) {
+        break;
+      }
+    } else {
+      lambda *= 10.0;
+    }
+  }
+  evaluate(pose, nullptr, nullptr);
+  score = likelihood_sum / static_cast<double>(count);
+
+  // Residual variance over the Hessian, what the field's curvature around the match supports
+  const double variance = cost / static_cast<double>(std::max<std::size_t>(count, 4) - 3);
+  Eigen::Matrix3d information = hessian;
+  information.diagonal().array() += 1e-9;
+  covariance = variance * information.inverse();
+  covariance(0, 0) = std::max(covariance(0, 0), kMinPositionVariance);
+  covariance(1, 1) = std::max(covariance(1, 1), kMinPositionVariance);
+  covariance(2, 2) = std::max(covariance(2, 2), kMinYawVariance);
+  pose.yaw = std::remainder(pose.yaw, 2.0 * M_PI);
+  return pose;
+}
+
+}  // namespace robocap_estimation
@@ -0,0 +1,227 @@
+#ifndef ROBOCAP_KINEMATICS__KIWI_DRIVE_HPP_
+#define ROBOCAP_KINEMATICS__KIWI_DRIVE_HPP_
+
+#include <array>
+#include <cstddef>
+
+#include "robocap_kinematics/simd.hpp"
+
+namespace robocap_kinematics
+{
+
+constexpr std::size_t kNumWheels = 3;
+
+namespace detail
+{
+
+// std::sqrt is not constexpr in C++17
+constexpr double sqrt(double x)
+{
+  if (x <= 0.0) {
+    return 0.0;
+  }
+  double guess = x > 1.0 ? x : 1.0;
+  for (int i = 0; i < 64; ++i) {
+    guess = 0.5 * (guess + x / guess);
+  }
+  return guess;
+}
+
+}  // namespace detail
+
+// Contact point of a wheel in base_link and the unit direction it drives the ground in, i.e. the
+// direction the wheel centre moves for a positive joint velocity
+struct WheelGeometry
+{
+  double x;
+  double y;
+  double drive_x;
+  double drive_y;
+};
+
+// Wheel whose spin axis points radially towards base_link, as all three do in robot_core.xacro.
+// Rolling about an inward axis moves the wheel along +z x axis, i.e. counter-clockwise.
+constexpr WheelGeometry radial_wheel(double x, double y)
+{
+  const double distance = detail::sqrt(x * x + y * y);
+  return WheelGeometry{x, y, -y / distance, x / distance};
+}
+
+struct WheelLayout
+{
+  std::array<WheelGeometry, kNumWheels> wheels;
+  double wheel_radius;
+};
+
+template<typename T>
+struct Twist
+{
+  T vx;  // [m/s] in base_link
+  T vy;  // [m/s]
+  T wz;  // [rad/s]
+};
+
+template<typename T>
+using WheelSpeeds = std::array<T, kNumWheels>;  // Joint velocities [rad/s]
+
+using Matrix3 = std::array<std::array<double, 3>, 3>;
+
+// Structure-of-arrays views for the batched API. All arrays hold `size` elements and may not alias.
+template<typename T>
+struct TwistBatch
+{
+  const T * vx;
+  const T * vy;
+  const T * wz;
+  std::size_t size;
+};
+
+template<typename T>
+struct WheelSpeedBatch
+{
+  std::array<T *, kNumWheels> wheel;
+};
+
+template<typename T>
+struct ConstWheelSpeedBatch
+{
+  std::array<const T *, kNumWheels> wheel;
+  std::size_t size;
+};
+
+template<typename T>
+struct TwistOutputBatch
+{
+  T * vx;
+  T * vy;
+  T * wz;
+};
+
+// Kiwi-drive kinematics for a fixed wheel layout. Both matrices are computed in the constructor,
+// which is constexpr, so a layout known at compile time costs nothing at runtime. Nothing here
+// allocates.
+class KiwiDrive
+{
+public:
+  constexpr explicit KiwiDrive(const WheelLayout & layout)
+  : inverse_(inverse_matrix(layout)), forward_(invert(inverse_))
+  {
+  }
+
+  // Twist -> wheel joint velocities
+  constexpr const Matrix3 & inverse_matrix() const {return inverse_;}
+  // Wheel joint velocities -> twist
+  constexpr const Matrix3 & forward_matrix() const {return forward_;}
+
+  template<typename T>
+  constexpr WheelSpeeds<T> to_wheel_speeds(const Twist<T> & twist) const
+  {
+    WheelSpeeds<T> speeds{};
+    for (std::size_t i = 0; i < kNumWheels; ++i) {
+      speeds[i] = static_cast<T>(inverse_[i][0]) * twist.vx +
+        static_cast<T>(inverse_[i][1]) * twist.vy + static_cast<T>(inverse_[i][2]) * twist.wz;
+    }
+    return speeds;
+  }
+
+  template<typename T>
+  constexpr Twist<T> to_twist(const WheelSpeeds<T> & speeds) const
+  {
+    std::array<T, 3> out{};
+    for (std::size_t row = 0; row < 3; ++row) {
+      for (std::size_t i = 0; i < kNumWheels; ++i) {
+        out[row] += static_cast<T>(forward_[row][i]) * speeds[i];
+      }
+    }
+    return Twist<T>{out[0], out[1], out[2]};
+  }
+
+  // Batched twist -> wheel speeds, vectorized over the candidates
+  template<typename T>
+  void to_wheel_speeds(const TwistBatch<T> & twists, const WheelSpeedBatch<T> & speeds) const
+  {
+    apply_batch<T>(inverse_, {twists.vx, twists.vy, twists.wz}, speeds.wheel, twists.size);
+  }
+
+  // Batched wheel speeds -> twist
+  template<typename T>
+  void to_twists(const ConstWheelSpeedBatch<T> & speeds, const TwistOutputBatch<T> & twists) const
+  {
+    apply_batch<T>(forward_, speeds.wheel, {twists.vx, twists.vy, twists.wz}, speeds.size);
+  }
+
+private:
+  static constexpr Matrix3 inverse_matrix(const WheelLayout & layout)
+  {
+    Matrix3 m{};
+    for (std::size_t i = 0; i < kNumWheels; ++i) {
+      const auto & w = layout.wheels[i];
+      // Velocity of the contact point along the drive direction, divided by the radius
+      m[i][0] = w.drive_x / layout.wheel_radius;
+      m[i][1] = w.drive_y / layout.wheel_radius;
+      m[i][2] = (w.x * w.drive_y - w.y * w.drive_x) / layout.wheel_radius;
+    }
+    return m;
+  }
+
+  static constexpr Matrix3 invert(const Matrix3 & m)
+  {
+    const double c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+    const double c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+    const double c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+    const double det = m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02;
+    // A singular layout (e.g. parallel drive directions) fails constant evaluation here
+    const double inv_det = 1.0 / det;
+    Matrix3 inv{};
+    inv[0][0] = c00 * inv_det;
+    inv[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * inv_det;
+    inv[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * inv_det;
+    inv[1][0] = c01 * inv_det;
+    inv[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * inv_det;
+    inv[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * inv_det;
+    inv[2][0] = c02 * inv_det;
+    inv[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * inv_det;
+    inv[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * inv_det;
+    return inv;
+  }
+
+  // out[row][k] = sum_col m[row][col] * in[col][k]
+  template<typename T>
+  static void apply_batch(
+    const Matrix3 & m, const std::array<const T *, 3> & in, const std::array<T *, 3> & out,
+    std::size_t size)
+  {
+    using Pack = simd::Pack<T>;
+    using Vec = typename Pack::Vec;
+
+    Vec coeff[3][3];
+    for (std::size_t row = 0; row < 3; ++row) {
+      for (std::size_t col = 0; col < 3; ++col) {
+        coeff[row][col] = Pack::broadcast(static_cast<T>(m[row][col]));
+      }
+    }
+
+    std::size_t k = 0;
+    for (; k + Pack::kLanes <= size; k += Pack::kLanes) {
+      const Vec a = Pack::load(in[0] + k);
+      const Vec b = Pack::load(in[1] + k);
+      const Vec c = Pack::load(in[2] + k);
+      for (std::size_t row = 0; row < 3; ++row) {
+        Pack::store(out[row] + k, coeff[row][0] * a + coeff[row][1] * b + coeff[row][2] * c);
+      }
+    }
+    for (; k < size; ++k) {
+      for (std::size_t row = 0; row < 3; ++row) {
+        out[row][k] = static_cast<T>(m[row][0]) * in[0][k] + static_cast<T>(m[row][1]) * in[1][k] +
+          static_cast<T>(m[row][2]) * in[2][k];
+      }
+    }
+  }
+
+  Matrix3 inverse_;
+  Matrix3 forward_;
+};
+
+}  // namespace robocap_kinematics
+
+#endif  // ROBOCAP_KINEMATICS__KIWI_DRIVE_HPP_
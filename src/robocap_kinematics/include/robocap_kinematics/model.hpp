@@ -0,0 +1,99 @@
+#ifndef ROBOCAP_KINEMATICS__MODEL_HPP_
+#define ROBOCAP_KINEMATICS__MODEL_HPP_
+
+#include <array>
+
+namespace robocap_kinematics
+{
+namespace model
+{
+
+// Plain constexpr mirror of the URDF elements robocap_model.hpp is generated from. Units and
+// frames are the URDF's: metres, radians, kilograms, and every pose relative to its parent.
+
+struct Vector3
+{
+  double x;
+  double y;
+  double z;
+};
+
+struct Origin
+{
+  Vector3 xyz;
+  Vector3 rpy;
+  // The same rotation as rpy, row-major, so nobody needs a constexpr sin/cos
+  std::array<std::array<double, 3>, 3> rotation;
+};
+
+// About the centre of mass, in the inertial origin frame
+struct Inertia
+{
+  double ixx;
+  double ixy;
+  double ixz;
+  double iyy;
+  double iyz;
+  double izz;
+};
+
+enum class GeometryType
+{
+  kNone,
+  kBox,       // size = x, y, z
+  kCylinder,  // size = radius, length, 0
+  kSphere,    // size = radius, 0, 0
+  kMesh,      // size = scale
+};
+
+struct Geometry
+{
+  GeometryType type;
+  Vector3 size;
+};
+
+struct Link
+{
+  const char * name;
+  double mass;  // 0 for links without <inertial>
+  Origin inertial_origin;
+  Inertia inertia;
+  Geometry collision;  // First <collision> only
+};
+
+enum class JointType
+{
+  kFixed,
+  kContinuous,
+  kRevolute,
+  kPrismatic,
+  kFloating,
+  kPlanar,
+};
+
+struct Joint
+{
+  const char * name;
+  JointType type;
+  const char * parent;
+  const char * child;
+  Origin origin;
+  Vector3 axis;  // In the child frame
+};
+
+// Joint axis expressed in the parent link frame
+constexpr Vector3 axis_in_parent(const Joint & joint)
+{
+  const auto & r = joint.origin.rotation;
+  const auto & a = joint.axis;
+  return Vector3{
+    r[0][0] * a.x + r[0][1] * a.y + r[0][2] * a.z,
+    r[1][0] * a.x + r[1][1] * a.y + r[1][2] * a.z,
+    r[2][0] * a.x + r[2][1] * a.y + r[2][2] * a.z,
+  };
+}
+
+}  // namespace model
+}  // namespace robocap_kinematics
+
+#endif  // ROBOCAP_KINEMATICS__MODEL_HPP_
@@ -0,0 +1,35 @@
+#ifndef ROBOCAP_KINEMATICS__ROBOCAP_LAYOUT_HPP_
+#define ROBOCAP_KINEMATICS__ROBOCAP_LAYOUT_HPP_
+
+#include "robocap_kinematics/kiwi_drive.hpp"
+#include "robocap_kinematics/model.hpp"
+#include "robocap_kinematics/robocap_model.hpp"
+
+namespace robocap_kinematics
+{
+
+// Wheel whose joint sits on the ground plane of base_link. A positive joint velocity spins the
+// wheel about its axle a, which moves the wheel centre along a x z.
+constexpr WheelGeometry model_wheel(const model::Joint & joint)
+{
+  const auto axle = model::axis_in_parent(joint);
+  const double length = detail::sqrt(axle.x * axle.x + axle.y * axle.y);
+  return WheelGeometry{joint.origin.xyz.x, joint.origin.xyz.y, axle.y / length, -axle.x / length};
+}
+
+// Wheel joint origins, axes and radius from the generated robot model, in joint order
+// wheel_1..wheel_3
+constexpr WheelLayout kRobocapLayout{
+  {{
+    model_wheel(robocap_model::joints::wheel_1_joint),
+    model_wheel(robocap_model::joints::wheel_2_joint),
+    model_wheel(robocap_model::joints::wheel_3_joint),
+  }},
+  robocap_model::links::wheel_1.collision.size.x,
+};
+
+constexpr KiwiDrive kRobocapKiwiDrive{kRobocapLayout};
+
+}  // namespace robocap_kinematics
+
+#endif  // ROBOCAP_KINEMATICS__ROBOCAP_LAYOUT_HPP_
@@ -0,0 +1,234 @@
+// Generated from robocap_sim/urdf/robot.urdf.xacro by robocap_sim/tools/generate_model_header.py.
+// Do not edit: the robocap_sim build regenerates it and fails while this copy is stale.
+
+#ifndef ROBOCAP_KINEMATICS__ROBOCAP_MODEL_HPP_
+#define ROBOCAP_KINEMATICS__ROBOCAP_MODEL_HPP_
+
+#include <array>
+
+#include "robocap_kinematics/model.hpp"
+
+namespace robocap_kinematics
+{
+namespace robocap_model
+{
+
+using model::GeometryType;
+using model::Joint;
+using model::JointType;
+using model::Link;
+
+namespace links
+{
+
+constexpr Link base_link{
+  "base_link",
+  0.0,
+  {
+    {0.0, 0.0, 0.0},
+    {0.0, 0.0, 0.0},
+    {{
+      {1.0, 0.0, 0.0},
+      {0.0, 1.0, 0.0},
+      {0.0, 0.0, 1.0},
+    }},
+  },
+  {0.0, 0.0, 0.0, 0.0, 0.0, 0.0},
+  {GeometryType::kNone, {0.0, 0.0, 0.0}},
+};
+
+constexpr Link chassis{
+  "chassis",
+  20.0,
+  {
+    {0.0, 0.0, 0.77},
+    {0.0, 0.0, 0.0},
+    {{
+      {1.0, 0.0, 0.0},
+      {0.0, 1.0, 0.0},
+      {0.0, 0.0, 1.0},
+    }},
+  },
+  {4.2651666666666666, 0.0, 0.0, 4.2651666666666666, 0.0, 0.625},
+  {GeometryType::kMesh, {0.001, 0.001, 0.001}},
+};
+
+constexpr Link laser{
+  "laser",
+  0.0,
+  {
+    {0.0, 0.0, 0.0},
+    {0.0, 0.0, 0.0},
+    {{
+      {1.0, 0.0, 0.0},
+      {0.0, 1.0, 0.0},
+      {0.0, 0.0, 1.0},
+    }},
+  },
+  {0.0, 0.0, 0.0, 0.0, 0.0, 0.0},
+  {GeometryType::kNone, {0.0, 0.0, 0.0}},
+};
+
+constexpr Link wheel_1{
+  "wheel_1",
+  0.2,
+  {
+    {0.0, 0.0, 0.0},
+    {0.0, 0.0, 0.0},
+    {{
+      {1.0, 0.0, 0.0},
+      {0.0, 1.0, 0.0},
+      {0.0, 0.0, 1.0},
+    }},
+  },
+  {0.00014906666666666667, 0.0, 0.0, 0.00014906666666666667, 0.0, 0.00025000000000000006},
+  {GeometryType::kCylinder, {0.05, 0.038, 0.0}},
+};
+
+constexpr Link wheel_2{
+  "wheel_2",
+  0.2,
+  {
+    {0.0, 0.0, 0.0},
+    {0.0, 0.0, 0.0},
+    {{
+      {1.0, 0.0, 0.0},
+      {0.0, 1.0, 0.0},
+      {0.0, 0.0, 1.0},
+    }},
+  },
+  {0.00014906666666666667, 0.0, 0.0, 0.00014906666666666667, 0.0, 0.00025000000000000006},
+  {GeometryType::kCylinder, {0.05, 0.038, 0.0}},
+};
+
+constexpr Link wheel_3{
+  "wheel_3",
+  0.2,
+  {
+    {0.0, 0.0, 0.0},
+    {0.0, 0.0, 0.0},
+    {{
+      {1.0, 0.0, 0.0},
+      {0.0, 1.0, 0.0},
+      {0.0, 0.0, 1.0},
+    }},
+  },
+  {0.00014906666666666667, 0.0, 0.0, 0.00014906666666666667, 0.0, 0.00025000000000000006},
+  {GeometryType::kCylinder, {0.05, 0.038, 0.0}},
+};
+
+}  // namespace links
+
+namespace joints
+{
+
+constexpr Joint chassis_joint{
+  "chassis_joint",
+  JointType::kFixed,
+  "base_link",
+  "chassis",
+  {
+    {0.0, 0.0, 0.0},
+    {0.0, 0.0, 0.0},
+    {{
+      {1.0, 0.0, 0.0},
+      {0.0, 1.0, 0.0},
+      {0.0, 0.0, 1.0},
+    }},
+  },
+  {1.0, 0.0, 0.0},
+};
+
+constexpr Joint laser_joint{
+  "laser_joint",
+  JointType::kFixed,
+  "chassis",
+  "laser",
+  {
+    {0.0, 0.0, 0.07},
+    {0.0, 0.0, 0.0},
+    {{
+      {1.0, 0.0, 0.0},
+      {0.0, 1.0, 0.0},
+      {0.0, 0.0, 1.0},
+    }},
+  },
+  {1.0, 0.0, 0.0},
+};
+
+constexpr Joint wheel_1_joint{
+  "wheel_1_joint",
+  JointType::kContinuous,
+  "base_link",
+  "wheel_1",
+  {
+    {0.2, 0.0, 0.0},
+    {0.0, -1.5707963267948966, 0.0},
+    {{
+      {6.123233995736766e-17, 0.0, -1.0},
+      {0.0, 1.0, 0.0},
+      {1.0, 0.0, 6.123233995736766e-17},
+    }},
+  },
+  {0.0, 0.0, 1.0},
+};
+
+constexpr Joint wheel_2_joint{
+  "wheel_2_joint",
+  JointType::kContinuous,
+  "base_link",
+  "wheel_2",
+  {
+    {-0.1, -0.1732050808, 0.0},
+    {0.0, 1.5707963267948966, 1.0471975511965976},
+    {{
+      {3.0616169978683836e-17, -0.8660254037844386, 0.5000000000000001},
+      {5.302876193624534e-17, 0.5000000000000001, 0.8660254037844386},
+      {-1.0, 0.0, 6.123233995736766e-17},
+    }},
+  },
+  {0.0, 0.0, 1.0},
+};
+
+constexpr Joint wheel_3_joint{
+  "wheel_3_joint",
+  JointType::kContinuous,
+  "base_link",
+  "wheel_3",
+  {
+    {-0.1, 0.1732050808, 0.0},
+    {0.0, 1.5707963267948966, -1.0471975511965976},
+    {{
+      {3.0616169978683836e-17, 0.8660254037844386, 0.5000000000000001},
+      {-5.302876193624534e-17, 0.5000000000000001, -0.8660254037844386},
+      {-1.0, 0.0, 6.123233995736766e-17},
+    }},
+  },
+  {0.0, 0.0, 1.0},
+};
+
+}  // namespace joints
+
+// In URDF order
+constexpr std::array<Link, 6> kLinks{{
+  links::base_link,
+  links::chassis,
+  links::laser,
+  links::wheel_1,
+  links::wheel_2,
+  links::wheel_3,
+}};
+constexpr std::array<Joint, 5> kJoints{{
+  joints::chassis_joint,
+  joints::laser_joint,
+  joints::wheel_1_joint,
+  joints::wheel_2_joint,
+  joints::wheel_3_joint,
+}};
+
+constexpr double kTotalMass = 20.599999999999998;
+
+}  // namespace robocap_model
+}  // namespace robocap_kinematics
+
+#endif  // ROBOCAP_KINEMATICS__ROBOCAP_MODEL_HPP_
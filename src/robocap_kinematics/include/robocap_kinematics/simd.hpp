@@ -0,0 +1,50 @@
+#ifndef ROBOCAP_KINEMATICS__SIMD_HPP_
+#define ROBOCAP_KINEMATICS__SIMD_HPP_
+
+#include <cstddef>
+#include <cstring>
+
+namespace robocap_kinematics
+{
+namespace simd
+{
+
+// Register width picked at compile time. GCC/Clang vector extensions lower to AVX/SSE on x86 and
+// NEON on ARM, so the batched kernels need no per-ISA intrinsics.
+#if defined(__AVX512F__)
+constexpr std::size_t kRegisterBytes = 64;
+#elif defined(__AVX__)
+constexpr std::size_t kRegisterBytes = 32;
+#else
+constexpr std::size_t kRegisterBytes = 16;
+#endif
+
+template<typename T>
+struct Pack
+{
+  static constexpr std::size_t kLanes = kRegisterBytes / sizeof(T);
+  typedef T Vec __attribute__((vector_size(kRegisterBytes)));
+
+  // memcpy compiles to a single unaligned load/store, the arrays need no particular alignment
+  static Vec load(const T * src)
+  {
+    Vec v;
+    std::memcpy(&v, src, sizeof(Vec));
+    return v;
+  }
+
+  static void store(T * dst, const Vec & v)
+  {
+    std::memcpy(dst, &v, sizeof(Vec));
+  }
+
+  static Vec broadcast(T value)
+  {
+    return Vec{} + value;
+  }
+};
+
+}  // namespace simd
+}  // namespace robocap_kinematics
+
+#endif  // ROBOCAP_KINEMATICS__SIMD_HPP_
@@ -0,0 +1,118 @@
+#ifndef ROBOCAP_PERCEPTION__GRID_DELTA_HPP_
+#define ROBOCAP_PERCEPTION__GRID_DELTA_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "robocap_msgs/msg/occupancy_grid_delta.hpp"
+#include "robocap_perception/rolling_grid.hpp"
+
+namespace robocap_perception
+{
+
+// Run-length codes sorted `changes` into message.runs/values, see OccupancyGridDelta.msg
+inline void encode_changes(
+  const std::vector<GridChange> & changes, robocap_msgs::msg::OccupancyGridDelta & message)
+{
+  message.runs.clear();
+  message.values.clear();
+  std::uint32_t next = 0;  // First cell after the previous run
+  for (std::size_t i = 0; i < changes.size(); ) {
+    std::size_t end = i + 1;
+    while (end < changes.size() && changes[end].index == changes[end - 1].index + 1) {
+      ++end;
+    }
+    message.runs.push_back(changes[i].index - next);
+    message.runs.push_back(static_cast<std::uint32_t>(end - i));
+    for (std::size_t j = i; j < end; ++j) {
+      message.values.push_back(changes[j].value);
+    }
+    next = changes[end - 1].index + 1;
+    i = end;
+  }
+}
+
+// Receiver side: mirrors the grid from a stream of deltas
+class GridDeltaDecoder
+{
+public:
+  // False while waiting for a keyframe, after a gap or before the first one
+  bool apply(const robocap_msgs::msg::OccupancyGridDelta & delta)
+  {
+    const bool in_sequence = synced_ && delta.sequence == sequence_ + 1 &&
+      static_cast<int>(delta.size) == size_;
+    if (!delta.keyframe && !in_sequence) {
+      synced_ = false;
+      return false;
+    }
+    if (delta.keyframe && static_cast<int>(delta.size) != size_) {
+      size_ = static_cast<int>(delta.size);
+      cells_.assign(static_cast<std::size_t>(size_) * size_, -1);
+    } else {
+      scroll(delta.origin_x, delta.origin_y);
+    }
+    origin_x_ = delta.origin_x;
+    origin_y_ = delta.origin_y;
+    sequence_ = delta.sequence;
+    synced_ = true;
+
+    std::size_t cell = 0;
+    std::size_t value = 0;
+    for (std::size_t i = 0; i + 1 < delta.runs.size(); i += 2) {
+      cell += delta.runs[i];
+      const std::size_t length = delta.runs[i + 1];
+      if (cell + length > cells_.size() || value + length > delta.values.size()) {
+        synced_ = false;
+        return false;
+      }
+      std::copy_n(delta.values.begin() + value, length, cells_.begin() + cell);
+      cell += length;
+      value += length;
+    }
+    return true;
+  }
+
+  int size() const {return size_;}
+  int origin_x() const {return origin_x_;}
+  int origin_y() const {return origin_y_;}
+  // Row-major, nav_msgs/OccupancyGrid convention
+  const std::vector<std::int8_t> & cells() const {return cells_;}
+
+private:
+  void scroll(int origin_x, int origin_y)
+  {
+    const int dx = origin_x - origin_x_;
+    const int dy = origin_y - origin_y_;
+    if (dx == 0 && dy == 0) {
+      return;
+    }
+    std::vector<std::int8_t> shifted(cells_.size(), -1);
+    for (int y = 0; y < size_; ++y) {
+      const int from_y = y + dy;
+      if (from_y < 0 || from_y >= size_) {
+        continue;
+      }
+      for (int x = 0; x < size_; ++x) {
+        const int from_x = x + dx;
+        if (from_x >= 0 && from_x < size_) {
+          shifted[static_cast<std::size_t>(y) * size_ + x] =
+            cells_[static_cast<std::size_t>(from_y) * size_ + from_x];
+        }
+      }
+    }
+    cells_.swap(shifted);
+  }
+
+  bool synced_ = false;
+  std::uint32_t sequence_ = 0;
+  int size_ = 0;
+  int origin_x_ = 0;
+  int origin_y_ = 0;
+  std::vector<std::int8_t> cells_;
+};
+
+}  // namespace robocap_perception
+
+#endif  // ROBOCAP_PERCEPTION__GRID_DELTA_HPP_
@@ -0,0 +1,51 @@
+#ifndef ROBOCAP_PERCEPTION__POINT_CLOUD_HPP_
+#define ROBOCAP_PERCEPTION__POINT_CLOUD_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "robocap_kinematics/simd.hpp"
+
+namespace robocap_perception
+{
+
+// Structure-of-arrays points for the filter stages. x, y and z are slices of one block allocated
+// in the constructor, each padded to whole SIMD packs so kernels can load the last pack without a
+// scalar tail. Filters shrink the cloud in place; nothing reallocates after construction.
+class PointCloud
+{
+public:
+  static constexpr std::size_t kLanes = robocap_kinematics::simd::Pack<float>::kLanes;
+
+  explicit PointCloud(std::size_t capacity)
+  : capacity_(capacity),
+    stride_((std::max<std::size_t>(capacity, 1) + kLanes - 1) / kLanes * kLanes),
+    storage_(3 * stride_, 0.0f)
+  {
+  }
+
+  std::size_t capacity() const {return capacity_;}
+  std::size_t size() const {return size_;}
+  bool empty() const {return size_ == 0;}
+  // Clamped to capacity(). New points are whatever the slots held before
+  void resize(std::size_t size) {size_ = std::min(size, capacity_);}
+  void clear() {size_ = 0;}
+
+  float * x() {return storage_.data();}
+  float * y() {return storage_.data() + stride_;}
+  float * z() {return storage_.data() + 2 * stride_;}
+  const float * x() const {return storage_.data();}
+  const float * y() const {return storage_.data() + stride_;}
+  const float * z() const {return storage_.data() + 2 * stride_;}
+
+private:
+  std::size_t capacity_;
+  std::size_t stride_;
+  std::size_t size_ = 0;
+  std::vector<float> storage_;
+};
+
+}  // namespace robocap_perception
+
+#endif  // ROBOCAP_PERCEPTION__POINT_CLOUD_HPP_
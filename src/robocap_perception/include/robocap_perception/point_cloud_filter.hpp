@@ -0,0 +1,82 @@
+#ifndef ROBOCAP_PERCEPTION__POINT_CLOUD_FILTER_HPP_
+#define ROBOCAP_PERCEPTION__POINT_CLOUD_FILTER_HPP_
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+#include "sensor_msgs/msg/camera_info.hpp"
+#include "sensor_msgs/msg/image.hpp"
+#include "sensor_msgs/msg/laser_scan.hpp"
+#include "sensor_msgs/msg/point_cloud2.hpp"
+#include "std_msgs/msg/header.hpp"
+#include "tf2_ros/buffer.h"
+#include "tf2_ros/transform_listener.h"
+
+#include "robocap_perception/point_cloud.hpp"
+#include "robocap_perception/point_filters.hpp"
+
+namespace robocap_perception
+{
+
+// Filtering stage between a range sensor and its consumers: "scan" (LaserScan) or "depth/image"
+// (32FC1 metres or 16UC1 millimetres, with "depth/camera_info") becomes an x/y/z PointCloud2 in
+// base_frame on "points". Each frame goes through
+//
+//   temporal median (organized) -> projection -> range -> base_frame -> self -> voxel grid
+//
+// with every stage after the projection working in place on one preallocated PointCloud, and the
+// outgoing message's buffer reserved for `capacity` points up front.
+//
+// Parameters:
+//   source         "scan" (default) or "depth"
+//   base_frame     output frame and the self filter's, defaults to base_link
+//   capacity       points per frame, defaults to 307200 (640x480)
+//   min_range      [m], defaults to 0.1
+//   max_range      [m], defaults to 12.0
+//   median_window  frames, odd, 1 disables, defaults to 3
+//   self_padding   [m] around the chassis cylinder, negative disables the self filter, 0.05
+//   voxel_size     [m], 0 disables, defaults to 0.05
+class PointCloudFilter : public rclcpp::Node
+{
+public:
+  explicit PointCloudFilter(const rclcpp::NodeOptions & options);
+
+private:
+  void on_scan(const sensor_msgs::msg::LaserScan & scan);
+  void on_depth(const sensor_msgs::msg::Image & image);
+  // The shared tail: range limits set, cloud projected in the sensor frame
+  void filter_and_publish(const std_msgs::msg::Header & header);
+
+  std::string base_frame_;
+  float min_range_ = 0.1f;
+  float max_range_ = 12.0f;
+  std::size_t capacity_;
+
+  PointCloud cloud_;
+  TemporalMedianFilter median_;
+  ScanProjector scan_projector_;
+  DepthProjector depth_projector_;
+  FilterChain chain_;
+  RangeFilter * range_filter_ = nullptr;
+  TransformFilter * transform_filter_ = nullptr;
+  // Median output, and 16UC1 depth converted to metres
+  std::vector<float> frame_;
+  std::optional<std::array<double, 4>> intrinsics_;  // fx, fy, cx, cy
+  sensor_msgs::msg::PointCloud2 points_;
+
+  std::unique_ptr<tf2_ros::Buffer> tf_buffer_;
+  std::unique_ptr<tf2_ros::TransformListener> tf_listener_;
+  rclcpp::Publisher<sensor_msgs::msg::PointCloud2>::SharedPtr publisher_;
+  rclcpp::Subscription<sensor_msgs::msg::LaserScan>::SharedPtr scan_subscription_;
+  rclcpp::Subscription<sensor_msgs::msg::Image>::SharedPtr depth_subscription_;
+  rclcpp::Subscription<sensor_msgs::msg::CameraInfo>::SharedPtr camera_info_subscription_;
+};
+
+}  // namespace robocap_perception
+
+#endif  // ROBOCAP_PERCEPTION__POINT_CLOUD_FILTER_HPP_
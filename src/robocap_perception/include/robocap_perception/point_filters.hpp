@@ -0,0 +1,212 @@
+#ifndef ROBOCAP_PERCEPTION__POINT_FILTERS_HPP_
+#define ROBOCAP_PERCEPTION__POINT_FILTERS_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "robocap_perception/point_cloud.hpp"
+
+namespace robocap_perception
+{
+
+// One in-place stage of a FilterChain. apply() may only shrink the cloud or rewrite its points,
+// and must not allocate: anything it needs is sized in its constructor.
+class PointFilter
+{
+public:
+  virtual ~PointFilter() = default;
+  virtual void apply(PointCloud & cloud) = 0;
+};
+
+// Runs its stages in the order they were added, all on the same PointCloud
+class FilterChain
+{
+public:
+  template<typename Filter, typename ... Args>
+  Filter & add(Args && ... args)
+  {
+    auto filter = std::make_unique<Filter>(std::forward<Args>(args)...);
+    auto & stage = *filter;
+    filters_.push_back(std::move(filter));
+    return stage;
+  }
+
+  void apply(PointCloud & cloud)
+  {
+    for (const auto & filter : filters_) {
+      filter->apply(cloud);
+    }
+  }
+
+  std::size_t size() const {return filters_.size();}
+
+private:
+  std::vector<std::unique_ptr<PointFilter>> filters_;
+};
+
+// Keeps points whose distance from the origin lies in [min_range, max_range]. Drops NaN and
+// infinite points, so it belongs first in a chain fed with raw sensor data
+class RangeFilter : public PointFilter
+{
+public:
+  RangeFilter(float min_range, float max_range) {set_limits(min_range, max_range);}
+
+  void set_limits(float min_range, float max_range);
+  void apply(PointCloud & cloud) override;
+
+private:
+  float min_squared_ = 0.0f;
+  float max_squared_ = 0.0f;
+};
+
+// Rigid transform of every point, e.g. from the sensor's frame into base_link
+class TransformFilter : public PointFilter
+{
+public:
+  // Row-major rotation and translation, p' = R p + t
+  using Rotation = std::array<float, 9>;
+  using Translation = std::array<float, 3>;
+
+  TransformFilter() = default;
+
+  void set_transform(const Rotation & rotation, const Translation & translation);
+  void apply(PointCloud & cloud) override;
+
+private:
+  Rotation rotation_{{1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f}};
+  Translation translation_{{0.0f, 0.0f, 0.0f}};
+};
+
+// Removes points on the robot itself: everything inside a vertical cylinder about base_link's z
+// axis, grown by `padding`. Expects points in base_link
+class SelfFilter : public PointFilter
+{
+public:
+  // The chassis' collision cylinder from robocap_kinematics/robocap_model.hpp
+  explicit SelfFilter(float padding = 0.05f);
+  SelfFilter(float radius, float z_min, float z_max);
+
+  float radius() const {return radius_;}
+  float z_min() const {return z_min_;}
+  float z_max() const {return z_max_;}
+
+  void apply(PointCloud & cloud) override;
+
+private:
+  float radius_;
+  float z_min_;
+  float z_max_;
+};
+
+// Replaces the points in each cubic voxel of side `leaf_size` by their centroid, in the order the
+// voxels were first hit. A voxel's slot in the cloud is never past the point that opened it, so
+// the sums accumulate in the cloud itself. The hash table has a generation per slot and is sized
+// once for `capacity` points; a new cloud only bumps the generation instead of clearing it.
+// Drops points too far out for the 21-bit voxel indices, about 50 km at 5 cm
+class VoxelGridFilter : public PointFilter
+{
+public:
+  VoxelGridFilter(float leaf_size, std::size_t capacity);
+
+  float leaf_size() const {return leaf_size_;}
+
+  void apply(PointCloud & cloud) override;
+
+private:
+  struct Slot
+  {
+    std::uint64_t key;
+    std::uint32_t generation;
+    std::uint32_t voxel;
+  };
+
+  float leaf_size_;
+  std::size_t capacity_;
+  std::uint32_t generation_ = 0;
+  std::uint64_t table_mask_ = 0;
+  int table_shift_ = 0;
+  std::vector<Slot> table_;
+  // Per point voxel indices, kInvalid for dropped points
+  std::vector<std::int32_t> cell_x_;
+  std::vector<std::int32_t> cell_y_;
+  std::vector<std::int32_t> cell_z_;
+  // Per voxel point count, float for the final division
+  std::vector<float> counts_;
+};
+
+// Per-element median over the last `window` frames of an organized range image, a LaserScan's
+// ranges or a depth image, before it is turned into points. Removes single-frame speckle without
+// blurring edges. NaN counts as no return (+inf). Until `window` frames were seen, and after the
+// frame size changes, the history is filled with the newest frame
+class TemporalMedianFilter
+{
+public:
+  static constexpr std::size_t kMaxWindow = 9;
+
+  // `window` is odd, at most kMaxWindow. 1 passes frames through. Throws std::invalid_argument
+  TemporalMedianFilter(std::size_t window, std::size_t capacity);
+
+  std::size_t window() const {return window_;}
+
+  // output[i] = median of input[i] and the previous frames' element i, for i < count. output
+  // may be input; neither needs padding
+  void apply(const float * input, float * output, std::size_t count);
+
+private:
+  std::size_t window_;
+  std::size_t capacity_;
+  std::size_t stride_;
+  std::size_t count_ = 0;
+  std::size_t newest_ = 0;
+  std::vector<float> history_;  // [window][stride], a ring of frames
+};
+
+// LaserScan ranges -> points in the scan's frame, with cos/sin per beam cached until the scan
+// geometry changes. Beams past the cloud's capacity are dropped
+class ScanProjector
+{
+public:
+  explicit ScanProjector(std::size_t capacity);
+
+  void project(
+    const float * ranges, std::size_t count, float angle_min, float angle_increment,
+    PointCloud & cloud);
+
+private:
+  std::size_t count_ = 0;
+  float angle_min_ = 0.0f;
+  float angle_increment_ = 0.0f;
+  std::vector<float> cos_;
+  std::vector<float> sin_;
+};
+
+// Pinhole depth image in metres -> points in the camera's optical frame (z forward), with each
+// pixel's ray cached until the intrinsics change. An invalid pixel (0, NaN) becomes a point at
+// the origin or NaN, which a RangeFilter with a positive min_range removes. Rows past the
+// cloud's capacity are dropped
+class DepthProjector
+{
+public:
+  explicit DepthProjector(std::size_t capacity);
+
+  // `row_stride` in elements
+  void project(
+    const float * depth, std::size_t width, std::size_t height, std::size_t row_stride,
+    const std::array<double, 4> & intrinsics, PointCloud & cloud);
+
+private:
+  std::size_t capacity_;
+  std::size_t width_ = 0;
+  std::size_t height_ = 0;
+  std::array<double, 4> intrinsics_{};  // fx, fy, cx, cy
+  std::vector<float> ray_x_;
+  std::vector<float> ray_y_;
+};
+
+}  // namespace robocap_perception
+
+#endif  // ROBOCAP_PERCEPTION__POINT_FILTERS_HPP_
@@ -0,0 +1,112 @@
+#ifndef ROBOCAP_PERCEPTION__ROLLING_GRID_HPP_
+#define ROBOCAP_PERCEPTION__ROLLING_GRID_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "robocap_perception/thread_pool.hpp"
+
+namespace robocap_perception
+{
+
+// One LaserScan, already placed in the grid's frame
+struct ScanRays
+{
+  double origin_x;  // [m] sensor position
+  double origin_y;
+  double yaw;       // [rad] sensor heading
+  float angle_min;
+  float angle_increment;
+  float range_min;
+  float range_max;
+  const float * ranges;
+  std::size_t count;
+};
+
+struct GridChange
+{
+  std::uint32_t index;  // Row-major in the window
+  std::int8_t value;    // nav_msgs/OccupancyGrid convention
+};
+
+// Square log-odds occupancy grid that scrolls with the robot.
+//
+// Cells are stored in 16x16 tiles of one byte each, so one tile is four cache lines and a beam
+// stays within a few lines per tile it crosses. The window scrolls by moving a wrap-around
+// offset, which only clears the rows and columns that enter. A scan goes in two parallel passes:
+//
+//   1. beams, SIMD over kLanes beams at a time: a DDA with unit steps along each beam's major
+//      axis computes storage indices for a whole pack per step, then marks cells free or hit
+//   2. tiles touched by pass 1, one thread per tile: apply the marks to the log-odds once per
+//      scan and record the cells whose published occupancy changed
+//
+// Everything is allocated in the constructor; insert_scan() only grows its beam buffers when a
+// scan has more beams than any before it.
+class RollingGrid
+{
+public:
+  static constexpr int kTileShift = 4;
+  static constexpr int kTile = 1 << kTileShift;
+
+  // `size` cells along each side, rounded up to a whole number of tiles
+  RollingGrid(int size, double resolution, std::size_t workers);
+
+  int size() const {return size_;}
+  double resolution() const {return resolution_;}
+  // Lower-left cell of the window, counted from the frame origin
+  int origin_x() const {return origin_x_;}
+  int origin_y() const {return origin_y_;}
+
+  // Scrolls the window once (x, y) [m] is more than a tile from its centre. Cells that enter are
+  // unknown, both here and for anyone mirroring the published values. Returns whether it moved
+  bool recenter(double x, double y);
+
+  void insert_scan(const ScanRays & scan, ThreadPool & pool);
+
+  // Cells whose published value changed since the last call, sorted by index. Call it after
+  // every insert_scan(), before the window scrolls again
+  void take_changes(std::vector<GridChange> & changes);
+
+  // Published value of window cell (x, y)
+  std::int8_t occupancy(int x, int y) const {return published_[storage_index(x, y)];}
+  // All published values, row-major
+  void snapshot(std::vector<std::int8_t> & values) const;
+
+private:
+  std::size_t storage_index(int x, int y) const;
+  void clear_cell(std::size_t index);
+  void mark_beams(std::size_t begin, std::size_t end);
+  void apply_tiles(std::size_t begin, std::size_t end, std::size_t worker);
+
+  int size_;
+  int tiles_;  // Per side
+  double resolution_;
+  int origin_x_ = 0;
+  int origin_y_ = 0;
+  // Storage column of window column 0, and row of row 0
+  int offset_x_ = 0;
+  int offset_y_ = 0;
+
+  std::vector<std::int8_t> log_odds_;
+  std::vector<std::int8_t> published_;
+  // Per scan: bit 0 free, bit 1 hit. Set concurrently by pass 1
+  std::vector<std::atomic<std::uint8_t>> marks_;
+  std::vector<std::atomic<std::uint8_t>> tile_dirty_;
+  std::vector<std::uint32_t> dirty_tiles_;
+  std::vector<std::vector<GridChange>> worker_changes_;
+
+  // Per-beam DDA setup for pass 1, in window cells
+  std::vector<float> start_x_;
+  std::vector<float> start_y_;
+  std::vector<float> step_x_;
+  std::vector<float> step_y_;
+  std::vector<std::int32_t> steps_;
+  std::vector<std::uint8_t> hit_;
+  std::size_t beams_ = 0;
+};
+
+}  // namespace robocap_perception
+
+#endif  // ROBOCAP_PERCEPTION__ROLLING_GRID_HPP_
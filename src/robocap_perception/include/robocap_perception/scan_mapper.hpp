@@ -0,0 +1,61 @@
+#ifndef ROBOCAP_PERCEPTION__SCAN_MAPPER_HPP_
+#define ROBOCAP_PERCEPTION__SCAN_MAPPER_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+#include "robocap_msgs/msg/occupancy_grid_delta.hpp"
+#include "sensor_msgs/msg/laser_scan.hpp"
+#include "tf2_ros/buffer.h"
+#include "tf2_ros/transform_listener.h"
+
+#include "robocap_perception/rolling_grid.hpp"
+#include "robocap_perception/thread_pool.hpp"
+#include "robocap_runtime/metrics.hpp"
+
+namespace robocap_perception
+{
+
+// Local costmap at the full scan rate: every LaserScan is ray-cast into a RollingGrid centred on
+// the sensor, and only the cells whose occupancy changed go out on "grid_delta" as a run-length
+// coded robocap_msgs/OccupancyGridDelta. A full keyframe every keyframe_interval scans lets a
+// receiver that joined late or dropped a message resynchronize. Each scan's age on arrival goes to
+// robocap_message_age_seconds.
+//
+// Parameters:
+//   frame_id           grid frame, defaults to odom
+//   size               cells per side, defaults to 400
+//   resolution         [m/cell], defaults to 0.05
+//   threads            ray-casting threads including the callback's, 0 (default) for one per core
+//   keyframe_interval  scans between keyframes, defaults to 40 (1 s of lidar)
+class ScanMapper : public rclcpp::Node
+{
+public:
+  explicit ScanMapper(const rclcpp::NodeOptions & options);
+
+private:
+  void on_scan(const sensor_msgs::msg::LaserScan & scan);
+
+  std::string frame_id_;
+  std::uint32_t keyframe_interval_ = 40;
+  std::uint32_t sequence_ = 0;
+
+  ThreadPool pool_;
+  RollingGrid grid_;
+  std::vector<GridChange> changes_;
+  std::vector<std::int8_t> snapshot_;
+  robocap_msgs::msg::OccupancyGridDelta delta_;
+  robocap_runtime::Histogram * scan_age_ = nullptr;
+
+  std::unique_ptr<tf2_ros::Buffer> tf_buffer_;
+  std::unique_ptr<tf2_ros::TransformListener> tf_listener_;
+  rclcpp::Publisher<robocap_msgs::msg::OccupancyGridDelta>::SharedPtr publisher_;
+  rclcpp::Subscription<sensor_msgs::msg::LaserScan>::SharedPtr subscription_;
+};
+
+}  // namespace robocap_perception
+
+#endif  // ROBOCAP_PERCEPTION__SCAN_MAPPER_HPP_
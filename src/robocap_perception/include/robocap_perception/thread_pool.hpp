@@ -0,0 +1,69 @@
+#ifndef ROBOCAP_PERCEPTION__THREAD_POOL_HPP_
+#define ROBOCAP_PERCEPTION__THREAD_POOL_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace robocap_perception
+{
+
+// Fork-join pool for data-parallel loops. The calling thread works too, and a loop body is passed
+// as a plain function pointer plus context, so parallel_for() never allocates.
+class ThreadPool
+{
+public:
+  // `threads` counts the caller, 0 means one per hardware thread
+  explicit ThreadPool(std::size_t threads = 0);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool & operator=(const ThreadPool &) = delete;
+
+  // Threads taking part in a loop, worker ids are [0, size())
+  std::size_t size() const {return threads_.size() + 1;}
+
+  // Calls body(begin, end, worker) over [0, count) in chunks of `chunk`, handed out dynamically,
+  // and returns once all of them finished. Not reentrant
+  template<typename Body>
+  void parallel_for(std::size_t count, std::size_t chunk, Body && body)
+  {
+    using Decayed = std::remove_reference_t<Body>;
+    run(
+      count, chunk == 0 ? 1 : chunk,
+      [](void * context, std::size_t begin, std::size_t end, std::size_t worker) {
+        (*static_cast<Decayed *>(context))(begin, end, worker);
+      },
+      const_cast<void *>(static_cast<const void *>(&body)));
+  }
+
+private:
+  using Invoke = void (*)(void * context, std::size_t begin, std::size_t end, std::size_t worker);
+
+  void run(std::size_t count, std::size_t chunk, Invoke invoke, void * context);
+  void work(std::size_t worker);
+  void worker_loop(std::size_t worker);
+
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable finished_;
+  std::uint64_t generation_ = 0;
+  std::size_t running_ = 0;
+  bool stop_ = false;
+
+  // The current loop, published to the workers under mutex_
+  std::size_t count_ = 0;
+  std::size_t chunk_ = 1;
+  Invoke invoke_ = nullptr;
+  void * context_ = nullptr;
+  alignas(64) std::atomic<std::size_t> next_{0};
+};
+
+}  // namespace robocap_perception
+
+#endif  // ROBOCAP_PERCEPTION__THREAD_POOL_HPP_
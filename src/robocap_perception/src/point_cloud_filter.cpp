@@ -0,0 +1,204 @@
+#include "robocap_perception/point_cloud_filter.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "robocap_tracing/tracing.hpp"
+#include "sensor_msgs/msg/point_field.hpp"
+#include "tf2/exceptions.h"
+
+namespace robocap_perception
+{
+
+namespace
+{
+
+constexpr std::size_t kPointStep = 3 * sizeof(float);
+constexpr float kMillimetres = 1e-3f;
+
+}  // namespace
+
+PointCloudFilter::PointCloudFilter(const rclcpp::NodeOptions & options)
+: rclcpp::Node("point_cloud_filter", options),
+  capacity_(static_cast<std::size_t>(std::max<std::int64_t>(
+      1, declare_parameter<int>("capacity", 640 * 480)))),
+  cloud_(capacity_),
+  median_(static_cast<std::size_t>(declare_parameter<int>("median_window", 3)), capacity_),
+  scan_projector_(capacity_),
+  depth_projector_(capacity_),
+  frame_(capacity_, 0.0f)
+{
+  const auto source = declare_parameter<std::string>("source", "scan");
+  if (source != "scan" && source != "depth") {
+    throw std::invalid_argument("PointCloudFilter: 'source' must be scan or depth");
+  }
+  base_frame_ = declare_parameter<std::string>("base_frame", "base_link");
+  min_range_ = static_cast<float>(declare_parameter<double>("min_range", min_range_));
+  max_range_ = static_cast<float>(declare_parameter<double>("max_range", max_range_));
+  const auto self_padding = declare_parameter<double>("self_padding", 0.05);
+  const auto voxel_size = declare_parameter<double>("voxel_size", 0.05);
+
+  range_filter_ = &chain_.add<RangeFilter>(min_range_, max_range_);
+  transform_filter_ = &chain_.add<TransformFilter>();
+  if (self_padding >= 0.0) {
+    chain_.add<SelfFilter>(static_cast<float>(self_padding));
+  }
+  if (voxel_size > 0.0) {
+    chain_.add<VoxelGridFilter>(static_cast<float>(voxel_size), capacity_);
+  }
+
+  points_.header.frame_id = base_frame_;
+  points_.height = 1;
+  points_.is_bigendian = false;
+  points_.is_dense = true;
+  points_.point_step = kPointStep;
+  for (const char * name : {"x", "y", "z"}) {
+    sensor_msgs::msg::PointField field;
+    field.name = name;
+    field.offset = static_cast<std::uint32_t>(points_.fields.size() * sizeof(float));
+    field.datatype = sensor_msgs::msg::PointField::FLOAT32;
+    field.count = 1;
+    points_.fields.push_back(field);
+  }
+  points_.data.reserve(capacity_ * kPointStep);
+
+  tf_buffer_ = std::make_unique<tf2_ros::Buffer>(get_clock());
+  tf_listener_ = std::make_unique<tf2_ros::TransformListener>(*tf_buffer_);
+  publisher_ = create_publisher<sensor_msgs::msg::PointCloud2>("points", rclcpp::SensorDataQoS());
+  if (source == "scan") {
+    scan_subscription_ = create_subscription<sensor_msgs::msg::LaserScan>(
+      "scan", rclcpp::SensorDataQoS(),
+      [this](const sensor_msgs::msg::LaserScan::ConstSharedPtr msg) {on_scan(*msg);});
+  } else {
+    camera_info_subscription_ = create_subscription<sensor_msgs::msg::CameraInfo>(
+      "depth/camera_info", rclcpp::SensorDataQoS(),
+      [this](const sensor_msgs::msg::CameraInfo::ConstSharedPtr msg) {
+        intrinsics_ = std::array<double, 4>{msg->k[0], msg->k[4], msg->k[2], msg->k[5]};
+      });
+    depth_subscription_ = create_subscription<sensor_msgs::msg::Image>(
+      "depth/image", rclcpp::SensorDataQoS(),
+      [this](const sensor_msgs::msg::Image::ConstSharedPtr msg) {on_depth(*msg);});
+  }
+  RCLCPP_INFO(
+    get_logger(), "Filtering %s into '%s', %zu stages, median over %zu frames", source.c_str(),
+    base_frame_.c_str(), chain_.size(), median_.window());
+  ROBOCAP_TRACEPOINT(component_init, this, get_fully_qualified_name());
+}
+
+void PointCloudFilter::on_scan(const sensor_msgs::msg::LaserScan & scan)
+{
+  ROBOCAP_TRACEPOINT(processing_start, this, rclcpp::Time(scan.header.stamp).nanoseconds());
+  const std::size_t count = std::min(scan.ranges.size(), capacity_);
+  const float * ranges = scan.ranges.data();
+  if (median_.window() > 1) {
+    median_.apply(ranges, frame_.data(), count);
+    ranges = frame_.data();
+  }
+  scan_projector_.project(ranges, count, scan.angle_min, scan.angle_increment, cloud_);
+  range_filter_->set_limits(
+    std::max(min_range_, scan.range_min), std::min(max_range_, scan.range_max));
+  filter_and_publish(scan.header);
+}
+
+void PointCloudFilter::on_depth(const sensor_msgs::msg::Image & image)
+{
+  ROBOCAP_TRACEPOINT(processing_start, this, rclcpp::Time(image.header.stamp).nanoseconds());
+  const bool millimetres = image.encoding == "16UC1";
+  const std::size_t pixel_size = millimetres ? sizeof(std::uint16_t) : sizeof(float);
+  const char * problem = nullptr;
+  if (!intrinsics_) {
+    problem = "no camera_info yet";
+  } else if (!millimetres && image.encoding != "32FC1") {
+    problem = "only 32FC1 and 16UC1 are supported";
+  } else if (image.width == 0 || image.step < image.width * pixel_size ||
+    image.data.size() < static_cast<std::size_t>(image.step) * image.height)
+  {
+    problem = "malformed image";
+  }
+  if (problem) {
+    RCLCPP_WARN_THROTTLE(get_logger(), *get_clock(), 5000, "Dropping depth image: %s", problem);
+    ROBOCAP_TRACEPOINT(processing_end, this);
+    return;
+  }
+  const std::size_t width = image.width;
+  const std::size_t height = std::min<std::size_t>(image.height, capacity_ / width);
+  const std::size_t pixels = width * height;
+
+  // Dense 32FC1 is read where it lies, anything else is unpacked into frame_ first
+  const float * depth = frame_.data();
+  if (!millimetres && image.step == width * sizeof(float)) {
+    depth = reinterpret_cast<const float *>(image.data.data());
+  } else {
+    for (std::size_t v = 0; v < height; ++v) {
+      const std::uint8_t * row = image.data.data() + v * image.step;
+      float * out = frame_.data() + v * width;
+      if (millimetres) {
+        for (std::size_t u = 0; u < width; ++u) {
+          std::uint16_t value;
+          std::memcpy(&value, row + u * sizeof(value), sizeof(value));
+          out[u] = static_cast<float>(value) * kMillimetres;
+        }
+      } else {
+        std::memcpy(out, row, width * sizeof(float));
+      }
+    }
+  }
+  if (median_.window() > 1) {
+    median_.apply(depth, frame_.data(), pixels);
+    depth = frame_.data();
+  }
+  depth_projector_.project(depth, width, height, width, *intrinsics_, cloud_);
+  range_filter_->set_limits(min_range_, max_range_);
+  filter_and_publish(image.header);
+}
+
+void PointCloudFilter::filter_and_publish(const std_msgs::msg::Header & header)
+{
+  geometry_msgs::msg::TransformStamped sensor;
+  try {
+    sensor = tf_buffer_->lookupTransform(base_frame_, header.frame_id, header.stamp);
+  } catch (const tf2::TransformException & e) {
+    RCLCPP_WARN_THROTTLE(get_logger(), *get_clock(), 5000, "Dropping frame: %s", e.what());
+    ROBOCAP_TRACEPOINT(processing_end, this);
+    return;
+  }
+  const auto & q = sensor.transform.rotation;
+  const auto & t = sensor.transform.translation;
+  transform_filter_->set_transform(
+    {
+      static_cast<float>(1.0 - 2.0 * (q.y * q.y + q.z * q.z)),
+      static_cast<float>(2.0 * (q.x * q.y - q.w * q.z)),
+      static_cast<float>(2.0 * (q.x * q.z + q.w * q.y)),
+      static_cast<float>(2.0 * (q.x * q.y + q.w * q.z)),
+      static_cast<float>(1.0 - 2.0 * (q.x * q.x + q.z * q.z)),
+      static_cast<float>(2.0 * (q.y * q.z - q.w * q.x)),
+      static_cast<float>(2.0 * (q.x * q.z - q.w * q.y)),
+      static_cast<float>(2.0 * (q.y * q.z + q.w * q.x)),
+      static_cast<float>(1.0 - 2.0 * (q.x * q.x + q.y * q.y)),
+    },
+    {static_cast<float>(t.x), static_cast<float>(t.y), static_cast<float>(t.z)});
+  chain_.apply(cloud_);
+
+  // Interleave into the reserved message buffer
+  const std::size_t count = cloud_.size();
+  points_.header.stamp = header.stamp;
+  points_.width = static_cast<std::uint32_t>(count);
+  points_.row_step = static_cast<std::uint32_t>(count * kPointStep);
+  points_.data.resize(count * kPointStep);
+  std::uint8_t * out = points_.data.data();
+  for (std::size_t i = 0; i < count; ++i, out += kPointStep) {
+    const float point[3] = {cloud_.x()[i], cloud_.y()[i], cloud_.z()[i]};
+    std::memcpy(out, point, kPointStep);
+  }
+  publisher_->publish(points_);
+  ROBOCAP_TRACEPOINT(processing_end, this);
+}
+
+}  // namespace robocap_perception
+
+#include "rclcpp_components/register_node_macro.hpp"
+
+RCLCPP_COMPONENTS_REGISTER_NODE(robocap_perception::PointCloudFilter)
@@ -0,0 +1,490 @@
+#include "robocap_perception/point_filters.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include "robocap_kinematics/kiwi_drive.hpp"
+#include "robocap_kinematics/robocap_model.hpp"
+#include "robocap_kinematics/simd.hpp"
+
+namespace robocap_perception
+{
+
+namespace
+{
+
+namespace model = robocap_kinematics::robocap_model;
+
+using FloatPack = robocap_kinematics::simd::Pack<float>;
+using IntPack = robocap_kinematics::simd::Pack<std::int32_t>;
+using Vec = FloatPack::Vec;
+using Mask = decltype(Vec{} < Vec{});
+static_assert(FloatPack::kLanes == IntPack::kLanes, "point lanes must match mask lanes");
+constexpr std::size_t kLanes = FloatPack::kLanes;
+
+// Voxel indices are biased into 21 unsigned bits each to form one 64-bit key
+constexpr int kCellBits = 21;
+constexpr std::int32_t kCellBias = 1 << (kCellBits - 1);
+constexpr std::int32_t kInvalid = std::numeric_limits<std::int32_t>::min();
+
+// The chassis link is fixed to base_link without rotation. Its collision is the inertial
+// cylinder from robot_core.xacro, but the generated header only records a mesh for it (the built
+// model uses convex hulls), so recover the cylinder from the inertia when needed:
+// izz = m r^2 / 2 and ixx = m (3 r^2 + l^2) / 12
+constexpr const auto & kChassis = model::links::chassis;
+constexpr bool kCylinderCollision = kChassis.collision.type == model::GeometryType::kCylinder;
+constexpr double kChassisRadius = kCylinderCollision ? kChassis.collision.size.x :
+  robocap_kinematics::detail::sqrt(2.0 * kChassis.inertia.izz / kChassis.mass);
+constexpr double kChassisLength = kCylinderCollision ? kChassis.collision.size.y :
+  robocap_kinematics::detail::sqrt(
+  12.0 * kChassis.inertia.ixx / kChassis.mass - 3.0 * kChassisRadius * kChassisRadius);
+constexpr double kChassisCenter =
+  model::joints::chassis_joint.origin.xyz.z + kChassis.inertial_origin.xyz.z;
+
+Vec select(const Mask & mask, const Vec & a, const Vec & b)
+{
+  return reinterpret_cast<Vec>(
+    (mask & reinterpret_cast<Mask>(a)) | (~mask & reinterpret_cast<Mask>(b)));
+}
+
+// Loads up to kLanes values from a buffer without padding, the rest of the pack is `fill`
+Vec load_partial(const float * src, std::size_t lanes, float fill)
+{
+  if (lanes == kLanes) {
+    return FloatPack::load(src);
+  }
+  float values[kLanes];
+  std::fill(values, values + kLanes, fill);
+  std::memcpy(values, src, lanes * sizeof(float));
+  return FloatPack::load(values);
+}
+
+void store_partial(float * dst, const Vec & value, std::size_t lanes)
+{
+  if (lanes == kLanes) {
+    FloatPack::store(dst, value);
+    return;
+  }
+  float values[kLanes];
+  FloatPack::store(values, value);
+  std::memcpy(dst, values, lanes * sizeof(float));
+}
+
+// Stream compaction shared by the filters that drop points: keep(x, y, z) returns a lane mask per
+// pack, and the kept points move down in place. Whole packs kept or dropped, the common case on
+// real frames, move as packs; in a mixed pack every lane is written and only kept ones advance
+// the output, so there is no branch per point. The output never passes the pack being read
+template<typename Keep>
+void compact(PointCloud & cloud, Keep && keep)
+{
+  float * x = cloud.x();
+  float * y = cloud.y();
+  float * z = cloud.z();
+  const std::size_t count = cloud.size();
+  std::size_t out = 0;
+  float px[kLanes], py[kLanes], pz[kLanes];
+  std::int32_t kept[kLanes];
+  for (std::size_t first = 0; first < count; first += kLanes) {
+    const Vec vx = FloatPack::load(x + first);
+    const Vec vy = FloatPack::load(y + first);
+    const Vec vz = FloatPack::load(z + first);
+    const Mask mask = keep(vx, vy, vz);
+    std::memcpy(kept, &mask, sizeof(kept));
+    const std::size_t lanes = std::min(kLanes, count - first);
+    std::int32_t all = -1;
+    std::int32_t any = 0;
+    for (std::size_t lane = 0; lane < kLanes; ++lane) {
+      all &= kept[lane];
+      any |= kept[lane];
+    }
+    if (lanes == kLanes && all) {
+      FloatPack::store(x + out, vx);
+      FloatPack::store(y + out, vy);
+      FloatPack::store(z + out, vz);
+      out += kLanes;
+      continue;
+    }
+    if (!any) {
+      continue;
+    }
+    FloatPack::store(px, vx);
+    FloatPack::store(py, vy);
+    FloatPack::store(pz, vz);
+    for (std::size_t lane = 0; lane < lanes; ++lane) {
+      x[out] = px[lane];
+      y[out] = py[lane];
+      z[out] = pz[lane];
+      out += static_cast<std::size_t>(kept[lane] & 1);
+    }
+  }
+  cloud.resize(out);
+}
+
+// Largest voxel index magnitude whose float is still exact enough to floor
+constexpr float kCellLimit = static_cast<float>(kCellBias - 1);
+
+IntPack::Vec floor_cells(const Vec & value, const Vec & inverse_leaf, Mask & valid)
+{
+  const Vec scaled = value * inverse_leaf;
+  valid &= (scaled > -kCellLimit) & (scaled < kCellLimit);
+  // Zero the lanes out of range before converting, converting them is undefined
+  const Vec safe = reinterpret_cast<Vec>(valid & reinterpret_cast<Mask>(scaled));
+  const auto truncated = __builtin_convertvector(safe, IntPack::Vec);
+  // Truncation rounds negative values up, take one off where it did
+  return truncated + (__builtin_convertvector(truncated, Vec) > safe);
+}
+
+// Median of frames[0, Window) by an odd-even transposition sort, unrolled per window size
+template<std::size_t Window>
+Vec median(Vec * frames)
+{
+  for (std::size_t pass = 0; pass < Window; ++pass) {
+    for (std::size_t i = pass % 2; i + 1 < Window; i += 2) {
+      const Mask swap = frames[i] > frames[i + 1];
+      const Vec low = select(swap, frames[i + 1], frames[i]);
+      frames[i + 1] = select(swap, frames[i], frames[i + 1]);
+      frames[i] = low;
+    }
+  }
+  return frames[Window / 2];
+}
+
+std::uint64_t cell_key(std::int32_t x, std::int32_t y, std::int32_t z)
+{
+  constexpr std::uint64_t kMask = (std::uint64_t{1} << kCellBits) - 1;
+  return (static_cast<std::uint64_t>(x + kCellBias) & kMask) |
+         ((static_cast<std::uint64_t>(y + kCellBias) & kMask) << kCellBits) |
+         ((static_cast<std::uint64_t>(z + kCellBias) & kMask) << (2 * kCellBits));
+}
+
+}  // namespace
+
+void RangeFilter::set_limits(float min_range, float max_range)
+{
+  min_squared_ = min_range > 0.0f ? min_range * min_range : 0.0f;
+  max_squared_ = max_range * max_range;
+}
+
+void RangeFilter::apply(PointCloud & cloud)
+{
+  const Vec min_squared = FloatPack::broadcast(min_squared_);
+  const Vec max_squared = FloatPack::broadcast(max_squared_);
+  compact(
+    cloud, [&](const Vec & x, const Vec & y, const Vec & z) {
+      const Vec squared = x * x + y * y + z * z;
+      // False for NaN, and for infinity unless max_range is
+      return (squared >= min_squared) & (squared <= max_squared);
+    });
+}
+
+void TransformFilter::set_transform(const Rotation & rotation, const Translation & translation)
+{
+  rotation_ = rotation;
+  translation_ = translation;
+}
+
+void TransformFilter::apply(PointCloud & cloud)
+{
+  Vec r[9];
+  for (std::size_t i = 0; i < 9; ++i) {
+    r[i] = FloatPack::broadcast(rotation_[i]);
+  }
+  const Vec tx = FloatPack::broadcast(translation_[0]);
+  const Vec ty = FloatPack::broadcast(translation_[1]);
+  const Vec tz = FloatPack::broadcast(translation_[2]);
+  float * x = cloud.x();
+  float * y = cloud.y();
+  float * z = cloud.z();
+  // Whole packs, the padding past size() is scratch
+  for (std::size_t first = 0; first < cloud.size(); first += kLanes) {
+    const Vec px = FloatPack::load(x + first);
+    const Vec py = FloatPack::load(y + first);
+    const Vec pz = FloatPack::load(z + first);
+    FloatPack::store(x + first, r[0] * px + r[1] * py + r[2] * pz + tx);
+    FloatPack::store(y + first, r[3] * px + r[4] * py + r[5] * pz + ty);
+    FloatPack::store(z + first, r[6] * px + r[7] * py + r[8] * pz + tz);
+  }
+}
+
+SelfFilter::SelfFilter(float padding)
+: SelfFilter(
+    static_cast<float>(kChassisRadius) + padding,
+    static_cast<float>(kChassisCenter - 0.5 * kChassisLength) - padding,
+    static_cast<float>(kChassisCenter + 0.5 * kChassisLength) + padding)
+{
+}
+
+SelfFilter::SelfFilter(float radius, float z_min, float z_max)
+: radius_(radius), z_min_(z_min), z_max_(z_max)
+{
+}
+
+void SelfFilter::apply(PointCloud & cloud)
+{
+  const Vec radius_squared = FloatPack::broadcast(radius_ * radius_);
+  const Vec z_min = FloatPack::broadcast(z_min_);
+  const Vec z_max = FloatPack::broadcast(z_max_);
+  compact(
+    cloud, [&](const Vec & x, const Vec & y, const Vec & z) {
+      return (x * x + y * y > radius_squared) | (z < z_min) | (z > z_max);
+    });
+}
+
+VoxelGridFilter::VoxelGridFilter(float leaf_size, std::size_t capacity)
+: leaf_size_(leaf_size),
+  capacity_(capacity)
+{
+  if (!(leaf_size > 0.0f)) {
+    throw std::invalid_argument("VoxelGridFilter: leaf_size must be positive");
+  }
+  // Open addressing at most half full
+  std::size_t slots = 16;
+  table_shift_ = 64 - 4;
+  while (slots < 2 * capacity) {
+    slots *= 2;
+    --table_shift_;
+  }
+  table_mask_ = slots - 1;
+  table_.assign(slots, Slot{0, 0, 0});
+  const std::size_t padded = (std::max<std::size_t>(capacity, 1) + kLanes - 1) / kLanes * kLanes;
+  cell_x_.assign(padded, 0);
+  cell_y_.assign(padded, 0);
+  cell_z_.assign(padded, 0);
+  counts_.assign(padded, 0.0f);
+}
+
+void VoxelGridFilter::apply(PointCloud & cloud)
+{
+  const std::size_t count = std::min(cloud.size(), capacity_);
+  if (++generation_ == 0) {
+    // Wrapped after 2^32 clouds, stale slots could look current
+    for (auto & slot : table_) {
+      slot.generation = 0;
+    }
+    generation_ = 1;
+  }
+  float * x = cloud.x();
+  float * y = cloud.y();
+  float * z = cloud.z();
+
+  // Voxel indices, SIMD
+  const Vec inverse_leaf = FloatPack::broadcast(1.0f / leaf_size_);
+  const auto invalid = IntPack::broadcast(kInvalid);
+  for (std::size_t first = 0; first < count; first += kLanes) {
+    Mask valid = IntPack::broadcast(-1);
+    const auto cx = floor_cells(FloatPack::load(x + first), inverse_leaf, valid);
+    const auto cy = floor_cells(FloatPack::load(y + first), inverse_leaf, valid);
+    const auto cz = floor_cells(FloatPack::load(z + first), inverse_leaf, valid);
+    IntPack::store(&cell_x_[first], (valid & cx) | (~valid & invalid));
+    IntPack::store(&cell_y_[first], cy);
+    IntPack::store(&cell_z_[first], cz);
+  }
+
+  // Hashing, scalar. Voxel v opens at a point index >= v and every point below that index was
+  // read already, so slot v of the cloud is free to hold the voxel's sums. Neighbouring points of
+  // a scan or an image row mostly share a voxel, so the current one's sums stay in registers and
+  // only go to its slot when the voxel changes
+  std::uint32_t voxels = 0;
+  std::uint64_t current_key = 0;
+  std::uint32_t current = 0;
+  bool open = false;
+  float sx = 0.0f, sy = 0.0f, sz = 0.0f, n = 0.0f;
+  const auto flush = [&]() {
+      x[current] += sx;
+      y[current] += sy;
+      z[current] += sz;
+      counts_[current] += n;
+    };
+  for (std::size_t i = 0; i < count; ++i) {
+    if (cell_x_[i] == kInvalid) {
+      continue;
+    }
+    const float px = x[i], py = y[i], pz = z[i];
+    const auto key = cell_key(cell_x_[i], cell_y_[i], cell_z_[i]);
+    if (open && key == current_key) {
+      sx += px;
+      sy += py;
+      sz += pz;
+      n += 1.0f;
+      continue;
+    }
+    if (open) {
+      flush();
+    }
+    auto index = (key * 0x9E3779B97F4A7C15ull) >> table_shift_;
+    while (table_[index].generation == generation_ && table_[index].key != key) {
+      index = (index + 1) & table_mask_;
+    }
+    auto & slot = table_[index];
+    if (slot.generation != generation_) {
+      slot = Slot{key, generation_, voxels};
+      x[voxels] = 0.0f;
+      y[voxels] = 0.0f;
+      z[voxels] = 0.0f;
+      counts_[voxels] = 0.0f;
+      ++voxels;
+    }
+    current_key = key;
+    current = slot.voxel;
+    open = true;
+    sx = px;
+    sy = py;
+    sz = pz;
+    n = 1.0f;
+  }
+  if (open) {
+    flush();
+  }
+
+  // Centroids, SIMD. Padding lanes divide garbage by garbage and are never read
+  for (std::size_t first = 0; first < voxels; first += kLanes) {
+    const Vec inverse = FloatPack::broadcast(1.0f) / select(
+      FloatPack::load(&counts_[first]) > FloatPack::broadcast(0.0f),
+      FloatPack::load(&counts_[first]), FloatPack::broadcast(1.0f));
+    FloatPack::store(x + first, FloatPack::load(x + first) * inverse);
+    FloatPack::store(y + first, FloatPack::load(y + first) * inverse);
+    FloatPack::store(z + first, FloatPack::load(z + first) * inverse);
+  }
+  cloud.resize(voxels);
+}
+
+TemporalMedianFilter::TemporalMedianFilter(std::size_t window, std::size_t capacity)
+: window_(window),
+  capacity_(capacity),
+  stride_((std::max<std::size_t>(capacity, 1) + kLanes - 1) / kLanes * kLanes)
+{
+  if (window == 0 || window % 2 == 0 || window > kMaxWindow) {
+    throw std::invalid_argument("TemporalMedianFilter: window must be odd and at most 9");
+  }
+  history_.assign(window_ * stride_, 0.0f);
+}
+
+void TemporalMedianFilter::apply(const float * input, float * output, std::size_t count)
+{
+  count = std::min(count, capacity_);
+  if (window_ == 1) {
+    if (output != input) {
+      std::memcpy(output, input, count * sizeof(float));
+    }
+    return;
+  }
+
+  const Vec infinity = FloatPack::broadcast(std::numeric_limits<float>::infinity());
+  const bool restart = count != count_;
+  newest_ = restart ? 0 : (newest_ + 1) % window_;
+  count_ = count;
+  for (std::size_t first = 0; first < count; first += kLanes) {
+    const std::size_t lanes = std::min(kLanes, count - first);
+    Vec value = load_partial(input + first, lanes, 0.0f);
+    value = select(value != value, infinity, value);
+    if (restart) {
+      for (std::size_t frame = 0; frame < window_; ++frame) {
+        FloatPack::store(&history_[frame * stride_ + first], value);
+      }
+    } else {
+      FloatPack::store(&history_[newest_ * stride_ + first], value);
+    }
+
+    Vec frames[kMaxWindow];
+    for (std::size_t frame = 0; frame < window_; ++frame) {
+      frames[frame] = FloatPack::load(&history_[frame * stride_ + first]);
+    }
+    Vec result;
+    switch (window_) {
+      case 3: result = median<3>(frames); break;
+      case 5: result = median<5>(frames); break;
+      case 7: result = median<7>(frames); break;
+      default: result = median<9>(frames); break;
+    }
+    store_partial(output + first, result, lanes);
+  }
+}
+
+ScanProjector::ScanProjector(std::size_t capacity)
+: cos_((std::max<std::size_t>(capacity, 1) + kLanes - 1) / kLanes * kLanes, 0.0f),
+  sin_(cos_.size(), 0.0f)
+{
+}
+
+void ScanProjector::project(
+  const float * ranges, std::size_t count, float angle_min, float angle_increment,
+  PointCloud & cloud)
+{
+  count = std::min({count, cloud.capacity(), cos_.size()});
+  if (count != count_ || angle_min != angle_min_ || angle_increment != angle_increment_) {
+    for (std::size_t i = 0; i < count; ++i) {
+      const double angle = angle_min + static_cast<double>(i) * angle_increment;
+      cos_[i] = static_cast<float>(std::cos(angle));
+      sin_[i] = static_cast<float>(std::sin(angle));
+    }
+    count_ = count;
+    angle_min_ = angle_min;
+    angle_increment_ = angle_increment;
+  }
+
+  float * x = cloud.x();
+  float * y = cloud.y();
+  float * z = cloud.z();
+  const Vec zero = FloatPack::broadcast(0.0f);
+  for (std::size_t first = 0; first < count; first += kLanes) {
+    const Vec range = load_partial(ranges + first, std::min(kLanes, count - first), 0.0f);
+    FloatPack::store(x + first, range * FloatPack::load(&cos_[first]));
+    FloatPack::store(y + first, range * FloatPack::load(&sin_[first]));
+    FloatPack::store(z + first, zero);
+  }
+  cloud.resize(count);
+}
+
+DepthProjector::DepthProjector(std::size_t capacity)
+: capacity_(capacity),
+  // A row's last pack may load up to kLanes - 1 rays past the image
+  ray_x_(std::max<std::size_t>(capacity, 1) + kLanes, 0.0f),
+  ray_y_(ray_x_.size(), 0.0f)
+{
+}
+
+void DepthProjector::project(
+  const float * depth, std::size_t width, std::size_t height, std::size_t row_stride,
+  const std::array<double, 4> & intrinsics, PointCloud & cloud)
+{
+  const std::size_t limit = std::min(capacity_, cloud.capacity());
+  if (width == 0 || width > limit) {
+    cloud.clear();
+    return;
+  }
+  height = std::min(height, limit / width);
+  if (width != width_ || height != height_ || intrinsics != intrinsics_) {
+    const double fx = intrinsics[0], fy = intrinsics[1], cx = intrinsics[2], cy = intrinsics[3];
+    for (std::size_t v = 0; v < height; ++v) {
+      for (std::size_t u = 0; u < width; ++u) {
+        ray_x_[v * width + u] = static_cast<float>((static_cast<double>(u) - cx) / fx);
+        ray_y_[v * width + u] = static_cast<float>((static_cast<double>(v) - cy) / fy);
+      }
+    }
+    width_ = width;
+    height_ = height;
+    intrinsics_ = intrinsics;
+  }
+
+  float * x = cloud.x();
+  float * y = cloud.y();
+  float * z = cloud.z();
+  for (std::size_t v = 0; v < height; ++v) {
+    const float * row = depth + v * row_stride;
+    const std::size_t base = v * width;
+    for (std::size_t u = 0; u < width; u += kLanes) {
+      // Rows are not pack aligned, the last pack of one only stores its own lanes
+      const std::size_t lanes = std::min(kLanes, width - u);
+      const Vec d = load_partial(row + u, lanes, 0.0f);
+      store_partial(x + base + u, d * FloatPack::load(&ray_x_[base + u]), lanes);
+      store_partial(y + base + u, d * FloatPack::load(&ray_y_[base + u]), lanes);
+      store_partial(z + base + u, d, lanes);
+    }
+  }
+  cloud.resize(width * height);
+}
+
+}  // namespace robocap_perception
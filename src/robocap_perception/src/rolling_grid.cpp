@@ -0,0 +1,335 @@
+#include "robocap_perception/rolling_grid.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+
+#include "robocap_kinematics/simd.hpp"
+
+namespace robocap_perception
+{
+
+namespace
+{
+
+using FloatPack = robocap_kinematics::simd::Pack<float>;
+using IntPack = robocap_kinematics::simd::Pack<std::int32_t>;
+static_assert(FloatPack::kLanes == IntPack::kLanes, "beam lanes must match index lanes");
+constexpr std::size_t kLanes = FloatPack::kLanes;
+
+constexpr std::uint8_t kFree = 1;
+constexpr std::uint8_t kHit = 2;
+
+// Log-odds in units of kLogOddsScale, so one byte spans p = 0.007 .. 0.993
+constexpr std::int8_t kUnknown = -128;
+constexpr int kHitUpdate = 20;    // p = 0.73
+constexpr int kFreeUpdate = -7;   // p = 0.41
+constexpr int kClamp = 100;
+constexpr double kLogOddsScale = 0.05;
+
+// Beam packs handed to a thread at a time
+constexpr std::size_t kPacksPerChunk = 8;
+
+// Published value for every log-odds byte
+const std::array<std::int8_t, 256> & occupancy_table()
+{
+  static const auto table = [] {
+      std::array<std::int8_t, 256> values{};
+      for (int i = 0; i < 256; ++i) {
+        const auto log_odds = static_cast<std::int8_t>(i);
+        values[i] = log_odds == kUnknown ? -1 : static_cast<std::int8_t>(
+          std::lround(100.0 / (1.0 + std::exp(-kLogOddsScale * log_odds))));
+      }
+      return values;
+    }();
+  return table;
+}
+
+int floor_div(double value, double resolution)
+{
+  return static_cast<int>(std::floor(value / resolution));
+}
+
+}  // namespace
+
+RollingGrid::RollingGrid(int size, double resolution, std::size_t workers)
+: size_((std::max(size, kTile) + kTile - 1) / kTile * kTile),
+  tiles_(size_ / kTile),
+  resolution_(resolution),
+  log_odds_(static_cast<std::size_t>(size_) * size_, kUnknown),
+  published_(log_odds_.size(), -1),
+  marks_(log_odds_.size()),
+  tile_dirty_(static_cast<std::size_t>(tiles_) * tiles_),
+  worker_changes_(std::max<std::size_t>(workers, 1))
+{
+  // std::atomic is not value-initialized before C++20
+  for (auto & mark : marks_) {
+    mark.store(0, std::memory_order_relaxed);
+  }
+  for (auto & dirty : tile_dirty_) {
+    dirty.store(0, std::memory_order_relaxed);
+  }
+  dirty_tiles_.reserve(tile_dirty_.size());
+  // Worst case: every cell changes within one worker's tiles
+  for (auto & changes : worker_changes_) {
+    changes.reserve(log_odds_.size());
+  }
+  occupancy_table();
+}
+
+std::size_t RollingGrid::storage_index(int x, int y) const
+{
+  int sx = x + offset_x_;
+  int sy = y + offset_y_;
+  sx -= sx >= size_ ? size_ : 0;
+  sy -= sy >= size_ ? size_ : 0;
+  return (static_cast<std::size_t>((sy >> kTileShift) * tiles_ + (sx >> kTileShift)) <<
+         (2 * kTileShift)) | static_cast<std::size_t>(((sy & (kTile - 1)) << kTileShift) |
+         (sx & (kTile - 1)));
+}
+
+void RollingGrid::clear_cell(std::size_t index)
+{
+  log_odds_[index] = kUnknown;
+  published_[index] = -1;
+}
+
+bool RollingGrid::recenter(double x, double y)
+{
+  const int half = size_ / 2;
+  const int target_x = floor_div(x, resolution_) - half;
+  const int target_y = floor_div(y, resolution_) - half;
+  const int dx = target_x - origin_x_;
+  const int dy = target_y - origin_y_;
+  if (std::abs(dx) <= kTile && std::abs(dy) <= kTile) {
+    return false;
+  }
+
+  if (std::abs(dx) >= size_ || std::abs(dy) >= size_) {
+    std::fill(log_odds_.begin(), log_odds_.end(), kUnknown);
+    std::fill(published_.begin(), published_.end(), -1);
+  } else {
+    // Columns leaving on one side are the storage for the columns entering on the other
+    for (int i = 0; i < std::abs(dx); ++i) {
+      const int column = dx > 0 ? i : size_ - 1 - i;
+      for (int row = 0; row < size_; ++row) {
+        clear_cell(storage_index(column, row));
+      }
+    }
+    for (int i = 0; i < std::abs(dy); ++i) {
+      const int row = dy > 0 ? i : size_ - 1 - i;
+      for (int column = 0; column < size_; ++column) {
+        clear_cell(storage_index(column, row));
+      }
+    }
+  }
+  offset_x_ = ((offset_x_ + dx) % size_ + size_) % size_;
+  offset_y_ = ((offset_y_ + dy) % size_ + size_) % size_;
+  origin_x_ = target_x;
+  origin_y_ = target_y;
+  return true;
+}
+
+void RollingGrid::insert_scan(const ScanRays & scan, ThreadPool & pool)
+{
+  // Pad to whole packs, padding beams take no steps
+  beams_ = (scan.count + kLanes - 1) / kLanes * kLanes;
+  if (start_x_.size() < beams_) {
+    start_x_.resize(beams_);
+    start_y_.resize(beams_);
+    step_x_.resize(beams_);
+    step_y_.resize(beams_);
+    steps_.resize(beams_);
+    hit_.resize(beams_);
+  }
+
+  const double x0 = scan.origin_x / resolution_ - origin_x_;
+  const double y0 = scan.origin_y / resolution_ - origin_y_;
+  // Keep the sampled cells strictly inside the window, truncation then never leaves it
+  const double limit = size_ - 1e-3;
+  const bool inside = x0 >= 0.0 && y0 >= 0.0 && x0 < limit && y0 < limit;
+  for (std::size_t i = 0; i < beams_; ++i) {
+    steps_[i] = -1;
+    hit_[i] = 0;
+    start_x_[i] = static_cast<float>(x0);
+    start_y_[i] = static_cast<float>(y0);
+    step_x_[i] = 0.0f;
+    step_y_[i] = 0.0f;
+    if (!inside || i >= scan.count) {
+      continue;
+    }
+    float range = scan.ranges[i];
+    bool hit = true;
+    if (std::isnan(range) || range < scan.range_min) {
+      continue;
+    }
+    if (range > scan.range_max) {
+      // No return: the beam is free space up to its maximum range
+      range = scan.range_max;
+      hit = false;
+    }
+
+    const double angle = scan.yaw + scan.angle_min + static_cast<double>(i) * scan.angle_increment;
+    const double c = std::cos(angle);
+    const double s = std::sin(angle);
+    const double major = std::max(std::abs(c), std::abs(s));
+    const double dx = c / major;
+    const double dy = s / major;
+    double steps = std::floor(range / resolution_ * major);
+    // Steps until the beam leaves the window
+    double exit = steps;
+    if (dx > 0.0) {
+      exit = std::min(exit, std::floor((limit - x0) / dx));
+    } else if (dx < 0.0) {
+      exit = std::min(exit, std::floor(x0 / -dx));
+    }
+    if (dy > 0.0) {
+      exit = std::min(exit, std::floor((limit - y0) / dy));
+    } else if (dy < 0.0) {
+      exit = std::min(exit, std::floor(y0 / -dy));
+    }
+    if (exit < steps) {
+      steps = exit;
+      hit = false;
+    }
+    step_x_[i] = static_cast<float>(dx);
+    step_y_[i] = static_cast<float>(dy);
+    // Free cells are steps [0, steps), the hit cell is step `steps`
+    steps_[i] = static_cast<std::int32_t>(steps);
+    hit_[i] = hit ? 1 : 0;
+  }
+
+  pool.parallel_for(
+    beams_ / kLanes, kPacksPerChunk,
+    [this](std::size_t begin, std::size_t end, std::size_t /*worker*/) {
+      mark_beams(begin, end);
+    });
+
+  dirty_tiles_.clear();
+  for (std::size_t tile = 0; tile < tile_dirty_.size(); ++tile) {
+    if (tile_dirty_[tile].load(std::memory_order_relaxed)) {
+      tile_dirty_[tile].store(0, std::memory_order_relaxed);
+      dirty_tiles_.push_back(static_cast<std::uint32_t>(tile));
+    }
+  }
+  pool.parallel_for(
+    dirty_tiles_.size(), 4,
+    [this](std::size_t begin, std::size_t end, std::size_t worker) {
+      apply_tiles(begin, end, worker);
+    });
+}
+
+void RollingGrid::mark_beams(std::size_t begin, std::size_t end)
+{
+  const auto size = IntPack::broadcast(size_);
+  const auto offset_x = IntPack::broadcast(offset_x_);
+  const auto offset_y = IntPack::broadcast(offset_y_);
+  const auto tiles = IntPack::broadcast(tiles_);
+  const auto local_mask = IntPack::broadcast(kTile - 1);
+
+  for (std::size_t pack = begin; pack < end; ++pack) {
+    const std::size_t first = pack * kLanes;
+    const auto x = FloatPack::load(&start_x_[first]);
+    const auto y = FloatPack::load(&start_y_[first]);
+    const auto dx = FloatPack::load(&step_x_[first]);
+    const auto dy = FloatPack::load(&step_y_[first]);
+    std::int32_t longest = -1;
+    for (std::size_t lane = 0; lane < kLanes; ++lane) {
+      longest = std::max(longest, steps_[first + lane]);
+    }
+
+    std::int32_t index[kLanes];
+    for (std::int32_t k = 0; k <= longest; ++k) {
+      const auto t = FloatPack::broadcast(static_cast<float>(k));
+      auto cx = __builtin_convertvector(x + t * dx, IntPack::Vec) + offset_x;
+      auto cy = __builtin_convertvector(y + t * dy, IntPack::Vec) + offset_y;
+      cx -= size & (cx >= size);
+      cy -= size & (cy >= size);
+      const auto tile = (cy >> kTileShift) * tiles + (cx >> kTileShift);
+      IntPack::store(
+        index, (tile << (2 * kTileShift)) | ((cy & local_mask) << kTileShift) | (cx & local_mask));
+
+      for (std::size_t lane = 0; lane < kLanes; ++lane) {
+        const auto steps = steps_[first + lane];
+        std::uint8_t mark;
+        if (k < steps) {
+          mark = kFree;
+        } else if (k == steps && hit_[first + lane]) {
+          mark = kHit;
+        } else {
+          continue;
+        }
+        // Check before writing, so beams converging near the sensor do not fight over lines
+        auto & cell = marks_[static_cast<std::size_t>(index[lane])];
+        if ((cell.load(std::memory_order_relaxed) & mark) == 0) {
+          cell.fetch_or(mark, std::memory_order_relaxed);
+        }
+        auto & dirty = tile_dirty_[static_cast<std::size_t>(index[lane]) >> (2 * kTileShift)];
+        if (!dirty.load(std::memory_order_relaxed)) {
+          dirty.store(1, std::memory_order_relaxed);
+        }
+      }
+    }
+  }
+}
+
+void RollingGrid::apply_tiles(std::size_t begin, std::size_t end, std::size_t worker)
+{
+  const auto & table = occupancy_table();
+  auto & changes = worker_changes_[worker];
+  for (std::size_t i = begin; i < end; ++i) {
+    const std::size_t first = static_cast<std::size_t>(dirty_tiles_[i]) << (2 * kTileShift);
+    for (std::size_t cell = first; cell < first + kTile * kTile; ++cell) {
+      const auto mark = marks_[cell].load(std::memory_order_relaxed);
+      if (mark == 0) {
+        continue;
+      }
+      marks_[cell].store(0, std::memory_order_relaxed);
+      // A hit wins over the free marks of beams passing through the same cell
+      int log_odds = log_odds_[cell] == kUnknown ? 0 : log_odds_[cell];
+      log_odds = std::clamp(
+        log_odds + ((mark & kHit) ? kHitUpdate : kFreeUpdate), -kClamp, kClamp);
+      log_odds_[cell] = static_cast<std::int8_t>(log_odds);
+      const auto value = table[static_cast<std::uint8_t>(log_odds)];
+      if (value != published_[cell]) {
+        published_[cell] = value;
+        changes.push_back(GridChange{static_cast<std::uint32_t>(cell), value});
+      }
+    }
+  }
+}
+
+void RollingGrid::take_changes(std::vector<GridChange> & changes)
+{
+  changes.clear();
+  for (auto & worker : worker_changes_) {
+    for (const auto & change : worker) {
+      // Storage index back to window coordinates
+      const int tile = static_cast<int>(change.index >> (2 * kTileShift));
+      const int local = static_cast<int>(change.index & (kTile * kTile - 1));
+      int x = (tile % tiles_) * kTile + (local & (kTile - 1)) - offset_x_;
+      int y = (tile / tiles_) * kTile + (local >> kTileShift) - offset_y_;
+      x += x < 0 ? size_ : 0;
+      y += y < 0 ? size_ : 0;
+      changes.push_back(
+        GridChange{static_cast<std::uint32_t>(y * size_ + x), change.value});
+    }
+    worker.clear();
+  }
+  std::sort(
+    changes.begin(), changes.end(),
+    [](const GridChange & a, const GridChange & b) {return a.index < b.index;});
+}
+
+void RollingGrid::snapshot(std::vector<std::int8_t> & values) const
+{
+  values.resize(published_.size());
+  for (int y = 0; y < size_; ++y) {
+    for (int x = 0; x < size_; ++x) {
+      values[static_cast<std::size_t>(y) * size_ + x] = published_[storage_index(x, y)];
+    }
+  }
+}
+
+}  // namespace robocap_perception
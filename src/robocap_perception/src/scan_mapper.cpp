@@ -0,0 +1,97 @@
+#include "robocap_perception/scan_mapper.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+
+#include "robocap_perception/grid_delta.hpp"
+#include "robocap_tracing/tracing.hpp"
+#include "tf2/exceptions.h"
+
+namespace robocap_perception
+{
+
+ScanMapper::ScanMapper(const rclcpp::NodeOptions & options)
+: rclcpp::Node("scan_mapper", options),
+  pool_(static_cast<std::size_t>(declare_parameter<int>("threads", 0))),
+  grid_(
+    static_cast<int>(declare_parameter<int>("size", 400)),
+    declare_parameter<double>("resolution", 0.05), pool_.size())
+{
+  frame_id_ = declare_parameter<std::string>("frame_id", "odom");
+  const auto keyframe_interval = declare_parameter<int>("keyframe_interval", 40);
+  keyframe_interval_ = static_cast<std::uint32_t>(std::max(1, keyframe_interval));
+
+  changes_.reserve(static_cast<std::size_t>(grid_.size()) * grid_.size());
+  delta_.header.frame_id = frame_id_;
+  delta_.resolution = static_cast<float>(grid_.resolution());
+  delta_.size = static_cast<std::uint32_t>(grid_.size());
+
+  tf_buffer_ = std::make_unique<tf2_ros::Buffer>(get_clock());
+  tf_listener_ = std::make_unique<tf2_ros::TransformListener>(*tf_buffer_);
+  publisher_ = create_publisher<robocap_msgs::msg::OccupancyGridDelta>(
+    "grid_delta", rclcpp::QoS(10).reliable());
+  subscription_ = create_subscription<sensor_msgs::msg::LaserScan>(
+    "scan", rclcpp::SensorDataQoS(),
+    [this](const sensor_msgs::msg::LaserScan::ConstSharedPtr msg) {on_scan(*msg);});
+  scan_age_ =
+    &robocap_runtime::message_age_histogram(get_name(), subscription_->get_topic_name());
+  RCLCPP_INFO(
+    get_logger(), "%dx%d grid at %.3f m in '%s', %zu threads", grid_.size(), grid_.size(),
+    grid_.resolution(), frame_id_.c_str(), pool_.size());
+  ROBOCAP_TRACEPOINT(component_init, this, get_fully_qualified_name());
+}
+
+void ScanMapper::on_scan(const sensor_msgs::msg::LaserScan & scan)
+{
+  ROBOCAP_TRACEPOINT(processing_start, this, rclcpp::Time(scan.header.stamp).nanoseconds());
+  scan_age_->record(
+    std::chrono::nanoseconds((now() - rclcpp::Time(scan.header.stamp)).nanoseconds()));
+  geometry_msgs::msg::TransformStamped sensor;
+  try {
+    sensor = tf_buffer_->lookupTransform(frame_id_, scan.header.frame_id, scan.header.stamp);
+  } catch (const tf2::TransformException & e) {
+    RCLCPP_WARN_THROTTLE(get_logger(), *get_clock(), 5000, "Dropping scan: %s", e.what());
+    ROBOCAP_TRACEPOINT(processing_end, this);
+    return;
+  }
+  const auto & q = sensor.transform.rotation;
+  const ScanRays rays{
+    sensor.transform.translation.x,
+    sensor.transform.translation.y,
+    std::atan2(2.0 * (q.w * q.z + q.x * q.y), 1.0 - 2.0 * (q.y * q.y + q.z * q.z)),
+    scan.angle_min,
+    scan.angle_increment,
+    scan.range_min,
+    scan.range_max,
+    scan.ranges.data(),
+    scan.ranges.size(),
+  };
+
+  grid_.recenter(rays.origin_x, rays.origin_y);
+  grid_.insert_scan(rays, pool_);
+  grid_.take_changes(changes_);
+
+  delta_.header.stamp = scan.header.stamp;
+  delta_.sequence = sequence_;
+  delta_.keyframe = sequence_ % keyframe_interval_ == 0;
+  delta_.origin_x = grid_.origin_x();
+  delta_.origin_y = grid_.origin_y();
+  if (delta_.keyframe) {
+    grid_.snapshot(snapshot_);
+    delta_.runs.assign({0, static_cast<std::uint32_t>(snapshot_.size())});
+    delta_.values.assign(snapshot_.begin(), snapshot_.end());
+  } else {
+    encode_changes(changes_, delta_);
+  }
+  ++sequence_;
+  publisher_->publish(delta_);
+  ROBOCAP_TRACEPOINT(processing_end, this);
+}
+
+}  // namespace robocap_perception
+
+#include "rclcpp_components/register_node_macro.hpp"
+
+RCLCPP_COMPONENTS_REGISTER_NODE(robocap_perception::ScanMapper)
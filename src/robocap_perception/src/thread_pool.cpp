@@ -0,0 +1,88 @@
+#include "robocap_perception/thread_pool.hpp"
+
+#include <algorithm>
+
+namespace robocap_perception
+{
+
+ThreadPool::ThreadPool(std::size_t threads)
+{
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threads_.reserve(threads - 1);
+  for (std::size_t worker = 1; worker < threads; ++worker) {
+    threads_.emplace_back(&ThreadPool::worker_loop, this, worker);
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_.notify_all();
+  for (auto & thread : threads_) {
+    thread.join();
+  }
+}
+
+void ThreadPool::run(std::size_t count, std::size_t chunk, Invoke invoke, void * context)
+{
+  if (threads_.empty() || count <= chunk) {
+    if (count > 0) {
+      invoke(context, 0, count, 0);
+    }
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    count_ = count;
+    chunk_ = chunk;
+    invoke_ = invoke;
+    context_ = context;
+    next_.store(0, std::memory_order_relaxed);
+    running_ = threads_.size();
+    ++generation_;
+  }
+  start_.notify_all();
+  work(0);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  finished_.wait(lock, [this] {return running_ == 0;});
+}
+
+void ThreadPool::work(std::size_t worker)
+{
+  for (;;) {
+    const auto begin = next_.fetch_add(chunk_, std::memory_order_relaxed);
+    if (begin >= count_) {
+      return;
+    }
+    invoke_(context_, begin, std::min(begin + chunk_, count_), worker);
+  }
+}
+
+void ThreadPool::worker_loop(std::size_t worker)
+{
+  std::uint64_t seen = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_.wait(lock, [&] {return stop_ || generation_ != seen;});
+      if (stop_) {
+        return;
+      }
+      seen = generation_;
+    }
+    work(worker);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --running_;
+    }
+    finished_.notify_one();
+  }
+}
+
+}  // namespace robocap_perception
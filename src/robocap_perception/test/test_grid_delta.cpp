@@ -0,0 +1,202 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "robocap_msgs/msg/occupancy_grid_delta.hpp"
+#include "robocap_perception/grid_delta.hpp"
+#include "robocap_perception/rolling_grid.hpp"
+#include "robocap_perception/thread_pool.hpp"
+
+namespace
+{
+
+using robocap_msgs::msg::OccupancyGridDelta;
+using robocap_perception::GridChange;
+using robocap_perception::GridDeltaDecoder;
+using robocap_perception::RollingGrid;
+using robocap_perception::ScanRays;
+using robocap_perception::ThreadPool;
+
+constexpr int kSize = 64;
+constexpr double kResolution = 0.1;
+constexpr float kRangeMax = 2.5f;
+
+// The publishing half of ScanMapper::on_scan(), without the node around it
+class Mapper
+{
+public:
+  explicit Mapper(std::uint32_t keyframe_interval)
+  : grid_(kSize, kResolution, 2), pool_(2), keyframe_interval_(keyframe_interval)
+  {
+    // A lumpy room, with a sector of beams that see nothing within range
+    ranges_.resize(180);
+    for (std::size_t i = 0; i < ranges_.size(); ++i) {
+      const double angle = 2.0 * M_PI * static_cast<double>(i) / ranges_.size();
+      ranges_[i] = i >= 40 && i < 55 ? 2.0f * kRangeMax :
+        static_cast<float>(1.0 + 0.8 * std::abs(std::sin(3.0 * angle)));
+    }
+  }
+
+  OccupancyGridDelta scan_at(double x, double y, double yaw)
+  {
+    const ScanRays rays{
+      x, y, yaw,
+      0.0f, static_cast<float>(2.0 * M_PI / ranges_.size()), 0.05f, kRangeMax,
+      ranges_.data(), ranges_.size(),
+    };
+    const int origin_x = grid_.origin_x();
+    const int origin_y = grid_.origin_y();
+    if (grid_.recenter(rays.origin_x, rays.origin_y)) {
+      const int shift = std::max(
+        std::abs(grid_.origin_x() - origin_x), std::abs(grid_.origin_y() - origin_y));
+      ++(shift >= grid_.size() ? full_scrolls : partial_scrolls);
+    }
+    grid_.insert_scan(rays, pool_);
+    grid_.take_changes(changes_);
+
+    OccupancyGridDelta delta;
+    delta.sequence = sequence_;
+    delta.keyframe = sequence_ % keyframe_interval_ == 0;
+    delta.resolution = static_cast<float>(grid_.resolution());
+    delta.size = static_cast<std::uint32_t>(grid_.size());
+    delta.origin_x = grid_.origin_x();
+    delta.origin_y = grid_.origin_y();
+    if (delta.keyframe) {
+      grid_.snapshot(snapshot_);
+      delta.runs.assign({0, static_cast<std::uint32_t>(snapshot_.size())});
+      delta.values.assign(snapshot_.begin(), snapshot_.end());
+    } else {
+      robocap_perception::encode_changes(changes_, delta);
+    }
+    ++sequence_;
+    return delta;
+  }
+
+  const RollingGrid & grid() const {return grid_;}
+
+  int partial_scrolls = 0;
+  int full_scrolls = 0;
+
+private:
+  RollingGrid grid_;
+  ThreadPool pool_;
+  std::uint32_t keyframe_interval_;
+  std::uint32_t sequence_ = 0;
+  std::vector<float> ranges_;
+  std::vector<GridChange> changes_;
+  std::vector<std::int8_t> snapshot_;
+};
+
+struct Pose
+{
+  double x;
+  double y;
+  double yaw;
+};
+
+// Small steps that stay within a tile, steps that scroll part of the window in each direction,
+// and jumps further than the window, which drop everything
+std::vector<Pose> route()
+{
+  std::vector<Pose> poses;
+  for (int i = 0; i < 4; ++i) {
+    poses.push_back({0.3 * i, 0.0, 0.2 * i});
+  }
+  for (int i = 0; i < 6; ++i) {
+    poses.push_back({1.0 + 1.9 * i, 0.1 * i, 0.5 * i});
+  }
+  for (int i = 0; i < 6; ++i) {
+    poses.push_back({11.0 - 1.7 * i, -2.1 * i, -0.4 * i});
+  }
+  poses.push_back({40.0, 25.0, 1.0});
+  poses.push_back({40.5, 25.2, 1.3});
+  poses.push_back({-30.0, -12.0, 2.0});
+  for (int i = 0; i < 4; ++i) {
+    poses.push_back({-30.0 + 1.8 * i, -12.0 + 1.8 * i, 2.0 + 0.3 * i});
+  }
+  return poses;
+}
+
+void expect_mirrors(const GridDeltaDecoder & decoder, const RollingGrid & grid)
+{
+  std::vector<std::int8_t> expected;
+  grid.snapshot(expected);
+  ASSERT_EQ(decoder.size(), grid.size());
+  EXPECT_EQ(decoder.origin_x(), grid.origin_x());
+  EXPECT_EQ(decoder.origin_y(), grid.origin_y());
+  EXPECT_EQ(decoder.cells(), expected);
+}
+
+TEST(GridDelta, EncodesSortedChangesAsRuns)
+{
+  const std::vector<GridChange> changes{
+    {2, 10}, {3, 11}, {4, 12}, {9, 50}, {20, -1}, {21, 100}};
+  OccupancyGridDelta delta;
+  robocap_perception::encode_changes(changes, delta);
+  EXPECT_EQ(delta.runs, (std::vector<std::uint32_t>{2, 3, 4, 1, 10, 2}));
+  EXPECT_EQ(delta.values, (std::vector<std::int8_t>{10, 11, 12, 50, -1, 100}));
+
+  robocap_perception::encode_changes({}, delta);
+  EXPECT_TRUE(delta.runs.empty());
+  EXPECT_TRUE(delta.values.empty());
+}
+
+TEST(GridDelta, DecoderMirrorsGridFromDeltasAlone)
+{
+  // Only the first message is a keyframe, so every scroll is replayed by the decoder itself
+  Mapper mapper(1000);
+  GridDeltaDecoder decoder;
+  for (const auto & pose : route()) {
+    ASSERT_TRUE(decoder.apply(mapper.scan_at(pose.x, pose.y, pose.yaw)));
+    expect_mirrors(decoder, mapper.grid());
+  }
+  EXPECT_GE(mapper.partial_scrolls, 8);
+  EXPECT_GE(mapper.full_scrolls, 2);
+}
+
+TEST(GridDelta, DecoderWaitsForKeyframeAfterGap)
+{
+  Mapper mapper(8);
+  GridDeltaDecoder decoder;
+  const auto poses = route();
+  ASSERT_GT(poses.size(), 16u);
+
+  // Not synced until a keyframe arrives, even when a delta would apply cleanly
+  auto first = mapper.scan_at(poses[0].x, poses[0].y, poses[0].yaw);
+  first.keyframe = false;
+  EXPECT_FALSE(decoder.apply(first));
+
+  for (std::size_t i = 1; i < poses.size(); ++i) {
+    const auto delta = mapper.scan_at(poses[i].x, poses[i].y, poses[i].yaw);
+    // Drop the message after keyframe 8, the rest up to keyframe 16 are refused
+    if (delta.sequence == 9) {
+      continue;
+    }
+    const bool synced = delta.sequence == 8 || delta.sequence >= 16;
+    ASSERT_EQ(decoder.apply(delta), synced) << "sequence " << delta.sequence;
+    if (synced) {
+      expect_mirrors(decoder, mapper.grid());
+    }
+  }
+  EXPECT_GE(mapper.partial_scrolls, 1);
+}
+
+TEST(GridDelta, DecoderRejectsRunsPastTheWindow)
+{
+  Mapper mapper(1000);
+  GridDeltaDecoder decoder;
+  ASSERT_TRUE(decoder.apply(mapper.scan_at(0.0, 0.0, 0.0)));
+
+  auto delta = mapper.scan_at(0.2, 0.0, 0.0);
+  delta.runs.assign({kSize * kSize - 1, 2});
+  delta.values.assign({0, 0});
+  EXPECT_FALSE(decoder.apply(delta));
+  // Unsynced from then on, the next delta in sequence included
+  EXPECT_FALSE(decoder.apply(mapper.scan_at(0.4, 0.0, 0.0)));
+}
+
+}  // namespace
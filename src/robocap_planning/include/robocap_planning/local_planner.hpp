@@ -0,0 +1,80 @@
+#ifndef ROBOCAP_PLANNING__LOCAL_PLANNER_HPP_
+#define ROBOCAP_PLANNING__LOCAL_PLANNER_HPP_
+
+#include <optional>
+#include <string>
+
+#include "geometry_msgs/msg/pose_stamped.hpp"
+#include "geometry_msgs/msg/twist.hpp"
+#include "nav_msgs/msg/odometry.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "robocap_msgs/msg/occupancy_grid_delta.hpp"
+
+#include "robocap_perception/grid_delta.hpp"
+#include "robocap_perception/thread_pool.hpp"
+#include "robocap_planning/mppi_planner.hpp"
+#include "robocap_planning/obstacle_map.hpp"
+#include "robocap_runtime/metrics.hpp"
+
+namespace robocap_planning
+{
+
+// Drives to the latest "goal_pose" with an MppiPlanner, publishing "cmd_vel" at a fixed rate.
+// The robot state comes from "odom" and obstacles from the ScanMapper's "grid_delta", mirrored
+// with a GridDeltaDecoder and grown by the robot radius. Goal, odometry and grid must share one
+// frame, odom by default. All callbacks share the node's default, mutually exclusive callback
+// group; the rollouts inside a cycle run on the node's own ThreadPool. Each cycle's planning time,
+// the cycles over the period and the age of the odometry planned from go to robocap_runtime's
+// metrics.
+//
+// Parameters:
+//   frame_id                odometry, goal and grid frame, defaults to odom
+//   rate                    [Hz] planning rate, defaults to 20
+//   threads                 rollout threads including the timer's, 0 (default) for one per core
+//   robot_radius            [m] obstacle inflation, defaults to 0.3
+//   occupied_threshold      grid value counted as an obstacle, defaults to 65
+//   xy_goal_tolerance       [m] defaults to 0.05
+//   yaw_goal_tolerance      [rad] defaults to 0.1
+//   samples, steps, dt, temperature, max_wheel_velocity, max_wheel_acceleration, seed
+//                           MppiConfig fields
+//   noise.vx, noise.vy, noise.wz
+//                           MppiConfig noise_* fields
+//   weights.goal, weights.terminal, weights.heading, weights.smoothness, weights.collision
+//                           MppiConfig *_weight fields and collision_cost
+class LocalPlanner : public rclcpp::Node
+{
+public:
+  explicit LocalPlanner(const rclcpp::NodeOptions & options);
+
+private:
+  void on_timer();
+  void on_grid_delta(const robocap_msgs::msg::OccupancyGridDelta & delta);
+  void stop();
+
+  std::string frame_id_;
+  double xy_goal_tolerance_;
+  double yaw_goal_tolerance_;
+  double period_;  // [s]
+
+  robocap_perception::ThreadPool pool_;
+  MppiPlanner planner_;
+  ObstacleMap obstacle_map_;
+  robocap_perception::GridDeltaDecoder decoder_;
+
+  std::optional<Pose2> goal_;
+  std::optional<nav_msgs::msg::Odometry> odom_;
+  geometry_msgs::msg::Twist command_;
+  robocap_runtime::Histogram * plan_duration_ = nullptr;
+  robocap_runtime::Counter * overruns_ = nullptr;
+  robocap_runtime::Histogram * odom_age_ = nullptr;
+
+  rclcpp::Publisher<geometry_msgs::msg::Twist>::SharedPtr cmd_vel_publisher_;
+  rclcpp::Subscription<nav_msgs::msg::Odometry>::SharedPtr odom_subscription_;
+  rclcpp::Subscription<geometry_msgs::msg::PoseStamped>::SharedPtr goal_subscription_;
+  rclcpp::Subscription<robocap_msgs::msg::OccupancyGridDelta>::SharedPtr grid_subscription_;
+  rclcpp::TimerBase::SharedPtr timer_;
+};
+
+}  // namespace robocap_planning
+
+#endif  // ROBOCAP_PLANNING__LOCAL_PLANNER_HPP_
@@ -0,0 +1,121 @@
+#ifndef ROBOCAP_PLANNING__MPPI_PLANNER_HPP_
+#define ROBOCAP_PLANNING__MPPI_PLANNER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "robocap_kinematics/kiwi_drive.hpp"
+#include "robocap_perception/thread_pool.hpp"
+#include "robocap_planning/obstacle_map.hpp"
+
+namespace robocap_planning
+{
+
+struct MppiConfig
+{
+  std::size_t samples = 5120;             // Rollouts per cycle, rounded up to whole packs
+  std::size_t steps = 20;                 // Horizon length
+  double dt = 0.1;                        // [s] per step
+  double temperature = 0.5;               // MPPI lambda, lower trusts the best rollouts more
+  double noise_vx = 0.3;                  // [m/s] sampling standard deviations
+  double noise_vy = 0.3;                  // [m/s]
+  double noise_wz = 0.8;                  // [rad/s]
+  double max_wheel_velocity = 20.0;       // [rad/s]
+  double max_wheel_acceleration = 40.0;   // [rad/s^2]
+  double goal_weight = 1.0;               // Per metre from the goal, per second
+  double terminal_weight = 5.0;           // Per metre from the goal at the end of the horizon
+  double heading_weight = 1.0;            // 1 - cos(yaw error) at the end of the horizon
+  double smoothness_weight = 0.2;         // Squared command change per step
+  double collision_cost = 1000.0;         // Per step with the robot centre in an obstacle
+  std::uint32_t seed = 0;
+};
+
+struct Pose2
+{
+  double x;    // [m]
+  double y;    // [m]
+  double yaw;  // [rad]
+};
+
+// Model predictive path integral control for the kiwi drive. Every cycle perturbs the previous
+// solution into `samples` (vx, vy, wz) sequences, rolls them out and averages them weighted by
+// exp(-cost / temperature). As the drive is holonomic, the samples cover all three axes.
+//
+// Each sampled command is projected onto what the wheels can do before it is rolled out: its
+// change from the previous step is scaled into max_wheel_acceleration, then the command itself
+// into max_wheel_velocity, both through the inverse kinematics. Both sets are convex, so the
+// weighted average is feasible too.
+//
+// Rollouts run in parallel over packs of samples. Controls and costs are kept as structure of
+// arrays, index step * samples + sample, so each step of a pack is one SIMD load per axis.
+// Buffers are allocated in the constructor and reused, plan() does not allocate.
+class MppiPlanner
+{
+public:
+  // `workers` is the size of the ThreadPool passed to plan()
+  MppiPlanner(
+    const robocap_kinematics::KiwiDrive & drive, const MppiConfig & config, std::size_t workers);
+
+  // One iteration from `pose` in the map frame, moving at `velocity` in base_link, towards `goal`.
+  // Returns the command to apply now and keeps the rest of the solution for the next call
+  robocap_kinematics::Twist<double> plan(
+    const Pose2 & pose, const robocap_kinematics::Twist<double> & velocity, const Pose2 & goal,
+    const ObstacleView & obstacles, robocap_perception::ThreadPool & pool);
+
+  // Forgets the previous solution, e.g. after a new goal
+  void reset();
+
+  const MppiConfig & config() const {return config_;}
+  std::size_t samples() const {return samples_;}
+  // Cost of the cheapest rollout in the last plan()
+  double min_cost() const {return min_cost_;}
+
+private:
+  // Per worker, so sampling needs no synchronization
+  struct alignas(64) Sampler
+  {
+    std::minstd_rand engine;
+    std::normal_distribution<float> normal;
+  };
+
+  // The start pose, velocity and goal of one plan(), relative to the start position
+  struct Problem
+  {
+    float yaw;
+    float vx;
+    float vy;
+    float wz;
+    float goal_x;
+    float goal_y;
+    float goal_cos;
+    float goal_sin;
+    ObstacleView obstacles;
+    float obstacle_x;  // Lower-left map corner [m] relative to the start
+    float obstacle_y;
+  };
+
+  void sample(std::size_t begin, std::size_t end, std::size_t worker);
+  void rollout(const Problem & problem, std::size_t begin, std::size_t end);
+
+  MppiConfig config_;
+  float inverse_[3][3];
+  std::size_t samples_;
+  std::size_t steps_;
+
+  std::vector<float> vx_;
+  std::vector<float> vy_;
+  std::vector<float> wz_;
+  std::vector<float> cost_;
+  std::vector<float> weight_;
+  std::vector<float> nominal_vx_;
+  std::vector<float> nominal_vy_;
+  std::vector<float> nominal_wz_;
+  std::vector<Sampler> samplers_;
+  double min_cost_ = 0.0;
+};
+
+}  // namespace robocap_planning
+
+#endif  // ROBOCAP_PLANNING__MPPI_PLANNER_HPP_
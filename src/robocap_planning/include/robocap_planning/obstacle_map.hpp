@@ -0,0 +1,51 @@
+#ifndef ROBOCAP_PLANNING__OBSTACLE_MAP_HPP_
+#define ROBOCAP_PLANNING__OBSTACLE_MAP_HPP_
+
+#include <cstdint>
+#include <vector>
+
+namespace robocap_planning
+{
+
+// Read-only view of an ObstacleMap for the rollouts
+struct ObstacleView
+{
+  const std::uint8_t * lethal = nullptr;  // size * size, row-major, nonzero inside obstacles
+  int size = 0;
+  double resolution = 1.0;  // [m/cell]
+  double origin_x = 0.0;    // [m] lower-left corner of cell (0, 0)
+  double origin_y = 0.0;
+};
+
+// Obstacles of an occupancy grid grown by the robot radius, so a rollout only has to check the
+// cell under the robot centre. Cells at or above `occupied_threshold` are obstacles, unknown and
+// free cells are not. The whole map is rebuilt per update(), which for a sparse local grid is
+// one short row fill per row of the robot's disc per occupied cell.
+class ObstacleMap
+{
+public:
+  ObstacleMap(double robot_radius, int occupied_threshold);
+
+  // `cells` in nav_msgs/OccupancyGrid convention, `size` x `size` from cell (origin_x, origin_y)
+  void update(
+    const std::vector<std::int8_t> & cells, int size, double resolution, int origin_x,
+    int origin_y);
+
+  // Empty until the first update()
+  ObstacleView view() const;
+
+private:
+  double robot_radius_;
+  int occupied_threshold_;
+  int size_ = 0;
+  double resolution_ = 0.0;
+  int origin_x_ = 0;
+  int origin_y_ = 0;
+  // Half width of the robot's disc for rows -radius..radius, in cells
+  std::vector<int> half_widths_;
+  std::vector<std::uint8_t> lethal_;
+};
+
+}  // namespace robocap_planning
+
+#endif  // ROBOCAP_PLANNING__OBSTACLE_MAP_HPP_
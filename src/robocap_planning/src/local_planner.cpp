@@ -0,0 +1,178 @@
+#include "robocap_planning/local_planner.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+#include "robocap_kinematics/robocap_layout.hpp"
+#include "robocap_tracing/tracing.hpp"
+
+namespace robocap_planning
+{
+
+namespace
+{
+
+MppiConfig declare_config(rclcpp::Node & node)
+{
+  MppiConfig config;
+  config.samples = static_cast<std::size_t>(
+    node.declare_parameter<int>("samples", static_cast<int>(config.samples)));
+  config.steps = static_cast<std::size_t>(
+    node.declare_parameter<int>("steps", static_cast<int>(config.steps)));
+  config.dt = node.declare_parameter("dt", config.dt);
+  config.temperature = node.declare_parameter("temperature", config.temperature);
+  config.noise_vx = node.declare_parameter("noise.vx", config.noise_vx);
+  config.noise_vy = node.declare_parameter("noise.vy", config.noise_vy);
+  config.noise_wz = node.declare_parameter("noise.wz", config.noise_wz);
+  config.max_wheel_velocity =
+    node.declare_parameter("max_wheel_velocity", config.max_wheel_velocity);
+  config.max_wheel_acceleration =
+    node.declare_parameter("max_wheel_acceleration", config.max_wheel_acceleration);
+  config.goal_weight = node.declare_parameter("weights.goal", config.goal_weight);
+  config.terminal_weight = node.declare_parameter("weights.terminal", config.terminal_weight);
+  config.heading_weight = node.declare_parameter("weights.heading", config.heading_weight);
+  config.smoothness_weight = node.declare_parameter("weights.smoothness", config.smoothness_weight);
+  config.collision_cost = node.declare_parameter("weights.collision", config.collision_cost);
+  config.seed = static_cast<std::uint32_t>(node.declare_parameter<int>("seed", 0));
+  if (config.samples < 2 || config.steps < 1 || config.dt <= 0.0 || config.temperature <= 0.0) {
+    throw std::invalid_argument("'samples', 'steps', 'dt' and 'temperature' must be positive");
+  }
+  if (config.max_wheel_velocity <= 0.0 || config.max_wheel_acceleration <= 0.0) {
+    throw std::invalid_argument("wheel limits must be positive");
+  }
+  return config;
+}
+
+double yaw_of(const geometry_msgs::msg::Quaternion & q)
+{
+  return std::atan2(2.0 * (q.w * q.z + q.x * q.y), 1.0 - 2.0 * (q.y * q.y + q.z * q.z));
+}
+
+}  // namespace
+
+LocalPlanner::LocalPlanner(const rclcpp::NodeOptions & options)
+: rclcpp::Node("local_planner", options),
+  pool_(static_cast<std::size_t>(declare_parameter<int>("threads", 0))),
+  planner_(robocap_kinematics::kRobocapKiwiDrive, declare_config(*this), pool_.size()),
+  obstacle_map_(
+    declare_parameter<double>("robot_radius", 0.3),
+    static_cast<int>(declare_parameter<int>("occupied_threshold", 65)))
+{
+  frame_id_ = declare_parameter<std::string>("frame_id", "odom");
+  xy_goal_tolerance_ = declare_parameter<double>("xy_goal_tolerance", 0.05);
+  yaw_goal_tolerance_ = declare_parameter<double>("yaw_goal_tolerance", 0.1);
+  const auto rate = declare_parameter<double>("rate", 20.0);
+  if (rate <= 0.0) {
+    throw std::invalid_argument("'rate' must be positive");
+  }
+  period_ = 1.0 / rate;
+
+  cmd_vel_publisher_ =
+    create_publisher<geometry_msgs::msg::Twist>("cmd_vel", rclcpp::SystemDefaultsQoS());
+  odom_subscription_ = create_subscription<nav_msgs::msg::Odometry>(
+    "odom", rclcpp::SystemDefaultsQoS(),
+    [this](const nav_msgs::msg::Odometry::ConstSharedPtr msg) {odom_ = *msg;});
+  goal_subscription_ = create_subscription<geometry_msgs::msg::PoseStamped>(
+    "goal_pose", rclcpp::SystemDefaultsQoS(),
+    [this](const geometry_msgs::msg::PoseStamped::ConstSharedPtr msg) {
+      if (msg->header.frame_id != frame_id_) {
+        RCLCPP_WARN(
+          get_logger(), "Ignoring goal in '%s', expected '%s'", msg->header.frame_id.c_str(),
+          frame_id_.c_str());
+        return;
+      }
+      goal_ = Pose2{msg->pose.position.x, msg->pose.position.y, yaw_of(msg->pose.orientation)};
+      planner_.reset();
+    });
+  grid_subscription_ = create_subscription<robocap_msgs::msg::OccupancyGridDelta>(
+    "grid_delta", rclcpp::QoS(10).reliable(),
+    [this](const robocap_msgs::msg::OccupancyGridDelta::ConstSharedPtr msg) {
+      on_grid_delta(*msg);
+    });
+  auto & metrics = robocap_runtime::MetricsRegistry::global();
+  const robocap_runtime::Labels labels{{"node", get_name()}};
+  plan_duration_ = &metrics.histogram(
+    "robocap_planner_cycle_seconds", "Time the local planner took per cycle", labels);
+  overruns_ = &metrics.counter(
+    "robocap_planner_overruns_total", "Local planner cycles longer than its period", labels);
+  odom_age_ =
+    &robocap_runtime::message_age_histogram(get_name(), odom_subscription_->get_topic_name());
+  // On the node clock, so with use_sim_time the planner keeps its rate in sim time
+  timer_ = rclcpp::create_timer(
+    this, get_clock(), rclcpp::Duration::from_seconds(period_), [this]() {on_timer();});
+  RCLCPP_INFO(
+    get_logger(), "%zu samples x %zu steps at %.0f Hz, %zu threads", planner_.samples(),
+    planner_.config().steps, rate, pool_.size());
+  ROBOCAP_TRACEPOINT(component_init, this, get_fully_qualified_name());
+}
+
+void LocalPlanner::on_grid_delta(const robocap_msgs::msg::OccupancyGridDelta & delta)
+{
+  if (delta.header.frame_id != frame_id_) {
+    RCLCPP_WARN_THROTTLE(
+      get_logger(), *get_clock(), 5000, "Ignoring grid in '%s', expected '%s'",
+      delta.header.frame_id.c_str(), frame_id_.c_str());
+    return;
+  }
+  // Until the next keyframe after a gap, plan against the last complete map
+  if (decoder_.apply(delta)) {
+    obstacle_map_.update(
+      decoder_.cells(), decoder_.size(), delta.resolution, decoder_.origin_x(),
+      decoder_.origin_y());
+  }
+}
+
+void LocalPlanner::on_timer()
+{
+  if (!goal_ || !odom_) {
+    return;
+  }
+  const auto & odom = *odom_;
+  const Pose2 pose{
+    odom.pose.pose.position.x, odom.pose.pose.position.y, yaw_of(odom.pose.pose.orientation)};
+  const double yaw_error = std::remainder(goal_->yaw - pose.yaw, 2.0 * M_PI);
+  if (std::hypot(goal_->x - pose.x, goal_->y - pose.y) < xy_goal_tolerance_ &&
+    std::abs(yaw_error) < yaw_goal_tolerance_)
+  {
+    RCLCPP_INFO(get_logger(), "Goal reached");
+    stop();
+    return;
+  }
+
+  ROBOCAP_TRACEPOINT(processing_start, this, rclcpp::Time(odom.header.stamp).nanoseconds());
+  const auto start = std::chrono::steady_clock::now();
+  const auto command = planner_.plan(
+    pose, {odom.twist.twist.linear.x, odom.twist.twist.linear.y, odom.twist.twist.angular.z},
+    *goal_, obstacle_map_.view(), pool_);
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  plan_duration_->record(elapsed);
+  odom_age_->record(
+    std::chrono::nanoseconds((now() - rclcpp::Time(odom.header.stamp)).nanoseconds()));
+  if (elapsed.count() > period_) {
+    overruns_->add();
+    RCLCPP_WARN_THROTTLE(
+      get_logger(), *get_clock(), 5000, "Planning took %.1f ms, over the %.1f ms period",
+      elapsed.count() * 1e3, period_ * 1e3);
+  }
+
+  command_.linear.x = command.vx;
+  command_.linear.y = command.vy;
+  command_.angular.z = command.wz;
+  cmd_vel_publisher_->publish(command_);
+  ROBOCAP_TRACEPOINT(processing_end, this);
+}
+
+void LocalPlanner::stop()
+{
+  goal_.reset();
+  planner_.reset();
+  command_ = geometry_msgs::msg::Twist();
+  cmd_vel_publisher_->publish(command_);
+}
+
+}  // namespace robocap_planning
+
+#include "rclcpp_components/register_node_macro.hpp"
+
+RCLCPP_COMPONENTS_REGISTER_NODE(robocap_planning::LocalPlanner)
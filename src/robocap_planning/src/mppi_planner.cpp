@@ -0,0 +1,278 @@
+#include "robocap_planning/mppi_planner.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "robocap_kinematics/simd.hpp"
+
+namespace robocap_planning
+{
+
+namespace
+{
+
+using FloatPack = robocap_kinematics::simd::Pack<float>;
+using Vec = FloatPack::Vec;
+using Mask = decltype(Vec{} < Vec{});
+constexpr std::size_t kLanes = FloatPack::kLanes;
+
+// Sample packs handed to a thread at a time
+constexpr std::size_t kPacksPerChunk = 8;
+
+Vec select(const Mask & mask, const Vec & a, const Vec & b)
+{
+  return reinterpret_cast<Vec>(
+    (mask & reinterpret_cast<Mask>(a)) | (~mask & reinterpret_cast<Mask>(b)));
+}
+
+Vec min(const Vec & a, const Vec & b) {return select(a < b, a, b);}
+Vec max(const Vec & a, const Vec & b) {return select(a > b, a, b);}
+Vec abs(const Vec & a) {return max(a, -a);}
+
+// Factor in (0, 1] that brings the fastest wheel of twist (vx, vy, wz) down to `limit`
+Vec limit_scale(
+  const Vec (&inverse)[3][3], const Vec & vx, const Vec & vy, const Vec & wz, const Vec & limit)
+{
+  Vec peak = FloatPack::broadcast(1e-6f);
+  for (std::size_t wheel = 0; wheel < 3; ++wheel) {
+    peak = max(peak, abs(inverse[wheel][0] * vx + inverse[wheel][1] * vy + inverse[wheel][2] * wz));
+  }
+  return min(FloatPack::broadcast(1.0f), limit / peak);
+}
+
+float dot(const float * a, const float * b, std::size_t size)
+{
+  Vec sum{};
+  for (std::size_t k = 0; k < size; k += kLanes) {
+    sum += FloatPack::load(a + k) * FloatPack::load(b + k);
+  }
+  float lanes[kLanes];
+  FloatPack::store(lanes, sum);
+  float total = 0.0f;
+  for (std::size_t lane = 0; lane < kLanes; ++lane) {
+    total += lanes[lane];
+  }
+  return total;
+}
+
+}  // namespace
+
+MppiPlanner::MppiPlanner(
+  const robocap_kinematics::KiwiDrive & drive, const MppiConfig & config, std::size_t workers)
+: config_(config),
+  samples_((std::max<std::size_t>(config.samples, 2) + kLanes - 1) / kLanes * kLanes),
+  steps_(std::max<std::size_t>(config.steps, 1)),
+  vx_(samples_ * steps_),
+  vy_(samples_ * steps_),
+  wz_(samples_ * steps_),
+  cost_(samples_),
+  weight_(samples_),
+  nominal_vx_(steps_),
+  nominal_vy_(steps_),
+  nominal_wz_(steps_),
+  samplers_(std::max<std::size_t>(workers, 1))
+{
+  for (std::size_t row = 0; row < 3; ++row) {
+    for (std::size_t col = 0; col < 3; ++col) {
+      inverse_[row][col] = static_cast<float>(drive.inverse_matrix()[row][col]);
+    }
+  }
+  for (std::size_t worker = 0; worker < samplers_.size(); ++worker) {
+    samplers_[worker].engine.seed(config.seed * 7919u + static_cast<std::uint32_t>(worker) + 1u);
+  }
+}
+
+void MppiPlanner::reset()
+{
+  std::fill(nominal_vx_.begin(), nominal_vx_.end(), 0.0f);
+  std::fill(nominal_vy_.begin(), nominal_vy_.end(), 0.0f);
+  std::fill(nominal_wz_.begin(), nominal_wz_.end(), 0.0f);
+}
+
+robocap_kinematics::Twist<double> MppiPlanner::plan(
+  const Pose2 & pose, const robocap_kinematics::Twist<double> & velocity, const Pose2 & goal,
+  const ObstacleView & obstacles, robocap_perception::ThreadPool & pool)
+{
+  // Rolled out relative to the start position, so floats keep millimetres far from the origin
+  const Problem problem{
+    static_cast<float>(pose.yaw),
+    static_cast<float>(velocity.vx),
+    static_cast<float>(velocity.vy),
+    static_cast<float>(velocity.wz),
+    static_cast<float>(goal.x - pose.x),
+    static_cast<float>(goal.y - pose.y),
+    static_cast<float>(std::cos(goal.yaw)),
+    static_cast<float>(std::sin(goal.yaw)),
+    obstacles,
+    static_cast<float>(obstacles.origin_x - pose.x),
+    static_cast<float>(obstacles.origin_y - pose.y),
+  };
+  pool.parallel_for(
+    samples_ / kLanes, kPacksPerChunk,
+    [this, &problem](std::size_t begin, std::size_t end, std::size_t worker) {
+      sample(begin, end, worker);
+      rollout(problem, begin, end);
+    });
+
+  const float min_cost = *std::min_element(cost_.begin(), cost_.end());
+  const float inverse_temperature = static_cast<float>(1.0 / config_.temperature);
+  float total = 0.0f;
+  for (std::size_t k = 0; k < samples_; ++k) {
+    weight_[k] = std::exp((min_cost - cost_[k]) * inverse_temperature);
+    total += weight_[k];
+  }
+  // The cheapest rollout has weight 1, so total >= 1
+  const float normalize = 1.0f / total;
+  for (std::size_t t = 0; t < steps_; ++t) {
+    const std::size_t row = t * samples_;
+    nominal_vx_[t] = dot(weight_.data(), &vx_[row], samples_) * normalize;
+    nominal_vy_[t] = dot(weight_.data(), &vy_[row], samples_) * normalize;
+    nominal_wz_[t] = dot(weight_.data(), &wz_[row], samples_) * normalize;
+  }
+  min_cost_ = min_cost;
+
+  const robocap_kinematics::Twist<double> command{nominal_vx_[0], nominal_vy_[0], nominal_wz_[0]};
+  // Warm start: the next cycle begins one step later, holding the last command
+  for (auto * nominal : {&nominal_vx_, &nominal_vy_, &nominal_wz_}) {
+    std::copy(nominal->begin() + 1, nominal->end(), nominal->begin());
+  }
+  return command;
+}
+
+void MppiPlanner::sample(std::size_t begin, std::size_t end, std::size_t worker)
+{
+  auto & sampler = samplers_[worker];
+  const auto noise_vx = static_cast<float>(config_.noise_vx);
+  const auto noise_vy = static_cast<float>(config_.noise_vy);
+  const auto noise_wz = static_cast<float>(config_.noise_wz);
+  const std::size_t first = begin * kLanes;
+  const std::size_t last = end * kLanes;
+  for (std::size_t t = 0; t < steps_; ++t) {
+    const std::size_t row = t * samples_;
+    std::size_t k = first;
+    // Sample 0 keeps the previous solution and sample 1 stops, both without noise
+    for (; k < std::min<std::size_t>(last, 2); ++k) {
+      const float keep = k == 0 ? 1.0f : 0.0f;
+      vx_[row + k] = keep * nominal_vx_[t];
+      vy_[row + k] = keep * nominal_vy_[t];
+      wz_[row + k] = keep * nominal_wz_[t];
+    }
+    for (; k < last; ++k) {
+      vx_[row + k] = nominal_vx_[t] + noise_vx * sampler.normal(sampler.engine);
+      vy_[row + k] = nominal_vy_[t] + noise_vy * sampler.normal(sampler.engine);
+      wz_[row + k] = nominal_wz_[t] + noise_wz * sampler.normal(sampler.engine);
+    }
+  }
+}
+
+void MppiPlanner::rollout(const Problem & problem, std::size_t begin, std::size_t end)
+{
+  const auto dt = static_cast<float>(config_.dt);
+  const auto step = FloatPack::broadcast(dt);
+  const auto max_change = FloatPack::broadcast(
+    static_cast<float>(config_.max_wheel_acceleration * config_.dt));
+  const auto max_speed = FloatPack::broadcast(static_cast<float>(config_.max_wheel_velocity));
+  const auto smoothness = FloatPack::broadcast(static_cast<float>(config_.smoothness_weight));
+  const auto goal_weight = static_cast<float>(config_.goal_weight * config_.dt);
+  const auto terminal_weight = static_cast<float>(config_.terminal_weight);
+  const auto collision_cost = static_cast<float>(config_.collision_cost);
+  const auto one = FloatPack::broadcast(1.0f);
+  Vec inverse[3][3];
+  for (std::size_t row = 0; row < 3; ++row) {
+    for (std::size_t col = 0; col < 3; ++col) {
+      inverse[row][col] = FloatPack::broadcast(inverse_[row][col]);
+    }
+  }
+  const auto & map = problem.obstacles;
+  const auto cells_per_metre = static_cast<float>(1.0 / map.resolution);
+
+  for (std::size_t pack = begin; pack < end; ++pack) {
+    const std::size_t first = pack * kLanes;
+    Vec x{};
+    Vec y{};
+    Vec c = FloatPack::broadcast(std::cos(problem.yaw));
+    Vec s = FloatPack::broadcast(std::sin(problem.yaw));
+    Vec last_vx = FloatPack::broadcast(problem.vx);
+    Vec last_vy = FloatPack::broadcast(problem.vy);
+    Vec last_wz = FloatPack::broadcast(problem.wz);
+    Vec cost{};
+    float lane_cost[kLanes] = {};
+    float lane_x[kLanes];
+    float lane_y[kLanes];
+
+    for (std::size_t t = 0; t < steps_; ++t) {
+      const std::size_t index = t * samples_ + first;
+      Vec vx = FloatPack::load(&vx_[index]);
+      Vec vy = FloatPack::load(&vy_[index]);
+      Vec wz = FloatPack::load(&wz_[index]);
+
+      // Wheel acceleration, then wheel speed
+      const Vec change = limit_scale(inverse, vx - last_vx, vy - last_vy, wz - last_wz, max_change);
+      vx = last_vx + (vx - last_vx) * change;
+      vy = last_vy + (vy - last_vy) * change;
+      wz = last_wz + (wz - last_wz) * change;
+      const Vec speed = limit_scale(inverse, vx, vy, wz, max_speed);
+      vx *= speed;
+      vy *= speed;
+      wz *= speed;
+      FloatPack::store(&vx_[index], vx);
+      FloatPack::store(&vy_[index], vy);
+      FloatPack::store(&wz_[index], wz);
+
+      const Vec dvx = vx - last_vx;
+      const Vec dvy = vy - last_vy;
+      const Vec dwz = wz - last_wz;
+      cost += smoothness * (dvx * dvx + dvy * dvy + dwz * dwz);
+      last_vx = vx;
+      last_vy = vy;
+      last_wz = wz;
+
+      x += (vx * c - vy * s) * step;
+      y += (vx * s + vy * c) * step;
+      // Rotate the heading by a = wz dt. Fifth order Taylor terms are within 1e-5 for the
+      // |a| < 0.5 any wheel limit allows at these step sizes, and need no vector sin/cos
+      const Vec a = wz * step;
+      const Vec a2 = a * a;
+      const Vec sin_a = a * (one - a2 * (1.0f / 6.0f - a2 * (1.0f / 120.0f)));
+      const Vec cos_a = one - a2 * (0.5f - a2 * (1.0f / 24.0f));
+      const Vec rotated_c = c * cos_a - s * sin_a;
+      s = s * cos_a + c * sin_a;
+      c = rotated_c;
+
+      // Goal distance and obstacles per lane, the map lookup is a gather anyway
+      FloatPack::store(lane_x, x);
+      FloatPack::store(lane_y, y);
+      for (std::size_t lane = 0; lane < kLanes; ++lane) {
+        const float ex = lane_x[lane] - problem.goal_x;
+        const float ey = lane_y[lane] - problem.goal_y;
+        lane_cost[lane] += goal_weight * std::sqrt(ex * ex + ey * ey);
+        if (map.lethal == nullptr) {
+          continue;
+        }
+        const auto cx =
+          static_cast<int>(std::floor((lane_x[lane] - problem.obstacle_x) * cells_per_metre));
+        const auto cy =
+          static_cast<int>(std::floor((lane_y[lane] - problem.obstacle_y) * cells_per_metre));
+        if (cx >= 0 && cy >= 0 && cx < map.size && cy < map.size &&
+          map.lethal[static_cast<std::size_t>(cy) * map.size + cx])
+        {
+          lane_cost[lane] += collision_cost;
+        }
+      }
+    }
+
+    for (std::size_t lane = 0; lane < kLanes; ++lane) {
+      const float ex = lane_x[lane] - problem.goal_x;
+      const float ey = lane_y[lane] - problem.goal_y;
+      lane_cost[lane] += terminal_weight * std::sqrt(ex * ex + ey * ey);
+    }
+    const auto heading = FloatPack::broadcast(static_cast<float>(config_.heading_weight));
+    const auto goal_cos = FloatPack::broadcast(problem.goal_cos);
+    const auto goal_sin = FloatPack::broadcast(problem.goal_sin);
+    cost += heading * (one - (c * goal_cos + s * goal_sin));
+    cost += FloatPack::load(lane_cost);
+    FloatPack::store(&cost_[first], cost);
+  }
+}
+
+}  // namespace robocap_planning
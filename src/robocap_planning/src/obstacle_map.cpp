@@ -0,0 +1,60 @@
+#include "robocap_planning/obstacle_map.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace robocap_planning
+{
+
+ObstacleMap::ObstacleMap(double robot_radius, int occupied_threshold)
+: robot_radius_(robot_radius), occupied_threshold_(occupied_threshold)
+{
+}
+
+void ObstacleMap::update(
+  const std::vector<std::int8_t> & cells, int size, double resolution, int origin_x,
+  int origin_y)
+{
+  if (resolution != resolution_) {
+    resolution_ = resolution;
+    const double radius = robot_radius_ / resolution;
+    const int rows = static_cast<int>(std::ceil(radius));
+    half_widths_.resize(static_cast<std::size_t>(2 * rows + 1));
+    for (int dy = -rows; dy <= rows; ++dy) {
+      half_widths_[dy + rows] =
+        static_cast<int>(std::ceil(std::sqrt(std::max(0.0, radius * radius - dy * dy))));
+    }
+  }
+  size_ = size;
+  origin_x_ = origin_x;
+  origin_y_ = origin_y;
+  lethal_.assign(static_cast<std::size_t>(size) * size, 0);
+
+  const int rows = static_cast<int>(half_widths_.size() / 2);
+  for (int y = 0; y < size; ++y) {
+    const std::int8_t * row = &cells[static_cast<std::size_t>(y) * size];
+    for (int x = 0; x < size; ++x) {
+      if (row[x] < occupied_threshold_) {
+        continue;
+      }
+      for (int dy = std::max(-rows, -y); dy <= std::min(rows, size - 1 - y); ++dy) {
+        const int half_width = half_widths_[dy + rows];
+        const int begin = std::max(0, x - half_width);
+        const int end = std::min(size - 1, x + half_width);
+        std::memset(&lethal_[static_cast<std::size_t>(y + dy) * size + begin], 1, end - begin + 1);
+      }
+    }
+  }
+}
+
+ObstacleView ObstacleMap::view() const
+{
+  if (lethal_.empty()) {
+    return ObstacleView{};
+  }
+  return ObstacleView{
+    lethal_.data(), size_, resolution_, origin_x_ * resolution_, origin_y_ * resolution_};
+}
+
+}  // namespace robocap_planning
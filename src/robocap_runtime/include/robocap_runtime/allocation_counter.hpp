@@ -0,0 +1,75 @@
+#ifndef ROBOCAP_RUNTIME__ALLOCATION_COUNTER_HPP_
+#define ROBOCAP_RUNTIME__ALLOCATION_COUNTER_HPP_
+
+#include <algorithm>
+#include <cstdint>
+
+namespace robocap_runtime
+{
+
+// Heap calls made by one thread: malloc, calloc, realloc and the aligned variants, and with them
+// every operator new, plus free
+struct AllocationCounts
+{
+  std::uint64_t allocations = 0;
+  std::uint64_t frees = 0;
+  std::uint64_t bytes = 0;  // Requested, not what the heap rounded it up to
+
+  AllocationCounts operator-(const AllocationCounts & other) const
+  {
+    return {allocations - other.allocations, frees - other.frees, bytes - other.bytes};
+  }
+};
+
+// The robocap_allocation_counter library replaces malloc and friends with wrappers that count
+// into thread-local counters and forward to glibc. Linking it into an executable, or preloading
+// it (LD_PRELOAD=librobocap_allocation_counter.so ros2 run ...), puts the wrappers in front of
+// glibc for the whole process; loaded any later, e.g. with a plugin, glibc's own stay in use and
+// nothing is counted. The counting is two thread-local increments per call, no lock, no atomic.
+
+// The calling thread's counts since it started
+AllocationCounts thread_allocation_counts();
+
+// True if this process's malloc is the counting one, i.e. the counts mean something
+bool allocation_counting_active();
+
+// Heap calls per cycle of a periodic loop: begin() and end() around each cycle, on the thread
+// running it. A steady-state real-time loop should report cycles_with_allocations() == 0.
+class CycleAllocationCounter
+{
+public:
+  void begin() {start_ = thread_allocation_counts();}
+
+  // Closes the cycle begin() opened, returns its allocations
+  std::uint64_t end()
+  {
+    last_ = thread_allocation_counts() - start_;
+    ++cycles_;
+    total_allocations_ += last_.allocations;
+    if (last_.allocations > 0) {
+      ++cycles_with_allocations_;
+      max_allocations_ = std::max(max_allocations_, last_.allocations);
+    }
+    return last_.allocations;
+  }
+
+  void reset() {*this = CycleAllocationCounter();}
+
+  const AllocationCounts & last() const {return last_;}
+  std::uint64_t cycles() const {return cycles_;}
+  std::uint64_t cycles_with_allocations() const {return cycles_with_allocations_;}
+  std::uint64_t total_allocations() const {return total_allocations_;}
+  std::uint64_t max_allocations() const {return max_allocations_;}
+
+private:
+  AllocationCounts start_;
+  AllocationCounts last_;
+  std::uint64_t cycles_ = 0;
+  std::uint64_t cycles_with_allocations_ = 0;
+  std::uint64_t total_allocations_ = 0;
+  std::uint64_t max_allocations_ = 0;
+};
+
+}  // namespace robocap_runtime
+
+#endif  // ROBOCAP_RUNTIME__ALLOCATION_COUNTER_HPP_
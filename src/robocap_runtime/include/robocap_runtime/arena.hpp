@@ -0,0 +1,71 @@
+#ifndef ROBOCAP_RUNTIME__ARENA_HPP_
+#define ROBOCAP_RUNTIME__ARENA_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+namespace robocap_runtime
+{
+
+struct ArenaStats
+{
+  std::uint64_t cycles = 0;     // reset() calls
+  std::uint64_t overflows = 0;  // Allocations passed on to the upstream resource
+  std::uint64_t regrows = 0;    // Times the buffer was replaced by a larger one
+  std::size_t high_water = 0;   // [bytes] most any one cycle asked for, padding included
+};
+
+// Per-cycle bump allocator: allocation moves a pointer through one buffer, deallocation does
+// nothing, and reset() at the top of each cycle hands the whole buffer out again. For the scratch
+// a loop builds and drops every cycle, e.g. std::pmr::vector<double> plan(&arena), which would
+// otherwise be a malloc and a free per container per cycle.
+//
+// Past the buffer's end allocations go to `upstream` and are counted as overflows, and the next
+// reset() frees them and regrows the buffer to what that cycle needed, so a loop whose demand
+// settles reaches a steady state that never calls upstream. Not thread-safe: one arena per loop.
+class Arena : public std::pmr::memory_resource
+{
+public:
+  explicit Arena(
+    std::size_t capacity, std::pmr::memory_resource * upstream = std::pmr::new_delete_resource());
+  ~Arena() override;
+
+  Arena(const Arena &) = delete;
+  Arena & operator=(const Arena &) = delete;
+
+  // Invalidates everything allocated since the last reset
+  void reset();
+
+  std::size_t capacity() const {return capacity_;}
+  std::size_t used() const {return used_;}  // [bytes] of the buffer this cycle
+  const ArenaStats & stats() const {return stats_;}
+
+protected:
+  void * do_allocate(std::size_t bytes, std::size_t alignment) override;
+  void do_deallocate(void * pointer, std::size_t bytes, std::size_t alignment) override;
+  bool do_is_equal(const std::pmr::memory_resource & other) const noexcept override;
+
+private:
+  // Heads every overflow block, chaining them for reset()
+  struct Overflow
+  {
+    Overflow * next;
+    std::size_t bytes;
+    std::size_t alignment;
+  };
+
+  void release_overflows();
+
+  std::pmr::memory_resource * upstream_;
+  std::byte * buffer_;
+  std::size_t capacity_;
+  std::size_t used_ = 0;
+  std::size_t demand_ = 0;  // [bytes] asked for this cycle, in the buffer or not
+  Overflow * overflows_ = nullptr;
+  ArenaStats stats_;
+};
+
+}  // namespace robocap_runtime
+
+#endif  // ROBOCAP_RUNTIME__ARENA_HPP_
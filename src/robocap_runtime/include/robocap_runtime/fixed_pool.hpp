@@ -0,0 +1,148 @@
+#ifndef ROBOCAP_RUNTIME__FIXED_POOL_HPP_
+#define ROBOCAP_RUNTIME__FIXED_POOL_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+
+namespace robocap_runtime
+{
+
+struct PoolStats
+{
+  std::uint64_t allocations = 0;  // Served by the pool
+  std::uint64_t overflows = 0;    // Passed on to the upstream resource: pool empty or too small
+  std::size_t in_use = 0;
+  std::size_t high_water = 0;     // Most blocks in use at once
+};
+
+// Lock-free stack of the indices 0..size-1, all free to start with: the free list under
+// FixedPool and MessagePool. The head carries a tag bumped on every push so that a pop racing a
+// pop-push of the same index fails its compare-exchange (no ABA). Neither call allocates.
+class FreeList
+{
+public:
+  static constexpr std::uint32_t kEmpty = UINT32_MAX;
+
+  explicit FreeList(std::size_t size);
+
+  // kEmpty if every index is taken
+  std::uint32_t pop();
+  void push(std::uint32_t index);
+
+  std::size_t size() const {return size_;}
+
+private:
+  std::size_t size_;
+  std::unique_ptr<std::atomic<std::uint32_t>[]> next_;
+  alignas(64) std::atomic<std::uint64_t> head_;  // tag << 32 | index
+};
+
+// Counters shared by the pools, relaxed atomics: one increment per allocation and release, with
+// the high water mark's compare-exchange only when it rises
+class PoolCounters
+{
+public:
+  void allocated();
+  void released() {releases_.fetch_add(1, std::memory_order_relaxed);}
+  void overflowed() {overflows_.fetch_add(1, std::memory_order_relaxed);}
+  PoolStats stats() const;
+
+private:
+  std::atomic<std::uint64_t> allocations_{0};
+  std::atomic<std::uint64_t> releases_{0};
+  std::atomic<std::uint64_t> overflows_{0};
+  std::atomic<std::size_t> high_water_{0};
+};
+
+// `block_count` blocks of `block_size` bytes carved out of one buffer taken from `upstream` up
+// front, as a std::pmr::memory_resource: behind std::pmr containers, std::allocate_shared's
+// control blocks, or an rcl allocator. Allocation and deallocation are a free-list pop and push,
+// lock-free and safe from any thread. A request the pool cannot serve (too large, over-aligned,
+// or every block taken) goes to `upstream` and is counted as an overflow, so a pool sized too
+// small shows up in stats() instead of failing.
+class FixedPool : public std::pmr::memory_resource
+{
+public:
+  static constexpr std::size_t kAlignment = 64;  // Of every block, a cache line
+
+  FixedPool(
+    std::size_t block_size, std::size_t block_count,
+    std::pmr::memory_resource * upstream = std::pmr::new_delete_resource());
+  ~FixedPool() override;
+
+  FixedPool(const FixedPool &) = delete;
+  FixedPool & operator=(const FixedPool &) = delete;
+
+  std::size_t block_size() const {return block_size_;}
+  std::size_t block_count() const {return free_.size();}
+  bool owns(const void * pointer) const;
+  PoolStats stats() const {return counters_.stats();}
+
+protected:
+  void * do_allocate(std::size_t bytes, std::size_t alignment) override;
+  void do_deallocate(void * pointer, std::size_t bytes, std::size_t alignment) override;
+  bool do_is_equal(const std::pmr::memory_resource & other) const noexcept override;
+
+private:
+  std::size_t block_size_;  // Rounded up to kAlignment
+  std::pmr::memory_resource * upstream_;
+  std::byte * buffer_;
+  FreeList free_;
+  PoolCounters counters_;
+};
+
+// Standard allocator over a FixedPool that shares ownership of it, for std::allocate_shared and
+// shared_ptr control blocks: the block's last release returns it to a pool that is still there,
+// where std::pmr::polymorphic_allocator's raw pointer could outlive the pool
+template<typename T>
+class FixedPoolAllocator
+{
+public:
+  using value_type = T;
+
+  explicit FixedPoolAllocator(std::shared_ptr<FixedPool> pool)
+  : pool_(std::move(pool))
+  {
+  }
+
+  template<typename U>
+  FixedPoolAllocator(const FixedPoolAllocator<U> & other)  // NOLINT implicit
+  : pool_(other.pool())
+  {
+  }
+
+  T * allocate(std::size_t count)
+  {
+    return static_cast<T *>(pool_->allocate(count * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T * pointer, std::size_t count)
+  {
+    pool_->deallocate(pointer, count * sizeof(T), alignof(T));
+  }
+
+  const std::shared_ptr<FixedPool> & pool() const {return pool_;}
+
+private:
+  std::shared_ptr<FixedPool> pool_;
+};
+
+template<typename T, typename U>
+bool operator==(const FixedPoolAllocator<T> & a, const FixedPoolAllocator<U> & b)
+{
+  return a.pool() == b.pool();
+}
+
+template<typename T, typename U>
+bool operator!=(const FixedPoolAllocator<T> & a, const FixedPoolAllocator<U> & b)
+{
+  return !(a == b);
+}
+
+}  // namespace robocap_runtime
+
+#endif  // ROBOCAP_RUNTIME__FIXED_POOL_HPP_
@@ -0,0 +1,257 @@
+#ifndef ROBOCAP_RUNTIME__MESSAGE_POOL_HPP_
+#define ROBOCAP_RUNTIME__MESSAGE_POOL_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "rclcpp/allocator/allocator_deleter.hpp"
+#include "rclcpp/message_memory_strategy.hpp"
+#include "rclcpp/publisher.hpp"
+
+#include "robocap_runtime/fixed_pool.hpp"
+
+namespace robocap_runtime
+{
+
+// Live messages kept for reuse. A message handed back keeps its sequences' and strings'
+// capacity, so refilling it with a message of the same shape (the same joints, the same beam
+// count) does not touch the heap, where a fresh message allocates every sequence again. That is
+// where most of a JointState's or LaserScan's mallocs are: the message object is one, its
+// sequences are the rest.
+//
+// acquire() and release() are a FreeList pop and push, lock-free from any thread. A message
+// comes back with whatever its last user left in it. An empty pool returns nullptr and counts
+// an overflow; the allocator and memory strategy below fall back to `upstream` then.
+template<typename MessageT>
+class MessagePool
+{
+public:
+  // `size` messages, each put through `prepare` once, e.g. to reserve their sequences
+  explicit MessagePool(
+    std::size_t size, const std::function<void(MessageT &)> & prepare = nullptr,
+    std::pmr::memory_resource * upstream = std::pmr::new_delete_resource())
+  : messages_(size), free_(size), upstream_(upstream)
+  {
+    if (prepare) {
+      for (auto & message : messages_) {
+        prepare(message);
+      }
+    }
+  }
+
+  MessagePool(const MessagePool &) = delete;
+  MessagePool & operator=(const MessagePool &) = delete;
+
+  MessageT * acquire()
+  {
+    const std::uint32_t index = free_.pop();
+    if (index == FreeList::kEmpty) {
+      counters_.overflowed();
+      return nullptr;
+    }
+    counters_.allocated();
+    return &messages_[index];
+  }
+
+  void release(MessageT * message)
+  {
+    free_.push(static_cast<std::uint32_t>(message - messages_.data()));
+    counters_.released();
+  }
+
+  bool owns(const MessageT * message) const
+  {
+    return message >= messages_.data() && message < messages_.data() + messages_.size();
+  }
+
+  std::size_t size() const {return messages_.size();}
+  std::pmr::memory_resource * upstream() const {return upstream_;}
+  PoolStats stats() const {return counters_.stats();}
+
+private:
+  std::vector<MessageT> messages_;
+  FreeList free_;
+  std::pmr::memory_resource * upstream_;
+  PoolCounters counters_;
+};
+
+// Allocator that hands out a MessagePool's messages, for rclcpp::PublisherOptionsWithAllocator.
+// rclcpp rebinds it to MessageT for the messages it allocates and to other types for everything
+// else; the MessageT instance takes messages from the pool and the rest goes to the pool's
+// upstream resource, as does a MessageT once the pool is empty.
+//
+// Pooled messages stay constructed while they are in the pool: construct() with no arguments
+// leaves the message as it was and construct() from a message assigns it, reusing capacity, and
+// destroy() leaves it alone. That is what makes Publisher::publish(const MessageT &) with
+// intra-process comms copy into a pooled message without allocating, and allocate_message()
+// below hand out one ready to fill.
+//
+// The pool outlives every publisher using it and every message in flight, each allocator copy
+// shares it. borrow_loaned_message() with a MessagePoolAllocator is only for rmws whose
+// can_loan_messages() is true: rclcpp's fallback loan destroys the message it allocated.
+template<typename MessageT, typename T = void>
+class MessagePoolAllocator
+{
+public:
+  using value_type = T;
+
+  template<typename U>
+  struct rebind
+  {
+    using other = MessagePoolAllocator<MessageT, U>;
+  };
+
+  explicit MessagePoolAllocator(std::shared_ptr<MessagePool<MessageT>> pool)
+  : pool_(std::move(pool))
+  {
+  }
+
+  template<typename U>
+  MessagePoolAllocator(const MessagePoolAllocator<MessageT, U> & other)  // NOLINT implicit
+  : pool_(other.pool())
+  {
+  }
+
+  T * allocate(std::size_t count)
+  {
+    if constexpr (std::is_same_v<T, MessageT>) {
+      if (count == 1) {
+        if (MessageT * message = pool_->acquire()) {
+          return message;
+        }
+      }
+    }
+    return static_cast<T *>(pool_->upstream()->allocate(count * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T * pointer, std::size_t count)
+  {
+    if constexpr (std::is_same_v<T, MessageT>) {
+      if (pool_->owns(pointer)) {
+        pool_->release(pointer);
+        return;
+      }
+    }
+    pool_->upstream()->deallocate(pointer, count * sizeof(T), alignof(T));
+  }
+
+  template<typename U, typename ... Args>
+  void construct(U * pointer, Args && ... args)
+  {
+    if constexpr (std::is_same_v<U, MessageT>) {
+      if (pool_->owns(pointer)) {
+        if constexpr (sizeof...(Args) == 1) {
+          *pointer = (std::forward<Args>(args), ...);
+        } else if constexpr (sizeof...(Args) > 1) {
+          *pointer = MessageT(std::forward<Args>(args)...);
+        }
+        return;
+      }
+    }
+    ::new (static_cast<void *>(pointer)) U(std::forward<Args>(args)...);
+  }
+
+  template<typename U>
+  void destroy(U * pointer)
+  {
+    if constexpr (std::is_same_v<U, MessageT>) {
+      if (pool_->owns(pointer)) {
+        return;
+      }
+    }
+    pointer->~U();
+  }
+
+  const std::shared_ptr<MessagePool<MessageT>> & pool() const {return pool_;}
+
+private:
+  std::shared_ptr<MessagePool<MessageT>> pool_;
+};
+
+template<typename MessageT, typename T, typename U>
+bool operator==(
+  const MessagePoolAllocator<MessageT, T> & a, const MessagePoolAllocator<MessageT, U> & b)
+{
+  return a.pool() == b.pool();
+}
+
+template<typename MessageT, typename T, typename U>
+bool operator!=(
+  const MessagePoolAllocator<MessageT, T> & a, const MessagePoolAllocator<MessageT, U> & b)
+{
+  return !(a == b);
+}
+
+// A message from `publisher`'s own allocator, as its publish(std::unique_ptr) takes it. With a
+// MessagePoolAllocator it is a pooled message, holding what it was last published with
+template<typename MessageT, typename AllocatorT>
+typename rclcpp::Publisher<MessageT, AllocatorT>::MessageUniquePtr allocate_message(
+  rclcpp::Publisher<MessageT, AllocatorT> & publisher)
+{
+  using PublisherT = rclcpp::Publisher<MessageT, AllocatorT>;
+  using Traits = typename PublisherT::MessageAllocatorTraits;
+  const auto allocator = publisher.get_allocator();
+  MessageT * message = Traits::allocate(*allocator, 1);
+  Traits::construct(*allocator, message);
+  typename PublisherT::MessageDeleter deleter;
+  rclcpp::allocator::set_allocator_for_deleter(&deleter, allocator.get());
+  return typename PublisherT::MessageUniquePtr(message, deleter);
+}
+
+// Subscription side: rclcpp takes every inter-process message into the shared_ptr borrowed here,
+// so with a MessagePool behind it the rmw deserializes into a pooled message's capacity and the
+// shared_ptr's control block comes from a FixedPool, neither from the heap. Pass it as
+// create_subscription()'s last argument. Callbacks should take the message by const reference
+// or ConstSharedPtr: a std::unique_ptr callback gets a heap copy.
+template<typename MessageT>
+class PooledMessageMemoryStrategy
+  : public rclcpp::message_memory_strategy::MessageMemoryStrategy<MessageT>
+{
+public:
+  // Comfortably above libstdc++'s control block for a pointer, deleter and allocator
+  static constexpr std::size_t kControlBlockSize = 128;
+
+  explicit PooledMessageMemoryStrategy(std::shared_ptr<MessagePool<MessageT>> pool)
+  : pool_(std::move(pool)),
+    control_blocks_(
+      std::make_shared<FixedPool>(kControlBlockSize, pool_->size(), pool_->upstream()))
+  {
+  }
+
+  std::shared_ptr<MessageT> borrow_message() override
+  {
+    MessageT * message = pool_->acquire();
+    if (!message) {
+      return rclcpp::message_memory_strategy::MessageMemoryStrategy<MessageT>::borrow_message();
+    }
+    // Deleter and allocator each share their pool, so a message that outlives the strategy (and
+    // its subscription) still has both to go back to
+    return std::shared_ptr<MessageT>(
+      message, Release{pool_}, FixedPoolAllocator<MessageT>(control_blocks_));
+  }
+
+  const std::shared_ptr<MessagePool<MessageT>> & pool() const {return pool_;}
+  PoolStats control_block_stats() const {return control_blocks_->stats();}
+
+private:
+  struct Release
+  {
+    std::shared_ptr<MessagePool<MessageT>> pool;
+
+    void operator()(MessageT * message) const {pool->release(message);}
+  };
+
+  std::shared_ptr<MessagePool<MessageT>> pool_;
+  std::shared_ptr<FixedPool> control_blocks_;
+};
+
+}  // namespace robocap_runtime
+
+#endif  // ROBOCAP_RUNTIME__MESSAGE_POOL_HPP_
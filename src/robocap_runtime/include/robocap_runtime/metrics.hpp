@@ -0,0 +1,179 @@
+#ifndef ROBOCAP_RUNTIME__METRICS_HPP_
+#define ROBOCAP_RUNTIME__METRICS_HPP_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace robocap_runtime
+{
+
+// std::chrono::steady_clock in nanoseconds, the clock latencies across threads are measured on
+inline std::int64_t steady_clock_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Label name/value pairs of one series, e.g. {{"controller", "kiwi_drive_controller"}}
+using Labels = std::vector<std::pair<std::string, std::string>>;
+
+struct HistogramSnapshot
+{
+  std::vector<std::uint64_t> counts;  // Per bucket, not cumulative, the last one unbounded
+  std::uint64_t count = 0;
+  std::uint64_t sum_ns = 0;
+  std::uint64_t max_ns = 0;
+
+  // Linear within the bucket the quantile falls in, `q` in [0, 1]. 0 when empty
+  double quantile_ns(double q) const;
+  double mean_ns() const {return count ? static_cast<double>(sum_ns) / count : 0.0;}
+};
+
+// Durations in nanoseconds, bucketed at two bounds per octave from 1 us (1, 1.5, 2, 3, 4, 6 us
+// ...) up to 25 s, plus one unbounded bucket: quantiles come out within a third of their value,
+// from a loop period to a stalled message. Recording is a handful of relaxed increments on the
+// calling thread's own shard, no lock and no allocation, from any number of threads; threads
+// beyond kShards share shards, still without locking. snapshot() sums the shards and is for
+// whoever exports the metrics, off the hot path.
+class Histogram
+{
+public:
+  static constexpr std::size_t kBounds = 50;
+  static constexpr std::size_t kBuckets = kBounds + 1;
+  static constexpr std::size_t kShards = 8;
+
+  // The bucket `ns` falls in, kBounds if beyond the last bound
+  static std::size_t bucket_of(std::uint64_t ns);
+  // Inclusive upper bound of `bucket` < kBounds
+  static std::uint64_t upper_bound_ns(std::size_t bucket);
+
+  void record(std::uint64_t ns);
+
+  // Negative durations, e.g. a stamp from a clock ahead of ours, count as 0
+  template<typename Rep, typename Period>
+  void record(std::chrono::duration<Rep, Period> duration)
+  {
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    record(static_cast<std::uint64_t>(ns > 0 ? ns : 0));
+  }
+
+  HistogramSnapshot snapshot() const;
+
+private:
+  struct alignas(64) Shard
+  {
+    std::array<std::atomic<std::uint64_t>, kBuckets> counts{};
+    std::atomic<std::uint64_t> sum_ns{0};
+    std::atomic<std::uint64_t> max_ns{0};
+  };
+
+  std::array<Shard, kShards> shards_;
+};
+
+// Monotonic count, e.g. overruns. One relaxed increment
+class Counter
+{
+public:
+  void add(std::uint64_t n = 1) {value_.fetch_add(n, std::memory_order_relaxed);}
+  std::uint64_t value() const {return value_.load(std::memory_order_relaxed);}
+
+private:
+  std::atomic<std::uint64_t> value_{0};
+};
+
+// Value that goes up and down, e.g. a queue depth or the real-time factor
+class Gauge
+{
+public:
+  void set(double value) {value_.store(value, std::memory_order_relaxed);}
+  void add(double delta);
+  double value() const {return value_.load(std::memory_order_relaxed);}
+
+private:
+  std::atomic<double> value_{0.0};
+};
+
+enum class MetricType
+{
+  kCounter,
+  kGauge,
+  kHistogram,
+};
+
+// One series as read by MetricsRegistry::snapshot()
+struct MetricSnapshot
+{
+  std::string name;
+  std::string help;
+  MetricType type;
+  Labels labels;
+  double value = 0.0;           // Counters and gauges
+  HistogramSnapshot histogram;  // Histograms
+};
+
+// Named series of a process, what MetricsServer and MetricsExporter export. Registration takes
+// a lock and may allocate, so components register in their constructor or on_configure and keep
+// the reference, which stays valid for the life of the registry; recording through it never
+// touches the registry again. Registering a name and labels twice returns the same series, so a
+// component that is loaded twice, or configured again, shares it. Names follow Prometheus: a
+// robocap_ prefix, _seconds for histograms (exported in seconds, recorded in nanoseconds) and
+// _total for counters.
+class MetricsRegistry
+{
+public:
+  // The process's registry: one per process with every component loaded into it, since they all
+  // share this library
+  static MetricsRegistry & global();
+
+  // Throw std::invalid_argument if `name` is already registered as another type
+  Histogram & histogram(const std::string & name, const std::string & help, const Labels & labels);
+  Counter & counter(const std::string & name, const std::string & help, const Labels & labels);
+  Gauge & gauge(const std::string & name, const std::string & help, const Labels & labels);
+
+  // Every series, sorted by name and then in registration order
+  std::vector<MetricSnapshot> snapshot() const;
+
+  // Text exposition format 0.0.4, as served on /metrics
+  std::string prometheus_text() const;
+
+private:
+  struct Series
+  {
+    Labels labels;
+    std::unique_ptr<Histogram> histogram;
+    std::unique_ptr<Counter> counter;
+    std::unique_ptr<Gauge> gauge;
+  };
+
+  struct Family
+  {
+    std::string help;
+    MetricType type;
+    std::deque<Series> series;  // Grows without moving the series handed out
+  };
+
+  Series & series(
+    const std::string & name, const std::string & help, MetricType type, const Labels & labels);
+
+  mutable std::mutex mutex_;
+  std::map<std::string, Family> families_;
+};
+
+// robocap_message_age_seconds of `topic` in `node`, the series components record their messages'
+// age in: from the header stamp to the callback taking it, or the bridge publishing it, on the
+// node's clock (simulated time under use_sim_time)
+Histogram & message_age_histogram(const std::string & node, const std::string & topic);
+
+}  // namespace robocap_runtime
+
+#endif  // ROBOCAP_RUNTIME__METRICS_HPP_
@@ -0,0 +1,56 @@
+#ifndef ROBOCAP_RUNTIME__METRICS_EXPORTER_HPP_
+#define ROBOCAP_RUNTIME__METRICS_EXPORTER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#include "diagnostic_msgs/msg/diagnostic_array.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "rosgraph_msgs/msg/clock.hpp"
+
+#include "robocap_runtime/metrics.hpp"
+#include "robocap_runtime/metrics_server.hpp"
+
+namespace robocap_runtime
+{
+
+// Exports the process's MetricsRegistry: Prometheus text on http://<address>:<port>/metrics,
+// and a diagnostic_msgs/DiagnosticArray on /diagnostics with one status per series (count, p50,
+// p99 and max in milliseconds for histograms, the value otherwise), e.g. for rqt_runtime_monitor.
+// Load one per process, into the container next to the components it reports on. It also
+// measures the simulation's real-time factor from /clock, as robocap_sim_real_time_factor.
+//
+// Both run on wall time and off the components' threads: the HTTP server on a thread of its
+// own, the diagnostics and the real-time factor on a wall timer.
+//
+// Parameters:
+//   port                HTTP port, defaults to 9464, 0 disables the endpoint
+//   address             IPv4 address to listen on, defaults to 0.0.0.0
+//   diagnostics_period  [s] between DiagnosticArrays, defaults to 1.0, 0 disables them
+class MetricsExporter : public rclcpp::Node
+{
+public:
+  explicit MetricsExporter(const rclcpp::NodeOptions & options);
+
+private:
+  void on_timer();
+  diagnostic_msgs::msg::DiagnosticArray diagnostics() const;
+
+  MetricsRegistry & registry_;
+  Gauge & real_time_factor_;
+  std::atomic<std::int64_t> sim_time_ns_{-1};  // Latest /clock, -1 before the first
+  std::int64_t last_sim_time_ns_ = -1;
+  std::chrono::steady_clock::time_point last_tick_;
+  bool publish_diagnostics_ = true;
+
+  std::unique_ptr<MetricsServer> server_;
+  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr diagnostics_publisher_;
+  rclcpp::Subscription<rosgraph_msgs::msg::Clock>::SharedPtr clock_subscription_;
+  rclcpp::TimerBase::SharedPtr timer_;
+};
+
+}  // namespace robocap_runtime
+
+#endif  // ROBOCAP_RUNTIME__METRICS_EXPORTER_HPP_
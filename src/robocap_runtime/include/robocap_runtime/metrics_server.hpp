@@ -0,0 +1,43 @@
+#ifndef ROBOCAP_RUNTIME__METRICS_SERVER_HPP_
+#define ROBOCAP_RUNTIME__METRICS_SERVER_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "robocap_runtime/metrics.hpp"
+
+namespace robocap_runtime
+{
+
+// Serves a MetricsRegistry's prometheus_text() on GET /metrics over plain HTTP/1.0, one request
+// per connection, from a thread of its own. The text is built per scrape, so the only cost
+// between scrapes is a poll() timing out. Anything but GET /metrics gets a 404.
+class MetricsServer
+{
+public:
+  // Throws std::runtime_error if `address`:`port` cannot be bound. Port 0 picks a free one
+  MetricsServer(MetricsRegistry & registry, const std::string & address, std::uint16_t port);
+  ~MetricsServer();
+
+  MetricsServer(const MetricsServer &) = delete;
+  MetricsServer & operator=(const MetricsServer &) = delete;
+
+  // The bound port
+  std::uint16_t port() const {return port_;}
+
+private:
+  void run();
+  void serve(int client);
+
+  MetricsRegistry & registry_;
+  int fd_ = -1;
+  std::uint16_t port_ = 0;
+  std::atomic<bool> running_{true};
+  std::thread thread_;
+};
+
+}  // namespace robocap_runtime
+
+#endif  // ROBOCAP_RUNTIME__METRICS_SERVER_HPP_
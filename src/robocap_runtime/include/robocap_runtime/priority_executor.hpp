@@ -0,0 +1,109 @@
+#ifndef ROBOCAP_RUNTIME__PRIORITY_EXECUTOR_HPP_
+#define ROBOCAP_RUNTIME__PRIORITY_EXECUTOR_HPP_
+
+#include <semaphore.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "rclcpp/any_executable.hpp"
+#include "rclcpp/callback_group.hpp"
+#include "rclcpp/executor.hpp"
+
+#include "robocap_runtime/metrics.hpp"
+#include "robocap_runtime/ready_queue.hpp"
+
+namespace robocap_runtime
+{
+
+// Scheduling of one tier's worker threads
+struct PriorityTier
+{
+  std::string name;
+  int priority = 0;        // SCHED_FIFO priority 1-99, 0 keeps the default scheduler
+  std::vector<int> cores;  // CPU affinity, empty leaves the threads unpinned
+  std::size_t threads = 1;
+};
+
+// Multi-threaded executor that runs callback groups in priority tiers, so control callbacks never
+// queue behind TF, markers or diagnostics. The thread calling spin() only waits for work: it hands
+// every ready executable to the lock-free queue of its group's tier and goes back to waiting. Each
+// tier's threads run only that queue, under their own scheduling policy and cores. Within a tier,
+// work runs in the order it became ready.
+//
+// The waiting thread takes the scheduling of the first tier, since every tier's latency includes
+// it. Groups are assigned by node name or one by one, everything else goes to the last tier.
+// Mutually exclusive groups keep their guarantee, the executor takes nothing else from a group
+// until its callback returned.
+//
+// Each tier's queue depth and full-queue waits are in robocap_runtime's MetricsRegistry, as
+// robocap_executor_queue_depth and robocap_executor_queue_full_total labelled with the tier.
+class PriorityExecutor : public rclcpp::Executor
+{
+public:
+  explicit PriorityExecutor(const rclcpp::ExecutorOptions & options = rclcpp::ExecutorOptions());
+  ~PriorityExecutor() override;
+
+  // Tiers in order of importance, returns the index of the new one. Like the assignments below,
+  // only before spin().
+  std::size_t add_tier(const PriorityTier & tier);
+
+  // Every callback group of nodes called `node_name` runs in `tier`. Either the plain or the fully
+  // qualified name, e.g. /robocap/ekf_node.
+  void set_node_tier(const std::string & node_name, std::size_t tier);
+
+  // Takes precedence over set_node_tier() for this group
+  void set_callback_group_tier(const rclcpp::CallbackGroup::SharedPtr & group, std::size_t tier);
+
+  void spin() override;
+
+  const std::vector<PriorityTier> & tiers() const {return configs_;}
+
+  // Executables that found their tier's queue full and waited for a slot
+  std::uint64_t queue_full_count() const {return queue_full_.load(std::memory_order_relaxed);}
+
+private:
+  static constexpr std::size_t kQueueCapacity = 256;
+
+  struct Tier
+  {
+    ReadyQueue<rclcpp::AnyExecutable, kQueueCapacity> queue;
+    sem_t ready;
+    std::vector<std::thread> threads;
+    Gauge * depth = nullptr;
+    Counter * full = nullptr;
+  };
+
+  struct GroupTier
+  {
+    std::weak_ptr<rclcpp::CallbackGroup> group;
+    std::size_t tier;
+  };
+
+  void push_tier(const PriorityTier & tier);
+  std::size_t tier_of(const rclcpp::AnyExecutable & executable);
+  void run_worker(std::size_t tier);
+  // After the workers joined: runs or releases what is left in the queues, zeroes the semaphores
+  void drain_tiers();
+  void check_not_spinning() const;
+
+  std::vector<PriorityTier> configs_;
+  std::vector<std::unique_ptr<Tier>> tiers_;
+  std::unordered_map<std::string, std::size_t> node_tiers_;
+  std::vector<GroupTier> group_overrides_;
+  // Only touched by the waiting thread, a cache of node_tiers_ and group_overrides_
+  std::unordered_map<const rclcpp::CallbackGroup *, GroupTier> group_tiers_;
+  std::atomic<bool> stopping_{false};
+  std::atomic<std::uint64_t> queue_full_{0};
+};
+
+}  // namespace robocap_runtime
+
+#endif  // ROBOCAP_RUNTIME__PRIORITY_EXECUTOR_HPP_
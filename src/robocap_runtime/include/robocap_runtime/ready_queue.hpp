@@ -0,0 +1,96 @@
+#ifndef ROBOCAP_RUNTIME__READY_QUEUE_HPP_
+#define ROBOCAP_RUNTIME__READY_QUEUE_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace robocap_runtime
+{
+
+// Bounded multi-producer/multi-consumer queue, the in-process sibling of robocap_sim::ShmRing
+// (Vyukov's sequence-per-slot ring). Values are moved in and out instead of copied, so it holds
+// shared_ptrs and other non-trivial types. Neither push() nor pop() locks or allocates.
+template<typename T, std::size_t Capacity>
+class ReadyQueue
+{
+  static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+  ReadyQueue()
+  {
+    for (std::size_t i = 0; i < Capacity; ++i) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  ReadyQueue(const ReadyQueue &) = delete;
+  ReadyQueue & operator=(const ReadyQueue &) = delete;
+
+  // Returns false, leaving `value` untouched, if the queue is full
+  bool push(T && value)
+  {
+    std::uint64_t position = tail_.load(std::memory_order_relaxed);
+    while (true) {
+      Slot & slot = slots_[position & kMask];
+      const std::uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::int64_t>(sequence - position);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          slot.value = std::move(value);
+          slot.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        position = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Returns false if the queue is empty. The slot is left default constructed, so it does not
+  // keep what it held alive until it is reused.
+  bool pop(T & value)
+  {
+    std::uint64_t position = head_.load(std::memory_order_relaxed);
+    while (true) {
+      Slot & slot = slots_[position & kMask];
+      const std::uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::int64_t>(sequence - (position + 1));
+      if (diff == 0) {
+        if (head_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          value = std::move(slot.value);
+          slot.value = T();
+          slot.sequence.store(position + Capacity, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        position = head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  static constexpr std::size_t capacity() {return Capacity;}
+
+private:
+  static constexpr std::uint64_t kMask = Capacity - 1;
+
+  struct alignas(64) Slot
+  {
+    std::atomic<std::uint64_t> sequence{0};
+    T value{};
+  };
+
+  alignas(64) std::atomic<std::uint64_t> head_{0};
+  alignas(64) std::atomic<std::uint64_t> tail_{0};
+  std::array<Slot, Capacity> slots_;
+};
+
+}  // namespace robocap_runtime
+
+#endif  // ROBOCAP_RUNTIME__READY_QUEUE_HPP_
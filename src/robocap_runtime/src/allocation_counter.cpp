@@ -0,0 +1,112 @@
+#include "robocap_runtime/allocation_counter.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+
+// glibc's allocator under its exported internal names, what the wrappers below forward to
+extern "C" {
+void * __libc_malloc(std::size_t size);
+void * __libc_calloc(std::size_t count, std::size_t size);
+void * __libc_realloc(void * pointer, std::size_t size);
+void * __libc_memalign(std::size_t alignment, std::size_t size);
+void __libc_free(void * pointer);
+}
+
+namespace
+{
+
+// Initial-exec so that touching it from inside malloc never calls back into malloc to set up
+// the thread's TLS; plain data, so there is no constructor to run either
+__attribute__((tls_model("initial-exec"))) thread_local robocap_runtime::AllocationCounts
+  counts;
+
+void count_allocation(std::size_t bytes)
+{
+  ++counts.allocations;
+  counts.bytes += bytes;
+}
+
+}  // namespace
+
+extern "C" {
+
+void * malloc(std::size_t size) noexcept
+{
+  count_allocation(size);
+  return __libc_malloc(size);
+}
+
+void * calloc(std::size_t count, std::size_t size) noexcept
+{
+  count_allocation(count * size);
+  return __libc_calloc(count, size);
+}
+
+void * realloc(void * pointer, std::size_t size) noexcept
+{
+  // A move to a new block, counted as its allocation and the old block's free
+  if (pointer) {
+    ++counts.frees;
+  }
+  if (size > 0) {
+    count_allocation(size);
+  }
+  return __libc_realloc(pointer, size);
+}
+
+void * memalign(std::size_t alignment, std::size_t size) noexcept
+{
+  count_allocation(size);
+  return __libc_memalign(alignment, size);
+}
+
+void * aligned_alloc(std::size_t alignment, std::size_t size) noexcept
+{
+  count_allocation(size);
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void ** pointer, std::size_t alignment, std::size_t size) noexcept
+{
+  if (alignment < sizeof(void *) || (alignment & (alignment - 1)) != 0) {
+    return EINVAL;
+  }
+  count_allocation(size);
+  void * block = __libc_memalign(alignment, size);
+  if (!block) {
+    return ENOMEM;
+  }
+  *pointer = block;
+  return 0;
+}
+
+void free(void * pointer) noexcept
+{
+  if (pointer) {
+    ++counts.frees;
+  }
+  __libc_free(pointer);
+}
+
+}  // extern "C"
+
+namespace robocap_runtime
+{
+
+AllocationCounts thread_allocation_counts()
+{
+  return counts;
+}
+
+bool allocation_counting_active()
+{
+  // Through a volatile pointer, so the compiler cannot drop the pair as it may a plain
+  // malloc followed by free. The pointer is whichever malloc the process resolved
+  void * (*volatile allocate)(std::size_t) = &std::malloc;
+  const auto before = counts.allocations;
+  std::free(allocate(1));
+  return counts.allocations != before;
+}
+
+}  // namespace robocap_runtime
@@ -0,0 +1,86 @@
+#include "robocap_runtime/arena.hpp"
+
+#include <algorithm>
+#include <new>
+
+namespace robocap_runtime
+{
+
+namespace
+{
+
+constexpr std::size_t kBufferAlignment = 64;
+
+std::size_t align_up(std::size_t value, std::size_t alignment)
+{
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}  // namespace
+
+Arena::Arena(std::size_t capacity, std::pmr::memory_resource * upstream)
+: upstream_(upstream),
+  buffer_(static_cast<std::byte *>(upstream->allocate(capacity, kBufferAlignment))),
+  capacity_(capacity)
+{
+}
+
+Arena::~Arena()
+{
+  release_overflows();
+  upstream_->deallocate(buffer_, capacity_, kBufferAlignment);
+}
+
+void Arena::reset()
+{
+  stats_.high_water = std::max(stats_.high_water, demand_);
+  if (overflows_) {
+    release_overflows();
+    upstream_->deallocate(buffer_, capacity_, kBufferAlignment);
+    capacity_ = align_up(demand_, kBufferAlignment);
+    buffer_ = static_cast<std::byte *>(upstream_->allocate(capacity_, kBufferAlignment));
+    ++stats_.regrows;
+  }
+  used_ = 0;
+  demand_ = 0;
+  ++stats_.cycles;
+}
+
+void * Arena::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+  // Aligned by address, buffer_ itself is only kBufferAlignment aligned
+  const auto base = reinterpret_cast<std::uintptr_t>(buffer_);
+  const std::size_t offset = align_up(base + used_, alignment) - base;
+  demand_ += offset - used_ + bytes;
+  if (offset + bytes <= capacity_) {
+    used_ = offset + bytes;
+    return buffer_ + offset;
+  }
+  // The header padded to `alignment`, so the block after it stays aligned
+  const std::size_t block_alignment = std::max(alignment, alignof(Overflow));
+  const std::size_t header = align_up(sizeof(Overflow), block_alignment);
+  auto * block = static_cast<std::byte *>(upstream_->allocate(header + bytes, block_alignment));
+  overflows_ = new (block) Overflow{overflows_, header + bytes, block_alignment};
+  ++stats_.overflows;
+  return block + header;
+}
+
+void Arena::do_deallocate(void *, std::size_t, std::size_t)
+{
+}
+
+bool Arena::do_is_equal(const std::pmr::memory_resource & other) const noexcept
+{
+  return this == &other;
+}
+
+void Arena::release_overflows()
+{
+  while (overflows_) {
+    Overflow * next = overflows_->next;
+    upstream_->deallocate(overflows_, overflows_->bytes, overflows_->alignment);
+    overflows_ = next;
+  }
+}
+
+}  // namespace robocap_runtime
@@ -0,0 +1,146 @@
+#include "robocap_runtime/fixed_pool.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace robocap_runtime
+{
+
+namespace
+{
+
+constexpr std::uint64_t kIndexMask = 0xffffffffu;
+
+std::uint64_t pack(std::uint64_t tag, std::uint32_t index)
+{
+  return tag << 32 | index;
+}
+
+}  // namespace
+
+FreeList::FreeList(std::size_t size)
+: size_(size),
+  next_(std::make_unique<std::atomic<std::uint32_t>[]>(size)),
+  head_(pack(0, size > 0 ? 0 : kEmpty))
+{
+  if (size >= kEmpty) {
+    throw std::invalid_argument("FreeList: size must be below 2^32 - 1");
+  }
+  for (std::size_t i = 0; i < size; ++i) {
+    next_[i].store(i + 1 < size ? static_cast<std::uint32_t>(i + 1) : kEmpty,
+      std::memory_order_relaxed);
+  }
+}
+
+std::uint32_t FreeList::pop()
+{
+  std::uint64_t head = head_.load(std::memory_order_acquire);
+  while (true) {
+    const auto index = static_cast<std::uint32_t>(head & kIndexMask);
+    if (index == kEmpty) {
+      return kEmpty;
+    }
+    // May read the link of an index another thread just popped; the tag makes the exchange fail
+    const std::uint32_t next = next_[index].load(std::memory_order_relaxed);
+    if (head_.compare_exchange_weak(
+        head, pack(head >> 32, next), std::memory_order_acquire, std::memory_order_acquire))
+    {
+      return index;
+    }
+  }
+}
+
+void FreeList::push(std::uint32_t index)
+{
+  std::uint64_t head = head_.load(std::memory_order_relaxed);
+  while (true) {
+    next_[index].store(static_cast<std::uint32_t>(head & kIndexMask), std::memory_order_relaxed);
+    if (head_.compare_exchange_weak(
+        head, pack((head >> 32) + 1, index), std::memory_order_release,
+        std::memory_order_relaxed))
+    {
+      return;
+    }
+  }
+}
+
+void PoolCounters::allocated()
+{
+  const std::uint64_t allocations = allocations_.fetch_add(1, std::memory_order_relaxed) + 1;
+  // Other threads' allocations and releases between the two counters can make this low, even
+  // negative, so the mark is a lower bound under contention and exact without it
+  const auto outstanding = static_cast<std::int64_t>(
+    allocations - releases_.load(std::memory_order_relaxed));
+  if (outstanding <= 0) {
+    return;
+  }
+  const auto in_use = static_cast<std::size_t>(outstanding);
+  std::size_t high_water = high_water_.load(std::memory_order_relaxed);
+  while (in_use > high_water &&
+    !high_water_.compare_exchange_weak(high_water, in_use, std::memory_order_relaxed))
+  {
+  }
+}
+
+PoolStats PoolCounters::stats() const
+{
+  PoolStats stats;
+  // Releases first, so that a release racing this read cannot make in_use negative
+  const std::uint64_t releases = releases_.load(std::memory_order_relaxed);
+  stats.allocations = allocations_.load(std::memory_order_relaxed);
+  stats.overflows = overflows_.load(std::memory_order_relaxed);
+  stats.in_use = static_cast<std::size_t>(stats.allocations - releases);
+  stats.high_water = high_water_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+FixedPool::FixedPool(
+  std::size_t block_size, std::size_t block_count, std::pmr::memory_resource * upstream)
+: block_size_((std::max<std::size_t>(block_size, 1) + kAlignment - 1) / kAlignment * kAlignment),
+  upstream_(upstream),
+  buffer_(static_cast<std::byte *>(upstream->allocate(block_size_ * block_count, kAlignment))),
+  free_(block_count)
+{
+}
+
+FixedPool::~FixedPool()
+{
+  upstream_->deallocate(buffer_, block_size_ * free_.size(), kAlignment);
+}
+
+bool FixedPool::owns(const void * pointer) const
+{
+  const auto * byte = static_cast<const std::byte *>(pointer);
+  return byte >= buffer_ && byte < buffer_ + block_size_ * free_.size();
+}
+
+void * FixedPool::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+  if (bytes <= block_size_ && alignment <= kAlignment) {
+    const std::uint32_t index = free_.pop();
+    if (index != FreeList::kEmpty) {
+      counters_.allocated();
+      return buffer_ + static_cast<std::size_t>(index) * block_size_;
+    }
+  }
+  counters_.overflowed();
+  return upstream_->allocate(bytes, alignment);
+}
+
+void FixedPool::do_deallocate(void * pointer, std::size_t bytes, std::size_t alignment)
+{
+  if (!owns(pointer)) {
+    upstream_->deallocate(pointer, bytes, alignment);
+    return;
+  }
+  const auto offset = static_cast<std::size_t>(static_cast<std::byte *>(pointer) - buffer_);
+  free_.push(static_cast<std::uint32_t>(offset / block_size_));
+  counters_.released();
+}
+
+bool FixedPool::do_is_equal(const std::pmr::memory_resource & other) const noexcept
+{
+  return this == &other;
+}
+
+}  // namespace robocap_runtime
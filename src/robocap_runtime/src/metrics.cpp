@@ -0,0 +1,272 @@
+#include "robocap_runtime/metrics.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+namespace robocap_runtime
+{
+
+namespace
+{
+
+constexpr const char * kTypeNames[] = {"counter", "gauge", "histogram"};
+
+std::size_t thread_shard()
+{
+  // Handed out round robin as threads first record, so up to kShards threads never share one
+  static std::atomic<std::size_t> next{0};
+  thread_local const std::size_t shard =
+    next.fetch_add(1, std::memory_order_relaxed) % Histogram::kShards;
+  return shard;
+}
+
+void raise_max(std::atomic<std::uint64_t> & max, std::uint64_t value)
+{
+  std::uint64_t current = max.load(std::memory_order_relaxed);
+  while (value > current &&
+    !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+  {
+  }
+}
+
+std::string format_number(double value)
+{
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+  return buffer;
+}
+
+void append_escaped(std::string & text, const std::string & value)
+{
+  for (const char c : value) {
+    if (c == '\\' || c == '"') {
+      text += '\\';
+      text += c;
+    } else if (c == '\n') {
+      text += "\\n";
+    } else {
+      text += c;
+    }
+  }
+}
+
+// {a="1",b="2"} with an optional extra label, nothing if there are no labels at all
+void append_labels(
+  std::string & text, const Labels & labels, const char * extra_name = nullptr,
+  const std::string & extra_value = {})
+{
+  if (labels.empty() && !extra_name) {
+    return;
+  }
+  text += '{';
+  bool first = true;
+  for (const auto & [name, value] : labels) {
+    text += first ? "" : ",";
+    text += name + "=\"";
+    append_escaped(text, value);
+    text += '"';
+    first = false;
+  }
+  if (extra_name) {
+    text += first ? "" : ",";
+    text += std::string(extra_name) + "=\"" + extra_value + "\"";
+  }
+  text += '}';
+}
+
+}  // namespace
+
+double HistogramSnapshot::quantile_ns(double q) const
+{
+  if (count == 0) {
+    return 0.0;
+  }
+  const double rank = std::clamp(q, 0.0, 1.0) * static_cast<double>(count);
+  std::uint64_t below = 0;
+  for (std::size_t bucket = 0; bucket < counts.size(); ++bucket) {
+    if (counts[bucket] == 0 || static_cast<double>(below + counts[bucket]) < rank) {
+      below += counts[bucket];
+      continue;
+    }
+    const double lower =
+      bucket == 0 ? 0.0 : static_cast<double>(Histogram::upper_bound_ns(bucket - 1));
+    const double upper = bucket < Histogram::kBounds ?
+      static_cast<double>(Histogram::upper_bound_ns(bucket)) : static_cast<double>(max_ns);
+    const double fraction = (rank - static_cast<double>(below)) / counts[bucket];
+    return std::min(lower + fraction * (upper - lower), static_cast<double>(max_ns));
+  }
+  return static_cast<double>(max_ns);
+}
+
+std::size_t Histogram::bucket_of(std::uint64_t ns)
+{
+  if (ns <= 1000) {
+    return 0;
+  }
+  // In half microseconds every bound is an integer: 2^(o + 1) and 3 * 2^(o - 1) in octave o
+  const std::uint64_t halves = (ns + 499) / 500;
+  const auto octave = static_cast<std::size_t>(63 - __builtin_clzll(halves - 1));
+  const std::size_t bucket = 2 * halves <= (std::uint64_t{3} << octave) ?
+    2 * octave - 1 : 2 * octave;
+  return std::min(bucket, kBounds);
+}
+
+std::uint64_t Histogram::upper_bound_ns(std::size_t bucket)
+{
+  return (bucket % 2 == 0 ? std::uint64_t{1000} : std::uint64_t{1500}) << (bucket / 2);
+}
+
+void Histogram::record(std::uint64_t ns)
+{
+  Shard & shard = shards_[thread_shard()];
+  shard.counts[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+  shard.sum_ns.fetch_add(ns, std::memory_order_relaxed);
+  raise_max(shard.max_ns, ns);
+}
+
+HistogramSnapshot Histogram::snapshot() const
+{
+  HistogramSnapshot snapshot;
+  snapshot.counts.assign(kBuckets, 0);
+  // Shards are read while they are written: a record() may show in its bucket and not yet in
+  // the sum, which the next snapshot makes up for
+  for (const Shard & shard : shards_) {
+    for (std::size_t bucket = 0; bucket < kBuckets; ++bucket) {
+      const std::uint64_t count = shard.counts[bucket].load(std::memory_order_relaxed);
+      snapshot.counts[bucket] += count;
+      snapshot.count += count;
+    }
+    snapshot.sum_ns += shard.sum_ns.load(std::memory_order_relaxed);
+    snapshot.max_ns = std::max(snapshot.max_ns, shard.max_ns.load(std::memory_order_relaxed));
+  }
+  return snapshot;
+}
+
+void Gauge::add(double delta)
+{
+  double current = value_.load(std::memory_order_relaxed);
+  while (!value_.compare_exchange_weak(current, current + delta, std::memory_order_relaxed)) {
+  }
+}
+
+MetricsRegistry & MetricsRegistry::global()
+{
+  static MetricsRegistry registry;
+  return registry;
+}
+
+Histogram & MetricsRegistry::histogram(
+  const std::string & name, const std::string & help, const Labels & labels)
+{
+  return *series(name, help, MetricType::kHistogram, labels).histogram;
+}
+
+Counter & MetricsRegistry::counter(
+  const std::string & name, const std::string & help, const Labels & labels)
+{
+  return *series(name, help, MetricType::kCounter, labels).counter;
+}
+
+Gauge & MetricsRegistry::gauge(
+  const std::string & name, const std::string & help, const Labels & labels)
+{
+  return *series(name, help, MetricType::kGauge, labels).gauge;
+}
+
+MetricsRegistry::Series & MetricsRegistry::series(
+  const std::string & name, const std::string & help, MetricType type, const Labels & labels)
+{
+  const std::lock_guard<std::mutex> lock(mutex_);
+  auto [family, inserted] = families_.try_emplace(name, Family{help, type, {}});
+  if (!inserted && family->second.type != type) {
+    throw std::invalid_argument(
+      "metric '" + name + "' is already registered as a " +
+      kTypeNames[static_cast<int>(family->second.type)]);
+  }
+  auto & all = family->second.series;
+  const auto existing = std::find_if(
+    all.begin(), all.end(), [&labels](const Series & series) {return series.labels == labels;});
+  if (existing != all.end()) {
+    return *existing;
+  }
+  Series & series = all.emplace_back();
+  series.labels = labels;
+  switch (type) {
+    case MetricType::kCounter:
+      series.counter = std::make_unique<Counter>();
+      break;
+    case MetricType::kGauge:
+      series.gauge = std::make_unique<Gauge>();
+      break;
+    case MetricType::kHistogram:
+      series.histogram = std::make_unique<Histogram>();
+      break;
+  }
+  return series;
+}
+
+std::vector<MetricSnapshot> MetricsRegistry::snapshot() const
+{
+  std::vector<MetricSnapshot> snapshot;
+  const std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto & [name, family] : families_) {
+    for (const auto & series : family.series) {
+      MetricSnapshot metric{name, family.help, family.type, series.labels, 0.0, {}};
+      if (series.counter) {
+        metric.value = static_cast<double>(series.counter->value());
+      } else if (series.gauge) {
+        metric.value = series.gauge->value();
+      } else {
+        metric.histogram = series.histogram->snapshot();
+      }
+      snapshot.push_back(std::move(metric));
+    }
+  }
+  return snapshot;
+}
+
+std::string MetricsRegistry::prometheus_text() const
+{
+  std::string text;
+  const std::string * family = nullptr;
+  for (const auto & metric : snapshot()) {
+    if (!family || *family != metric.name) {
+      text += "# HELP " + metric.name + " " + metric.help + "\n";
+      text += "# TYPE " + metric.name + " " + kTypeNames[static_cast<int>(metric.type)] + "\n";
+    }
+    family = &metric.name;
+    if (metric.type != MetricType::kHistogram) {
+      text += metric.name;
+      append_labels(text, metric.labels);
+      text += " " + format_number(metric.value) + "\n";
+      continue;
+    }
+    const auto & histogram = metric.histogram;
+    std::uint64_t cumulative = 0;
+    for (std::size_t bucket = 0; bucket < Histogram::kBuckets; ++bucket) {
+      cumulative += histogram.counts[bucket];
+      text += metric.name + "_bucket";
+      append_labels(
+        text, metric.labels, "le", bucket < Histogram::kBounds ?
+        format_number(Histogram::upper_bound_ns(bucket) * 1e-9) : "+Inf");
+      text += " " + std::to_string(cumulative) + "\n";
+    }
+    text += metric.name + "_sum";
+    append_labels(text, metric.labels);
+    text += " " + format_number(histogram.sum_ns * 1e-9) + "\n";
+    text += metric.name + "_count";
+    append_labels(text, metric.labels);
+    text += " " + std::to_string(histogram.count) + "\n";
+  }
+  return text;
+}
+
+Histogram & message_age_histogram(const std::string & node, const std::string & topic)
+{
+  return MetricsRegistry::global().histogram(
+    "robocap_message_age_seconds", "Time from a message's stamp to a component taking it in",
+    {{"node", node}, {"topic", topic}});
+}
+
+}  // namespace robocap_runtime
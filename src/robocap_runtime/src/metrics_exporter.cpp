@@ -0,0 +1,125 @@
+#include "robocap_runtime/metrics_exporter.hpp"
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "diagnostic_msgs/msg/diagnostic_status.hpp"
+#include "diagnostic_msgs/msg/key_value.hpp"
+
+namespace robocap_runtime
+{
+
+namespace
+{
+
+diagnostic_msgs::msg::KeyValue key_value(const std::string & key, double value)
+{
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%.6g", value);
+  diagnostic_msgs::msg::KeyValue pair;
+  pair.key = key;
+  pair.value = buffer;
+  return pair;
+}
+
+// name{a=1,b=2}, the series' name in diagnostics
+std::string series_name(const MetricSnapshot & metric)
+{
+  std::string name = metric.name;
+  if (!metric.labels.empty()) {
+    name += '{';
+    for (std::size_t i = 0; i < metric.labels.size(); ++i) {
+      name += (i ? "," : "") + metric.labels[i].first + "=" + metric.labels[i].second;
+    }
+    name += '}';
+  }
+  return name;
+}
+
+}  // namespace
+
+MetricsExporter::MetricsExporter(const rclcpp::NodeOptions & options)
+: rclcpp::Node("metrics_exporter", options),
+  registry_(MetricsRegistry::global()),
+  real_time_factor_(registry_.gauge(
+      "robocap_sim_real_time_factor", "Simulated seconds per wall clock second, from /clock",
+      {})),
+  last_tick_(std::chrono::steady_clock::now())
+{
+  const auto port = declare_parameter<int>("port", 9464);
+  const auto address = declare_parameter<std::string>("address", "0.0.0.0");
+  const auto period = declare_parameter<double>("diagnostics_period", 1.0);
+  if (port < 0 || port > 65535) {
+    throw std::invalid_argument("'port' must be in [0, 65535]");
+  }
+  if (period < 0.0) {
+    throw std::invalid_argument("'diagnostics_period' must not be negative");
+  }
+
+  if (port > 0) {
+    server_ = std::make_unique<MetricsServer>(
+      registry_, address, static_cast<std::uint16_t>(port));
+    RCLCPP_INFO(
+      get_logger(), "Serving metrics on http://%s:%u/metrics", address.c_str(), server_->port());
+  }
+  publish_diagnostics_ = period > 0.0;
+  if (publish_diagnostics_) {
+    diagnostics_publisher_ = create_publisher<diagnostic_msgs::msg::DiagnosticArray>(
+      "/diagnostics", rclcpp::SystemDefaultsQoS());
+  }
+  clock_subscription_ = create_subscription<rosgraph_msgs::msg::Clock>(
+    "/clock", rclcpp::ClockQoS(), [this](const rosgraph_msgs::msg::Clock & message) {
+      sim_time_ns_.store(rclcpp::Time(message.clock).nanoseconds(), std::memory_order_relaxed);
+    });
+  // The real-time factor is measured on the same tick when diagnostics are off
+  timer_ = create_wall_timer(
+    std::chrono::duration<double>(publish_diagnostics_ ? period : 1.0), [this]() {on_timer();});
+}
+
+void MetricsExporter::on_timer()
+{
+  const auto now = std::chrono::steady_clock::now();
+  const std::int64_t sim_time_ns = sim_time_ns_.load(std::memory_order_relaxed);
+  if (sim_time_ns >= 0 && last_sim_time_ns_ >= 0) {
+    const double wall = std::chrono::duration<double>(now - last_tick_).count();
+    real_time_factor_.set(static_cast<double>(sim_time_ns - last_sim_time_ns_) * 1e-9 / wall);
+  }
+  last_sim_time_ns_ = sim_time_ns;
+  last_tick_ = now;
+
+  if (publish_diagnostics_) {
+    diagnostics_publisher_->publish(diagnostics());
+  }
+}
+
+diagnostic_msgs::msg::DiagnosticArray MetricsExporter::diagnostics() const
+{
+  diagnostic_msgs::msg::DiagnosticArray array;
+  array.header.stamp = now();
+  for (const auto & metric : registry_.snapshot()) {
+    diagnostic_msgs::msg::DiagnosticStatus status;
+    status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+    status.name = series_name(metric);
+    status.message = metric.help;
+    status.hardware_id = get_fully_qualified_name();
+    if (metric.type == MetricType::kHistogram) {
+      const auto & histogram = metric.histogram;
+      status.values.push_back(key_value("count", static_cast<double>(histogram.count)));
+      status.values.push_back(key_value("p50_ms", histogram.quantile_ns(0.5) * 1e-6));
+      status.values.push_back(key_value("p99_ms", histogram.quantile_ns(0.99) * 1e-6));
+      status.values.push_back(key_value("max_ms", static_cast<double>(histogram.max_ns) * 1e-6));
+    } else {
+      status.values.push_back(key_value("value", metric.value));
+    }
+    array.status.push_back(std::move(status));
+  }
+  return array;
+}
+
+}  // namespace robocap_runtime
+
+#include "rclcpp_components/register_node_macro.hpp"
+
+RCLCPP_COMPONENTS_REGISTER_NODE(robocap_runtime::MetricsExporter)
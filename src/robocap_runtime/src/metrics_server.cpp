@@ -0,0 +1,132 @@
+#include "robocap_runtime/metrics_server.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace robocap_runtime
+{
+
+namespace
+{
+
+constexpr int kPollTimeoutMs = 200;  // How long the destructor may wait for the thread
+constexpr int kReceiveTimeoutS = 1;  // For a client that connects and says nothing
+constexpr std::size_t kMaxRequest = 4096;
+
+bool write_all(int fd, const std::string & data)
+{
+  const char * bytes = data.data();
+  std::size_t size = data.size();
+  while (size > 0) {
+    const ssize_t n = ::send(fd, bytes, size, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    bytes += n;
+    size -= static_cast<std::size_t>(n);
+  }
+  return true;
+}
+
+std::string response(const char * status, const char * content_type, const std::string & body)
+{
+  return std::string("HTTP/1.0 ") + status + "\r\nContent-Type: " + content_type +
+         "\r\nContent-Length: " + std::to_string(body.size()) +
+         "\r\nConnection: close\r\n\r\n" + body;
+}
+
+}  // namespace
+
+MetricsServer::MetricsServer(
+  MetricsRegistry & registry, const std::string & address, std::uint16_t port)
+: registry_(registry)
+{
+  sockaddr_in bind_address{};
+  bind_address.sin_family = AF_INET;
+  bind_address.sin_port = htons(port);
+  if (::inet_pton(AF_INET, address.c_str(), &bind_address.sin_addr) != 1) {
+    throw std::invalid_argument("MetricsServer: '" + address + "' is not an IPv4 address");
+  }
+  fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd_ < 0) {
+    throw std::runtime_error(std::string("MetricsServer: socket: ") + std::strerror(errno));
+  }
+  // A restarted container rebinds while the last one's connections are in TIME_WAIT
+  const int reuse = 1;
+  ::setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  socklen_t length = sizeof(bind_address);
+  if (::bind(fd_, reinterpret_cast<const sockaddr *>(&bind_address), sizeof(bind_address)) != 0 ||
+    ::listen(fd_, 8) != 0 ||
+    ::getsockname(fd_, reinterpret_cast<sockaddr *>(&bind_address), &length) != 0)
+  {
+    const std::string error = std::strerror(errno);
+    ::close(fd_);
+    throw std::runtime_error(
+      "MetricsServer: cannot listen on " + address + ":" + std::to_string(port) + ": " + error);
+  }
+  port_ = ntohs(bind_address.sin_port);
+  thread_ = std::thread([this]() {run();});
+}
+
+MetricsServer::~MetricsServer()
+{
+  running_ = false;
+  thread_.join();
+  ::close(fd_);
+}
+
+void MetricsServer::run()
+{
+  while (running_.load()) {
+    pollfd listener{fd_, POLLIN, 0};
+    if (::poll(&listener, 1, kPollTimeoutMs) <= 0) {
+      continue;
+    }
+    const int client = ::accept4(fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (client < 0) {
+      continue;
+    }
+    serve(client);
+    ::close(client);
+  }
+}
+
+void MetricsServer::serve(int client)
+{
+  const timeval timeout{kReceiveTimeoutS, 0};
+  ::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  // Only the request line matters, the headers after it are read and ignored
+  std::string request;
+  char buffer[512];
+  while (request.find("\r\n") == std::string::npos && request.size() < kMaxRequest) {
+    const ssize_t n = ::recv(client, buffer, sizeof(buffer), 0);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return;
+    }
+    request.append(buffer, static_cast<std::size_t>(n));
+  }
+  const auto line = request.substr(0, request.find("\r\n"));
+  if (line.rfind("GET /metrics ", 0) == 0 || line == "GET /metrics") {
+    write_all(
+      client, response(
+        "200 OK", "text/plain; version=0.0.4; charset=utf-8", registry_.prometheus_text()));
+  } else {
+    write_all(client, response("404 Not Found", "text/plain", "Only /metrics is served\n"));
+  }
+}
+
+}  // namespace robocap_runtime
@@ -0,0 +1,83 @@
+// Component container on a robocap_runtime::PriorityExecutor, a drop-in for component_container_mt
+// where control and estimation callbacks must not wait behind TF, markers or diagnostics.
+//
+// Parameters of the container node:
+//   tiers            tier names, most important first. Nodes nobody assigned run in the last one
+//   <tier>.priority  SCHED_FIFO priority 1-99, 0 (default) keeps the default scheduler
+//   <tier>.cores     CPUs the tier's threads are pinned to, ideally isolated (isolcpus, nohz_full)
+//   <tier>.threads   worker threads, defaults to 1
+//   <tier>.nodes     names of the nodes whose callbacks run in this tier
+//   lock_memory      mlockall() before loading any component, defaults to false
+//
+// See config/priority_tiers.yaml for the robocap stack.
+
+#include <sys/mman.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+#include "rclcpp_components/component_manager.hpp"
+
+#include "robocap_runtime/priority_executor.hpp"
+
+namespace
+{
+
+void configure_tiers(rclcpp::Node & node, robocap_runtime::PriorityExecutor & executor)
+{
+  const auto names = node.declare_parameter<std::vector<std::string>>(
+    "tiers", std::vector<std::string>{});
+  for (const auto & name : names) {
+    robocap_runtime::PriorityTier tier;
+    tier.name = name;
+    tier.priority = static_cast<int>(node.declare_parameter<int>(name + ".priority", 0));
+    for (const auto core : node.declare_parameter<std::vector<std::int64_t>>(
+        name + ".cores", std::vector<std::int64_t>{}))
+    {
+      tier.cores.push_back(static_cast<int>(core));
+    }
+    tier.threads = static_cast<std::size_t>(node.declare_parameter<int>(name + ".threads", 1));
+    const auto index = executor.add_tier(tier);
+    for (const auto & node_name : node.declare_parameter<std::vector<std::string>>(
+        name + ".nodes", std::vector<std::string>{}))
+    {
+      executor.set_node_tier(node_name, index);
+    }
+    RCLCPP_INFO(
+      node.get_logger(), "Tier '%s': priority %d, %zu cores, %zu threads", name.c_str(),
+      tier.priority, tier.cores.size(), tier.threads);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  rclcpp::init(argc, argv);
+  auto executor = std::make_shared<robocap_runtime::PriorityExecutor>();
+  auto container = std::make_shared<rclcpp_components::ComponentManager>(executor);
+  try {
+    configure_tiers(*container, *executor);
+  } catch (const std::exception & e) {
+    RCLCPP_FATAL(container->get_logger(), "Invalid tiers: %s", e.what());
+    rclcpp::shutdown();
+    return 1;
+  }
+  // Page faults on first touch are the other source of multi-millisecond stalls
+  if (container->declare_parameter<bool>("lock_memory", false) &&
+    mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+  {
+    RCLCPP_WARN(
+      container->get_logger(), "Could not lock memory: %s", std::strerror(errno));
+  }
+
+  executor->add_node(container);
+  executor->spin();
+  rclcpp::shutdown();
+  return 0;
+}
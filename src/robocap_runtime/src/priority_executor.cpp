@@ -0,0 +1,255 @@
+#include "robocap_runtime/priority_executor.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include "rclcpp/logging.hpp"
+#include "rclcpp/scope_exit.hpp"
+#include "rclcpp/utilities.hpp"
+
+namespace robocap_runtime
+{
+
+namespace
+{
+
+const rclcpp::Logger kLogger = rclcpp::get_logger("PriorityExecutor");
+
+// Applies `tier` to the calling thread. Without CAP_SYS_NICE (or an rtprio limit) the thread keeps
+// running on the default scheduler, which is what happens in containers and CI.
+void configure_thread(const PriorityTier & tier)
+{
+  if (!tier.cores.empty()) {
+    cpu_set_t cores;
+    CPU_ZERO(&cores);
+    for (const int core : tier.cores) {
+      CPU_SET(core, &cores);
+    }
+    if (const int error = pthread_setaffinity_np(pthread_self(), sizeof(cores), &cores)) {
+      RCLCPP_WARN(
+        kLogger, "Could not pin tier '%s' to its cores: %s", tier.name.c_str(),
+        std::strerror(error));
+    }
+  }
+  if (tier.priority > 0) {
+    sched_param parameters{};
+    parameters.sched_priority = tier.priority;
+    if (const int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters)) {
+      RCLCPP_WARN(
+        kLogger, "Could not set SCHED_FIFO %d for tier '%s': %s", tier.priority,
+        tier.name.c_str(), std::strerror(error));
+    }
+  }
+}
+
+}  // namespace
+
+PriorityExecutor::PriorityExecutor(const rclcpp::ExecutorOptions & options)
+: rclcpp::Executor(options)
+{
+}
+
+PriorityExecutor::~PriorityExecutor()
+{
+  for (auto & tier : tiers_) {
+    sem_destroy(&tier->ready);
+  }
+}
+
+std::size_t PriorityExecutor::add_tier(const PriorityTier & tier)
+{
+  check_not_spinning();
+  if (tier.threads == 0) {
+    throw std::invalid_argument("tier '" + tier.name + "' needs at least one thread");
+  }
+  if (tier.priority < 0 || tier.priority > sched_get_priority_max(SCHED_FIFO)) {
+    throw std::invalid_argument("tier '" + tier.name + "' has an invalid SCHED_FIFO priority");
+  }
+  push_tier(tier);
+  return tiers_.size() - 1;
+}
+
+void PriorityExecutor::set_node_tier(const std::string & node_name, std::size_t tier)
+{
+  check_not_spinning();
+  if (tier >= tiers_.size()) {
+    throw std::out_of_range("no tier " + std::to_string(tier));
+  }
+  node_tiers_[node_name] = tier;
+}
+
+void PriorityExecutor::set_callback_group_tier(
+  const rclcpp::CallbackGroup::SharedPtr & group, std::size_t tier)
+{
+  check_not_spinning();
+  if (tier >= tiers_.size()) {
+    throw std::out_of_range("no tier " + std::to_string(tier));
+  }
+  group_overrides_.push_back({group, tier});
+}
+
+void PriorityExecutor::spin()
+{
+  if (spinning.exchange(true)) {
+    throw std::runtime_error("spin() called while already spinning");
+  }
+  RCLCPP_SCOPE_EXIT(this->spinning.store(false););
+  if (tiers_.empty()) {
+    push_tier(PriorityTier{"default"});
+  }
+
+  stopping_ = false;
+  for (std::size_t i = 0; i < tiers_.size(); ++i) {
+    for (std::size_t thread = 0; thread < configs_[i].threads; ++thread) {
+      tiers_[i]->threads.emplace_back([this, i]() {run_worker(i);});
+    }
+  }
+  configure_thread(configs_.front());
+
+  while (rclcpp::ok(context_) && spinning.load()) {
+    rclcpp::AnyExecutable executable;
+    if (!get_next_executable(executable)) {
+      continue;
+    }
+    Tier & tier = *tiers_[tier_of(executable)];
+    // Ahead of the push, so that the worker's decrement never comes first
+    tier.depth->add(1.0);
+    while (!tier.queue.push(std::move(executable))) {
+      queue_full_.fetch_add(1, std::memory_order_relaxed);
+      tier.full->add();
+      std::this_thread::yield();
+    }
+    // AnyExecutable has no move assignment, so the queue holds a copy. Dropping the group here
+    // keeps this one's destructor from releasing a mutually exclusive group before it ran.
+    executable.callback_group.reset();
+    sem_post(&tier.ready);
+  }
+
+  stopping_ = true;
+  for (auto & tier : tiers_) {
+    for (std::size_t thread = 0; thread < tier->threads.size(); ++thread) {
+      sem_post(&tier->ready);
+    }
+  }
+  for (auto & tier : tiers_) {
+    for (auto & thread : tier->threads) {
+      thread.join();
+    }
+    tier->threads.clear();
+  }
+  drain_tiers();
+}
+
+void PriorityExecutor::drain_tiers()
+{
+  // Workers stop without emptying their queues. A queued executable holds its mutually exclusive
+  // group, and a timer in it already had its tick consumed, so it runs here while the context
+  // lives, and otherwise only gives its group back, for the next spin() or another executor
+  const bool run = rclcpp::ok(context_);
+  for (auto & tier : tiers_) {
+    rclcpp::AnyExecutable executable;
+    while (tier->queue.pop(executable)) {
+      tier->depth->add(-1.0);
+      if (run) {
+        execute_any_executable(executable);
+      } else if (executable.callback_group) {
+        executable.callback_group->can_be_taken_from().store(true);
+      }
+      executable.callback_group.reset();
+      executable = rclcpp::AnyExecutable();
+    }
+    // A later spin() starts from a count of zero, not with posts for work that is gone
+    while (sem_trywait(&tier->ready) == 0 || errno == EINTR) {
+    }
+  }
+}
+
+void PriorityExecutor::push_tier(const PriorityTier & tier)
+{
+  configs_.push_back(tier);
+  auto & added = *tiers_.emplace_back(std::make_unique<Tier>());
+  sem_init(&added.ready, 0, 0);
+  // A second executor with the same tier names shares the series
+  const Labels labels{{"tier", tier.name}};
+  added.depth = &MetricsRegistry::global().gauge(
+    "robocap_executor_queue_depth", "Executables waiting in a tier's ready queue", labels);
+  added.full = &MetricsRegistry::global().counter(
+    "robocap_executor_queue_full_total", "Times a tier's ready queue was full", labels);
+}
+
+std::size_t PriorityExecutor::tier_of(const rclcpp::AnyExecutable & executable)
+{
+  const std::size_t fallback = tiers_.size() - 1;
+  const auto * group = executable.callback_group.get();
+  if (!group) {
+    return fallback;
+  }
+  // A group that died may have left its address to a new one, which is resolved again
+  const auto cached = group_tiers_.find(group);
+  if (cached != group_tiers_.end() && !cached->second.group.expired()) {
+    return cached->second.tier;
+  }
+
+  std::size_t tier = fallback;
+  bool overridden = false;
+  for (const auto & entry : group_overrides_) {
+    if (entry.group.lock() == executable.callback_group) {
+      tier = entry.tier;
+      overridden = true;
+      break;
+    }
+  }
+  if (!overridden && executable.node_base) {
+    auto node = node_tiers_.find(executable.node_base->get_fully_qualified_name());
+    if (node == node_tiers_.end()) {
+      node = node_tiers_.find(executable.node_base->get_name());
+    }
+    if (node != node_tiers_.end()) {
+      tier = node->second;
+    }
+  }
+  group_tiers_[group] = GroupTier{executable.callback_group, tier};
+  RCLCPP_DEBUG(
+    kLogger, "Callback group of '%s' runs in tier '%s'",
+    executable.node_base ? executable.node_base->get_fully_qualified_name() : "?",
+    configs_[tier].name.c_str());
+  return tier;
+}
+
+void PriorityExecutor::run_worker(std::size_t index)
+{
+  Tier & tier = *tiers_[index];
+  configure_thread(configs_[index]);
+  rclcpp::AnyExecutable executable;
+  while (true) {
+    if (sem_wait(&tier.ready) != 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    if (stopping_.load()) {
+      break;
+    }
+    if (tier.queue.pop(executable)) {
+      tier.depth->add(-1.0);
+      execute_any_executable(executable);
+      // Released by execute_any_executable() already, see MultiThreadedExecutor::run()
+      executable.callback_group.reset();
+      executable = rclcpp::AnyExecutable();
+    }
+  }
+}
+
+void PriorityExecutor::check_not_spinning() const
+{
+  if (spinning.load()) {
+    throw std::runtime_error("tiers can only be changed before spin()");
+  }
+}
+
+}  // namespace robocap_runtime
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "robocap_runtime/arena.hpp"
+
+namespace
+{
+
+using robocap_runtime::Arena;
+
+bool inside(const Arena & arena, const void * first, const void * pointer)
+{
+  const auto * byte = static_cast<const std::byte *>(pointer);
+  const auto * start = static_cast<const std::byte *>(first);
+  return byte >= start && byte < start + arena.capacity();
+}
+
+TEST(Arena, BumpsThroughTheBufferAndHonoursAlignment)
+{
+  Arena arena(256);
+  void * a = arena.allocate(1, 1);
+  void * b = arena.allocate(8, 8);
+  void * c = arena.allocate(16, 32);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(b) % 8, 0u);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(c) % 32, 0u);
+  EXPECT_LT(a, b);
+  EXPECT_LT(b, c);
+  EXPECT_EQ(arena.used(), static_cast<std::size_t>(
+      static_cast<std::byte *>(c) - static_cast<std::byte *>(a)) + 16);
+  EXPECT_EQ(arena.stats().overflows, 0u);
+}
+
+TEST(Arena, ResetHandsTheBufferOutAgain)
+{
+  Arena arena(128);
+  void * first = arena.allocate(64, 8);
+  [[maybe_unused]] void * second = arena.allocate(32, 8);
+  arena.deallocate(first, 64, 8);  // Does nothing, the space stays taken
+  EXPECT_EQ(arena.used(), 96u);
+
+  arena.reset();
+  EXPECT_EQ(arena.used(), 0u);
+  EXPECT_EQ(arena.allocate(64, 8), first);
+  EXPECT_EQ(arena.stats().cycles, 1u);
+  EXPECT_EQ(arena.stats().high_water, 96u);
+  EXPECT_EQ(arena.stats().regrows, 0u);
+}
+
+TEST(Arena, OverflowGoesUpstreamAndResetRegrows)
+{
+  Arena arena(64);
+  void * first = arena.allocate(48, 8);
+  void * overflow = arena.allocate(48, 16);
+  EXPECT_FALSE(inside(arena, first, overflow));
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(overflow) % 16, 0u);
+  EXPECT_EQ(arena.stats().overflows, 1u);
+
+  // What the cycle asked for fits after the reset, without going upstream
+  arena.reset();
+  EXPECT_GE(arena.capacity(), 96u);
+  EXPECT_EQ(arena.stats().regrows, 1u);
+  first = arena.allocate(48, 8);
+  void * second = arena.allocate(48, 16);
+  EXPECT_TRUE(inside(arena, first, second));
+  EXPECT_EQ(arena.stats().overflows, 1u);
+
+  // A cycle within the buffer leaves it as it is
+  arena.reset();
+  EXPECT_EQ(arena.stats().regrows, 1u);
+  EXPECT_EQ(arena.stats().cycles, 2u);
+}
+
+TEST(Arena, BacksPmrContainersThatSettle)
+{
+  Arena arena(64);
+  for (int cycle = 0; cycle < 4; ++cycle) {
+    arena.reset();
+    std::pmr::vector<double> plan(&arena);
+    plan.reserve(32);
+    for (int i = 0; i < 32; ++i) {
+      plan.push_back(i);
+    }
+    EXPECT_EQ(plan.back(), 31.0);
+  }
+  // Only the first cycle outgrew the buffer
+  EXPECT_EQ(arena.stats().overflows, 1u);
+  EXPECT_EQ(arena.stats().regrows, 1u);
+}
+
+}  // namespace
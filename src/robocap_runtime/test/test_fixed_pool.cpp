@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "robocap_runtime/fixed_pool.hpp"
+
+namespace
+{
+
+using robocap_runtime::FixedPool;
+using robocap_runtime::FreeList;
+
+TEST(FreeList, PopsEveryIndexOnceThenEmpty)
+{
+  FreeList list(8);
+  std::set<std::uint32_t> popped;
+  for (int i = 0; i < 8; ++i) {
+    const auto index = list.pop();
+    ASSERT_NE(index, FreeList::kEmpty);
+    EXPECT_LT(index, 8u);
+    EXPECT_TRUE(popped.insert(index).second);
+  }
+  EXPECT_EQ(list.pop(), FreeList::kEmpty);
+
+  list.push(5);
+  EXPECT_EQ(list.pop(), 5u);
+  EXPECT_EQ(list.pop(), FreeList::kEmpty);
+}
+
+TEST(FreeList, EmptyListHasNothingToPop)
+{
+  FreeList list(0);
+  EXPECT_EQ(list.pop(), FreeList::kEmpty);
+}
+
+// Threads pop and push back as fast as they can while each checks that no index it holds is held
+// by anyone else: a lost tag would hand one index to two threads, or drop it
+TEST(FreeList, ConcurrentPopPushNeverSharesAnIndex)
+{
+  constexpr std::size_t kSize = 16;
+  constexpr int kThreads = 4;
+  constexpr int kRounds = 20000;
+  FreeList list(kSize);
+  std::vector<std::atomic<int>> holders(kSize);
+  std::atomic<bool> shared{false};
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&] {
+        std::vector<std::uint32_t> held;
+        for (int round = 0; round < kRounds; ++round) {
+          // Hold up to three at once, so that pops also race pushes of other indices
+          while (held.size() < 3) {
+            const auto index = list.pop();
+            if (index == FreeList::kEmpty) {
+              break;
+            }
+            if (holders[index].fetch_add(1) != 0) {
+              shared = true;
+            }
+            held.push_back(index);
+          }
+          if (!held.empty()) {
+            const auto index = held.back();
+            held.pop_back();
+            holders[index].fetch_sub(1);
+            list.push(index);
+          }
+          std::this_thread::yield();
+        }
+        for (const auto index : held) {
+          holders[index].fetch_sub(1);
+          list.push(index);
+        }
+      });
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  EXPECT_FALSE(shared);
+
+  // Every index made it back, exactly once
+  std::set<std::uint32_t> popped;
+  for (std::size_t i = 0; i < kSize; ++i) {
+    const auto index = list.pop();
+    ASSERT_NE(index, FreeList::kEmpty);
+    EXPECT_TRUE(popped.insert(index).second);
+  }
+  EXPECT_EQ(list.pop(), FreeList::kEmpty);
+}
+
+TEST(FixedPool, BlocksAreAlignedAndDistinct)
+{
+  FixedPool pool(24, 4);
+  EXPECT_EQ(pool.block_size(), FixedPool::kAlignment);
+  std::vector<void *> blocks;
+  for (int i = 0; i < 4; ++i) {
+    void * block = pool.allocate(24, 8);
+    EXPECT_TRUE(pool.owns(block));
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(block) % FixedPool::kAlignment, 0u);
+    blocks.push_back(block);
+  }
+  std::sort(blocks.begin(), blocks.end());
+  EXPECT_EQ(std::adjacent_find(blocks.begin(), blocks.end()), blocks.end());
+  for (void * block : blocks) {
+    pool.deallocate(block, 24, 8);
+  }
+}
+
+TEST(FixedPool, ExhaustedPoolOverflowsUpstreamAndReusesReleasedBlocks)
+{
+  FixedPool pool(64, 2);
+  void * a = pool.allocate(64, 8);
+  void * b = pool.allocate(64, 8);
+  void * overflow = pool.allocate(64, 8);
+  EXPECT_TRUE(pool.owns(a));
+  EXPECT_TRUE(pool.owns(b));
+  EXPECT_FALSE(pool.owns(overflow));
+
+  auto stats = pool.stats();
+  EXPECT_EQ(stats.allocations, 2u);
+  EXPECT_EQ(stats.overflows, 1u);
+  EXPECT_EQ(stats.in_use, 2u);
+  EXPECT_EQ(stats.high_water, 2u);
+
+  pool.deallocate(overflow, 64, 8);
+  pool.deallocate(a, 64, 8);
+  EXPECT_EQ(pool.stats().in_use, 1u);
+  // The block released last is the one handed out next
+  EXPECT_EQ(pool.allocate(64, 8), a);
+  pool.deallocate(a, 64, 8);
+  pool.deallocate(b, 64, 8);
+
+  stats = pool.stats();
+  EXPECT_EQ(stats.allocations, 3u);
+  EXPECT_EQ(stats.overflows, 1u);
+  EXPECT_EQ(stats.in_use, 0u);
+  EXPECT_EQ(stats.high_water, 2u);
+}
+
+TEST(FixedPool, OversizedAndOveralignedRequestsOverflow)
+{
+  FixedPool pool(64, 4);
+  void * large = pool.allocate(65, 8);
+  void * aligned = pool.allocate(16, 2 * FixedPool::kAlignment);
+  EXPECT_FALSE(pool.owns(large));
+  EXPECT_FALSE(pool.owns(aligned));
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(aligned) % (2 * FixedPool::kAlignment), 0u);
+  EXPECT_EQ(pool.stats().overflows, 2u);
+  EXPECT_EQ(pool.stats().allocations, 0u);
+  pool.deallocate(large, 65, 8);
+  pool.deallocate(aligned, 16, 2 * FixedPool::kAlignment);
+}
+
+TEST(FixedPool, ConcurrentAllocationsStayInThePool)
+{
+  constexpr std::size_t kBlocks = 8;
+  constexpr int kThreads = 4;
+  FixedPool pool(sizeof(std::uint64_t), kBlocks);
+  std::atomic<bool> corrupted{false};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+        for (int round = 0; round < 10000; ++round) {
+          auto * value = static_cast<std::uint64_t *>(pool.allocate(sizeof(std::uint64_t)));
+          // A block handed to two threads shows up as the other thread's stamp
+          const auto stamp =
+            static_cast<std::uint64_t>(t) << 32 | static_cast<std::uint32_t>(round);
+          *value = stamp;
+          std::this_thread::yield();
+          if (pool.owns(value) && *value != stamp) {
+            corrupted = true;
+          }
+          pool.deallocate(value, sizeof(std::uint64_t));
+        }
+      });
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  EXPECT_FALSE(corrupted);
+  EXPECT_EQ(pool.stats().in_use, 0u);
+  EXPECT_EQ(pool.stats().overflows, 0u);
+}
+
+TEST(FixedPoolAllocator, SharedPtrControlBlockComesFromThePool)
+{
+  auto pool = std::make_shared<FixedPool>(128, 2);
+  {
+    auto value = std::allocate_shared<int>(robocap_runtime::FixedPoolAllocator<int>(pool), 42);
+    EXPECT_EQ(*value, 42);
+    EXPECT_TRUE(pool->owns(value.get()));
+    EXPECT_EQ(pool->stats().in_use, 1u);
+  }
+  EXPECT_EQ(pool->stats().in_use, 0u);
+}
+
+}  // namespace
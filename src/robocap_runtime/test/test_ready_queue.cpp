@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "robocap_runtime/ready_queue.hpp"
+
+namespace
+{
+
+using robocap_runtime::ReadyQueue;
+
+TEST(ReadyQueue, PopsInPushOrderUntilEmpty)
+{
+  ReadyQueue<int, 4> queue;
+  int value = 0;
+  EXPECT_FALSE(queue.pop(value));
+  EXPECT_TRUE(queue.push(1));
+  EXPECT_TRUE(queue.push(2));
+  EXPECT_TRUE(queue.pop(value));
+  EXPECT_EQ(value, 1);
+  EXPECT_TRUE(queue.pop(value));
+  EXPECT_EQ(value, 2);
+  EXPECT_FALSE(queue.pop(value));
+}
+
+TEST(ReadyQueue, FullQueueRejectsAndLeavesTheValue)
+{
+  ReadyQueue<std::shared_ptr<int>, 2> queue;
+  EXPECT_TRUE(queue.push(std::make_shared<int>(1)));
+  EXPECT_TRUE(queue.push(std::make_shared<int>(2)));
+  auto rejected = std::make_shared<int>(3);
+  EXPECT_FALSE(queue.push(std::move(rejected)));
+  ASSERT_NE(rejected, nullptr);
+  EXPECT_EQ(*rejected, 3);
+
+  std::shared_ptr<int> value;
+  EXPECT_TRUE(queue.pop(value));
+  EXPECT_EQ(*value, 1);
+  EXPECT_TRUE(queue.push(std::move(rejected)));
+  EXPECT_TRUE(queue.pop(value));
+  EXPECT_EQ(*value, 2);
+  EXPECT_TRUE(queue.pop(value));
+  EXPECT_EQ(*value, 3);
+  EXPECT_FALSE(queue.pop(value));
+}
+
+TEST(ReadyQueue, WrapsAroundManyTimes)
+{
+  ReadyQueue<std::uint64_t, 4> queue;
+  std::uint64_t value = 0;
+  for (std::uint64_t i = 0; i < 1000; ++i) {
+    ASSERT_TRUE(queue.push(std::uint64_t{i}));
+    ASSERT_TRUE(queue.push(i + 1000));
+    ASSERT_TRUE(queue.pop(value));
+    EXPECT_EQ(value, i);
+    ASSERT_TRUE(queue.pop(value));
+    EXPECT_EQ(value, i + 1000);
+  }
+}
+
+TEST(ReadyQueue, PopLeavesTheSlotEmpty)
+{
+  ReadyQueue<std::shared_ptr<int>, 4> queue;
+  auto shared = std::make_shared<int>(7);
+  EXPECT_TRUE(queue.push(std::shared_ptr<int>(shared)));
+  EXPECT_EQ(shared.use_count(), 2);
+  {
+    std::shared_ptr<int> value;
+    EXPECT_TRUE(queue.pop(value));
+    EXPECT_EQ(shared.use_count(), 2);  // `value` and `shared`, nothing in the queue
+  }
+  EXPECT_EQ(shared.use_count(), 1);
+}
+
+// Producers push disjoint ranges, consumers count what they pop: every value arrives exactly once
+TEST(ReadyQueue, ConcurrentProducersAndConsumersLoseAndDuplicateNothing)
+{
+  constexpr int kProducers = 3;
+  constexpr int kConsumers = 3;
+  constexpr std::uint64_t kPerProducer = 20000;
+  constexpr std::uint64_t kTotal = kProducers * kPerProducer;
+  ReadyQueue<std::shared_ptr<std::uint64_t>, 16> queue;
+  std::vector<std::atomic<int>> seen(kTotal);
+  std::atomic<std::uint64_t> popped{0};
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < kProducers; ++p) {
+    threads.emplace_back([&, p] {
+        for (std::uint64_t i = 0; i < kPerProducer; ) {
+          auto value = std::make_shared<std::uint64_t>(p * kPerProducer + i);
+          if (queue.push(std::move(value))) {
+            ++i;
+          } else {
+            std::this_thread::yield();
+          }
+        }
+      });
+  }
+  for (int c = 0; c < kConsumers; ++c) {
+    threads.emplace_back([&] {
+        std::shared_ptr<std::uint64_t> value;
+        while (popped.load() < kTotal) {
+          if (queue.pop(value)) {
+            seen[*value].fetch_add(1);
+            popped.fetch_add(1);
+            value.reset();
+          } else {
+            std::this_thread::yield();
+          }
+        }
+      });
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(popped.load(), kTotal);
+  int wrong = 0;
+  for (const auto & count : seen) {
+    wrong += count.load() != 1;
+  }
+  EXPECT_EQ(wrong, 0);
+  std::shared_ptr<std::uint64_t> value;
+  EXPECT_FALSE(queue.pop(value));
+}
+
+}  // namespace
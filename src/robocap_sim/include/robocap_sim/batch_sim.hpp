@@ -0,0 +1,107 @@
+#ifndef ROBOCAP_SIM__BATCH_SIM_HPP_
+#define ROBOCAP_SIM__BATCH_SIM_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "robocap_kinematics/kiwi_drive.hpp"
+#include "robocap_perception/thread_pool.hpp"
+
+namespace robocap_sim
+{
+
+// Defaults are the ones the Gazebo model runs with: worlds/robocap.sdf's step size and the
+// OmniWheelContact parameters from urdf/omni_wheels.xacro
+struct BatchSimConfig
+{
+  double step_size = 0.001;          // [s] per substep
+  double mu = 1.0;                   // rolling-direction friction coefficient
+  double roller_drag = 0.5;          // [N s/m] along the axle
+  double gravity = 9.81;             // [m/s^2]
+  double motor_time_constant = 0.0;  // [s] wheel speed lag, 0 tracks commands exactly
+  std::size_t threads = 0;           // counting the caller, 0 for one per hardware thread
+};
+
+// Planar pose and world-frame velocity of one robot
+struct PlanarState
+{
+  double x = 0.0;    // [m]
+  double y = 0.0;    // [m]
+  double yaw = 0.0;  // [rad]
+  double vx = 0.0;   // [m/s] world frame
+  double vy = 0.0;   // [m/s]
+  double wz = 0.0;   // [rad/s]
+};
+
+// Thousands of independent robocap kiwi drives stepped together, for RL training where one robot
+// per Gazebo server is orders of magnitude too slow. Each robot is a rigid body on flat ground with
+// the model's mass and yaw inertia from robocap_kinematics/robocap_model.hpp and OmniWheelContact's
+// contact law at each wheel: slip-proportional traction along the rolling direction capped at
+// mu * N, viscous roller drag along the axle. The wheels are velocity controlled like
+// JointVelocityCmd, optionally through a first order lag.
+//
+// State is structure-of-arrays in float, padded to whole SIMD packs, and step() splits the packs
+// over a ThreadPool. Nothing allocates after construction. Compare against the full model with
+// robocap_batch_sim_validate.
+class BatchSim
+{
+public:
+  explicit BatchSim(std::size_t size, const BatchSimConfig & config = BatchSimConfig{});
+
+  std::size_t size() const {return size_;}
+  const BatchSimConfig & config() const {return config_;}
+
+  // Joint velocity commands [rad/s] of wheel_1..wheel_3, [size()] each. Held until changed
+  float * wheel_command(std::size_t wheel) {return wheel_command_[wheel].data();}
+
+  // Places robot `index` at `state`, with its wheels at rest and zero commands
+  void reset(std::size_t index, const PlanarState & state = PlanarState{});
+
+  // Advances every robot by `substeps` steps of config().step_size
+  void step(std::uint32_t substeps = 1);
+
+  PlanarState state(std::size_t index) const;
+
+  // Read-only views, [size()] each. Velocities are in the world frame
+  const float * x() const {return x_.data();}
+  const float * y() const {return y_.data();}
+  const float * cos_yaw() const {return cos_yaw_.data();}
+  const float * sin_yaw() const {return sin_yaw_.data();}
+  const float * vx() const {return vx_.data();}
+  const float * vy() const {return vy_.data();}
+  const float * wz() const {return wz_.data();}
+  const float * wheel_position(std::size_t wheel) const {return wheel_position_[wheel].data();}
+  const float * wheel_velocity(std::size_t wheel) const {return wheel_velocity_[wheel].data();}
+
+private:
+  using Lanes = std::vector<float>;
+  using WheelLanes = std::array<Lanes, robocap_kinematics::kNumWheels>;
+
+  void step_packs(std::size_t begin, std::size_t end, std::uint32_t substeps);
+
+  std::size_t size_;
+  std::size_t padded_;
+  BatchSimConfig config_;
+  robocap_perception::ThreadPool pool_;
+
+  double mass_;
+  double yaw_inertia_;
+
+  Lanes x_;
+  Lanes y_;
+  // Heading as a unit vector, so a step only needs multiplies
+  Lanes cos_yaw_;
+  Lanes sin_yaw_;
+  Lanes vx_;
+  Lanes vy_;
+  Lanes wz_;
+  WheelLanes wheel_position_;
+  WheelLanes wheel_velocity_;
+  WheelLanes wheel_command_;
+};
+
+}  // namespace robocap_sim
+
+#endif  // ROBOCAP_SIM__BATCH_SIM_HPP_
@@ -0,0 +1,58 @@
+#ifndef ROBOCAP_SIM__ENTITY_SPAWNER_HPP_
+#define ROBOCAP_SIM__ENTITY_SPAWNER_HPP_
+
+#include <chrono>
+#include <functional>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "ignition/math/Pose3.hh"
+#include "ignition/transport/Node.hh"
+
+namespace robocap_sim
+{
+
+struct EntitySpec
+{
+  std::string name;  // Empty keeps the model's own, taken names get a suffix
+  std::string uri;   // model://<name>, or a model directory or SDF file on the server's machine
+  ignition::math::Pose3d pose;
+};
+
+// One entity per line, "<name> <uri> <x> <y> <z> [<roll> <pitch> <yaw>]", blank lines and
+// everything after a '#' ignored. Throws std::invalid_argument naming the offending line.
+std::vector<EntitySpec> parse_entities(std::istream & in);
+EntitySpec parse_entity(const std::string & line);
+
+// Spawns any number of models into a running world with one request to its UserCommands
+// world/<name>/create_multiple service, instead of one `ros_gz_sim create` process, ROS node and
+// service call per model. Nothing polls for the world: a request made before the service was
+// discovered is held by gz-transport and sent once discovery finds it.
+//
+// An accepted batch is created at the start of the world's next update, paused or not.
+class EntitySpawner
+{
+public:
+  using Callback = std::function<void (bool accepted)>;
+
+  explicit EntitySpawner(const std::string & world = "default");
+
+  const std::string & service() const {return service_;}
+
+  // Returns right after queueing the request. `done` runs on a gz-transport thread once the world
+  // replied, which is never if it never comes up. Pending requests die with the spawner.
+  bool spawn_async(const std::vector<EntitySpec> & entities, Callback done);
+
+  // Blocks until the world accepted the batch, false if it refused it or `timeout` ran out first,
+  // counting the time it takes the world to come up
+  bool spawn(const std::vector<EntitySpec> & entities, std::chrono::milliseconds timeout);
+
+private:
+  std::string service_;
+  ignition::transport::Node node_;
+};
+
+}  // namespace robocap_sim
+
+#endif  // ROBOCAP_SIM__ENTITY_SPAWNER_HPP_
@@ -0,0 +1,55 @@
+#ifndef ROBOCAP_SIM__LOCKSTEP_CLIENT_HPP_
+#define ROBOCAP_SIM__LOCKSTEP_CLIENT_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace robocap_sim
+{
+
+// Samples of one step() call, structure-of-arrays. The vectors are reused between calls and only
+// grow, so a client stepping with a fixed batch size stops allocating after the first call.
+struct LockstepSamples
+{
+  std::size_t size = 0;
+  std::uint64_t iterations = 0;
+  std::vector<std::int64_t> sim_time_ns;   // [size]
+  std::vector<double> base_pose;           // [size][7], x y z qw qx qy qz
+  std::vector<double> joint_position;      // [size][joint_count]
+  std::vector<double> joint_velocity;      // [size][joint_count]
+};
+
+// Drives a robocap_lockstep_server. The world only advances inside step(), so the client fully
+// controls the pace and the simulation runs as fast as physics allows.
+class LockstepClient
+{
+public:
+  LockstepClient() = default;
+  ~LockstepClient();
+
+  LockstepClient(const LockstepClient &) = delete;
+  LockstepClient & operator=(const LockstepClient &) = delete;
+
+  bool connect(const std::string & socket_path);
+  void disconnect();
+
+  const std::vector<std::string> & joint_names() const {return joint_names_;}
+  std::int64_t step_size_ns() const {return step_size_ns_;}
+
+  // Runs `steps` physics iterations in one round trip. `velocity_commands` is either empty (keep
+  // the previous commands) or one joint velocity per joint_names() entry.
+  bool step(
+    std::uint32_t steps, std::uint32_t record_every, const std::vector<double> & velocity_commands,
+    LockstepSamples & samples);
+
+private:
+  int fd_ = -1;
+  std::vector<std::string> joint_names_;
+  std::int64_t step_size_ns_ = 0;
+};
+
+}  // namespace robocap_sim
+
+#endif  // ROBOCAP_SIM__LOCKSTEP_CLIENT_HPP_
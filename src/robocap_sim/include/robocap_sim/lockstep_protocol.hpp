@@ -0,0 +1,53 @@
+#ifndef ROBOCAP_SIM__LOCKSTEP_PROTOCOL_HPP_
+#define ROBOCAP_SIM__LOCKSTEP_PROTOCOL_HPP_
+
+#include <cstdint>
+
+// Wire format between robocap_lockstep_server and LockstepClient over a Unix stream socket. Both
+// ends run on the same host, so the structs are sent as raw native-endian bytes.
+//
+//   server -> client on connect:  Handshake, then joint_count names of kJointNameSize bytes each
+//   client -> server:             StepRequest, then command_count doubles (joint velocities)
+//   server -> client:             StepReply, then sample_count blocks laid out as
+//                                   int64  sim_time_ns[sample_count]
+//                                   double base_pose[sample_count][7]   x y z qw qx qy qz
+//                                   double joint_position[sample_count][joint_count]
+//                                   double joint_velocity[sample_count][joint_count]
+
+namespace robocap_sim
+{
+namespace lockstep
+{
+
+constexpr std::uint32_t kMagic = 0x52424c53;  // "RBLS"
+constexpr std::uint32_t kJointNameSize = 64;
+constexpr std::uint32_t kPoseSize = 7;
+
+struct Handshake
+{
+  std::uint32_t magic;
+  std::uint32_t joint_count;
+  std::int64_t step_size_ns;
+};
+
+struct StepRequest
+{
+  std::uint32_t magic;
+  std::uint32_t steps;          // Physics iterations to run before replying
+  std::uint32_t record_every;   // Record one sample every N iterations, 0 for the last one only
+  std::uint32_t command_count;  // 0 keeps the previous commands, otherwise joint_count
+};
+
+struct StepReply
+{
+  std::uint32_t magic;
+  std::uint32_t sample_count;
+  std::uint32_t joint_count;
+  std::uint32_t reserved;
+  std::uint64_t iterations;  // Total iterations since the server started
+};
+
+}  // namespace lockstep
+}  // namespace robocap_sim
+
+#endif  // ROBOCAP_SIM__LOCKSTEP_PROTOCOL_HPP_
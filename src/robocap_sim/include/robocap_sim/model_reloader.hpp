@@ -0,0 +1,105 @@
+#ifndef ROBOCAP_SIM__MODEL_RELOADER_HPP_
+#define ROBOCAP_SIM__MODEL_RELOADER_HPP_
+
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "ignition/common/Event.hh"
+#include "ignition/gazebo/Entity.hh"
+#include "ignition/gazebo/EntityComponentManager.hh"
+#include "ignition/gazebo/EventManager.hh"
+#include "ignition/gazebo/System.hh"
+#include "ignition/msgs/stringmsg.pb.h"
+#include "ignition/transport/Node.hh"
+#include "sdf/Model.hh"
+#include "sdf/Root.hh"
+
+namespace robocap_sim
+{
+
+// Emitted on the simulation thread after ModelReloader patched `model`, with the SDF it was
+// patched from. Systems attached to the model connect to it to pick up their own <plugin>
+// parameters and whatever they derived from the patched components.
+using ModelReloaded = ignition::common::EventT<
+  void (const ignition::gazebo::EntityComponentManager & ecm, ignition::gazebo::Entity model,
+  const sdf::Model & sdf), struct ModelReloadedTag>;
+
+// The service ModelReloader advertises for `world`, /world/<world>/reload_model
+std::string reload_service(const std::string & world);
+
+// What patch_model() found different, per kind of element
+struct ModelPatch
+{
+  // Patched in the ECM, where running systems read them
+  std::size_t inertials = 0;   // Link mass, centre of mass and inertia
+  // Left alone, only a new spawn applies them: Physics owns link poses and writes them every
+  // step, and reads joint placement and collisions only when it creates the model
+  std::size_t poses = 0;       // Link and joint poses, i.e. the URDF joint origins
+  std::size_t collisions = 0;  // Collision geometry and surface: friction, kp, kd
+
+  std::size_t respawn() const {return poses + collisions;}
+};
+
+// Patches the link inertials of `model` that differ from `sdf`, matched by name, and marks them
+// changed. Link and joint poses and collisions are compared with the SDF the model was spawned
+// from and only counted. Elements only one side has are left alone.
+ModelPatch patch_model(
+  ignition::gazebo::EntityComponentManager & ecm, ignition::gazebo::Entity model,
+  const sdf::Model & sdf);
+
+// One line for a reply or the log, e.g. "Patched [robot]: 1 inertials; needs a respawn: 2 poses"
+std::string describe(const std::string & model, const ModelPatch & patch);
+
+// World system that hot-patches a model in the running world from a new SDF of it, so tuning the
+// xacro does not need gz sim and the stack relaunched. robocap_xacro_watch sends the baked SDF on
+// every effective xacro change; anything else can too:
+//
+//   ign service -s /world/default/reload_model --reqtype ignition.msgs.StringMsg
+//     --reptype ignition.msgs.StringMsg --timeout 5000 --req 'data: "<sdf>...</sdf>"'
+//
+// The SDF is parsed on the service thread and applied at the start of the next update, paused or
+// not, and the reply says what was patched and what needs a respawn (or, if no update ran within
+// kReplyTimeout, only that it parsed). Inertials land in the ECM, where systems such as
+// OmniWheelContact (the mass it loads the wheels with) see them right away, and every
+// ModelReloaded listener gets the new SDF for its <plugin> parameters (OmniWheelContact's
+// traction mu). The physics engine takes link inertia, collision surfaces and joint placement
+// when it creates the model, so changes to those reach the solver only with the next spawn.
+class ModelReloader
+  : public ignition::gazebo::System,
+  public ignition::gazebo::ISystemConfigure,
+  public ignition::gazebo::ISystemPreUpdate
+{
+public:
+  void Configure(
+    const ignition::gazebo::Entity & entity, const std::shared_ptr<const sdf::Element> & sdf,
+    ignition::gazebo::EntityComponentManager & ecm,
+    ignition::gazebo::EventManager & event_manager) override;
+
+  void PreUpdate(
+    const ignition::gazebo::UpdateInfo & info,
+    ignition::gazebo::EntityComponentManager & ecm) override;
+
+private:
+  // A parsed request and the reply PreUpdate() sends back for it
+  struct Pending
+  {
+    std::unique_ptr<sdf::Root> root;
+    std::promise<std::string> result;
+  };
+
+  bool on_reload(const ignition::msgs::StringMsg & request, ignition::msgs::StringMsg & reply);
+
+  ignition::gazebo::Entity world_ = ignition::gazebo::kNullEntity;
+  ignition::gazebo::EventManager * event_manager_ = nullptr;
+  ignition::transport::Node node_;
+
+  std::mutex mutex_;
+  std::unique_ptr<Pending> pending_;  // Latest parsed request, older ones are superseded
+};
+
+}  // namespace robocap_sim
+
+#endif  // ROBOCAP_SIM__MODEL_RELOADER_HPP_
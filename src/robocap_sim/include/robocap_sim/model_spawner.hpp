@@ -0,0 +1,45 @@
+#ifndef ROBOCAP_SIM__MODEL_SPAWNER_HPP_
+#define ROBOCAP_SIM__MODEL_SPAWNER_HPP_
+
+#include <memory>
+#include <string>
+
+#include "ignition/gazebo/System.hh"
+#include "ignition/math/Pose3.hh"
+
+namespace robocap_sim
+{
+
+// Resolves model://<name> against IGN_GAZEBO_RESOURCE_PATH to the model's SDF file. Plain paths
+// to a model directory or SDF file are accepted as well. Returns an empty string if not found.
+std::string resolve_model_file(const std::string & uri);
+
+// World system that creates models straight in the ECM while the world loads, replacing the
+// `ros_gz_sim create` processes and their round trip through the world/<name>/create service.
+//
+// SDF parameters, any number of:
+//   <model>
+//     <uri>model://robocap</uri>
+//     <name>robot</name>
+//     <pose>0 0 0.1 0 0 0</pose>
+//   </model>
+class ModelSpawner
+  : public ignition::gazebo::System,
+  public ignition::gazebo::ISystemConfigure
+{
+public:
+  void Configure(
+    const ignition::gazebo::Entity & entity, const std::shared_ptr<const sdf::Element> & sdf,
+    ignition::gazebo::EntityComponentManager & ecm,
+    ignition::gazebo::EventManager & event_manager) override;
+};
+
+// Loads the model SDF at `file` and creates it under `world`. Returns kNullEntity on failure.
+ignition::gazebo::Entity spawn_model(
+  ignition::gazebo::EntityComponentManager & ecm, ignition::gazebo::EventManager & event_manager,
+  ignition::gazebo::Entity world, const std::string & file, const std::string & name,
+  const ignition::math::Pose3d & pose);
+
+}  // namespace robocap_sim
+
+#endif  // ROBOCAP_SIM__MODEL_SPAWNER_HPP_
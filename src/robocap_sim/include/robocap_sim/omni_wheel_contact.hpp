@@ -0,0 +1,77 @@
+#ifndef ROBOCAP_SIM__OMNI_WHEEL_CONTACT_HPP_
+#define ROBOCAP_SIM__OMNI_WHEEL_CONTACT_HPP_
+
+#include <memory>
+#include <vector>
+
+#include "ignition/common/Event.hh"
+#include "ignition/gazebo/Entity.hh"
+#include "ignition/gazebo/System.hh"
+#include "ignition/math/Vector3.hh"
+#include "sdf/Model.hh"
+
+namespace robocap_sim
+{
+
+// Analytic omni-wheel traction for the kiwi drive. The wheel collisions are frictionless, so the
+// physics engine only supports the robot vertically, and this system applies the ground force at
+// each wheel's contact point itself:
+//
+//   rolling direction  regularized Coulomb friction on the contact point's slip velocity, with a
+//                      gain that removes at most half the slip per step so it stays stable at any
+//                      step size, capped at mu * N
+//   along the axle     light viscous drag only, because the rollers spin freely
+//
+// This replaces the mu1/mu2/fdir1 anisotropic friction hack, which needed 0.5 ms steps to
+// stay stable.
+//
+// The parameters and the model mass are read again whenever ModelReloader patches the model, so
+// traction can be tuned in the xacro while the world runs. The wheels are not.
+//
+// SDF parameters:
+//   <wheel>          wheel link, repeated (wheel_1..wheel_3)
+//   <radius>         wheel radius [m], defaults to 0.05
+//   <axis>           wheel axle in the wheel link frame, defaults to 0 0 1
+//   <mu>             rolling-direction friction coefficient, defaults to 1.0
+//   <roller_drag>    axle-direction drag [N s/m], defaults to 0.5
+class OmniWheelContact
+  : public ignition::gazebo::System,
+  public ignition::gazebo::ISystemConfigure,
+  public ignition::gazebo::ISystemPreUpdate
+{
+public:
+  void Configure(
+    const ignition::gazebo::Entity & entity, const std::shared_ptr<const sdf::Element> & sdf,
+    ignition::gazebo::EntityComponentManager & ecm,
+    ignition::gazebo::EventManager & event_manager) override;
+
+  void PreUpdate(
+    const ignition::gazebo::UpdateInfo & info,
+    ignition::gazebo::EntityComponentManager & ecm) override;
+
+private:
+  struct Wheel
+  {
+    ignition::gazebo::Entity link;
+    std::vector<ignition::gazebo::Entity> collisions;
+  };
+
+  void read_parameters(const sdf::Element & sdf);
+  void update_mass(const ignition::gazebo::EntityComponentManager & ecm);
+  void on_reloaded(const ignition::gazebo::EntityComponentManager & ecm, const sdf::Model & sdf);
+
+  bool in_contact(const Wheel & wheel, const ignition::gazebo::EntityComponentManager & ecm) const;
+
+  std::vector<Wheel> wheels_;
+  double radius_ = 0.05;
+  ignition::math::Vector3d axis_{0.0, 0.0, 1.0};
+  double mu_ = 1.0;
+  double roller_drag_ = 0.5;
+  double mass_ = 0.0;  // Whole model, for the normal load and the slip gain
+  ignition::gazebo::Entity model_ = ignition::gazebo::kNullEntity;
+  ignition::common::ConnectionPtr reloaded_connection_;
+};
+
+}  // namespace robocap_sim
+
+#endif  // ROBOCAP_SIM__OMNI_WHEEL_CONTACT_HPP_
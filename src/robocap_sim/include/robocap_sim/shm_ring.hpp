@@ -0,0 +1,95 @@
+#ifndef ROBOCAP_SIM__SHM_RING_HPP_
+#define ROBOCAP_SIM__SHM_RING_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace robocap_sim
+{
+
+// Bounded multi-producer/multi-consumer ring (Vyukov's sequence-per-slot queue) that lives in a
+// shared memory mapping. It holds no pointers and only address-free lock-free atomics, so several
+// processes can map the same bytes and push/pop concurrently without locks.
+//
+// Construct it once with placement new in zero-filled memory, then every process uses the mapping.
+template<typename T, std::size_t Capacity>
+class ShmRing
+{
+  static_assert(std::is_trivially_copyable<T>::value, "T is copied between processes");
+  static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+  static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "needs address-free atomics");
+
+public:
+  ShmRing()
+  {
+    for (std::size_t i = 0; i < Capacity; ++i) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_release);
+  }
+
+  // Returns false if the ring is full
+  bool push(const T & value)
+  {
+    std::uint64_t position = tail_.load(std::memory_order_relaxed);
+    while (true) {
+      Slot & slot = slots_[position & kMask];
+      const std::uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::int64_t>(sequence - position);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          slot.value = value;
+          slot.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        position = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Returns false if the ring is empty
+  bool pop(T & value)
+  {
+    std::uint64_t position = head_.load(std::memory_order_relaxed);
+    while (true) {
+      Slot & slot = slots_[position & kMask];
+      const std::uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::int64_t>(sequence - (position + 1));
+      if (diff == 0) {
+        if (head_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          value = slot.value;
+          slot.sequence.store(position + Capacity, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        position = head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+private:
+  static constexpr std::uint64_t kMask = Capacity - 1;
+
+  struct alignas(64) Slot
+  {
+    std::atomic<std::uint64_t> sequence;
+    T value;
+  };
+
+  alignas(64) std::atomic<std::uint64_t> head_;
+  alignas(64) std::atomic<std::uint64_t> tail_;
+  std::array<Slot, Capacity> slots_;
+};
+
+}  // namespace robocap_sim
+
+#endif  // ROBOCAP_SIM__SHM_RING_HPP_
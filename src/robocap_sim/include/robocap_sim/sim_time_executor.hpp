@@ -0,0 +1,46 @@
+#ifndef ROBOCAP_SIM__SIM_TIME_EXECUTOR_HPP_
+#define ROBOCAP_SIM__SIM_TIME_EXECUTOR_HPP_
+
+#include <cstddef>
+
+#include "rclcpp/executor.hpp"
+#include "rclcpp/node.hpp"
+#include "rclcpp/publisher.hpp"
+#include "rclcpp/time.hpp"
+#include "rosgraph_msgs/msg/clock.hpp"
+
+namespace robocap_sim
+{
+
+// Single-threaded executor that runs in lockstep with a simulation it does not own. Callbacks only
+// run inside advance() and drain(), on the calling thread: advance() publishes the new sim time on
+// /clock, then runs everything that is ready, including whatever those callbacks trigger, until
+// nothing is left. Time never moves while work is pending, so a callback always sees the step it
+// was triggered in, however long it took in wall time.
+//
+// Within one drain, work runs in the order the executor collects it (timers, subscriptions,
+// services, clients, waitables, each by node and creation order), never in arrival order. Nodes
+// need use_sim_time and NodeOptions::use_clock_thread(false), so /clock is handled here too.
+class SimTimeExecutor : public rclcpp::Executor
+{
+public:
+  explicit SimTimeExecutor(const rclcpp::ExecutorOptions & options = rclcpp::ExecutorOptions());
+
+  // Runs work as it arrives until cancel(), without publishing a clock
+  void spin() override;
+
+  // Publishes `time` on /clock and drains. Returns the number of callbacks run
+  std::size_t advance(const rclcpp::Time & time);
+
+  // Runs callbacks until none is ready, without moving time
+  std::size_t drain();
+
+private:
+  rclcpp::Node::SharedPtr clock_node_;
+  rclcpp::Publisher<rosgraph_msgs::msg::Clock>::SharedPtr clock_publisher_;
+  rosgraph_msgs::msg::Clock clock_;
+};
+
+}  // namespace robocap_sim
+
+#endif  // ROBOCAP_SIM__SIM_TIME_EXECUTOR_HPP_
@@ -1,20 +1,104 @@
 from launch import LaunchDescription
-from launch.actions import ExecuteProcess
-from launch_ros.actions import Node
-from launch.actions import IncludeLaunchDescription
+from launch.conditions import IfCondition, UnlessCondition
+from launch_ros.actions import ComposableNodeContainer, LoadComposableNodes, Node
+from launch_ros.descriptions import ComposableNode
+from launch_ros.substitutions import ExecutableInPackage
+from launch.actions import DeclareLaunchArgument, ExecuteProcess, IncludeLaunchDescription
+from launch.actions import SetEnvironmentVariable
 from launch.launch_description_sources import PythonLaunchDescriptionSource
+from launch.substitutions import LaunchConfiguration, PythonExpression
 from ament_index_python.packages import get_package_share_directory
 import os
 
+
 def generate_launch_description():
-    # Set the path to the Xacro file in the source directory
-    xacro_file = '/home/developer/repo/src/robocap_sim/urdf/robot.urdf.xacro'
+    package_share = get_package_share_directory('robocap_sim')
+
+    # headless:=true runs only the server (gz sim -s), without a GUI through xpra
+    headless = DeclareLaunchArgument('headless', default_value='false')
+    server_only = PythonExpression(
+        ["'-s ' if '", LaunchConfiguration('headless'), "' == 'true' else ''"])
+
+    # telemetry_file:=/tmp/robocap.ring records every physics step, see robocap_telemetry
+    telemetry_file = DeclareLaunchArgument('telemetry_file', default_value='')
+    telemetry_env = SetEnvironmentVariable(
+        'ROBOCAP_TELEMETRY_FILE', LaunchConfiguration('telemetry_file'))
+
+    # The controllers' loop period and command latency from gz sim, next to the container's 9464.
+    # metrics_port:=0 turns it off
+    metrics_port = DeclareLaunchArgument('metrics_port', default_value='9465')
+    metrics_port_env = SetEnvironmentVariable(
+        'ROBOCAP_METRICS_PORT', LaunchConfiguration('metrics_port'))
+
+    # shm_bridge:=true takes joint states, ground truth and scans out of gz sim through shared
+    # memory (robocap_bridge::ShmBridge) instead of gz-transport and LaserScanBridge
+    shm_bridge = DeclareLaunchArgument('shm_bridge', default_value='false')
+    shm_segment_env = SetEnvironmentVariable(
+        'ROBOCAP_SHM_SEGMENT',
+        PythonExpression(
+            ["'/robocap_bridge' if '", LaunchConfiguration('shm_bridge'), "' == 'true' else ''"]))
+    scan_bridge = PythonExpression(
+        ["'robocap_bridge::ShmBridge' if '", LaunchConfiguration('shm_bridge'),
+         "' == 'true' else 'robocap_bridge::LaserScanBridge'"])
+
+    # estimator:=controller runs the EKF inside the controller manager instead of as a node
+    estimator = DeclareLaunchArgument(
+        'estimator', default_value='node', choices=['node', 'controller'])
+    ekf_in_controller = PythonExpression(
+        ["'", LaunchConfiguration('estimator'), "' == 'controller'"])
+    ekf_as_node = PythonExpression(["'", LaunchConfiguration('estimator'), "' == 'node'"])
+    odom_topic = PythonExpression(
+        ["'/odom' if '", LaunchConfiguration('estimator'),
+         "' == 'node' else '/ekf_odometry_controller/odom'"])
 
-    # Convert Xacro to URDF
-    urdf_file = '/tmp/robot.urdf'  # Temporary file location for the converted URDF
+    # controller:=mpc drives the wheels through robocap_control::KiwiMpcController, which keeps
+    # accelerations within the chassis' tipping limit, instead of KiwiDriveController
+    controller_type = DeclareLaunchArgument(
+        'controller', default_value='velocity', choices=['velocity', 'mpc'])
+    drive_controller = PythonExpression(
+        ["'kiwi_mpc_controller' if '", LaunchConfiguration('controller'),
+         "' == 'mpc' else 'kiwi_drive_controller'"])
 
-    xacro_to_urdf = ExecuteProcess(
-        cmd=['xacro', xacro_file, '-o', urdf_file],
+    # deterministic:=true steps the world and the whole ROS stack in lockstep in one process, with
+    # a fixed seed, and writes a state checksum per step to checksum_file. See
+    # robocap_deterministic_sim; steps:=0 runs until shutdown.
+    deterministic = DeclareLaunchArgument('deterministic', default_value='false')
+    seed = DeclareLaunchArgument('seed', default_value='1')
+    steps = DeclareLaunchArgument('steps', default_value='0')
+    checksum_file = DeclareLaunchArgument('checksum_file', default_value='')
+    is_deterministic = IfCondition(LaunchConfiguration('deterministic'))
+    not_deterministic = UnlessCondition(LaunchConfiguration('deterministic'))
+
+    # priority_executor:=true runs the container on robocap_runtime's priority tiers, with the EKF
+    # and the planner on SCHED_FIFO threads ahead of TF and the occupancy grid
+    priority_executor = DeclareLaunchArgument('priority_executor', default_value='false')
+    container_package = PythonExpression(
+        ["'robocap_runtime' if '", LaunchConfiguration('priority_executor'),
+         "' == 'true' else 'rclcpp_components'"])
+    container_executable = PythonExpression(
+        ["'robocap_priority_container' if '", LaunchConfiguration('priority_executor'),
+         "' == 'true' else 'component_container_mt'"])
+    priority_tiers = os.path.join(
+        get_package_share_directory('robocap_runtime'), 'config', 'priority_tiers.yaml')
+
+    # Baked from urdf/robot.urdf.xacro at build time, see CMakeLists.txt
+    urdf_file = os.path.join(package_share, 'models', 'robocap', 'robot.urdf')
+    with open(urdf_file, 'r') as f:
+        robot_description = f.read()
+
+    # Local world with the ground plane, robocap_sim::ModelSpawner creates the robot in it
+    world_file = os.path.join(package_share, 'worlds', 'robocap.sdf')
+
+    # entities:=<file> spawns more models (see robocap_sim::parse_entities) into the world in one
+    # batched request as soon as its create_multiple service shows up
+    entities = DeclareLaunchArgument('entities', default_value='')
+    spawn_entities = ExecuteProcess(
+        cmd=[
+            ExecutableInPackage(package='robocap_sim', executable='robocap_spawn'),
+            '--file', LaunchConfiguration('entities'),
+        ],
+        condition=IfCondition(
+            PythonExpression(["'", LaunchConfiguration('entities'), "' != ''"])),
         output='screen'
     )
 
@@ -23,28 +107,175 @@ def generate_launch_description():
         PythonLaunchDescriptionSource(
             os.path.join(get_package_share_directory('ros_gz_sim'), 'launch', 'gz_sim.launch.py')
         ),
-        launch_arguments={'gz_args': '--verbose'}.items(),  # Use --verbose for more logging information
+        # Use --verbose for more logging information, -r starts the simulation right away
+        launch_arguments={'gz_args': [server_only, '-r --verbose ', world_file]}.items(),
+        condition=not_deterministic,
+    )
+
+    # One process for the ROS side of the stack. With intra-process comms, scans and other messages
+    # between these nodes move as unique_ptr instead of being serialized
+    intra_process = [{'use_intra_process_comms': True}]
+    stack_nodes = [
+        # Loop periods, message ages and queue depths of everything in the container on
+        # http://localhost:9464/metrics and /diagnostics, the controllers' are on metrics_port
+        ComposableNode(
+            package='robocap_runtime',
+            plugin='robocap_runtime::MetricsExporter',
+            parameters=[{'use_sim_time': True, 'port': 9464}],
+            extra_arguments=intra_process,
+        ),
+        # The shared memory bridge's joint states sit beside joint_state_broadcaster's
+        ComposableNode(
+            package='robocap_bridge',
+            plugin=scan_bridge,
+            parameters=[{'use_sim_time': True, 'segment': '/robocap_bridge'}],
+            remappings=[('joint_states', '/sim/joint_states')],
+            extra_arguments=intra_process,
+        ),
+        ComposableNode(
+            package='robocap_bridge',
+            plugin='robocap_bridge::ImuBridge',
+            parameters=[{'use_sim_time': True}],
+            extra_arguments=intra_process,
+        ),
+        # Rolling occupancy grid around the robot, published as grid_delta
+        ComposableNode(
+            package='robocap_perception',
+            plugin='robocap_perception::ScanMapper',
+            parameters=[{'use_sim_time': True}],
+            extra_arguments=intra_process,
+        ),
+        # MPPI towards goal_pose (e.g. RViz 2D Goal Pose in odom), avoiding the grid's obstacles
+        ComposableNode(
+            package='robocap_planning',
+            plugin='robocap_planning::LocalPlanner',
+            parameters=[{'use_sim_time': True}],
+            remappings=[
+                ('odom', odom_topic),
+                ('cmd_vel', ['/', drive_controller, '/cmd_vel']),
+            ],
+            extra_arguments=intra_process,
+        ),
+        # Serves robot_description and TF, the controller manager reads the baked URDF itself
+        ComposableNode(
+            package='robot_state_publisher',
+            plugin='robot_state_publisher::RobotStatePublisher',
+            parameters=[{
+                'robot_description': robot_description,
+                'use_sim_time': True,
+            }],
+            extra_arguments=intra_process,
+        ),
+    ]
+    container = ComposableNodeContainer(
+        name='robocap_container',
+        namespace='',
+        package=container_package,
+        executable=container_executable,
+        # Only read by robocap_priority_container
+        parameters=[priority_tiers],
+        composable_node_descriptions=[
+            # Sim time for the controller manager and everything else with use_sim_time
+            ComposableNode(
+                package='robocap_bridge',
+                plugin='robocap_bridge::ClockBridge',
+                extra_arguments=intra_process,
+            ),
+            *stack_nodes,
+        ],
+        condition=not_deterministic,
+        output='screen'
     )
 
-    # Spawn the ground plane
-    spawn_ground_plane = Node(
-        package='ros_gz_sim',
-        executable='create',
-        arguments=['-name', 'ground_plane', '-topic', 'world/default/create', '-file', 'https://fuel.ignitionrobotics.org/1.0/OpenRobotics/models/Ground%20Plane'],
+    # The deterministic runner is the container itself and publishes /clock from the world
+    controllers = PythonExpression(
+        ["'joint_state_broadcaster ", drive_controller, "' + (' ekf_odometry_controller' if '",
+         LaunchConfiguration('estimator'), "' == 'controller' else '')"])
+    components = PythonExpression(
+        [str(len(stack_nodes)), " + (1 if '", LaunchConfiguration('estimator'),
+         "' == 'node' else 0)"])
+    deterministic_sim = Node(
+        package='robocap_sim',
+        executable='robocap_deterministic_sim',
+        name='robocap_container',
+        arguments=[
+            '--world', world_file,
+            '--seed', LaunchConfiguration('seed'),
+            '--steps', LaunchConfiguration('steps'),
+            '--components', components,
+            '--controllers', controllers,
+            '--checksum-file', LaunchConfiguration('checksum_file'),
+        ],
+        # Process-wide, so the controller manager the plugin creates finds its parameters too
+        parameters=[os.path.join(
+            get_package_share_directory('robocap_control'), 'config',
+            'kiwi_drive_controllers.yaml')],
+        condition=is_deterministic,
         output='screen'
     )
+    deterministic_stack = LoadComposableNodes(
+        target_container='robocap_container',
+        composable_node_descriptions=stack_nodes,
+        condition=is_deterministic,
+    )
 
-    # Spawn robot in Ignition Gazebo with a z-offset of 0.1 meter
-    spawn_robot = Node(
-        package='ros_gz_sim',
-        executable='create',
-        arguments=['-file', urdf_file, '-name', 'robot', '-z', '0.1'],
+    # Odometry and odom -> base_link from the wheels and the IMU
+    ekf_node = LoadComposableNodes(
+        target_container='robocap_container',
+        condition=IfCondition(ekf_as_node),
+        composable_node_descriptions=[
+            ComposableNode(
+                package='robocap_estimation',
+                plugin='robocap_estimation::EkfNode',
+                parameters=[{'use_sim_time': True}],
+                extra_arguments=intra_process,
+            ),
+        ],
+    )
+    spawn_ekf_controller = Node(
+        package='controller_manager',
+        executable='spawner',
+        arguments=['ekf_odometry_controller', '--controller-manager', '/controller_manager'],
+        condition=IfCondition(PythonExpression(
+            [ekf_in_controller, " and '", LaunchConfiguration('deterministic'), "' != 'true'"])),
         output='screen'
     )
 
+    # The controller manager runs inside gz_sim (robocap_control::GzControlPlugin). In lockstep the
+    # plugin activates the controllers itself
+    spawn_controllers = [
+        Node(
+            package='controller_manager',
+            executable='spawner',
+            arguments=[controller, '--controller-manager', '/controller_manager'],
+            condition=not_deterministic,
+            output='screen'
+        )
+        for controller in ['joint_state_broadcaster', drive_controller]
+    ]
+
     return LaunchDescription([
-        xacro_to_urdf,
+        headless,
+        telemetry_file,
+        telemetry_env,
+        metrics_port,
+        metrics_port_env,
+        shm_bridge,
+        shm_segment_env,
+        estimator,
+        controller_type,
+        priority_executor,
+        deterministic,
+        seed,
+        steps,
+        checksum_file,
+        entities,
         gz_sim,
-        spawn_ground_plane,
-        spawn_robot,
+        spawn_entities,
+        container,
+        deterministic_sim,
+        deterministic_stack,
+        ekf_node,
+        *spawn_controllers,
+        spawn_ekf_controller,
     ])
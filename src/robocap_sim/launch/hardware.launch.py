@@ -0,0 +1,69 @@
+from launch import LaunchDescription
+from launch_ros.actions import Node
+from launch_ros.parameter_descriptions import ParameterValue
+from launch.actions import DeclareLaunchArgument
+from launch.substitutions import Command, LaunchConfiguration, PythonExpression
+from ament_index_python.packages import get_package_share_directory
+import os
+
+
+def generate_launch_description():
+    package_share = get_package_share_directory('robocap_sim')
+
+    # The same URDF, hardware interface and controllers as gazebo.launch.py, on the real motor
+    # drivers: KiwiDriveSystem talks to them through robocap_control::MotorBusBackend when no
+    # simulation attaches its wheels. transport:=serial device:=/dev/ttyACM0 for a serial line
+    transport = DeclareLaunchArgument('transport', default_value='can', choices=['can', 'serial'])
+    device = DeclareLaunchArgument('device', default_value='can0')
+    controller_type = DeclareLaunchArgument(
+        'controller', default_value='velocity', choices=['velocity', 'mpc'])
+    drive_controller = PythonExpression(
+        ["'kiwi_mpc_controller' if '", LaunchConfiguration('controller'),
+         "' == 'mpc' else 'kiwi_drive_controller'"])
+
+    # Expanded here rather than baked, the drivers' device is only known on the robot
+    robot_description = ParameterValue(
+        Command([
+            'xacro ', os.path.join(package_share, 'urdf', 'robot.urdf.xacro'),
+            ' motor_transport:=', LaunchConfiguration('transport'),
+            ' motor_device:=', LaunchConfiguration('device'),
+        ]),
+        value_type=str)
+
+    # The controllers' file sets use_sim_time for the simulation, the robot runs on the wall clock
+    controller_manager = Node(
+        package='controller_manager',
+        executable='ros2_control_node',
+        parameters=[
+            {'robot_description': robot_description},
+            os.path.join(
+                get_package_share_directory('robocap_control'), 'config',
+                'kiwi_drive_controllers.yaml'),
+            {'use_sim_time': False},
+        ],
+        output='screen'
+    )
+    robot_state_publisher = Node(
+        package='robot_state_publisher',
+        executable='robot_state_publisher',
+        parameters=[{'robot_description': robot_description}],
+        output='screen'
+    )
+    spawn_controllers = [
+        Node(
+            package='controller_manager',
+            executable='spawner',
+            arguments=[controller, '--controller-manager', '/controller_manager'],
+            output='screen'
+        )
+        for controller in ['joint_state_broadcaster', drive_controller]
+    ]
+
+    return LaunchDescription([
+        transport,
+        device,
+        controller_type,
+        controller_manager,
+        robot_state_publisher,
+        *spawn_controllers,
+    ])
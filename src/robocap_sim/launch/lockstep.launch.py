@@ -0,0 +1,33 @@
+from launch import LaunchDescription
+from launch_ros.actions import Node
+from launch.actions import DeclareLaunchArgument
+from launch.substitutions import LaunchConfiguration
+from ament_index_python.packages import get_package_share_directory
+import os
+
+
+def generate_launch_description():
+    package_share = get_package_share_directory('robocap_sim')
+
+    socket = DeclareLaunchArgument('socket', default_value='/tmp/robocap_lockstep.sock')
+    # Physics only: no Sensors system rendering the lidar and a robot without GzControlPlugin
+    world = DeclareLaunchArgument(
+        'world', default_value=os.path.join(package_share, 'worlds', 'robocap_headless.sdf'))
+
+    # Headless server that only steps when a LockstepClient asks, as fast as physics allows.
+    # No controllers run, the client commands the wheel joints directly.
+    lockstep_server = Node(
+        package='robocap_sim',
+        executable='robocap_lockstep_server',
+        arguments=[
+            '--world', LaunchConfiguration('world'),
+            '--socket', LaunchConfiguration('socket'),
+        ],
+        output='screen'
+    )
+
+    return LaunchDescription([
+        socket,
+        world,
+        lockstep_server,
+    ])
@@ -1,3 +1,5 @@
+#!/usr/bin/env python3
+
 def main():
     print('Hi from robocap_sim.')
 
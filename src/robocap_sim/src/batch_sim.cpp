@@ -0,0 +1,232 @@
+#include "robocap_sim/batch_sim.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+#include "robocap_kinematics/robocap_layout.hpp"
+#include "robocap_kinematics/simd.hpp"
+
+namespace robocap_sim
+{
+
+namespace
+{
+
+namespace model = robocap_kinematics::robocap_model;
+
+using FloatPack = robocap_kinematics::simd::Pack<float>;
+using Vec = FloatPack::Vec;
+using Mask = decltype(Vec{} < Vec{});
+constexpr std::size_t kLanes = FloatPack::kLanes;
+constexpr std::size_t kWheels = robocap_kinematics::kNumWheels;
+
+// Packs handed to a thread at a time
+constexpr std::size_t kPacksPerChunk = 16;
+
+// Same as OmniWheelContact: the traction force removes at most this fraction of the slip per step
+constexpr double kSlipCorrection = 0.5;
+
+// A wheel's share of the yaw inertia about base_link's z. The axles are horizontal, so the wheel
+// turns about a diameter of its cylinder, plus the parallel axis term for its joint offset
+constexpr double wheel_yaw_inertia(const model::Link & link, const model::Joint & joint)
+{
+  const auto & offset = joint.origin.xyz;
+  return link.inertia.ixx + link.mass * (offset.x * offset.x + offset.y * offset.y);
+}
+
+// The chassis' inertial origin lies on base_link's z axis, so its own izz counts as is
+constexpr double kYawInertia = model::links::chassis.inertia.izz +
+  wheel_yaw_inertia(model::links::wheel_1, model::joints::wheel_1_joint) +
+  wheel_yaw_inertia(model::links::wheel_2, model::joints::wheel_2_joint) +
+  wheel_yaw_inertia(model::links::wheel_3, model::joints::wheel_3_joint);
+
+Vec select(const Mask & mask, const Vec & a, const Vec & b)
+{
+  return reinterpret_cast<Vec>(
+    (mask & reinterpret_cast<Mask>(a)) | (~mask & reinterpret_cast<Mask>(b)));
+}
+
+Vec clamp(const Vec & value, const Vec & limit)
+{
+  const Vec low = select(value < -limit, -limit, value);
+  return select(low > limit, limit, low);
+}
+
+}  // namespace
+
+BatchSim::BatchSim(std::size_t size, const BatchSimConfig & config)
+: size_(size),
+  padded_((size + kLanes - 1) / kLanes * kLanes),
+  config_(config),
+  pool_(config.threads),
+  mass_(model::kTotalMass),
+  yaw_inertia_(kYawInertia)
+{
+  if (size == 0) {
+    throw std::invalid_argument("BatchSim needs at least one robot");
+  }
+  if (!(config.step_size > 0.0) || config.mu < 0.0 || config.roller_drag < 0.0 ||
+    config.motor_time_constant < 0.0)
+  {
+    throw std::invalid_argument("BatchSim: step_size must be positive, the rest non-negative");
+  }
+  for (auto * lanes : {&x_, &y_, &sin_yaw_, &vx_, &vy_, &wz_}) {
+    lanes->assign(padded_, 0.0f);
+  }
+  cos_yaw_.assign(padded_, 1.0f);
+  for (std::size_t wheel = 0; wheel < kWheels; ++wheel) {
+    wheel_position_[wheel].assign(padded_, 0.0f);
+    wheel_velocity_[wheel].assign(padded_, 0.0f);
+    wheel_command_[wheel].assign(padded_, 0.0f);
+  }
+}
+
+void BatchSim::reset(std::size_t index, const PlanarState & state)
+{
+  x_[index] = static_cast<float>(state.x);
+  y_[index] = static_cast<float>(state.y);
+  cos_yaw_[index] = static_cast<float>(std::cos(state.yaw));
+  sin_yaw_[index] = static_cast<float>(std::sin(state.yaw));
+  vx_[index] = static_cast<float>(state.vx);
+  vy_[index] = static_cast<float>(state.vy);
+  wz_[index] = static_cast<float>(state.wz);
+  for (std::size_t wheel = 0; wheel < kWheels; ++wheel) {
+    wheel_position_[wheel][index] = 0.0f;
+    wheel_velocity_[wheel][index] = 0.0f;
+    wheel_command_[wheel][index] = 0.0f;
+  }
+}
+
+PlanarState BatchSim::state(std::size_t index) const
+{
+  PlanarState state;
+  state.x = x_[index];
+  state.y = y_[index];
+  state.yaw = std::atan2(sin_yaw_[index], cos_yaw_[index]);
+  state.vx = vx_[index];
+  state.vy = vy_[index];
+  state.wz = wz_[index];
+  return state;
+}
+
+void BatchSim::step(std::uint32_t substeps)
+{
+  if (substeps == 0) {
+    return;
+  }
+  pool_.parallel_for(
+    padded_ / kLanes, kPacksPerChunk,
+    [this, substeps](std::size_t begin, std::size_t end, std::size_t /*worker*/) {
+      step_packs(begin, end, substeps);
+    });
+}
+
+void BatchSim::step_packs(std::size_t begin, std::size_t end, std::uint32_t substeps)
+{
+  const auto & layout = robocap_kinematics::kRobocapLayout;
+  const double dt = config_.step_size;
+  // Flat ground: all three wheels touch and share the weight evenly
+  const double normal_force = mass_ * config_.gravity / static_cast<double>(kWheels);
+
+  const Vec step = FloatPack::broadcast(static_cast<float>(dt));
+  const Vec radius = FloatPack::broadcast(static_cast<float>(layout.wheel_radius));
+  const Vec slip_gain = FloatPack::broadcast(
+    static_cast<float>(kSlipCorrection * mass_ / static_cast<double>(kWheels) / dt));
+  const Vec roller_drag = FloatPack::broadcast(static_cast<float>(config_.roller_drag));
+  const Vec max_force = FloatPack::broadcast(static_cast<float>(config_.mu * normal_force));
+  const Vec inv_mass = FloatPack::broadcast(static_cast<float>(1.0 / mass_));
+  const Vec inv_inertia = FloatPack::broadcast(static_cast<float>(1.0 / yaw_inertia_));
+  const bool lag = config_.motor_time_constant > 0.0;
+  const Vec lag_gain = FloatPack::broadcast(
+    static_cast<float>(dt / (config_.motor_time_constant + dt)));
+  const Vec half = FloatPack::broadcast(0.5f);
+  const Vec one = FloatPack::broadcast(1.0f);
+  const Vec sixth = FloatPack::broadcast(1.0f / 6.0f);
+  const Vec three_halves = FloatPack::broadcast(1.5f);
+
+  Vec px[kWheels], py[kWheels], dx[kWheels], dy[kWheels];
+  for (std::size_t wheel = 0; wheel < kWheels; ++wheel) {
+    px[wheel] = FloatPack::broadcast(static_cast<float>(layout.wheels[wheel].x));
+    py[wheel] = FloatPack::broadcast(static_cast<float>(layout.wheels[wheel].y));
+    dx[wheel] = FloatPack::broadcast(static_cast<float>(layout.wheels[wheel].drive_x));
+    dy[wheel] = FloatPack::broadcast(static_cast<float>(layout.wheels[wheel].drive_y));
+  }
+
+  for (std::size_t pack = begin; pack < end; ++pack) {
+    const std::size_t k = pack * kLanes;
+    // The pack stays in registers for all substeps
+    Vec x = FloatPack::load(&x_[k]);
+    Vec y = FloatPack::load(&y_[k]);
+    Vec c = FloatPack::load(&cos_yaw_[k]);
+    Vec s = FloatPack::load(&sin_yaw_[k]);
+    Vec vx = FloatPack::load(&vx_[k]);
+    Vec vy = FloatPack::load(&vy_[k]);
+    Vec wz = FloatPack::load(&wz_[k]);
+    Vec position[kWheels], velocity[kWheels], command[kWheels];
+    for (std::size_t wheel = 0; wheel < kWheels; ++wheel) {
+      position[wheel] = FloatPack::load(&wheel_position_[wheel][k]);
+      velocity[wheel] = FloatPack::load(&wheel_velocity_[wheel][k]);
+      command[wheel] = FloatPack::load(&wheel_command_[wheel][k]);
+    }
+
+    for (std::uint32_t substep = 0; substep < substeps; ++substep) {
+      // Chassis velocity in base_link
+      const Vec bvx = c * vx + s * vy;
+      const Vec bvy = c * vy - s * vx;
+
+      Vec fx{}, fy{}, torque{};
+      for (std::size_t wheel = 0; wheel < kWheels; ++wheel) {
+        velocity[wheel] = lag ?
+          velocity[wheel] + (command[wheel] - velocity[wheel]) * lag_gain : command[wheel];
+        position[wheel] += velocity[wheel] * step;
+
+        // Contact point velocity, the rim moves back along the drive direction as the wheel spins
+        const Vec cvx = bvx - wz * py[wheel];
+        const Vec cvy = bvy + wz * px[wheel];
+        const Vec slip = cvx * dx[wheel] + cvy * dy[wheel] - radius * velocity[wheel];
+        const Vec lateral = cvy * dx[wheel] - cvx * dy[wheel];
+        const Vec traction = clamp(-slip_gain * slip, max_force);
+        const Vec drag = clamp(-roller_drag * lateral, max_force);
+
+        const Vec wfx = traction * dx[wheel] - drag * dy[wheel];
+        const Vec wfy = traction * dy[wheel] + drag * dx[wheel];
+        fx += wfx;
+        fy += wfy;
+        torque += px[wheel] * wfy - py[wheel] * wfx;
+      }
+
+      // Semi-implicit Euler, as the physics engine integrates
+      vx += (c * fx - s * fy) * inv_mass * step;
+      vy += (s * fx + c * fy) * inv_mass * step;
+      wz += torque * inv_inertia * step;
+      x += vx * step;
+      y += vy * step;
+
+      // Rotate the heading by wz * dt with third order sin/cos, then pull it back onto the unit
+      // circle with one Newton step, which is exact enough for angles this small
+      const Vec angle = wz * step;
+      const Vec angle2 = angle * angle;
+      const Vec cd = one - half * angle2;
+      const Vec sd = angle * (one - sixth * angle2);
+      const Vec nc = c * cd - s * sd;
+      const Vec ns = s * cd + c * sd;
+      const Vec norm = three_halves - half * (nc * nc + ns * ns);
+      c = nc * norm;
+      s = ns * norm;
+    }
+
+    FloatPack::store(&x_[k], x);
+    FloatPack::store(&y_[k], y);
+    FloatPack::store(&cos_yaw_[k], c);
+    FloatPack::store(&sin_yaw_[k], s);
+    FloatPack::store(&vx_[k], vx);
+    FloatPack::store(&vy_[k], vy);
+    FloatPack::store(&wz_[k], wz);
+    for (std::size_t wheel = 0; wheel < kWheels; ++wheel) {
+      FloatPack::store(&wheel_position_[wheel][k], position[wheel]);
+      FloatPack::store(&wheel_velocity_[wheel][k], velocity[wheel]);
+    }
+  }
+}
+
+}  // namespace robocap_sim
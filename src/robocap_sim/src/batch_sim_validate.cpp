@@ -0,0 +1,250 @@
+// Compares BatchSim against the full Gazebo model. Drives a robocap_lockstep_server with random
+// piecewise-constant twists and, at the start of every segment, puts a one-robot BatchSim into the
+// state Gazebo reached, runs the same wheel commands on both and reports how far they end apart.
+//
+// Usage: robocap_batch_sim_validate [--socket <path>] [--segments 20] [--segment-time 2]
+//                                   [--record-every 10] [--seed 1] [--motor-time-constant 0]
+//                                   [--tolerance 0] [--output trace.csv]
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "robocap_kinematics/robocap_layout.hpp"
+
+#include "robocap_sim/batch_sim.hpp"
+#include "robocap_sim/lockstep_client.hpp"
+
+namespace robocap_sim
+{
+
+namespace
+{
+
+constexpr double kMaxLinear = 1.0;   // [m/s] sampled command range, as robocap_sim_farm
+constexpr double kMaxAngular = 1.5;  // [rad/s]
+constexpr double kSettleTime = 0.5;  // [s] of zero commands before the first segment
+constexpr double kPi = 3.14159265358979323846;
+
+const std::array<std::string, robocap_kinematics::kNumWheels> kWheelJoints = {
+  "wheel_1_joint", "wheel_2_joint", "wheel_3_joint"};
+
+struct Options
+{
+  std::string socket = "/tmp/robocap_lockstep.sock";
+  std::string output;
+  std::uint32_t segments = 20;
+  double segment_time = 2.0;         // [s]
+  std::uint32_t record_every = 10;   // physics steps between compared samples
+  std::uint64_t seed = 1;
+  double motor_time_constant = 0.0;  // [s]
+  double tolerance = 0.0;            // [m] on the segment end error, 0 only reports
+};
+
+struct Pose2d
+{
+  double x;
+  double y;
+  double yaw;
+};
+
+double wrap(double angle)
+{
+  return std::remainder(angle, 2.0 * kPi);
+}
+
+Pose2d sample_pose(const LockstepSamples & samples, std::size_t index)
+{
+  const double * pose = &samples.base_pose[index * 7];
+  const double qw = pose[3], qx = pose[4], qy = pose[5], qz = pose[6];
+  return Pose2d{
+    pose[0], pose[1],
+    std::atan2(2.0 * (qw * qz + qx * qy), 1.0 - 2.0 * (qy * qy + qz * qz))};
+}
+
+// Gazebo's state at the last sample, velocities by backward difference over the last interval
+PlanarState last_state(const LockstepSamples & samples, double interval)
+{
+  const auto now = sample_pose(samples, samples.size - 1);
+  const auto before = sample_pose(samples, samples.size - 2);
+  PlanarState state;
+  state.x = now.x;
+  state.y = now.y;
+  state.yaw = now.yaw;
+  state.vx = (now.x - before.x) / interval;
+  state.vy = (now.y - before.y) / interval;
+  state.wz = wrap(now.yaw - before.yaw) / interval;
+  return state;
+}
+
+struct ErrorStats
+{
+  double sum = 0.0;
+  double max = 0.0;
+  std::size_t count = 0;
+
+  void add(double error)
+  {
+    sum += error;
+    max = std::max(max, error);
+    ++count;
+  }
+
+  double mean() const {return count > 0 ? sum / static_cast<double>(count) : 0.0;}
+};
+
+bool parse_options(int argc, char ** argv, Options & options)
+{
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string flag = argv[i];
+    const std::string value = argv[i + 1];
+    if (flag == "--socket") {
+      options.socket = value;
+    } else if (flag == "--output") {
+      options.output = value;
+    } else if (flag == "--segments") {
+      options.segments = static_cast<std::uint32_t>(std::stoul(value));
+    } else if (flag == "--segment-time") {
+      options.segment_time = std::stod(value);
+    } else if (flag == "--record-every") {
+      options.record_every = static_cast<std::uint32_t>(std::stoul(value));
+    } else if (flag == "--seed") {
+      options.seed = std::stoull(value);
+    } else if (flag == "--motor-time-constant") {
+      options.motor_time_constant = std::stod(value);
+    } else if (flag == "--tolerance") {
+      options.tolerance = std::stod(value);
+    } else {
+      std::cerr << "Unknown argument " << flag << std::endl;
+      return false;
+    }
+  }
+  return (argc % 2) == 1 && options.record_every > 0 && options.segment_time > 0.0;
+}
+
+}  // namespace
+
+}  // namespace robocap_sim
+
+int main(int argc, char ** argv)
+{
+  using robocap_sim::LockstepSamples;
+
+  robocap_sim::Options options;
+  if (!robocap_sim::parse_options(argc, argv, options)) {
+    std::cerr << "Usage: " << argv[0] << " [--socket path] [--segments N] [--segment-time s]"
+      " [--record-every N] [--seed N] [--motor-time-constant s] [--tolerance m]"
+      " [--output file]" << std::endl;
+    return 1;
+  }
+
+  robocap_sim::LockstepClient client;
+  if (!client.connect(options.socket)) {
+    std::cerr << "Failed to connect to " << options.socket << std::endl;
+    return 1;
+  }
+  // Commands go out in the server's joint order
+  const auto & joint_names = client.joint_names();
+  std::array<std::size_t, robocap_kinematics::kNumWheels> joint_index{};
+  for (std::size_t wheel = 0; wheel < joint_index.size(); ++wheel) {
+    const auto found = std::find(
+      joint_names.begin(), joint_names.end(), robocap_sim::kWheelJoints[wheel]);
+    if (found == joint_names.end()) {
+      std::cerr << "Server has no joint " << robocap_sim::kWheelJoints[wheel] << std::endl;
+      return 1;
+    }
+    joint_index[wheel] = static_cast<std::size_t>(found - joint_names.begin());
+  }
+
+  const double step_size = static_cast<double>(client.step_size_ns()) * 1e-9;
+  const double interval = step_size * options.record_every;
+  const auto records = static_cast<std::uint32_t>(
+    std::max(2.0, std::round(options.segment_time / interval)));
+  robocap_sim::BatchSimConfig config;
+  config.step_size = step_size;
+  config.motor_time_constant = options.motor_time_constant;
+  config.threads = 1;
+  robocap_sim::BatchSim sim(1, config);
+
+  std::ofstream trace;
+  if (!options.output.empty()) {
+    trace.open(options.output);
+    trace << "segment,time,gz_x,gz_y,gz_yaw,batch_x,batch_y,batch_yaw\n";
+  }
+
+  LockstepSamples samples;
+  std::vector<double> commands(joint_names.size(), 0.0);
+  const auto settle = static_cast<std::uint32_t>(
+    std::max(2.0, std::round(robocap_sim::kSettleTime / interval)));
+  if (!client.step(settle * options.record_every, options.record_every, commands, samples) ||
+    samples.size < 2)
+  {
+    std::cerr << "Lockstep server stopped answering" << std::endl;
+    return 1;
+  }
+
+  std::mt19937_64 engine(options.seed);
+  std::uniform_real_distribution<double> linear(-robocap_sim::kMaxLinear, robocap_sim::kMaxLinear);
+  std::uniform_real_distribution<double> angular(
+    -robocap_sim::kMaxAngular, robocap_sim::kMaxAngular);
+  robocap_sim::ErrorStats position_error;
+  robocap_sim::ErrorStats yaw_error;
+  std::chrono::steady_clock::duration gz_time{};
+  std::chrono::steady_clock::duration batch_time{};
+
+  for (std::uint32_t segment = 0; segment < options.segments; ++segment) {
+    sim.reset(0, robocap_sim::last_state(samples, interval));
+    const auto speeds = robocap_kinematics::kRobocapKiwiDrive.to_wheel_speeds(
+      robocap_kinematics::Twist<double>{linear(engine), linear(engine), angular(engine)});
+    for (std::size_t wheel = 0; wheel < speeds.size(); ++wheel) {
+      commands[joint_index[wheel]] = speeds[wheel];
+      sim.wheel_command(wheel)[0] = static_cast<float>(speeds[wheel]);
+    }
+
+    const auto gz_start = std::chrono::steady_clock::now();
+    if (!client.step(records * options.record_every, options.record_every, commands, samples) ||
+      samples.size != records)
+    {
+      std::cerr << "Lockstep server stopped answering" << std::endl;
+      return 1;
+    }
+    gz_time += std::chrono::steady_clock::now() - gz_start;
+
+    for (std::size_t record = 0; record < samples.size; ++record) {
+      const auto batch_start = std::chrono::steady_clock::now();
+      sim.step(options.record_every);
+      batch_time += std::chrono::steady_clock::now() - batch_start;
+      const auto gz = robocap_sim::sample_pose(samples, record);
+      const auto batch = sim.state(0);
+      if (trace.is_open()) {
+        trace << segment << ',' << static_cast<double>(samples.sim_time_ns[record]) * 1e-9 << ',' <<
+          gz.x << ',' << gz.y << ',' << gz.yaw << ',' << batch.x << ',' << batch.y << ',' <<
+          batch.yaw << '\n';
+      }
+      if (record + 1 == samples.size) {
+        position_error.add(std::hypot(batch.x - gz.x, batch.y - gz.y));
+        yaw_error.add(std::abs(robocap_sim::wrap(batch.yaw - gz.yaw)));
+      }
+    }
+  }
+
+  const double steps = static_cast<double>(options.segments) * records * options.record_every;
+  std::cout << options.segments << " segments of " << records * interval << " s: position error "
+    "mean " << position_error.mean() << " m, max " << position_error.max << " m; yaw error mean " <<
+    yaw_error.mean() << " rad, max " << yaw_error.max << " rad" << std::endl;
+  std::cout << "gazebo " << steps / std::chrono::duration<double>(gz_time).count() <<
+    " steps/s, batch sim " << steps / std::chrono::duration<double>(batch_time).count() <<
+    " steps/s for one robot" << std::endl;
+  if (options.tolerance > 0.0 && position_error.max > options.tolerance) {
+    std::cerr << "Position error above tolerance " << options.tolerance << " m" << std::endl;
+    return 1;
+  }
+  return 0;
+}
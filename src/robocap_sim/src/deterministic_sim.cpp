@@ -0,0 +1,256 @@
+// Reproducible robocap runs: the Ignition server and the ROS side of the stack in one process, on
+// one thread, advancing in lockstep. Each iteration steps physics once with the world's fixed step
+// and a seeded RNG, publishes the new sim time and runs every ROS callback that time or the step
+// made ready. A checksum of the world state after every step tells two runs apart at the first
+// iteration where they diverge.
+//
+// The process also acts as the component container, so launch files load the stack into it with
+// LoadComposableNodes. Stepping only starts once --components nodes are loaded.
+//
+// Usage: robocap_deterministic_sim --world <file.sdf> [--seed 1] [--steps 0] [--components 0]
+//                                  [--controllers "joint_state_broadcaster kiwi_drive_controller"]
+//                                  [--checksum-file <path>] [--ros-args ...]
+//
+// Pass the controller manager's parameter file as `--ros-args --params-file <file>`, the plugin
+// cannot add it once rclcpp is initialized. --steps 0 runs until shutdown.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ignition/gazebo/Server.hh"
+#include "ignition/gazebo/ServerConfig.hh"
+#include "ignition/gazebo/System.hh"
+#include "ignition/gazebo/components/Joint.hh"
+#include "ignition/gazebo/components/JointPosition.hh"
+#include "ignition/gazebo/components/JointVelocity.hh"
+#include "ignition/gazebo/components/Link.hh"
+#include "ignition/gazebo/components/Model.hh"
+#include "ignition/gazebo/components/Pose.hh"
+#include "rclcpp/rclcpp.hpp"
+#include "rclcpp_components/component_manager.hpp"
+
+#include "robocap_sim/sim_time_executor.hpp"
+
+namespace robocap_sim
+{
+
+namespace components = ignition::gazebo::components;
+
+// FNV-1a over the bit patterns of the model and link poses and the joint states after each step.
+// Entities are visited in ECM view order, i.e. by entity id, which only depends on the order the
+// world created them in.
+class StateChecksum
+  : public ignition::gazebo::System,
+  public ignition::gazebo::ISystemPostUpdate
+{
+public:
+  explicit StateChecksum(std::ostream * out)
+  : out_(out)
+  {
+  }
+
+  void PostUpdate(
+    const ignition::gazebo::UpdateInfo & info,
+    const ignition::gazebo::EntityComponentManager & ecm) override
+  {
+    sim_time_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(info.simTime).count();
+    if (info.paused) {
+      return;
+    }
+    hash_ = kOffsetBasis;
+    const auto add_pose = [this](const ignition::gazebo::Entity & entity,
+        const components::Pose * pose) {
+        const auto & p = pose->Data();
+        add(entity);
+        add(p.Pos().X());
+        add(p.Pos().Y());
+        add(p.Pos().Z());
+        add(p.Rot().W());
+        add(p.Rot().X());
+        add(p.Rot().Y());
+        add(p.Rot().Z());
+        return true;
+      };
+    ecm.Each<components::Model, components::Pose>(
+      [&](const ignition::gazebo::Entity & entity, const components::Model *,
+      const components::Pose * pose) {return add_pose(entity, pose);});
+    ecm.Each<components::Link, components::Pose>(
+      [&](const ignition::gazebo::Entity & entity, const components::Link *,
+      const components::Pose * pose) {return add_pose(entity, pose);});
+    ecm.Each<components::Joint>(
+      [&](const ignition::gazebo::Entity & entity, const components::Joint *) {
+        add(entity);
+        if (const auto * position = ecm.Component<components::JointPosition>(entity)) {
+          for (const double value : position->Data()) {
+            add(value);
+          }
+        }
+        if (const auto * velocity = ecm.Component<components::JointVelocity>(entity)) {
+          for (const double value : velocity->Data()) {
+            add(value);
+          }
+        }
+        return true;
+      });
+    if (out_) {
+      *out_ << info.iterations << ' ' << sim_time_ns_ << ' ' << hex(hash_) << '\n';
+    }
+  }
+
+  static std::string hex(std::uint64_t value)
+  {
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(value));
+    return text;
+  }
+
+  std::int64_t sim_time_ns() const {return sim_time_ns_;}
+  std::uint64_t checksum() const {return hash_;}
+
+private:
+  static constexpr std::uint64_t kOffsetBasis = 14695981039346656037ull;
+  static constexpr std::uint64_t kPrime = 1099511628211ull;
+
+  template<typename T>
+  void add(const T & value)
+  {
+    unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    for (const unsigned char byte : bytes) {
+      hash_ = (hash_ ^ byte) * kPrime;
+    }
+  }
+
+  std::ostream * out_;
+  std::int64_t sim_time_ns_ = 0;
+  std::uint64_t hash_ = kOffsetBasis;
+};
+
+// Component container whose nodes get /clock from the executor, in order with their other
+// callbacks, instead of from a clock thread of their own
+class DeterministicContainer : public rclcpp_components::ComponentManager
+{
+public:
+  using rclcpp_components::ComponentManager::ComponentManager;
+
+  std::size_t node_count() const {return node_wrappers_.size();}
+
+protected:
+  rclcpp::NodeOptions create_node_options(const std::shared_ptr<LoadNode::Request> request)
+  override
+  {
+    return ComponentManager::create_node_options(request).use_clock_thread(false);
+  }
+};
+
+namespace
+{
+
+struct Options
+{
+  std::string world;
+  std::string controllers = "joint_state_broadcaster kiwi_drive_controller";
+  std::string checksum_file;
+  unsigned int seed = 1;
+  std::uint64_t steps = 0;
+  std::size_t components = 0;
+};
+
+bool parse_options(const std::vector<std::string> & arguments, Options & options)
+{
+  for (std::size_t i = 1; i + 1 < arguments.size(); i += 2) {
+    const auto & flag = arguments[i];
+    const auto & value = arguments[i + 1];
+    if (flag == "--world") {
+      options.world = value;
+    } else if (flag == "--controllers") {
+      options.controllers = value;
+    } else if (flag == "--checksum-file") {
+      options.checksum_file = value;
+    } else if (flag == "--seed") {
+      options.seed = static_cast<unsigned int>(std::stoul(value));
+    } else if (flag == "--steps") {
+      options.steps = std::stoull(value);
+    } else if (flag == "--components") {
+      options.components = std::stoul(value);
+    } else {
+      std::cerr << "Unknown argument " << flag << std::endl;
+      return false;
+    }
+  }
+  return !options.world.empty();
+}
+
+}  // namespace
+
+}  // namespace robocap_sim
+
+int main(int argc, char ** argv)
+{
+  rclcpp::init(argc, argv);
+  robocap_sim::Options options;
+  if (!robocap_sim::parse_options(rclcpp::remove_ros_arguments(argc, argv), options)) {
+    std::cerr << "Usage: " << argv[0] << " --world <file.sdf> [--seed N] [--steps N]"
+      " [--components N] [--controllers \"name ...\"] [--checksum-file path]"
+      " [--ros-args ...]" << std::endl;
+    rclcpp::shutdown();
+    return 1;
+  }
+  // Read by robocap_control::GzControlPlugin when the robot is created
+  setenv("ROBOCAP_DETERMINISTIC_CONTROLLERS", options.controllers.c_str(), 1);
+
+  auto executor = std::make_shared<robocap_sim::SimTimeExecutor>();
+  auto container = std::make_shared<robocap_sim::DeterministicContainer>(
+    executor, "robocap_container");
+  executor->add_node(container);
+
+  std::ofstream checksum_file;
+  if (!options.checksum_file.empty()) {
+    checksum_file.open(options.checksum_file);
+  }
+  auto checksum = std::make_shared<robocap_sim::StateChecksum>(
+    checksum_file.is_open() ? &checksum_file : nullptr);
+
+  // The step size is the world's <max_step_size>, every Run() below is exactly one of them
+  ignition::gazebo::ServerConfig config;
+  config.SetSdfFile(options.world);
+  config.SetSeed(options.seed);
+  config.SetHeadlessRendering(true);
+  ignition::gazebo::Server server(config);
+  server.SetUpdatePeriod(std::chrono::nanoseconds(0));
+  server.AddSystem(checksum);
+  server.RunOnce(true);
+
+  // Loading happens over services from the launch process, so it is the one part that waits on
+  // wall time. Nothing steps before the whole stack is there.
+  while (rclcpp::ok() && container->node_count() < options.components) {
+    executor->drain();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  executor->advance(rclcpp::Time(checksum->sim_time_ns(), RCL_ROS_TIME));
+  std::cout << "Deterministic run of " << options.world << " with seed " << options.seed <<
+    ", " << container->node_count() << " components" << std::endl;
+
+  std::uint64_t step = 0;
+  while (rclcpp::ok() && (options.steps == 0 || step < options.steps)) {
+    server.Run(true, 1, false);
+    executor->advance(rclcpp::Time(checksum->sim_time_ns(), RCL_ROS_TIME));
+    ++step;
+  }
+
+  std::cout << "seed " << options.seed << " steps " << step << " checksum " <<
+    robocap_sim::StateChecksum::hex(checksum->checksum()) << std::endl;
+  executor->remove_node(container);
+  container.reset();
+  rclcpp::shutdown();
+  return 0;
+}
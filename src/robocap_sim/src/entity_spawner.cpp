@@ -0,0 +1,97 @@
+#include "robocap_sim/entity_spawner.hpp"
+
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include "ignition/msgs/boolean.pb.h"
+#include "ignition/msgs/entity_factory_v.pb.h"
+#include "ignition/msgs/Utility.hh"
+
+namespace robocap_sim
+{
+
+namespace
+{
+
+ignition::msgs::EntityFactory_V make_request(const std::vector<EntitySpec> & entities)
+{
+  ignition::msgs::EntityFactory_V request;
+  for (const auto & entity : entities) {
+    auto * factory = request.add_data();
+    // The server resolves model:// against its own resource path, so only the URI crosses over
+    factory->set_sdf_filename(entity.uri);
+    factory->set_name(entity.name);
+    factory->set_allow_renaming(true);
+    ignition::msgs::Set(factory->mutable_pose(), entity.pose);
+  }
+  return request;
+}
+
+}  // namespace
+
+EntitySpec parse_entity(const std::string & line)
+{
+  std::istringstream fields(line.substr(0, line.find('#')));
+  EntitySpec entity;
+  double x, y, z;
+  if (!(fields >> entity.name >> entity.uri >> x >> y >> z)) {
+    throw std::invalid_argument("Expected <name> <uri> <x> <y> <z>: '" + line + "'");
+  }
+  double roll = 0.0, pitch = 0.0, yaw = 0.0;
+  if (!(fields >> std::ws).eof() && !(fields >> roll >> pitch >> yaw)) {
+    throw std::invalid_argument("Expected <roll> <pitch> <yaw> after the position: '" + line + "'");
+  }
+  if (!(fields >> std::ws).eof()) {
+    throw std::invalid_argument("Unexpected fields after the pose: '" + line + "'");
+  }
+  entity.pose.Set(x, y, z, roll, pitch, yaw);
+  return entity;
+}
+
+std::vector<EntitySpec> parse_entities(std::istream & in)
+{
+  std::vector<EntitySpec> entities;
+  std::string line;
+  for (std::size_t number = 1; std::getline(in, line); ++number) {
+    const auto content = line.substr(0, line.find('#'));
+    if (content.find_first_not_of(" \t\r") == std::string::npos) {
+      continue;
+    }
+    try {
+      entities.push_back(parse_entity(content));
+    } catch (const std::invalid_argument & e) {
+      throw std::invalid_argument("Line " + std::to_string(number) + ": " + e.what());
+    }
+  }
+  return entities;
+}
+
+EntitySpawner::EntitySpawner(const std::string & world)
+: service_("/world/" + world + "/create_multiple")
+{
+}
+
+bool EntitySpawner::spawn_async(const std::vector<EntitySpec> & entities, Callback done)
+{
+  std::function<void(const ignition::msgs::Boolean &, const bool)> reply =
+    [done = std::move(done)](const ignition::msgs::Boolean & accepted, const bool result) {
+      if (done) {
+        done(result && accepted.data());
+      }
+    };
+  return node_.Request(service_, make_request(entities), reply);
+}
+
+bool EntitySpawner::spawn(
+  const std::vector<EntitySpec> & entities, std::chrono::milliseconds timeout)
+{
+  ignition::msgs::Boolean accepted;
+  bool result = false;
+  const bool replied = node_.Request(
+    service_, make_request(entities), static_cast<unsigned int>(timeout.count()), accepted,
+    result);
+  return replied && result && accepted.data();
+}
+
+}  // namespace robocap_sim
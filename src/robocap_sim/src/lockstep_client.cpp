@@ -0,0 +1,103 @@
+#include "robocap_sim/lockstep_client.hpp"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include "robocap_sim/lockstep_protocol.hpp"
+#include "socket_io.hpp"
+
+namespace robocap_sim
+{
+
+LockstepClient::~LockstepClient()
+{
+  disconnect();
+}
+
+bool LockstepClient::connect(const std::string & socket_path)
+{
+  disconnect();
+
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (socket_path.size() >= sizeof(address.sun_path)) {
+    return false;
+  }
+  std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+  fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd_ < 0) {
+    return false;
+  }
+  if (::connect(fd_, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0) {
+    disconnect();
+    return false;
+  }
+
+  lockstep::Handshake handshake{};
+  if (!read_exact(fd_, &handshake, sizeof(handshake)) || handshake.magic != lockstep::kMagic) {
+    disconnect();
+    return false;
+  }
+  step_size_ns_ = handshake.step_size_ns;
+  joint_names_.resize(handshake.joint_count);
+  char name[lockstep::kJointNameSize];
+  for (auto & joint_name : joint_names_) {
+    if (!read_exact(fd_, name, sizeof(name))) {
+      disconnect();
+      return false;
+    }
+    joint_name.assign(name, strnlen(name, sizeof(name)));
+  }
+  return true;
+}
+
+void LockstepClient::disconnect()
+{
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+bool LockstepClient::step(
+  std::uint32_t steps, std::uint32_t record_every, const std::vector<double> & velocity_commands,
+  LockstepSamples & samples)
+{
+  if (fd_ < 0 || (!velocity_commands.empty() && velocity_commands.size() != joint_names_.size())) {
+    return false;
+  }
+
+  const lockstep::StepRequest request{
+    lockstep::kMagic, steps, record_every, static_cast<std::uint32_t>(velocity_commands.size())};
+  if (!write_exact(fd_, &request, sizeof(request)) ||
+    !write_exact(fd_, velocity_commands.data(), velocity_commands.size() * sizeof(double)))
+  {
+    return false;
+  }
+
+  lockstep::StepReply reply{};
+  if (!read_exact(fd_, &reply, sizeof(reply)) || reply.magic != lockstep::kMagic ||
+    reply.joint_count != joint_names_.size())
+  {
+    return false;
+  }
+
+  const std::size_t n = reply.sample_count;
+  const std::size_t joints = reply.joint_count;
+  samples.size = n;
+  samples.iterations = reply.iterations;
+  samples.sim_time_ns.resize(n);
+  samples.base_pose.resize(n * lockstep::kPoseSize);
+  samples.joint_position.resize(n * joints);
+  samples.joint_velocity.resize(n * joints);
+  return read_exact(fd_, samples.sim_time_ns.data(), n * sizeof(std::int64_t)) &&
+         read_exact(fd_, samples.base_pose.data(), n * lockstep::kPoseSize * sizeof(double)) &&
+         read_exact(fd_, samples.joint_position.data(), n * joints * sizeof(double)) &&
+         read_exact(fd_, samples.joint_velocity.data(), n * joints * sizeof(double));
+}
+
+}  // namespace robocap_sim
@@ -0,0 +1,350 @@
+// Headless Ignition server that only advances the world when a LockstepClient asks it to. It runs
+// N physics iterations per request as fast as the CPU allows and answers with the joint states and
+// base pose of the whole batch in one reply.
+//
+// Usage: robocap_lockstep_server --world <file.sdf> [--socket <path>] [--model <name>]
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ignition/gazebo/Server.hh"
+#include "ignition/gazebo/ServerConfig.hh"
+#include "ignition/gazebo/System.hh"
+#include "ignition/gazebo/components/Joint.hh"
+#include "ignition/gazebo/components/JointPosition.hh"
+#include "ignition/gazebo/components/JointVelocity.hh"
+#include "ignition/gazebo/components/JointVelocityCmd.hh"
+#include "ignition/gazebo/components/Model.hh"
+#include "ignition/gazebo/components/Name.hh"
+#include "ignition/gazebo/components/ParentEntity.hh"
+#include "ignition/gazebo/components/Physics.hh"
+#include "ignition/gazebo/components/Pose.hh"
+#include "ignition/gazebo/components/World.hh"
+
+#include "robocap_sim/lockstep_protocol.hpp"
+#include "socket_io.hpp"
+
+namespace robocap_sim
+{
+
+namespace components = ignition::gazebo::components;
+
+// Records the robot state after each physics step and applies the latest velocity commands
+class LockstepRecorder
+  : public ignition::gazebo::System,
+  public ignition::gazebo::ISystemPreUpdate,
+  public ignition::gazebo::ISystemPostUpdate
+{
+public:
+  explicit LockstepRecorder(std::string model_name)
+  : model_name_(std::move(model_name))
+  {
+  }
+
+  void PreUpdate(
+    const ignition::gazebo::UpdateInfo & /*info*/,
+    ignition::gazebo::EntityComponentManager & ecm) override
+  {
+    if (model_ == ignition::gazebo::kNullEntity) {
+      resolve(ecm);
+    }
+    if (!has_commands_) {
+      return;
+    }
+    for (std::size_t i = 0; i < joints_.size(); ++i) {
+      auto * command = ecm.Component<components::JointVelocityCmd>(joints_[i]);
+      if (!command) {
+        ecm.CreateComponent(joints_[i], components::JointVelocityCmd({commands_[i]}));
+      } else {
+        command->Data()[0] = commands_[i];
+      }
+    }
+  }
+
+  void PostUpdate(
+    const ignition::gazebo::UpdateInfo & info,
+    const ignition::gazebo::EntityComponentManager & ecm) override
+  {
+    iterations_ = info.iterations;
+    if (info.paused || model_ == ignition::gazebo::kNullEntity) {
+      return;
+    }
+    ++batch_iteration_;
+    const bool last = batch_iteration_ == batch_steps_;
+    const bool record = record_every_ == 0 ? last : batch_iteration_ % record_every_ == 0;
+    if (!record) {
+      return;
+    }
+
+    sim_time_ns_.push_back(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(info.simTime).count());
+    const auto * pose = ecm.Component<components::Pose>(model_);
+    const auto & p = pose ? pose->Data() : ignition::math::Pose3d::Zero;
+    const double values[lockstep::kPoseSize] = {p.Pos().X(), p.Pos().Y(), p.Pos().Z(),
+      p.Rot().W(), p.Rot().X(), p.Rot().Y(), p.Rot().Z()};
+    base_pose_.insert(base_pose_.end(), values, values + lockstep::kPoseSize);
+    for (const auto joint : joints_) {
+      const auto * position = ecm.Component<components::JointPosition>(joint);
+      const auto * velocity = ecm.Component<components::JointVelocity>(joint);
+      joint_position_.push_back(
+        position && !position->Data().empty() ? position->Data()[0] : 0.0);
+      joint_velocity_.push_back(
+        velocity && !velocity->Data().empty() ? velocity->Data()[0] : 0.0);
+    }
+  }
+
+  // Clears the sample buffers and prepares for a batch of `steps` iterations. Capacity is kept,
+  // so repeated batches of the same size do not allocate inside the physics loop.
+  void begin_batch(std::uint32_t steps, std::uint32_t record_every)
+  {
+    batch_steps_ = steps;
+    batch_iteration_ = 0;
+    record_every_ = record_every;
+    const std::size_t samples = record_every == 0 ? 1 : steps / record_every;
+    sim_time_ns_.clear();
+    sim_time_ns_.reserve(samples);
+    base_pose_.clear();
+    base_pose_.reserve(samples * lockstep::kPoseSize);
+    joint_position_.clear();
+    joint_position_.reserve(samples * joints_.size());
+    joint_velocity_.clear();
+    joint_velocity_.reserve(samples * joints_.size());
+  }
+
+  void set_commands(const std::vector<double> & commands)
+  {
+    commands_ = commands;
+    has_commands_ = true;
+  }
+
+  bool ready() const {return model_ != ignition::gazebo::kNullEntity;}
+  const std::vector<std::string> & joint_names() const {return joint_names_;}
+  std::int64_t step_size_ns() const {return step_size_ns_;}
+  std::uint64_t iterations() const {return iterations_;}
+  std::size_t sample_count() const {return sim_time_ns_.size();}
+  const std::vector<std::int64_t> & sim_time_ns() const {return sim_time_ns_;}
+  const std::vector<double> & base_pose() const {return base_pose_;}
+  const std::vector<double> & joint_position() const {return joint_position_;}
+  const std::vector<double> & joint_velocity() const {return joint_velocity_;}
+
+private:
+  void resolve(ignition::gazebo::EntityComponentManager & ecm)
+  {
+    model_ = ecm.EntityByComponents(components::Model(), components::Name(model_name_));
+    if (model_ == ignition::gazebo::kNullEntity) {
+      return;
+    }
+
+    std::vector<std::pair<std::string, ignition::gazebo::Entity>> joints;
+    ecm.Each<components::Joint, components::Name, components::ParentEntity>(
+      [&](const ignition::gazebo::Entity & entity, const components::Joint *,
+      const components::Name * name, const components::ParentEntity * parent) {
+        if (parent->Data() == model_) {
+          joints.emplace_back(name->Data(), entity);
+        }
+        return true;
+      });
+    // Sorted so the order in the reply does not depend on the order entities were created in
+    std::sort(joints.begin(), joints.end());
+    for (const auto & [name, entity] : joints) {
+      joint_names_.push_back(name);
+      joints_.push_back(entity);
+      if (!ecm.Component<components::JointPosition>(entity)) {
+        ecm.CreateComponent(entity, components::JointPosition({0.0}));
+      }
+      if (!ecm.Component<components::JointVelocity>(entity)) {
+        ecm.CreateComponent(entity, components::JointVelocity({0.0}));
+      }
+    }
+    commands_.assign(joints_.size(), 0.0);
+
+    const auto world = ecm.EntityByComponents(components::World());
+    if (const auto * physics = ecm.Component<components::Physics>(world)) {
+      step_size_ns_ = std::llround(physics->Data().MaxStepSize() * 1e9);
+    }
+  }
+
+  std::string model_name_;
+  ignition::gazebo::Entity model_ = ignition::gazebo::kNullEntity;
+  std::vector<std::string> joint_names_;
+  std::vector<ignition::gazebo::Entity> joints_;
+  std::int64_t step_size_ns_ = 0;
+
+  std::vector<double> commands_;
+  bool has_commands_ = false;
+
+  std::uint64_t iterations_ = 0;
+  std::uint32_t batch_steps_ = 0;
+  std::uint32_t batch_iteration_ = 0;
+  std::uint32_t record_every_ = 0;
+  std::vector<std::int64_t> sim_time_ns_;
+  std::vector<double> base_pose_;
+  std::vector<double> joint_position_;
+  std::vector<double> joint_velocity_;
+};
+
+namespace
+{
+
+int listen_on(const std::string & path)
+{
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    return -1;
+  }
+  std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+  ::unlink(path.c_str());
+
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  if (::bind(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 ||
+    ::listen(fd, 1) != 0)
+  {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+bool send_handshake(int fd, const LockstepRecorder & recorder)
+{
+  const lockstep::Handshake handshake{
+    lockstep::kMagic, static_cast<std::uint32_t>(recorder.joint_names().size()),
+    recorder.step_size_ns()};
+  if (!write_exact(fd, &handshake, sizeof(handshake))) {
+    return false;
+  }
+  for (const auto & joint_name : recorder.joint_names()) {
+    char name[lockstep::kJointNameSize] = {};
+    std::strncpy(name, joint_name.c_str(), sizeof(name) - 1);
+    if (!write_exact(fd, name, sizeof(name))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void serve(int fd, ignition::gazebo::Server & server, LockstepRecorder & recorder)
+{
+  const std::size_t joints = recorder.joint_names().size();
+  std::vector<double> commands;
+  lockstep::StepRequest request{};
+  while (read_exact(fd, &request, sizeof(request)) && request.magic == lockstep::kMagic) {
+    if (request.command_count != 0) {
+      if (request.command_count != joints) {
+        std::cerr << "Expected " << joints << " commands, got " << request.command_count <<
+          std::endl;
+        return;
+      }
+      commands.resize(joints);
+      if (!read_exact(fd, commands.data(), joints * sizeof(double))) {
+        return;
+      }
+      recorder.set_commands(commands);
+    }
+
+    recorder.begin_batch(request.steps, request.record_every);
+    if (request.steps > 0) {
+      server.Run(true, request.steps, false);
+    }
+
+    const std::size_t n = recorder.sample_count();
+    const lockstep::StepReply reply{
+      lockstep::kMagic, static_cast<std::uint32_t>(n), static_cast<std::uint32_t>(joints), 0,
+      recorder.iterations()};
+    if (!write_exact(fd, &reply, sizeof(reply)) ||
+      !write_exact(fd, recorder.sim_time_ns().data(), n * sizeof(std::int64_t)) ||
+      !write_exact(fd, recorder.base_pose().data(), n * lockstep::kPoseSize * sizeof(double)) ||
+      !write_exact(fd, recorder.joint_position().data(), n * joints * sizeof(double)) ||
+      !write_exact(fd, recorder.joint_velocity().data(), n * joints * sizeof(double)))
+    {
+      return;
+    }
+  }
+}
+
+}  // namespace
+
+}  // namespace robocap_sim
+
+int main(int argc, char ** argv)
+{
+  std::string world_file;
+  std::string socket_path = "/tmp/robocap_lockstep.sock";
+  std::string model_name = "robot";
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string flag = argv[i];
+    if (flag == "--world") {
+      world_file = argv[i + 1];
+    } else if (flag == "--socket") {
+      socket_path = argv[i + 1];
+    } else if (flag == "--model") {
+      model_name = argv[i + 1];
+    } else {
+      std::cerr << "Unknown argument " << flag << std::endl;
+      return 1;
+    }
+  }
+  if (world_file.empty()) {
+    std::cerr << "Usage: " << argv[0] <<
+      " --world <file.sdf> [--socket <path>] [--model <name>]" << std::endl;
+    return 1;
+  }
+
+  ignition::gazebo::ServerConfig config;
+  config.SetSdfFile(world_file);
+  config.SetHeadlessRendering(true);
+  ignition::gazebo::Server server(config);
+  // No wall-clock throttling, every Run() goes as fast as physics allows
+  server.SetUpdatePeriod(std::chrono::nanoseconds(0));
+
+  auto recorder = std::make_shared<robocap_sim::LockstepRecorder>(model_name);
+  server.AddSystem(recorder);
+  // One paused iteration lets the recorder find the model and its joints before any client asks
+  server.RunOnce(true);
+  if (!recorder->ready()) {
+    std::cerr << "Model [" << model_name << "] not found in " << world_file << std::endl;
+    return 1;
+  }
+
+  const int listen_fd = robocap_sim::listen_on(socket_path);
+  if (listen_fd < 0) {
+    std::cerr << "Failed to listen on " << socket_path << ": " << std::strerror(errno) <<
+      std::endl;
+    return 1;
+  }
+  std::cout << "Lockstep server for [" << model_name << "] listening on " << socket_path <<
+    std::endl;
+
+  while (true) {
+    const int client_fd = ::accept(listen_fd, nullptr, nullptr);
+    if (client_fd < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    if (robocap_sim::send_handshake(client_fd, *recorder)) {
+      robocap_sim::serve(client_fd, server, *recorder);
+    }
+    ::close(client_fd);
+  }
+  ::close(listen_fd);
+  ::unlink(socket_path.c_str());
+  return 0;
+}
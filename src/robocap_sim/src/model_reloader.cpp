@@ -0,0 +1,210 @@
+#include "robocap_sim/model_reloader.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <utility>
+
+#include "ignition/common/Console.hh"
+#include "ignition/gazebo/Link.hh"
+#include "ignition/gazebo/Model.hh"
+#include "ignition/gazebo/components/Inertial.hh"
+#include "ignition/gazebo/components/Model.hh"
+#include "ignition/gazebo/components/Name.hh"
+#include "ignition/gazebo/components/ParentEntity.hh"
+#include "ignition/gazebo/components/World.hh"
+#include "ignition/plugin/Register.hh"
+#include "sdf/Collision.hh"
+#include "sdf/Joint.hh"
+#include "sdf/Link.hh"
+
+namespace robocap_sim
+{
+
+namespace components = ignition::gazebo::components;
+
+namespace
+{
+
+// How long a reply waits for the next update to apply the request
+constexpr auto kReplyTimeout = std::chrono::seconds(2);
+
+// As written in the SDF, so that two descriptions compare without their frame graphs
+bool same_pose(const sdf::SemanticPose & a, const sdf::SemanticPose & b)
+{
+  return a.RawPose() == b.RawPose() && a.RelativeTo() == b.RelativeTo();
+}
+
+// Sets `entity`'s ComponentT to `value` if it has one that differs, true if it did
+template<typename ComponentT, typename DataT>
+bool patch_component(
+  ignition::gazebo::EntityComponentManager & ecm, ignition::gazebo::Entity entity,
+  const DataT & value)
+{
+  auto * component = ecm.Component<ComponentT>(entity);
+  if (component == nullptr || component->Data() == value) {
+    return false;
+  }
+  component->Data() = value;
+  ecm.SetChanged(entity, ComponentT::typeId, ignition::gazebo::ComponentState::OneTimeChange);
+  return true;
+}
+
+// sdf::Collision has no equality, and its surface only exposes part of <surface>, e.g. not kp/kd
+std::string element_text(const sdf::Collision & collision)
+{
+  return collision.Element() ? collision.Element()->ToString("") : std::string{};
+}
+
+}  // namespace
+
+std::string reload_service(const std::string & world)
+{
+  return "/world/" + world + "/reload_model";
+}
+
+ModelPatch patch_model(
+  ignition::gazebo::EntityComponentManager & ecm, ignition::gazebo::Entity model,
+  const sdf::Model & sdf)
+{
+  const ignition::gazebo::Model running(model);
+  // SdfEntityCreator keeps the description the model was created from
+  const auto * spawned_component = ecm.Component<components::ModelSdf>(model);
+  const sdf::Model * spawned = spawned_component ? &spawned_component->Data() : nullptr;
+  ModelPatch patch;
+  for (std::uint64_t i = 0; i < sdf.LinkCount(); ++i) {
+    const auto * link_sdf = sdf.LinkByIndex(i);
+    const ignition::gazebo::Link link(running.LinkByName(ecm, link_sdf->Name()));
+    if (!link.Valid(ecm)) {
+      continue;
+    }
+    patch.inertials +=
+      patch_component<components::Inertial>(ecm, link.Entity(), link_sdf->Inertial());
+
+    const auto * spawned_link = spawned ? spawned->LinkByName(link_sdf->Name()) : nullptr;
+    if (spawned_link == nullptr) {
+      continue;
+    }
+    patch.poses += !same_pose(link_sdf->SemanticPose(), spawned_link->SemanticPose());
+    for (std::uint64_t c = 0; c < link_sdf->CollisionCount(); ++c) {
+      const auto * collision_sdf = link_sdf->CollisionByIndex(c);
+      const auto * spawned_collision = spawned_link->CollisionByName(collision_sdf->Name());
+      patch.collisions += spawned_collision != nullptr &&
+        element_text(*spawned_collision) != element_text(*collision_sdf);
+    }
+  }
+
+  for (std::uint64_t i = 0; i < sdf.JointCount(); ++i) {
+    const auto * joint_sdf = sdf.JointByIndex(i);
+    const auto * spawned_joint = spawned ? spawned->JointByName(joint_sdf->Name()) : nullptr;
+    patch.poses += spawned_joint != nullptr &&
+      !same_pose(joint_sdf->SemanticPose(), spawned_joint->SemanticPose());
+  }
+  return patch;
+}
+
+std::string describe(const std::string & model, const ModelPatch & patch)
+{
+  std::ostringstream text;
+  text << "Patched [" << model << "]: " << patch.inertials << " inertials";
+  if (patch.respawn() > 0) {
+    text << "; needs a respawn: " << patch.poses << " poses, " << patch.collisions <<
+      " collisions";
+  }
+  return text.str();
+}
+
+void ModelReloader::Configure(
+  const ignition::gazebo::Entity & entity, const std::shared_ptr<const sdf::Element> & /*sdf*/,
+  ignition::gazebo::EntityComponentManager & ecm, ignition::gazebo::EventManager & event_manager)
+{
+  const auto * name = ecm.Component<components::Name>(entity);
+  if (!ecm.Component<components::World>(entity) || name == nullptr) {
+    ignerr << "ModelReloader must be attached to a world" << std::endl;
+    return;
+  }
+  world_ = entity;
+  event_manager_ = &event_manager;
+
+  const auto service = reload_service(name->Data());
+  if (!node_.Advertise(service, &ModelReloader::on_reload, this)) {
+    ignerr << "ModelReloader: failed to advertise [" << service << "]" << std::endl;
+    return;
+  }
+  ignmsg << "ModelReloader: reloading models from [" << service << "]" << std::endl;
+}
+
+bool ModelReloader::on_reload(
+  const ignition::msgs::StringMsg & request, ignition::msgs::StringMsg & reply)
+{
+  auto root = std::make_unique<sdf::Root>();
+  const auto errors = root->LoadSdfString(request.data());
+  if (!errors.empty() || root->Model() == nullptr) {
+    std::ostringstream message;
+    message << "Not a model SDF";
+    for (const auto & error : errors) {
+      message << "\n" << error;
+    }
+    reply.set_data(message.str());
+    return false;
+  }
+  const auto name = root->Model()->Name();
+
+  auto pending = std::make_unique<Pending>();
+  pending->root = std::move(root);
+  auto result = pending->result.get_future();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_) {
+      pending_->result.set_value("Superseded by a newer request for [" + name + "]");
+    }
+    pending_ = std::move(pending);
+  }
+  // A paused world still runs its updates, a blocked one leaves the request queued
+  if (result.wait_for(kReplyTimeout) == std::future_status::ready) {
+    reply.set_data(result.get());
+  } else {
+    reply.set_data("Reloading [" + name + "] on the next update");
+  }
+  return true;
+}
+
+void ModelReloader::PreUpdate(
+  const ignition::gazebo::UpdateInfo & /*info*/, ignition::gazebo::EntityComponentManager & ecm)
+{
+  std::unique_ptr<Pending> pending;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending = std::move(pending_);
+  }
+  if (!pending) {
+    return;
+  }
+
+  const auto & sdf = *pending->root->Model();
+  const auto model = ecm.EntityByComponents(
+    components::Model(), components::Name(sdf.Name()), components::ParentEntity(world_));
+  if (model == ignition::gazebo::kNullEntity) {
+    const auto message = "No model [" + sdf.Name() + "] in the world";
+    ignerr << "ModelReloader: " << message << std::endl;
+    pending->result.set_value(message);
+    return;
+  }
+
+  const auto patch = patch_model(ecm, model, sdf);
+  event_manager_->Emit<ModelReloaded>(ecm, model, sdf);
+  const auto message = describe(sdf.Name(), patch);
+  ignmsg << message << std::endl;
+  if (patch.inertials > 0) {
+    ignwarn << "Physics keeps the inertia it created [" << sdf.Name() << "] with until the " <<
+      "model is spawned again, systems reading the ECM see the new one" << std::endl;
+  }
+  pending->result.set_value(message);
+}
+
+}  // namespace robocap_sim
+
+IGNITION_ADD_PLUGIN(
+  robocap_sim::ModelReloader, ignition::gazebo::System,
+  robocap_sim::ModelReloader::ISystemConfigure,
+  robocap_sim::ModelReloader::ISystemPreUpdate)
@@ -0,0 +1,121 @@
+#include "robocap_sim/model_spawner.hpp"
+
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
+
+#include "ignition/common/Console.hh"
+#include "ignition/gazebo/SdfEntityCreator.hh"
+#include "ignition/gazebo/components/World.hh"
+#include "ignition/plugin/Register.hh"
+#include "sdf/Model.hh"
+#include "sdf/Root.hh"
+
+namespace robocap_sim
+{
+
+namespace
+{
+
+constexpr char kModelScheme[] = "model://";
+
+std::string model_file_in(const std::filesystem::path & path)
+{
+  std::error_code error;
+  if (std::filesystem::is_directory(path, error)) {
+    const auto file = path / "model.sdf";
+    return std::filesystem::is_regular_file(file, error) ? file.string() : std::string{};
+  }
+  return std::filesystem::is_regular_file(path, error) ? path.string() : std::string{};
+}
+
+}  // namespace
+
+std::string resolve_model_file(const std::string & uri)
+{
+  if (uri.rfind(kModelScheme, 0) != 0) {
+    return model_file_in(uri);
+  }
+  const auto relative = uri.substr(sizeof(kModelScheme) - 1);
+  const char * resource_path = std::getenv("IGN_GAZEBO_RESOURCE_PATH");
+  if (resource_path == nullptr) {
+    return {};
+  }
+  std::istringstream paths(resource_path);
+  std::string directory;
+  while (std::getline(paths, directory, ':')) {
+    if (directory.empty()) {
+      continue;
+    }
+    const auto file = model_file_in(std::filesystem::path(directory) / relative);
+    if (!file.empty()) {
+      return file;
+    }
+  }
+  return {};
+}
+
+ignition::gazebo::Entity spawn_model(
+  ignition::gazebo::EntityComponentManager & ecm, ignition::gazebo::EventManager & event_manager,
+  ignition::gazebo::Entity world, const std::string & file, const std::string & name,
+  const ignition::math::Pose3d & pose)
+{
+  sdf::Root root;
+  const auto errors = root.Load(file);
+  if (!errors.empty() || root.Model() == nullptr) {
+    ignerr << "Failed to load model [" << file << "]" << std::endl;
+    for (const auto & error : errors) {
+      ignerr << error << std::endl;
+    }
+    return ignition::gazebo::kNullEntity;
+  }
+
+  sdf::Model model = *root.Model();
+  if (!name.empty()) {
+    model.SetName(name);
+  }
+  model.SetRawPose(pose);
+
+  // Same path the UserCommands create service takes, minus the transport and the SDF string copy.
+  // Model plugins (e.g. GzControlPlugin) are loaded through the LoadPlugins event it emits.
+  ignition::gazebo::SdfEntityCreator creator(ecm, event_manager);
+  const auto entity = creator.CreateEntities(&model);
+  creator.SetParent(entity, world);
+  return entity;
+}
+
+void ModelSpawner::Configure(
+  const ignition::gazebo::Entity & entity, const std::shared_ptr<const sdf::Element> & sdf,
+  ignition::gazebo::EntityComponentManager & ecm, ignition::gazebo::EventManager & event_manager)
+{
+  if (!ecm.Component<ignition::gazebo::components::World>(entity)) {
+    ignerr << "ModelSpawner must be attached to a world" << std::endl;
+    return;
+  }
+
+  for (auto element = sdf->FindElement("model"); element;
+    element = element->GetNextElement("model"))
+  {
+    const auto uri = element->Get<std::string>("uri");
+    const auto file = resolve_model_file(uri);
+    if (file.empty()) {
+      ignerr << "Could not resolve model [" << uri << "], is IGN_GAZEBO_RESOURCE_PATH set?" <<
+        std::endl;
+      continue;
+    }
+    const auto name = element->Get<std::string>("name", "").first;
+    const auto pose = element->Get<ignition::math::Pose3d>("pose", {}).first;
+    if (spawn_model(ecm, event_manager, entity, file, name, pose) !=
+      ignition::gazebo::kNullEntity)
+    {
+      ignmsg << "Spawned [" << (name.empty() ? uri : name) << "] from [" << file << "]" <<
+        std::endl;
+    }
+  }
+}
+
+}  // namespace robocap_sim
+
+IGNITION_ADD_PLUGIN(
+  robocap_sim::ModelSpawner, ignition::gazebo::System,
+  robocap_sim::ModelSpawner::ISystemConfigure)
@@ -0,0 +1,191 @@
+#include "robocap_sim/omni_wheel_contact.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+#include "ignition/common/Console.hh"
+#include "ignition/gazebo/Link.hh"
+#include "ignition/gazebo/Model.hh"
+#include "ignition/gazebo/Util.hh"
+#include "ignition/gazebo/components/ContactSensorData.hh"
+#include "ignition/gazebo/components/Gravity.hh"
+#include "ignition/gazebo/components/Inertial.hh"
+#include "ignition/gazebo/components/Link.hh"
+#include "ignition/plugin/Register.hh"
+#include "robocap_sim/model_reloader.hpp"
+
+namespace robocap_sim
+{
+
+namespace components = ignition::gazebo::components;
+
+namespace
+{
+
+// Fraction of the slip velocity the traction force may remove in one step. Below 1 the explicit
+// update cannot overshoot, 0.5 leaves margin for the three wheels coupling through the chassis.
+constexpr double kSlipCorrection = 0.5;
+
+}  // namespace
+
+void OmniWheelContact::Configure(
+  const ignition::gazebo::Entity & entity, const std::shared_ptr<const sdf::Element> & sdf,
+  ignition::gazebo::EntityComponentManager & ecm,
+  ignition::gazebo::EventManager & event_manager)
+{
+  const ignition::gazebo::Model model(entity);
+  if (!model.Valid(ecm)) {
+    ignerr << "OmniWheelContact must be attached to a model" << std::endl;
+    return;
+  }
+  model_ = entity;
+  read_parameters(*sdf);
+
+  auto element = sdf->FindElement("wheel");
+  while (element) {
+    const auto name = element->Get<std::string>();
+    const ignition::gazebo::Link link(model.LinkByName(ecm, name));
+    if (!link.Valid(ecm)) {
+      ignerr << "OmniWheelContact: link [" << name << "] not found" << std::endl;
+      wheels_.clear();
+      return;
+    }
+    Wheel wheel{link.Entity(), link.Collisions(ecm)};
+    // Physics only reports contacts for collisions that carry this component
+    for (const auto collision : wheel.collisions) {
+      if (!ecm.Component<components::ContactSensorData>(collision)) {
+        ecm.CreateComponent(collision, components::ContactSensorData());
+      }
+    }
+    link.EnableVelocityChecks(ecm, true);
+    wheels_.push_back(wheel);
+    element = element->GetNextElement("wheel");
+  }
+
+  update_mass(ecm);
+  reloaded_connection_ = event_manager.Connect<ModelReloaded>(
+    [this](
+      const ignition::gazebo::EntityComponentManager & reloaded_ecm,
+      ignition::gazebo::Entity model, const sdf::Model & model_sdf) {
+      if (model == model_) {
+        on_reloaded(reloaded_ecm, model_sdf);
+      }
+    });
+  ignmsg << "OmniWheelContact: " << wheels_.size() << " wheels, model mass " << mass_ << " kg" <<
+    std::endl;
+}
+
+void OmniWheelContact::read_parameters(const sdf::Element & sdf)
+{
+  radius_ = sdf.Get<double>("radius", radius_).first;
+  axis_ = sdf.Get<ignition::math::Vector3d>("axis", axis_).first.Normalized();
+  mu_ = sdf.Get<double>("mu", mu_).first;
+  roller_drag_ = sdf.Get<double>("roller_drag", roller_drag_).first;
+}
+
+void OmniWheelContact::update_mass(const ignition::gazebo::EntityComponentManager & ecm)
+{
+  mass_ = 0.0;
+  for (const auto link : ecm.ChildrenByComponents(model_, components::Link())) {
+    if (const auto * inertial = ecm.Component<components::Inertial>(link)) {
+      mass_ += inertial->Data().MassMatrix().Mass();
+    }
+  }
+}
+
+void OmniWheelContact::on_reloaded(
+  const ignition::gazebo::EntityComponentManager & ecm, const sdf::Model & sdf)
+{
+  const auto model = sdf.Element();
+  for (auto plugin = model ? model->FindElement("plugin") : nullptr; plugin;
+    plugin = plugin->GetNextElement("plugin"))
+  {
+    if (plugin->Get<std::string>("name") == "robocap_sim::OmniWheelContact") {
+      read_parameters(*plugin);
+      break;
+    }
+  }
+  update_mass(ecm);
+  ignmsg << "OmniWheelContact: reloaded, mu " << mu_ << ", roller drag " << roller_drag_ <<
+    ", model mass " << mass_ << " kg" << std::endl;
+}
+
+bool OmniWheelContact::in_contact(
+  const Wheel & wheel, const ignition::gazebo::EntityComponentManager & ecm) const
+{
+  for (const auto collision : wheel.collisions) {
+    const auto * data = ecm.Component<components::ContactSensorData>(collision);
+    if (data && data->Data().contact_size() > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void OmniWheelContact::PreUpdate(
+  const ignition::gazebo::UpdateInfo & info, ignition::gazebo::EntityComponentManager & ecm)
+{
+  const double dt = std::chrono::duration<double>(info.dt).count();
+  if (info.paused || dt <= 0.0 || wheels_.empty()) {
+    return;
+  }
+
+  std::size_t touching = 0;
+  for (const auto & wheel : wheels_) {
+    touching += in_contact(wheel, ecm) ? 1 : 0;
+  }
+  if (touching == 0) {
+    return;
+  }
+
+  // Flat ground assumed: load is shared evenly by the wheels that touch it, "up" opposes gravity
+  ignition::math::Vector3d gravity(0.0, 0.0, -9.81);
+  if (const auto * world_gravity =
+    ecm.Component<components::Gravity>(ignition::gazebo::worldEntity(ecm)))
+  {
+    gravity = world_gravity->Data();
+  }
+  const auto up = -gravity.Normalized();
+  const double normal_force = mass_ * gravity.Length() / static_cast<double>(touching);
+  const double max_force = mu_ * normal_force;
+  const double slip_gain = kSlipCorrection * mass_ / static_cast<double>(touching) / dt;
+
+  for (const auto & wheel : wheels_) {
+    if (!in_contact(wheel, ecm)) {
+      continue;
+    }
+    const ignition::gazebo::Link link(wheel.link);
+    const auto linear = link.WorldLinearVelocity(ecm);
+    const auto angular = link.WorldAngularVelocity(ecm);
+    if (!linear || !angular) {
+      continue;  // Velocities appear after the first physics step
+    }
+    const auto pose = ignition::gazebo::worldPose(wheel.link, ecm);
+    const auto axle = pose.Rot().RotateVector(axis_);
+    auto rolling = axle.Cross(up);
+    if (rolling.Length() < 1e-6) {
+      continue;  // Wheel lying flat, no rolling direction
+    }
+    rolling.Normalize();
+    const auto lateral = up.Cross(rolling);
+
+    // Velocity of the rim point touching the ground, spin included
+    const auto contact_offset = -up * radius_;
+    const auto contact_velocity = *linear + angular->Cross(contact_offset);
+
+    const double traction =
+      std::clamp(-slip_gain * contact_velocity.Dot(rolling), -max_force, max_force);
+    const double drag =
+      std::clamp(-roller_drag_ * contact_velocity.Dot(lateral), -max_force, max_force);
+    link.AddWorldForce(
+      ecm, rolling * traction + lateral * drag, pose.Rot().RotateVectorReverse(contact_offset));
+  }
+}
+
+}  // namespace robocap_sim
+
+IGNITION_ADD_PLUGIN(
+  robocap_sim::OmniWheelContact, ignition::gazebo::System,
+  robocap_sim::OmniWheelContact::ISystemConfigure,
+  robocap_sim::OmniWheelContact::ISystemPreUpdate)
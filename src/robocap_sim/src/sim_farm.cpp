@@ -0,0 +1,516 @@
+// Runs randomized robocap scenarios on N isolated headless Ignition instances, one per CPU core.
+//
+// Each worker is a forked process pinned to its own core with its own IGN_PARTITION and
+// ROS_DOMAIN_ID, so instances never see each other's transport traffic. Workers pull scenario
+// indices from a shared counter and push results into a lock-free ring in shared memory, which the
+// parent drains and writes out as JSON lines.
+//
+// --entities spawns the models listed in a file (see robocap_sim::parse_entities) into every
+// instance in one batched request before its first scenario, e.g. obstacles, or the robot itself
+// in a world without a ModelSpawner.
+//
+// Usage: robocap_sim_farm --world <file.sdf> [--scenarios 100] [--instances <cores>]
+//                         [--duration 10] [--seed 1] [--spawn-radius 2] [--domain-base 10]
+//                         [--model robot] [--entities <file>] [--output results.jsonl]
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ignition/gazebo/Model.hh"
+#include "ignition/gazebo/Server.hh"
+#include "ignition/gazebo/ServerConfig.hh"
+#include "ignition/gazebo/System.hh"
+#include "ignition/gazebo/Util.hh"
+#include "ignition/gazebo/components/JointPositionReset.hh"
+#include "ignition/gazebo/components/JointType.hh"
+#include "ignition/gazebo/components/JointVelocityCmd.hh"
+#include "ignition/gazebo/components/JointVelocityReset.hh"
+#include "ignition/gazebo/components/Model.hh"
+#include "ignition/gazebo/components/Name.hh"
+#include "ignition/gazebo/components/Physics.hh"
+#include "ignition/gazebo/components/Pose.hh"
+#include "ignition/gazebo/components/PoseCmd.hh"
+#include "robocap_kinematics/robocap_layout.hpp"
+
+#include "robocap_sim/entity_spawner.hpp"
+#include "robocap_sim/shm_ring.hpp"
+
+namespace robocap_sim
+{
+
+namespace components = ignition::gazebo::components;
+
+namespace
+{
+
+constexpr std::size_t kResultRingSize = 1024;
+constexpr double kSpawnHeight = 0.1;   // Same offset the old `ros_gz_sim create -z 0.1` used
+constexpr double kMaxLinear = 1.0;     // [m/s] sampled command range
+constexpr double kMaxAngular = 1.5;    // [rad/s]
+constexpr double kSettleTime = 0.5;  // [s] of zero commands between scenarios
+constexpr auto kSpawnTimeout = std::chrono::seconds(5);
+// UserCommands creates a spawned batch in its PreUpdate, which may come after ScenarioDriver's
+constexpr int kResolveSteps = 3;
+
+const std::array<std::string, robocap_kinematics::kNumWheels> kWheelJoints = {
+  "wheel_1_joint", "wheel_2_joint", "wheel_3_joint"};
+
+struct Options
+{
+  std::string world;
+  std::string model = "robot";
+  std::string output;
+  std::uint32_t scenarios = 100;
+  std::uint32_t instances = 0;  // 0 = one per available core
+  double duration = 10.0;       // [s] of sim time per scenario
+  std::uint64_t seed = 1;
+  double spawn_radius = 2.0;    // [m]
+  int domain_base = 10;
+  std::vector<EntitySpec> entities;
+};
+
+struct Pose2d
+{
+  double x;
+  double y;
+  double yaw;
+};
+
+struct ScenarioResult
+{
+  std::uint32_t scenario;
+  std::uint32_t instance;
+  std::uint64_t seed;
+  Pose2d start;
+  Pose2d end;
+  double twist[3];      // Commanded vx, vy, wz
+  double sim_time;      // [s]
+  double wall_time;     // [s]
+};
+
+struct FarmShared
+{
+  std::atomic<std::uint32_t> next_scenario{0};
+  ShmRing<ScenarioResult, kResultRingSize> results;
+};
+
+// Teleports the robot for a new scenario, with its wheel and roller joints back at rest, and
+// holds the wheel velocity commands
+class ScenarioDriver
+  : public ignition::gazebo::System,
+  public ignition::gazebo::ISystemPreUpdate,
+  public ignition::gazebo::ISystemPostUpdate
+{
+public:
+  explicit ScenarioDriver(std::string model_name)
+  : model_name_(std::move(model_name))
+  {
+  }
+
+  void PreUpdate(
+    const ignition::gazebo::UpdateInfo & /*info*/,
+    ignition::gazebo::EntityComponentManager & ecm) override
+  {
+    if (model_ == ignition::gazebo::kNullEntity && !resolve(ecm)) {
+      return;
+    }
+    if (reset_pending_) {
+      const ignition::math::Pose3d pose(
+        reset_pose_.x, reset_pose_.y, kSpawnHeight, 0.0, 0.0, reset_pose_.yaw);
+      if (auto * command = ecm.Component<components::WorldPoseCmd>(model_)) {
+        command->Data() = pose;
+      } else {
+        ecm.CreateComponent(model_, components::WorldPoseCmd(pose));
+      }
+      for (const auto joint : joints_) {
+        reset_joint(ecm, joint);
+      }
+      reset_pending_ = false;
+    }
+    for (std::size_t i = 0; i < wheels_.size(); ++i) {
+      ecm.Component<components::JointVelocityCmd>(wheels_[i])->Data()[0] = wheel_speeds_[i];
+    }
+  }
+
+  void PostUpdate(
+    const ignition::gazebo::UpdateInfo & info,
+    const ignition::gazebo::EntityComponentManager & ecm) override
+  {
+    sim_time_ = std::chrono::duration<double>(info.simTime).count();
+    if (world_name_.empty()) {
+      const auto * name = ecm.Component<components::Name>(ignition::gazebo::worldEntity(ecm));
+      world_name_ = name ? name->Data() : "default";
+    }
+    if (const auto * pose = ecm.Component<components::Pose>(model_)) {
+      pose_ = {pose->Data().Pos().X(), pose->Data().Pos().Y(), pose->Data().Rot().Yaw()};
+    }
+  }
+
+  bool ready() const {return model_ != ignition::gazebo::kNullEntity;}
+
+  void reset(const Pose2d & pose)
+  {
+    reset_pose_ = pose;
+    reset_pending_ = true;
+  }
+
+  void set_wheel_speeds(const robocap_kinematics::WheelSpeeds<double> & speeds)
+  {
+    wheel_speeds_ = speeds;
+  }
+
+  Pose2d pose() const {return pose_;}
+  double sim_time() const {return sim_time_;}
+  double step_size() const {return step_size_;}
+  const std::string & world_name() const {return world_name_;}
+
+private:
+  static void reset_joint(
+    ignition::gazebo::EntityComponentManager & ecm, ignition::gazebo::Entity joint)
+  {
+    if (auto * position = ecm.Component<components::JointPositionReset>(joint)) {
+      position->Data() = {0.0};
+    } else {
+      ecm.CreateComponent(joint, components::JointPositionReset({0.0}));
+    }
+    if (auto * velocity = ecm.Component<components::JointVelocityReset>(joint)) {
+      velocity->Data() = {0.0};
+    } else {
+      ecm.CreateComponent(joint, components::JointVelocityReset({0.0}));
+    }
+  }
+
+  bool resolve(ignition::gazebo::EntityComponentManager & ecm)
+  {
+    const auto model = ecm.EntityByComponents(components::Model(), components::Name(model_name_));
+    if (model == ignition::gazebo::kNullEntity) {
+      return false;
+    }
+    const ignition::gazebo::Model wrapper(model);
+    for (std::size_t i = 0; i < wheels_.size(); ++i) {
+      wheels_[i] = wrapper.JointByName(ecm, kWheelJoints[i]);
+      if (wheels_[i] == ignition::gazebo::kNullEntity) {
+        std::cerr << "Joint [" << kWheelJoints[i] << "] not found in [" << model_name_ << "]" <<
+          std::endl;
+        return false;
+      }
+      if (!ecm.Component<components::JointVelocityCmd>(wheels_[i])) {
+        ecm.CreateComponent(wheels_[i], components::JointVelocityCmd({0.0}));
+      }
+    }
+    // Single-axis joints only, fixed ones have no state to reset
+    joints_.clear();
+    for (const auto joint : wrapper.Joints(ecm)) {
+      const auto * type = ecm.Component<components::JointType>(joint);
+      if (type && (type->Data() == sdf::JointType::REVOLUTE ||
+        type->Data() == sdf::JointType::CONTINUOUS))
+      {
+        joints_.push_back(joint);
+      }
+    }
+    const auto world = ignition::gazebo::worldEntity(ecm);
+    if (const auto * physics = ecm.Component<components::Physics>(world)) {
+      step_size_ = physics->Data().MaxStepSize();
+    }
+    model_ = model;
+    return step_size_ > 0.0;
+  }
+
+  std::string model_name_;
+  std::string world_name_;
+  ignition::gazebo::Entity model_ = ignition::gazebo::kNullEntity;
+  std::array<ignition::gazebo::Entity, robocap_kinematics::kNumWheels> wheels_{};
+  std::vector<ignition::gazebo::Entity> joints_;  // Reset along with the pose
+  robocap_kinematics::WheelSpeeds<double> wheel_speeds_{};
+  bool reset_pending_ = false;
+  Pose2d reset_pose_{};
+  Pose2d pose_{};
+  double sim_time_ = 0.0;
+  double step_size_ = 0.0;
+};
+
+std::vector<int> available_cores()
+{
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  std::vector<int> cores;
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &set)) {
+        cores.push_back(cpu);
+      }
+    }
+  }
+  return cores;
+}
+
+[[noreturn]] void run_worker(
+  const Options & options, std::uint32_t instance, int core, FarmShared & shared)
+{
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(core, &set);
+  if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+    std::perror("sched_setaffinity");
+  }
+
+  // Isolate transport before anything creates a gz-transport or DDS participant
+  const auto partition = "robocap_farm_" + std::to_string(getppid()) + "_" +
+    std::to_string(instance);
+  setenv("IGN_PARTITION", partition.c_str(), 1);
+  setenv("GZ_PARTITION", partition.c_str(), 1);
+  setenv("ROS_DOMAIN_ID", std::to_string(options.domain_base + instance).c_str(), 1);
+
+  ignition::gazebo::ServerConfig config;
+  config.SetSdfFile(options.world);
+  config.SetHeadlessRendering(true);
+  ignition::gazebo::Server server(config);
+  server.SetUpdatePeriod(std::chrono::nanoseconds(0));
+
+  auto driver = std::make_shared<ScenarioDriver>(options.model);
+  server.AddSystem(driver);
+  server.RunOnce(true);
+  if (!options.entities.empty()) {
+    // The server is in this process, so the request skips discovery and is answered right away
+    EntitySpawner spawner(driver->world_name());
+    if (!spawner.spawn(options.entities, kSpawnTimeout)) {
+      std::cerr << "Instance " << instance << ": world [" << driver->world_name() <<
+        "] did not accept " << options.entities.size() << " entities" << std::endl;
+      std::_Exit(1);
+    }
+    for (int step = 0; step < kResolveSteps && !driver->ready(); ++step) {
+      server.RunOnce(true);
+    }
+  }
+  if (!driver->ready()) {
+    std::cerr << "Instance " << instance << ": model [" << options.model << "] not found" <<
+      std::endl;
+    std::_Exit(1);
+  }
+
+  // In steps of whatever max_step_size the world uses
+  const auto steps =
+    static_cast<std::uint64_t>(std::llround(options.duration / driver->step_size()));
+  const auto settle_steps =
+    static_cast<std::uint64_t>(std::llround(kSettleTime / driver->step_size()));
+  std::uint32_t scenario;
+  while ((scenario = shared.next_scenario.fetch_add(1)) < options.scenarios) {
+    // Seeded per scenario, not per worker, so the sampled start and command do not depend on the
+    // instance count. The teleport resets the joints, but whatever chassis motion the settle
+    // leaves still carries over from this instance's previous scenario
+    std::mt19937_64 rng(options.seed * 0x9e3779b97f4a7c15ULL + scenario);
+    std::uniform_real_distribution<double> position(-options.spawn_radius, options.spawn_radius);
+    std::uniform_real_distribution<double> heading(-M_PI, M_PI);
+    std::uniform_real_distribution<double> linear(-kMaxLinear, kMaxLinear);
+    std::uniform_real_distribution<double> angular(-kMaxAngular, kMaxAngular);
+
+    ScenarioResult result{};
+    result.scenario = scenario;
+    result.instance = instance;
+    result.seed = options.seed;
+    result.start = {position(rng), position(rng), heading(rng)};
+    const robocap_kinematics::Twist<double> twist{linear(rng), linear(rng), angular(rng)};
+    result.twist[0] = twist.vx;
+    result.twist[1] = twist.vy;
+    result.twist[2] = twist.wz;
+
+    // Let the previous scenario come to rest before teleporting
+    driver->set_wheel_speeds({});
+    server.Run(true, settle_steps, false);
+    driver->reset(result.start);
+    driver->set_wheel_speeds(robocap_kinematics::kRobocapKiwiDrive.to_wheel_speeds(twist));
+
+    const double sim_start = driver->sim_time();
+    const auto wall_start = std::chrono::steady_clock::now();
+    server.Run(true, steps, false);
+    result.wall_time =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    result.sim_time = driver->sim_time() - sim_start;
+    result.end = driver->pose();
+
+    while (!shared.results.push(result)) {
+      std::this_thread::yield();  // The parent is behind draining the ring
+    }
+  }
+  std::_Exit(0);
+}
+
+void write_result(std::ostream & out, const ScenarioResult & r)
+{
+  char line[512];
+  std::snprintf(
+    line, sizeof(line),
+    "{\"scenario\": %u, \"instance\": %u, \"seed\": %llu, "
+    "\"start\": [%.6f, %.6f, %.6f], \"twist\": [%.6f, %.6f, %.6f], \"end\": [%.6f, %.6f, %.6f], "
+    "\"sim_time\": %.6f, \"wall_time\": %.6f, \"real_time_factor\": %.3f}",
+    r.scenario, r.instance, static_cast<unsigned long long>(r.seed),
+    r.start.x, r.start.y, r.start.yaw, r.twist[0], r.twist[1], r.twist[2],
+    r.end.x, r.end.y, r.end.yaw, r.sim_time, r.wall_time,
+    r.wall_time > 0.0 ? r.sim_time / r.wall_time : 0.0);
+  out << line << '\n';
+}
+
+bool parse_options(int argc, char ** argv, Options & options)
+{
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string flag = argv[i];
+    const std::string value = argv[i + 1];
+    if (flag == "--world") {
+      options.world = value;
+    } else if (flag == "--model") {
+      options.model = value;
+    } else if (flag == "--output") {
+      options.output = value;
+    } else if (flag == "--scenarios") {
+      options.scenarios = static_cast<std::uint32_t>(std::stoul(value));
+    } else if (flag == "--instances") {
+      options.instances = static_cast<std::uint32_t>(std::stoul(value));
+    } else if (flag == "--duration") {
+      options.duration = std::stod(value);
+    } else if (flag == "--seed") {
+      options.seed = std::stoull(value);
+    } else if (flag == "--spawn-radius") {
+      options.spawn_radius = std::stod(value);
+    } else if (flag == "--domain-base") {
+      options.domain_base = std::stoi(value);
+    } else if (flag == "--entities") {
+      std::ifstream file(value);
+      if (!file) {
+        std::cerr << "Cannot read " << value << std::endl;
+        return false;
+      }
+      options.entities = parse_entities(file);
+    } else {
+      std::cerr << "Unknown argument " << flag << std::endl;
+      return false;
+    }
+  }
+  return !options.world.empty();
+}
+
+}  // namespace
+
+}  // namespace robocap_sim
+
+int main(int argc, char ** argv)
+{
+  using robocap_sim::FarmShared;
+
+  robocap_sim::Options options;
+  try {
+    if (!robocap_sim::parse_options(argc, argv, options)) {
+      std::cerr << "Usage: " << argv[0] << " --world <file.sdf> [--scenarios N] [--instances N]"
+        " [--duration s] [--seed N] [--spawn-radius m] [--domain-base N] [--model name]"
+        " [--entities file] [--output file]" << std::endl;
+      return 1;
+    }
+  } catch (const std::invalid_argument & e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  const auto cores = robocap_sim::available_cores();
+  if (cores.empty()) {
+    std::cerr << "No CPU cores available" << std::endl;
+    return 1;
+  }
+  std::uint32_t instances = options.instances == 0 ?
+    static_cast<std::uint32_t>(cores.size()) : options.instances;
+  if (instances > cores.size()) {
+    std::cerr << "Only " << cores.size() << " cores available, running " << cores.size() <<
+      " instances" << std::endl;
+    instances = static_cast<std::uint32_t>(cores.size());
+  }
+
+  // The parent has no threads yet, so forking the workers below is safe
+  const auto shm_name = "/robocap_farm_" + std::to_string(getpid());
+  const int shm_fd = shm_open(shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (shm_fd < 0 || ftruncate(shm_fd, sizeof(FarmShared)) != 0) {
+    std::perror("shm_open");
+    return 1;
+  }
+  void * memory = mmap(nullptr, sizeof(FarmShared), PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+  close(shm_fd);
+  if (memory == MAP_FAILED) {
+    std::perror("mmap");
+    shm_unlink(shm_name.c_str());
+    return 1;
+  }
+  auto * shared = new (memory) FarmShared();
+
+  std::vector<pid_t> workers;
+  for (std::uint32_t i = 0; i < instances; ++i) {
+    const pid_t pid = fork();
+    if (pid == 0) {
+      robocap_sim::run_worker(options, i, cores[i], *shared);
+    }
+    if (pid < 0) {
+      std::perror("fork");
+      break;
+    }
+    workers.push_back(pid);
+  }
+
+  std::ofstream file;
+  if (!options.output.empty()) {
+    file.open(options.output);
+  }
+  std::ostream & out = options.output.empty() ? std::cout : file;
+
+  std::uint32_t received = 0;
+  std::size_t running = workers.size();
+  robocap_sim::ScenarioResult result;
+  while (received < options.scenarios) {
+    if (shared->results.pop(result)) {
+      robocap_sim::write_result(out, result);
+      ++received;
+      continue;
+    }
+    // Empty ring: stop once every worker has exited and nothing is left to drain
+    int status;
+    while (running > 0 && waitpid(-1, &status, WNOHANG) > 0) {
+      --running;
+    }
+    if (running == 0 && !shared->results.pop(result)) {
+      break;
+    }
+    if (running == 0) {
+      robocap_sim::write_result(out, result);
+      ++received;
+      continue;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  out.flush();
+
+  for (const pid_t pid : workers) {
+    waitpid(pid, nullptr, 0);
+  }
+  shared->~FarmShared();
+  munmap(memory, sizeof(FarmShared));
+  shm_unlink(shm_name.c_str());
+
+  std::cerr << received << "/" << options.scenarios << " scenarios on " << workers.size() <<
+    " instances" << std::endl;
+  return received == options.scenarios ? 0 : 1;
+}
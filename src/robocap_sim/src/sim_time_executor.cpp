@@ -0,0 +1,61 @@
+#include "robocap_sim/sim_time_executor.hpp"
+
+#include <chrono>
+#include <stdexcept>
+
+#include "rclcpp/qos.hpp"
+#include "rclcpp/scope_exit.hpp"
+
+namespace robocap_sim
+{
+
+SimTimeExecutor::SimTimeExecutor(const rclcpp::ExecutorOptions & options)
+: rclcpp::Executor(options)
+{
+  // Never added to the executor, it only owns the clock publisher
+  clock_node_ = std::make_shared<rclcpp::Node>(
+    "sim_time_executor", rclcpp::NodeOptions()
+    .context(options.context)
+    .start_parameter_services(false)
+    .start_parameter_event_publisher(false)
+    .use_clock_thread(false));
+  clock_publisher_ =
+    clock_node_->create_publisher<rosgraph_msgs::msg::Clock>("/clock", rclcpp::ClockQoS());
+}
+
+void SimTimeExecutor::spin()
+{
+  if (spinning.exchange(true)) {
+    throw std::runtime_error("spin() called while already spinning");
+  }
+  RCLCPP_SCOPE_EXIT(this->spinning.store(false););
+  while (rclcpp::ok(context_) && spinning.load()) {
+    rclcpp::AnyExecutable executable;
+    if (get_next_executable(executable)) {
+      execute_any_executable(executable);
+    }
+  }
+}
+
+std::size_t SimTimeExecutor::advance(const rclcpp::Time & time)
+{
+  clock_.clock = time;
+  clock_publisher_->publish(clock_);
+  return drain();
+}
+
+std::size_t SimTimeExecutor::drain()
+{
+  // A zero timeout only collects work that is already there, so this returns once a wait finds
+  // nothing new after the last callback
+  std::size_t callbacks = 0;
+  rclcpp::AnyExecutable executable;
+  while (rclcpp::ok(context_) && get_next_executable(executable, std::chrono::nanoseconds(0))) {
+    execute_any_executable(executable);
+    executable = rclcpp::AnyExecutable();
+    ++callbacks;
+  }
+  return callbacks;
+}
+
+}  // namespace robocap_sim
@@ -0,0 +1,52 @@
+#ifndef ROBOCAP_SIM__SOCKET_IO_HPP_
+#define ROBOCAP_SIM__SOCKET_IO_HPP_
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+
+namespace robocap_sim
+{
+
+// Blocking socket helpers that retry on short transfers and EINTR. A peer that went away is a
+// false return, EOF for a read and EPIPE for a write, never a SIGPIPE: the lockstep server
+// outlives its clients
+inline bool read_exact(int fd, void * data, std::size_t size)
+{
+  auto * bytes = static_cast<char *>(data);
+  while (size > 0) {
+    const ssize_t n = ::read(fd, bytes, size);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    bytes += n;
+    size -= static_cast<std::size_t>(n);
+  }
+  return true;
+}
+
+inline bool write_exact(int fd, const void * data, std::size_t size)
+{
+  const auto * bytes = static_cast<const char *>(data);
+  while (size > 0) {
+    const ssize_t n = ::send(fd, bytes, size, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    bytes += n;
+    size -= static_cast<std::size_t>(n);
+  }
+  return true;
+}
+
+}  // namespace robocap_sim
+
+#endif  // ROBOCAP_SIM__SOCKET_IO_HPP_
@@ -0,0 +1,87 @@
+// Spawns a list of models into a running (or still starting) world in one batched request, see
+// robocap_sim::EntitySpawner. Exits once the world accepted the batch, 1 if it refused it or did
+// not come up within the timeout.
+//
+// Usage: robocap_spawn [--world default] [--timeout 30] [--file <entities.txt>]
+//                      [--entity "<name> <uri> <x> <y> <z> [<roll> <pitch> <yaw>]"]...
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "robocap_sim/entity_spawner.hpp"
+
+namespace robocap_sim
+{
+
+namespace
+{
+
+struct Options
+{
+  std::string world = "default";
+  double timeout = 30.0;  // [s]
+  std::vector<EntitySpec> entities;
+};
+
+bool parse_options(int argc, char ** argv, Options & options)
+{
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string flag = argv[i];
+    const std::string value = argv[i + 1];
+    if (flag == "--world") {
+      options.world = value;
+    } else if (flag == "--timeout") {
+      options.timeout = std::stod(value);
+    } else if (flag == "--file") {
+      std::ifstream file(value);
+      if (!file) {
+        std::cerr << "Cannot read " << value << std::endl;
+        return false;
+      }
+      const auto entities = parse_entities(file);
+      options.entities.insert(options.entities.end(), entities.begin(), entities.end());
+    } else if (flag == "--entity") {
+      options.entities.push_back(parse_entity(value));
+    } else {
+      std::cerr << "Unknown argument " << flag << std::endl;
+      return false;
+    }
+  }
+  return argc % 2 == 1 && !options.entities.empty();
+}
+
+}  // namespace
+
+}  // namespace robocap_sim
+
+int main(int argc, char ** argv)
+{
+  robocap_sim::Options options;
+  try {
+    if (!robocap_sim::parse_options(argc, argv, options)) {
+      std::cerr << "Usage: " << argv[0] << " [--world name] [--timeout s] [--file entities.txt]"
+        " [--entity \"name uri x y z [roll pitch yaw]\"]..." << std::endl;
+      return 1;
+    }
+  } catch (const std::invalid_argument & e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  robocap_sim::EntitySpawner spawner(options.world);
+  const auto start = std::chrono::steady_clock::now();
+  const auto timeout = std::chrono::milliseconds(static_cast<long>(options.timeout * 1e3));
+  if (!spawner.spawn(options.entities, timeout)) {
+    std::cerr << "World [" << options.world << "] did not accept " << options.entities.size() <<
+      " entities on " << spawner.service() << std::endl;
+    return 1;
+  }
+  std::cerr << "Spawned " << options.entities.size() << " entities into [" << options.world <<
+    "] in " << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() <<
+    " s" << std::endl;
+  return 0;
+}
@@ -0,0 +1,397 @@
+// Watches the robot's xacro files and hot-patches the model in the running world whenever an edit
+// changes what they expand to, through robocap_sim::ModelReloader, instead of relaunching gz sim
+// and the stack. Exits on Ctrl-C.
+//
+// Work per edit is kept to what the edit touched:
+//   - inotify reports which files were written; files robot.urdf.xacro does not include (editor
+//     swap files, other robots) and writes that leave the content as it was are ignored;
+//   - the chassis convex hulls come from robocap_mesh_tool once per STL content, cached on disk
+//     under --cache-dir, so only an edit of the STL itself pays for the decomposition again;
+//   - xacro re-expands the whole robot, it has no notion of re-evaluating one macro, but that is
+//     tens of milliseconds: a model that expands to the same SDF as before is dropped here, and
+//     ModelReloader only patches the links, joints and collisions that differ.
+//
+// Usage: robocap_xacro_watch [--urdf-dir <dir>] [--world default] [--model robot]
+//                            [--cache-dir ~/.cache/robocap_sim] [--debounce 0.2] [--timeout 5]
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ignition/msgs/stringmsg.pb.h"
+#include "ignition/transport/Node.hh"
+#include "robocap_sim/model_reloader.hpp"
+#include "sdf/Root.hh"
+
+namespace robocap_sim
+{
+
+namespace
+{
+
+constexpr char kRobotXacro[] = "robot.urdf.xacro";
+constexpr char kChassisMesh[] = "frame_ultra_low_poly.stl";
+// Same visual the build bakes, so the reloaded model's visuals match the running ones
+constexpr char kMeshUri[] = "model://robocap/meshes/frame_ultra_low_poly.stl";
+
+struct Options
+{
+  std::filesystem::path urdf_dir = ROBOCAP_SIM_URDF_DIR;
+  std::string world = "default";
+  std::string model = "robot";
+  std::filesystem::path cache_dir;
+  double debounce = 0.2;  // [s]
+  double timeout = 5.0;   // [s]
+};
+
+bool parse_options(int argc, char ** argv, Options & options)
+{
+  const char * cache_home = std::getenv("XDG_CACHE_HOME");
+  const char * home = std::getenv("HOME");
+  options.cache_dir = cache_home ? std::filesystem::path(cache_home) / "robocap_sim" :
+    std::filesystem::path(home ? home : "/tmp") / ".cache" / "robocap_sim";
+
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string flag = argv[i];
+    const std::string value = argv[i + 1];
+    if (flag == "--urdf-dir") {
+      options.urdf_dir = value;
+    } else if (flag == "--world") {
+      options.world = value;
+    } else if (flag == "--model") {
+      options.model = value;
+    } else if (flag == "--cache-dir") {
+      options.cache_dir = value;
+    } else if (flag == "--debounce") {
+      options.debounce = std::stod(value);
+    } else if (flag == "--timeout") {
+      options.timeout = std::stod(value);
+    } else {
+      std::cerr << "Unknown argument " << flag << std::endl;
+      return false;
+    }
+  }
+  return argc % 2 == 1;
+}
+
+// FNV-1a of the file's content, 0 if it cannot be read
+std::uint64_t content_hash(const std::filesystem::path & path)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return 0;
+  }
+  std::uint64_t hash = 14695981039346656037ull;
+  char buffer[65536];
+  while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
+    for (std::streamsize i = 0; i < file.gcount(); ++i) {
+      hash = (hash ^ static_cast<unsigned char>(buffer[i])) * 1099511628211ull;
+    }
+  }
+  return hash;
+}
+
+// Runs `args` to completion, true if it exited with 0. Its stdout goes to `out` if given
+bool run(const std::vector<std::string> & args, std::string * out = nullptr)
+{
+  int pipe_fds[2];
+  if (out != nullptr && pipe(pipe_fds) != 0) {
+    std::perror("pipe");
+    return false;
+  }
+  const pid_t pid = fork();
+  if (pid == 0) {
+    if (out != nullptr) {
+      dup2(pipe_fds[1], STDOUT_FILENO);
+      close(pipe_fds[0]);
+      close(pipe_fds[1]);
+    }
+    std::vector<char *> argv;
+    for (const auto & arg : args) {
+      argv.push_back(const_cast<char *>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+    execvp(argv[0], argv.data());
+    std::perror(argv[0]);
+    _exit(127);
+  }
+  if (out != nullptr) {
+    close(pipe_fds[1]);
+    if (pid > 0) {
+      char buffer[4096];
+      ssize_t n;
+      while ((n = read(pipe_fds[0], buffer, sizeof(buffer))) > 0) {
+        out->append(buffer, static_cast<std::size_t>(n));
+      }
+    }
+    close(pipe_fds[0]);
+  }
+  if (pid < 0) {
+    std::perror("fork");
+    return false;
+  }
+  int status = 0;
+  return waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+std::string hex(std::uint64_t value)
+{
+  char buffer[17];
+  std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(value));
+  return buffer;
+}
+
+// Convex hulls of each chassis STL content seen, from robocap_mesh_tool. Kept across runs: a
+// directory per content hash, which is complete once its chassis_collision.xacro exists
+class HullCache
+{
+public:
+  // `install_prefix` is where robocap_sim is installed, whose meshes the running model uses
+  HullCache(std::filesystem::path directory, const std::filesystem::path & install_prefix)
+  : directory_(std::move(directory)),
+    mesh_tool_(install_prefix / "lib" / "robocap_sim" / "robocap_mesh_tool"),
+    installed_hash_(content_hash(
+        install_prefix / "share" / "robocap_sim" / "models" / "robocap" / "meshes" / kChassisMesh))
+  {}
+
+  // chassis_collision.xacro for the STL with content `hash`, empty if decomposing it failed
+  std::filesystem::path collision_xacro(const std::filesystem::path & stl, std::uint64_t hash)
+  {
+    const auto directory = directory_ / ("hulls_" + hex(hash));
+    const auto xacro = directory / "chassis_collision.xacro";
+    std::error_code error;
+    if (std::filesystem::is_regular_file(xacro, error)) {
+      return xacro;
+    }
+    std::cerr << "Decomposing " << stl.string() << " into " << directory.string() << std::endl;
+    const auto partial = directory.string() + ".partial";
+    std::filesystem::remove_all(partial, error);
+    // Hulls of the installed STL are the installed ones, so their collisions compare equal to the
+    // running model's. Others are referenced by absolute path, gz sim runs on this machine
+    const auto uri_prefix =
+      hash == installed_hash_ ? std::string("model://robocap/meshes/") : directory.string() + "/";
+    if (!run({mesh_tool_.string(), stl.string(), partial, "--uri-prefix", uri_prefix})) {
+      std::cerr << "robocap_mesh_tool failed on " << stl.string() << std::endl;
+      return {};
+    }
+    std::filesystem::rename(partial, directory, error);
+    return error ? std::filesystem::path{} : xacro;
+  }
+
+private:
+  std::filesystem::path directory_;
+  std::filesystem::path mesh_tool_;
+  std::uint64_t installed_hash_;
+};
+
+class XacroWatch
+{
+public:
+  explicit XacroWatch(const Options & options)
+  : options_(options),
+    // Installed as <prefix>/lib/robocap_sim/robocap_xacro_watch
+    hulls_(options.cache_dir,
+      std::filesystem::read_symlink("/proc/self/exe").parent_path().parent_path().parent_path()),
+    service_(reload_service(options.world)) {}
+
+  // Records the content of the `names` just written under the urdf directory, true if one of them
+  // changes the model
+  bool changed(const std::set<std::string> & names)
+  {
+    bool changed = false;
+    for (const auto & name : names) {
+      const auto path = std::filesystem::absolute(options_.urdf_dir / name).lexically_normal();
+      if (name != kChassisMesh && dependencies_.count(path.string()) == 0) {
+        continue;
+      }
+      const auto hash = content_hash(path);
+      auto & known = hashes_[path.string()];
+      changed |= hash != known;
+      known = hash;
+    }
+    return changed;
+  }
+
+  // Expands the xacro and sends the model to the world if it differs from what was sent last
+  void reload()
+  {
+    const auto start = std::chrono::steady_clock::now();
+    const auto stl = std::filesystem::absolute(options_.urdf_dir / kChassisMesh);
+    auto & stl_hash = hashes_[stl.lexically_normal().string()];
+    if (stl_hash == 0) {
+      stl_hash = content_hash(stl);
+    }
+    const auto collision = hulls_.collision_xacro(stl, stl_hash);
+    if (collision.empty()) {
+      return;
+    }
+
+    const auto urdf = options_.cache_dir / "robot.urdf";
+    const std::vector<std::string> xacro{
+      "xacro", (options_.urdf_dir / kRobotXacro).string(),
+      std::string("mesh_uri:=") + kMeshUri,
+      "chassis_collision:=" + collision.string()};
+    auto expand = xacro;
+    expand.insert(expand.end(), {"-o", urdf.string()});
+    if (!run(expand)) {
+      std::cerr << "xacro failed, keeping the running model" << std::endl;
+      return;
+    }
+    update_dependencies(xacro);
+
+    sdf::Root root;
+    const auto errors = root.Load(urdf.string());
+    if (!errors.empty() || root.Model() == nullptr) {
+      for (const auto & error : errors) {
+        std::cerr << error << std::endl;
+      }
+      std::cerr << urdf.string() << " does not describe a model" << std::endl;
+      return;
+    }
+    root.Element()->GetElement("model")->GetAttribute("name")->Set(options_.model);
+    const auto model = root.Element()->ToString("");
+    if (model == sent_) {
+      std::cerr << "No change to the model" << std::endl;
+      return;
+    }
+
+    ignition::msgs::StringMsg request;
+    request.set_data(model);
+    ignition::msgs::StringMsg reply;
+    bool accepted = false;
+    const auto timeout = static_cast<unsigned int>(options_.timeout * 1e3);
+    if (!node_.Request(service_, request, timeout, reply, accepted)) {
+      std::cerr << "No reply from " << service_ << ", is the world running with "
+        "robocap_sim::ModelReloader?" << std::endl;
+      return;
+    }
+    std::cerr << reply.data() << " (" << std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - start).count() << " ms)" << std::endl;
+    if (accepted) {
+      sent_ = model;
+    }
+  }
+
+private:
+  // The files the expansion read, from xacro --deps plus the root file it leaves out, with their
+  // current content
+  void update_dependencies(const std::vector<std::string> & xacro)
+  {
+    auto deps = xacro;
+    deps.insert(deps.begin() + 1, "--deps");
+    std::string out;
+    if (!run(deps, &out)) {
+      return;  // Keep the previous set, xacro just expanded with the same files
+    }
+    dependencies_.clear();
+    std::vector<std::string> files{(options_.urdf_dir / kRobotXacro).string()};
+    std::istringstream paths(out);
+    for (std::string path; paths >> path; ) {
+      files.push_back(path);
+    }
+    for (const auto & path : files) {
+      const auto normal = std::filesystem::absolute(path).lexically_normal().string();
+      dependencies_.insert(normal);
+      auto & known = hashes_[normal];
+      if (known == 0) {
+        known = content_hash(normal);
+      }
+    }
+  }
+
+  Options options_;
+  HullCache hulls_;
+  std::string service_;
+  ignition::transport::Node node_;
+  std::set<std::string> dependencies_;
+  std::map<std::string, std::uint64_t> hashes_;
+  std::string sent_;
+};
+
+// Names of the files written in the watched directory, once `debounce` passed without another
+// write: editors save through temporary files and renames, in several events
+std::set<std::string> wait_for_writes(int fd, std::chrono::milliseconds debounce)
+{
+  std::set<std::string> names;
+  pollfd descriptor{fd, POLLIN, 0};
+  int timeout = -1;
+  while (poll(&descriptor, 1, timeout) > 0) {
+    alignas(inotify_event) char buffer[4096];
+    const ssize_t length = read(fd, buffer, sizeof(buffer));
+    for (ssize_t offset = 0; offset < length; ) {
+      const auto * event = reinterpret_cast<const inotify_event *>(buffer + offset);
+      if (event->len > 0) {
+        names.insert(event->name);
+      }
+      offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+    }
+    timeout = static_cast<int>(debounce.count());
+  }
+  return names;
+}
+
+}  // namespace
+
+}  // namespace robocap_sim
+
+int main(int argc, char ** argv)
+{
+  robocap_sim::Options options;
+  try {
+    if (!robocap_sim::parse_options(argc, argv, options)) {
+      std::cerr << "Usage: " << argv[0] << " [--urdf-dir dir] [--world name] [--model name]"
+        " [--cache-dir dir] [--debounce s] [--timeout s]" << std::endl;
+      return 1;
+    }
+  } catch (const std::invalid_argument & e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  std::error_code error;
+  std::filesystem::create_directories(options.cache_dir, error);
+  if (error) {
+    std::cerr << "Cannot create " << options.cache_dir.string() << ": " << error.message() <<
+      std::endl;
+    return 1;
+  }
+
+  const int fd = inotify_init1(IN_CLOEXEC);
+  if (fd < 0 ||
+    inotify_add_watch(fd, options.urdf_dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+  {
+    std::perror(options.urdf_dir.c_str());
+    return 1;
+  }
+
+  // The first reload brings the running model in line with the files as they are now
+  robocap_sim::XacroWatch watch(options);
+  watch.reload();
+  std::cerr << "Watching " << options.urdf_dir.string() << std::endl;
+  const auto debounce = std::chrono::milliseconds(static_cast<long>(options.debounce * 1e3));
+  while (true) {
+    const auto names = robocap_sim::wait_for_writes(fd, debounce);
+    if (names.empty()) {
+      std::perror("inotify");
+      return 1;
+    }
+    if (watch.changed(names)) {
+      watch.reload();
+    }
+  }
+}
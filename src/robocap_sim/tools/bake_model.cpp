@@ -0,0 +1,39 @@
+// Converts the xacro-expanded robot.urdf into the SDF model installed under models/robocap, so
+// neither xacro nor the URDF parser has to run when the simulation starts.
+//
+// Usage: robocap_bake_model <robot.urdf> <model.sdf>
+
+#include <fstream>
+#include <iostream>
+
+#include "sdf/Root.hh"
+
+int main(int argc, char ** argv)
+{
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <robot.urdf> <model.sdf>" << std::endl;
+    return 1;
+  }
+
+  // sdformat converts URDF on load, lumping fixed joints the same way a runtime spawn would
+  sdf::Root root;
+  const auto errors = root.Load(argv[1]);
+  if (!errors.empty()) {
+    for (const auto & error : errors) {
+      std::cerr << error << std::endl;
+    }
+    return 1;
+  }
+  if (root.Model() == nullptr) {
+    std::cerr << argv[1] << " does not describe a model" << std::endl;
+    return 1;
+  }
+
+  std::ofstream out(argv[2]);
+  out << root.Element()->ToString("");
+  if (!out) {
+    std::cerr << "Failed to write " << argv[2] << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,229 @@
+#!/usr/bin/env python3
+"""
+Generate robocap_kinematics/robocap_model.hpp from the xacro-expanded robot.urdf.
+
+Every link's mass, inertial origin, inertia and first collision primitive and every joint's
+origin and axis become constexpr values, so C++ consumers get the real geometry at compile time
+without parsing the URDF at startup.
+
+Usage: generate_model_header.py <robot.urdf> <robocap_model.hpp> [--check <installed.hpp>]
+
+With --check the header is only written if it matches the installed copy, otherwise the
+differences are printed and the exit status is 1.
+"""
+
+import argparse
+import difflib
+import math
+import re
+import sys
+import xml.etree.ElementTree as ET
+
+JOINT_TYPES = {
+    'fixed': 'kFixed',
+    'continuous': 'kContinuous',
+    'revolute': 'kRevolute',
+    'prismatic': 'kPrismatic',
+    'floating': 'kFloating',
+    'planar': 'kPlanar',
+}
+
+
+def literal(value):
+    # repr() is the shortest string that parses back to the same double
+    text = repr(float(value))
+    return '0.0' if text == '-0.0' else text
+
+
+def vector(text, default='0 0 0'):
+    values = [float(v) for v in (text or default).split()]
+    if len(values) != 3:
+        raise ValueError('expected three numbers, got "%s"' % text)
+    return values
+
+
+def rotation(rpy):
+    # URDF convention: fixed-axis roll about x, then pitch about y, then yaw about z
+    cr, sr = math.cos(rpy[0]), math.sin(rpy[0])
+    cp, sp = math.cos(rpy[1]), math.sin(rpy[1])
+    cy, sy = math.cos(rpy[2]), math.sin(rpy[2])
+    return [
+        [cy * cp, cy * sp * sr - sy * cr, cy * sp * cr + sy * sr],
+        [sy * cp, sy * sp * sr + cy * cr, sy * sp * cr - cy * sr],
+        [-sp, cp * sr, cp * cr],
+    ]
+
+
+def identifier(name):
+    ident = re.sub(r'\W', '_', name)
+    return '_' + ident if ident[0].isdigit() else ident
+
+
+def format_vector(values):
+    return '{%s}' % ', '.join(literal(v) for v in values)
+
+
+def format_origin(element, indent):
+    xyz = vector(element.get('xyz') if element is not None else None)
+    rpy = vector(element.get('rpy') if element is not None else None)
+    rows = ',\n'.join(indent + '  ' + format_vector(row) for row in rotation(rpy))
+    return '{\n%s%s,\n%s%s,\n%s{{\n%s,\n%s}},\n%s}' % (
+        indent, format_vector(xyz), indent, format_vector(rpy), indent, rows, indent, indent[2:])
+
+
+def format_geometry(link):
+    collision = link.find('collision')
+    geometry = collision.find('geometry') if collision is not None else None
+    shape = geometry[0] if geometry is not None and len(geometry) else None
+    if shape is None:
+        return 'GeometryType::kNone, {0.0, 0.0, 0.0}'
+    if shape.tag == 'box':
+        return 'GeometryType::kBox, %s' % format_vector(vector(shape.get('size')))
+    if shape.tag == 'cylinder':
+        return 'GeometryType::kCylinder, %s' % format_vector(
+            [float(shape.get('radius')), float(shape.get('length')), 0.0])
+    if shape.tag == 'sphere':
+        return 'GeometryType::kSphere, %s' % format_vector([float(shape.get('radius')), 0.0, 0.0])
+    if shape.tag == 'mesh':
+        return 'GeometryType::kMesh, %s' % format_vector(vector(shape.get('scale'), '1 1 1'))
+    raise ValueError('unsupported collision geometry <%s>' % shape.tag)
+
+
+def format_link(link):
+    inertial = link.find('inertial')
+    mass = 0.0
+    inertia = [0.0] * 6
+    origin = None
+    if inertial is not None:
+        mass = float(inertial.find('mass').get('value'))
+        tensor = inertial.find('inertia')
+        inertia = [float(tensor.get(k, 0.0)) for k in ('ixx', 'ixy', 'ixz', 'iyy', 'iyz', 'izz')]
+        origin = inertial.find('origin')
+    name = link.get('name')
+    return (
+        'constexpr Link %s{\n'
+        '  "%s",\n'
+        '  %s,\n'
+        '  %s,\n'
+        '  {%s},\n'
+        '  {%s},\n'
+        '};\n') % (
+        identifier(name), name, literal(mass), format_origin(origin, '    '),
+        ', '.join(literal(v) for v in inertia), format_geometry(link))
+
+
+def format_joint(joint):
+    name = joint.get('name')
+    kind = joint.get('type')
+    if kind not in JOINT_TYPES:
+        raise ValueError('joint %s has unknown type %s' % (name, kind))
+    axis = joint.find('axis')
+    return (
+        'constexpr Joint %s{\n'
+        '  "%s",\n'
+        '  JointType::%s,\n'
+        '  "%s",\n'
+        '  "%s",\n'
+        '  %s,\n'
+        '  %s,\n'
+        '};\n') % (
+        identifier(name), name, JOINT_TYPES[kind], joint.find('parent').get('link'),
+        joint.find('child').get('link'), format_origin(joint.find('origin'), '    '),
+        format_vector(vector(axis.get('xyz') if axis is not None else None, '1 0 0')))
+
+
+def generate(urdf_path):
+    robot = ET.parse(urdf_path).getroot()
+    links = robot.findall('link')
+    joints = robot.findall('joint')
+    total_mass = sum(
+        float(link.find('inertial/mass').get('value'))
+        for link in links if link.find('inertial') is not None)
+
+    out = []
+    out.append(
+        '// Generated from robocap_sim/urdf/robot.urdf.xacro by robocap_sim/tools/'
+        'generate_model_header.py.\n'
+        '// Do not edit: the robocap_sim build regenerates it and fails while this copy is stale.\n'
+        '\n'
+        '#ifndef ROBOCAP_KINEMATICS__ROBOCAP_MODEL_HPP_\n'
+        '#define ROBOCAP_KINEMATICS__ROBOCAP_MODEL_HPP_\n'
+        '\n'
+        '#include <array>\n'
+        '\n'
+        '#include "robocap_kinematics/model.hpp"\n'
+        '\n'
+        'namespace robocap_kinematics\n'
+        '{\n'
+        'namespace robocap_model\n'
+        '{\n'
+        '\n'
+        'using model::GeometryType;\n'
+        'using model::Joint;\n'
+        'using model::JointType;\n'
+        'using model::Link;\n'
+        '\n'
+        'namespace links\n'
+        '{\n'
+        '\n')
+    out.append('\n'.join(format_link(link) for link in links))
+    out.append(
+        '\n'
+        '}  // namespace links\n'
+        '\n'
+        'namespace joints\n'
+        '{\n'
+        '\n')
+    out.append('\n'.join(format_joint(joint) for joint in joints))
+    out.append(
+        '\n'
+        '}  // namespace joints\n'
+        '\n'
+        '// In URDF order\n')
+    out.append('constexpr std::array<Link, %d> kLinks{{\n' % len(links))
+    out.append(''.join('  links::%s,\n' % identifier(link.get('name')) for link in links))
+    out.append('}};\n')
+    out.append('constexpr std::array<Joint, %d> kJoints{{\n' % len(joints))
+    out.append(''.join('  joints::%s,\n' % identifier(joint.get('name')) for joint in joints))
+    out.append('}};\n')
+    out.append(
+        '\n'
+        'constexpr double kTotalMass = %s;\n'
+        '\n'
+        '}  // namespace robocap_model\n'
+        '}  // namespace robocap_kinematics\n'
+        '\n'
+        '#endif  // ROBOCAP_KINEMATICS__ROBOCAP_MODEL_HPP_\n' % literal(total_mass))
+    return ''.join(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument('urdf')
+    parser.add_argument('output')
+    parser.add_argument('--check', metavar='HEADER',
+                        help='fail unless HEADER already holds the generated code')
+    args = parser.parse_args()
+
+    header = generate(args.urdf)
+    if args.check:
+        try:
+            with open(args.check, 'r') as f:
+                current = f.read()
+        except OSError:
+            current = ''
+        if current != header:
+            sys.stderr.writelines(difflib.unified_diff(
+                current.splitlines(True), header.splitlines(True), args.check, 'generated'))
+            sys.stderr.write(
+                '\n%s is out of date with the URDF, regenerate it with\n'
+                '  %s %s <robocap_kinematics>/include/robocap_kinematics/robocap_model.hpp\n'
+                % (args.check, sys.argv[0], args.urdf))
+            return 1
+    with open(args.output, 'w') as f:
+        f.write(header)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,929 @@
+// Turns the chassis STL into a handful of convex collision hulls and decimated visual LODs at build
+// time, so physics never sees the raw mesh and nothing is re-parsed when the simulation starts.
+//
+// Convex decomposition is approximate, in the spirit of V-HACD: the mesh is voxelized, split into
+// connected parts, and the part whose convex hull wastes the most volume is cut along the plane
+// that minimizes the summed hull volume, until every part is close enough to convex or an
+// oversplit budget of kSplitFactor * max_hulls is spent. The parts are then merged back pairwise,
+// cheapest added hull volume first, while a merge stays within the concavity or there are more
+// than max_hulls. Last, every hull is cut down to max_faces by keeping the vertices farthest out.
+// Hulls are built over integer voxel corners, so the hull predicates are exact. LODs use vertex
+// clustering on progressively coarser grids.
+//
+// Usage: robocap_mesh_tool <input.stl> <output_dir> [--voxel-size 10] [--max-hulls 24]
+//                          [--max-faces 32] [--concavity 0.05] [--lod-cells 5,15,40]
+//                          [--scale 0.001] [--uri-prefix model://robocap/meshes/]
+//
+// Writes collision_<i>.stl, visual_lod<k>.stl and chassis_collision.xacro, which defines the
+// chassis_collision macro used by urdf/robot_core.xacro. Units are kept from the input, the xacro
+// applies --scale like the visual does.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+
+using Vec3f = std::array<float, 3>;
+using Vec3i = std::array<std::int64_t, 3>;
+using Triangle = std::array<std::uint32_t, 3>;
+
+struct Mesh
+{
+  std::vector<Vec3f> vertices;
+  std::vector<Triangle> triangles;
+};
+
+struct Options
+{
+  std::string input;
+  std::string output_dir;
+  float voxel_size = 10.0f;       // In input units
+  std::size_t max_hulls = 24;
+  std::size_t max_faces = 32;     // Per hull, at least 4
+  double concavity = 0.05;        // Fraction of hull volume allowed to be empty
+  std::vector<float> lod_cells = {5.0f, 15.0f, 40.0f};
+  std::string scale = "0.001";
+  std::string uri_prefix = "model://robocap/meshes/";
+};
+
+// ---- STL io ----
+
+bool read_stl(const std::string & path, Mesh & mesh)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+  std::map<Vec3f, std::uint32_t> index;
+  const auto add_vertex = [&](const Vec3f & v) {
+      const auto [it, inserted] = index.emplace(v, static_cast<std::uint32_t>(index.size()));
+      if (inserted) {
+        mesh.vertices.push_back(v);
+      }
+      return it->second;
+    };
+
+  std::uint32_t count = 0;
+  if (data.size() >= 84) {
+    std::memcpy(&count, data.data() + 80, sizeof(count));
+  }
+  const bool binary = data.size() >= 84 && data.size() == 84 + 50 * static_cast<std::size_t>(count);
+  if (binary) {
+    for (std::uint32_t i = 0; i < count; ++i) {
+      float values[12];
+      std::memcpy(values, data.data() + 84 + 50 * static_cast<std::size_t>(i), sizeof(values));
+      Triangle triangle;
+      for (int k = 0; k < 3; ++k) {
+        triangle[k] = add_vertex({values[3 + 3 * k], values[4 + 3 * k], values[5 + 3 * k]});
+      }
+      mesh.triangles.push_back(triangle);
+    }
+    return true;
+  }
+
+  // ASCII: every three "vertex x y z" lines make a facet
+  std::istringstream stream(data);
+  std::string token;
+  Triangle triangle;
+  int corner = 0;
+  while (stream >> token) {
+    if (token != "vertex") {
+      continue;
+    }
+    Vec3f v;
+    stream >> v[0] >> v[1] >> v[2];
+    triangle[corner++] = add_vertex(v);
+    if (corner == 3) {
+      mesh.triangles.push_back(triangle);
+      corner = 0;
+    }
+  }
+  return !mesh.triangles.empty();
+}
+
+bool write_stl(const std::string & path, const Mesh & mesh)
+{
+  std::ofstream file(path, std::ios::binary);
+  char header[80] = "robocap_mesh_tool";
+  file.write(header, sizeof(header));
+  const auto count = static_cast<std::uint32_t>(mesh.triangles.size());
+  file.write(reinterpret_cast<const char *>(&count), sizeof(count));
+  for (const auto & triangle : mesh.triangles) {
+    const auto & a = mesh.vertices[triangle[0]];
+    const auto & b = mesh.vertices[triangle[1]];
+    const auto & c = mesh.vertices[triangle[2]];
+    const Vec3f u{b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    const Vec3f v{c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+    Vec3f n{u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0]};
+    const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    if (length > 0.0f) {
+      n = {n[0] / length, n[1] / length, n[2] / length};
+    }
+    float values[12] = {n[0], n[1], n[2]};
+    for (int k = 0; k < 3; ++k) {
+      std::memcpy(values + 3 + 3 * k, mesh.vertices[triangle[k]].data(), sizeof(Vec3f));
+    }
+    const std::uint16_t attributes = 0;
+    file.write(reinterpret_cast<const char *>(values), sizeof(values));
+    file.write(reinterpret_cast<const char *>(&attributes), sizeof(attributes));
+  }
+  return static_cast<bool>(file);
+}
+
+// ---- Voxelization ----
+
+struct VoxelGrid
+{
+  Vec3f origin;
+  float size;
+  std::array<std::int64_t, 3> dims;
+  std::vector<std::uint8_t> solid;
+
+  std::int64_t index(std::int64_t i, std::int64_t j, std::int64_t k) const
+  {
+    return (k * dims[1] + j) * dims[0] + i;
+  }
+  bool inside(std::int64_t i, std::int64_t j, std::int64_t k) const
+  {
+    return i >= 0 && j >= 0 && k >= 0 && i < dims[0] && j < dims[1] && k < dims[2];
+  }
+};
+
+constexpr std::array<std::array<int, 3>, 6> kNeighbors = {{
+  {{1, 0, 0}}, {{-1, 0, 0}}, {{0, 1, 0}}, {{0, -1, 0}}, {{0, 0, 1}}, {{0, 0, -1}}}};
+
+// Marks the surface by sampling each triangle finer than a voxel, then fills everything the
+// outside cannot reach. Small holes in the mesh only lose the interior behind them.
+VoxelGrid voxelize(const Mesh & mesh, float size)
+{
+  Vec3f lo = mesh.vertices.front();
+  Vec3f hi = lo;
+  for (const auto & v : mesh.vertices) {
+    for (int a = 0; a < 3; ++a) {
+      lo[a] = std::min(lo[a], v[a]);
+      hi[a] = std::max(hi[a], v[a]);
+    }
+  }
+  VoxelGrid grid;
+  grid.size = size;
+  for (int a = 0; a < 3; ++a) {
+    grid.origin[a] = lo[a] - size;  // One empty voxel of padding for the flood fill
+    grid.dims[a] = static_cast<std::int64_t>(std::ceil((hi[a] - lo[a]) / size)) + 3;
+  }
+  const auto cells = grid.dims[0] * grid.dims[1] * grid.dims[2];
+  std::vector<std::uint8_t> surface(static_cast<std::size_t>(cells), 0);
+
+  for (const auto & triangle : mesh.triangles) {
+    const auto & a = mesh.vertices[triangle[0]];
+    const auto & b = mesh.vertices[triangle[1]];
+    const auto & c = mesh.vertices[triangle[2]];
+    float longest = 0.0f;
+    for (const auto & [p, q] : {std::make_pair(a, b), std::make_pair(b, c), std::make_pair(c, a)}) {
+      longest = std::max(
+        longest, std::sqrt(
+          (p[0] - q[0]) * (p[0] - q[0]) + (p[1] - q[1]) * (p[1] - q[1]) +
+          (p[2] - q[2]) * (p[2] - q[2])));
+    }
+    const int steps = std::max(1, static_cast<int>(std::ceil(2.0f * longest / size)));
+    for (int s = 0; s <= steps; ++s) {
+      for (int t = 0; s + t <= steps; ++t) {
+        const float u = static_cast<float>(s) / steps;
+        const float v = static_cast<float>(t) / steps;
+        std::array<std::int64_t, 3> cell;
+        for (int axis = 0; axis < 3; ++axis) {
+          const float p = a[axis] + u * (b[axis] - a[axis]) + v * (c[axis] - a[axis]);
+          cell[axis] = static_cast<std::int64_t>(std::floor((p - grid.origin[axis]) / size));
+        }
+        if (grid.inside(cell[0], cell[1], cell[2])) {
+          surface[static_cast<std::size_t>(grid.index(cell[0], cell[1], cell[2]))] = 1;
+        }
+      }
+    }
+  }
+
+  std::vector<std::uint8_t> outside(static_cast<std::size_t>(cells), 0);
+  std::vector<std::array<std::int64_t, 3>> stack = {{0, 0, 0}};
+  outside[0] = 1;
+  while (!stack.empty()) {
+    const auto cell = stack.back();
+    stack.pop_back();
+    for (const auto & n : kNeighbors) {
+      const std::int64_t i = cell[0] + n[0], j = cell[1] + n[1], k = cell[2] + n[2];
+      if (!grid.inside(i, j, k)) {
+        continue;
+      }
+      const auto id = static_cast<std::size_t>(grid.index(i, j, k));
+      if (!outside[id] && !surface[id]) {
+        outside[id] = 1;
+        stack.push_back({i, j, k});
+      }
+    }
+  }
+  grid.solid.resize(static_cast<std::size_t>(cells));
+  for (std::size_t i = 0; i < grid.solid.size(); ++i) {
+    grid.solid[i] = outside[i] ? 0 : 1;
+  }
+  return grid;
+}
+
+// ---- Exact convex hull over integer points ----
+
+struct Hull
+{
+  std::vector<Vec3i> vertices;
+  std::vector<Triangle> faces;
+  double volume = 0.0;  // In voxels
+};
+
+std::int64_t orient(const Vec3i & a, const Vec3i & b, const Vec3i & c, const Vec3i & d)
+{
+  const std::int64_t ux = b[0] - a[0], uy = b[1] - a[1], uz = b[2] - a[2];
+  const std::int64_t vx = c[0] - a[0], vy = c[1] - a[1], vz = c[2] - a[2];
+  const std::int64_t wx = d[0] - a[0], wy = d[1] - a[1], wz = d[2] - a[2];
+  return wx * (uy * vz - uz * vy) + wy * (uz * vx - ux * vz) + wz * (ux * vy - uy * vx);
+}
+
+// Incremental hull: each point outside the current hull replaces the faces it sees with a fan to
+// their horizon. Coplanar points count as inside, which keeps the result free of slivers.
+Hull convex_hull(std::vector<Vec3i> points)
+{
+  Hull hull;
+  if (points.size() < 4) {
+    return hull;
+  }
+  // Seed tetrahedron from extreme points
+  std::size_t i0 = 0;
+  for (std::size_t i = 1; i < points.size(); ++i) {
+    if (points[i] < points[i0]) {
+      i0 = i;
+    }
+  }
+  const auto distance2 = [&](std::size_t i, std::size_t j) {
+      std::int64_t sum = 0;
+      for (int a = 0; a < 3; ++a) {
+        sum += (points[i][a] - points[j][a]) * (points[i][a] - points[j][a]);
+      }
+      return sum;
+    };
+  std::size_t i1 = i0;
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    if (distance2(i, i0) > distance2(i1, i0)) {
+      i1 = i;
+    }
+  }
+  std::size_t i2 = i0;
+  std::int64_t best_area = 0;
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    const auto & a = points[i0];
+    const auto & b = points[i1];
+    const auto & c = points[i];
+    const std::int64_t ux = b[0] - a[0], uy = b[1] - a[1], uz = b[2] - a[2];
+    const std::int64_t vx = c[0] - a[0], vy = c[1] - a[1], vz = c[2] - a[2];
+    const std::int64_t nx = uy * vz - uz * vy, ny = uz * vx - ux * vz, nz = ux * vy - uy * vx;
+    const std::int64_t area = nx * nx + ny * ny + nz * nz;
+    if (area > best_area) {
+      best_area = area;
+      i2 = i;
+    }
+  }
+  std::size_t i3 = i0;
+  std::int64_t best_volume = 0;
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    const auto volume = std::abs(orient(points[i0], points[i1], points[i2], points[i]));
+    if (volume > best_volume) {
+      best_volume = volume;
+      i3 = i;
+    }
+  }
+  if (best_area == 0 || best_volume == 0) {
+    return hull;  // Flat point set
+  }
+
+  const std::array<std::size_t, 4> seed = {i0, i1, i2, i3};
+  std::vector<Vec3i> & v = hull.vertices;
+  for (const auto i : seed) {
+    v.push_back(points[i]);
+  }
+  for (auto i : {i3, i2, i1, i0}) {  // Descending, so the indices stay valid
+    points[i] = points.back();
+    points.pop_back();
+  }
+
+  struct Face
+  {
+    Triangle corners;
+    bool alive;
+  };
+  std::vector<Face> faces;
+  const std::array<std::array<std::uint32_t, 4>, 4> tetra = {{
+    {{0, 1, 2, 3}}, {{0, 1, 3, 2}}, {{0, 2, 3, 1}}, {{1, 2, 3, 0}}}};
+  for (const auto & f : tetra) {
+    // Outward means the opposite corner is on the negative side
+    if (orient(v[f[0]], v[f[1]], v[f[2]], v[f[3]]) < 0) {
+      faces.push_back({{f[0], f[1], f[2]}, true});
+    } else {
+      faces.push_back({{f[0], f[2], f[1]}, true});
+    }
+  }
+
+  std::mt19937 rng(1);
+  std::shuffle(points.begin(), points.end(), rng);
+  std::vector<std::size_t> visible;
+  std::unordered_set<std::uint64_t> edges;
+  const auto edge_key = [](std::uint32_t a, std::uint32_t b) {
+      return (static_cast<std::uint64_t>(a) << 32) | b;
+    };
+  for (const auto & p : points) {
+    visible.clear();
+    for (std::size_t f = 0; f < faces.size(); ++f) {
+      const auto & c = faces[f].corners;
+      if (faces[f].alive && orient(v[c[0]], v[c[1]], v[c[2]], p) > 0) {
+        visible.push_back(f);
+      }
+    }
+    if (visible.empty()) {
+      continue;
+    }
+    edges.clear();
+    for (const auto f : visible) {
+      const auto & c = faces[f].corners;
+      edges.insert(edge_key(c[0], c[1]));
+      edges.insert(edge_key(c[1], c[2]));
+      edges.insert(edge_key(c[2], c[0]));
+    }
+    const auto apex = static_cast<std::uint32_t>(v.size());
+    v.push_back(p);
+    for (const auto f : visible) {
+      faces[f].alive = false;
+      const auto c = faces[f].corners;
+      for (int e = 0; e < 3; ++e) {
+        const auto a = c[e];
+        const auto b = c[(e + 1) % 3];
+        if (!edges.count(edge_key(b, a))) {  // Horizon edge
+          faces.push_back({{a, b, apex}, true});
+        }
+      }
+    }
+    if (faces.size() > 4096) {
+      faces.erase(
+        std::remove_if(faces.begin(), faces.end(), [](const Face & f) {return !f.alive;}),
+        faces.end());
+    }
+  }
+
+  // Keep only the vertices that ended up on a face
+  std::vector<std::int64_t> remap(v.size(), -1);
+  std::vector<Vec3i> used;
+  for (const auto & face : faces) {
+    if (!face.alive) {
+      continue;
+    }
+    Triangle corners;
+    for (int k = 0; k < 3; ++k) {
+      auto & id = remap[face.corners[k]];
+      if (id < 0) {
+        id = static_cast<std::int64_t>(used.size());
+        used.push_back(v[face.corners[k]]);
+      }
+      corners[k] = static_cast<std::uint32_t>(id);
+    }
+    hull.faces.push_back(corners);
+  }
+  hull.vertices = std::move(used);
+  const Vec3i & o = hull.vertices.front();
+  std::int64_t six_volume = 0;
+  for (const auto & f : hull.faces) {
+    six_volume += orient(o, hull.vertices[f[0]], hull.vertices[f[1]], hull.vertices[f[2]]);
+  }
+  hull.volume = static_cast<double>(std::abs(six_volume)) / 6.0;
+  return hull;
+}
+
+// ---- Decomposition ----
+
+struct Part
+{
+  std::vector<Vec3i> voxels;
+  Hull hull;
+  double concavity = 0.0;
+  bool final = false;
+};
+
+std::uint64_t pack(std::int64_t i, std::int64_t j, std::int64_t k)
+{
+  return (static_cast<std::uint64_t>(i + 1) << 42) | (static_cast<std::uint64_t>(j + 1) << 21) |
+         static_cast<std::uint64_t>(k + 1);
+}
+
+// Corners of the voxels on the part's boundary, the only ones that can be hull vertices
+std::vector<Vec3i> hull_points(const std::vector<Vec3i> & voxels)
+{
+  std::unordered_set<std::uint64_t> occupied;
+  for (const auto & c : voxels) {
+    occupied.insert(pack(c[0], c[1], c[2]));
+  }
+  std::unordered_set<std::uint64_t> seen;
+  std::vector<Vec3i> points;
+  for (const auto & c : voxels) {
+    bool boundary = false;
+    for (const auto & n : kNeighbors) {
+      if (!occupied.count(pack(c[0] + n[0], c[1] + n[1], c[2] + n[2]))) {
+        boundary = true;
+        break;
+      }
+    }
+    if (!boundary) {
+      continue;
+    }
+    for (int corner = 0; corner < 8; ++corner) {
+      const Vec3i p{c[0] + (corner & 1), c[1] + ((corner >> 1) & 1), c[2] + ((corner >> 2) & 1)};
+      if (seen.insert(pack(p[0], p[1], p[2])).second) {
+        points.push_back(p);
+      }
+    }
+  }
+  return points;
+}
+
+// Fraction of the hull's volume the voxels leave empty
+double hull_concavity(std::size_t voxels, const Hull & hull)
+{
+  return hull.volume > 0.0 ?
+         std::max(0.0, 1.0 - static_cast<double>(voxels) / hull.volume) : 0.0;
+}
+
+Part make_part(std::vector<Vec3i> voxels)
+{
+  Part part;
+  part.voxels = std::move(voxels);
+  part.hull = convex_hull(hull_points(part.voxels));
+  part.concavity = hull_concavity(part.voxels.size(), part.hull);
+  return part;
+}
+
+std::vector<std::vector<Vec3i>> connected_components(const std::vector<Vec3i> & voxels)
+{
+  std::unordered_set<std::uint64_t> remaining;
+  for (const auto & c : voxels) {
+    remaining.insert(pack(c[0], c[1], c[2]));
+  }
+  std::vector<std::vector<Vec3i>> components;
+  for (const auto & start : voxels) {
+    if (!remaining.erase(pack(start[0], start[1], start[2]))) {
+      continue;
+    }
+    std::vector<Vec3i> component = {start};
+    for (std::size_t i = 0; i < component.size(); ++i) {
+      const auto c = component[i];
+      for (const auto & n : kNeighbors) {
+        const Vec3i next{c[0] + n[0], c[1] + n[1], c[2] + n[2]};
+        if (remaining.erase(pack(next[0], next[1], next[2]))) {
+          component.push_back(next);
+        }
+      }
+    }
+    components.push_back(std::move(component));
+  }
+  return components;
+}
+
+// Cuts along the candidate plane that minimizes the summed hull volume of the two halves
+std::vector<Part> split(const Part & part)
+{
+  Vec3i lo = part.voxels.front();
+  Vec3i hi = lo;
+  for (const auto & c : part.voxels) {
+    for (int a = 0; a < 3; ++a) {
+      lo[a] = std::min(lo[a], c[a]);
+      hi[a] = std::max(hi[a], c[a]);
+    }
+  }
+  double best_cost = part.hull.volume;
+  int best_axis = -1;
+  std::int64_t best_plane = 0;
+  for (int axis = 0; axis < 3; ++axis) {
+    const auto extent = hi[axis] - lo[axis] + 1;
+    if (extent < 2) {
+      continue;
+    }
+    for (const double fraction : {0.25, 0.5, 0.75}) {
+      const auto plane = lo[axis] + std::max<std::int64_t>(
+        1, static_cast<std::int64_t>(std::llround(fraction * static_cast<double>(extent))));
+      std::vector<Vec3i> below;
+      std::vector<Vec3i> above;
+      for (const auto & c : part.voxels) {
+        (c[axis] < plane ? below : above).push_back(c);
+      }
+      if (below.empty() || above.empty()) {
+        continue;
+      }
+      const double cost = convex_hull(hull_points(below)).volume +
+        convex_hull(hull_points(above)).volume;
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_axis = axis;
+        best_plane = plane;
+      }
+    }
+  }
+  if (best_axis < 0) {
+    return {};
+  }
+  std::vector<Vec3i> below;
+  std::vector<Vec3i> above;
+  for (const auto & c : part.voxels) {
+    (c[best_axis] < best_plane ? below : above).push_back(c);
+  }
+  std::vector<Part> parts;
+  for (auto * half : {&below, &above}) {
+    for (auto & component : connected_components(*half)) {
+      parts.push_back(make_part(std::move(component)));
+    }
+  }
+  return parts;
+}
+
+// Hull of both parts' hull vertices, which is the hull of their union
+Hull merged_hull(const Part & a, const Part & b)
+{
+  std::vector<Vec3i> points = a.hull.vertices;
+  points.insert(points.end(), b.hull.vertices.begin(), b.hull.vertices.end());
+  return convex_hull(std::move(points));
+}
+
+// [voxels] from the plane through face `f` to `p`, positive outside
+double face_distance(const Hull & hull, const Triangle & f, const Vec3i & p)
+{
+  const auto & a = hull.vertices[f[0]];
+  const auto & b = hull.vertices[f[1]];
+  const auto & c = hull.vertices[f[2]];
+  const double ux = b[0] - a[0], uy = b[1] - a[1], uz = b[2] - a[2];
+  const double vx = c[0] - a[0], vy = c[1] - a[1], vz = c[2] - a[2];
+  const double nx = uy * vz - uz * vy, ny = uz * vx - ux * vz, nz = ux * vy - uy * vx;
+  const double length = std::sqrt(nx * nx + ny * ny + nz * nz);
+  return length > 0.0 ? static_cast<double>(orient(a, b, c, p)) / length : 0.0;
+}
+
+// Rebuilds `hull` from the fewest of its vertices that keep it within `max_faces`: starting from
+// the extremes along each axis, the vertex farthest outside the current hull is added while the
+// result still fits. The simplified hull lies inside the original one
+Hull simplify(const Hull & hull, std::size_t max_faces)
+{
+  if (hull.faces.size() <= max_faces) {
+    return hull;
+  }
+  const auto & points = hull.vertices;
+  std::vector<std::uint8_t> taken(points.size(), 0);
+  std::vector<Vec3i> selected;
+  for (int axis = 0; axis < 3; ++axis) {
+    std::size_t lo = 0;
+    std::size_t hi = 0;
+    for (std::size_t i = 1; i < points.size(); ++i) {
+      lo = points[i][axis] < points[lo][axis] ? i : lo;
+      hi = points[i][axis] > points[hi][axis] ? i : hi;
+    }
+    for (const auto i : {lo, hi}) {
+      if (!taken[i]) {
+        taken[i] = 1;
+        selected.push_back(points[i]);
+      }
+    }
+  }
+  Hull current = convex_hull(selected);
+  while (true) {
+    std::size_t farthest = points.size();
+    double farthest_distance = 0.0;
+    for (std::size_t i = 0; i < points.size(); ++i) {
+      if (taken[i]) {
+        continue;
+      }
+      double distance = current.faces.empty() ? 1.0 : -1.0;
+      for (const auto & f : current.faces) {
+        distance = std::max(distance, face_distance(current, f, points[i]));
+      }
+      if (distance > farthest_distance) {
+        farthest = i;
+        farthest_distance = distance;
+      }
+    }
+    if (farthest == points.size()) {
+      break;
+    }
+    taken[farthest] = 1;
+    selected.push_back(points[farthest]);
+    Hull next = convex_hull(selected);
+    if (next.faces.size() > max_faces && !current.faces.empty()) {
+      break;
+    }
+    current = std::move(next);
+  }
+  return current;
+}
+
+// Parts are oversplit to this many times max_hulls before merging back
+constexpr std::size_t kSplitFactor = 4;
+
+std::vector<Part> decompose(const VoxelGrid & grid, const Options & options)
+{
+  std::vector<Vec3i> voxels;
+  for (std::int64_t k = 0; k < grid.dims[2]; ++k) {
+    for (std::int64_t j = 0; j < grid.dims[1]; ++j) {
+      for (std::int64_t i = 0; i < grid.dims[0]; ++i) {
+        if (grid.solid[static_cast<std::size_t>(grid.index(i, j, k))]) {
+          voxels.push_back({i, j, k});
+        }
+      }
+    }
+  }
+  std::vector<Part> parts;
+  for (auto & component : connected_components(voxels)) {
+    parts.push_back(make_part(std::move(component)));
+  }
+
+  const std::size_t split_budget = kSplitFactor * options.max_hulls;
+  while (parts.size() < split_budget) {
+    // Split where the most empty volume would be gained
+    std::size_t worst = parts.size();
+    double worst_waste = 0.0;
+    for (std::size_t i = 0; i < parts.size(); ++i) {
+      const double waste = parts[i].concavity * parts[i].hull.volume;
+      if (!parts[i].final && parts[i].concavity > options.concavity && waste > worst_waste) {
+        worst = i;
+        worst_waste = waste;
+      }
+    }
+    if (worst == parts.size()) {
+      break;
+    }
+    auto pieces = split(parts[worst]);
+    if (pieces.empty() || parts.size() - 1 + pieces.size() > split_budget) {
+      parts[worst].final = true;
+      continue;
+    }
+    parts.erase(parts.begin() + static_cast<std::ptrdiff_t>(worst));
+    for (auto & piece : pieces) {
+      parts.push_back(std::move(piece));
+    }
+  }
+  // Flat or single-voxel specks have no hull and nothing to collide with
+  parts.erase(
+    std::remove_if(parts.begin(), parts.end(), [](const Part & p) {return p.hull.faces.empty();}),
+    parts.end());
+
+  // Merge back the pair whose merged hull adds the least volume over the two hulls, for free
+  // while the result is still within the concavity, at any cost while there are too many hulls.
+  // Merged hulls are cached per pair, a merge only recomputes the merged part's row
+  std::vector<std::vector<Hull>> pairs(parts.size(), std::vector<Hull>(parts.size()));
+  for (std::size_t a = 0; a < parts.size(); ++a) {
+    for (std::size_t b = a + 1; b < parts.size(); ++b) {
+      pairs[a][b] = merged_hull(parts[a], parts[b]);
+    }
+  }
+  while (parts.size() > 1) {
+    std::size_t best_a = 0;
+    std::size_t best_b = 1;
+    double best_cost = std::numeric_limits<double>::infinity();
+    for (std::size_t a = 0; a < parts.size(); ++a) {
+      for (std::size_t b = a + 1; b < parts.size(); ++b) {
+        const double cost = pairs[a][b].volume - parts[a].hull.volume - parts[b].hull.volume;
+        if (cost < best_cost) {
+          best_a = a;
+          best_b = b;
+          best_cost = cost;
+        }
+      }
+    }
+    const std::size_t voxels = parts[best_a].voxels.size() + parts[best_b].voxels.size();
+    if (parts.size() <= options.max_hulls &&
+      hull_concavity(voxels, pairs[best_a][best_b]) > options.concavity)
+    {
+      break;
+    }
+    auto & merged = parts[best_a];
+    merged.voxels.insert(
+      merged.voxels.end(), parts[best_b].voxels.begin(), parts[best_b].voxels.end());
+    merged.hull = std::move(pairs[best_a][best_b]);
+    merged.concavity = hull_concavity(merged.voxels.size(), merged.hull);
+    parts.erase(parts.begin() + static_cast<std::ptrdiff_t>(best_b));
+    pairs.erase(pairs.begin() + static_cast<std::ptrdiff_t>(best_b));
+    for (auto & row : pairs) {
+      row.erase(row.begin() + static_cast<std::ptrdiff_t>(best_b));
+    }
+    for (std::size_t other = 0; other < parts.size(); ++other) {
+      if (other != best_a) {
+        const auto a = std::min(other, best_a);
+        const auto b = std::max(other, best_a);
+        pairs[a][b] = merged_hull(parts[a], parts[b]);
+      }
+    }
+  }
+
+  for (auto & part : parts) {
+    part.hull = simplify(part.hull, options.max_faces);
+    part.concavity = hull_concavity(part.voxels.size(), part.hull);
+  }
+  parts.erase(
+    std::remove_if(parts.begin(), parts.end(), [](const Part & p) {return p.hull.faces.empty();}),
+    parts.end());
+  return parts;
+}
+
+// ---- Visual LODs ----
+
+Mesh cluster_vertices(const Mesh & mesh, float cell)
+{
+  Vec3f lo = mesh.vertices.front();
+  for (const auto & v : mesh.vertices) {
+    for (int a = 0; a < 3; ++a) {
+      lo[a] = std::min(lo[a], v[a]);
+    }
+  }
+  std::map<std::array<std::int64_t, 3>, std::uint32_t> cells;
+  std::vector<std::array<double, 4>> sums;  // x, y, z, count
+  std::vector<std::uint32_t> remap(mesh.vertices.size());
+  for (std::size_t i = 0; i < mesh.vertices.size(); ++i) {
+    const auto & v = mesh.vertices[i];
+    std::array<std::int64_t, 3> key;
+    for (int a = 0; a < 3; ++a) {
+      key[a] = static_cast<std::int64_t>(std::floor((v[a] - lo[a]) / cell));
+    }
+    const auto [it, inserted] = cells.emplace(key, static_cast<std::uint32_t>(sums.size()));
+    if (inserted) {
+      sums.push_back({0.0, 0.0, 0.0, 0.0});
+    }
+    auto & sum = sums[it->second];
+    sum = {sum[0] + v[0], sum[1] + v[1], sum[2] + v[2], sum[3] + 1.0};
+    remap[i] = it->second;
+  }
+  Mesh lod;
+  for (const auto & sum : sums) {
+    lod.vertices.push_back(
+      {static_cast<float>(sum[0] / sum[3]), static_cast<float>(sum[1] / sum[3]),
+        static_cast<float>(sum[2] / sum[3])});
+  }
+  std::set<Triangle> seen;
+  for (const auto & triangle : mesh.triangles) {
+    const Triangle t{remap[triangle[0]], remap[triangle[1]], remap[triangle[2]]};
+    if (t[0] == t[1] || t[1] == t[2] || t[2] == t[0]) {
+      continue;
+    }
+    // Same corners in either winding are the same triangle
+    Triangle key = t;
+    std::sort(key.begin(), key.end());
+    if (seen.insert(key).second) {
+      lod.triangles.push_back(t);
+    }
+  }
+  return lod;
+}
+
+// ---- Output ----
+
+Mesh hull_mesh(const Hull & hull, const VoxelGrid & grid)
+{
+  Mesh mesh;
+  for (const auto & p : hull.vertices) {
+    mesh.vertices.push_back(
+      {grid.origin[0] + static_cast<float>(p[0]) * grid.size,
+        grid.origin[1] + static_cast<float>(p[1]) * grid.size,
+        grid.origin[2] + static_cast<float>(p[2]) * grid.size});
+  }
+  mesh.triangles = hull.faces;
+  return mesh;
+}
+
+bool write_collision_xacro(const std::string & path, std::size_t hulls, const Options & options)
+{
+  std::ofstream out(path);
+  out << "<?xml version=\"1.0\"?>\n"
+      << "<!-- Generated by robocap_mesh_tool from "
+      << std::filesystem::path(options.input).filename().string() << ", do not edit -->\n"
+      << "<robot xmlns:xacro=\"http://www.ros.org/wiki/xacro\">\n\n"
+      << "    <xacro:macro name=\"chassis_collision\">\n";
+  for (std::size_t i = 0; i < hulls; ++i) {
+    out << "        <collision name=\"chassis_hull_" << i << "\">\n"
+        << "            <geometry>\n"
+        << "                <mesh filename=\"" << options.uri_prefix << "collision_" << i
+        << ".stl\" scale=\"" << options.scale << " " << options.scale << " " << options.scale
+        << "\"/>\n"
+        << "            </geometry>\n"
+        << "        </collision>\n";
+  }
+  out << "    </xacro:macro>\n\n"
+      << "</robot>\n";
+  return static_cast<bool>(out);
+}
+
+bool parse_options(int argc, char ** argv, Options & options)
+{
+  if (argc < 3) {
+    return false;
+  }
+  options.input = argv[1];
+  options.output_dir = argv[2];
+  for (int i = 3; i + 1 < argc; i += 2) {
+    const std::string flag = argv[i];
+    const std::string value = argv[i + 1];
+    if (flag == "--voxel-size") {
+      options.voxel_size = std::stof(value);
+    } else if (flag == "--max-hulls") {
+      options.max_hulls = std::stoul(value);
+    } else if (flag == "--max-faces") {
+      options.max_faces = std::stoul(value);
+    } else if (flag == "--concavity") {
+      options.concavity = std::stod(value);
+    } else if (flag == "--lod-cells") {
+      options.lod_cells.clear();
+      std::stringstream list(value);
+      std::string cell;
+      while (std::getline(list, cell, ',')) {
+        options.lod_cells.push_back(std::stof(cell));
+      }
+    } else if (flag == "--scale") {
+      options.scale = value;
+    } else if (flag == "--uri-prefix") {
+      options.uri_prefix = value;
+    } else {
+      std::cerr << "Unknown argument " << flag << std::endl;
+      return false;
+    }
+  }
+  return options.voxel_size > 0.0f && options.max_hulls > 0 && options.max_faces >= 4;
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  Options options;
+  if (!parse_options(argc, argv, options)) {
+    std::cerr << "Usage: " << argv[0] << " <input.stl> <output_dir> [--voxel-size 10]"
+      " [--max-hulls 24] [--max-faces 32] [--concavity 0.05] [--lod-cells 5,15,40]"
+      " [--scale 0.001] [--uri-prefix model://robocap/meshes/]" << std::endl;
+    return 1;
+  }
+
+  Mesh mesh;
+  if (!read_stl(options.input, mesh)) {
+    std::cerr << "Failed to read " << options.input << std::endl;
+    return 1;
+  }
+  namespace fs = std::filesystem;
+  fs::create_directories(options.output_dir);
+  // Hull count can shrink between runs, stale files would otherwise be installed too
+  for (const auto & entry : fs::directory_iterator(options.output_dir)) {
+    if (entry.path().filename().string().rfind("collision_", 0) == 0) {
+      fs::remove(entry.path());
+    }
+  }
+
+  const auto grid = voxelize(mesh, options.voxel_size);
+  const auto parts = decompose(grid, options);
+  std::size_t collision_faces = 0;
+  for (std::size_t i = 0; i < parts.size(); ++i) {
+    const auto path = (fs::path(options.output_dir) / ("collision_" + std::to_string(i) + ".stl"));
+    if (!write_stl(path.string(), hull_mesh(parts[i].hull, grid))) {
+      std::cerr << "Failed to write " << path << std::endl;
+      return 1;
+    }
+    std::cout << "collision_" << i << ".stl: " << parts[i].hull.faces.size() << " faces, " <<
+      static_cast<int>(100.0 * parts[i].concavity) << "% empty" << std::endl;
+    collision_faces += parts[i].hull.faces.size();
+  }
+  std::cout << "collision: " << collision_faces << " faces in " << parts.size() << " hulls, of " <<
+    mesh.triangles.size() << " triangles" << std::endl;
+  const auto xacro = (fs::path(options.output_dir) / "chassis_collision.xacro").string();
+  if (!write_collision_xacro(xacro, parts.size(), options)) {
+    std::cerr << "Failed to write " << xacro << std::endl;
+    return 1;
+  }
+
+  for (std::size_t k = 0; k < options.lod_cells.size(); ++k) {
+    const auto lod = cluster_vertices(mesh, options.lod_cells[k]);
+    const auto path = (fs::path(options.output_dir) / ("visual_lod" + std::to_string(k) + ".stl"));
+    if (!write_stl(path.string(), lod)) {
+      std::cerr << "Failed to write " << path << std::endl;
+      return 1;
+    }
+    std::cout << "visual_lod" << k << ".stl: " << lod.triangles.size() << " of " <<
+      mesh.triangles.size() << " triangles" << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,154 @@
+#ifndef ROBOCAP_TELEMETRY__RING_LOG_HPP_
+#define ROBOCAP_TELEMETRY__RING_LOG_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace robocap_telemetry
+{
+
+// On-disk layout of a ring log: a header page followed by one array of `capacity` 8-byte values
+// per column. Record i lives in slot i % capacity of every column, so one column of a time slice
+// is at most two contiguous runs in the mapping and can be read without touching the others.
+//
+// The single writer fills every column of record i, then publishes it by storing write_count =
+// i + 1 with release ordering. Readers may map the file while it is being written: a record they
+// copied is intact if, after copying, it is still newer than write_count - capacity.
+constexpr std::uint64_t kMagic = 0x474f4c5043424f52;  // "ROBCPLOG"
+constexpr std::uint32_t kVersion = 1;
+constexpr std::size_t kColumnNameSize = 32;
+constexpr std::size_t kHeaderSize = 4096;
+constexpr std::size_t kColumnTableOffset = 128;
+
+enum class ColumnType : std::uint32_t
+{
+  kInt64 = 0,
+  kFloat64 = 1,
+};
+
+struct FileHeader
+{
+  std::uint64_t magic;
+  std::uint32_t version;
+  std::uint32_t column_count;
+  std::uint64_t capacity;  // Records, a power of two
+  alignas(64) std::atomic<std::uint64_t> write_count;
+};
+
+// column_count of these start at kColumnTableOffset
+struct ColumnInfo
+{
+  char name[kColumnNameSize];
+  ColumnType type;
+  std::uint32_t reserved;
+  std::uint64_t offset;  // Of the column's slot array, from the start of the file
+};
+
+static_assert(sizeof(FileHeader) <= kColumnTableOffset, "header overlaps the column table");
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "readers map write_count");
+constexpr std::size_t kMaxColumns = (kHeaderSize - kColumnTableOffset) / sizeof(ColumnInfo);
+
+struct ColumnSpec
+{
+  std::string name;
+  ColumnType type;
+};
+
+// Appends fixed-schema records to a ring file. set()/commit() are wait-free and only write memory
+// that open() mapped and faulted in, so they are safe to call from the physics thread.
+class RingLogWriter
+{
+public:
+  RingLogWriter() = default;
+  ~RingLogWriter();
+  RingLogWriter(const RingLogWriter &) = delete;
+  RingLogWriter & operator=(const RingLogWriter &) = delete;
+
+  // Creates or truncates `path`. `capacity` is rounded up to a power of two
+  bool open(
+    const std::string & path, const std::vector<ColumnSpec> & columns, std::size_t capacity);
+  void close();
+  bool is_open() const {return header_ != nullptr;}
+
+  // Fill the pending record column by column, then commit() it. Unset columns keep whatever the
+  // slot held capacity records ago
+  void set(std::size_t column, double value)
+  {
+    std::memcpy(&columns_[column][slot_], &value, sizeof(value));
+  }
+  void set(std::size_t column, std::int64_t value)
+  {
+    std::memcpy(&columns_[column][slot_], &value, sizeof(value));
+  }
+  void commit()
+  {
+    header_->write_count.store(++count_, std::memory_order_release);
+    slot_ = count_ & mask_;
+  }
+
+private:
+  FileHeader * header_ = nullptr;
+  std::vector<std::uint64_t *> columns_;
+  std::uint64_t mask_ = 0;
+  std::uint64_t count_ = 0;
+  std::uint64_t slot_ = 0;
+  void * mapping_ = nullptr;
+  std::size_t mapping_size_ = 0;
+};
+
+// Read-only view of a ring log, which may still be written to
+class RingLogReader
+{
+public:
+  RingLogReader() = default;
+  ~RingLogReader();
+  RingLogReader(const RingLogReader &) = delete;
+  RingLogReader & operator=(const RingLogReader &) = delete;
+
+  bool open(const std::string & path);
+  void close();
+
+  const std::vector<ColumnSpec> & columns() const {return columns_;}
+  // Index into columns(), or -1
+  int find(const std::string & name) const;
+  std::uint64_t capacity() const {return capacity_;}
+
+  // Records [begin, end) in write order
+  struct Range
+  {
+    std::uint64_t begin;
+    std::uint64_t end;
+  };
+  // Records currently held by the ring
+  Range range() const;
+
+  // First record in `range` whose int64 `column` is >= value, for columns that only grow such as
+  // sim_time_ns. Reads O(log n) values of that one column
+  std::uint64_t lower_bound(int column, std::int64_t value, Range range) const;
+
+  // Copies one column of `range` into `out` without touching any other column. Returns the first
+  // record that was still intact after the copy; out[0 .. result - range.begin) was overwritten
+  // by the writer meanwhile and has to be dropped
+  std::uint64_t read(int column, Range range, std::vector<double> & out) const;
+  std::uint64_t read(int column, Range range, std::vector<std::int64_t> & out) const;
+
+private:
+  template<typename T>
+  std::uint64_t read_column(int column, Range range, std::vector<T> & out) const;
+  std::int64_t int_at(int column, std::uint64_t record) const;
+
+  const FileHeader * header_ = nullptr;
+  std::vector<ColumnSpec> columns_;
+  std::vector<const std::uint64_t *> data_;
+  std::uint64_t capacity_ = 0;
+  const void * mapping_ = nullptr;
+  std::size_t mapping_size_ = 0;
+};
+
+}  // namespace robocap_telemetry
+
+#endif  // ROBOCAP_TELEMETRY__RING_LOG_HPP_
@@ -0,0 +1,58 @@
+#ifndef ROBOCAP_TELEMETRY__TELEMETRY_RECORDER_HPP_
+#define ROBOCAP_TELEMETRY__TELEMETRY_RECORDER_HPP_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ignition/gazebo/Entity.hh"
+#include "ignition/gazebo/System.hh"
+
+#include "robocap_telemetry/ring_log.hpp"
+
+namespace robocap_telemetry
+{
+
+// Records wheel joint states and commands, wheel contacts and the base pose and twist on every
+// physics step into a RingLogWriter file. The physics thread only copies numbers into the mapped
+// ring; the kernel writes the pages back in its own time.
+//
+// SDF parameters:
+//   <path>      ring file, defaults to $ROBOCAP_TELEMETRY_FILE. Recording is off if neither is set
+//   <capacity>  records kept, defaults to 262144 (about 4 minutes at 1 kHz)
+//   <joint>     wheel joint to record, repeated. Defaults to wheel_1_joint..wheel_3_joint
+class TelemetryRecorder
+  : public ignition::gazebo::System,
+  public ignition::gazebo::ISystemConfigure,
+  public ignition::gazebo::ISystemPostUpdate
+{
+public:
+  TelemetryRecorder() = default;
+
+  void Configure(
+    const ignition::gazebo::Entity & entity, const std::shared_ptr<const sdf::Element> & sdf,
+    ignition::gazebo::EntityComponentManager & ecm,
+    ignition::gazebo::EventManager & event_manager) override;
+
+  void PostUpdate(
+    const ignition::gazebo::UpdateInfo & info,
+    const ignition::gazebo::EntityComponentManager & ecm) override;
+
+private:
+  struct Wheel
+  {
+    ignition::gazebo::Entity joint;
+    std::vector<ignition::gazebo::Entity> collisions;
+  };
+
+  std::vector<Wheel> wheels_;
+  ignition::gazebo::Entity base_link_ = ignition::gazebo::kNullEntity;
+  RingLogWriter writer_;
+};
+
+// Column names written by TelemetryRecorder for `joints`, in record order
+std::vector<ColumnSpec> telemetry_schema(const std::vector<std::string> & joints);
+
+}  // namespace robocap_telemetry
+
+#endif  // ROBOCAP_TELEMETRY__TELEMETRY_RECORDER_HPP_
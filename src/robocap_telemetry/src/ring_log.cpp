@@ -0,0 +1,229 @@
+#include "robocap_telemetry/ring_log.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <new>
+
+namespace robocap_telemetry
+{
+
+namespace
+{
+
+std::uint64_t round_up_pow2(std::uint64_t value)
+{
+  std::uint64_t result = 1;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+const ColumnInfo * column_table(const void * mapping)
+{
+  return reinterpret_cast<const ColumnInfo *>(
+    static_cast<const char *>(mapping) + kColumnTableOffset);
+}
+
+}  // namespace
+
+RingLogWriter::~RingLogWriter()
+{
+  close();
+}
+
+bool RingLogWriter::open(
+  const std::string & path, const std::vector<ColumnSpec> & columns, std::size_t capacity)
+{
+  close();
+  if (columns.empty() || columns.size() > kMaxColumns || capacity == 0) {
+    return false;
+  }
+  const auto records = round_up_pow2(capacity);
+  mapping_size_ = kHeaderSize + columns.size() * records * sizeof(std::uint64_t);
+
+  const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  if (ftruncate(fd, static_cast<off_t>(mapping_size_)) != 0) {
+    ::close(fd);
+    return false;
+  }
+  // MAP_POPULATE faults every page in now, so appends never take a page fault on the hot path
+  mapping_ = mmap(
+    nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+  ::close(fd);
+  if (mapping_ == MAP_FAILED) {
+    mapping_ = nullptr;
+    return false;
+  }
+
+  header_ = new (mapping_) FileHeader();
+  header_->magic = kMagic;
+  header_->version = kVersion;
+  header_->column_count = static_cast<std::uint32_t>(columns.size());
+  header_->capacity = records;
+  auto * table = const_cast<ColumnInfo *>(column_table(mapping_));
+  columns_.clear();
+  for (std::size_t i = 0; i < columns.size(); ++i) {
+    auto & info = table[i];
+    std::memset(&info, 0, sizeof(info));
+    std::strncpy(info.name, columns[i].name.c_str(), kColumnNameSize - 1);
+    info.type = columns[i].type;
+    info.offset = kHeaderSize + i * records * sizeof(std::uint64_t);
+    columns_.push_back(
+      reinterpret_cast<std::uint64_t *>(static_cast<char *>(mapping_) + info.offset));
+  }
+  mask_ = records - 1;
+  count_ = 0;
+  slot_ = 0;
+  header_->write_count.store(0, std::memory_order_release);
+  return true;
+}
+
+void RingLogWriter::close()
+{
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+  }
+  mapping_ = nullptr;
+  header_ = nullptr;
+  columns_.clear();
+}
+
+RingLogReader::~RingLogReader()
+{
+  close();
+}
+
+bool RingLogReader::open(const std::string & path)
+{
+  close();
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < kHeaderSize) {
+    ::close(fd);
+    return false;
+  }
+  mapping_size_ = static_cast<std::size_t>(info.st_size);
+  void * mapping = mmap(nullptr, mapping_size_, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+  mapping_ = mapping;
+  header_ = static_cast<const FileHeader *>(mapping_);
+
+  const auto valid = header_->magic == kMagic && header_->version == kVersion &&
+    header_->column_count <= kMaxColumns && header_->capacity > 0 &&
+    (header_->capacity & (header_->capacity - 1)) == 0;
+  if (!valid) {
+    close();
+    return false;
+  }
+  capacity_ = header_->capacity;
+  const auto * table = column_table(mapping_);
+  for (std::uint32_t i = 0; i < header_->column_count; ++i) {
+    if (table[i].offset + capacity_ * sizeof(std::uint64_t) > mapping_size_) {
+      close();
+      return false;
+    }
+    columns_.push_back({std::string(table[i].name, strnlen(table[i].name, kColumnNameSize)),
+        table[i].type});
+    data_.push_back(
+      reinterpret_cast<const std::uint64_t *>(
+        static_cast<const char *>(mapping_) + table[i].offset));
+  }
+  return true;
+}
+
+void RingLogReader::close()
+{
+  if (mapping_ != nullptr) {
+    munmap(const_cast<void *>(mapping_), mapping_size_);
+  }
+  mapping_ = nullptr;
+  header_ = nullptr;
+  columns_.clear();
+  data_.clear();
+  capacity_ = 0;
+}
+
+int RingLogReader::find(const std::string & name) const
+{
+  for (std::size_t i = 0; i < columns_.size(); ++i) {
+    if (columns_[i].name == name) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+RingLogReader::Range RingLogReader::range() const
+{
+  const auto end = header_->write_count.load(std::memory_order_acquire);
+  // The writer may already be filling the slot of end - capacity
+  return {end >= capacity_ ? end - capacity_ + 1 : 0, end};
+}
+
+std::int64_t RingLogReader::int_at(int column, std::uint64_t record) const
+{
+  std::int64_t value;
+  std::memcpy(&value, &data_[column][record & (capacity_ - 1)], sizeof(value));
+  return value;
+}
+
+std::uint64_t RingLogReader::lower_bound(int column, std::int64_t value, Range range) const
+{
+  auto begin = range.begin;
+  auto count = range.end - range.begin;
+  while (count > 0) {
+    const auto step = count / 2;
+    if (int_at(column, begin + step) < value) {
+      begin += step + 1;
+      count -= step + 1;
+    } else {
+      count = step;
+    }
+  }
+  return begin;
+}
+
+template<typename T>
+std::uint64_t RingLogReader::read_column(int column, Range range, std::vector<T> & out) const
+{
+  out.resize(range.end - range.begin);
+  const auto mask = capacity_ - 1;
+  // At most two contiguous runs: up to the end of the slot array, then from its start
+  std::uint64_t record = range.begin;
+  std::size_t written = 0;
+  while (record < range.end) {
+    const auto slot = record & mask;
+    const auto run = std::min<std::uint64_t>(range.end - record, capacity_ - slot);
+    std::memcpy(out.data() + written, &data_[column][slot], run * sizeof(T));
+    record += run;
+    written += run;
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return std::max(range.begin, this->range().begin);
+}
+
+std::uint64_t RingLogReader::read(int column, Range range, std::vector<double> & out) const
+{
+  return read_column(column, range, out);
+}
+
+std::uint64_t RingLogReader::read(int column, Range range, std::vector<std::int64_t> & out) const
+{
+  return read_column(column, range, out);
+}
+
+}  // namespace robocap_telemetry
@@ -0,0 +1,180 @@
+#include "robocap_telemetry/telemetry_recorder.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+
+#include "ignition/common/Console.hh"
+#include "ignition/gazebo/Link.hh"
+#include "ignition/gazebo/Model.hh"
+#include "ignition/gazebo/Util.hh"
+#include "ignition/gazebo/components/ChildLinkName.hh"
+#include "ignition/gazebo/components/ContactSensorData.hh"
+#include "ignition/gazebo/components/JointForceCmd.hh"
+#include "ignition/gazebo/components/JointPosition.hh"
+#include "ignition/gazebo/components/JointVelocity.hh"
+#include "ignition/gazebo/components/JointVelocityCmd.hh"
+#include "ignition/plugin/Register.hh"
+
+namespace robocap_telemetry
+{
+
+namespace components = ignition::gazebo::components;
+
+namespace
+{
+
+constexpr std::size_t kDefaultCapacity = 1 << 18;
+
+const std::vector<std::string> kDefaultJoints = {"wheel_1_joint", "wheel_2_joint", "wheel_3_joint"};
+
+// Base columns, after the per-wheel ones
+const std::array<const char *, 13> kBaseColumns = {
+  "base_x", "base_y", "base_z", "base_qw", "base_qx", "base_qy", "base_qz",
+  "base_vx", "base_vy", "base_vz", "base_wx", "base_wy", "base_wz"};
+
+template<typename ComponentT>
+double first_or_zero(
+  const ignition::gazebo::EntityComponentManager & ecm, ignition::gazebo::Entity entity)
+{
+  const auto * component = ecm.Component<ComponentT>(entity);
+  return component && !component->Data().empty() ? component->Data()[0] : 0.0;
+}
+
+}  // namespace
+
+std::vector<ColumnSpec> telemetry_schema(const std::vector<std::string> & joints)
+{
+  std::vector<ColumnSpec> columns = {
+    {"sim_time_ns", ColumnType::kInt64},
+    {"iteration", ColumnType::kInt64},
+  };
+  for (const auto & joint : joints) {
+    for (const char * suffix : {"position", "velocity", "velocity_cmd", "force_cmd", "contacts"}) {
+      columns.push_back({joint + "/" + suffix, ColumnType::kFloat64});
+    }
+  }
+  for (const char * name : kBaseColumns) {
+    columns.push_back({name, ColumnType::kFloat64});
+  }
+  return columns;
+}
+
+void TelemetryRecorder::Configure(
+  const ignition::gazebo::Entity & entity, const std::shared_ptr<const sdf::Element> & sdf,
+  ignition::gazebo::EntityComponentManager & ecm,
+  ignition::gazebo::EventManager & /*event_manager*/)
+{
+  const ignition::gazebo::Model model(entity);
+  if (!model.Valid(ecm)) {
+    ignerr << "TelemetryRecorder must be attached to a model" << std::endl;
+    return;
+  }
+
+  std::string path = sdf->HasElement("path") ? sdf->Get<std::string>("path") : std::string{};
+  if (path.empty()) {
+    const char * env = std::getenv("ROBOCAP_TELEMETRY_FILE");
+    path = env != nullptr ? env : "";
+  }
+  if (path.empty()) {
+    ignmsg << "TelemetryRecorder: no <path> or ROBOCAP_TELEMETRY_FILE, not recording" << std::endl;
+    return;
+  }
+  const auto capacity = sdf->HasElement("capacity") ?
+    static_cast<std::size_t>(sdf->Get<std::uint64_t>("capacity")) : kDefaultCapacity;
+
+  std::vector<std::string> joints;
+  auto element = sdf->FindElement("joint");
+  while (element) {
+    joints.push_back(element->Get<std::string>());
+    element = element->GetNextElement("joint");
+  }
+  if (joints.empty()) {
+    joints = kDefaultJoints;
+  }
+
+  for (const auto & name : joints) {
+    Wheel wheel;
+    wheel.joint = model.JointByName(ecm, name);
+    if (wheel.joint == ignition::gazebo::kNullEntity) {
+      ignerr << "TelemetryRecorder: joint [" << name << "] not found" << std::endl;
+      return;
+    }
+    if (!ecm.Component<components::JointPosition>(wheel.joint)) {
+      ecm.CreateComponent(wheel.joint, components::JointPosition());
+    }
+    if (!ecm.Component<components::JointVelocity>(wheel.joint)) {
+      ecm.CreateComponent(wheel.joint, components::JointVelocity());
+    }
+    // Physics only reports contacts for collisions that carry this component
+    const auto * child = ecm.Component<components::ChildLinkName>(wheel.joint);
+    if (child) {
+      const ignition::gazebo::Link link(model.LinkByName(ecm, child->Data()));
+      for (const auto collision : link.Collisions(ecm)) {
+        if (!ecm.Component<components::ContactSensorData>(collision)) {
+          ecm.CreateComponent(collision, components::ContactSensorData());
+        }
+        wheel.collisions.push_back(collision);
+      }
+    }
+    wheels_.push_back(wheel);
+  }
+
+  base_link_ = model.CanonicalLink(ecm);
+  ignition::gazebo::Link(base_link_).EnableVelocityChecks(ecm, true);
+
+  if (!writer_.open(path, telemetry_schema(joints), capacity)) {
+    ignerr << "TelemetryRecorder: failed to map [" << path << "]" << std::endl;
+    return;
+  }
+  ignmsg << "TelemetryRecorder: recording " << joints.size() << " joints to [" << path << "]" <<
+    std::endl;
+}
+
+void TelemetryRecorder::PostUpdate(
+  const ignition::gazebo::UpdateInfo & info,
+  const ignition::gazebo::EntityComponentManager & ecm)
+{
+  if (!writer_.is_open() || info.paused) {
+    return;
+  }
+
+  std::size_t column = 0;
+  writer_.set(
+    column++,
+    static_cast<std::int64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(info.simTime).count()));
+  writer_.set(column++, static_cast<std::int64_t>(info.iterations));
+
+  for (const auto & wheel : wheels_) {
+    writer_.set(column++, first_or_zero<components::JointPosition>(ecm, wheel.joint));
+    writer_.set(column++, first_or_zero<components::JointVelocity>(ecm, wheel.joint));
+    writer_.set(column++, first_or_zero<components::JointVelocityCmd>(ecm, wheel.joint));
+    writer_.set(column++, first_or_zero<components::JointForceCmd>(ecm, wheel.joint));
+    int contacts = 0;
+    for (const auto collision : wheel.collisions) {
+      const auto * data = ecm.Component<components::ContactSensorData>(collision);
+      contacts += data ? data->Data().contact_size() : 0;
+    }
+    writer_.set(column++, static_cast<double>(contacts));
+  }
+
+  const ignition::gazebo::Link link(base_link_);
+  const auto pose = ignition::gazebo::worldPose(base_link_, ecm);
+  const auto linear = link.WorldLinearVelocity(ecm).value_or(ignition::math::Vector3d::Zero);
+  const auto angular = link.WorldAngularVelocity(ecm).value_or(ignition::math::Vector3d::Zero);
+  for (const double value : {pose.Pos().X(), pose.Pos().Y(), pose.Pos().Z(), pose.Rot().W(),
+      pose.Rot().X(), pose.Rot().Y(), pose.Rot().Z(), linear.X(), linear.Y(), linear.Z(),
+      angular.X(), angular.Y(), angular.Z()})
+  {
+    writer_.set(column++, value);
+  }
+  writer_.commit();
+}
+
+}  // namespace robocap_telemetry
+
+IGNITION_ADD_PLUGIN(
+  robocap_telemetry::TelemetryRecorder, ignition::gazebo::System,
+  robocap_telemetry::TelemetryRecorder::ISystemConfigure,
+  robocap_telemetry::TelemetryRecorder::ISystemPostUpdate)
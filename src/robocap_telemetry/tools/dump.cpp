@@ -0,0 +1,124 @@
+// Prints a slice of a telemetry ring log as CSV. Only the selected columns are read, and the time
+// window is found by binary search on sim_time_ns, so slicing a large log stays cheap.
+//
+// Usage: robocap_telemetry_dump <file.ring> [--list] [--columns a,b,c] [--from s] [--to s]
+
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "robocap_telemetry/ring_log.hpp"
+
+int main(int argc, char ** argv)
+{
+  using robocap_telemetry::ColumnType;
+
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] <<
+      " <file.ring> [--list] [--columns a,b,c] [--from s] [--to s]" << std::endl;
+    return 1;
+  }
+  robocap_telemetry::RingLogReader reader;
+  if (!reader.open(argv[1])) {
+    std::cerr << "Failed to open " << argv[1] << " as a ring log" << std::endl;
+    return 1;
+  }
+
+  bool list = false;
+  std::string selection;
+  double from = -std::numeric_limits<double>::infinity();
+  double to = std::numeric_limits<double>::infinity();
+  for (int i = 2; i < argc; ++i) {
+    const std::string flag = argv[i];
+    if (flag == "--list") {
+      list = true;
+    } else if (flag == "--columns" && i + 1 < argc) {
+      selection = argv[++i];
+    } else if (flag == "--from" && i + 1 < argc) {
+      from = std::stod(argv[++i]);
+    } else if (flag == "--to" && i + 1 < argc) {
+      to = std::stod(argv[++i]);
+    } else {
+      std::cerr << "Unknown argument " << flag << std::endl;
+      return 1;
+    }
+  }
+
+  const auto range = reader.range();
+  if (list) {
+    std::cout << range.end - range.begin << " records of " << reader.capacity() << std::endl;
+    for (const auto & column : reader.columns()) {
+      std::cout << column.name << (column.type == ColumnType::kInt64 ? " int64" : " float64") <<
+        std::endl;
+    }
+    return 0;
+  }
+
+  std::vector<int> selected;
+  if (selection.empty()) {
+    for (std::size_t i = 0; i < reader.columns().size(); ++i) {
+      selected.push_back(static_cast<int>(i));
+    }
+  } else {
+    std::stringstream names(selection);
+    std::string name;
+    while (std::getline(names, name, ',')) {
+      const int index = reader.find(name);
+      if (index < 0) {
+        std::cerr << "No column named " << name << std::endl;
+        return 1;
+      }
+      selected.push_back(index);
+    }
+  }
+
+  auto slice = range;
+  const int time = reader.find("sim_time_ns");
+  if (time >= 0) {
+    const auto to_ns = [](double seconds) {
+        return std::isinf(seconds) ?
+               (seconds < 0 ? std::numeric_limits<std::int64_t>::min() :
+               std::numeric_limits<std::int64_t>::max()) :
+               static_cast<std::int64_t>(std::llround(seconds * 1e9));
+      };
+    slice.begin = reader.lower_bound(time, to_ns(from), range);
+    slice.end = reader.lower_bound(time, to_ns(to), {slice.begin, range.end});
+  }
+
+  // Columns are copied one after another, so only records intact after the last copy are printed
+  std::vector<std::vector<double>> floats(selected.size());
+  std::vector<std::vector<std::int64_t>> ints(selected.size());
+  std::uint64_t intact = slice.begin;
+  for (std::size_t c = 0; c < selected.size(); ++c) {
+    const auto type = reader.columns()[selected[c]].type;
+    intact = type == ColumnType::kInt64 ?
+      reader.read(selected[c], slice, ints[c]) : reader.read(selected[c], slice, floats[c]);
+  }
+
+  for (std::size_t c = 0; c < selected.size(); ++c) {
+    std::cout << (c ? "," : "") << reader.columns()[selected[c]].name;
+  }
+  std::cout << '\n';
+  for (auto record = intact; record < slice.end; ++record) {
+    const auto row = record - slice.begin;
+    for (std::size_t c = 0; c < selected.size(); ++c) {
+      if (c) {
+        std::cout << ',';
+      }
+      if (reader.columns()[selected[c]].type == ColumnType::kInt64) {
+        std::cout << ints[c][row];
+      } else {
+        char value[32];
+        std::snprintf(value, sizeof(value), "%.9g", floats[c][row]);
+        std::cout << value;
+      }
+    }
+    std::cout << '\n';
+  }
+  return 0;
+}
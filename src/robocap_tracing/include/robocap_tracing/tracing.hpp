@@ -0,0 +1,61 @@
+#ifndef ROBOCAP_TRACING__TRACING_HPP_
+#define ROBOCAP_TRACING__TRACING_HPP_
+
+#include <cstdint>
+
+#include "robocap_tracing/config.hpp"
+
+// Tracepoints on the robocap hot paths, recorded by LTTng under the `robocap` provider:
+//
+//   lttng create robocap && lttng enable-event -u 'robocap:*' && lttng start
+//
+// Call them through ROBOCAP_TRACEPOINT(event, args...). Without an active session an event costs
+// a call and one predicted branch. In a build without LTTng (or with ROBOCAP_TRACING_DISABLED)
+// the macro expands to nothing and its arguments are not evaluated.
+//
+// Events carry a `handle`, the address of the emitting object, which component_init() ties to a
+// name. Times are taken by LTTng from the monotonic clock; `stamp_ns` fields are ROS times.
+#ifdef ROBOCAP_TRACING_DISABLED
+#define ROBOCAP_TRACEPOINT(event, ...) ((void)0)
+#else
+#define ROBOCAP_TRACEPOINT(event, ...) ::robocap_tracing::event(__VA_ARGS__)
+#endif
+
+namespace robocap_tracing
+{
+
+// Names `handle` for the analysis, once outside the hot path
+void component_init(const void * handle, const char * name);
+// Joint `wheel` of a wheel backend is `joint_name`
+void wheel_joint_init(const void * backend, std::uint32_t wheel, const char * joint_name);
+
+// Gazebo system phases, at the start of each
+void sim_pre_update(const void * plugin, std::int64_t sim_ns);
+void sim_post_update(const void * plugin, std::int64_t sim_ns);
+
+// Hardware interface read()/write()
+void hardware_read_start(const void * hardware);
+void hardware_read_end(const void * hardware);
+void hardware_write_start(const void * hardware);
+void hardware_write_end(const void * hardware);
+// A wheel backend handed the command of `wheel` to the simulator or the device
+void wheel_command_applied(const void * backend, std::uint32_t wheel, double value);
+
+// Controller update(). `sequence` numbers the velocity commands a controller received; the same
+// sequence is reported by every update() that acts on that command
+void controller_update_start(const void * controller);
+void controller_update_end(const void * controller);
+void cmd_vel_received(const void * controller, std::uint64_t sequence);
+void controller_command(const void * controller, std::uint64_t sequence);
+
+// Message processing in estimator, mapping and planning nodes
+void processing_start(const void * handle, std::int64_t stamp_ns);
+void processing_end(const void * handle);
+
+// A bridge converting and publishing one gz message
+void bridge_publish_start(const void * bridge, std::int64_t stamp_ns);
+void bridge_publish_end(const void * bridge);
+
+}  // namespace robocap_tracing
+
+#endif  // ROBOCAP_TRACING__TRACING_HPP_
@@ -0,0 +1,255 @@
+#!/usr/bin/env python3
+"""
+Reconstruct per-command latency on the cmd_vel -> wheel joint path from a robocap LTTng trace.
+
+Usage: command_latency.py TRACE_DIR [--cycles cycles.csv]
+
+Record the trace with the robocap provider enabled, and the process id so handles from
+different processes do not mix:
+
+    lttng create robocap
+    lttng enable-event -u 'robocap:*'
+    lttng add-context -u -t vpid
+    lttng start
+    ...
+    lttng stop
+
+Every velocity command a kiwi drive controller received is followed through the first update()
+that acted on it, the next hardware write() and each wheel command handed to the simulator,
+until the physics step that consumed it ended. The stages are printed as percentiles, next to
+the durations of every traced update, read/write, bridge publish and processing callback.
+
+Needs the babeltrace2 Python bindings (python3-bt2).
+"""
+
+import argparse
+import collections
+import csv
+import math
+import sys
+
+import bt2
+
+# Begin/end pairs summarized per component
+SPANS = {
+    'hardware_read_start': ('hardware_read_end', 'read'),
+    'hardware_write_start': ('hardware_write_end', 'write'),
+    'controller_update_start': ('controller_update_end', 'update'),
+    'processing_start': ('processing_end', 'processing'),
+    'bridge_publish_start': ('bridge_publish_end', 'publish'),
+}
+SPAN_ENDS = {end: (start, label) for start, (end, label) in SPANS.items()}
+
+
+class Command:
+    """Timestamps in ns of one velocity command on its way to the wheels."""
+
+    def __init__(self, controller, sequence, received):
+        self.controller = controller
+        self.sequence = sequence
+        self.received = received
+        self.update_start = None
+        self.update_end = None
+        self.write_start = None
+        self.applied = {}
+        self.backend = None
+        self.write_end = None
+        self.stepped = None
+
+    def stages(self, joints):
+        """Return [(stage, duration in ns)] for the stages this command reached."""
+        stages = []
+
+        def add(name, begin, end):
+            if begin is not None and end is not None:
+                stages.append((name, end - begin))
+
+        add('cmd_vel -> update', self.received, self.update_start)
+        add('update', self.update_start, self.update_end)
+        add('update -> write', self.update_end, self.write_start)
+        for wheel, stamp in sorted(self.applied.items()):
+            add(f'write -> {joints.get(wheel, f"wheel {wheel}")}', self.write_start, stamp)
+        add('write -> physics step done', self.write_end, self.stepped)
+        if self.applied:
+            add('cmd_vel -> last wheel', self.received, max(self.applied.values()))
+        add('cmd_vel -> physics step done', self.received, self.stepped)
+        return stages
+
+
+class Analysis:
+    """Single pass over the time-ordered events."""
+
+    def __init__(self):
+        self.names = {}
+        self.joints = collections.defaultdict(dict)
+        self.spans = collections.defaultdict(list)
+        self.open_spans = {}
+        self.pending = collections.defaultdict(dict)
+        self.last_sequence = {}
+        self.last_update_start = {}
+        self.in_update = {}
+        self.to_write = collections.defaultdict(list)
+        self.in_write = collections.defaultdict(list)
+        self.to_step = collections.defaultdict(list)
+        self.done = []
+        self.superseded = 0
+
+    def event(self, name, stamp, pid, fields):
+        handle = (pid, fields['handle'])
+        if name == 'component_init':
+            self.names[handle] = fields['name']
+        elif name == 'wheel_joint_init':
+            self.joints[handle][fields['wheel']] = fields['joint_name']
+        elif name == 'cmd_vel_received':
+            self.pending[handle][fields['sequence']] = Command(handle, fields['sequence'], stamp)
+        elif name == 'controller_command':
+            self.consume(handle, fields['sequence'])
+        elif name == 'hardware_write_start':
+            self.in_write[pid].extend(self.to_write.pop(pid, []))
+            for command in self.in_write[pid]:
+                command.write_start = stamp
+        elif name == 'wheel_command_applied':
+            for command in self.in_write[pid]:
+                command.applied.setdefault(fields['wheel'], stamp)
+                command.backend = handle
+        elif name == 'hardware_write_end':
+            for command in self.in_write.pop(pid, []):
+                command.write_end = stamp
+                self.to_step[pid].append(command)
+        elif name == 'sim_post_update':
+            for command in self.to_step.pop(pid, []):
+                command.stepped = stamp
+                self.done.append(command)
+
+        if name == 'controller_update_start':
+            self.last_update_start[handle] = stamp
+        elif name == 'controller_update_end' and handle in self.in_update:
+            command = self.in_update.pop(handle)
+            command.update_end = stamp
+            self.to_write[pid].append(command)
+
+        if name in SPANS:
+            self.open_spans[(handle, name)] = stamp
+        elif name in SPAN_ENDS:
+            start, label = SPAN_ENDS[name]
+            begin = self.open_spans.pop((handle, start), None)
+            if begin is not None:
+                self.spans[(handle, label)].append(stamp - begin)
+
+    def consume(self, handle, sequence):
+        """Attach the update in progress to `sequence` the first time a controller acts on it."""
+        if self.last_sequence.get(handle) == sequence:
+            return
+        self.last_sequence[handle] = sequence
+        pending = self.pending[handle]
+        command = pending.pop(sequence, None)
+        # Commands overwritten in the triple buffer before any update read them
+        for older in [s for s in pending if s < sequence]:
+            del pending[older]
+            self.superseded += 1
+        if command is None:
+            return
+        command.update_start = self.last_update_start.get(handle)
+        self.in_update[handle] = command
+
+    def finish(self):
+        """Keep commands whose trace ended before a physics step, e.g. on real hardware."""
+        for commands in list(self.to_step.values()) + list(self.in_write.values()):
+            self.done.extend(commands)
+        self.done.sort(key=lambda command: command.received)
+
+    def joint_names(self, command):
+        return self.joints.get(command.backend, {})
+
+    def name(self, handle):
+        return self.names.get(handle, f'{handle[1]:#x}')
+
+
+def field_value(field):
+    if isinstance(field, bt2._StringFieldConst):
+        return str(field)
+    if isinstance(field, bt2._RealFieldConst):
+        return float(field)
+    return int(field)
+
+
+def read_trace(path, analysis):
+    events = 0
+    for message in bt2.TraceCollectionMessageIterator(path):
+        if type(message) is not bt2._EventMessageConst:
+            continue
+        event = message.event
+        provider, _, name = event.name.partition(':')
+        if provider != 'robocap':
+            continue
+        context = event.common_context_field
+        pid = int(context['vpid']) if context is not None and 'vpid' in context else 0
+        fields = {key: field_value(value) for key, value in event.payload_field.items()}
+        analysis.event(name, message.default_clock_snapshot.ns_from_origin, pid, fields)
+        events += 1
+    return events
+
+
+def percentile(values, fraction):
+    """Nearest-rank percentile of sorted `values`."""
+    index = min(len(values) - 1, max(0, math.ceil(fraction * len(values)) - 1))
+    return values[index]
+
+
+def print_table(title, rows):
+    print(title)
+    print(f'  {"":<48} {"count":>7} {"p50":>9} {"p90":>9} {"p99":>9} {"max":>9}  [us]')
+    for label, values in rows:
+        values = sorted(values)
+        quantiles = [percentile(values, f) / 1e3 for f in (0.5, 0.9, 0.99)] + [values[-1] / 1e3]
+        print(f'  {label:<48} {len(values):>7}' + ''.join(f' {q:>9.1f}' for q in quantiles))
+    print()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument('trace', help='trace directory, searched recursively')
+    parser.add_argument('--cycles', help='write one row per command to this CSV file')
+    args = parser.parse_args()
+
+    analysis = Analysis()
+    if read_trace(args.trace, analysis) == 0:
+        print(f'No robocap events in {args.trace}')
+        return 1
+    analysis.finish()
+
+    stages = collections.OrderedDict()
+    for command in analysis.done:
+        for stage, duration in command.stages(analysis.joint_names(command)):
+            stages.setdefault(stage, []).append(duration)
+    if stages:
+        print_table(
+            f'cmd_vel -> wheel joints, {len(analysis.done)} commands '
+            f'({analysis.superseded} superseded before an update)', stages.items())
+    else:
+        print('No command reached a controller update, is a kiwi drive controller traced?\n')
+
+    spans = sorted(
+        ((f'{analysis.name(handle)} {label}', values)
+         for (handle, label), values in analysis.spans.items()),
+        key=lambda row: row[0])
+    if spans:
+        print_table('Callbacks', spans)
+
+    if args.cycles:
+        columns = [
+            'sequence', 'received', 'update_start', 'update_end', 'write_start', 'write_end',
+            'stepped']
+        with open(args.cycles, 'w', newline='') as f:
+            writer = csv.writer(f)
+            writer.writerow(['controller'] + columns + ['wheel_0', 'wheel_1', 'wheel_2'])
+            for command in analysis.done:
+                writer.writerow(
+                    [analysis.name(command.controller)] +
+                    [getattr(command, column) for column in columns] +
+                    [command.applied.get(wheel) for wheel in range(3)])
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,6 @@
+// Instantiates the tracepoint provider and its probes in librobocap_tracing
+
+#define TRACEPOINT_CREATE_PROBES
+
+#define TRACEPOINT_DEFINE
+#include "tp_call.h"
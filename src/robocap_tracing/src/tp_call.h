@@ -0,0 +1,111 @@
+// LTTng-UST tracepoint provider for robocap, see robocap_tracing/tracing.hpp
+
+#undef TRACEPOINT_PROVIDER
+#define TRACEPOINT_PROVIDER robocap
+
+#undef TRACEPOINT_INCLUDE
+#define TRACEPOINT_INCLUDE "tp_call.h"
+
+#if !defined(ROBOCAP_TRACING__TP_CALL_H_) || defined(TRACEPOINT_HEADER_MULTI_READ)
+#define ROBOCAP_TRACING__TP_CALL_H_
+
+#include <lttng/tracepoint.h>
+
+#include <stdint.h>
+
+// Events that only identify their emitter
+TRACEPOINT_EVENT_CLASS(
+  robocap,
+  handle_class,
+  TP_ARGS(const void *, handle_arg),
+  TP_FIELDS(
+    ctf_integer_hex(const void *, handle, handle_arg)
+  )
+)
+
+#define ROBOCAP_HANDLE_EVENT(name) \
+  TRACEPOINT_EVENT_INSTANCE(robocap, handle_class, name, TP_ARGS(const void *, handle_arg))
+
+ROBOCAP_HANDLE_EVENT(hardware_read_start)
+ROBOCAP_HANDLE_EVENT(hardware_read_end)
+ROBOCAP_HANDLE_EVENT(hardware_write_start)
+ROBOCAP_HANDLE_EVENT(hardware_write_end)
+ROBOCAP_HANDLE_EVENT(controller_update_start)
+ROBOCAP_HANDLE_EVENT(controller_update_end)
+ROBOCAP_HANDLE_EVENT(processing_end)
+ROBOCAP_HANDLE_EVENT(bridge_publish_end)
+
+// Events with a ROS or simulation time
+TRACEPOINT_EVENT_CLASS(
+  robocap,
+  stamp_class,
+  TP_ARGS(const void *, handle_arg, int64_t, stamp_ns_arg),
+  TP_FIELDS(
+    ctf_integer_hex(const void *, handle, handle_arg)
+    ctf_integer(int64_t, stamp_ns, stamp_ns_arg)
+  )
+)
+
+#define ROBOCAP_STAMP_EVENT(name) \
+  TRACEPOINT_EVENT_INSTANCE( \
+    robocap, stamp_class, name, TP_ARGS(const void *, handle_arg, int64_t, stamp_ns_arg))
+
+ROBOCAP_STAMP_EVENT(sim_pre_update)
+ROBOCAP_STAMP_EVENT(sim_post_update)
+ROBOCAP_STAMP_EVENT(processing_start)
+ROBOCAP_STAMP_EVENT(bridge_publish_start)
+
+// Events tracking one velocity command through a controller
+TRACEPOINT_EVENT_CLASS(
+  robocap,
+  sequence_class,
+  TP_ARGS(const void *, handle_arg, uint64_t, sequence_arg),
+  TP_FIELDS(
+    ctf_integer_hex(const void *, handle, handle_arg)
+    ctf_integer(uint64_t, sequence, sequence_arg)
+  )
+)
+
+TRACEPOINT_EVENT_INSTANCE(
+  robocap, sequence_class, cmd_vel_received,
+  TP_ARGS(const void *, handle_arg, uint64_t, sequence_arg))
+TRACEPOINT_EVENT_INSTANCE(
+  robocap, sequence_class, controller_command,
+  TP_ARGS(const void *, handle_arg, uint64_t, sequence_arg))
+
+TRACEPOINT_EVENT(
+  robocap,
+  wheel_command_applied,
+  TP_ARGS(const void *, handle_arg, uint32_t, wheel_arg, double, value_arg),
+  TP_FIELDS(
+    ctf_integer_hex(const void *, handle, handle_arg)
+    ctf_integer(uint32_t, wheel, wheel_arg)
+    ctf_float(double, value, value_arg)
+  )
+)
+
+// Metadata, emitted once per component
+TRACEPOINT_EVENT(
+  robocap,
+  component_init,
+  TP_ARGS(const void *, handle_arg, const char *, name_arg),
+  TP_FIELDS(
+    ctf_integer_hex(const void *, handle, handle_arg)
+    ctf_string(name, name_arg)
+  )
+)
+
+TRACEPOINT_EVENT(
+  robocap,
+  wheel_joint_init,
+  TP_ARGS(const void *, handle_arg, uint32_t, wheel_arg, const char *, joint_name_arg),
+  TP_FIELDS(
+    ctf_integer_hex(const void *, handle, handle_arg)
+    ctf_integer(uint32_t, wheel, wheel_arg)
+    ctf_string(joint_name, joint_name_arg)
+  )
+)
+
+#endif  // ROBOCAP_TRACING__TP_CALL_H_
+
+#include <lttng/tracepoint-event.h>
@@ -0,0 +1,96 @@
+#include "robocap_tracing/tracing.hpp"
+
+#include "tp_call.h"
+
+namespace robocap_tracing
+{
+
+// tracepoint() checks the enabled state inline, so each call below is a single branch while no
+// session records the event
+
+void component_init(const void * handle, const char * name)
+{
+  tracepoint(robocap, component_init, handle, name);
+}
+
+void wheel_joint_init(const void * backend, std::uint32_t wheel, const char * joint_name)
+{
+  tracepoint(robocap, wheel_joint_init, backend, wheel, joint_name);
+}
+
+void sim_pre_update(const void * plugin, std::int64_t sim_ns)
+{
+  tracepoint(robocap, sim_pre_update, plugin, sim_ns);
+}
+
+void sim_post_update(const void * plugin, std::int64_t sim_ns)
+{
+  tracepoint(robocap, sim_post_update, plugin, sim_ns);
+}
+
+void hardware_read_start(const void * hardware)
+{
+  tracepoint(robocap, hardware_read_start, hardware);
+}
+
+void hardware_read_end(const void * hardware)
+{
+  tracepoint(robocap, hardware_read_end, hardware);
+}
+
+void hardware_write_start(const void * hardware)
+{
+  tracepoint(robocap, hardware_write_start, hardware);
+}
+
+void hardware_write_end(const void * hardware)
+{
+  tracepoint(robocap, hardware_write_end, hardware);
+}
+
+void wheel_command_applied(const void * backend, std::uint32_t wheel, double value)
+{
+  tracepoint(robocap, wheel_command_applied, backend, wheel, value);
+}
+
+void controller_update_start(const void * controller)
+{
+  tracepoint(robocap, controller_update_start, controller);
+}
+
+void controller_update_end(const void * controller)
+{
+  tracepoint(robocap, controller_update_end, controller);
+}
+
+void cmd_vel_received(const void * controller, std::uint64_t sequence)
+{
+  tracepoint(robocap, cmd_vel_received, controller, sequence);
+}
+
+void controller_command(const void * controller, std::uint64_t sequence)
+{
+  tracepoint(robocap, controller_command, controller, sequence);
+}
+
+void processing_start(const void * handle, std::int64_t stamp_ns)
+{
+  tracepoint(robocap, processing_start, handle, stamp_ns);
+}
+
+void processing_end(const void * handle)
+{
+  tracepoint(robocap, processing_end, handle);
+}
+
+void bridge_publish_start(const void * bridge, std::int64_t stamp_ns)
+{
+  tracepoint(robocap, bridge_publish_start, bridge, stamp_ns);
+}
+
+void bridge_publish_end(const void * bridge)
+{
+  tracepoint(robocap, bridge_publish_end, bridge);
+}
+
+}  // namespace robocap_tracing